@@ -49,12 +49,11 @@
 #include <class_zone.h>
 #include <class_text_mod.h>
 #include <convert_basic_shapes_to_polygon.h>
+#include <thread_pool.h>
 #include <trigo.h>
 #include <utility>
 #include <vector>
-#include <thread>
 #include <algorithm>
-#include <atomic>
 
 #include <profile.h>
 
@@ -690,39 +689,20 @@ void BOARD_ADAPTER::createLayers( REPORTER *aStatusTextReporter )
 
         // Add zones objects
         // /////////////////////////////////////////////////////////////////////
-        std::atomic<size_t> nextZone( 0 );
-        std::atomic<size_t> threadsFinished( 0 );
+        ParallelFor( 0, m_board->GetAreaCount(),
+                     [this]( size_t areaId )
+                     {
+                         const ZONE_CONTAINER* zone = m_board->GetArea( areaId );
 
-        size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            std::thread t = std::thread( [&]()
-            {
-                for( size_t areaId = nextZone.fetch_add( 1 );
-                            areaId < static_cast<size_t>( m_board->GetAreaCount() );
-                            areaId = nextZone.fetch_add( 1 ) )
-                {
-                    const ZONE_CONTAINER* zone = m_board->GetArea( areaId );
-
-                    if( zone == nullptr )
-                        break;
-
-                    auto layerContainer = m_layers_container2D.find( zone->GetLayer() );
-
-                    if( layerContainer != m_layers_container2D.end() )
-                        AddSolidAreasShapesToContainer( zone, layerContainer->second,
-                                                        zone->GetLayer() );
-                }
-
-                threadsFinished++;
-            } );
-
-            t.detach();
-        }
+                         if( zone == nullptr )
+                             return;
 
-        while( threadsFinished < parallelThreadCount )
-            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+                         auto layerContainer = m_layers_container2D.find( zone->GetLayer() );
 
+                         if( layerContainer != m_layers_container2D.end() )
+                             AddSolidAreasShapesToContainer( zone, layerContainer->second,
+                                                             zone->GetLayer() );
+                     }, nullptr, 1 );
     }
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
@@ -760,35 +740,15 @@ void BOARD_ADAPTER::createLayers( REPORTER *aStatusTextReporter )
     if( GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS )
             && ( m_render_engine == RENDER_ENGINE::OPENGL_LEGACY ) )
     {
-        std::atomic<size_t> nextItem( 0 );
-        std::atomic<size_t> threadsFinished( 0 );
-
-        size_t parallelThreadCount = std::min<size_t>(
-                std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
-                layer_id.size() );
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            std::thread t = std::thread( [&nextItem, &threadsFinished, &layer_id, this]()
-            {
-                for( size_t i = nextItem.fetch_add( 1 );
-                            i < layer_id.size();
-                            i = nextItem.fetch_add( 1 ) )
-                {
-                    auto layerPoly = m_layers_poly.find( layer_id[i] );
-
-                    if( layerPoly != m_layers_poly.end() )
-                        // This will make a union of all added contours
-                        layerPoly->second->Simplify( SHAPE_POLY_SET::PM_FAST );
-                }
-
-                threadsFinished++;
-            } );
-
-            t.detach();
-        }
-
-        while( threadsFinished < parallelThreadCount )
-            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        ParallelFor( 0, layer_id.size(),
+                     [&layer_id, this]( size_t i )
+                     {
+                         auto layerPoly = m_layers_poly.find( layer_id[i] );
+
+                         if( layerPoly != m_layers_poly.end() )
+                             // This will make a union of all added contours
+                             layerPoly->second->Simplify( SHAPE_POLY_SET::PM_FAST );
+                     }, nullptr, 1 );
     }
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
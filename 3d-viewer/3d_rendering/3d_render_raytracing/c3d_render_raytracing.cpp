@@ -32,7 +32,6 @@
 #include <atomic>
 #include <chrono>
 #include <climits>
-#include <thread>
 
 #include "c3d_render_raytracing.h"
 #include "mortoncodes.h"
@@ -41,6 +40,7 @@
 #include "3d_math.h"
 #include "../common_ogl/ogl_utils.h"
 #include <profile.h>        // To use GetRunningMicroSecs or another profiling utility
+#include <thread_pool.h>
 
 // This should be used in future for the function
 // convertLinearToSRGB
@@ -367,23 +367,16 @@ void C3D_RENDER_RAYTRACING::rt_render_tracing( GLubyte *ptrPBO ,
     m_isPreview = false;
 
     auto startTime = std::chrono::steady_clock::now();
-    bool breakLoop = false;
+    std::atomic<bool> breakLoop( false );
 
     std::atomic<size_t> numBlocksRendered( 0 );
-    std::atomic<size_t> currentBlock( 0 );
-    std::atomic<size_t> threadsFinished( 0 );
 
-    size_t parallelThreadCount = std::min<size_t>(
-            std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
-            m_blockPositions.size() );
-    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-    {
-        std::thread t = std::thread( [&]()
-        {
-            for( size_t iBlock = currentBlock.fetch_add( 1 );
-                        iBlock < m_blockPositions.size() && !breakLoop;
-                        iBlock = currentBlock.fetch_add( 1 ) )
+    ParallelFor( 0, m_blockPositions.size(),
+            [&]( size_t iBlock )
             {
+                if( breakLoop )
+                    return;
+
                 if( !m_blockPositionsWasProcessed[iBlock] )
                 {
                     rt_render_trace_block( ptrPBO, iBlock );
@@ -396,16 +389,7 @@ void C3D_RENDER_RAYTRACING::rt_render_tracing( GLubyte *ptrPBO ,
                             std::chrono::steady_clock::now() - startTime ).count() > 150 )
                         breakLoop = true;
                 }
-            }
-
-            threadsFinished++;
-        } );
-
-        t.detach();
-    }
-
-    while( threadsFinished < parallelThreadCount )
-        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+            } );
 
     m_nrBlocksRenderProgress += numBlocksRendered;
 
@@ -916,17 +900,8 @@ void C3D_RENDER_RAYTRACING::rt_render_post_process_shade( GLubyte *ptrPBO,
         if( aStatusTextReporter )
             aStatusTextReporter->Report( _("Rendering: Post processing shader") );
 
-        std::atomic<size_t> nextBlock( 0 );
-        std::atomic<size_t> threadsFinished( 0 );
-
-        size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            std::thread t = std::thread( [&]()
-            {
-                for( size_t y = nextBlock.fetch_add( 1 );
-                            y < m_realBufferSize.y;
-                            y = nextBlock.fetch_add( 1 ) )
+        ParallelFor( 0, m_realBufferSize.y,
+                [&]( size_t y )
                 {
                     SFVEC3F *ptr = &m_shaderBuffer[ y * m_realBufferSize.x ];
 
@@ -935,16 +910,7 @@ void C3D_RENDER_RAYTRACING::rt_render_post_process_shade( GLubyte *ptrPBO,
                         *ptr = m_postshader_ssao.Shade( SFVEC2I( x, y ) );
                         ptr++;
                     }
-                }
-
-                threadsFinished++;
-            } );
-
-            t.detach();
-        }
-
-        while( threadsFinished < parallelThreadCount )
-            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+                } );
 
         // Set next state
         m_rt_render_state = RT_RENDER_STATE_POST_PROCESS_BLUR_AND_FINISH;
@@ -965,17 +931,8 @@ void C3D_RENDER_RAYTRACING::rt_render_post_process_blur_finish( GLubyte *ptrPBO,
     if( m_boardAdapter.GetFlag( FL_RENDER_RAYTRACING_POST_PROCESSING ) )
     {
         // Now blurs the shader result and compute the final color
-        std::atomic<size_t> nextBlock( 0 );
-        std::atomic<size_t> threadsFinished( 0 );
-
-        size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            std::thread t = std::thread( [&]()
-            {
-                for( size_t y = nextBlock.fetch_add( 1 );
-                            y < m_realBufferSize.y;
-                            y = nextBlock.fetch_add( 1 ) )
+        ParallelFor( 0, m_realBufferSize.y,
+                [&]( size_t y )
                 {
                     GLubyte *ptr = &ptrPBO[ y * m_realBufferSize.x * 4 ];
 
@@ -1055,16 +1012,7 @@ void C3D_RENDER_RAYTRACING::rt_render_post_process_blur_finish( GLubyte *ptrPBO,
 
                         ptr += 4;
                     }
-                }
-
-                threadsFinished++;
-            } );
-
-            t.detach();
-        }
-
-        while( threadsFinished < parallelThreadCount )
-            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+                } );
 
 
         // Debug code
@@ -1080,19 +1028,8 @@ void C3D_RENDER_RAYTRACING::render_preview( GLubyte *ptrPBO )
 {
     m_isPreview = true;
 
-    std::atomic<size_t> nextBlock( 0 );
-    std::atomic<size_t> threadsFinished( 0 );
-
-    size_t parallelThreadCount = std::min<size_t>(
-            std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
-            m_blockPositions.size() );
-    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-    {
-        std::thread t = std::thread( [&]()
-        {
-            for( size_t iBlock = nextBlock.fetch_add( 1 );
-                        iBlock < m_blockPositionsFast.size();
-                        iBlock = nextBlock.fetch_add( 1 ) )
+    ParallelFor( 0, m_blockPositionsFast.size(),
+            [&]( size_t iBlock )
             {
                 const SFVEC2UI &windowPosUI = m_blockPositionsFast[ iBlock ];
                 const SFVEC2I windowsPos = SFVEC2I( windowPosUI.x + m_xoffset,
@@ -1693,16 +1630,7 @@ void C3D_RENDER_RAYTRACING::render_preview( GLubyte *ptrPBO )
                         SetPixel( ptr + 12, BlendColor( cRBC, BlendColor( cRB , cC ) ) );
                     }
                 }
-            }
-
-            threadsFinished++;
-        } );
-
-        t.detach();
-    }
-
-    while( threadsFinished < parallelThreadCount )
-        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+            } );
 }
 
 
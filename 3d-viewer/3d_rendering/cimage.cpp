@@ -31,9 +31,7 @@
 #include "buffers_debug.h"
 #include <cstring> // For memcpy
 
-#include <atomic>
-#include <thread>
-#include <chrono>
+#include <thread_pool.h>
 
 #ifndef CLAMP
 #define CLAMP(n, min, max) {if( n < min ) n=min; else if( n > max ) n = max;}
@@ -475,51 +473,33 @@ void CIMAGE::EfxFilter( CIMAGE* aInImg, IMAGE_FILTER aFilterType )
     aInImg->m_wraping = IMAGE_WRAP::CLAMP;
     m_wraping         = IMAGE_WRAP::CLAMP;
 
-    std::atomic<size_t> nextRow( 0 );
-    std::atomic<size_t> threadsFinished( 0 );
-
-    size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
-
-    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+    auto filter_lambda = [&]( size_t iy )
     {
-        std::thread t = std::thread( [&]()
+        for( size_t ix = 0; ix < m_width; ix++ )
         {
-            for( size_t iy = nextRow.fetch_add( 1 );
-                        iy < m_height;
-                        iy = nextRow.fetch_add( 1 ) )
+            int v = 0;
+
+            for( size_t sy = 0; sy < 5; sy++ )
             {
-                for( size_t ix = 0; ix < m_width; ix++ )
+                for( size_t sx = 0; sx < 5; sx++ )
                 {
-                    int v = 0;
-
-                    for( size_t sy = 0; sy < 5; sy++ )
-                    {
-                        for( size_t sx = 0; sx < 5; sx++ )
-                        {
-                            int factor = filter.kernel[sx][sy];
-                            unsigned char pixelv = aInImg->Getpixel( ix + sx - 2,
-                                                                     iy + sy - 2 );
-
-                            v += pixelv * factor;
-                        }
-                    }
-
-                    v /= filter.div;
-                    v += filter.offset;
-                    CLAMP(v, 0, 255);
-                    //TODO: This needs to write to a separate buffer
-                    m_pixels[ix + iy * m_width] = v;
+                    int factor = filter.kernel[sx][sy];
+                    unsigned char pixelv = aInImg->Getpixel( ix + sx - 2,
+                                                             iy + sy - 2 );
+
+                    v += pixelv * factor;
                 }
             }
 
-            threadsFinished++;
-        } );
-
-        t.detach();
-    }
+            v /= filter.div;
+            v += filter.offset;
+            CLAMP(v, 0, 255);
+            //TODO: This needs to write to a separate buffer
+            m_pixels[ix + iy * m_width] = v;
+        }
+    };
 
-    while( threadsFinished < parallelThreadCount )
-        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    ParallelFor( 0, m_height, filter_lambda );
 }
 
 
@@ -87,6 +87,61 @@ static const wxChar RealtimeConnectivity[] = wxT( "RealtimeConnectivity" );
  */
 static const wxChar CoroutineStackSize[] = wxT( "CoroutineStackSize" );
 
+/**
+ * Limit the number of worker threads used for parallel operations (zone filling, connectivity,
+ * 3D rendering...).  0 uses one thread per hardware thread.  Useful on many-core machines
+ * shared with other jobs.
+ */
+static const wxChar MaxWorkerThreads[] = wxT( "MaxWorkerThreads" );
+
+/**
+ * Re-check the DRC markers of the tracks changed by the interactive router after each of its
+ * commits, spending at most this many milliseconds.  What does not fit is checked after the
+ * next commit.  0 (the default) disables it; a DRC must have been run once before.
+ */
+static const wxChar RealtimeDrcBudget[] = wxT( "RealtimeDrcBudget" );
+
+/**
+ * Split the polygon booleans of the zone fills having at least this many contours (outline,
+ * holes and clearance knockouts) in tiles computed in parallel.  Large ground planes fill
+ * much faster this way.  0 (the default) keeps the single pass booleans.
+ */
+static const wxChar ZoneFillPartitionContours[] = wxT( "ZoneFillPartitionContours" );
+
+/**
+ * Write a binary snapshot (board-file.kicad_pcb-snapshot) next to the saved boards, holding
+ * their tracks and zone fills in binary.  Boards are then loaded from their snapshot as long
+ * as the board file did not change since, which is much faster for large boards.
+ */
+static const wxChar BoardSnapshots[] = wxT( "BoardSnapshots" );
+
+/**
+ * Minimum number of items the view updates at once (e.g. when loading a board or switching
+ * the display options) for their geometry to be drawn by several threads into their own vertex
+ * buffers, the GUI thread then only moving the buffers to the cache.  0 disables it.
+ */
+static const wxChar ParallelRecacheItems[] = wxT( "ParallelRecacheItems" );
+
+/**
+ * Items spanning fewer pixels than this on the screen are drawn as coarse shapes merged with
+ * their neighbours in a few groups per screen tile, instead of one group per item.  This keeps
+ * the zoomed out views of boards with many vias and pads responsive.  0 disables it.
+ */
+static const wxChar LodPixelThreshold[] = wxT( "LodPixelThreshold" );
+
+/**
+ * Show the vertex memory used by the OpenGL canvas in the display options: the size of the
+ * buffer, the part of it holding vertices and the work done by the allocator to keep it so.
+ */
+static const wxChar ShowVertexMemoryStats[] = wxT( "ShowVertexMemoryStats" );
+
+/**
+ * Draw the pads and vias sharing the same shape with instanced draw calls in the OpenGL canvas:
+ * the shape is stored once, each pad only as a position, a rotation and a color. Off to
+ * compare with the vertices of every pad being stored.
+ */
+static const wxChar ShapeInstancing[] = wxT( "ShapeInstancing" );
+
 } // namespace KEYS
 
 
@@ -167,6 +222,14 @@ ADVANCED_CFG::ADVANCED_CFG()
     m_EnableUsePadProperty = false;
     m_realTimeConnectivity = true;
     m_coroutineStackSize = AC_STACK::default_stack;
+    m_maxWorkerThreads = 0;
+    m_realTimeDrcBudget = 0;
+    m_zoneFillPartitionContours = 0;
+    m_boardSnapshots = false;
+    m_parallelRecacheItems = 1000;
+    m_lodPixelThreshold = 3;
+    m_showVertexMemoryStats = false;
+    m_shapeInstancing = true;
 
     loadFromConfigFile();
 }
@@ -210,6 +273,30 @@ void ADVANCED_CFG::loadSettings( wxConfigBase& aCfg )
                                                &m_coroutineStackSize, AC_STACK::default_stack,
                                                AC_STACK::min_stack, AC_STACK::max_stack ) );
 
+    configParams.push_back( new PARAM_CFG_INT( true, AC_KEYS::MaxWorkerThreads,
+                                               &m_maxWorkerThreads, 0, 0, 1024 ) );
+
+    configParams.push_back( new PARAM_CFG_INT( true, AC_KEYS::RealtimeDrcBudget,
+                                               &m_realTimeDrcBudget, 0, 0, 10000 ) );
+
+    configParams.push_back( new PARAM_CFG_INT( true, AC_KEYS::ZoneFillPartitionContours,
+                                               &m_zoneFillPartitionContours, 0, 0, 10000000 ) );
+
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::BoardSnapshots,
+                                                &m_boardSnapshots, false ) );
+
+    configParams.push_back( new PARAM_CFG_INT( true, AC_KEYS::ParallelRecacheItems,
+                                               &m_parallelRecacheItems, 1000, 0, 10000000 ) );
+
+    configParams.push_back( new PARAM_CFG_INT( true, AC_KEYS::LodPixelThreshold,
+                                               &m_lodPixelThreshold, 3, 0, 100 ) );
+
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::ShowVertexMemoryStats,
+                                                &m_showVertexMemoryStats, false ) );
+
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::ShapeInstancing,
+                                                &m_shapeInstancing, true ) );
+
     wxConfigLoadSetups( &aCfg, configParams );
 
     for( auto param : configParams )
@@ -44,6 +44,9 @@ using KIGFX::COLOR4D;
 // Create only once, as seeding is *very* expensive
 static boost::uuids::random_generator randomGenerator;
 
+// The generator is not thread-safe, and board items get created from worker threads too
+static std::mutex randomGeneratorLock;
+
 // These don't have the same performance penalty, but might as well be consistent
 static boost::uuids::string_generator stringGenerator;
 static boost::uuids::nil_generator nilGenerator;
@@ -52,8 +55,15 @@ static boost::uuids::nil_generator nilGenerator;
 KIID niluuid( 0 );
 
 
+static boost::uuids::uuid newRandomUuid()
+{
+    std::lock_guard<std::mutex> guard( randomGeneratorLock );
+    return randomGenerator();
+}
+
+
 KIID::KIID() :
-        m_uuid( randomGenerator() ),
+        m_uuid( newRandomUuid() ),
         m_cached_timestamp( 0 )
 {
 #if defined(EESCHEMA)
@@ -109,7 +119,7 @@ KIID::KIID( const wxString& aString ) :
         {
             // Failed to parse string representation; best we can do is assign a new
             // random one.
-            m_uuid = randomGenerator();
+            m_uuid = newRandomUuid();
         }
     }
 }
@@ -570,6 +580,30 @@ const wxString ExpandEnvVarSubstitutions( const wxString& aString, PROJECT* aPro
 }
 
 
+wxString GetUserCachePath()
+{
+    // wxWidgets has no function to retrieve a user cache directory
+    wxString cacheDir;
+
+#if defined( _WIN32 )
+    wxStandardPaths::Get().UseAppInfo( wxStandardPaths::AppInfo_None );
+    cacheDir = wxStandardPaths::Get().GetUserLocalDataDir();
+    cacheDir.append( "\\kicad\\" );
+#elif defined( __APPLE__ )
+    cacheDir = ExpandEnvVarSubstitutions( "${HOME}/Library/Caches/kicad/", nullptr );
+#else   // assume Linux
+    cacheDir = ExpandEnvVarSubstitutions( "${XDG_CACHE_HOME}", nullptr );
+
+    if( cacheDir.empty() || cacheDir == "${XDG_CACHE_HOME}" )
+        cacheDir = ExpandEnvVarSubstitutions( "${HOME}/.cache", nullptr );
+
+    cacheDir.append( "/kicad/" );
+#endif
+
+    return cacheDir;
+}
+
+
 const wxString ResolveUriByEnvVars( const wxString& aUri, PROJECT* aProject )
 {
     wxString uri = ExpandTextVars( aUri, nullptr, aProject );
@@ -655,7 +655,7 @@ L_read:
                     case 'v':   c = '\x0b';     break;
 
                     case 'x':   // 1 or 2 byte hex escape sequence
-                        for( i=0; i<2; ++i )
+                        for( i=0; i<2 && head+i<limit; ++i )
                         {
                             if( !isxdigit( head[i] ) )
                                 break;
@@ -671,7 +671,7 @@ L_read:
 
                     default:    // 1-3 byte octal escape sequence
                         --head;
-                        for( i=0; i<3; ++i )
+                        for( i=0; i<3 && head+i<limit; ++i )
                         {
                             if( head[i] < '0' || head[i] > '7' )
                                 break;
@@ -697,7 +697,15 @@ L_read:
                 }
 
                 else
-                    curText += *head++;
+                {
+                    // the plain characters up to the next escape or quote, at once
+                    const char* run = head;
+
+                    while( head<limit && *head!='\\' && *head!='"' )
+                        ++head;
+
+                    curText.append( run, head );
+                }
 
             }   // while
 
@@ -777,11 +785,11 @@ L_read:
     }           // specctraMode
 
     // non-quoted token, read it into curText.
-    curText.clear();
-
     head = cur;
     while( head<limit && !isSep( *head ) )
-        curText += *head++;
+        ++head;
+
+    curText.assign( cur, head );
 
     if( isNumber( curText.c_str(), curText.c_str() + curText.size() ) )
     {
@@ -808,6 +816,81 @@ exit:   // single point of exit, no returns elsewhere please.
 }
 
 
+void DSNLEXER::CaptureList( std::string* aText )
+{
+    wxASSERT( !specctraMode );
+
+    int         depth = 1;          // the opening parenthesis of the list itself
+    bool        inString = false;
+    bool        afterSep = true;    // a double quote only opens a string at a token start
+    const char* cur = next;
+    const char* run = next;
+
+    aText->assign( 1, '(' );
+    aText->append( curText );
+
+    for(;;)
+    {
+        while( cur < limit )
+        {
+            char cc = *cur++;
+
+            if( inString )
+            {
+                if( cc == '\\' && cur < limit )
+                    ++cur;
+                else if( cc == '"' )
+                    inString = false;
+
+                afterSep = true;
+                continue;
+            }
+
+            if( cc == '"' && afterSep )
+            {
+                inString = true;
+                continue;
+            }
+
+            if( cc == '(' )
+            {
+                ++depth;
+            }
+            else if( cc == ')' && --depth == 0 )
+            {
+                aText->append( run, cur );
+
+                prevTok   = curTok;
+                curTok    = DSN_RIGHT;
+                curText   = cc;
+                curOffset = cur - 1 - start;
+                next      = cur;
+                return;
+            }
+
+            afterSep = isSep( cc );
+        }
+
+        aText->append( run, limit );
+
+        if( readLine() == 0 )
+            Expecting( DSN_RIGHT );
+
+        // strings don't span lines, and comment lines are skipped by NextTok()
+        cur      = start;
+        run      = start;
+        inString = false;
+        afterSep = true;
+
+        while( cur < limit && isSpace( *cur ) )
+            ++cur;
+
+        if( cur < limit && *cur == '#' )
+            cur = limit;
+    }
+}
+
+
 wxArrayString* DSNLEXER::ReadCommentLines()
 {
     wxArrayString*  ret = 0;
@@ -338,6 +338,20 @@ const MODULE* FP_LIB_TABLE::GetEnumeratedFootprint( const wxString& aNickname,
 }
 
 
+bool FP_LIB_TABLE::GetEnumeratedFootprintInfo( const wxString& aNickname,
+                                               const wxString& aFootprintName,
+                                               wxString* aDescription, wxString* aKeywords,
+                                               unsigned* aPadCount, unsigned* aUniquePadCount )
+{
+    const FP_LIB_TABLE_ROW* row = FindRow( aNickname );
+    wxASSERT( (PLUGIN*) row->plugin );
+
+    return row->plugin->GetEnumeratedFootprintInfo( row->GetFullURI( true ), aFootprintName,
+                                                    aDescription, aKeywords, aPadCount,
+                                                    aUniquePadCount, row->GetProperties() );
+}
+
+
 bool FP_LIB_TABLE::FootprintExists( const wxString& aNickname, const wxString& aFootprintName )
 {
     try
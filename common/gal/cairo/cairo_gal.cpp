@@ -1148,7 +1148,7 @@ void CAIRO_GAL_BASE::drawPoly( const VECTOR2D aPointList[], int aListSize )
     const auto p = roundp( xform( ptr->x, ptr->y ) );
     cairo_move_to( currentContext, p.x, p.y );
 
-    for( int i = 0; i < aListSize; ++i )
+    for( int i = 1; i < aListSize; ++i )
     {
         ++ptr;
         const auto p2 = roundp( xform( ptr->x, ptr->y ) );
@@ -1160,6 +1160,44 @@ void CAIRO_GAL_BASE::drawPoly( const VECTOR2D aPointList[], int aListSize )
 }
 
 
+void CAIRO_GAL_BASE::DrawPolylines( const std::vector<VECTOR2D>& aPoints,
+                                    const std::vector<unsigned int>& aStarts )
+{
+    // Filling the polylines one by one is not the same as filling them all as one path
+    if( isFillEnabled )
+    {
+        GAL::DrawPolylines( aPoints, aStarts );
+        return;
+    }
+
+    if( aStarts.empty() )
+        return;
+
+    syncLineWidth();
+
+    // All the polylines are stroked at once, as the subpaths of a single path
+    for( size_t ii = 0; ii < aStarts.size(); ++ii )
+    {
+        unsigned int end = ii + 1 < aStarts.size() ? aStarts[ii + 1] : aPoints.size();
+
+        if( end <= aStarts[ii] )
+            continue;
+
+        const auto p = roundp( xform( aPoints[aStarts[ii]] ) );
+        cairo_move_to( currentContext, p.x, p.y );
+
+        for( unsigned int jj = aStarts[ii] + 1; jj < end; ++jj )
+        {
+            const auto p2 = roundp( xform( aPoints[jj] ) );
+            cairo_line_to( currentContext, p2.x, p2.y );
+        }
+    }
+
+    flushPath();
+    isElementAdded = true;
+}
+
+
 void CAIRO_GAL_BASE::drawPoly( const SHAPE_LINE_CHAIN& aLineChain )
 {
     if( aLineChain.PointCount() < 2 )
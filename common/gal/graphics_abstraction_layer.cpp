@@ -89,6 +89,23 @@ GAL::~GAL()
 }
 
 
+void GAL::copyViewSettings( const GAL& aGal )
+{
+    screenSize        = aGal.screenSize;
+    worldUnitLength   = aGal.worldUnitLength;
+    screenDPI         = aGal.screenDPI;
+    lookAtPoint       = aGal.lookAtPoint;
+    zoomFactor        = aGal.zoomFactor;
+    rotation          = aGal.rotation;
+    worldScreenMatrix = aGal.worldScreenMatrix;
+    screenWorldMatrix = aGal.screenWorldMatrix;
+    worldScale        = aGal.worldScale;
+    globalFlipX       = aGal.globalFlipX;
+    globalFlipY       = aGal.globalFlipY;
+    depthRange        = aGal.depthRange;
+}
+
+
 void GAL::OnGalDisplayOptionsChanged( const GAL_DISPLAY_OPTIONS& aOptions )
 {
     // defer to the child class first
@@ -178,6 +195,21 @@ VECTOR2D GAL::GetTextLineSize( const UTF8& aText, int aMarkupFlags ) const
 }
 
 
+void GAL::DrawPolylines( const std::vector<VECTOR2D>& aPoints,
+                         const std::vector<unsigned int>& aStarts )
+{
+    std::deque<VECTOR2D> pointList;
+
+    for( size_t ii = 0; ii < aStarts.size(); ++ii )
+    {
+        size_t end = ii + 1 < aStarts.size() ? aStarts[ii + 1] : aPoints.size();
+
+        pointList.assign( aPoints.begin() + aStarts[ii], aPoints.begin() + end );
+        DrawPolyline( pointList );
+    }
+}
+
+
 void GAL::ComputeWorldScreenMatrix()
 {
     computeWorldScale();
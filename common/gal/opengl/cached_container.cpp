@@ -34,8 +34,9 @@
 #include <gal/opengl/vertex_item.h>
 #include <gal/opengl/utils.h>
 
-#include <list>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 #ifdef __WXDEBUG__
 #include <wx/log.h>
@@ -44,11 +45,27 @@
 
 using namespace KIGFX;
 
+///> Size of the blocks of the smallest size class, expressed in vertices
+static const unsigned int MIN_BLOCK_SIZE = 4;
+
+///> Size classes are spaced by 1.5 and 2 in turn, the largest one fits twice in a page
+static const int SIZE_CLASS_COUNT = 23;
+
+
 CACHED_CONTAINER::CACHED_CONTAINER( unsigned int aSize ) :
-    VERTEX_CONTAINER( aSize ), m_item( NULL ), m_chunkSize( 0 ), m_chunkOffset( 0 ), m_maxIndex( 0 )
+    VERTEX_CONTAINER( aSize ), m_item( NULL ), m_chunkSize( 0 ), m_chunkOffset( 0 ),
+    m_maxIndex( 0 ), m_storedVertices( 0 ), m_resizes( 0 ), m_compactions( 0 )
 {
+    // The container is made of whole pages
+    unsigned int pageCount = std::max( 1u, ( aSize + PAGE_SIZE - 1 ) / PAGE_SIZE );
+
+    m_currentSize = pageCount * PAGE_SIZE;
+    m_initialSize = m_currentSize;
+    m_freeSpace   = m_currentSize;
+
     // In the beginning there is only free space
-    m_freeChunks.insert( std::make_pair( aSize, 0 ) );
+    m_pages.resize( pageCount );
+    m_partialSlabs.resize( SIZE_CLASS_COUNT );
 }
 
 
@@ -58,10 +75,10 @@ void CACHED_CONTAINER::SetItem( VERTEX_ITEM* aItem )
 
     unsigned int itemSize = aItem->GetSize();
     m_item      = aItem;
-    m_chunkSize = itemSize;
 
     // Get the previously set offset if the item was stored previously
     m_chunkOffset = itemSize > 0 ? aItem->GetOffset() : -1;
+    m_chunkSize   = itemSize > 0 ? chunkCapacity( m_chunkOffset ) : 0;
 
 #if CACHED_CONTAINER_TEST > 1
     wxLogDebug( wxT( "Adding/editing item 0x%08lx (size %d)" ), (long) m_item, itemSize );
@@ -76,21 +93,33 @@ void CACHED_CONTAINER::FinishItem()
     unsigned int itemSize = m_item->GetSize();
 
     // Finishing the previously edited item
-    if( itemSize < m_chunkSize )
+    if( itemSize > 0 )
     {
-        // There is some not used but reserved memory left, so we should return it to the pool
-        int itemOffset = m_item->GetOffset();
-
-        // Add the not used memory back to the pool
-        addFreeChunk( itemOffset + itemSize, m_chunkSize - itemSize );
-        // mergeFreeChunks();   // veery slow and buggy
+        int itemClass = sizeClass( itemSize );
 
-        m_maxIndex = std::max( itemOffset + itemSize, m_maxIndex );
+        if( itemClass < 0 )
+        {
+            // Return the pages left unused at the end of the run to the pool
+            unsigned int first = m_chunkOffset / PAGE_SIZE;
+            unsigned int count = ( itemSize + PAGE_SIZE - 1 ) / PAGE_SIZE;
+            PAGE&        run   = m_pages[first];
+
+            if( count < run.m_used )
+            {
+                m_freeSpace += ( run.m_used - count ) * PAGE_SIZE;
+                freePages( first + count, run.m_used - count );
+                run.m_used = count;
+                updateMaxIndex();
+            }
+        }
+        else if( blockSize( itemClass ) < m_chunkSize )
+        {
+            // There is some not used but reserved memory left, so move the item to a block
+            // of the right size. If that is not possible, the item simply stays where it is.
+            reallocate( itemSize );
+        }
     }
 
-    if( itemSize > 0 )
-        m_items.insert( m_item );
-
     m_item = NULL;
     m_chunkSize = 0;
     m_chunkOffset = 0;
@@ -127,6 +156,7 @@ VERTEX* CACHED_CONTAINER::Allocate( unsigned int aSize )
 
     // Now the item officially possesses the memory chunk
     m_item->setSize( newSize );
+    m_storedVertices += aSize;
 
     // The content has to be updated
     m_dirty = true;
@@ -135,7 +165,6 @@ VERTEX* CACHED_CONTAINER::Allocate( unsigned int aSize )
     test();
 #endif
 #if CACHED_CONTAINER_TEST > 2
-    showFreeChunks();
     showUsedChunks();
 #endif
 
@@ -146,7 +175,6 @@ VERTEX* CACHED_CONTAINER::Allocate( unsigned int aSize )
 void CACHED_CONTAINER::Delete( VERTEX_ITEM* aItem )
 {
     assert( aItem != NULL );
-    assert( m_items.find( aItem ) != m_items.end() || aItem->GetSize() == 0 );
 
     int size = aItem->GetSize();
 
@@ -159,118 +187,195 @@ void CACHED_CONTAINER::Delete( VERTEX_ITEM* aItem )
     wxLogDebug( wxT( "Removing 0x%08lx (size %d offset %d)" ), (long) aItem, size, offset );
 #endif
 
-    // Insert a free memory chunk entry in the place where item was stored
-    addFreeChunk( offset, size );
+    // Give the block back to its slab, or the pages back to the pool
+    freeChunk( offset );
+    m_storedVertices -= size;
 
     // Indicate that the item is not stored in the container anymore
     aItem->setSize( 0 );
 
-    m_items.erase( aItem );
-
 #if CACHED_CONTAINER_TEST > 0
     test();
 #endif
-
-    // This dynamic memory freeing optimize memory usage, but in fact can create
-    // out of memory issues because freeing and reallocation large chunks of memory
-    // can create memory fragmentation and no room to reallocate large chunks
-    // after many free/reallocate cycles during a session using the same complex board
-    // So it can be disable.
-    // Currently: it is disable to avoid "out of memory" issues
-#if 0
-    // Dynamic memory freeing, there is no point in holding
-    // a large amount of memory when there is no use for it
-    if( m_freeSpace > ( 0.75 * m_currentSize ) && m_currentSize > m_initialSize )
-    {
-        defragmentResize( 0.5 * m_currentSize );
-    }
-#endif
 }
 
 
 void CACHED_CONTAINER::Clear()
 {
-    m_freeSpace = m_currentSize;
-    m_maxIndex = 0;
-    m_failed = false;
-
     // Set the size of all the stored VERTEX_ITEMs to 0, so it is clear that they are not held
     // in the container anymore
-    for( ITEMS::iterator it = m_items.begin(); it != m_items.end(); ++it )
-        ( *it )->setSize( 0 );
+    for( PAGE& page : m_pages )
+    {
+        for( VERTEX_ITEM* item : page.m_owners )
+        {
+            if( item )
+                item->setSize( 0 );
+        }
 
-    m_items.clear();
+        page = PAGE();
+    }
+
+    for( std::vector<unsigned int>& partial : m_partialSlabs )
+        partial.clear();
 
-    // Now there is only free space left
-    m_freeChunks.clear();
-    m_freeChunks.insert( std::make_pair( m_freeSpace, 0 ) );
+    m_freeSpace = m_currentSize;
+    m_maxIndex = 0;
+    m_storedVertices = 0;
+    m_failed = false;
 }
 
 
-bool CACHED_CONTAINER::reallocate( unsigned int aSize )
+void CACHED_CONTAINER::Compact( unsigned int aMaxVertices )
 {
-    assert( aSize > 0 );
+    assert( m_item == NULL );
     assert( IsMapped() );
 
-    unsigned int itemSize = m_item->GetSize();
+    unsigned int moved = 0;
+    bool         released = false;
 
-#if CACHED_CONTAINER_TEST > 2
-    wxLogDebug( wxT( "Resize %p from %d to %d" ), m_item, itemSize, aSize );
-#endif
-
-    // Find a free space chunk >= aSize
-    FREE_CHUNK_MAP::iterator newChunk = m_freeChunks.lower_bound( aSize );
-
-    // Is there enough space to store vertices?
-    if( newChunk == m_freeChunks.end() )
+    for( int cls = 0; cls < SIZE_CLASS_COUNT; ++cls )
     {
-        bool result;
+        std::vector<unsigned int>& partial = m_partialSlabs[cls];
+        unsigned int               size = blockSize( cls );
+        unsigned int               blocks = PAGE_SIZE / size;
 
-        // Would it be enough to double the current space?
-        if( aSize < m_freeSpace + m_currentSize )
+        // Empty slabs are kept until now, for the items deleted and added again in an update
+        for( size_t ii = 0; ii < partial.size(); )
         {
-            // Yes: exponential growing
-            result = defragmentResize( m_currentSize * 2 );
+            if( m_pages[partial[ii]].m_used == 0 )
+            {
+                freePages( partial[ii], 1 );
+                partial[ii] = partial.back();
+                partial.pop_back();
+                released = true;
+            }
+            else
+            {
+                ++ii;
+            }
         }
-        else
+
+        if( moved >= aMaxVertices || partial.size() < 2 )
+            continue;
+
+        // Emptiest slabs first; new blocks are taken from the back, that is the fullest slabs
+        std::sort( partial.begin(), partial.end(),
+                [&]( unsigned int aA, unsigned int aB )
+                {
+                    return m_pages[aA].m_used < m_pages[aB].m_used;
+                } );
+
+        size_t freeBlocks = 0;
+
+        for( unsigned int page : partial )
+            freeBlocks += m_pages[page].m_freeBlocks.size();
+
+        while( partial.size() > 1 && moved < aMaxVertices )
         {
-            // No: grow to the nearest greater power of 2
-            result = defragmentResize( pow( 2, ceil( log2( m_currentSize * 2 + aSize ) ) ) );
+            unsigned int page = partial.front();
+            unsigned int used = m_pages[page].m_used;
+
+            // The other slabs have to take all the blocks of this one
+            if( freeBlocks - m_pages[page].m_freeBlocks.size() < used )
+                break;
+
+            freeBlocks -= m_pages[page].m_freeBlocks.size() + used;
+            partial.erase( partial.begin() );
+
+            for( unsigned int block = 0; block < blocks; ++block )
+            {
+                VERTEX_ITEM* item = m_pages[page].m_owners[block];
+
+                if( !item )
+                    continue;
+
+                int offset = allocateChunk( size, item );
+                assert( offset >= 0 && (unsigned int) offset / PAGE_SIZE != page );
+
+                memcpy( &m_vertices[offset], &m_vertices[item->GetOffset()],
+                        item->GetSize() * VERTEX_SIZE );
+                item->setOffset( offset );
+                moved += item->GetSize();
+            }
+
+            m_freeSpace += used * size;
+            freePages( page, 1 );
+            m_compactions++;
+            released = true;
         }
+    }
+
+    if( released )
+        updateMaxIndex();
+
+    if( moved > 0 )
+        m_dirty = true;
+
+#if CACHED_CONTAINER_TEST > 0
+    test();
+#endif
+}
 
-        if( !result )
-            return false;
 
-        newChunk = m_freeChunks.lower_bound( aSize );
-        assert( newChunk != m_freeChunks.end() );
+VERTEX_MEMORY_STATS CACHED_CONTAINER::GetStats() const
+{
+    VERTEX_MEMORY_STATS stats;
+
+    stats.m_reserved = (unsigned long long) m_currentSize * VERTEX_SIZE;
+    stats.m_inUse = (unsigned long long) m_storedVertices * VERTEX_SIZE;
+    stats.m_resizes = m_resizes;
+    stats.m_compactions = m_compactions;
+
+    for( const PAGE& page : m_pages )
+    {
+        if( page.m_class == FREE_PAGE )
+            continue;
+
+        stats.m_slabs += (unsigned long long) PAGE_SIZE * VERTEX_SIZE;
+
+        if( page.m_class >= 0 || page.m_used > 0 )
+            stats.m_slabCount++;
     }
 
-    // Parameters of the allocated chunk
-    unsigned int newChunkSize   = getChunkSize( *newChunk );
-    unsigned int newChunkOffset = getChunkOffset( *newChunk );
+    return stats;
+}
+
+
+bool CACHED_CONTAINER::reallocate( unsigned int aSize )
+{
+    assert( aSize > 0 );
+    assert( IsMapped() );
+
+    unsigned int itemSize = m_item->GetSize();
+
+#if CACHED_CONTAINER_TEST > 2
+    wxLogDebug( wxT( "Resize %p from %d to %d" ), m_item, itemSize, aSize );
+#endif
+
+    // A large item is moved to a run of pages with room to double, so that growing a few
+    // vertices at a time does not copy it again at every page. FinishItem() gives the pages
+    // left unused back.
+    unsigned int reserved = sizeClass( aSize ) < 0 ? std::max( aSize, 2 * itemSize ) : aSize;
+    int          newChunkOffset = allocateChunk( reserved, m_item );
 
-    assert( newChunkSize >= aSize );
-    assert( newChunkOffset < m_currentSize );
+    if( newChunkOffset < 0 )
+        return false;
 
     // Check if the item was previously stored in the container
     if( itemSize > 0 )
     {
 #if CACHED_CONTAINER_TEST > 3
         wxLogDebug( wxT( "Moving 0x%08x from 0x%08x to 0x%08x" ),
-                    (int) m_item, oldChunkOffset, newChunkOffset );
+                    (int) m_item, m_chunkOffset, newChunkOffset );
 #endif
         // The item was reallocated, so we have to copy all the old data to the new place
         memcpy( &m_vertices[newChunkOffset], &m_vertices[m_chunkOffset], itemSize * VERTEX_SIZE );
 
         // Free the space used by the previous chunk
-        addFreeChunk( m_chunkOffset, m_chunkSize );
+        freeChunk( m_chunkOffset );
     }
 
-    // Remove the new allocated chunk from the free space pool
-    m_freeChunks.erase( newChunk );
-    m_freeSpace -= newChunkSize;
-
-    m_chunkSize = newChunkSize;
+    m_chunkSize = chunkCapacity( newChunkOffset );
     m_chunkOffset = newChunkOffset;
 
     m_item->setOffset( m_chunkOffset );
@@ -279,145 +384,213 @@ bool CACHED_CONTAINER::reallocate( unsigned int aSize )
 }
 
 
-void CACHED_CONTAINER::defragment( VERTEX* aTarget )
+int CACHED_CONTAINER::sizeClass( unsigned int aSize )
+{
+    for( int cls = 0; cls < SIZE_CLASS_COUNT; ++cls )
+    {
+        if( blockSize( cls ) >= aSize )
+            return cls;
+    }
+
+    return -1;
+}
+
+
+unsigned int CACHED_CONTAINER::blockSize( int aClass )
+{
+    unsigned int size = MIN_BLOCK_SIZE << ( aClass / 2 );
+
+    return aClass % 2 ? size + size / 2 : size;
+}
+
+
+int CACHED_CONTAINER::allocateChunk( unsigned int aSize, VERTEX_ITEM* aOwner )
 {
-    // Defragmentation
-    ITEMS::iterator it, it_end;
-    int newOffset = 0;
+    int cls = sizeClass( aSize );
 
-    for( VERTEX_ITEM* item : m_items )
+    if( cls < 0 )
     {
-        int itemOffset    = item->GetOffset();
-        int itemSize      = item->GetSize();
+        // Large items get a run of pages for themselves
+        unsigned int count = ( aSize + PAGE_SIZE - 1 ) / PAGE_SIZE;
+        int          first = allocatePages( count );
+
+        if( first < 0 )
+            return -1;
+
+        for( unsigned int ii = first; ii < first + count; ++ii )
+            m_pages[ii].m_class = LARGE_PAGE;
 
-        // Move an item to the new container
-        memcpy( &aTarget[newOffset], &m_vertices[itemOffset], itemSize * VERTEX_SIZE );
+        m_pages[first].m_used = count;
+        m_pages[first].m_owners.assign( 1, aOwner );
 
-        // Update new offset
-        item->setOffset( newOffset );
+        m_freeSpace -= count * PAGE_SIZE;
+        m_maxIndex = std::max( m_maxIndex, ( first + count ) * PAGE_SIZE );
 
-        // Move to the next free space
-        newOffset += itemSize;
+        return first * PAGE_SIZE;
     }
 
-    // Move the current item and place it at the end
-    if( m_item->GetSize() > 0 )
+    std::vector<unsigned int>& partial = m_partialSlabs[cls];
+    unsigned int               size = blockSize( cls );
+
+    if( partial.empty() )
     {
-        memcpy( &aTarget[newOffset], &m_vertices[m_item->GetOffset()],
-                m_item->GetSize() * VERTEX_SIZE );
-        m_item->setOffset( newOffset );
-        m_chunkOffset = newOffset;
+        int newSlab = allocatePages( 1 );
+
+        if( newSlab < 0 )
+            return -1;
+
+        PAGE&        slab = m_pages[newSlab];
+        unsigned int blocks = PAGE_SIZE / size;
+
+        slab.m_class = cls;
+        slab.m_used = 0;
+        slab.m_owners.assign( blocks, nullptr );
+        slab.m_freeBlocks.resize( blocks );
+
+        // Blocks are taken from the back, that is from the beginning of the slab
+        for( unsigned int ii = 0; ii < blocks; ++ii )
+            slab.m_freeBlocks[ii] = blocks - 1 - ii;
+
+        partial.push_back( newSlab );
+        m_maxIndex = std::max( m_maxIndex, ( newSlab + 1 ) * PAGE_SIZE );
     }
 
-    m_maxIndex = usedSpace();
+    unsigned int page = partial.back();
+    PAGE&        slab = m_pages[page];
+    unsigned int block = slab.m_freeBlocks.back();
+
+    slab.m_freeBlocks.pop_back();
+    slab.m_owners[block] = aOwner;
+    slab.m_used++;
+
+    if( slab.m_freeBlocks.empty() )
+        partial.pop_back();
+
+    m_freeSpace -= size;
+
+    return page * PAGE_SIZE + block * size;
 }
 
 
-void CACHED_CONTAINER::mergeFreeChunks()
+void CACHED_CONTAINER::freeChunk( unsigned int aOffset )
 {
-    if( m_freeChunks.size() <= 1 ) // There are no chunks that can be merged
+    unsigned int page = aOffset / PAGE_SIZE;
+    PAGE&        chunkPage = m_pages[page];
+
+    if( chunkPage.m_class == LARGE_PAGE )
+    {
+        assert( aOffset % PAGE_SIZE == 0 && chunkPage.m_used > 0 );
+
+        m_freeSpace += chunkPage.m_used * PAGE_SIZE;
+        freePages( page, chunkPage.m_used );
+        updateMaxIndex();
         return;
+    }
 
-#ifdef __WXDEBUG__
-    PROF_COUNTER totalTime;
-#endif /* __WXDEBUG__ */
+    assert( chunkPage.m_class >= 0 );
 
-    // Reversed free chunks map - this one stores chunk size with its offset as the key
-    std::list<CHUNK> freeChunks;
+    unsigned int size = blockSize( chunkPage.m_class );
+    unsigned int block = ( aOffset % PAGE_SIZE ) / size;
 
-    FREE_CHUNK_MAP::const_iterator it, it_end;
+    assert( chunkPage.m_owners[block] != NULL );
 
-    for( it = m_freeChunks.begin(), it_end = m_freeChunks.end(); it != it_end; ++it )
-    {
-        freeChunks.emplace_back( it->second, it->first );
-    }
+    chunkPage.m_owners[block] = NULL;
+    chunkPage.m_freeBlocks.push_back( block );
+    chunkPage.m_used--;
 
-    m_freeChunks.clear();
-    freeChunks.sort();
+    // The slab was full, it can take blocks again. The slab is not released when it gets
+    // empty, that is up to Compact().
+    if( chunkPage.m_freeBlocks.size() == 1 )
+        m_partialSlabs[chunkPage.m_class].push_back( page );
 
-    std::list<CHUNK>::const_iterator itf, itf_end;
-    unsigned int offset = freeChunks.front().first;
-    unsigned int size   = freeChunks.front().second;
-    freeChunks.pop_front();
+    m_freeSpace += size;
+}
 
-    for( itf = freeChunks.begin(), itf_end = freeChunks.end(); itf != itf_end; ++itf )
-    {
-        if( itf->first == offset + size )
-        {
-            // These chunks can be merged, so just increase the current chunk size and go on
-            size += itf->second;
-        }
-        else
-        {
-            // These chunks cannot be merged
-            // So store the previous one
-            m_freeChunks.insert( std::make_pair( size, offset ) );
-            // and let's check the next chunk
-            offset = itf->first;
-            size   = itf->second;
 
-        }
-    }
+unsigned int CACHED_CONTAINER::chunkCapacity( unsigned int aOffset ) const
+{
+    const PAGE& page = m_pages[aOffset / PAGE_SIZE];
 
-    // Add the last one
-    m_freeChunks.insert( std::make_pair( size, offset ) );
+    if( page.m_class == LARGE_PAGE )
+        return page.m_used * PAGE_SIZE;
 
-#ifdef __WXDEBUG__
-    totalTime.Stop();
-    wxLogDebug( "Merged free chunks / %.1f ms", totalTime.msecs() );
-#endif /* __WXDEBUG__ */
-#if CACHED_CONTAINER_TEST > 0
-    test();
-#endif
+    assert( page.m_class >= 0 );
+
+    return blockSize( page.m_class );
 }
 
 
-void CACHED_CONTAINER::addFreeChunk( unsigned int aOffset, unsigned int aSize )
+int CACHED_CONTAINER::allocatePages( unsigned int aCount )
 {
-    assert( aOffset + aSize <= m_currentSize );
-    assert( aSize > 0 );
+    unsigned int run = 0;
+    unsigned int pageCount = m_pages.size();
+
+    // First fit; slabs are a single page, so only large items may not fit the gaps
+    for( unsigned int ii = 0; ii < pageCount; ++ii )
+    {
+        if( m_pages[ii].m_class != FREE_PAGE )
+            run = 0;
+        else if( ++run == aCount )
+            return ii + 1 - aCount;
+    }
+
+    // The container has to grow, the free pages at its end are the beginning of the run
+    unsigned int needed = pageCount + aCount - run;
+    unsigned int newCount = pageCount * 2;
+
+    while( newCount < needed )
+        newCount *= 2;
+
+    if( !resize( newCount * PAGE_SIZE ) )
+        return -1;
 
-    m_freeChunks.insert( std::make_pair( aSize, aOffset ) );
-    m_freeSpace += aSize;
+    m_freeSpace += ( newCount - pageCount ) * PAGE_SIZE;
+    m_currentSize = newCount * PAGE_SIZE;
+    m_pages.resize( newCount );
+    m_resizes++;
+
+    return pageCount - run;
 }
 
 
-void CACHED_CONTAINER::showFreeChunks()
+void CACHED_CONTAINER::freePages( unsigned int aFirst, unsigned int aCount )
 {
-#ifdef __WXDEBUG__
-    FREE_CHUNK_MAP::iterator it;
+    for( unsigned int ii = aFirst; ii < aFirst + aCount; ++ii )
+        m_pages[ii] = PAGE();
+}
 
-    wxLogDebug( wxT( "Free chunks:" ) );
 
-    for( it = m_freeChunks.begin(); it != m_freeChunks.end(); ++it )
-    {
-        unsigned int offset = getChunkOffset( *it );
-        unsigned int size   = getChunkSize( *it );
-        assert( size > 0 );
+void CACHED_CONTAINER::updateMaxIndex()
+{
+    unsigned int last = m_pages.size();
 
-        wxLogDebug( wxT( "[0x%08x-0x%08x] (size %d)" ),
-                    offset, offset + size - 1, size );
-    }
-#endif /* __WXDEBUG__ */
+    while( last > 0 && m_pages[last - 1].m_class == FREE_PAGE )
+        --last;
+
+    m_maxIndex = last * PAGE_SIZE;
 }
 
 
 void CACHED_CONTAINER::showUsedChunks()
 {
 #ifdef __WXDEBUG__
-    ITEMS::iterator it;
-
     wxLogDebug( wxT( "Used chunks:" ) );
 
-    for( it = m_items.begin(); it != m_items.end(); ++it )
+    for( unsigned int page = 0; page < m_pages.size(); ++page )
     {
-        VERTEX_ITEM* item   = *it;
-        unsigned int offset = item->GetOffset();
-        unsigned int size   = item->GetSize();
-        assert( size > 0 );
+        const PAGE& slab = m_pages[page];
+
+        for( VERTEX_ITEM* item : slab.m_owners )
+        {
+            if( !item )
+                continue;
+
+            unsigned int offset = item->GetOffset();
+            unsigned int size   = item->GetSize();
 
-        wxLogDebug( wxT( "[0x%08x-0x%08x] @ 0x%p (size %d)" ),
-                    offset, offset + size - 1, item, size );
+            wxLogDebug( wxT( "[0x%08x-0x%08x] @ 0x%p (size %d, page %d, class %d)" ),
+                        offset, offset + size - 1, item, size, page, slab.m_class );
+        }
     }
 #endif /* __WXDEBUG__ */
 }
@@ -426,29 +599,58 @@ void CACHED_CONTAINER::showUsedChunks()
 void CACHED_CONTAINER::test()
 {
 #ifdef __WXDEBUG__
-    // Free space check
+    // Free space check: free pages, free blocks of the slabs and the unusable ends of slabs
     unsigned int freeSpace = 0;
-    FREE_CHUNK_MAP::iterator itf;
+    unsigned int usedSpace = 0;
 
-    for( itf = m_freeChunks.begin(); itf != m_freeChunks.end(); ++itf )
-        freeSpace += getChunkSize( *itf );
+    for( unsigned int page = 0; page < m_pages.size(); ++page )
+    {
+        const PAGE& slab = m_pages[page];
 
-    assert( freeSpace == m_freeSpace );
+        if( slab.m_class == FREE_PAGE )
+        {
+            freeSpace += PAGE_SIZE;
+        }
+        else if( slab.m_class >= 0 )
+        {
+            unsigned int size = blockSize( slab.m_class );
+
+            assert( slab.m_used + slab.m_freeBlocks.size() == slab.m_owners.size() );
+            freeSpace += PAGE_SIZE - slab.m_used * size;
+
+            for( VERTEX_ITEM* item : slab.m_owners )
+            {
+                if( item && item != m_item )
+                {
+                    assert( item->GetOffset() / PAGE_SIZE == page );
+                    assert( item->GetSize() <= size );
+                    usedSpace += item->GetSize();
+                }
+            }
+        }
+        else if( slab.m_used > 0 )
+        {
+            VERTEX_ITEM* item = slab.m_owners[0];
+
+            if( item != m_item )
+            {
+                assert( item->GetOffset() == page * PAGE_SIZE );
+                assert( item->GetSize() <= slab.m_used * PAGE_SIZE );
+                usedSpace += item->GetSize();
+            }
+        }
+    }
 
-    // Used space check
-    unsigned int used_space = 0;
-    ITEMS::iterator itr;
-    for( itr = m_items.begin(); itr != m_items.end(); ++itr )
-        used_space += ( *itr )->GetSize();
+    assert( freeSpace == m_freeSpace );
 
     // If we have a chunk assigned, then there must be an item edited
     assert( m_chunkSize == 0 || m_item );
 
-    // Currently reserved chunk is also counted as used
-    used_space += m_chunkSize;
-
-    assert( ( m_freeSpace + used_space ) == m_currentSize );
+    // The item edited is counted separately, it is in the middle of getting its vertices
+    if( m_item )
+        usedSpace += m_item->GetSize();
 
-    // Overlapping check TODO
+    assert( usedSpace == m_storedVertices );
+    assert( m_maxIndex <= m_currentSize );
 #endif /* __WXDEBUG__ */
 }
@@ -29,7 +29,7 @@
 #include <gal/opengl/utils.h>
 
 #include <confirm.h>
-#include <list>
+#include <cstdlib>
 #include <cassert>
 
 #ifdef __WXDEBUG__
@@ -45,7 +45,7 @@ CACHED_CONTAINER_RAM::CACHED_CONTAINER_RAM( unsigned int aSize ) :
     glGenBuffers( 1, &m_verticesBuffer );
     checkGlError( "generating vertices buffer" );
 
-    m_vertices = static_cast<VERTEX*>( malloc( aSize * VERTEX_SIZE ) );
+    m_vertices = static_cast<VERTEX*>( malloc( m_currentSize * VERTEX_SIZE ) );
 }
 
 
@@ -71,45 +71,18 @@ void CACHED_CONTAINER_RAM::Unmap()
 }
 
 
-bool CACHED_CONTAINER_RAM::defragmentResize( unsigned int aNewSize )
+bool CACHED_CONTAINER_RAM::resize( unsigned int aNewSize )
 {
     wxLogTrace( "GAL_CACHED_CONTAINER",
-            wxT( "Resizing & defragmenting container (memcpy) from %d to %d" ),
-            m_currentSize, aNewSize );
+            wxT( "Resizing container from %d to %d" ), m_currentSize, aNewSize );
 
-    // No shrinking if we cannot fit all the data
-    if( usedSpace() > aNewSize )
-        return false;
-
-#ifdef __WXDEBUG__
-    PROF_COUNTER totalTime;
-#endif /* __WXDEBUG__ */
-
-    VERTEX* newBufferMem = static_cast<VERTEX*>( malloc( aNewSize * VERTEX_SIZE ) );
+    // The stored data keeps its offsets, so the buffer can simply be reallocated
+    VERTEX* newBufferMem = static_cast<VERTEX*>( realloc( m_vertices, aNewSize * VERTEX_SIZE ) );
 
     if( !newBufferMem )
         return false;
 
-    defragment( newBufferMem );
-
-    // Switch to the new vertex buffer
-    free( m_vertices );
     m_vertices = newBufferMem;
-
-#ifdef __WXDEBUG__
-    totalTime.Stop();
-
-    wxLogTrace( "GAL_CACHED_CONTAINER",
-                "Defragmented container storing %d vertices / %.1f ms",
-                m_currentSize - m_freeSpace, totalTime.msecs() );
-#endif /* __WXDEBUG__ */
-
-    m_freeSpace += ( aNewSize - m_currentSize );
-    m_currentSize = aNewSize;
-
-    // Now there is only one big chunk of free memory
-    m_freeChunks.clear();
-    m_freeChunks.insert( std::make_pair( m_freeSpace, m_currentSize - m_freeSpace ) );
     m_dirty = true;
 
     return true;
@@ -77,6 +77,13 @@ const float SHADER_LINE_F               = 10.0;
 const float MIN_WIDTH = 1.0;
 
 attribute vec4 attrShaderParams;
+
+// Instance of a shape: position (xy), depth offset (z) and rotation (w), and a color
+// multiplying the colors of the shape. The vertices drawn without instances get (0, 0, 0, 0)
+// and (1, 1, 1, 1).
+attribute vec4 attrInstance;
+attribute vec4 attrInstanceColor;
+
 varying vec4 shaderParams;
 varying vec2 circleCoords;
 uniform float worldPixelSize;
@@ -85,6 +92,11 @@ uniform float pixelSizeMultiplier;
 uniform float minLinePixelWidth;
 
 
+// The vertex and its color once placed by the instance
+vec4 vertex;
+vec4 color;
+
+
 float roundr( float f, float r )
 {
     return floor(f / r + 0.5) * r;
@@ -98,11 +110,10 @@ vec4 roundv( vec4 x, vec2 t)
 void computeLineCoords( bool posture, vec2 vs, vec2 vp, vec2 texcoord, vec2 dir, float lineWidth, bool endV )
 {
     float lineLength = length(vs);
-    vec4 screenPos = gl_ModelViewProjectionMatrix * gl_Vertex + vec4(1, 1, 0, 0);
+    vec4 screenPos = gl_ModelViewProjectionMatrix * vertex + vec4(1, 1, 0, 0);
     float w = ((lineWidth == 0.0) ? worldPixelSize : lineWidth );
     float pixelWidth = roundr( w / worldPixelSize, 1.0 );
     float aspect = ( lineLength + w ) / w;
-    vec4 color = gl_Color;
     vec2 s = sign( vec2( gl_ModelViewProjectionMatrix[0][0], gl_ModelViewProjectionMatrix[1][1] ) );
 
 
@@ -144,14 +155,14 @@ void computeLineCoords( bool posture, vec2 vs, vec2 vp, vec2 texcoord, vec2 dir,
     shaderParams[1] = aspect;
 
     gl_TexCoord[0].st = vec2(aspect * texcoord.x, texcoord.y);
-    gl_FrontColor = gl_Color;
+    gl_FrontColor = color;
 }
 
 
 void computeCircleCoords( float mode, float vertexIndex, float radius, float lineWidth )
 {
     vec4 delta;
-    vec4 center = roundv( gl_ModelViewProjectionMatrix * gl_Vertex + vec4(1, 1, 0, 0), screenPixelSize );
+    vec4 center = roundv( gl_ModelViewProjectionMatrix * vertex + vec4(1, 1, 0, 0), screenPixelSize );
     float pixelWidth = roundr( lineWidth / worldPixelSize, 1.0);
     float pixelR = roundr( radius / worldPixelSize, 1.0);
 
@@ -201,7 +212,7 @@ void computeCircleCoords( float mode, float vertexIndex, float radius, float lin
     delta.y *= screenPixelSize.y;
 
     gl_Position = center + delta + adjust;
-    gl_FrontColor = gl_Color;
+    gl_FrontColor = color;
 }
 
 
@@ -209,11 +220,20 @@ void main()
 {
     float mode = attrShaderParams[0];
 
+    // Place the vertex of a shape instance
+    float cosA = cos( attrInstance.w );
+    float sinA = sin( attrInstance.w );
+    mat2 rotation = mat2( cosA, sinA, -sinA, cosA );
+
+    vertex = vec4( rotation * gl_Vertex.xy + attrInstance.xy, gl_Vertex.z + attrInstance.z,
+                   gl_Vertex.w );
+    color = gl_Color * attrInstanceColor;
+
     // Pass attributes to the fragment shader
     shaderParams = attrShaderParams;
 
     float lineWidth = shaderParams.y;
-    vec2 vs = shaderParams.zw;
+    vec2 vs = rotation * shaderParams.zw;
     vec2 vp = vec2(-vs.y, vs.x);
     bool posture = abs( vs.x ) < abs(vs.y);
 
@@ -234,8 +254,8 @@ void main()
     else
     {
         // Pass through the coordinates like in the fixed pipeline
-        gl_Position = ftransform();
-        gl_FrontColor = gl_Color;
+        gl_Position = gl_ModelViewProjectionMatrix * vertex;
+        gl_FrontColor = color;
 
     }
 
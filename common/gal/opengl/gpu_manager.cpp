@@ -109,6 +109,7 @@ void GPU_CACHED_MANAGER::BeginDrawing()
     m_indicesSize = 0;
     // Set the indices pointer to the beginning of the indices-to-draw buffer
     m_indicesPtr = m_indices.get();
+    m_drawBreaks.clear();
 
     m_isDrawing = true;
 }
@@ -148,12 +149,58 @@ void GPU_CACHED_MANAGER::EndDrawing()
     if( cached->IsMapped() )
         cached->Unmap();
 
-    if( m_indicesSize == 0 )
+    if( m_indicesSize > 0 )
     {
-        m_isDrawing = false;
-        return;
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_indicesBuffer );
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER, m_indicesSize * sizeof(int),
+                (GLvoid*) m_indices.get(), GL_DYNAMIC_DRAW );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+    }
+
+    unsigned int drawn = 0;
+
+    for( std::pair<unsigned int, std::function<void()>>& drawBreak : m_drawBreaks )
+    {
+        drawIndices( drawn, drawBreak.first );
+        drawn = drawBreak.first;
+        drawBreak.second();
     }
 
+    drawIndices( drawn, m_indicesSize );
+
+#ifdef __WXDEBUG__
+    wxLogTrace( "GAL_PROFILE", wxT( "Cached manager size: %d" ), m_indicesSize );
+#endif /* __WXDEBUG__ */
+
+    if( m_indicesSize > 0 )
+        cached->ClearDirty();
+
+    m_drawBreaks.clear();
+    m_isDrawing = false;
+
+#ifdef __WXDEBUG__
+    totalRealTime.Stop();
+    wxLogTrace( "GAL_PROFILE",
+                wxT( "GPU_CACHED_MANAGER::EndDrawing(): %.1f ms" ), totalRealTime.msecs() );
+#endif /* __WXDEBUG__ */
+}
+
+
+void GPU_CACHED_MANAGER::AddDrawBreak( std::function<void()> aHandler )
+{
+    wxASSERT( m_isDrawing );
+
+    m_drawBreaks.emplace_back( m_indicesSize, std::move( aHandler ) );
+}
+
+
+void GPU_CACHED_MANAGER::drawIndices( unsigned int aBegin, unsigned int aEnd )
+{
+    if( aBegin >= aEnd )
+        return;
+
+    CACHED_CONTAINER* cached = static_cast<CACHED_CONTAINER*>( m_container );
+
     if( m_enableDepthTest )
         glEnable( GL_DEPTH_TEST );
     else
@@ -177,18 +224,11 @@ void GPU_CACHED_MANAGER::EndDrawing()
     }
 
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_indicesBuffer );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, m_indicesSize * sizeof(int),
-            (GLvoid*) m_indices.get(), GL_DYNAMIC_DRAW );
-
-    glDrawElements( GL_TRIANGLES, m_indicesSize, GL_UNSIGNED_INT, 0 );
-
-#ifdef __WXDEBUG__
-    wxLogTrace( "GAL_PROFILE", wxT( "Cached manager size: %d" ), m_indicesSize );
-#endif /* __WXDEBUG__ */
+    glDrawElements( GL_TRIANGLES, aEnd - aBegin, GL_UNSIGNED_INT,
+                    (GLvoid*) ( aBegin * sizeof( GLuint ) ) );
 
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
-    cached->ClearDirty();
 
     // Deactivate vertex array
     glDisableClientState( GL_COLOR_ARRAY );
@@ -199,14 +239,6 @@ void GPU_CACHED_MANAGER::EndDrawing()
         glDisableVertexAttribArray( m_shaderAttrib );
         m_shader->Deactivate();
     }
-
-    m_isDrawing = false;
-
-#ifdef __WXDEBUG__
-    totalRealTime.Stop();
-    wxLogTrace( "GAL_PROFILE",
-                wxT( "GPU_CACHED_MANAGER::EndDrawing(): %.1f ms" ), totalRealTime.msecs() );
-#endif /* __WXDEBUG__ */
 }
 
 
@@ -59,16 +59,20 @@ VERTEX* NONCACHED_CONTAINER::Allocate( unsigned int aSize )
 {
     if( m_freeSpace < aSize )
     {
-        // Double the space
+        // Double the space, as many times as needed for large allocations
+        unsigned int newSize = m_currentSize * 2;
+
+        while( newSize - m_freePtr < aSize )
+            newSize *= 2;
+
         VERTEX* newVertices = static_cast<VERTEX*>( realloc( m_vertices,
-                                                             m_currentSize * 2 *
-                                                             sizeof(VERTEX) ) );
+                                                             newSize * sizeof(VERTEX) ) );
 
         if( newVertices != NULL )
         {
             m_vertices    = newVertices;
-            m_freeSpace   += m_currentSize;
-            m_currentSize *= 2;
+            m_freeSpace   = newSize - m_freePtr;
+            m_currentSize = newSize;
         }
         else
         {
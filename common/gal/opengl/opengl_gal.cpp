@@ -35,6 +35,7 @@
 #include <gal/opengl/opengl_gal.h>
 #include <gal/opengl/utils.h>
 #include <gal/definitions.h>
+#include <advanced_config.h>
 #include <gl_context_mgr.h>
 #include <geometry/shape_poly_set.h>
 #include <bitmap_base.h>
@@ -48,6 +49,7 @@
 #include <wx/log.h>
 #endif /* __WXDEBUG__ */
 
+#include <algorithm>
 #include <functional>
 #include <limits>
 #include <memory>
@@ -188,22 +190,54 @@ GLuint GL_BITMAP_CACHE::cacheBitmap( const BITMAP_BASE* aBitmap )
     return textureID;
 }
 
+OPENGL_GAL_BASE::OPENGL_GAL_BASE( GAL_DISPLAY_OPTIONS& aDisplayOptions ) :
+    GAL( aDisplayOptions ),
+    currentManager( nullptr ),
+    m_shapeInstancing( false ),
+    m_shapesChanged( false ),
+    m_shapeSavedManager( nullptr ),
+    m_shapeSavedDepth( 0.0 )
+{
+    // Tesselator initialization
+    tesselator = gluNewTess();
+    InitTesselatorCallbacks( tesselator );
+
+    if( tesselator == NULL )
+        throw std::runtime_error( "Could not create the tesselator" );
+
+    gluTessProperty( tesselator, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_POSITIVE );
+}
+
+
+OPENGL_GAL_BASE::~OPENGL_GAL_BASE()
+{
+    gluDeleteTess( tesselator );
+}
+
+
 OPENGL_GAL::OPENGL_GAL( GAL_DISPLAY_OPTIONS& aDisplayOptions, wxWindow* aParent,
                         wxEvtHandler* aMouseListener, wxEvtHandler* aPaintListener,
                         const wxString& aName ) :
-    GAL( aDisplayOptions ),
+    OPENGL_GAL_BASE( aDisplayOptions ),
     HIDPI_GL_CANVAS( aParent, wxID_ANY, (int*) glAttributes, wxDefaultPosition, wxDefaultSize,
                 wxEXPAND, aName ),
     mouseListener( aMouseListener ),
     paintListener( aPaintListener ),
-    currentManager( nullptr ),
     cachedManager( nullptr ),
     nonCachedManager( nullptr ),
     overlayManager( nullptr ),
     mainBuffer( 0 ),
     overlayBuffer( 0 ),
     isContextLocked( false ),
-    lockClientCookie( 0 )
+    lockClientCookie( 0 ),
+    m_currentGroup( -1 ),
+    m_frameLayerStart( 0 ),
+    m_shapeBuffer( 0 ),
+    m_instanceBuffer( 0 ),
+    m_attrShaderParams( -1 ),
+    m_attrInstance( -1 ),
+    m_attrInstanceColor( -1 ),
+    m_depthTest( true )
 {
 // IsDisplayAttr() handles WX_GL_{MAJOR,MINOR}_VERSION correctly only in 3.0.4
 // starting with 3.1.0 one should use wxGLContext::IsOk() (done by GL_CONTEXT_MANAGER)
@@ -275,15 +309,6 @@ OPENGL_GAL::OPENGL_GAL( GAL_DISPLAY_OPTIONS& aDisplayOptions, wxWindow* aParent,
     SetGridColor( COLOR4D( 0.8, 0.8, 0.8, 0.1 ) );
     SetAxesColor( COLOR4D( BLUE ) );
 
-    // Tesselator initialization
-    tesselator = gluNewTess();
-    InitTesselatorCallbacks( tesselator );
-
-    if( tesselator == NULL )
-        throw std::runtime_error( "Could not create the tesselator" );
-
-    gluTessProperty( tesselator, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_POSITIVE );
-
     SetTarget( TARGET_NONCACHED );
 
     // Avoid unitialized variables:
@@ -299,7 +324,6 @@ OPENGL_GAL::~OPENGL_GAL()
 
     --instanceCounter;
     glFlush();
-    gluDeleteTess( tesselator );
     ClearCache();
 
     delete compositor;
@@ -311,6 +335,12 @@ OPENGL_GAL::~OPENGL_GAL()
         delete overlayManager;
     }
 
+    if( m_shapeBuffer )
+        glDeleteBuffers( 1, &m_shapeBuffer );
+
+    if( m_instanceBuffer )
+        glDeleteBuffers( 1, &m_instanceBuffer );
+
     GL_CONTEXT_MANAGER::Get().UnlockCtx( glPrivContext );
 
     // If it was the main context, then it will be deleted
@@ -506,6 +536,11 @@ void OPENGL_GAL::beginDrawing()
     shader->SetParameter( ufm_pixelSizeMultiplier, (float) pixelSizeMultiplier );
     shader->Deactivate();
 
+    resetInstanceAttributes();
+
+    m_frameInstances.clear();
+    m_frameLayerStart = 0;
+
     // Something betreen BeginDrawing and EndDrawing seems to depend on
     // this texture unit being active, but it does not assure it itself.
     glActiveTexture( GL_TEXTURE0 );
@@ -531,6 +566,8 @@ void OPENGL_GAL::endDrawing()
     // Cached & non-cached containers are rendered to the same buffer
     compositor->SetBuffer( mainBuffer );
     nonCachedManager->EndDrawing();
+    breakShapeInstances();
+    uploadShapeInstances();
     cachedManager->EndDrawing();
 
     // Overlay container is rendered to a different buffer
@@ -601,10 +638,11 @@ void OPENGL_GAL::endUpdate()
         return;
 
     cachedManager->Unmap();
+    options.m_vertexMemory = cachedManager->GetMemoryStats();
 }
 
 
-void OPENGL_GAL::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
+void OPENGL_GAL_BASE::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
 {
     currentManager->Color( strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.a );
 
@@ -612,8 +650,8 @@ void OPENGL_GAL::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoin
 }
 
 
-void OPENGL_GAL::DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint,
-                              double aWidth )
+void OPENGL_GAL_BASE::DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint,
+                                   double aWidth )
 {
     if( aStartPoint == aEndPoint )  // 0 length segments are just a circle.
     {
@@ -658,7 +696,7 @@ void OPENGL_GAL::DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndP
 }
 
 
-void OPENGL_GAL::DrawCircle( const VECTOR2D& aCenterPoint, double aRadius )
+void OPENGL_GAL_BASE::DrawCircle( const VECTOR2D& aCenterPoint, double aRadius )
 {
     if( isFillEnabled )
     {
@@ -714,8 +752,8 @@ void OPENGL_GAL::DrawCircle( const VECTOR2D& aCenterPoint, double aRadius )
 }
 
 
-void OPENGL_GAL::DrawArc( const VECTOR2D& aCenterPoint, double aRadius, double aStartAngle,
-                          double aEndAngle )
+void OPENGL_GAL_BASE::DrawArc( const VECTOR2D& aCenterPoint, double aRadius, double aStartAngle,
+                               double aEndAngle )
 {
     if( aRadius <= 0 )
         return;
@@ -780,8 +818,8 @@ void OPENGL_GAL::DrawArc( const VECTOR2D& aCenterPoint, double aRadius, double a
 }
 
 
-void OPENGL_GAL::DrawArcSegment( const VECTOR2D& aCenterPoint, double aRadius, double aStartAngle,
-                                 double aEndAngle, double aWidth )
+void OPENGL_GAL_BASE::DrawArcSegment( const VECTOR2D& aCenterPoint, double aRadius,
+                                      double aStartAngle, double aEndAngle, double aWidth )
 {
     if( aRadius <= 0 )
     {
@@ -876,7 +914,7 @@ void OPENGL_GAL::DrawArcSegment( const VECTOR2D& aCenterPoint, double aRadius, d
 }
 
 
-void OPENGL_GAL::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
+void OPENGL_GAL_BASE::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
 {
     // Compute the diagonal points of the rectangle
     VECTOR2D diagonalPointA( aEndPoint.x, aStartPoint.y );
@@ -914,19 +952,19 @@ void OPENGL_GAL::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEn
 }
 
 
-void OPENGL_GAL::DrawPolyline( const std::deque<VECTOR2D>& aPointList )
+void OPENGL_GAL_BASE::DrawPolyline( const std::deque<VECTOR2D>& aPointList )
 {
     drawPolyline( [&](int idx) { return aPointList[idx]; }, aPointList.size() );
 }
 
 
-void OPENGL_GAL::DrawPolyline( const VECTOR2D aPointList[], int aListSize )
+void OPENGL_GAL_BASE::DrawPolyline( const VECTOR2D aPointList[], int aListSize )
 {
     drawPolyline( [&](int idx) { return aPointList[idx]; }, aListSize );
 }
 
 
-void OPENGL_GAL::DrawPolyline( const SHAPE_LINE_CHAIN& aLineChain )
+void OPENGL_GAL_BASE::DrawPolyline( const SHAPE_LINE_CHAIN& aLineChain )
 {
     auto numPoints = aLineChain.PointCount();
 
@@ -937,7 +975,40 @@ void OPENGL_GAL::DrawPolyline( const SHAPE_LINE_CHAIN& aLineChain )
 }
 
 
-void OPENGL_GAL::DrawPolygon( const std::deque<VECTOR2D>& aPointList )
+void OPENGL_GAL_BASE::DrawPolylines( const std::vector<VECTOR2D>& aPoints,
+                                     const std::vector<unsigned int>& aStarts )
+{
+    // Polylines of a single point draw nothing, as with drawPolyline()
+    unsigned int segments = 0;
+
+    for( size_t ii = 0; ii < aStarts.size(); ++ii )
+    {
+        unsigned int end = ii + 1 < aStarts.size() ? aStarts[ii + 1] : aPoints.size();
+
+        if( end > aStarts[ii] + 1 )
+            segments += end - aStarts[ii] - 1;
+    }
+
+    if( segments == 0 )
+        return;
+
+    // A single allocation for all the lines
+    if( !currentManager->Reserve( 6 * segments ) )
+        return;
+
+    currentManager->Color( strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.a );
+
+    for( size_t ii = 0; ii < aStarts.size(); ++ii )
+    {
+        unsigned int end = ii + 1 < aStarts.size() ? aStarts[ii + 1] : aPoints.size();
+
+        for( unsigned int jj = aStarts[ii] + 1; jj < end; ++jj )
+            drawLineQuad( aPoints[jj - 1], aPoints[jj], false );
+    }
+}
+
+
+void OPENGL_GAL_BASE::DrawPolygon( const std::deque<VECTOR2D>& aPointList )
 {
     auto points = std::unique_ptr<GLdouble[]>( new GLdouble[3 * aPointList.size()] );
     GLdouble* ptr = points.get();
@@ -953,7 +1024,7 @@ void OPENGL_GAL::DrawPolygon( const std::deque<VECTOR2D>& aPointList )
 }
 
 
-void OPENGL_GAL::DrawPolygon( const VECTOR2D aPointList[], int aListSize )
+void OPENGL_GAL_BASE::DrawPolygon( const VECTOR2D aPointList[], int aListSize )
 {
     auto points = std::unique_ptr<GLdouble[]>( new GLdouble[3 * aListSize] );
     GLdouble* target = points.get();
@@ -971,7 +1042,7 @@ void OPENGL_GAL::DrawPolygon( const VECTOR2D aPointList[], int aListSize )
 }
 
 
-void OPENGL_GAL::drawTriangulatedPolyset( const SHAPE_POLY_SET& aPolySet )
+void OPENGL_GAL_BASE::drawTriangulatedPolyset( const SHAPE_POLY_SET& aPolySet )
 {
     currentManager->Shader( SHADER_NONE );
     currentManager->Color( fillColor.r, fillColor.g, fillColor.b, fillColor.a );
@@ -1008,7 +1079,7 @@ void OPENGL_GAL::drawTriangulatedPolyset( const SHAPE_POLY_SET& aPolySet )
 }
 
 
-void OPENGL_GAL::DrawPolygon( const SHAPE_POLY_SET& aPolySet )
+void OPENGL_GAL_BASE::DrawPolygon( const SHAPE_POLY_SET& aPolySet )
 {
     if ( aPolySet.IsTriangulationUpToDate() )
     {
@@ -1025,7 +1096,7 @@ void OPENGL_GAL::DrawPolygon( const SHAPE_POLY_SET& aPolySet )
 
 
 
-void OPENGL_GAL::DrawPolygon( const SHAPE_LINE_CHAIN& aPolygon )
+void OPENGL_GAL_BASE::DrawPolygon( const SHAPE_LINE_CHAIN& aPolygon )
 {
     if( aPolygon.SegmentCount() == 0 )
         return;
@@ -1046,9 +1117,9 @@ void OPENGL_GAL::DrawPolygon( const SHAPE_LINE_CHAIN& aPolygon )
 }
 
 
-void OPENGL_GAL::DrawCurve( const VECTOR2D& aStartPoint, const VECTOR2D& aControlPointA,
-                            const VECTOR2D& aControlPointB, const VECTOR2D& aEndPoint,
-                            double aFilterValue )
+void OPENGL_GAL_BASE::DrawCurve( const VECTOR2D& aStartPoint, const VECTOR2D& aControlPointA,
+                                 const VECTOR2D& aControlPointB, const VECTOR2D& aEndPoint,
+                                 double aFilterValue )
 {
     std::vector<VECTOR2D> output;
     std::vector<VECTOR2D> pointCtrl;
@@ -1120,8 +1191,8 @@ void OPENGL_GAL::DrawBitmap( const BITMAP_BASE& aBitmap )
 }
 
 
-void OPENGL_GAL::BitmapText( const wxString& aText, const VECTOR2D& aPosition,
-                             double aRotationAngle )
+void OPENGL_GAL_BASE::BitmapText( const wxString& aText, const VECTOR2D& aPosition,
+                                  double aRotationAngle )
 {
     wxASSERT_MSG( !IsTextMirrored(), "No support for mirrored text using bitmap fonts." );
 
@@ -1460,36 +1531,207 @@ void OPENGL_GAL::Transform( const MATRIX3x3D& aTransformation )
 }
 
 
-void OPENGL_GAL::Rotate( double aAngle )
+void OPENGL_GAL::SetLayerDepth( double aLayerDepth )
+{
+    // The instances of the previous layer are drawn after its cached vertices, but before
+    // the next layers
+    breakShapeInstances();
+
+    super::SetLayerDepth( aLayerDepth );
+}
+
+
+void OPENGL_GAL_BASE::Rotate( double aAngle )
 {
     currentManager->Rotate( aAngle, 0.0f, 0.0f, 1.0f );
 }
 
 
-void OPENGL_GAL::Translate( const VECTOR2D& aVector )
+void OPENGL_GAL_BASE::Translate( const VECTOR2D& aVector )
 {
     currentManager->Translate( aVector.x, aVector.y, 0.0f );
 }
 
 
-void OPENGL_GAL::Scale( const VECTOR2D& aScale )
+void OPENGL_GAL_BASE::Scale( const VECTOR2D& aScale )
 {
     currentManager->Scale( aScale.x, aScale.y, 0.0f );
 }
 
 
-void OPENGL_GAL::Save()
+void OPENGL_GAL_BASE::Save()
 {
     currentManager->PushMatrix();
 }
 
 
-void OPENGL_GAL::Restore()
+void OPENGL_GAL_BASE::Restore()
 {
     currentManager->PopMatrix();
 }
 
 
+bool OPENGL_GAL_BASE::HasShapeInstance( const SHAPE_INSTANCE_KEY& aKey ) const
+{
+    return m_shapeIndices.count( aKey ) > 0;
+}
+
+
+bool OPENGL_GAL_BASE::BeginShapeInstance( const SHAPE_INSTANCE_KEY& aKey )
+{
+    if( !m_shapeInstancing )
+        return false;
+
+    wxCHECK_MSG( !m_shapeSavedManager, false, wxT( "Shapes can't be nested" ) );
+
+    if( !m_shapeManager )
+        m_shapeManager.reset( new VERTEX_MANAGER( new NONCACHED_CONTAINER ) );
+
+    m_shapeManager->Clear();
+
+    // The shape is drawn around the origin, the depth is given by its instances
+    m_shapeKey = aKey;
+    m_shapeSavedManager = currentManager;
+    m_shapeSavedDepth = layerDepth;
+    currentManager = m_shapeManager.get();
+    layerDepth = 0.0;
+
+    return true;
+}
+
+
+void OPENGL_GAL_BASE::EndShapeInstance()
+{
+    wxCHECK_RET( m_shapeSavedManager, wxT( "No shape is being drawn" ) );
+
+    currentManager = m_shapeSavedManager;
+    layerDepth = m_shapeSavedDepth;
+    m_shapeSavedManager = nullptr;
+
+    addShape( m_shapeKey, m_shapeManager->GetVertices( 0 ), m_shapeManager->GetSize() );
+    m_shapeManager->Clear();
+}
+
+
+bool OPENGL_GAL_BASE::DrawShapeInstance( const SHAPE_INSTANCE_KEY& aKey,
+                                         const VECTOR2D& aPosition, double aRotation,
+                                         const COLOR4D& aColor )
+{
+    auto it = m_shapeIndices.find( aKey );
+
+    if( it == m_shapeIndices.end() )
+        return false;
+
+    SHAPE_INSTANCE instance;
+
+    instance.m_x = aPosition.x;
+    instance.m_y = aPosition.y;
+    instance.m_depth = layerDepth;
+    instance.m_angle = aRotation;
+    instance.m_color[0] = aColor.r * 255.0;
+    instance.m_color[1] = aColor.g * 255.0;
+    instance.m_color[2] = aColor.b * 255.0;
+    instance.m_color[3] = aColor.a * 255.0;
+    instance.m_shape = it->second;
+
+    // An instance drawn as a part of another shape becomes vertices of that shape
+    if( m_shapeSavedManager || !storeShapeInstance( instance ) )
+        expandShapeInstance( instance, m_shapes );
+
+    return true;
+}
+
+
+int OPENGL_GAL_BASE::addShape( const SHAPE_INSTANCE_KEY& aKey, const VERTEX* aVertices,
+                                unsigned int aSize )
+{
+    auto it = m_shapeIndices.find( aKey );
+
+    if( it != m_shapeIndices.end() )
+        return it->second;
+
+    int index = (int) m_shapes.size();
+
+    m_shapes.push_back( { aKey, std::vector<VERTEX>( aVertices, aVertices + aSize ) } );
+    m_shapeIndices[aKey] = index;
+    m_shapesChanged = true;
+
+    return index;
+}
+
+
+void OPENGL_GAL_BASE::clearShapes()
+{
+    m_shapes.clear();
+    m_shapeIndices.clear();
+    m_shapesChanged = true;
+}
+
+
+void OPENGL_GAL_BASE::adoptShapeInstance( const SHAPE_INSTANCE& aInstance,
+                                          const std::vector<INSTANCED_SHAPE>& aShapes )
+{
+    if( !m_shapeInstancing )
+    {
+        expandShapeInstance( aInstance, aShapes );
+        return;
+    }
+
+    const INSTANCED_SHAPE& shape = aShapes[aInstance.m_shape];
+    SHAPE_INSTANCE         instance = aInstance;
+
+    instance.m_shape = addShape( shape.m_key, shape.m_vertices.data(),
+                                 shape.m_vertices.size() );
+
+    if( !storeShapeInstance( instance ) )
+        expandShapeInstance( instance, m_shapes );
+}
+
+
+void OPENGL_GAL_BASE::expandShapeInstance( const SHAPE_INSTANCE& aInstance,
+                                           const std::vector<INSTANCED_SHAPE>& aShapes )
+{
+    const std::vector<VERTEX>& vertices = aShapes[aInstance.m_shape].m_vertices;
+    const glm::mat4&           transform = currentManager->GetTransformation();
+    const GLfloat              colorScale = 1.0f / ( 255.0f * 255.0f );
+    GLfloat                    cosA = cos( aInstance.m_angle );
+    GLfloat                    sinA = sin( aInstance.m_angle );
+
+    if( vertices.empty() )
+        return;
+
+    currentManager->Reserve( vertices.size() );
+
+    // Does what the vertex shader does with the instance attributes
+    for( const VERTEX& v : vertices )
+    {
+        GLfloat params[SHADER_STRIDE] = { v.shader[0], v.shader[1], v.shader[2], v.shader[3] };
+
+        if( params[0] >= SHADER_LINE_A && params[0] <= SHADER_LINE_F )
+        {
+            // The line vectors are in world coordinates
+            glm::vec4 vs( cosA * params[2] - sinA * params[3],
+                          sinA * params[2] + cosA * params[3], 0.0, 0.0 );
+
+            vs = transform * vs;
+            params[2] = vs.x;
+            params[3] = vs.y;
+        }
+
+        currentManager->Color( v.r * aInstance.m_color[0] * colorScale,
+                               v.g * aInstance.m_color[1] * colorScale,
+                               v.b * aInstance.m_color[2] * colorScale,
+                               v.a * aInstance.m_color[3] * colorScale );
+        currentManager->Shader( params[0], params[1], params[2], params[3] );
+        currentManager->Vertex( aInstance.m_x + cosA * v.x - sinA * v.y,
+                                aInstance.m_y + sinA * v.x + cosA * v.y,
+                                v.z + aInstance.m_depth );
+    }
+
+    currentManager->Shader( SHADER_NONE );
+}
+
+
 int OPENGL_GAL::BeginGroup()
 {
     isGrouping = true;
@@ -1497,6 +1739,7 @@ int OPENGL_GAL::BeginGroup()
     std::shared_ptr<VERTEX_ITEM> newItem = std::make_shared<VERTEX_ITEM>( *cachedManager );
     int groupNumber = getNewGroupNumber();
     groups.insert( std::make_pair( groupNumber, newItem ) );
+    m_currentGroup = groupNumber;
 
     return groupNumber;
 }
@@ -1506,6 +1749,7 @@ void OPENGL_GAL::EndGroup()
 {
     cachedManager->FinishItem();
     isGrouping = false;
+    m_currentGroup = -1;
 }
 
 
@@ -1513,6 +1757,14 @@ void OPENGL_GAL::DrawGroup( int aGroupNumber )
 {
     if( groups[aGroupNumber] )
         cachedManager->DrawItem( *groups[aGroupNumber] );
+
+    auto instances = m_groupInstances.find( aGroupNumber );
+
+    if( instances != m_groupInstances.end() )
+    {
+        m_frameInstances.insert( m_frameInstances.end(), instances->second.begin(),
+                                 instances->second.end() );
+    }
 }
 
 
@@ -1520,6 +1772,20 @@ void OPENGL_GAL::ChangeGroupColor( int aGroupNumber, const COLOR4D& aNewColor )
 {
     if( groups[aGroupNumber] )
         cachedManager->ChangeItemColor( *groups[aGroupNumber], aNewColor );
+
+    auto instances = m_groupInstances.find( aGroupNumber );
+
+    if( instances != m_groupInstances.end() )
+    {
+        // The shapes are white, the instance color is the color of the pixels
+        for( SHAPE_INSTANCE& instance : instances->second )
+        {
+            instance.m_color[0] = aNewColor.r * 255.0;
+            instance.m_color[1] = aNewColor.g * 255.0;
+            instance.m_color[2] = aNewColor.b * 255.0;
+            instance.m_color[3] = aNewColor.a * 255.0;
+        }
+    }
 }
 
 
@@ -1527,6 +1793,14 @@ void OPENGL_GAL::ChangeGroupDepth( int aGroupNumber, int aDepth )
 {
     if( groups[aGroupNumber] )
         cachedManager->ChangeItemDepth( *groups[aGroupNumber], aDepth );
+
+    auto instances = m_groupInstances.find( aGroupNumber );
+
+    if( instances != m_groupInstances.end() )
+    {
+        for( SHAPE_INSTANCE& instance : instances->second )
+            instance.m_depth = aDepth;
+    }
 }
 
 
@@ -1534,6 +1808,7 @@ void OPENGL_GAL::DeleteGroup( int aGroupNumber )
 {
     // Frees memory in the container as well
     groups.erase( aGroupNumber );
+    m_groupInstances.erase( aGroupNumber );
 }
 
 
@@ -1542,12 +1817,206 @@ void OPENGL_GAL::ClearCache()
     bitmapCache = std::make_unique<GL_BITMAP_CACHE>( );
 
     groups.clear();
+    m_groupInstances.clear();
+    m_frameInstances.clear();
+    m_frameLayerStart = 0;
+    clearShapes();
 
     if( isInitialized )
         cachedManager->Clear();
 }
 
 
+std::unique_ptr<GAL> OPENGL_GAL::CreateWorkerGal()
+{
+    return std::make_unique<OPENGL_WORKER_GAL>( options, this );
+}
+
+
+int OPENGL_GAL::AdoptGroup( GAL* aWorker, int aGroupNumber )
+{
+    const OPENGL_WORKER_GAL* worker = static_cast<const OPENGL_WORKER_GAL*>( aWorker );
+    const VERTEX*            vertices = nullptr;
+    unsigned int             size = 0;
+
+    if( !worker->GetGroupVertices( aGroupNumber, vertices, size ) )
+        return -1;
+
+    // The vertices are ready to use, they only need to be stored in a single chunk
+    int groupNumber = BeginGroup();
+
+    if( size > 0 )
+        cachedManager->CopyVertices( vertices, size );
+
+    const SHAPE_INSTANCE* instances = nullptr;
+    unsigned int          count = 0;
+    VERTEX_MANAGER*       manager = currentManager;
+
+    worker->GetGroupInstances( aGroupNumber, instances, count );
+    currentManager = cachedManager;
+
+    for( unsigned int ii = 0; ii < count; ++ii )
+        adoptShapeInstance( instances[ii], worker->GetShapes() );
+
+    currentManager = manager;
+    EndGroup();
+
+    return groupNumber;
+}
+
+
+bool OPENGL_GAL::storeShapeInstance( const SHAPE_INSTANCE& aInstance )
+{
+    // Only the cached groups are drawn with instances, and an instance is placed by its
+    // position and rotation alone
+    if( !isGrouping || currentManager != cachedManager
+            || cachedManager->GetTransformation() != glm::mat4( 1.0f ) )
+    {
+        return false;
+    }
+
+    m_groupInstances[m_currentGroup].push_back( aInstance );
+
+    return true;
+}
+
+
+void OPENGL_GAL::breakShapeInstances()
+{
+    size_t begin = m_frameLayerStart;
+    size_t end = m_frameInstances.size();
+
+    if( begin == end )
+        return;
+
+    // The instances of a layer share its depth and its colors, so they are drawn by shape,
+    // with one draw call per shape
+    std::stable_sort( m_frameInstances.begin() + begin, m_frameInstances.begin() + end,
+                      []( const SHAPE_INSTANCE& aFirst, const SHAPE_INSTANCE& aSecond )
+                      {
+                          return aFirst.m_shape < aSecond.m_shape;
+                      } );
+
+    cachedManager->AddDrawBreak( [this, begin, end]()
+                                 {
+                                     drawShapeInstances( begin, end );
+                                 } );
+
+    m_frameLayerStart = end;
+}
+
+
+void OPENGL_GAL::uploadShapeInstances()
+{
+    if( m_frameInstances.empty() )
+        return;
+
+    if( m_shapesChanged )
+    {
+        std::vector<VERTEX> vertices;
+
+        m_shapeOffsets.clear();
+
+        for( const INSTANCED_SHAPE& shape : m_shapes )
+        {
+            m_shapeOffsets.push_back( (GLint) vertices.size() );
+            vertices.insert( vertices.end(), shape.m_vertices.begin(), shape.m_vertices.end() );
+        }
+
+        glBindBuffer( GL_ARRAY_BUFFER, m_shapeBuffer );
+        glBufferData( GL_ARRAY_BUFFER, vertices.size() * VERTEX_SIZE, vertices.data(),
+                      GL_STATIC_DRAW );
+        m_shapesChanged = false;
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER, m_instanceBuffer );
+    glBufferData( GL_ARRAY_BUFFER, m_frameInstances.size() * sizeof( SHAPE_INSTANCE ),
+                  m_frameInstances.data(), GL_STREAM_DRAW );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+#ifdef __WXDEBUG__
+    wxLogTrace( "GAL_PROFILE", wxT( "Shape instances: %d" ), (int) m_frameInstances.size() );
+#endif /* __WXDEBUG__ */
+}
+
+
+void OPENGL_GAL::drawShapeInstances( size_t aBegin, size_t aEnd )
+{
+    if( m_depthTest )
+        glEnable( GL_DEPTH_TEST );
+    else
+        glDisable( GL_DEPTH_TEST );
+
+    // The shapes are stored like the cached vertices...
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_COLOR_ARRAY );
+
+    glBindBuffer( GL_ARRAY_BUFFER, m_shapeBuffer );
+    glVertexPointer( COORD_STRIDE, GL_FLOAT, VERTEX_SIZE, (GLvoid*) COORD_OFFSET );
+    glColorPointer( COLOR_STRIDE, GL_UNSIGNED_BYTE, VERTEX_SIZE, (GLvoid*) COLOR_OFFSET );
+
+    shader->Use();
+    glEnableVertexAttribArray( m_attrShaderParams );
+    glVertexAttribPointer( m_attrShaderParams, SHADER_STRIDE, GL_FLOAT, GL_FALSE, VERTEX_SIZE,
+                           (GLvoid*) SHADER_OFFSET );
+
+    // ...and the instance attributes advance once per instance
+    glBindBuffer( GL_ARRAY_BUFFER, m_instanceBuffer );
+    glEnableVertexAttribArray( m_attrInstance );
+    glEnableVertexAttribArray( m_attrInstanceColor );
+    glVertexAttribDivisorARB( m_attrInstance, 1 );
+    glVertexAttribDivisorARB( m_attrInstanceColor, 1 );
+
+    for( size_t first = aBegin; first < aEnd; )
+    {
+        int    shape = m_frameInstances[first].m_shape;
+        size_t last = first + 1;
+
+        while( last < aEnd && m_frameInstances[last].m_shape == shape )
+            ++last;
+
+        size_t offset = first * sizeof( SHAPE_INSTANCE );
+
+        glVertexAttribPointer( m_attrInstance, 4, GL_FLOAT, GL_FALSE, sizeof( SHAPE_INSTANCE ),
+                               (GLvoid*) ( offset + offsetof( SHAPE_INSTANCE, m_x ) ) );
+        glVertexAttribPointer( m_attrInstanceColor, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                               sizeof( SHAPE_INSTANCE ),
+                               (GLvoid*) ( offset + offsetof( SHAPE_INSTANCE, m_color ) ) );
+        glDrawArraysInstancedARB( GL_TRIANGLES, m_shapeOffsets[shape],
+                                  (GLsizei) m_shapes[shape].m_vertices.size(),
+                                  (GLsizei) ( last - first ) );
+
+        first = last;
+    }
+
+    glVertexAttribDivisorARB( m_attrInstance, 0 );
+    glVertexAttribDivisorARB( m_attrInstanceColor, 0 );
+    glDisableVertexAttribArray( m_attrInstance );
+    glDisableVertexAttribArray( m_attrInstanceColor );
+    glDisableVertexAttribArray( m_attrShaderParams );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    glDisableClientState( GL_COLOR_ARRAY );
+    glDisableClientState( GL_VERTEX_ARRAY );
+
+    shader->Deactivate();
+
+    // The current values of the attributes are undefined after drawing from their arrays
+    resetInstanceAttributes();
+}
+
+
+void OPENGL_GAL::resetInstanceAttributes()
+{
+    if( m_attrInstance < 0 )
+        return;
+
+    // The vertices drawn without instances are not moved, and keep their color
+    glVertexAttrib4f( m_attrInstance, 0.0f, 0.0f, 0.0f, 0.0f );
+    glVertexAttrib4f( m_attrInstanceColor, 1.0f, 1.0f, 1.0f, 1.0f );
+}
+
+
 void OPENGL_GAL::SetTarget( RENDER_TARGET aTarget )
 {
     switch( aTarget )
@@ -1616,7 +2085,8 @@ void OPENGL_GAL::DrawCursor( const VECTOR2D& aCursorPosition )
 }
 
 
-void OPENGL_GAL::drawLineQuad( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
+void OPENGL_GAL_BASE::drawLineQuad( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint,
+                                    bool aReserve )
 {
     /* Helper drawing:                   ____--- v3       ^
      *                           ____---- ...   \          \
@@ -1633,12 +2103,15 @@ void OPENGL_GAL::drawLineQuad( const VECTOR2D& aStartPoint, const VECTOR2D& aEnd
      * dots mark triangles' hypotenuses
      */
 
-    auto v1  = currentManager->GetTransformation() * glm::vec4( aStartPoint.x, aStartPoint.y, 0.0, 0.0 );
-    auto v2  = currentManager->GetTransformation() * glm::vec4( aEndPoint.x, aEndPoint.y, 0.0, 0.0 );
+    // The line vector is transformed as a direction, the difference is taken in double
+    // precision rather than after converting the points
+    auto v = currentManager->GetTransformation()
+             * glm::vec4( aEndPoint.x - aStartPoint.x, aEndPoint.y - aStartPoint.y, 0.0, 0.0 );
 
-    VECTOR2D vs( v2.x - v1.x, v2.y - v1.y );
+    VECTOR2D vs( v.x, v.y );
 
-    currentManager->Reserve( 6 );
+    if( aReserve )
+        currentManager->Reserve( 6 );
 
     // Line width is maintained by the vertex shader
     currentManager->Shader( SHADER_LINE_A, lineWidth, vs.x, vs.y );
@@ -1661,7 +2134,8 @@ void OPENGL_GAL::drawLineQuad( const VECTOR2D& aStartPoint, const VECTOR2D& aEnd
 }
 
 
-void OPENGL_GAL::drawSemiCircle( const VECTOR2D& aCenterPoint, double aRadius, double aAngle )
+void OPENGL_GAL_BASE::drawSemiCircle( const VECTOR2D& aCenterPoint, double aRadius,
+                                      double aAngle )
 {
     if( isFillEnabled )
     {
@@ -1677,8 +2151,8 @@ void OPENGL_GAL::drawSemiCircle( const VECTOR2D& aCenterPoint, double aRadius, d
 }
 
 
-void OPENGL_GAL::drawFilledSemiCircle( const VECTOR2D& aCenterPoint, double aRadius,
-                                       double aAngle )
+void OPENGL_GAL_BASE::drawFilledSemiCircle( const VECTOR2D& aCenterPoint, double aRadius,
+                                            double aAngle )
 {
     Save();
 
@@ -1708,8 +2182,8 @@ void OPENGL_GAL::drawFilledSemiCircle( const VECTOR2D& aCenterPoint, double aRad
 }
 
 
-void OPENGL_GAL::drawStrokedSemiCircle( const VECTOR2D& aCenterPoint, double aRadius,
-                                        double aAngle )
+void OPENGL_GAL_BASE::drawStrokedSemiCircle( const VECTOR2D& aCenterPoint, double aRadius,
+                                             double aAngle )
 {
     double outerRadius = aRadius + ( lineWidth / 2 );
 
@@ -1742,7 +2216,7 @@ void OPENGL_GAL::drawStrokedSemiCircle( const VECTOR2D& aCenterPoint, double aRa
 }
 
 
-void OPENGL_GAL::drawPolygon( GLdouble* aPoints, int aPointCount )
+void OPENGL_GAL_BASE::drawPolygon( GLdouble* aPoints, int aPointCount )
 {
     if( isFillEnabled )
     {
@@ -1778,7 +2252,8 @@ void OPENGL_GAL::drawPolygon( GLdouble* aPoints, int aPointCount )
 }
 
 
-void OPENGL_GAL::drawPolyline( const std::function<VECTOR2D (int)>& aPointGetter, int aPointCount )
+void OPENGL_GAL_BASE::drawPolyline( const std::function<VECTOR2D (int)>& aPointGetter,
+                                    int aPointCount )
 {
     if( aPointCount < 2 )
         return;
@@ -1796,7 +2271,7 @@ void OPENGL_GAL::drawPolyline( const std::function<VECTOR2D (int)>& aPointGetter
 }
 
 
-int OPENGL_GAL::drawBitmapChar( unsigned long aChar )
+int OPENGL_GAL_BASE::drawBitmapChar( unsigned long aChar )
 {
     const float TEX_X = font_image.width;
     const float TEX_Y = font_image.height;
@@ -1872,7 +2347,7 @@ int OPENGL_GAL::drawBitmapChar( unsigned long aChar )
 }
 
 
-void OPENGL_GAL::drawBitmapOverbar( double aLength, double aHeight )
+void OPENGL_GAL_BASE::drawBitmapOverbar( double aLength, double aHeight )
 {
     // To draw an overbar, simply draw an overbar
     const FONT_GLYPH_TYPE* glyph = LookupGlyph( '_' );
@@ -1901,7 +2376,7 @@ void OPENGL_GAL::drawBitmapOverbar( double aLength, double aHeight )
 }
 
 
-std::pair<VECTOR2D, float> OPENGL_GAL::computeBitmapTextSize( const UTF8& aText ) const
+std::pair<VECTOR2D, float> OPENGL_GAL_BASE::computeBitmapTextSize( const UTF8& aText ) const
 {
     VECTOR2D textSize( 0, 0 );
     float commonOffset = std::numeric_limits<float>::max();
@@ -2057,6 +2532,22 @@ void OPENGL_GAL::init()
     nonCachedManager->SetShader( *shader );
     overlayManager->SetShader( *shader );
 
+    m_attrShaderParams = shader->GetAttribute( "attrShaderParams" );
+    m_attrInstance = shader->GetAttribute( "attrInstance" );
+    m_attrInstanceColor = shader->GetAttribute( "attrInstanceColor" );
+
+    // Instanced draw calls are not part of OpenGL 2.1, without them the shapes of the pads
+    // and vias are drawn for every pad and via
+    m_shapeInstancing = ADVANCED_CFG::GetCfg().m_shapeInstancing
+                        && GLEW_ARB_draw_instanced && GLEW_ARB_instanced_arrays
+                        && m_attrInstance >= 0 && m_attrInstanceColor >= 0;
+
+    if( m_shapeInstancing )
+    {
+        glGenBuffers( 1, &m_shapeBuffer );
+        glGenBuffers( 1, &m_instanceBuffer );
+    }
+
     isInitialized = true;
 }
 
@@ -2065,7 +2556,7 @@ void OPENGL_GAL::init()
 void CALLBACK VertexCallback( GLvoid* aVertexPtr, void* aData )
 {
     GLdouble* vertex = static_cast<GLdouble*>( aVertexPtr );
-    OPENGL_GAL::TessParams* param = static_cast<OPENGL_GAL::TessParams*>( aData );
+    OPENGL_GAL_BASE::TessParams* param = static_cast<OPENGL_GAL_BASE::TessParams*>( aData );
     VERTEX_MANAGER* vboManager = param->vboManager;
 
     assert( vboManager );
@@ -2078,7 +2569,7 @@ void CALLBACK CombineCallback( GLdouble coords[3],
                                GLfloat weight[4], GLdouble** dataOut, void* aData )
 {
     GLdouble* vertex = new GLdouble[3];
-    OPENGL_GAL::TessParams* param = static_cast<OPENGL_GAL::TessParams*>( aData );
+    OPENGL_GAL_BASE::TessParams* param = static_cast<OPENGL_GAL_BASE::TessParams*>( aData );
 
     // Save the pointer so we can delete it later
     param->intersectPoints.emplace_back( vertex );
@@ -2112,6 +2603,7 @@ static void InitTesselatorCallbacks( GLUtesselator* aTesselator )
 
 void OPENGL_GAL::EnableDepthTest( bool aEnabled )
 {
+    m_depthTest = aEnabled;
     cachedManager->EnableDepthTest( aEnabled );
     nonCachedManager->EnableDepthTest( aEnabled );
     overlayManager->EnableDepthTest( aEnabled );
@@ -2134,3 +2626,153 @@ void OPENGL_GAL::ComputeWorldScreenMatrix()
     GAL::ComputeWorldScreenMatrix();
 }
 
+
+
+///< Initial size of the container of a worker GAL (expressed in vertices), it grows as needed
+static const unsigned int WORKER_CONTAINER_SIZE = 65536;
+
+
+OPENGL_WORKER_GAL::OPENGL_WORKER_GAL( GAL_DISPLAY_OPTIONS& aDisplayOptions,
+                                      const GAL* aParent ) :
+    OPENGL_GAL_BASE( aDisplayOptions ),
+    m_manager( new NONCACHED_CONTAINER( WORKER_CONTAINER_SIZE ) ),
+    m_isGrouping( false )
+{
+    currentManager = &m_manager;
+
+    if( aParent )
+    {
+        copyViewSettings( *aParent );
+        m_shapeInstancing = aParent->IsShapeInstancingEnabled();
+    }
+    else
+    {
+        m_shapeInstancing = ADVANCED_CFG::GetCfg().m_shapeInstancing;
+    }
+}
+
+
+OPENGL_WORKER_GAL::~OPENGL_WORKER_GAL()
+{
+}
+
+
+void OPENGL_WORKER_GAL::DrawBitmap( const BITMAP_BASE& aBitmap )
+{
+    // Bitmaps need textures, so the group has to be made by the OPENGL_GAL
+    if( m_isGrouping )
+        m_groups.back().m_complete = false;
+}
+
+
+void OPENGL_WORKER_GAL::Transform( const MATRIX3x3D& aTransformation )
+{
+    // OPENGL_GAL applies the transformation to the OpenGL matrix stack
+    if( m_isGrouping )
+        m_groups.back().m_complete = false;
+}
+
+
+int OPENGL_WORKER_GAL::BeginGroup()
+{
+    m_groups.push_back( { m_manager.GetSize(), 0, (unsigned int) m_instances.size(), 0, true } );
+    m_isGrouping = true;
+
+    return (int) m_groups.size() - 1;
+}
+
+
+void OPENGL_WORKER_GAL::EndGroup()
+{
+    GROUP& group = m_groups.back();
+
+    group.m_size = m_manager.GetSize() - group.m_offset;
+    group.m_instanceCount = m_instances.size() - group.m_firstInstance;
+    m_isGrouping = false;
+}
+
+
+void OPENGL_WORKER_GAL::ClearCache()
+{
+    m_groups.clear();
+    m_instances.clear();
+    m_manager.Clear();
+    clearShapes();
+}
+
+
+std::unique_ptr<GAL> OPENGL_WORKER_GAL::CreateWorkerGal()
+{
+    return std::make_unique<OPENGL_WORKER_GAL>( options, this );
+}
+
+
+int OPENGL_WORKER_GAL::AdoptGroup( GAL* aWorker, int aGroupNumber )
+{
+    const OPENGL_WORKER_GAL* worker = static_cast<const OPENGL_WORKER_GAL*>( aWorker );
+    const VERTEX*            vertices = nullptr;
+    unsigned int             size = 0;
+
+    if( !worker->GetGroupVertices( aGroupNumber, vertices, size ) )
+        return -1;
+
+    int groupNumber = BeginGroup();
+
+    if( size > 0 )
+        m_manager.CopyVertices( vertices, size );
+
+    const SHAPE_INSTANCE* instances = nullptr;
+    unsigned int          count = 0;
+
+    worker->GetGroupInstances( aGroupNumber, instances, count );
+
+    for( unsigned int ii = 0; ii < count; ++ii )
+        adoptShapeInstance( instances[ii], worker->GetShapes() );
+
+    EndGroup();
+
+    return groupNumber;
+}
+
+
+bool OPENGL_WORKER_GAL::GetGroupVertices( int aGroupNumber, const VERTEX*& aVertices,
+                                          unsigned int& aSize ) const
+{
+    wxCHECK( aGroupNumber >= 0 && aGroupNumber < (int) m_groups.size(), false );
+
+    const GROUP& group = m_groups[aGroupNumber];
+
+    aVertices = m_manager.GetVertices( group.m_offset );
+    aSize = group.m_size;
+
+    return group.m_complete;
+}
+
+
+void OPENGL_WORKER_GAL::GetGroupInstances( int aGroupNumber, const SHAPE_INSTANCE*& aInstances,
+                                           unsigned int& aSize ) const
+{
+    aInstances = nullptr;
+    aSize = 0;
+
+    wxCHECK( aGroupNumber >= 0 && aGroupNumber < (int) m_groups.size(), /* void */ );
+
+    const GROUP& group = m_groups[aGroupNumber];
+
+    if( group.m_instanceCount > 0 )
+    {
+        aInstances = &m_instances[group.m_firstInstance];
+        aSize = group.m_instanceCount;
+    }
+}
+
+
+bool OPENGL_WORKER_GAL::storeShapeInstance( const SHAPE_INSTANCE& aInstance )
+{
+    if( !m_isGrouping || m_manager.GetTransformation() != glm::mat4( 1.0f ) )
+        return false;
+
+    m_instances.push_back( aInstance );
+
+    return true;
+}
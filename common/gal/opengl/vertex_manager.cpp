@@ -35,12 +35,20 @@
 #include <gal/opengl/vertex_item.h>
 #include <confirm.h>
 
+#include <algorithm>
+
 using namespace KIGFX;
 
 VERTEX_MANAGER::VERTEX_MANAGER( bool aCached ) :
+    VERTEX_MANAGER( VERTEX_CONTAINER::MakeContainer( aCached ) )
+{
+}
+
+
+VERTEX_MANAGER::VERTEX_MANAGER( VERTEX_CONTAINER* aContainer ) :
     m_noTransform( true ), m_transform( 1.0f ), m_reserved( NULL ), m_reservedSpace( 0 )
 {
-    m_container.reset( VERTEX_CONTAINER::MakeContainer( aCached ) );
+    m_container.reset( aContainer );
     m_gpu.reset( GPU_MANAGER::MakeManager( m_container.get() ) );
 
     // There is no shader used by default
@@ -57,6 +65,14 @@ void VERTEX_MANAGER::Map()
 
 void VERTEX_MANAGER::Unmap()
 {
+    if( m_container->IsCached() )
+    {
+        CACHED_CONTAINER* cached = static_cast<CACHED_CONTAINER*>( m_container.get() );
+
+        if( cached->IsMapped() )
+            cached->Compact();
+    }
+
     m_container->Unmap();
 }
 
@@ -154,6 +170,30 @@ bool VERTEX_MANAGER::Vertices( const VERTEX aVertices[], unsigned int aSize )
 }
 
 
+bool VERTEX_MANAGER::CopyVertices( const VERTEX aVertices[], unsigned int aSize )
+{
+    // flag to avoid hanging by calling DisplayError too many times:
+    static bool show_err = true;
+
+    VERTEX* newVertex = m_container->Allocate( aSize );
+
+    if( newVertex == NULL )
+    {
+        if( show_err )
+        {
+            DisplayError( NULL, wxT( "VERTEX_MANAGER::CopyVertices: Vertex allocation error" ) );
+            show_err = false;
+        }
+
+        return false;
+    }
+
+    std::copy( aVertices, aVertices + aSize, newVertex );
+
+    return true;
+}
+
+
 void VERTEX_MANAGER::SetItem( VERTEX_ITEM& aItem ) const
 {
     m_container->SetItem( &aItem );
@@ -218,6 +258,27 @@ VERTEX* VERTEX_MANAGER::GetVertices( const VERTEX_ITEM& aItem ) const
 }
 
 
+VERTEX* VERTEX_MANAGER::GetVertices( unsigned int aOffset ) const
+{
+    return m_container->GetVertices( aOffset );
+}
+
+
+unsigned int VERTEX_MANAGER::GetSize() const
+{
+    return m_container->GetSize();
+}
+
+
+VERTEX_MEMORY_STATS VERTEX_MANAGER::GetMemoryStats() const
+{
+    if( !m_container->IsCached() )
+        return VERTEX_MEMORY_STATS();
+
+    return static_cast<CACHED_CONTAINER*>( m_container.get() )->GetStats();
+}
+
+
 void VERTEX_MANAGER::SetShader( SHADER& aShader ) const
 {
     m_gpu->SetShader( aShader );
@@ -251,6 +312,14 @@ void VERTEX_MANAGER::EndDrawing() const
 }
 
 
+void VERTEX_MANAGER::AddDrawBreak( std::function<void()> aHandler ) const
+{
+    wxCHECK_RET( m_container->IsCached(), wxT( "Only the cached items can be drawn in parts" ) );
+
+    static_cast<GPU_CACHED_MANAGER*>( m_gpu.get() )->AddDrawBreak( std::move( aHandler ) );
+}
+
+
 void VERTEX_MANAGER::putVertex( VERTEX& aTarget, GLfloat aX, GLfloat aY, GLfloat aZ ) const
 {
     // Modify the vertex according to the currently used transformations
@@ -32,6 +32,9 @@
 #include <wx/string.h>
 #include <gr_text.h>
 
+#include <functional>
+#include <mutex>
+
 
 using namespace KIGFX;
 
@@ -40,15 +43,55 @@ const double STROKE_FONT::OVERBAR_POSITION_FACTOR = 1.40;
 const double STROKE_FONT::BOLD_FACTOR = 1.3;
 const double STROKE_FONT::STROKE_FONT_SCALE = 1.0 / 21.0;
 const double STROKE_FONT::ITALIC_TILT = 1.0 / 8;
+const size_t STROKE_FONT::LAYOUT_CACHE_SIZE = 4096;
+
+STROKE_FONT::LAYOUT_CACHE STROKE_FONT::s_layoutCache;
+std::shared_timed_mutex   STROKE_FONT::s_layoutCacheMutex;
+std::atomic<uint64_t>     STROKE_FONT::s_layoutClock( 0 );
 
 
 GLYPH_LIST*         g_newStrokeFontGlyphs = nullptr;     ///< Glyph list
 std::vector<BOX2D>* g_newStrokeFontGlyphBoundingBoxes;   ///< Bounding boxes of the glyphs
+STROKE_GLYPHS*      g_newStrokeFontStrokeGlyphs;         ///< Strokes of the glyphs
+
+static bool         s_layoutCacheEnabled = true;
 
 
 STROKE_FONT::STROKE_FONT( GAL* aGal ) :
-    m_gal( aGal ), m_glyphs( nullptr ), m_glyphBoundingBoxes( nullptr )
+    m_gal( aGal ), m_glyphs( nullptr ), m_glyphBoundingBoxes( nullptr ),
+    m_strokeGlyphs( nullptr )
+{
+}
+
+
+void STROKE_FONT::SetLayoutCacheEnabled( bool aEnabled )
 {
+    s_layoutCacheEnabled = aEnabled;
+}
+
+
+bool STROKE_FONT::IsLayoutCacheEnabled()
+{
+    return s_layoutCacheEnabled;
+}
+
+
+size_t STROKE_FONT::TEXT_LAYOUT_KEY_HASH::operator()( const TEXT_LAYOUT_KEY& aKey ) const
+{
+    size_t seed = std::hash<std::string>()( aKey.m_text );
+
+    auto combine = [&]( size_t aHash )
+    {
+        seed ^= aHash + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+    };
+
+    combine( std::hash<double>()( aKey.m_glyphSize.x ) );
+    combine( std::hash<double>()( aKey.m_glyphSize.y ) );
+    combine( std::hash<double>()( aKey.m_lineWidth ) );
+    combine( ( aKey.m_italic ? 1 : 0 ) | ( aKey.m_mirrored ? 2 : 0 )
+             | ( aKey.m_markupFlags << 2 ) );
+
+    return seed;
 }
 
 
@@ -58,6 +101,7 @@ bool STROKE_FONT::LoadNewStrokeFont( const char* const aNewStrokeFont[], int aNe
     {
         m_glyphs = g_newStrokeFontGlyphs;
         m_glyphBoundingBoxes = g_newStrokeFontGlyphBoundingBoxes;
+        m_strokeGlyphs = g_newStrokeFontStrokeGlyphs;
         return true;
     }
 
@@ -152,8 +196,29 @@ bool STROKE_FONT::LoadNewStrokeFont( const char* const aNewStrokeFont[], int aNe
         g_newStrokeFontGlyphs->push_back( glyph );
     }
 
+    // The same strokes, flattened
+    g_newStrokeFontStrokeGlyphs = new STROKE_GLYPHS;
+
+    STROKE_GLYPHS& strokeGlyphs = *g_newStrokeFontStrokeGlyphs;
+
+    for( const GLYPH* glyph : *g_newStrokeFontGlyphs )
+    {
+        strokeGlyphs.m_glyphStarts.push_back( strokeGlyphs.m_strokeStarts.size() );
+
+        for( const std::vector<VECTOR2D>* pointList : *glyph )
+        {
+            strokeGlyphs.m_strokeStarts.push_back( strokeGlyphs.m_points.size() );
+            strokeGlyphs.m_points.insert( strokeGlyphs.m_points.end(), pointList->begin(),
+                                          pointList->end() );
+        }
+    }
+
+    strokeGlyphs.m_glyphStarts.push_back( strokeGlyphs.m_strokeStarts.size() );
+    strokeGlyphs.m_strokeStarts.push_back( strokeGlyphs.m_points.size() );
+
     m_glyphs = g_newStrokeFontGlyphs;
     m_glyphBoundingBoxes = g_newStrokeFontGlyphBoundingBoxes;
+    m_strokeGlyphs = g_newStrokeFontStrokeGlyphs;
     return true;
 }
 
@@ -268,16 +333,10 @@ void STROKE_FONT::Draw( const UTF8& aText, const VECTOR2D& aPosition, double aRo
 
 void STROKE_FONT::drawSingleLineText( const UTF8& aText, int markupFlags )
 {
-    double      xOffset;
-    double      yOffset;
-    VECTOR2D    baseGlyphSize( m_gal->GetGlyphSize() );
-    double      overbar_italic_comp = computeOverbarVerticalPosition() * ITALIC_TILT;
-
-    if( m_gal->IsTextMirrored() )
-        overbar_italic_comp = -overbar_italic_comp;
+    const TEXT_LAYOUT& layout = getLayout( aText, markupFlags );
 
     // Compute the text size
-    VECTOR2D textSize = computeTextLineSize( aText, markupFlags );
+    const VECTOR2D& textSize = layout.m_size;
     double half_thickness = m_gal->GetLineWidth()/2;
 
     // Context needs to be saved before any transformations
@@ -311,6 +370,112 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText, int markupFlags )
         break;
     }
 
+    for( size_t ii = 0; ii + 1 < layout.m_overbars.size(); ii += 2 )
+        m_gal->DrawLine( layout.m_overbars[ii], layout.m_overbars[ii + 1] );
+
+    // All the strokes at once
+    m_gal->DrawPolylines( layout.m_points, layout.m_starts );
+
+    m_gal->Restore();
+}
+
+
+const STROKE_FONT::TEXT_LAYOUT& STROKE_FONT::getLayout( const UTF8& aText, int aMarkupFlags )
+{
+    if( !s_layoutCacheEnabled )
+    {
+        layoutSingleLineText( aText, aMarkupFlags, m_layout );
+        return m_layout;
+    }
+
+    TEXT_LAYOUT_KEY key;
+
+    key.m_text = aText;
+    key.m_glyphSize = m_gal->GetGlyphSize();
+    key.m_lineWidth = m_gal->GetLineWidth();
+    key.m_italic = m_gal->IsFontItalic();
+    key.m_mirrored = m_gal->IsTextMirrored();
+    key.m_markupFlags = aMarkupFlags;
+
+    uint64_t now = ++s_layoutClock;
+
+    {
+        std::shared_lock<std::shared_timed_mutex> lock( s_layoutCacheMutex );
+
+        auto it = s_layoutCache.find( key );
+
+        if( it != s_layoutCache.end() )
+        {
+            it->second.m_lastUse.store( now, std::memory_order_relaxed );
+            m_cachedLayout = it->second.m_layout;
+            return *m_cachedLayout;
+        }
+    }
+
+    // Laid out without the lock, another thread may lay out the same text meanwhile
+    std::shared_ptr<TEXT_LAYOUT> layout = std::make_shared<TEXT_LAYOUT>();
+    layoutSingleLineText( aText, aMarkupFlags, *layout );
+
+    std::unique_lock<std::shared_timed_mutex> lock( s_layoutCacheMutex );
+
+    if( s_layoutCache.size() >= LAYOUT_CACHE_SIZE && !s_layoutCache.count( key ) )
+        evictLayouts();
+
+    CACHED_LAYOUT& cached = s_layoutCache[key];
+
+    if( !cached.m_layout )
+        cached.m_layout = std::move( layout );
+
+    cached.m_lastUse.store( now, std::memory_order_relaxed );
+    m_cachedLayout = cached.m_layout;
+
+    return *m_cachedLayout;
+}
+
+
+void STROKE_FONT::evictLayouts()
+{
+    std::vector<uint64_t> uses;
+
+    uses.reserve( s_layoutCache.size() );
+
+    for( const auto& entry : s_layoutCache )
+        uses.push_back( entry.second.m_lastUse.load( std::memory_order_relaxed ) );
+
+    // Every lookup gets its own clock value, so this keeps the most recently used half
+    auto middle = uses.begin() + uses.size() / 2;
+    std::nth_element( uses.begin(), middle, uses.end() );
+
+    for( auto it = s_layoutCache.begin(); it != s_layoutCache.end(); )
+    {
+        if( it->second.m_lastUse.load( std::memory_order_relaxed ) < *middle )
+            it = s_layoutCache.erase( it );
+        else
+            ++it;
+    }
+}
+
+
+void STROKE_FONT::layoutSingleLineText( const UTF8& aText, int markupFlags,
+                                        TEXT_LAYOUT& aLayout ) const
+{
+    double      xOffset;
+    double      yOffset;
+    VECTOR2D    baseGlyphSize( m_gal->GetGlyphSize() );
+    double      overbar_italic_comp = computeOverbarVerticalPosition() * ITALIC_TILT;
+
+    if( m_gal->IsTextMirrored() )
+        overbar_italic_comp = -overbar_italic_comp;
+
+    aLayout.m_points.clear();
+    aLayout.m_starts.clear();
+    aLayout.m_overbars.clear();
+
+    // Compute the text size
+    VECTOR2D textSize = computeTextLineSize( aText, markupFlags );
+
+    aLayout.m_size = textSize;
+
     if( m_gal->IsTextMirrored() )
     {
         // In case of mirrored text invert the X scale of points and their X direction
@@ -330,6 +495,8 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText, int markupFlags )
     bool     last_had_overbar = false;
     bool     in_overbar = false;
     VECTOR2D glyphSize = baseGlyphSize;
+    bool     italic = m_gal->IsFontItalic();
+    double   italic_tilt = m_gal->IsTextMirrored() ? ITALIC_TILT : -ITALIC_TILT;
 
     yOffset = 0;
 
@@ -427,7 +594,6 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText, int markupFlags )
             dd = substitute - ' ';
         }
 
-        const GLYPH* glyph = m_glyphs->at( dd );
         const BOX2D& bbox  = m_glyphBoundingBoxes->at( dd );
 
         if( in_overbar )
@@ -439,50 +605,44 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText, int markupFlags )
 
             if( !last_had_overbar )
             {
-                if( m_gal->IsFontItalic() )
+                if( italic )
                     overbar_start_x += overbar_italic_comp;
 
                 last_had_overbar = true;
             }
 
-            VECTOR2D startOverbar( overbar_start_x, overbar_start_y );
-            VECTOR2D endOverbar( overbar_end_x, overbar_end_y );
-
-            m_gal->DrawLine( startOverbar, endOverbar );
+            aLayout.m_overbars.emplace_back( overbar_start_x, overbar_start_y );
+            aLayout.m_overbars.emplace_back( overbar_end_x, overbar_end_y );
         }
         else
         {
             last_had_overbar = false;
         }
 
-        for( const std::vector<VECTOR2D>* ptList : *glyph )
+        const STROKE_GLYPHS& glyphs = *m_strokeGlyphs;
+
+        for( unsigned int stroke = glyphs.m_glyphStarts[dd];
+             stroke < glyphs.m_glyphStarts[dd + 1]; ++stroke )
         {
-            std::deque<VECTOR2D> ptListScaled;
+            aLayout.m_starts.push_back( aLayout.m_points.size() );
 
-            for( const VECTOR2D& pt : *ptList )
+            for( unsigned int ii = glyphs.m_strokeStarts[stroke];
+                 ii < glyphs.m_strokeStarts[stroke + 1]; ++ii )
             {
+                const VECTOR2D& pt = glyphs.m_points[ii];
                 VECTOR2D scaledPt( pt.x * glyphSize.x + xOffset, pt.y * glyphSize.y + yOffset );
 
-                if( m_gal->IsFontItalic() )
-                {
-                    // FIXME should be done other way - referring to the lowest Y value of point
-                    // because now italic fonts are translated a bit
-                    if( m_gal->IsTextMirrored() )
-                        scaledPt.x += scaledPt.y * STROKE_FONT::ITALIC_TILT;
-                    else
-                        scaledPt.x -= scaledPt.y * STROKE_FONT::ITALIC_TILT;
-                }
+                // FIXME should be done other way - referring to the lowest Y value of point
+                // because now italic fonts are translated a bit
+                if( italic )
+                    scaledPt.x += scaledPt.y * italic_tilt;
 
-                ptListScaled.push_back( scaledPt );
+                aLayout.m_points.push_back( scaledPt );
             }
-
-            m_gal->DrawPolyline( ptListScaled );
         }
 
         xOffset += glyphSize.x * bbox.GetEnd().x;
     }
-
-    m_gal->Restore();
 }
 
 
@@ -337,7 +337,7 @@ void LIB_TABLE::Load( const wxString& aFileName )
     // It's OK if footprint library tables are missing.
     if( wxFileName::IsFileReadable( aFileName ) )
     {
-        FILE_LINE_READER    reader( aFileName );
+        WHOLE_FILE_LINE_READER reader( aFileName );
         LIB_TABLE_LEXER     lexer( &reader );
 
         Parse( &lexer );
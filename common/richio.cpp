@@ -28,6 +28,12 @@
 
 #include <richio.h>
 
+#ifdef __WINDOWS__
+#include <windows.h>
+#endif
+
+#include <wx/ffile.h>
+
 
 // Fall back to getc() when getc_unlocked() is not available on the target platform.
 #if !defined( HAVE_FGETC_NOLOCK )
@@ -225,20 +231,158 @@ char* FILE_LINE_READER::ReadLine()
 }
 
 
-STRING_LINE_READER::STRING_LINE_READER( const std::string& aString, const wxString& aSource ):
+WHOLE_FILE_LINE_READER::WHOLE_FILE_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber, unsigned aMaxLineLength ) :
+    LINE_READER( aMaxLineLength ),
+    m_data( "" ), m_size( 0 ), m_ndx( 0 ), m_view( NULL ), m_mapping( NULL )
+{
+    wxString msg = wxString::Format(
+        _( "Unable to open filename \"%s\" for reading" ), aFileName.GetData() );
+
+#ifdef __WINDOWS__
+    // Windows refuses to truncate a mapped file, so the mapping cannot lose pages under us
+    HANDLE file = CreateFileW( aFileName.wc_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    LARGE_INTEGER size;
+
+    if( file == INVALID_HANDLE_VALUE )
+        THROW_IO_ERROR( msg );
+
+    if( GetFileSizeEx( file, &size ) && size.QuadPart > 0 )
+    {
+        HANDLE mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+
+        if( mapping )
+        {
+            const void* view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+
+            if( view )
+            {
+                m_data    = static_cast<const char*>( view );
+                m_size    = (size_t) size.QuadPart;
+                m_mapping = mapping;
+            }
+            else
+            {
+                CloseHandle( mapping );
+            }
+        }
+    }
+
+    CloseHandle( file );
+#endif
+
+    // Elsewhere another program truncating a mapped file makes reading its lost pages raise
+    // SIGBUS, so the file is read whole instead; so are files Windows cannot map
+    if( !m_mapping )
+    {
+        wxFFile file( aFileName, wxT( "rb" ) );
+
+        if( !file.IsOpened() )
+            THROW_IO_ERROR( msg );
+
+        wxFileOffset length = file.Length();
+
+        if( length > 0 )
+        {
+            m_fallback.resize( (size_t) length );
+            m_fallback.resize( file.Read( &m_fallback[0], m_fallback.size() ) );
+        }
+
+        m_data = m_fallback.c_str();
+        m_size = m_fallback.size();
+    }
+
+    m_source  = aFileName;
+    m_lineNum = aStartingLineNumber;
+}
+
+
+WHOLE_FILE_LINE_READER::~WHOLE_FILE_LINE_READER()
+{
+    if( !m_mapping )
+        return;
+
+#ifdef __WINDOWS__
+    UnmapViewOfFile( m_data );
+    CloseHandle( (HANDLE) m_mapping );
+#endif
+}
+
+
+const char* WHOLE_FILE_LINE_READER::ReadLineInPlace( unsigned* aLength )
+{
+    const char* line = m_data + m_ndx;
+    size_t      left = m_size - m_ndx;
+    const char* nl = left ? (const char*) memchr( line, '\n', left ) : NULL;
+    size_t      length = nl ? nl - line + 1 : left;     // include the newline, so +1
+
+    if( length >= m_maxLineLength )
+        THROW_IO_ERROR( _( "Maximum line length exceeded" ) );
+
+    m_ndx   += length;
+    m_length = (unsigned) length;
+    m_view   = line;
+
+    // m_lineNum is incremented even if there was no line read, because this
+    // leads to better error reporting when we hit an end of file.
+    ++m_lineNum;
+
+    *aLength = m_length;
+    return line;
+}
+
+
+char* WHOLE_FILE_LINE_READER::FetchLine()
+{
+    if( m_view )
+    {
+        unsigned length = m_length;
+
+        if( length + 1 > m_capacity )   // +1 for terminating nul
+        {
+            m_length = 0;               // nothing worth keeping in the old buffer
+            expandCapacity( length + 1 );
+            m_length = length;
+        }
+
+        memcpy( m_line, m_view, m_length );
+        m_line[m_length] = 0;
+        m_view = NULL;
+    }
+
+    return m_line;
+}
+
+
+char* WHOLE_FILE_LINE_READER::ReadLine()
+{
+    unsigned length;
+
+    ReadLineInPlace( &length );
+    FetchLine();
+
+    return length ? m_line : NULL;
+}
+
+
+STRING_LINE_READER::STRING_LINE_READER( const std::string& aString, const wxString& aSource,
+                                        unsigned aStartingLineNumber ):
     LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
-    m_lines( aString ), m_ndx( 0 )
+    m_lines( aString ), m_ndx( 0 ), m_inPlace( false )
 {
     // Clipboard text should be nice and _use multiple lines_ so that
     // we can report _line number_ oriented error messages when parsing.
-    m_source = aSource;
+    m_source  = aSource;
+    m_lineNum = aStartingLineNumber;
 }
 
 
 STRING_LINE_READER::STRING_LINE_READER( const STRING_LINE_READER& aStartingPoint ):
     LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
     m_lines( aStartingPoint.m_lines ),
-    m_ndx( aStartingPoint.m_ndx )
+    m_ndx( aStartingPoint.m_ndx ),
+    m_inPlace( false )
 {
     // since we are keeping the same "source" name, for error reporting purposes
     // we need to have the same notion of line number and offset.
@@ -273,11 +417,56 @@ char* STRING_LINE_READER::ReadLine()
 
     ++m_lineNum;      // this gets incremented even if no bytes were read
     m_line[m_length] = 0;
+    m_inPlace = false;
 
     return m_length ? m_line : NULL;
 }
 
 
+const char* STRING_LINE_READER::ReadLineInPlace( unsigned* aLength )
+{
+    size_t  nlOffset = m_lines.find( '\n', m_ndx );
+    size_t  begin = m_ndx;
+
+    if( nlOffset == std::string::npos )
+        m_length = m_lines.length() - m_ndx;
+    else
+        m_length = nlOffset - m_ndx + 1;     // include the newline, so +1
+
+    if( m_length >= m_maxLineLength )
+        THROW_IO_ERROR( _("Line length exceeded") );
+
+    m_ndx += m_length;
+    ++m_lineNum;      // this gets incremented even if no bytes were read
+    m_inPlace = true;
+
+    *aLength = m_length;
+    return m_lines.c_str() + begin;
+}
+
+
+char* STRING_LINE_READER::FetchLine()
+{
+    if( m_inPlace )
+    {
+        unsigned length = m_length;
+
+        if( length + 1 > m_capacity )   // +1 for terminating nul
+        {
+            m_length = 0;               // nothing worth keeping in the old buffer
+            expandCapacity( length + 1 );
+            m_length = length;
+        }
+
+        memcpy( m_line, m_lines.c_str() + m_ndx - m_length, m_length );
+        m_line[m_length] = 0;
+        m_inPlace = false;
+    }
+
+    return m_line;
+}
+
+
 INPUTSTREAM_LINE_READER::INPUTSTREAM_LINE_READER( wxInputStream* aStream, const wxString& aSource ) :
     LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
     m_stream( aStream )
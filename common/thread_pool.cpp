@@ -0,0 +1,323 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <thread_pool.h>
+
+#include <advanced_config.h>
+#include <widgets/progress_reporter.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <wx/thread.h>
+
+
+// The pool and worker index of the calling thread; null for threads outside any pool.
+static thread_local const THREAD_POOL* t_pool = nullptr;
+static thread_local size_t             t_workerIndex = 0;
+
+
+THREAD_POOL::THREAD_POOL( size_t aThreadCount ) :
+        m_queued( 0 ),
+        m_nextVictim( 0 ),
+        m_stop( false )
+{
+    if( aThreadCount == 0 )
+        aThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+
+    for( size_t ii = 0; ii < aThreadCount; ++ii )
+        m_workers.push_back( std::make_unique<WORKER>() );
+
+    // Workers only start once every deque exists, as they steal from each other
+    for( size_t ii = 0; ii < aThreadCount; ++ii )
+        m_workers[ii]->m_thread = std::thread( &THREAD_POOL::workerLoop, this, ii );
+}
+
+
+THREAD_POOL::~THREAD_POOL()
+{
+    {
+        std::lock_guard<std::mutex> guard( m_sleepLock );
+        m_stop.store( true );
+    }
+
+    m_wakeUp.notify_all();
+
+    for( auto& worker : m_workers )
+    {
+        if( worker->m_thread.joinable() )
+            worker->m_thread.join();
+    }
+}
+
+
+THREAD_POOL& THREAD_POOL::Get()
+{
+    static THREAD_POOL instance( ADVANCED_CFG::GetCfg().m_maxWorkerThreads );
+    return instance;
+}
+
+
+bool THREAD_POOL::IsWorkerThread() const
+{
+    return t_pool == this;
+}
+
+
+void THREAD_POOL::Submit( TASK aTask )
+{
+    size_t target;
+
+    if( IsWorkerThread() )
+        target = t_workerIndex;
+    else
+        target = m_nextVictim.fetch_add( 1 ) % m_workers.size();
+
+    // Counted before it is visible so that the count never underflows when it is popped
+    m_queued.fetch_add( 1 );
+
+    {
+        std::lock_guard<std::mutex> guard( m_workers[target]->m_lock );
+        m_workers[target]->m_tasks.push_back( std::move( aTask ) );
+    }
+
+    // Taking the lock orders the increment above with a worker checking the wait predicate
+    {
+        std::lock_guard<std::mutex> guard( m_sleepLock );
+    }
+
+    m_wakeUp.notify_one();
+}
+
+
+bool THREAD_POOL::popTask( size_t aIndex, TASK& aTask )
+{
+    WORKER& worker = *m_workers[aIndex];
+    std::lock_guard<std::mutex> guard( worker.m_lock );
+
+    if( worker.m_tasks.empty() )
+        return false;
+
+    aTask = std::move( worker.m_tasks.back() );
+    worker.m_tasks.pop_back();
+    m_queued.fetch_sub( 1 );
+    return true;
+}
+
+
+bool THREAD_POOL::stealTask( size_t aThief, TASK& aTask )
+{
+    size_t count = m_workers.size();
+    size_t start = ( aThief < count ) ? aThief + 1 : m_nextVictim.load();
+
+    for( size_t ii = 0; ii < count; ++ii )
+    {
+        size_t victimIndex = ( start + ii ) % count;
+
+        if( victimIndex == aThief )
+            continue;
+
+        WORKER& victim = *m_workers[victimIndex];
+        std::lock_guard<std::mutex> guard( victim.m_lock );
+
+        if( victim.m_tasks.empty() )
+            continue;
+
+        aTask = std::move( victim.m_tasks.front() );
+        victim.m_tasks.pop_front();
+        m_queued.fetch_sub( 1 );
+        return true;
+    }
+
+    return false;
+}
+
+
+bool THREAD_POOL::RunPendingTask()
+{
+    TASK task;
+
+    if( IsWorkerThread() )
+    {
+        if( !popTask( t_workerIndex, task ) && !stealTask( t_workerIndex, task ) )
+            return false;
+    }
+    else if( !stealTask( m_workers.size(), task ) )
+    {
+        return false;
+    }
+
+    task();
+    return true;
+}
+
+
+void THREAD_POOL::workerLoop( size_t aIndex )
+{
+    t_pool = this;
+    t_workerIndex = aIndex;
+
+    while( true )
+    {
+        TASK task;
+
+        if( popTask( aIndex, task ) || stealTask( aIndex, task ) )
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( m_sleepLock );
+
+        m_wakeUp.wait( lock, [&]() { return m_stop.load() || m_queued.load() > 0; } );
+
+        if( m_stop.load() && m_queued.load() == 0 )
+            return;
+    }
+}
+
+
+TASK_GROUP::TASK_GROUP( PROGRESS_REPORTER* aReporter, THREAD_POOL& aPool ) :
+        m_pool( aPool ),
+        m_reporter( aReporter ),
+        m_pending( 0 ),
+        m_cancelled( false )
+{
+}
+
+
+TASK_GROUP::~TASK_GROUP()
+{
+    try
+    {
+        Wait();
+    }
+    catch( ... )
+    {
+        // Whoever cared about the result should have called Wait() themselves
+    }
+}
+
+
+void TASK_GROUP::Run( std::function<void()> aTask )
+{
+    m_pending.fetch_add( 1 );
+
+    m_pool.Submit( [this, task = std::move( aTask )]()
+            {
+                if( !IsCancelled() )
+                {
+                    try
+                    {
+                        task();
+                    }
+                    catch( ... )
+                    {
+                        std::lock_guard<std::mutex> guard( m_doneLock );
+
+                        if( !m_exception )
+                            m_exception = std::current_exception();
+
+                        Cancel();
+                    }
+                }
+
+                // The count is dropped under the lock so that Wait() cannot return, and the
+                // group be destroyed, while we still hold a reference to it
+                std::lock_guard<std::mutex> guard( m_doneLock );
+
+                if( m_pending.fetch_sub( 1 ) == 1 )
+                    m_done.notify_all();
+            } );
+}
+
+
+bool TASK_GROUP::Wait()
+{
+    // The UI may only be refreshed from the main thread, which then only waits: running a
+    // long task there would freeze the progress dialog.  Any other thread helps out.
+    bool refreshUI = m_reporter && !m_pool.IsWorkerThread() && wxIsMainThread();
+
+    while( m_pending.load() > 0 )
+    {
+        if( refreshUI )
+        {
+            if( !m_reporter->KeepRefreshing() )
+                Cancel();
+
+            std::unique_lock<std::mutex> lock( m_doneLock );
+            m_done.wait_for( lock, std::chrono::milliseconds( 100 ),
+                             [&]() { return m_pending.load() == 0; } );
+        }
+        else if( !m_pool.RunPendingTask() )
+        {
+            std::unique_lock<std::mutex> lock( m_doneLock );
+            m_done.wait_for( lock, std::chrono::milliseconds( 10 ),
+                             [&]() { return m_pending.load() == 0; } );
+        }
+    }
+
+    std::exception_ptr exception;
+
+    {
+        std::lock_guard<std::mutex> guard( m_doneLock );
+        std::swap( exception, m_exception );
+    }
+
+    if( exception )
+        std::rethrow_exception( exception );
+
+    return !IsCancelled();
+}
+
+
+bool ParallelFor( size_t aBegin, size_t aEnd, const std::function<void( size_t )>& aFunc,
+                  PROGRESS_REPORTER* aReporter, size_t aGrain )
+{
+    if( aEnd <= aBegin )
+        return true;
+
+    TASK_GROUP group( aReporter );
+    size_t     count = aEnd - aBegin;
+
+    // A few blocks per worker leaves room for stealing without drowning in task overhead
+    if( aGrain == 0 )
+        aGrain = std::max<size_t>( count / ( group.GetPool().GetThreadCount() * 4 ), 1 );
+
+    for( size_t blockStart = aBegin; blockStart < aEnd; blockStart += aGrain )
+    {
+        size_t blockEnd = std::min( blockStart + aGrain, aEnd );
+
+        group.Run( [&group, &aFunc, blockStart, blockEnd]()
+                {
+                    for( size_t ii = blockStart; ii < blockEnd && !group.IsCancelled(); ++ii )
+                        aFunc( ii );
+                } );
+
+        // Don't overflow on huge ranges
+        if( aEnd - blockStart <= aGrain )
+            break;
+    }
+
+    return group.Wait();
+}
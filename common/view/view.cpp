@@ -36,10 +36,16 @@
 #include <gal/definitions.h>
 #include <gal/graphics_abstraction_layer.h>
 #include <painter.h>
+#include <advanced_config.h>
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdint>
 
-#ifdef __WXDEBUG__
 #include <profile.h>
-#endif /* __WXDEBUG__  */
 
 namespace KIGFX {
 
@@ -53,6 +59,7 @@ public:
         m_flags( KIGFX::VISIBLE ),
         m_requiredUpdate( KIGFX::NONE ),
         m_drawPriority( 0 ),
+        m_lodStamp( 0 ),
         m_groups( nullptr ),
         m_groupsSize( 0 ) {}
 
@@ -90,6 +97,7 @@ private:
     int     m_flags;            ///< Visibility flags
     int     m_requiredUpdate;   ///< Flag required for updating
     int     m_drawPriority;     ///< Order to draw this item in a layer, lowest first
+    uint64_t m_lodStamp;        ///< State number, changed on every update (see VIEW::lodFrame)
 
     ///> Helper for storing cached items group ids
     typedef std::pair<int, int> GroupPair;
@@ -293,7 +301,13 @@ VIEW::VIEW( bool aIsDynamic ) :
     m_dynamic( aIsDynamic ),
     m_useDrawPriority( false ),
     m_nextDrawPriority( 0 ),
-    m_reverseDrawOrder( false )
+    m_reverseDrawOrder( false ),
+    m_parallelRecacheItems( ADVANCED_CFG::GetCfg().m_parallelRecacheItems ),
+    m_lodThreshold( ADVANCED_CFG::GetCfg().m_lodPixelThreshold ),
+    m_lodLevel( INT_MIN ),
+    m_lodStamp( 0 ),
+    m_lodBuiltTiles( 0 ),
+    m_redrawStats()
 {
     // Set m_boundary to define the max area size. The default area size
     // is defined here as the max value of a int.
@@ -525,6 +539,10 @@ void VIEW::SetGAL( GAL* aGal )
     if( recacheGroups )
         clearGroupCache();
 
+    // the merged tiles belong to the previous GAL
+    m_lodTiles.clear();
+    m_lodPendingTiles.clear();
+
     // every target has to be refreshed
     MarkDirty();
 
@@ -727,6 +745,7 @@ void VIEW::ReorderLayerData( std::unordered_map<int, int> aReorderMap )
     }
 
     m_layers = new_map;
+    clearLodTiles();
 
     for( VIEW_ITEM* item : *m_allItems )
     {
@@ -792,6 +811,9 @@ void VIEW::UpdateLayerColor( int aLayer )
         m_layers[aLayer].items->Query( r, visitor );
         MarkTargetDirty( m_layers[aLayer].target );
     }
+
+    // Tiles hold the shapes of many items, of different colors: they are built again
+    clearLodTiles( aLayer );
 }
 
 
@@ -822,6 +844,7 @@ void VIEW::UpdateAllLayersColor()
         }
     }
 
+    clearLodTiles();
     MarkDirty();
 }
 
@@ -950,18 +973,197 @@ void VIEW::UpdateAllLayersOrder()
                     m_gal->ChangeGroupDepth( group, m_layers[layers[i]].renderingOrder );
             }
         }
+
+        for( const auto& layerTiles : m_lodTiles )
+        {
+            for( const auto& tile : layerTiles.second )
+            {
+                if( tile.second.group >= 0 )
+                {
+                    m_gal->ChangeGroupDepth( tile.second.group,
+                                             m_layers[layerTiles.first].renderingOrder );
+                }
+            }
+        }
     }
 
     MarkDirty();
 }
 
 
+/**
+ * Signature of the items of a merged tile, independent of the order they are found in
+ */
+struct LOD_SIGNATURE
+{
+    LOD_SIGNATURE() :
+        sum( 0 ), bits( 0 ), count( 0 )
+    {
+    }
+
+    void Add( const VIEW_ITEM* aItem, uint64_t aStamp )
+    {
+        // splitmix64 finalizer of the item address and its state
+        uint64_t h = (uint64_t) reinterpret_cast<uintptr_t>( aItem )
+                     ^ ( aStamp * 0x9E3779B97F4A7C15ULL );
+
+        h = ( h ^ ( h >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+        h = ( h ^ ( h >> 27 ) ) * 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+
+        sum += h;
+        bits ^= ( h << 17 ) | ( h >> 47 );
+        count++;
+    }
+
+    uint64_t Value() const
+    {
+        return sum ^ ( bits * 0x9E3779B97F4A7C15ULL ) ^ count;
+    }
+
+    uint64_t sum;
+    uint64_t bits;
+    uint64_t count;
+};
+
+
+static uint64_t lodTileKey( const VECTOR2I& aTile )
+{
+    return ( (uint64_t) (uint32_t) aTile.x << 32 ) | (uint32_t) aTile.y;
+}
+
+
+static VECTOR2I lodTileFromKey( uint64_t aKey )
+{
+    return VECTOR2I( (int32_t) (uint32_t) ( aKey >> 32 ), (int32_t) (uint32_t) aKey );
+}
+
+
+/**
+ * The merged tiles covering the area redrawn on a layer. The small items found while drawing
+ * the layer are kept by tile instead of being drawn; a tile is then drawn as its cached group
+ * if it was built for exactly these items in their current state, otherwise its items are
+ * drawn one by one and the tile is built by the next VIEW::UpdateItems().
+ */
+struct VIEW::lodFrame
+{
+    ///> At most this many tiles are covered, otherwise the items are not merged
+    static const int MAX_TILES = 4096;
+
+    struct TILE
+    {
+        LOD_SIGNATURE           signature;
+        std::vector<VIEW_ITEM*> items;
+    };
+
+    lodFrame( VIEW* aView, const LOD_GRID& aGrid, const BOX2I& aRect ) :
+        view( aView ), grid( aGrid ), layer( -1 )
+    {
+        VECTOR2I end = aRect.GetEnd();
+
+        first = VECTOR2I( (int) std::floor( aRect.GetX() / grid.tileSize ),
+                          (int) std::floor( aRect.GetY() / grid.tileSize ) );
+        count = VECTOR2I( (int) std::floor( end.x / grid.tileSize ) - first.x + 1,
+                          (int) std::floor( end.y / grid.tileSize ) - first.y + 1 );
+
+        if( (double) count.x * count.y > MAX_TILES )
+            count = VECTOR2I( 0, 0 );
+
+        tiles.resize( count.x * count.y );
+
+        // Every item of the tiles has to be found: the query covers them entirely
+        rect = grid.TileRect( first );
+        rect.Merge( grid.TileRect( first + count - VECTOR2I( 1, 1 ) ) );
+    }
+
+    bool IsValid() const
+    {
+        return !tiles.empty();
+    }
+
+    void Reset( int aLayer )
+    {
+        layer = aLayer;
+
+        for( TILE& tile : tiles )
+        {
+            tile.signature = LOD_SIGNATURE();
+            tile.items.clear();
+        }
+    }
+
+    ///> Keeps aItem for its tile if it is drawn by one
+    bool Add( VIEW_ITEM* aItem, unsigned int aLod )
+    {
+        VIEW_COARSE_SHAPE shape;
+        VECTOR2I          tile;
+
+        if( !grid.Merges( aItem, layer, aLod, shape, tile ) )
+            return false;
+
+        tile -= first;
+
+        // Tiles at the border of the query, which were not entirely found
+        if( tile.x < 0 || tile.y < 0 || tile.x >= count.x || tile.y >= count.y )
+            return false;
+
+        TILE& t = tiles[tile.y * count.x + tile.x];
+
+        t.signature.Add( aItem, aItem->viewPrivData()->m_lodStamp );
+        t.items.push_back( aItem );
+
+        return true;
+    }
+
+    void Draw()
+    {
+        std::unordered_map<uint64_t, LOD_TILE>& built = view->m_lodTiles[layer];
+
+        for( int ii = 0; ii < (int) tiles.size(); ++ii )
+        {
+            const TILE& tile = tiles[ii];
+
+            if( tile.items.empty() )
+                continue;
+
+            uint64_t key = lodTileKey( first + VECTOR2I( ii % count.x, ii / count.x ) );
+            auto     it = built.find( key );
+
+            if( it != built.end() && it->second.group >= 0
+                    && it->second.signature == tile.signature.Value() )
+            {
+                view->m_gal->DrawGroup( it->second.group );
+                view->m_redrawStats.m_drawCalls++;
+                view->m_redrawStats.m_tiles++;
+                view->m_redrawStats.m_mergedItems += (int) tile.items.size();
+                continue;
+            }
+
+            for( VIEW_ITEM* item : tile.items )
+                view->draw( item, layer );
+
+            view->m_lodPendingTiles.emplace_back( layer, key );
+        }
+    }
+
+    VIEW*             view;
+    const LOD_GRID&   grid;
+    int               layer;
+    VECTOR2I          first;    ///< first tile covered
+    VECTOR2I          count;    ///< number of tiles covered, in each direction
+    BOX2I             rect;     ///< area to query for the items
+    std::vector<TILE> tiles;
+};
+
+
 struct VIEW::drawItem
 {
-    drawItem( VIEW* aView, int aLayer, bool aUseDrawPriority, bool aReverseDrawOrder ) :
+    drawItem( VIEW* aView, int aLayer, bool aUseDrawPriority, bool aReverseDrawOrder,
+              lodFrame* aLodFrame = nullptr ) :
         view( aView ), layer( aLayer ),
         useDrawPriority( aUseDrawPriority ),
-        reverseDrawOrder( aReverseDrawOrder )
+        reverseDrawOrder( aReverseDrawOrder ),
+        lod( aLodFrame )
     {
     }
 
@@ -969,10 +1171,17 @@ struct VIEW::drawItem
     {
         wxCHECK( aItem->viewPrivData(), false );
 
+        if( !aItem->viewPrivData()->isRenderable() )
+            return true;
+
+        unsigned int itemLod = aItem->ViewGetLOD( layer, view );
+
         // Conditions that have to be fulfilled for an item to be drawn
-        bool drawCondition = aItem->viewPrivData()->isRenderable() &&
-                             aItem->ViewGetLOD( layer, view ) < view->m_scale;
-        if( !drawCondition )
+        if( itemLod >= view->m_scale )
+            return true;
+
+        // Small items are drawn by their tile
+        if( lod && lod->Add( aItem, itemLod ) )
             return true;
 
         if( useDrawPriority )
@@ -1003,21 +1212,52 @@ struct VIEW::drawItem
     VIEW* view;
     int layer, layers[VIEW_MAX_LAYERS];
     bool useDrawPriority, reverseDrawOrder;
+    lodFrame* lod;
     std::vector<VIEW_ITEM*> drawItems;
 };
 
 
 void VIEW::redrawRect( const BOX2I& aRect )
 {
+    LOD_GRID                  grid;
+    std::unique_ptr<lodFrame> lod;
+
+    if( getLodGrid( grid ) )
+    {
+        // The tiles of another zoom level will not be used before long
+        if( grid.level != m_lodLevel )
+        {
+            clearLodTiles();
+            m_lodLevel = grid.level;
+        }
+
+        lod = std::make_unique<lodFrame>( this, grid, aRect );
+
+        if( !lod->IsValid() )
+            lod.reset();
+    }
+
     for( VIEW_LAYER* l : m_orderedLayers )
     {
         if( l->visible && IsTargetDirty( l->target ) && areRequiredLayersEnabled( l->id ) )
         {
-            drawItem drawFunc( this, l->id, m_useDrawPriority, m_reverseDrawOrder );
+            bool     merge = lod && l->target == TARGET_CACHED;
+            drawItem drawFunc( this, l->id, m_useDrawPriority, m_reverseDrawOrder,
+                               merge ? lod.get() : nullptr );
 
             m_gal->SetTarget( l->target );
             m_gal->SetLayerDepth( l->renderingOrder );
-            l->items->Query( aRect, drawFunc );
+
+            if( merge )
+            {
+                lod->Reset( l->id );
+                l->items->Query( lod->rect, drawFunc );
+                lod->Draw();
+            }
+            else
+            {
+                l->items->Query( aRect, drawFunc );
+            }
 
             if( m_useDrawPriority )
                 drawFunc.deferredDraw();
@@ -1039,15 +1279,22 @@ void VIEW::draw( VIEW_ITEM* aItem, int aLayer, bool aImmediate )
         int group = viewData->getGroup( aLayer );
 
         if( group >= 0 )
+        {
             m_gal->DrawGroup( group );
+            m_redrawStats.m_drawCalls++;
+        }
         else
+        {
             Update( aItem );
+        }
     }
     else
     {
         // Immediate mode
         if( !m_painter->Draw( aItem, aLayer ) )
             aItem->ViewDraw( aLayer, this );  // Alternative drawing method
+
+        m_redrawStats.m_drawCalls++;
     }
 }
 
@@ -1120,6 +1367,8 @@ void VIEW::Clear()
     m_nextDrawPriority = 0;
 
     m_gal->ClearCache();
+    m_lodTiles.clear();
+    m_lodPendingTiles.clear();
 }
 
 
@@ -1144,9 +1393,11 @@ void VIEW::ClearTargets()
 
 void VIEW::Redraw()
 {
-#ifdef __WXDEBUG__
     PROF_COUNTER totalRealTime;
-#endif /* __WXDEBUG__ */
+
+    m_redrawStats = REDRAW_STATS();
+    m_redrawStats.m_builtTiles = m_lodBuiltTiles;
+    m_lodBuiltTiles = 0;
 
     VECTOR2D screenSize = m_gal->GetScreenPixelSize();
     BOX2D    rect( ToWorld( VECTOR2D( 0, 0 ) ),
@@ -1167,9 +1418,13 @@ void VIEW::Redraw()
     markTargetClean( TARGET_NONCACHED );
     markTargetClean( TARGET_OVERLAY );
 
-#ifdef __WXDEBUG__
     totalRealTime.Stop();
-    wxLogTrace( "GAL_PROFILE", "VIEW::Redraw(): %.1f ms", totalRealTime.msecs() );
+    m_redrawStats.m_time = totalRealTime.msecs();
+
+#ifdef __WXDEBUG__
+    wxLogTrace( "GAL_PROFILE", "VIEW::Redraw(): %.1f ms, %d draw calls, %d tiles (%d items)",
+                m_redrawStats.m_time, m_redrawStats.m_drawCalls, m_redrawStats.m_tiles,
+                m_redrawStats.m_mergedItems );
 #endif /* __WXDEBUG__ */
 }
 
@@ -1213,7 +1468,8 @@ void VIEW::clearGroupCache()
 }
 
 
-void VIEW::invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags )
+void VIEW::invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags,
+                           std::vector<VIEW_ITEM*>* aGeometryUpdates )
 {
     if( aUpdateFlags & INITIAL_ADD )
     {
@@ -1237,12 +1493,17 @@ void VIEW::invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags )
     int layers[VIEW_MAX_LAYERS], layers_count;
     aItem->ViewGetLayers( layers, layers_count );
 
+    bool deferGeometry = aGeometryUpdates && ( aUpdateFlags & ( GEOMETRY | LAYERS | REPAINT ) );
+
+    if( deferGeometry )
+        aGeometryUpdates->push_back( aItem );
+
     // Iterate through layers used by the item and recache it immediately
     for( int i = 0; i < layers_count; ++i )
     {
         int layerId = layers[i];
 
-        if( IsCached( layerId ) )
+        if( IsCached( layerId ) && !deferGeometry )
         {
             if( aUpdateFlags & ( GEOMETRY | LAYERS | REPAINT ) )
                 updateItemGeometry( aItem, layerId );
@@ -1254,6 +1515,9 @@ void VIEW::invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags )
         MarkTargetDirty( m_layers[layerId].target );
     }
 
+    // The merged tile of the item has to be built again
+    aItem->viewPrivData()->m_lodStamp = ++m_lodStamp;
+
     aItem->viewPrivData()->clearUpdateFlags();
 }
 
@@ -1322,6 +1586,372 @@ void VIEW::updateItemGeometry( VIEW_ITEM* aItem, int aLayer )
 }
 
 
+void VIEW::updateItemsGeometry( const std::vector<VIEW_ITEM*>& aItems )
+{
+    // Number of items drawn by the workers before their groups are moved to the GAL, it
+    // bounds the memory used by the workers
+    const size_t CHUNK_SIZE = 16384;
+
+    std::vector<std::unique_ptr<GAL>>     workerGals;
+    std::vector<std::unique_ptr<PAINTER>> workerPainters;
+
+    if( m_parallelRecacheItems > 0 && aItems.size() >= (size_t) m_parallelRecacheItems )
+    {
+        // The GUI thread draws as well while waiting for the pool threads
+        size_t workerCount = THREAD_POOL::Get().GetThreadCount() + 1;
+
+        for( size_t ii = 0; ii < workerCount; ++ii )
+        {
+            std::unique_ptr<GAL>     gal = m_gal->CreateWorkerGal();
+            std::unique_ptr<PAINTER> painter = gal ? m_painter->Clone( gal.get() ) : nullptr;
+
+            if( !painter )
+                break;
+
+            workerGals.push_back( std::move( gal ) );
+            workerPainters.push_back( std::move( painter ) );
+        }
+    }
+
+    if( workerGals.empty() )
+    {
+        for( VIEW_ITEM* item : aItems )
+        {
+            int layers[VIEW_MAX_LAYERS], layers_count;
+            item->ViewGetLayers( layers, layers_count );
+
+            for( int i = 0; i < layers_count; ++i )
+            {
+                if( IsCached( layers[i] ) )
+                    updateItemGeometry( item, layers[i] );
+            }
+        }
+
+        return;
+    }
+
+    struct DRAWN_LAYER
+    {
+        int m_layer;
+        int m_group;    ///< Group number in the worker GAL, -1 if the painter can't draw the item
+    };
+
+    struct DRAWN_ITEM
+    {
+        GAL*                     m_gal;
+        std::vector<DRAWN_LAYER> m_layers;
+    };
+
+    std::vector<DRAWN_ITEM> drawn;
+
+    for( size_t chunkStart = 0; chunkStart < aItems.size(); chunkStart += CHUNK_SIZE )
+    {
+        size_t              chunkEnd = std::min( chunkStart + CHUNK_SIZE, aItems.size() );
+        std::atomic<size_t> nextItem( chunkStart );
+        TASK_GROUP          tasks;
+
+        drawn.assign( chunkEnd - chunkStart, DRAWN_ITEM() );
+
+        // Drawing an item may change the item itself (e.g. its cached triangulation) but
+        // nothing shared with other items, so the workers take the items one at a time
+        for( size_t w = 0; w < workerGals.size(); ++w )
+        {
+            tasks.Run( [&, w]()
+                    {
+                        GAL*     gal = workerGals[w].get();
+                        PAINTER* painter = workerPainters[w].get();
+
+                        for( size_t ii = nextItem++; ii < chunkEnd; ii = nextItem++ )
+                        {
+                            VIEW_ITEM*  item = aItems[ii];
+                            DRAWN_ITEM& result = drawn[ii - chunkStart];
+                            int         layers[VIEW_MAX_LAYERS], layers_count;
+
+                            item->ViewGetLayers( layers, layers_count );
+                            result.m_gal = gal;
+
+                            for( int i = 0; i < layers_count; ++i )
+                            {
+                                if( !IsCached( layers[i] ) )
+                                    continue;
+
+                                gal->SetLayerDepth( m_layers.at( layers[i] ).renderingOrder );
+
+                                int group = gal->BeginGroup();
+
+                                // ViewDraw() is left to the GUI thread
+                                if( !painter->Draw( static_cast<EDA_ITEM*>( item ), layers[i] ) )
+                                    group = -1;
+
+                                gal->EndGroup();
+                                result.m_layers.push_back( { layers[i], group } );
+                            }
+                        }
+                    } );
+        }
+
+        tasks.Wait();
+
+        // Only the GUI thread may touch the GAL: move the groups in the items order
+        for( size_t ii = chunkStart; ii < chunkEnd; ++ii )
+        {
+            VIEW_ITEM*        item = aItems[ii];
+            VIEW_ITEM_DATA*   viewData = item->viewPrivData();
+            const DRAWN_ITEM& result = drawn[ii - chunkStart];
+
+            for( const DRAWN_LAYER& drawnLayer : result.m_layers )
+            {
+                int group = -1;
+
+                if( drawnLayer.m_group >= 0 )
+                    group = m_gal->AdoptGroup( result.m_gal, drawnLayer.m_group );
+
+                if( group < 0 )
+                {
+                    updateItemGeometry( item, drawnLayer.m_layer );
+                    continue;
+                }
+
+                int oldGroup = viewData->getGroup( drawnLayer.m_layer );
+
+                if( oldGroup >= 0 )
+                    m_gal->DeleteGroup( oldGroup );
+
+                viewData->setGroup( drawnLayer.m_layer, group );
+            }
+        }
+
+        for( std::unique_ptr<GAL>& gal : workerGals )
+            gal->ClearCache();
+    }
+}
+
+
+/// Size of the merged tiles in pixels, at the lowest zoom of their level
+static const double LOD_TILE_PIXELS = 256.0;
+
+
+void VIEW::SetLodThreshold( int aPixels )
+{
+    if( aPixels == m_lodThreshold )
+        return;
+
+    m_lodThreshold = aPixels;
+    clearLodTiles();
+    MarkTargetDirty( TARGET_CACHED );
+}
+
+
+bool VIEW::getLodGrid( LOD_GRID& aGrid ) const
+{
+    double worldScale = m_gal->GetWorldScale();
+
+    // Printing and draw priorities need every item drawn by itself
+    if( m_lodThreshold <= 0 || m_useDrawPriority || m_printMode > 0 || worldScale <= 0.0 )
+        return false;
+
+    // The levels are a factor of 2 apart: the items merged at a level are smaller than the
+    // threshold at every zoom of the level
+    aGrid.level = (int) std::floor( std::log2( worldScale ) );
+
+    double levelScale = std::ldexp( 1.0, aGrid.level );
+
+    aGrid.tileSize = LOD_TILE_PIXELS / levelScale;
+    aGrid.itemSize = m_lodThreshold / ( 2.0 * levelScale );
+    aGrid.minScale = m_scale * levelScale / worldScale;
+
+    // Nothing is small enough to be merged when zoomed in that much
+    return aGrid.itemSize >= 1.0;
+}
+
+
+bool VIEW::LOD_GRID::Merges( const VIEW_ITEM* aItem, int aLayer, unsigned int aLod,
+                             VIEW_COARSE_SHAPE& aShape, VECTOR2I& aTile ) const
+{
+    if( aLod >= minScale || !aItem->ViewGetCoarseShape( aLayer, aShape ) )
+        return false;
+
+    BOX2I bbox = aShape.BBox();
+
+    if( std::max( bbox.GetWidth(), bbox.GetHeight() ) >= itemSize )
+        return false;
+
+    VECTOR2I centre = bbox.Centre();
+
+    aTile.x = (int) std::floor( centre.x / tileSize );
+    aTile.y = (int) std::floor( centre.y / tileSize );
+
+    return true;
+}
+
+
+const BOX2I VIEW::LOD_GRID::TileRect( const VECTOR2I& aTile ) const
+{
+    typedef std::numeric_limits<int> coord_limits;
+
+    auto clamp = []( double aValue ) -> int
+    {
+        return (int) std::max<double>( coord_limits::lowest() / 2,
+                                       std::min<double>( coord_limits::max() / 2, aValue ) );
+    };
+
+    VECTOR2I start( clamp( std::floor( aTile.x * tileSize ) ),
+                    clamp( std::floor( aTile.y * tileSize ) ) );
+    VECTOR2I end( clamp( std::ceil( ( aTile.x + 1 ) * tileSize ) ),
+                  clamp( std::ceil( ( aTile.y + 1 ) * tileSize ) ) );
+
+    return BOX2I( start, end - start );
+}
+
+
+/**
+ * Finds the items drawn by a merged tile, for VIEW::updateLodTiles()
+ */
+struct VIEW::lodTileBuilder
+{
+    lodTileBuilder( VIEW* aView, int aLayer, const LOD_GRID& aGrid, const VECTOR2I& aTile ) :
+        view( aView ), layer( aLayer ), grid( aGrid ), tile( aTile )
+    {
+    }
+
+    bool operator()( VIEW_ITEM* aItem )
+    {
+        VIEW_ITEM_DATA*   viewData = aItem->viewPrivData();
+        VIEW_COARSE_SHAPE shape;
+        VECTOR2I          itemTile;
+
+        // Same conditions as the ones of drawItem and lodFrame
+        if( !viewData || !viewData->isRenderable() )
+            return true;
+
+        unsigned int itemLod = aItem->ViewGetLOD( layer, view );
+
+        if( itemLod >= view->m_scale || !grid.Merges( aItem, layer, itemLod, shape, itemTile )
+                || itemTile != tile )
+        {
+            return true;
+        }
+
+        signature.Add( aItem, viewData->m_lodStamp );
+        shapes.emplace_back( shape, view->m_painter->GetSettings()->GetColor( aItem, layer ) );
+
+        return true;
+    }
+
+    VIEW*           view;
+    int             layer;
+    const LOD_GRID& grid;
+    VECTOR2I        tile;
+    LOD_SIGNATURE   signature;
+    std::vector<std::pair<VIEW_COARSE_SHAPE, COLOR4D>> shapes;
+};
+
+
+void VIEW::updateLodTiles()
+{
+    LOD_GRID grid;
+
+    if( m_lodPendingTiles.empty() )
+        return;
+
+    // The zoom changed to another level since the tiles were found out of date
+    if( !getLodGrid( grid ) || grid.level != m_lodLevel )
+    {
+        m_lodPendingTiles.clear();
+        return;
+    }
+
+    std::sort( m_lodPendingTiles.begin(), m_lodPendingTiles.end() );
+    m_lodPendingTiles.erase( std::unique( m_lodPendingTiles.begin(), m_lodPendingTiles.end() ),
+                             m_lodPendingTiles.end() );
+
+    for( const std::pair<int, uint64_t>& pending : m_lodPendingTiles )
+    {
+        VIEW_LAYER&                             l = m_layers.at( pending.first );
+        std::unordered_map<uint64_t, LOD_TILE>& tiles = m_lodTiles[pending.first];
+        VECTOR2I                                tilePos = lodTileFromKey( pending.second );
+        lodTileBuilder                          builder( this, l.id, grid, tilePos );
+
+        l.items->Query( grid.TileRect( tilePos ), builder );
+
+        auto it = tiles.find( pending.second );
+
+        if( it != tiles.end() )
+        {
+            if( it->second.group >= 0 )
+                m_gal->DeleteGroup( it->second.group );
+
+            tiles.erase( it );
+        }
+
+        if( builder.shapes.empty() )
+            continue;
+
+        LOD_TILE tile;
+
+        m_gal->SetTarget( l.target );
+        m_gal->SetLayerDepth( l.renderingOrder );
+
+        tile.group = m_gal->BeginGroup();
+        tile.signature = builder.signature.Value();
+
+        m_gal->SetIsFill( true );
+        m_gal->SetIsStroke( false );
+
+        for( const std::pair<VIEW_COARSE_SHAPE, COLOR4D>& shape : builder.shapes )
+        {
+            const VIEW_COARSE_SHAPE& s = shape.first;
+
+            m_gal->SetFillColor( shape.second );
+            m_gal->SetStrokeColor( shape.second );
+
+            switch( s.m_type )
+            {
+            case VIEW_COARSE_SHAPE::SEGMENT:
+                m_gal->DrawSegment( s.m_start, s.m_end, s.m_width );
+                break;
+
+            case VIEW_COARSE_SHAPE::CIRCLE:
+                m_gal->DrawCircle( s.m_start, s.m_width / 2.0 );
+                break;
+
+            case VIEW_COARSE_SHAPE::RECT:
+                m_gal->DrawRectangle( s.m_start, s.m_end );
+                break;
+            }
+        }
+
+        m_gal->EndGroup();
+
+        tiles[pending.second] = tile;
+        m_lodBuiltTiles++;
+        MarkTargetDirty( l.target );
+    }
+
+    m_lodPendingTiles.clear();
+}
+
+
+void VIEW::clearLodTiles( int aLayer )
+{
+    for( auto& layerTiles : m_lodTiles )
+    {
+        if( aLayer >= 0 && layerTiles.first != aLayer )
+            continue;
+
+        for( const auto& tile : layerTiles.second )
+        {
+            if( tile.second.group >= 0 )
+                m_gal->DeleteGroup( tile.second.group );
+        }
+
+        layerTiles.second.clear();
+    }
+
+    m_lodPendingTiles.clear();
+}
+
+
 void VIEW::updateBbox( VIEW_ITEM* aItem )
 {
     int layers[VIEW_MAX_LAYERS], layers_count;
@@ -1415,6 +2045,8 @@ void VIEW::RecacheAllItems()
             l->items->Query( r, visitor );
         }
     }
+
+    clearLodTiles();
 }
 
 
@@ -1422,7 +2054,8 @@ void VIEW::UpdateItems()
 {
     if( m_gal->IsVisible() )
     {
-        GAL_UPDATE_CONTEXT ctx( m_gal );
+        GAL_UPDATE_CONTEXT      ctx( m_gal );
+        std::vector<VIEW_ITEM*> geometryUpdates;
 
         for( VIEW_ITEM* item : *m_allItems )
         {
@@ -1433,10 +2066,13 @@ void VIEW::UpdateItems()
 
             if( viewData->m_requiredUpdate != NONE )
             {
-                invalidateItem( item, viewData->m_requiredUpdate );
+                invalidateItem( item, viewData->m_requiredUpdate, &geometryUpdates );
                 viewData->m_requiredUpdate = NONE;
             }
         }
+
+        updateItemsGeometry( geometryUpdates );
+        updateLodTiles();
     }
 }
 
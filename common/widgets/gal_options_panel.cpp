@@ -30,6 +30,7 @@
 
 #include <widgets/gal_options_panel.h>
 
+#include <advanced_config.h>
 #include <common.h>
 
 #include <config_map.h>
@@ -56,6 +57,7 @@ static const UTIL::CFG_MAP<KIGFX::GRID_STYLE> gridStyleSelectMap =
 
 GAL_OPTIONS_PANEL::GAL_OPTIONS_PANEL( wxWindow* aParent, KIGFX::GAL_DISPLAY_OPTIONS& aGalOpts ):
     wxPanel( aParent, wxID_ANY ),
+    m_vertexMemory( nullptr ),
     m_galOptions( aGalOpts )
 {
     // the main sizer that holds "columns" of settings
@@ -156,6 +158,20 @@ GAL_OPTIONS_PANEL::GAL_OPTIONS_PANEL( wxWindow* aParent, KIGFX::GAL_DISPLAY_OPTI
         m_forceCursorDisplay = new wxCheckBox( this, wxID_ANY, _( "Always show crosshairs" ) );
         sCursorSettings->Add( m_forceCursorDisplay, 0, wxALL | wxEXPAND, 5 );
     }
+
+    /*
+     * Vertex memory statistics, a debugging aid
+     */
+    if( ADVANCED_CFG::GetCfg().m_showVertexMemoryStats )
+    {
+        auto sMemoryStats = new wxStaticBoxSizer( new wxStaticBox( this,
+                wxID_ANY, _( "Vertex Memory (OpenGL)" ) ), wxVERTICAL );
+
+        sLeftSizer->Add( sMemoryStats, 0, wxTOP | wxRIGHT | wxEXPAND, 5 );
+
+        m_vertexMemory = new wxStaticText( sMemoryStats->GetStaticBox(), wxID_ANY, wxEmptyString );
+        sMemoryStats->Add( m_vertexMemory, 0, wxALL | wxEXPAND, 5 );
+    }
 }
 
 
@@ -172,6 +188,19 @@ bool GAL_OPTIONS_PANEL::TransferDataToWindow()
 
     m_forceCursorDisplay->SetValue( m_galOptions.m_forceDisplayCursor );
 
+    if( m_vertexMemory )
+    {
+        const KIGFX::VERTEX_MEMORY_STATS& stats = m_galOptions.m_vertexMemory;
+        const double                      MB = 1024.0 * 1024.0;
+
+        m_vertexMemory->SetLabel( wxString::Format(
+                _( "Buffer: %.1f MB\nSlabs: %d (%.1f MB)\nVertices: %.1f MB\n"
+                   "Fragmentation: %.1f %%\nResizes: %d\nCompacted slabs: %d" ),
+                stats.m_reserved / MB, stats.m_slabCount, stats.m_slabs / MB,
+                stats.m_inUse / MB, stats.Fragmentation() * 100.0, stats.m_resizes,
+                stats.m_compactions ) );
+    }
+
     return true;
 }
 
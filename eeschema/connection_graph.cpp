@@ -19,9 +19,7 @@
  */
 
 #include <list>
-#include <thread>
 #include <algorithm>
-#include <future>
 #include <vector>
 #include <unordered_map>
 #include <profile.h>
@@ -40,6 +38,7 @@
 
 #include <advanced_config.h>
 #include <connection_graph.h>
+#include <thread_pool.h>
 #include <widgets/ui_common.h>
 
 bool CONNECTION_SUBGRAPH::ResolveDrivers( bool aCreateMarkers )
@@ -717,12 +716,6 @@ void CONNECTION_GRAPH::buildConnectionGraph()
 
     // Resolve drivers for subgraphs and propagate connectivity info
 
-    // We don't want to spin up a new thread for fewer than 8 nets (overhead costs)
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            ( m_subgraphs.size() + 3 ) / 4 );
-
-    std::atomic<size_t> nextSubgraph( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
     std::vector<CONNECTION_SUBGRAPH*> dirty_graphs;
 
     std::copy_if( m_subgraphs.begin(), m_subgraphs.end(), std::back_inserter( dirty_graphs ),
@@ -731,105 +724,97 @@ void CONNECTION_GRAPH::buildConnectionGraph()
                       return candidate->m_dirty;
                   } );
 
-    auto update_lambda = [&nextSubgraph, &dirty_graphs]() -> size_t
+    auto update_lambda = [&dirty_graphs]( size_t subgraphId )
     {
-        for( size_t subgraphId = nextSubgraph++; subgraphId < dirty_graphs.size(); subgraphId = nextSubgraph++ )
-        {
-            auto subgraph = dirty_graphs[subgraphId];
+        auto subgraph = dirty_graphs[subgraphId];
 
-            if( !subgraph->m_dirty )
-                continue;
+        if( !subgraph->m_dirty )
+            return;
 
-            // Special processing for some items
-            for( auto item : subgraph->m_items )
+        // Special processing for some items
+        for( auto item : subgraph->m_items )
+        {
+            switch( item->Type() )
             {
-                switch( item->Type() )
-                {
-                case SCH_NO_CONNECT_T:
-                    subgraph->m_no_connect = item;
-                    break;
+            case SCH_NO_CONNECT_T:
+                subgraph->m_no_connect = item;
+                break;
 
-                case SCH_BUS_WIRE_ENTRY_T:
-                    subgraph->m_bus_entry = item;
-                    break;
+            case SCH_BUS_WIRE_ENTRY_T:
+                subgraph->m_bus_entry = item;
+                break;
 
-                case SCH_PIN_T:
-                {
-                    auto pin = static_cast<SCH_PIN*>( item );
+            case SCH_PIN_T:
+            {
+                auto pin = static_cast<SCH_PIN*>( item );
 
-                    if( pin->GetType() == ELECTRICAL_PINTYPE::PT_NC )
-                        subgraph->m_no_connect = item;
+                if( pin->GetType() == ELECTRICAL_PINTYPE::PT_NC )
+                    subgraph->m_no_connect = item;
 
-                    break;
-                }
+                break;
+            }
 
-                default:
-                    break;
-                }
+            default:
+                break;
             }
+        }
 
-            if( !subgraph->ResolveDrivers() )
+        if( !subgraph->ResolveDrivers() )
+        {
+            subgraph->m_dirty = false;
+        }
+        else
+        {
+            // Now the subgraph has only one driver
+            SCH_ITEM* driver = subgraph->m_driver;
+            SCH_SHEET_PATH sheet = subgraph->m_sheet;
+            SCH_CONNECTION* connection = driver->Connection( sheet );
+
+            // TODO(JE) This should live in SCH_CONNECTION probably
+            switch( driver->Type() )
             {
-                subgraph->m_dirty = false;
+            case SCH_LABEL_T:
+            case SCH_GLOBAL_LABEL_T:
+            case SCH_HIER_LABEL_T:
+            {
+                auto text = static_cast<SCH_TEXT*>( driver );
+                connection->ConfigureFromLabel( text->GetText() );
+                break;
             }
-            else
+            case SCH_SHEET_PIN_T:
             {
-                // Now the subgraph has only one driver
-                SCH_ITEM* driver = subgraph->m_driver;
-                SCH_SHEET_PATH sheet = subgraph->m_sheet;
-                SCH_CONNECTION* connection = driver->Connection( sheet );
-
-                // TODO(JE) This should live in SCH_CONNECTION probably
-                switch( driver->Type() )
-                {
-                case SCH_LABEL_T:
-                case SCH_GLOBAL_LABEL_T:
-                case SCH_HIER_LABEL_T:
-                {
-                    auto text = static_cast<SCH_TEXT*>( driver );
-                    connection->ConfigureFromLabel( text->GetText() );
-                    break;
-                }
-                case SCH_SHEET_PIN_T:
-                {
-                    auto pin = static_cast<SCH_SHEET_PIN*>( driver );
-                    connection->ConfigureFromLabel( pin->GetText() );
-                    break;
-                }
-                case SCH_PIN_T:
-                {
-                    auto pin = static_cast<SCH_PIN*>( driver );
-                    // NOTE(JE) GetDefaultNetName is not thread-safe.
-                    connection->ConfigureFromLabel( pin->GetDefaultNetName( sheet ) );
+                auto pin = static_cast<SCH_SHEET_PIN*>( driver );
+                connection->ConfigureFromLabel( pin->GetText() );
+                break;
+            }
+            case SCH_PIN_T:
+            {
+                auto pin = static_cast<SCH_PIN*>( driver );
+                // NOTE(JE) GetDefaultNetName is not thread-safe.
+                connection->ConfigureFromLabel( pin->GetDefaultNetName( sheet ) );
 
-                    break;
-                }
-                default:
-                    wxLogTrace( "CONN", "Driver type unsupported: %s",
-                            driver->GetSelectMenuText( EDA_UNITS::MILLIMETRES ) );
-                    break;
-                }
+                break;
+            }
+            default:
+                wxLogTrace( "CONN", "Driver type unsupported: %s",
+                        driver->GetSelectMenuText( EDA_UNITS::MILLIMETRES ) );
+                break;
+            }
 
-                connection->SetDriver( driver );
-                connection->ClearDirty();
+            connection->SetDriver( driver );
+            connection->ClearDirty();
 
-                subgraph->m_dirty = false;
-            }
+            subgraph->m_dirty = false;
         }
-
-        return 1;
     };
 
-    if( parallelThreadCount == 1 )
-        update_lambda();
-    else
+    // We don't want to go through the thread pool for fewer than 8 nets (overhead costs).
+    // A cancelled loop leaves subgraphs unresolved, and the rest of the graph relies on all of
+    // them: they are finished here, the subgraphs already resolved are no longer dirty.
+    if( dirty_graphs.size() < 8 || !ParallelFor( 0, dirty_graphs.size(), update_lambda ) )
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
-
-        // Finalize the threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
+        for( size_t ii = 0; ii < dirty_graphs.size(); ++ii )
+            update_lambda( ii );
     }
 
     // Now discard any non-driven subgraphs from further consideration
@@ -60,11 +60,10 @@
 #include <sch_sheet.h>
 #include <sch_text.h>
 #include <symbol_lib_table.h>
+#include <thread_pool.h>
 #include <tool/common_tools.h>
 
-#include <thread>
 #include <algorithm>
-#include <future>
 #include <array>
 
 // TODO(JE) Debugging only
@@ -1161,31 +1160,11 @@ void SCH_SCREENS::TestDanglingEnds()
     for( SCH_SCREEN* screen = GetFirst(); screen; screen = GetNext() )
         screens.push_back( screen );
 
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            screens.size() );
-
-    std::atomic<size_t> nextScreen( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
-
-    auto update_lambda = [&screens, &nextScreen]() -> size_t
-    {
-        for( auto i = nextScreen++; i < screens.size(); i = nextScreen++ )
-            screens[i]->TestDanglingEnds();
-
-        return 1;
-    };
-
-    if( parallelThreadCount == 1 )
-        update_lambda();
-    else
-    {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
-
-        // Finalize the threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
-    }
+    ParallelFor( 0, screens.size(),
+                 [&screens]( size_t i )
+                 {
+                     screens[i]->TestDanglingEnds();
+                 }, nullptr, 1 );
 }
 
 
@@ -558,7 +558,7 @@ void SCH_SEXPR_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
 
 void SCH_SEXPR_PLUGIN::loadFile( const wxString& aFileName, SCH_SCREEN* aScreen )
 {
-    FILE_LINE_READER reader( aFileName );
+    WHOLE_FILE_LINE_READER reader( aFileName );
 
     loadHeader( reader, aScreen );
 
@@ -1363,7 +1363,7 @@ void SCH_SEXPR_PLUGIN_CACHE::Load()
     wxLogTrace( traceSchLegacyPlugin, "Loading sexpr symbol library file \"%s\"",
                 m_libFileName.GetFullPath() );
 
-    FILE_LINE_READER reader( m_libFileName.GetFullPath() );
+    WHOLE_FILE_LINE_READER reader( m_libFileName.GetFullPath() );
 
     SCH_SEXPR_PARSER parser( &reader );
 
@@ -83,6 +83,51 @@ public:
      */
     int m_coroutineStackSize;
 
+    /**
+     * Maximum number of worker threads in the shared thread pool (0 for one per core)
+     */
+    int m_maxWorkerThreads;
+
+    /**
+     * Time in ms the router may spend re-checking the DRC after each commit (0 to disable)
+     */
+    int m_realTimeDrcBudget;
+
+    /**
+     * Minimum number of contours (outlines, holes and knockouts) in a zone fill for its
+     * booleans to be split in tiles run in parallel (0 to always use a single pass)
+     */
+    int m_zoneFillPartitionContours;
+
+    /**
+     * Write a binary snapshot next to saved boards, and load boards from it while it
+     * matches the board file
+     */
+    bool m_boardSnapshots;
+
+    /**
+     * Minimum number of items to update at once for the view to draw their cached geometry
+     * in parallel (0 to always draw it in the GUI thread)
+     */
+    int m_parallelRecacheItems;
+
+    /**
+     * Size in pixels under which the view draws the items merged by screen tiles, as coarse
+     * shapes (0 to always draw the items one by one)
+     */
+    int m_lodPixelThreshold;
+
+    /**
+     * Show the state of the OpenGL vertex memory allocator in the display options
+     */
+    bool m_showVertexMemoryStats;
+
+    /**
+     * Draw the pads and vias of the same shape by instances of a single shape in the OpenGL
+     * canvas, when the graphics driver supports instanced drawing
+     */
+    bool m_shapeInstancing;
+
 
 private:
     ADVANCED_CFG();
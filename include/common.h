@@ -48,123 +48,13 @@
 #include <memory>
 #include <type_traits>
 #include <typeinfo>
-#include <boost/uuid/uuid.hpp>
+
+#include <kiid.h>
 
 class PROJECT;
 class SEARCH_STACK;
 class REPORTER;
 
-/**
- * timestamp_t is our type to represent unique IDs for all kinds of elements;
- * historically simply the timestamp when they were created.
- *
- * Long term, this type might be renamed to something like unique_id_t
- * (and then rename all the methods from {Get,Set}TimeStamp()
- * to {Get,Set}Id()) ?
- */
-typedef uint32_t timestamp_t;
-
-class KIID
-{
-public:
-    KIID();
-    KIID( int null );
-    KIID( const wxString& aString );
-    KIID( timestamp_t aTimestamp );
-
-    void Clone( const KIID& aUUID );
-
-    size_t Hash() const;
-
-    bool IsLegacyTimestamp() const;
-    timestamp_t AsLegacyTimestamp() const;
-
-    wxString AsString() const;
-    wxString AsLegacyTimestampString() const;
-
-    bool operator==( KIID const& rhs) const
-    {
-        return m_uuid == rhs.m_uuid;
-    }
-
-    bool operator!=( KIID const& rhs) const
-    {
-        return m_uuid != rhs.m_uuid;
-    }
-
-    bool operator<( KIID const& rhs) const
-    {
-        return m_uuid < rhs.m_uuid;
-    }
-
-private:
-    boost::uuids::uuid m_uuid;
-
-    timestamp_t        m_cached_timestamp;
-};
-
-
-extern KIID niluuid;
-
-
-class KIID_PATH : public std::vector<KIID>
-{
-public:
-    KIID_PATH()
-    {}
-
-    KIID_PATH( const wxString& aString )
-    {
-        for( const wxString& pathStep : wxSplit( aString, '/' ) )
-        {
-            if( !pathStep.empty() )
-                emplace_back( KIID( pathStep ) );
-        }
-    }
-
-    wxString AsString() const
-    {
-        wxString path;
-
-        for( const KIID& pathStep : *this )
-            path += '/' + pathStep.AsString();
-
-        return path;
-    }
-
-    bool operator==( KIID_PATH const& rhs) const
-    {
-        if( size() != rhs.size() )
-            return false;
-
-        for( size_t i = 0; i < size(); ++i )
-        {
-            if( at( i ) != rhs.at( i ) )
-                return false;
-        }
-
-        return true;
-    }
-
-    bool operator<( KIID_PATH const& rhs) const
-    {
-        if( size() != rhs.size() )
-            return size() < rhs.size();
-
-        for( size_t i = 0; i < size(); ++i )
-        {
-            if( at( i ) < rhs.at( i ) )
-                return true;
-
-            if( at( i ) != rhs.at( i ) )
-                return false;
-        }
-
-        return false;
-    }
-};
-
-
 /// default name for nameless projects
 #define NAMELESS_PROJECT wxT( "noname" )
 
@@ -312,6 +202,14 @@ const wxString PrePendPath( const wxString& aEnvVar, const wxString& aPriorityPa
  */
 const wxString ExpandEnvVarSubstitutions( const wxString& aString, PROJECT* aProject );
 
+/**
+ * Return the user cache path, where KiCad keeps data it can regenerate (footprint library
+ * indexes...): ~/Library/Caches/kicad/ on OSX, ${XDG_CACHE_HOME}/kicad/ or ~/.cache/kicad/
+ * on Linux and AppData\Local\kicad\ on MSWin.  The path ends with a separator; it is not
+ * created here.
+ */
+wxString GetUserCachePath();
+
 /**
  * Expand '${var-name}' templates in text.  The LocalResolver is given first crack at it,
  * after which the PROJECT's resolver is called.
@@ -118,13 +118,11 @@ protected:
     {
         if( reader )
         {
-            reader->ReadLine();
+            unsigned len;
 
-            unsigned len = reader->Length();
-
-            // start may have changed in ReadLine(), which can resize and
-            // relocate reader's line buffer.
-            start = reader->Line();
+            // Readers holding the whole text in memory don't copy the line: we only
+            // scan it between start and limit, and fetch a copy for error messages.
+            start = reader->ReadLineInPlace( &len );
 
             next  = start;
             limit = next + len;
@@ -225,6 +223,18 @@ public:
      */
     bool SyncLineReaderWith( DSNLEXER& aLexer );
 
+    /**
+     * Function CaptureList
+     * copies the text of the list whose opening parenthesis and keyword were just read, up
+     * to its closing parenthesis, without tokenizing it.  Another lexer can then tokenize
+     * the text later, or on another thread.  Afterwards the current token is that closing
+     * DSN_RIGHT.  Not available in specctra mode.
+     *
+     * @param aText receives the text of the list, starting with the parenthesis and keyword.
+     * @throw IO_ERROR if the list is not closed before the end of the input.
+     */
+    void CaptureList( std::string* aText );
+
     /**
      * Function SetSpecctraMode
      * changes the behavior of this lexer into or out of "specctra mode".  If
@@ -516,7 +526,7 @@ public:
      */
     const char* CurLine()
     {
-        return (const char*)(*reader);
+        return reader->FetchLine();
     }
 
     /**
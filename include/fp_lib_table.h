@@ -205,6 +205,19 @@ public:
      */
     const MODULE* GetEnumeratedFootprint( const wxString& aNickname,
                                           const wxString& aFootprintName );
+
+    /**
+     * Function GetEnumeratedFootprintInfo
+     *
+     * fetches the description, keywords and pad counts of a footprint found by a previous
+     * FootprintEnumerate() from the library index, if the library plugin keeps one.
+     *
+     * @return false if there is no index entry for the footprint.
+     */
+    bool GetEnumeratedFootprintInfo( const wxString& aNickname, const wxString& aFootprintName,
+                                     wxString* aDescription, wxString* aKeywords,
+                                     unsigned* aPadCount, unsigned* aUniquePadCount );
+
     /**
      * Enum SAVE_T
      * is the set of return values from FootprintSave() below.
@@ -93,6 +93,10 @@ public:
     virtual void DrawPolyline( const VECTOR2D aPointList[], int aListSize ) override { drawPoly( aPointList, aListSize ); }
     virtual void DrawPolyline( const SHAPE_LINE_CHAIN& aLineChain ) override { drawPoly( aLineChain ); }
 
+    /// @copydoc GAL::DrawPolylines()
+    virtual void DrawPolylines( const std::vector<VECTOR2D>& aPoints,
+                                const std::vector<unsigned int>& aStarts ) override;
+
     /// @copydoc GAL::DrawPolygon()
     virtual void DrawPolygon( const std::deque<VECTOR2D>& aPointList ) override { drawPoly( aPointList ); }
     virtual void DrawPolygon( const VECTOR2D aPointList[], int aListSize ) override { drawPoly( aPointList, aListSize ); }
@@ -62,6 +62,45 @@ namespace KIGFX
         BEST,
     };
 
+    /**
+     * VERTEX_MEMORY_STATS: State of the allocator of the cached vertex memory of a GAL, for
+     * debugging and tuning. Sizes are in bytes.
+     */
+    struct VERTEX_MEMORY_STATS
+    {
+        VERTEX_MEMORY_STATS() :
+            m_reserved( 0 ), m_slabs( 0 ), m_inUse( 0 ), m_slabCount( 0 ), m_resizes( 0 ),
+            m_compactions( 0 )
+        {}
+
+        /**
+         * Returns the part of the memory handed out by the allocator which does not hold vertex
+         * data, that is the unused ends of the blocks and the free blocks of the slabs.
+         */
+        double Fragmentation() const
+        {
+            return m_slabs > 0 ? 1.0 - (double) m_inUse / m_slabs : 0.0;
+        }
+
+        ///> Size of the vertex buffer
+        unsigned long long m_reserved;
+
+        ///> Size of the slabs and large blocks taken from the vertex buffer
+        unsigned long long m_slabs;
+
+        ///> Size of the stored vertices
+        unsigned long long m_inUse;
+
+        ///> Number of slabs and large blocks
+        int m_slabCount;
+
+        ///> Number of times the vertex buffer has grown
+        int m_resizes;
+
+        ///> Number of slabs emptied by moving their blocks to other slabs
+        int m_compactions;
+    };
+
     class GAL_DISPLAY_OPTIONS;
 
     class GAL_DISPLAY_OPTIONS_OBSERVER
@@ -133,6 +172,9 @@ namespace KIGFX
 
         ///> The pixel scale factor (>1 for hi-DPI scaled displays)
         double m_scaleFactor;
+
+        ///> Vertex memory state of the last GAL updated, not an option (OpenGL only)
+        VERTEX_MEMORY_STATS m_vertexMemory;
     };
 
 }
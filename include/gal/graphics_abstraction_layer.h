@@ -30,6 +30,8 @@
 #include <deque>
 #include <stack>
 #include <limits>
+#include <memory>
+#include <vector>
 
 #include <math/matrix3x3.h>
 
@@ -37,6 +39,7 @@
 #include <gal/definitions.h>
 #include <gal/stroke_font.h>
 #include <gal/gal_display_options.h>
+#include <gal/shape_instance_key.h>
 #include <newstroke_font.h>
 
 class SHAPE_LINE_CHAIN;
@@ -115,6 +118,16 @@ public:
     virtual void DrawPolyline( const VECTOR2D aPointList[], int aListSize ) {};
     virtual void DrawPolyline( const SHAPE_LINE_CHAIN& aLineChain ) {};
 
+    /**
+     * @brief Draw several polylines at once, e.g. the strokes of a text.
+     *
+     * @param aPoints are the points of all the polylines, one polyline after the other.
+     * @param aStarts are the indices in aPoints of the first point of each polyline: a polyline
+     * ends where the next one starts, the last one at the end of aPoints.
+     */
+    virtual void DrawPolylines( const std::vector<VECTOR2D>& aPoints,
+                                const std::vector<unsigned int>& aStarts );
+
     /**
      * @brief Draw a circle using world coordinates.
      *
@@ -604,6 +617,80 @@ public:
      */
     virtual void ClearCache() {};
 
+    /**
+     * @brief Create a GAL making groups in its own memory, so items can be cached in other
+     * threads than the one drawing with this GAL. The groups are then moved to this GAL
+     * with AdoptGroup().
+     *
+     * The new GAL uses the current world <-> screen transformation of this GAL, it does not
+     * draw anything on screen and it is to be used by a single thread at a time.
+     *
+     * @return the new GAL, or nullptr if this GAL does not support it.
+     */
+    virtual std::unique_ptr<GAL> CreateWorkerGal() { return nullptr; }
+
+    /**
+     * @brief Move a group made by a GAL returned by CreateWorkerGal() to this GAL.
+     *
+     * @param aWorker is the GAL which made the group.
+     * @param aGroupNumber is the group number in aWorker.
+     * @return the number of the new group, or -1 if the group could not be moved (e.g. it
+     * draws what the worker could not) and it has to be drawn again by this GAL.
+     */
+    virtual int AdoptGroup( GAL* aWorker, int aGroupNumber ) { return -1; }
+
+    // --------------------------------------------
+    // Shape instances
+    // --------------------------------------------
+
+    /**
+     * @brief Tells if this GAL can draw instances of shapes, i.e. store a shape drawn many
+     * times once and then only the position, rotation and color of each copy (e.g. the
+     * pads of the same size on a board).
+     *
+     * A shape is identified by a key made by the caller from its geometry. It is drawn
+     * once between BeginShapeInstance() and EndShapeInstance(), around the origin, in white:
+     * the color of an instance multiplies the colors of its shape.
+     */
+    virtual bool IsShapeInstancingEnabled() const { return false; }
+
+    /**
+     * @brief Tells if the shape of a key was drawn since the last ClearCache().
+     *
+     * @param aKey is the key of the shape.
+     */
+    virtual bool HasShapeInstance( const SHAPE_INSTANCE_KEY& aKey ) const { return false; }
+
+    /**
+     * @brief Begins drawing a shape: until EndShapeInstance(), the drawing methods draw the
+     * shape of aKey instead of drawing on the current target.
+     *
+     * @param aKey is the key of the shape.
+     * @return false if this GAL does not draw instances of shapes; nothing is recorded then.
+     */
+    virtual bool BeginShapeInstance( const SHAPE_INSTANCE_KEY& aKey ) { return false; }
+
+    /**
+     * @brief Ends drawing a shape started with BeginShapeInstance().
+     */
+    virtual void EndShapeInstance() {}
+
+    /**
+     * @brief Draws an instance of a shape on the current target (or in the current group).
+     *
+     * @param aKey is the key of the shape.
+     * @param aPosition is where the origin of the shape is drawn.
+     * @param aRotation is the rotation of the shape around its origin (in radians, as with
+     * Rotate()).
+     * @param aColor multiplies the colors of the shape.
+     * @return false if there is no shape for aKey; nothing is drawn then.
+     */
+    virtual bool DrawShapeInstance( const SHAPE_INSTANCE_KEY& aKey, const VECTOR2D& aPosition,
+                                    double aRotation, const COLOR4D& aColor )
+    {
+        return false;
+    }
+
     // --------------------------------------------------------
     // Handling the world <-> screen transformation
     // --------------------------------------------------------
@@ -1116,6 +1203,9 @@ protected:
     /// Private: use GAL_DRAWING_CONTEXT RAII object
     virtual void endDrawing() {};
 
+    /// Copy the world <-> screen transformation and the depth range of another GAL
+    void copyViewSettings( const GAL& aGal );
+
     /// Compute the scaling factor for the world->screen matrix
     inline void computeWorldScale()
     {
@@ -26,8 +26,8 @@
 #define CACHED_CONTAINER_H_
 
 #include <gal/opengl/vertex_container.h>
-#include <map>
-#include <set>
+#include <gal/gal_display_options.h>
+#include <vector>
 
 namespace KIGFX
 {
@@ -38,6 +38,12 @@ class SHADER;
  * @brief Class to store VERTEX instances with caching. It associates VERTEX
  * objects and with VERTEX_ITEMs. Caching vertices data in the memory and a
  * enables fast reuse of that data.
+ *
+ * The container is split in pages. A page is either a slab holding blocks of a single size
+ * class, or a part of a run of pages holding a single large item. Item offsets do not change
+ * when the container grows, and freeing an item never requires merging free space, so the
+ * container is never defragmented as a whole. Slabs left mostly empty are compacted a few at
+ * a time by Compact(), at the end of each update.
  */
 
 class CACHED_CONTAINER : public VERTEX_CONTAINER
@@ -82,19 +88,53 @@ public:
     ///> @copydoc VERTEX_CONTAINER::Unmap()
     virtual void Unmap() override = 0;
 
+    /**
+     * Releases the empty slabs and moves the blocks of the emptiest slabs to the free blocks of
+     * the other slabs of their size class, until about aMaxVertices vertices have been moved.
+     * The container has to be mapped and no item may be edited.
+     */
+    void Compact( unsigned int aMaxVertices = COMPACTION_BUDGET );
+
+    /**
+     * Returns the state of the allocator.
+     */
+    VERTEX_MEMORY_STATS GetStats() const;
+
 protected:
-    ///> Maps size of free memory chunks to their offsets
-    typedef std::pair<unsigned int, unsigned int> CHUNK;
-    typedef std::multimap<unsigned int, unsigned int> FREE_CHUNK_MAP;
+    ///> Page size, expressed in vertices
+    static constexpr unsigned int PAGE_SIZE = 16384;
 
-    /// List of all the stored items
-    typedef std::set<VERTEX_ITEM*> ITEMS;
+    ///> Default number of vertices moved by Compact()
+    static constexpr unsigned int COMPACTION_BUDGET = 4 * PAGE_SIZE;
 
-    ///> Stores size & offset of free chunks.
-    FREE_CHUNK_MAP  m_freeChunks;
+    ///> Values of PAGE::m_class for the pages which are not slabs
+    static constexpr int FREE_PAGE  = -1;
+    static constexpr int LARGE_PAGE = -2;
 
-    ///> Stored VERTEX_ITEMs
-    ITEMS m_items;
+    struct PAGE
+    {
+        PAGE() :
+            m_class( FREE_PAGE ), m_used( 0 )
+        {}
+
+        ///> Size class of the slab, or FREE_PAGE, or LARGE_PAGE
+        int m_class;
+
+        ///> Number of blocks in use, or number of pages in the run for the first page of a run
+        unsigned int m_used;
+
+        ///> Indices of the free blocks of a slab
+        std::vector<unsigned int> m_freeBlocks;
+
+        ///> Items stored in the blocks of a slab, or in the run starting at this page
+        std::vector<VERTEX_ITEM*> m_owners;
+    };
+
+    ///> Pages of the container
+    std::vector<PAGE> m_pages;
+
+    ///> Slabs having free blocks, for each size class
+    std::vector<std::vector<unsigned int>> m_partialSlabs;
 
     ///> Currently modified item
     VERTEX_ITEM* m_item;
@@ -106,6 +146,13 @@ protected:
     ///> Maximal vertex index number stored in the container
     unsigned int m_maxIndex;
 
+    ///> Number of vertices stored by the items
+    unsigned int m_storedVertices;
+
+    ///> Allocator counters reported by GetStats()
+    int m_resizes;
+    int m_compactions;
+
     /**
      * Resizes the chunk that stores the current item to the given size. The current item has
      * its offset adjusted after the call, and the new chunk parameters are stored
@@ -117,55 +164,50 @@ protected:
     bool reallocate( unsigned int aSize );
 
     /**
-     * Removes empty spaces between chunks and optionally resizes the container.
-     * After the operation there is continous space for storing vertices at the end of the container.
+     * Resizes the container, keeping the vertices at their offsets. Only the first m_maxIndex
+     * vertices have to be copied.
      *
      * @param aNewSize is the new size of container, expressed in number of vertices
      * @return false in case of failure (e.g. memory shortage)
      */
-    virtual bool defragmentResize( unsigned int aNewSize ) = 0;
+    virtual bool resize( unsigned int aNewSize ) = 0;
 
     /**
-     * Transfers all stored data to a new buffer, removing empty spaces between the data chunks
-     * in the container.
-     * @param aTarget is the destination for the defragmented data.
+     * Returns the size class of blocks able to store aSize vertices, or -1 if the item has to
+     * be stored in a run of pages.
      */
-    void defragment( VERTEX* aTarget );
+    static int sizeClass( unsigned int aSize );
 
-    /**
-     * Looks for consecutive free memory chunks and merges them, decreasing fragmentation of
-     * memory.
-     */
-    void mergeFreeChunks();
+    ///> Returns the block size of a size class
+    static unsigned int blockSize( int aClass );
 
     /**
-     * Returns the size of a chunk.
-     *
-     * @param aChunk is the chunk.
+     * Takes a block (or a run of pages) for at least aSize vertices, growing the container if
+     * needed, and records aOwner as the item stored there.
+     * @return the offset of the block, or -1 in case of failure.
      */
-    inline int getChunkSize( const CHUNK& aChunk ) const
-    {
-        return aChunk.first;
-    }
+    int allocateChunk( unsigned int aSize, VERTEX_ITEM* aOwner );
 
-    /**
-     * Returns the offset of a chunk.
-     *
-     * @param aChunk is the chunk.
-     */
-    inline unsigned int getChunkOffset( const CHUNK& aChunk ) const
-    {
-        return aChunk.second;
-    }
+    ///> Returns the block (or the run of pages) at aOffset to the free space
+    void freeChunk( unsigned int aOffset );
+
+    ///> Returns the number of vertices the chunk at aOffset can hold
+    unsigned int chunkCapacity( unsigned int aOffset ) const;
 
     /**
-     * Adds a chunk marked as a free space.
+     * Returns the index of the first page of a run of aCount free pages, growing the container
+     * if needed, or -1 in case of failure.
      */
-    void addFreeChunk( unsigned int aOffset, unsigned int aSize );
+    int allocatePages( unsigned int aCount );
+
+    ///> Marks a slab or a run of pages as free
+    void freePages( unsigned int aFirst, unsigned int aCount );
+
+    ///> Updates m_maxIndex to the end of the last page in use
+    void updateMaxIndex();
 
 private:
     /// Debug & test functions
-    void showFreeChunks();
     void showUsedChunks();
     void test();
 };
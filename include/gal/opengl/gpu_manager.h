@@ -27,6 +27,9 @@
 
 #include <gal/opengl/vertex_common.h>
 #include <boost/scoped_array.hpp>
+#include <functional>
+#include <utility>
+#include <vector>
 
 namespace KIGFX
 {
@@ -123,6 +126,15 @@ public:
     ///> @copydoc GPU_MANAGER::EndDrawing()
     virtual void EndDrawing() override;
 
+    /**
+     * Function AddDrawBreak()
+     * Splits the indices drawn so far from the next ones: EndDrawing() draws them, calls
+     * aHandler and only then draws the next ones.  It lets other draw calls keep the order
+     * of the items.
+     * @param aHandler draws what goes between both parts.
+     */
+    void AddDrawBreak( std::function<void()> aHandler );
+
     ///> Maps vertex buffer stored in GPU memory.
     void Map();
 
@@ -133,6 +145,9 @@ protected:
     ///> Resizes the indices buffer to aNewSize if necessary
     void resizeIndices( unsigned int aNewSize );
 
+    ///> Draws the indices in [aBegin, aEnd) of the indices buffer
+    void drawIndices( unsigned int aBegin, unsigned int aEnd );
+
     ///> Buffers initialization flag
     bool m_buffersInitialized;
 
@@ -150,6 +165,9 @@ protected:
 
     ///> Current indices buffer size
     unsigned int m_indicesCapacity;
+
+    ///> Number of indices drawn before each break, and the handler of the break
+    std::vector<std::pair<unsigned int, std::function<void()>>> m_drawBreaks;
 };
 
 
@@ -43,6 +43,7 @@
 #include <unordered_map>
 #include <boost/smart_ptr/shared_array.hpp>
 #include <memory>
+#include <vector>
 
 #ifndef CALLBACK
 #define CALLBACK
@@ -56,51 +57,20 @@ class SHADER;
 class GL_BITMAP_CACHE;
 
 /**
- * @brief Class OpenGL_GAL is the OpenGL implementation of the Graphics Abstraction Layer.
+ * @brief Class OPENGL_GAL_BASE turns the drawing calls into vertices stored by a VERTEX_MANAGER.
  *
- * This is a direct OpenGL-implementation and uses low-level graphics primitives like triangles
- * and quads. The purpose is to provide a fast graphics interface, that takes advantage of modern
- * graphics card GPUs. All methods here benefit thus from the hardware acceleration.
+ * It is the part of the OpenGL GAL which needs no OpenGL context, so it can also work outside
+ * of the GUI thread (see OPENGL_WORKER_GAL).
  */
-class OPENGL_GAL : public GAL, public HIDPI_GL_CANVAS
+class OPENGL_GAL_BASE : public GAL
 {
 public:
-    /**
-     * @brief Constructor OPENGL_GAL
-     *
-     * @param aParent is the wxWidgets immediate wxWindow parent of this object.
-     *
-     * @param aMouseListener is the wxEvtHandler that should receive the mouse events,
-     *  this can be can be any wxWindow, but is often a wxFrame container.
-     *
-     * @param aPaintListener is the wxEvtHandler that should receive the paint
-     *  event.  This can be any wxWindow, but is often a derived instance
-     *  of this class or a containing wxFrame.  The "paint event" here is
-     *  a wxCommandEvent holding EVT_GAL_REDRAW, as sent by PostPaint().
-     *
-     * @param aName is the name of this window for use by wxWindow::FindWindowByName()
-     */
-    OPENGL_GAL( GAL_DISPLAY_OPTIONS& aDisplayOptions, wxWindow* aParent,
-                wxEvtHandler* aMouseListener = nullptr, wxEvtHandler* aPaintListener = nullptr,
-                const wxString& aName = wxT( "GLCanvas" ) );
+    OPENGL_GAL_BASE( GAL_DISPLAY_OPTIONS& aDisplayOptions );
 
-    virtual ~OPENGL_GAL();
+    virtual ~OPENGL_GAL_BASE();
 
     virtual bool IsOpenGlEngine() override { return true; }
 
-    /// @copydoc GAL::IsInitialized()
-    virtual bool IsInitialized() const override
-    {
-        // is*Initialized flags, but it is enough for OpenGL to show up
-        return IsShownOnScreen() && !GetClientRect().IsEmpty();
-    }
-
-    ///> @copydoc GAL::IsVisible()
-    bool IsVisible() const override
-    {
-        return IsShownOnScreen() && !GetClientRect().IsEmpty();
-    }
-
     // ---------------
     // Drawing methods
     // ---------------
@@ -131,6 +101,10 @@ public:
     virtual void DrawPolyline( const VECTOR2D aPointList[], int aListSize ) override;
     virtual void DrawPolyline( const SHAPE_LINE_CHAIN& aLineChain ) override;
 
+    /// @copydoc GAL::DrawPolylines()
+    virtual void DrawPolylines( const std::vector<VECTOR2D>& aPoints,
+                                const std::vector<unsigned int>& aStarts ) override;
+
     /// @copydoc GAL::DrawPolygon()
     virtual void DrawPolygon( const std::deque<VECTOR2D>& aPointList ) override;
     virtual void DrawPolygon( const VECTOR2D aPointList[], int aListSize ) override;
@@ -142,13 +116,292 @@ public:
                             const VECTOR2D& controlPointB, const VECTOR2D& endPoint,
                             double aFilterValue = 0.0 ) override;
 
-    /// @copydoc GAL::DrawBitmap()
-    virtual void DrawBitmap( const BITMAP_BASE& aBitmap ) override;
-
     /// @copydoc GAL::BitmapText()
     virtual void BitmapText( const wxString& aText, const VECTOR2D& aPosition,
                              double aRotationAngle ) override;
 
+    // --------------
+    // Transformation
+    // --------------
+
+    /// @copydoc GAL::Rotate()
+    virtual void Rotate( double aAngle ) override;
+
+    /// @copydoc GAL::Translate()
+    virtual void Translate( const VECTOR2D& aTranslation ) override;
+
+    /// @copydoc GAL::Scale()
+    virtual void Scale( const VECTOR2D& aScale ) override;
+
+    /// @copydoc GAL::Save()
+    virtual void Save() override;
+
+    /// @copydoc GAL::Restore()
+    virtual void Restore() override;
+
+    // ---------------
+    // Shape instances
+    // ---------------
+
+    /// @copydoc GAL::IsShapeInstancingEnabled()
+    virtual bool IsShapeInstancingEnabled() const override
+    {
+        return m_shapeInstancing;
+    }
+
+    /// @copydoc GAL::HasShapeInstance()
+    virtual bool HasShapeInstance( const SHAPE_INSTANCE_KEY& aKey ) const override;
+
+    /// @copydoc GAL::BeginShapeInstance()
+    virtual bool BeginShapeInstance( const SHAPE_INSTANCE_KEY& aKey ) override;
+
+    /// @copydoc GAL::EndShapeInstance()
+    virtual void EndShapeInstance() override;
+
+    /// @copydoc GAL::DrawShapeInstance()
+    virtual bool DrawShapeInstance( const SHAPE_INSTANCE_KEY& aKey, const VECTOR2D& aPosition,
+                                    double aRotation, const COLOR4D& aColor ) override;
+
+    ///< Parameters passed to the GLU tesselator
+    typedef struct
+    {
+        /// Manager used for storing new vertices
+        VERTEX_MANAGER* vboManager;
+
+        /// Intersect points, that have to be freed after tessellation
+        std::deque< boost::shared_array<GLdouble> >& intersectPoints;
+    } TessParams;
+
+    ///< A shape drawn by instances
+    struct INSTANCED_SHAPE
+    {
+        SHAPE_INSTANCE_KEY  m_key;
+        std::vector<VERTEX> m_vertices;     ///< Triangles of the shape, around the origin
+    };
+
+    ///< An instance of a shape, laid out as the shader attributes of the instance
+    struct SHAPE_INSTANCE
+    {
+        GLfloat     m_x, m_y;       ///< Position of the origin of the shape
+        GLfloat     m_depth;        ///< Added to the depth of the vertices of the shape
+        GLfloat     m_angle;        ///< Rotation around the origin of the shape
+        GLubyte     m_color[4];     ///< Multiplies the colors of the shape
+        int         m_shape;        ///< Index of the shape in m_shapes
+    };
+
+protected:
+    static const int    CIRCLE_POINTS   = 64;   ///< The number of points for circle approximation
+    static const int    CURVE_POINTS    = 32;   ///< The number of points for curve approximation
+
+    VERTEX_MANAGER*         currentManager;         ///< Currently used VERTEX_MANAGER (for storing VERTEX_ITEMs)
+
+    // Shape instances
+    bool                    m_shapeInstancing;      ///< Are shapes drawn by instances?
+    bool                    m_shapesChanged;        ///< Were shapes added since the last upload?
+    std::vector<INSTANCED_SHAPE>      m_shapes;         ///< Shapes drawn by instances
+    std::unordered_map<SHAPE_INSTANCE_KEY, int, SHAPE_INSTANCE_KEY::HASH>
+                            m_shapeIndices;         ///< Index in m_shapes of a key
+
+    /// Stores the shape drawn between BeginShapeInstance() and EndShapeInstance()
+    std::unique_ptr<VERTEX_MANAGER> m_shapeManager;
+    VERTEX_MANAGER*         m_shapeSavedManager;    ///< currentManager while drawing a shape
+    double                  m_shapeSavedDepth;      ///< layerDepth while drawing a shape
+    SHAPE_INSTANCE_KEY      m_shapeKey;             ///< Key of the shape being drawn
+
+    // Polygon tesselation
+    /// The tessellator
+    GLUtesselator*          tesselator;
+    /// Storage for intersecting points
+    std::deque< boost::shared_array<GLdouble> > tessIntersects;
+
+    /**
+     * @brief Draw a quad for the line.
+     *
+     * @param aStartPoint is the start point of the line.
+     * @param aEndPoint is the end point of the line.
+     * @param aReserve tells if the vertices have to be reserved, false if the caller has
+     * already reserved them (for many lines at once).
+     */
+    void drawLineQuad( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint,
+                       bool aReserve = true );
+
+    /**
+     * @brief Draw a semicircle. Depending on settings (isStrokeEnabled & isFilledEnabled) it runs
+     * the proper function (drawStrokedSemiCircle or drawFilledSemiCircle).
+     *
+     * @param aCenterPoint is the center point.
+     * @param aRadius is the radius of the semicircle.
+     * @param aAngle is the angle of the semicircle.
+     *
+     */
+    void drawSemiCircle( const VECTOR2D& aCenterPoint, double aRadius, double aAngle );
+
+    /**
+     * @brief Draw a filled semicircle.
+     *
+     * @param aCenterPoint is the center point.
+     * @param aRadius is the radius of the semicircle.
+     * @param aAngle is the angle of the semicircle.
+     *
+     */
+    void drawFilledSemiCircle( const VECTOR2D& aCenterPoint, double aRadius, double aAngle );
+
+    /**
+     * @brief Draw a stroked semicircle.
+     *
+     * @param aCenterPoint is the center point.
+     * @param aRadius is the radius of the semicircle.
+     * @param aAngle is the angle of the semicircle.
+     *
+     */
+    void drawStrokedSemiCircle( const VECTOR2D& aCenterPoint, double aRadius, double aAngle );
+
+    /**
+     * @brief Generic way of drawing a polyline stored in different containers.
+     * @param aPointGetter is a function to obtain coordinates of n-th vertex.
+     * @param aPointCount is the number of points to be drawn.
+     */
+    void drawPolyline( const std::function<VECTOR2D (int)>& aPointGetter, int aPointCount );
+
+    /**
+     * @brief Draws a filled polygon. It does not need the last point to have the same coordinates
+     * as the first one.
+     * @param aPoints is the vertices data (3 coordinates: x, y, z).
+     * @param aPointCount is the number of points.
+     */
+    void drawPolygon( GLdouble* aPoints, int aPointCount );
+
+    /**
+     * @brief Draws a set of polygons with a cached triangulation. Way faster than drawPolygon.
+     */
+    void drawTriangulatedPolyset( const SHAPE_POLY_SET& aPoly );
+
+
+    /**
+     * @brief Draws a single character using bitmap font.
+     * Its main purpose is to be used in BitmapText() function.
+     *
+     * @param aChar is the character to be drawn.
+     * @return Width of the drawn glyph.
+     */
+    int drawBitmapChar( unsigned long aChar );
+
+    /**
+     * @brief Draws an overbar over the currently drawn text.
+     * Its main purpose is to be used in BitmapText() function.
+     * This method requires appropriate scaling to be applied (as is done in BitmapText() function).
+     * The current X coordinate will be the overbar ending.
+     *
+     * @param aLength is the width of the overbar.
+     * @param aHeight is the height for the overbar.
+     */
+    void drawBitmapOverbar( double aLength, double aHeight );
+
+    /**
+     * @brief Computes a size of text drawn using bitmap font with current text setting applied.
+     *
+     * @param aText is the text to be drawn.
+     * @return Pair containing text bounding box and common Y axis offset. The values are expressed
+     * as a number of pixels on the bitmap font texture and need to be scaled before drawing.
+     */
+    std::pair<VECTOR2D, float> computeBitmapTextSize( const UTF8& aText ) const;
+
+    /**
+     * @brief Adds a shape, unless there is already one for its key.
+     *
+     * @return the index of the shape of aKey in m_shapes.
+     */
+    int addShape( const SHAPE_INSTANCE_KEY& aKey, const VERTEX* aVertices,
+                  unsigned int aSize );
+
+    /**
+     * @brief Deletes all the shapes.
+     */
+    void clearShapes();
+
+    /**
+     * @brief Keeps an instance in the current group, to draw it with instanced draw calls.
+     *
+     * @return false if the instance is not kept, it is then drawn by expandShapeInstance().
+     */
+    virtual bool storeShapeInstance( const SHAPE_INSTANCE& aInstance ) { return false; }
+
+    /**
+     * @brief Draws an instance made by another GAL (see AdoptGroup()).
+     *
+     * @param aInstance is the instance.
+     * @param aShapes are the shapes of the other GAL.
+     */
+    void adoptShapeInstance( const SHAPE_INSTANCE& aInstance,
+                             const std::vector<INSTANCED_SHAPE>& aShapes );
+
+    /**
+     * @brief Draws the triangles of a shape instance with the current VERTEX_MANAGER.
+     *
+     * @param aInstance is the instance.
+     * @param aShapes are the shapes aInstance refers to.
+     */
+    void expandShapeInstance( const SHAPE_INSTANCE& aInstance,
+                              const std::vector<INSTANCED_SHAPE>& aShapes );
+
+    /**
+     * @brief Compute the angle step when drawing arcs/circles approximated with lines.
+     */
+    double calcAngleStep( double aRadius ) const
+    {
+        // Bigger arcs need smaller alpha increment to make them look smooth
+        return std::min( 1e6 / aRadius, 2.0 * M_PI / CIRCLE_POINTS );
+    }
+};
+
+
+/**
+ * @brief Class OpenGL_GAL is the OpenGL implementation of the Graphics Abstraction Layer.
+ *
+ * This is a direct OpenGL-implementation and uses low-level graphics primitives like triangles
+ * and quads. The purpose is to provide a fast graphics interface, that takes advantage of modern
+ * graphics card GPUs. All methods here benefit thus from the hardware acceleration.
+ */
+class OPENGL_GAL : public OPENGL_GAL_BASE, public HIDPI_GL_CANVAS
+{
+public:
+    /**
+     * @brief Constructor OPENGL_GAL
+     *
+     * @param aParent is the wxWidgets immediate wxWindow parent of this object.
+     *
+     * @param aMouseListener is the wxEvtHandler that should receive the mouse events,
+     *  this can be can be any wxWindow, but is often a wxFrame container.
+     *
+     * @param aPaintListener is the wxEvtHandler that should receive the paint
+     *  event.  This can be any wxWindow, but is often a derived instance
+     *  of this class or a containing wxFrame.  The "paint event" here is
+     *  a wxCommandEvent holding EVT_GAL_REDRAW, as sent by PostPaint().
+     *
+     * @param aName is the name of this window for use by wxWindow::FindWindowByName()
+     */
+    OPENGL_GAL( GAL_DISPLAY_OPTIONS& aDisplayOptions, wxWindow* aParent,
+                wxEvtHandler* aMouseListener = nullptr, wxEvtHandler* aPaintListener = nullptr,
+                const wxString& aName = wxT( "GLCanvas" ) );
+
+    virtual ~OPENGL_GAL();
+
+    /// @copydoc GAL::IsInitialized()
+    virtual bool IsInitialized() const override
+    {
+        // is*Initialized flags, but it is enough for OpenGL to show up
+        return IsShownOnScreen() && !GetClientRect().IsEmpty();
+    }
+
+    ///> @copydoc GAL::IsVisible()
+    bool IsVisible() const override
+    {
+        return IsShownOnScreen() && !GetClientRect().IsEmpty();
+    }
+
+    /// @copydoc GAL::DrawBitmap()
+    virtual void DrawBitmap( const BITMAP_BASE& aBitmap ) override;
+
     /// @copydoc GAL::DrawGrid()
     virtual void DrawGrid() override;
 
@@ -175,20 +428,12 @@ public:
     /// @copydoc GAL::Transform()
     virtual void Transform( const MATRIX3x3D& aTransformation ) override;
 
-    /// @copydoc GAL::Rotate()
-    virtual void Rotate( double aAngle ) override;
+    // -------------------
+    // Parameter setting
+    // -------------------
 
-    /// @copydoc GAL::Translate()
-    virtual void Translate( const VECTOR2D& aTranslation ) override;
-
-    /// @copydoc GAL::Scale()
-    virtual void Scale( const VECTOR2D& aScale ) override;
-
-    /// @copydoc GAL::Save()
-    virtual void Save() override;
-
-    /// @copydoc GAL::Restore()
-    virtual void Restore() override;
+    /// @copydoc GAL::SetLayerDepth()
+    virtual void SetLayerDepth( double aLayerDepth ) override;
 
     // --------------------------------------------
     // Group methods
@@ -215,6 +460,12 @@ public:
     /// @copydoc GAL::ClearCache()
     virtual void ClearCache() override;
 
+    /// @copydoc GAL::CreateWorkerGal()
+    virtual std::unique_ptr<GAL> CreateWorkerGal() override;
+
+    /// @copydoc GAL::AdoptGroup()
+    virtual int AdoptGroup( GAL* aWorker, int aGroupNumber ) override;
+
     // --------------------------------------------------------
     // Handling the world <-> screen transformation
     // --------------------------------------------------------
@@ -266,22 +517,9 @@ public:
 
     virtual void EnableDepthTest( bool aEnabled = false ) override;
 
-    ///< Parameters passed to the GLU tesselator
-    typedef struct
-    {
-        /// Manager used for storing new vertices
-        VERTEX_MANAGER* vboManager;
-
-        /// Intersect points, that have to be freed after tessellation
-        std::deque< boost::shared_array<GLdouble> >& intersectPoints;
-    } TessParams;
-
 private:
     /// Super class definition
-    typedef GAL super;
-
-    static const int    CIRCLE_POINTS   = 64;   ///< The number of points for circle approximation
-    static const int    CURVE_POINTS    = 32;   ///< The number of points for curve approximation
+    typedef OPENGL_GAL_BASE super;
 
     static wxGLContext*     glMainContext;      ///< Parent OpenGL context
     wxGLContext*            glPrivContext;      ///< Canvas-specific OpenGL context
@@ -295,7 +533,6 @@ private:
     typedef std::unordered_map< unsigned int, std::shared_ptr<VERTEX_ITEM> > GROUPS_MAP;
     GROUPS_MAP              groups;                 ///< Stores informations about VBO objects (groups)
     unsigned int            groupCounter;           ///< Counter used for generating keys for groups
-    VERTEX_MANAGER*         currentManager;         ///< Currently used VERTEX_MANAGER (for storing VERTEX_ITEMs)
     VERTEX_MANAGER*         cachedManager;          ///< Container for storing cached VERTEX_ITEMs
     VERTEX_MANAGER*         nonCachedManager;       ///< Container for storing non-cached VERTEX_ITEMs
     VERTEX_MANAGER*         overlayManager;         ///< Container for storing overlaid VERTEX_ITEMs
@@ -322,6 +559,20 @@ private:
     GLint                   ufm_screenPixelSize;
     GLint                   ufm_pixelSizeMultiplier;
 
+    // Shape instances
+    typedef std::unordered_map< unsigned int, std::vector<SHAPE_INSTANCE> > GROUP_INSTANCES_MAP;
+    GROUP_INSTANCES_MAP     m_groupInstances;       ///< Shape instances of the groups
+    int                     m_currentGroup;         ///< Number of the group being made
+    std::vector<SHAPE_INSTANCE> m_frameInstances;   ///< Instances of the groups drawn, by layer
+    size_t                  m_frameLayerStart;      ///< First instance of the current layer
+    std::vector<GLint>      m_shapeOffsets;         ///< First vertex of a shape in m_shapeBuffer
+    GLuint                  m_shapeBuffer;          ///< Vertices of the shapes
+    GLuint                  m_instanceBuffer;       ///< Instances of the shapes being drawn
+    GLint                   m_attrShaderParams;
+    GLint                   m_attrInstance;
+    GLint                   m_attrInstanceColor;
+    bool                    m_depthTest;            ///< See EnableDepthTest()
+
     std::unique_ptr<GL_BITMAP_CACHE>         bitmapCache;
 
     void lockContext( int aClientCookie ) override;
@@ -343,100 +594,32 @@ private:
     ///< Update handler for OpenGL settings
     bool updatedGalDisplayOptions( const GAL_DISPLAY_OPTIONS& aOptions ) override;
 
-    // Polygon tesselation
-    /// The tessellator
-    GLUtesselator*          tesselator;
-    /// Storage for intersecting points
-    std::deque< boost::shared_array<GLdouble> > tessIntersects;
-
-    /**
-     * @brief Draw a quad for the line.
-     *
-     * @param aStartPoint is the start point of the line.
-     * @param aEndPoint is the end point of the line.
-     */
-    void drawLineQuad( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint );
-
-    /**
-     * @brief Draw a semicircle. Depending on settings (isStrokeEnabled & isFilledEnabled) it runs
-     * the proper function (drawStrokedSemiCircle or drawFilledSemiCircle).
-     *
-     * @param aCenterPoint is the center point.
-     * @param aRadius is the radius of the semicircle.
-     * @param aAngle is the angle of the semicircle.
-     *
-     */
-    void drawSemiCircle( const VECTOR2D& aCenterPoint, double aRadius, double aAngle );
-
-    /**
-     * @brief Draw a filled semicircle.
-     *
-     * @param aCenterPoint is the center point.
-     * @param aRadius is the radius of the semicircle.
-     * @param aAngle is the angle of the semicircle.
-     *
-     */
-    void drawFilledSemiCircle( const VECTOR2D& aCenterPoint, double aRadius, double aAngle );
-
-    /**
-     * @brief Draw a stroked semicircle.
-     *
-     * @param aCenterPoint is the center point.
-     * @param aRadius is the radius of the semicircle.
-     * @param aAngle is the angle of the semicircle.
-     *
-     */
-    void drawStrokedSemiCircle( const VECTOR2D& aCenterPoint, double aRadius, double aAngle );
-
-    /**
-     * @brief Generic way of drawing a polyline stored in different containers.
-     * @param aPointGetter is a function to obtain coordinates of n-th vertex.
-     * @param aPointCount is the number of points to be drawn.
-     */
-    void drawPolyline( const std::function<VECTOR2D (int)>& aPointGetter, int aPointCount );
+    /// @copydoc OPENGL_GAL_BASE::storeShapeInstance()
+    bool storeShapeInstance( const SHAPE_INSTANCE& aInstance ) override;
 
     /**
-     * @brief Draws a filled polygon. It does not need the last point to have the same coordinates
-     * as the first one.
-     * @param aPoints is the vertices data (3 coordinates: x, y, z).
-     * @param aPointCount is the number of points.
+     * @brief Makes the cached manager draw the shape instances of the current layer once it
+     * has drawn the cached vertices of the groups drawn so far, so that the instances keep
+     * the layer order.
      */
-    void drawPolygon( GLdouble* aPoints, int aPointCount );
+    void breakShapeInstances();
 
     /**
-     * @brief Draws a set of polygons with a cached triangulation. Way faster than drawPolygon.
-     */
-    void drawTriangulatedPolyset( const SHAPE_POLY_SET& aPoly );
-
-
-    /**
-     * @brief Draws a single character using bitmap font.
-     * Its main purpose is to be used in BitmapText() function.
-     *
-     * @param aChar is the character to be drawn.
-     * @return Width of the drawn glyph.
+     * @brief Uploads the shapes and the instances of the groups drawn since beginDrawing().
      */
-    int drawBitmapChar( unsigned long aChar );
+    void uploadShapeInstances();
 
     /**
-     * @brief Draws an overbar over the currently drawn text.
-     * Its main purpose is to be used in BitmapText() function.
-     * This method requires appropriate scaling to be applied (as is done in BitmapText() function).
-     * The current X coordinate will be the overbar ending.
-     *
-     * @param aLength is the width of the overbar.
-     * @param aHeight is the height for the overbar.
+     * @brief Draws the uploaded shape instances in [aBegin, aEnd), sorted by shape, with one
+     * instanced draw call per shape.
      */
-    void drawBitmapOverbar( double aLength, double aHeight );
+    void drawShapeInstances( size_t aBegin, size_t aEnd );
 
     /**
-     * @brief Computes a size of text drawn using bitmap font with current text setting applied.
-     *
-     * @param aText is the text to be drawn.
-     * @return Pair containing text bounding box and common Y axis offset. The values are expressed
-     * as a number of pixels on the bitmap font texture and need to be scaled before drawing.
+     * @brief Sets the values of the instance attributes of the shader used by the draw calls
+     * which do not draw instances, so the shader draws their vertices as they are.
      */
-    std::pair<VECTOR2D, float> computeBitmapTextSize( const UTF8& aText ) const;
+    void resetInstanceAttributes();
 
     // Event handling
     /**
@@ -465,15 +648,6 @@ private:
      */
     unsigned int getNewGroupNumber();
 
-    /**
-     * @brief Compute the angle step when drawing arcs/circles approximated with lines.
-     */
-    double calcAngleStep( double aRadius ) const
-    {
-        // Bigger arcs need smaller alpha increment to make them look smooth
-        return std::min( 1e6 / aRadius, 2.0 * M_PI / CIRCLE_POINTS );
-    }
-
     double getWorldPixelSize() const;
 
     VECTOR2D getScreenPixelSize() const;
@@ -484,6 +658,115 @@ private:
      */
     void init();
 };
+
+
+/**
+ * @brief Class OPENGL_WORKER_GAL makes groups of vertices for an OPENGL_GAL without drawing
+ * them, so items can be cached by several threads at once (see GAL::CreateWorkerGal()).
+ *
+ * It needs neither a window nor an OpenGL context, and serves as well to run the painters
+ * without displaying anything, e.g. in benchmarks.
+ */
+class OPENGL_WORKER_GAL : public OPENGL_GAL_BASE
+{
+public:
+    /**
+     * @brief Constructor OPENGL_WORKER_GAL
+     *
+     * @param aDisplayOptions are the display options of the GAL.
+     * @param aParent is the GAL whose world <-> screen transformation is used, if any.
+     */
+    OPENGL_WORKER_GAL( GAL_DISPLAY_OPTIONS& aDisplayOptions, const GAL* aParent = nullptr );
+
+    virtual ~OPENGL_WORKER_GAL();
+
+    /// @copydoc GAL::DrawBitmap()
+    virtual void DrawBitmap( const BITMAP_BASE& aBitmap ) override;
+
+    /// @copydoc GAL::Transform()
+    virtual void Transform( const MATRIX3x3D& aTransformation ) override;
+
+    /// @copydoc GAL::BeginGroup()
+    virtual int BeginGroup() override;
+
+    /// @copydoc GAL::EndGroup()
+    virtual void EndGroup() override;
+
+    /// @copydoc GAL::DeleteGroup()
+    virtual void DeleteGroup( int aGroupNumber ) override {}
+
+    /// @copydoc GAL::ClearCache()
+    virtual void ClearCache() override;
+
+    /// @copydoc GAL::CreateWorkerGal()
+    virtual std::unique_ptr<GAL> CreateWorkerGal() override;
+
+    /// @copydoc GAL::AdoptGroup()
+    virtual int AdoptGroup( GAL* aWorker, int aGroupNumber ) override;
+
+    /**
+     * @brief Returns the vertices of a group.
+     *
+     * @param aGroupNumber is the group number.
+     * @param aVertices is set to the first vertex of the group.
+     * @param aSize is set to the number of vertices of the group.
+     * @return false if the group draws what only an OPENGL_GAL can draw (bitmaps, or shapes
+     * transformed by Transform()), so it has to be drawn again by the OPENGL_GAL.
+     */
+    bool GetGroupVertices( int aGroupNumber, const VERTEX*& aVertices, unsigned int& aSize ) const;
+
+    /**
+     * @brief Returns the shape instances of a group.
+     *
+     * @param aGroupNumber is the group number.
+     * @param aInstances is set to the first instance of the group.
+     * @param aSize is set to the number of instances of the group.
+     */
+    void GetGroupInstances( int aGroupNumber, const SHAPE_INSTANCE*& aInstances,
+                            unsigned int& aSize ) const;
+
+    ///> Returns the shapes the instances refer to
+    const std::vector<INSTANCED_SHAPE>& GetShapes() const
+    {
+        return m_shapes;
+    }
+
+    ///> Returns the number of vertices of all the groups
+    unsigned int GetVertexCount() const
+    {
+        return m_manager.GetSize();
+    }
+
+    ///> Returns the number of shape instances of all the groups
+    unsigned int GetInstanceCount() const
+    {
+        return m_instances.size();
+    }
+
+    ///> Enables or disables drawing shape instances (by default, as the parent GAL does)
+    void SetShapeInstancing( bool aEnabled )
+    {
+        m_shapeInstancing = aEnabled;
+    }
+
+private:
+    struct GROUP
+    {
+        unsigned int m_offset;          ///< Index of the first vertex of the group
+        unsigned int m_size;            ///< Number of vertices of the group
+        unsigned int m_firstInstance;   ///< Index of the first shape instance of the group
+        unsigned int m_instanceCount;   ///< Number of shape instances of the group
+        bool         m_complete;        ///< False if the group has to be drawn by an OPENGL_GAL
+    };
+
+    /// @copydoc OPENGL_GAL_BASE::storeShapeInstance()
+    bool storeShapeInstance( const SHAPE_INSTANCE& aInstance ) override;
+
+    VERTEX_MANAGER          m_manager;      ///< Stores the vertices of all the groups
+    std::vector<GROUP>      m_groups;
+    std::vector<SHAPE_INSTANCE> m_instances;    ///< Shape instances of all the groups
+    bool                    m_isGrouping;
+};
 } // namespace KIGFX
 
 #endif  // OPENGLGAL_H_
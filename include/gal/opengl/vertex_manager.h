@@ -36,6 +36,8 @@
 #include <glm/glm.hpp>
 #include <gal/opengl/vertex_common.h>
 #include <gal/color4d.h>
+#include <gal/gal_display_options.h>
+#include <functional>
 #include <stack>
 #include <memory>
 #include <wx/log.h>
@@ -58,6 +60,13 @@ public:
      */
     VERTEX_MANAGER( bool aCached );
 
+    /**
+     * @brief Constructor.
+     *
+     * @param aContainer is the container storing the vertices, the manager takes its ownership.
+     */
+    VERTEX_MANAGER( VERTEX_CONTAINER* aContainer );
+
     /**
      * Function Map()
      * maps vertex buffer.
@@ -66,7 +75,8 @@ public:
 
     /**
      * Function Unmap()
-     * unmaps vertex buffer.
+     * unmaps vertex buffer. A cached container is compacted a bit before, as its updates are
+     * over for now.
      */
     void Unmap();
 
@@ -134,6 +144,17 @@ public:
      */
     bool Vertices( const VERTEX aVertices[], unsigned int aSize );
 
+    /**
+     * Function CopyVertices()
+     * adds vertices to the currently set item as they are: neither the current transformation,
+     * color nor shader are applied. It serves to move vertices made by another manager.
+     *
+     * @param aVertices contains vertices to be added
+     * @param aSize is the number of vertices to be added.
+     * @return True if successful, false otherwise.
+     */
+    bool CopyVertices( const VERTEX aVertices[], unsigned int aSize );
+
     /**
      * Function Color()
      * changes currently used color that will be applied to newly added vertices.
@@ -311,6 +332,24 @@ public:
      */
     VERTEX* GetVertices( const VERTEX_ITEM& aItem ) const;
 
+    /**
+     * Function GetVertices()
+     * returns a pointer to the vertices stored at the specific offset of the container.
+     */
+    VERTEX* GetVertices( unsigned int aOffset ) const;
+
+    /**
+     * Function GetSize()
+     * returns the amount of vertices stored in the container.
+     */
+    unsigned int GetSize() const;
+
+    /**
+     * Function GetMemoryStats()
+     * returns the state of the allocator of a cached container (empty stats otherwise).
+     */
+    VERTEX_MEMORY_STATS GetMemoryStats() const;
+
     const glm::mat4& GetTransformation() const
     {
         return m_transform;
@@ -349,6 +388,15 @@ public:
      */
     void EndDrawing() const;
 
+    /**
+     * Function AddDrawBreak()
+     * makes EndDrawing() call aHandler once the items drawn so far are drawn, before it draws
+     * the next ones.  Only a manager of cached items can split its drawing.
+     *
+     * @param aHandler draws what goes between both parts.
+     */
+    void AddDrawBreak( std::function<void()> aHandler ) const;
+
     /**
      * Function EnableDepthTest()
      * Enables/disables Z buffer depth test.
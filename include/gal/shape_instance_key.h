@@ -0,0 +1,101 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef SHAPE_INSTANCE_KEY_H_
+#define SHAPE_INSTANCE_KEY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace KIGFX
+{
+/**
+ * The key of a shape drawn by instances (see GAL::DrawShapeInstance()): the values defining
+ * the geometry of the shape.  Two keys are equal only if all their values are; the hash of
+ * the values only speeds up the lookups.
+ */
+class SHAPE_INSTANCE_KEY
+{
+public:
+    /**
+     * @param aKind tells apart the shapes made from different kinds of values.
+     */
+    explicit SHAPE_INSTANCE_KEY( int aKind = 0 ) :
+        m_hash( 14695981039346656037ULL )
+    {
+        Add( aKind );
+    }
+
+    SHAPE_INSTANCE_KEY& Add( int aValue )
+    {
+        add( &aValue, sizeof( aValue ) );
+        return *this;
+    }
+
+    SHAPE_INSTANCE_KEY& Add( double aValue )
+    {
+        add( &aValue, sizeof( aValue ) );
+        return *this;
+    }
+
+    bool operator==( const SHAPE_INSTANCE_KEY& aOther ) const
+    {
+        return m_hash == aOther.m_hash && m_values == aOther.m_values;
+    }
+
+    bool operator!=( const SHAPE_INSTANCE_KEY& aOther ) const
+    {
+        return !( *this == aOther );
+    }
+
+    ///> Hash function of the keys, for the unordered containers
+    struct HASH
+    {
+        size_t operator()( const SHAPE_INSTANCE_KEY& aKey ) const
+        {
+            return (size_t) aKey.m_hash;
+        }
+    };
+
+private:
+    void add( const void* aData, size_t aSize )
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>( aData );
+
+        m_values.insert( m_values.end(), bytes, bytes + aSize );
+
+        // FNV-1a
+        for( size_t ii = 0; ii < aSize; ++ii )
+        {
+            m_hash ^= bytes[ii];
+            m_hash *= 1099511628211ULL;
+        }
+    }
+
+    std::vector<unsigned char> m_values;    ///< Bytes of the values of the key
+    uint64_t                   m_hash;      ///< Hash of m_values
+};
+} // namespace KIGFX
+
+#endif /* SHAPE_INSTANCE_KEY_H_ */
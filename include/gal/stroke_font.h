@@ -31,6 +31,13 @@
 
 #include <deque>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <utf8.h>
 
@@ -45,6 +52,21 @@ class GAL;
 typedef std::vector<std::vector<VECTOR2D>*> GLYPH;
 typedef std::vector<GLYPH*>                 GLYPH_LIST;
 
+/**
+ * The strokes of all the glyphs of a font, flattened into arrays to be walked without
+ * following a pointer per stroke.
+ *
+ * The strokes of glyph i are the strokes m_glyphStarts[i] to m_glyphStarts[i + 1] - 1, and the
+ * points of stroke s are m_points[m_strokeStarts[s]] to m_points[m_strokeStarts[s + 1] - 1]:
+ * both arrays end with an extra entry.
+ */
+struct STROKE_GLYPHS
+{
+    std::vector<VECTOR2D>     m_points;         ///< Points of all the strokes
+    std::vector<unsigned int> m_strokeStarts;   ///< Index of the first point of each stroke
+    std::vector<unsigned int> m_glyphStarts;    ///< Index of the first stroke of each glyph
+};
+
 /**
  * @brief Class STROKE_FONT implements stroke font drawing.
  *
@@ -117,12 +139,70 @@ public:
      */
     static double GetInterline( double aGlyphHeight );
 
+    /**
+     * Enables or disables the text layout cache of all the fonts, to measure what it saves.
+     * Not to be called while texts are drawn in other threads.
+     */
+    static void SetLayoutCacheEnabled( bool aEnabled );
 
+    static bool IsLayoutCacheEnabled();
 
 private:
+    ///> The strokes of a line of text, ready to be drawn with GAL::DrawPolylines()
+    struct TEXT_LAYOUT
+    {
+        std::vector<VECTOR2D>     m_points;     ///< Points of the strokes of the glyphs
+        std::vector<unsigned int> m_starts;     ///< Index of the first point of each stroke
+        std::vector<VECTOR2D>     m_overbars;   ///< Start and end points of the overbars
+        VECTOR2D                  m_size;       ///< See computeTextLineSize()
+    };
+
+    ///> What a text layout depends on: the text and the text attributes of the GAL
+    struct TEXT_LAYOUT_KEY
+    {
+        std::string m_text;
+        VECTOR2D    m_glyphSize;
+        double      m_lineWidth;
+        bool        m_italic;
+        bool        m_mirrored;
+        int         m_markupFlags;
+
+        bool operator==( const TEXT_LAYOUT_KEY& aOther ) const
+        {
+            return m_text == aOther.m_text && m_glyphSize == aOther.m_glyphSize
+                   && m_lineWidth == aOther.m_lineWidth && m_italic == aOther.m_italic
+                   && m_mirrored == aOther.m_mirrored && m_markupFlags == aOther.m_markupFlags;
+        }
+    };
+
+    struct TEXT_LAYOUT_KEY_HASH
+    {
+        size_t operator()( const TEXT_LAYOUT_KEY& aKey ) const;
+    };
+
+    struct CACHED_LAYOUT
+    {
+        std::shared_ptr<const TEXT_LAYOUT> m_layout;
+        std::atomic<uint64_t>              m_lastUse;   ///< Value of s_layoutClock when last used
+    };
+
+    typedef std::unordered_map<TEXT_LAYOUT_KEY, CACHED_LAYOUT, TEXT_LAYOUT_KEY_HASH> LAYOUT_CACHE;
+
     GAL*                      m_gal;                  ///< Pointer to the GAL
     const GLYPH_LIST*         m_glyphs;               ///< Glyph list
     const std::vector<BOX2D>* m_glyphBoundingBoxes;   ///< Bounding boxes of the glyphs
+    const STROKE_GLYPHS*      m_strokeGlyphs;         ///< Strokes of the glyphs
+
+    /// Layouts of the lines of text drawn recently, shared by the fonts of all the GALs: the
+    /// worker GALs made for each recache of a view find the layouts of the previous ones.
+    /// Looked up under a shared lock, the workers drawing in other threads only take the
+    /// lock exclusively to add a layout.
+    static LAYOUT_CACHE            s_layoutCache;
+    static std::shared_timed_mutex s_layoutCacheMutex;
+    static std::atomic<uint64_t>   s_layoutClock;         ///< Counts the cache lookups
+
+    std::shared_ptr<const TEXT_LAYOUT> m_cachedLayout;    ///< Last layout returned by the cache
+    TEXT_LAYOUT               m_layout;               ///< Layout used without the cache
 
     /**
      * @brief Compute the X and Y size of a given text. The text is expected to be
@@ -158,6 +238,26 @@ private:
      */
     void drawSingleLineText( const UTF8& aText, int markupFlags );
 
+    /**
+     * @brief Returns the layout of a single line of text with the current text attributes
+     * of the GAL, from the cache if possible.
+     *
+     * The reference is valid until the next call, even if the layout is evicted meanwhile.
+     */
+    const TEXT_LAYOUT& getLayout( const UTF8& aText, int aMarkupFlags );
+
+    /**
+     * @brief Drops the least recently used half of the layout cache. s_layoutCacheMutex must
+     * be locked exclusively.
+     */
+    static void evictLayouts();
+
+    /**
+     * @brief Lays out a single line of text with the current text attributes of the GAL,
+     * as drawSingleLineText() draws it before the horizontal justification.
+     */
+    void layoutSingleLineText( const UTF8& aText, int aMarkupFlags, TEXT_LAYOUT& aLayout ) const;
+
     /**
      * @brief Returns number of lines for a given text.
      *
@@ -188,6 +288,9 @@ private:
 
     ///> Factor that determines the pitch between 2 lines.
     static const double INTERLINE_PITCH_RATIO;
+
+    ///> Number of layouts kept by the layout cache
+    static const size_t LAYOUT_CACHE_SIZE;
 };
 } // namespace KIGFX
 
@@ -354,6 +354,18 @@ public:
      */
     virtual bool Draw( const VIEW_ITEM* aItem, int aLayer ) = 0;
 
+    /**
+     * Function Clone
+     * Creates a painter with the same settings drawing with another GAL, to draw items in
+     * another thread (see GAL::CreateWorkerGal()).
+     * @param aGal is the GAL used by the new painter.
+     * @return the new painter, or nullptr if the painter can only be used by the GUI thread.
+     */
+    virtual std::unique_ptr<PAINTER> Clone( GAL* aGal ) const
+    {
+        return nullptr;
+    }
+
 protected:
     /// Instance of graphic abstraction layer that gives an interface to call
     /// commands used to draw (eg. DrawLine, DrawCircle, etc.)
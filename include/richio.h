@@ -120,6 +120,32 @@ public:
      */
     virtual char* ReadLine() = 0;
 
+    /**
+     * Function ReadLineInPlace
+     * reads a line like ReadLine(), but lets the readers which hold the whole text in memory
+     * hand it out where it lies instead of copying it into the line buffer.  Such a line is
+     * not nul terminated, and Line() does not return it until FetchLine() is called.
+     * @param aLength receives the number of bytes in the line, 0 at end of file.
+     * @return const char* - The beginning of the read line, never NULL.
+     * @throw IO_ERROR when a line is too long.
+     */
+    virtual const char* ReadLineInPlace( unsigned* aLength )
+    {
+        ReadLine();
+        *aLength = m_length;
+        return m_line;
+    }
+
+    /**
+     * Function FetchLine
+     * copies the last line read in place into the line buffer, if it is not there yet.
+     * @return char* - The nul terminated line, as Line() returns it afterwards.
+     */
+    virtual char* FetchLine()
+    {
+        return m_line;
+    }
+
     /**
      * Function GetSource
      * returns the name of the source of the lines in an abstract sense.
@@ -247,6 +273,65 @@ public:
 };
 
 
+/**
+ * WHOLE_FILE_LINE_READER
+ * is a LINE_READER that holds a whole file in memory rather than reading it through a
+ * FILE, so later changes to the file do not affect the lines read.  Lines are found with memchr() instead of one character at a time, and
+ * ReadLineInPlace() hands them out without copying them at all, which is what DSNLEXER
+ * asks for.
+ *
+ * The file is mapped on Windows only, which does not let other programs truncate a mapped
+ * file.  Elsewhere a truncated mapping raises SIGBUS, so the file is read at once instead.
+ */
+class WHOLE_FILE_LINE_READER : public LINE_READER
+{
+protected:
+    const char*     m_data;       ///< the text of the file
+    size_t          m_size;       ///< no. bytes in the file
+    size_t          m_ndx;        ///< offset of the next line
+    const char*     m_view;       ///< last line read in place and not copied yet, if any
+
+    void*           m_mapping;    ///< the platform handle of the mapping
+    std::string     m_fallback;   ///< the text, when the file is not mapped
+
+public:
+
+    /**
+     * Constructor WHOLE_FILE_LINE_READER
+     * reads @a aFileName in memory, or maps it on Windows.
+     *
+     * @param aFileName is the name of the file to open and to use for error reporting purposes.
+     * @param aStartingLineNumber is the initial line number to report on error, as for
+     *  FILE_LINE_READER.
+     * @param aMaxLineLength is the maximum supported line length.
+     *
+     * @throw IO_ERROR if @a aFileName cannot be opened.
+     */
+    WHOLE_FILE_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber = 0,
+            unsigned aMaxLineLength = LINE_READER_LINE_DEFAULT_MAX );
+
+    ~WHOLE_FILE_LINE_READER();
+
+    char* ReadLine() override;
+
+    const char* ReadLineInPlace( unsigned* aLength ) override;
+
+    char* FetchLine() override;
+
+    /**
+     * Function Rewind
+     * goes back to the beginning of the file and resets the line number back to zero.
+     */
+    void Rewind()
+    {
+        m_ndx = 0;
+        m_view = NULL;
+        m_lineNum = 0;
+    }
+};
+
+
 /**
  * STRING_LINE_READER
  * is a LINE_READER that reads from a multiline 8 bit wide std::string
@@ -256,6 +341,7 @@ class STRING_LINE_READER : public LINE_READER
 protected:
     std::string     m_lines;
     size_t          m_ndx;
+    bool            m_inPlace;    ///< the last line was read in place and not copied yet
 
 public:
 
@@ -268,8 +354,12 @@ public:
      *
      * @param aSource describes the source of aString for error reporting purposes
      *  can be anything meaninful, such as wxT( "clipboard" ).
+     *
+     * @param aStartingLineNumber is the initial line number to report on error, for
+     *  text taken out of a bigger source.
      */
-    STRING_LINE_READER( const std::string& aString, const wxString& aSource );
+    STRING_LINE_READER( const std::string& aString, const wxString& aSource,
+                        unsigned aStartingLineNumber = 0 );
 
     /**
      * Constructor STRING_LINE_READER( const STRING_LINE_READER& )
@@ -280,6 +370,10 @@ public:
     STRING_LINE_READER( const STRING_LINE_READER& aStartingPoint );
 
     char* ReadLine() override;
+
+    const char* ReadLineInPlace( unsigned* aLength ) override;
+
+    char* FetchLine() override;
 };
 
 
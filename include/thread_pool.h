@@ -0,0 +1,180 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class PROGRESS_REPORTER;
+
+/**
+ * A work-stealing pool of worker threads.
+ *
+ * Every worker owns a task deque.  Tasks submitted from a worker are pushed on the back of
+ * its own deque and popped LIFO (which keeps nested work cache-local); idle workers steal
+ * from the front of the other deques.  Tasks submitted from outside the pool are dealt
+ * round-robin across the workers.
+ *
+ * There is normally a single, process-wide instance obtained through #THREAD_POOL::Get()
+ * so that back-to-back parallel operations (zone refill followed by a ratsnest update,
+ * for instance) share the same threads instead of oversubscribing the machine.
+ *
+ * Tasks are usually not submitted directly but through a #TASK_GROUP or #ParallelFor(),
+ * which take care of completion tracking and cancellation.
+ */
+class THREAD_POOL
+{
+public:
+    typedef std::function<void()> TASK;
+
+    /**
+     * @param aThreadCount is the number of worker threads.  0 means one thread per hardware
+     *                     thread.
+     */
+    explicit THREAD_POOL( size_t aThreadCount );
+    THREAD_POOL( const THREAD_POOL& ) = delete;
+    THREAD_POOL& operator=( const THREAD_POOL& ) = delete;
+
+    ~THREAD_POOL();
+
+    /**
+     * Return the process-wide pool.  Its size is set by ADVANCED_CFG::m_maxWorkerThreads.
+     */
+    static THREAD_POOL& Get();
+
+    size_t GetThreadCount() const { return m_workers.size(); }
+
+    /**
+     * Queue a task for execution on one of the workers.
+     */
+    void Submit( TASK aTask );
+
+    /**
+     * Execute one queued task on the calling thread, if there is one.  Threads waiting on
+     * pool work should call this rather than blocking so that nested parallel sections
+     * cannot starve the pool.
+     *
+     * @return true if a task was executed.
+     */
+    bool RunPendingTask();
+
+    /**
+     * @return true if the calling thread is one of this pool's workers.
+     */
+    bool IsWorkerThread() const;
+
+private:
+    struct WORKER
+    {
+        std::mutex       m_lock;
+        std::deque<TASK> m_tasks;
+        std::thread      m_thread;
+    };
+
+    void workerLoop( size_t aIndex );
+
+    bool popTask( size_t aIndex, TASK& aTask );
+    bool stealTask( size_t aThief, TASK& aTask );
+
+    std::vector<std::unique_ptr<WORKER>> m_workers;
+
+    std::mutex              m_sleepLock;
+    std::condition_variable m_wakeUp;
+    std::atomic<size_t>     m_queued;
+    std::atomic<size_t>     m_nextVictim;
+    std::atomic<bool>       m_stop;
+};
+
+
+/**
+ * A set of tasks running on a #THREAD_POOL that can be waited on and cancelled together.
+ *
+ * When a #PROGRESS_REPORTER is given, Wait() keeps it refreshed while waiting on the main
+ * thread and cancels the group if the user aborts.  Tasks belonging to a cancelled group
+ * that have not started yet are dropped; long running tasks should poll IsCancelled().
+ *
+ * The destructor waits for all outstanding tasks.
+ */
+class TASK_GROUP
+{
+public:
+    TASK_GROUP( PROGRESS_REPORTER* aReporter = nullptr,
+                THREAD_POOL& aPool = THREAD_POOL::Get() );
+    TASK_GROUP( const TASK_GROUP& ) = delete;
+
+    ~TASK_GROUP();
+
+    /**
+     * Queue a task as part of this group.
+     */
+    void Run( std::function<void()> aTask );
+
+    /**
+     * Block until every task of the group has finished.  If a task threw, the first
+     * exception is rethrown here.
+     *
+     * @return false if the group was cancelled.
+     */
+    bool Wait();
+
+    void Cancel() { m_cancelled.store( true ); }
+
+    bool IsCancelled() const { return m_cancelled.load(); }
+
+    THREAD_POOL& GetPool() const { return m_pool; }
+
+private:
+    THREAD_POOL&            m_pool;
+    PROGRESS_REPORTER*      m_reporter;
+
+    std::atomic<size_t>     m_pending;
+    std::atomic<bool>       m_cancelled;
+    std::exception_ptr      m_exception;     ///< first exception thrown by a task
+    std::mutex              m_doneLock;
+    std::condition_variable m_done;
+};
+
+
+/**
+ * Call aFunc for every index in [aBegin, aEnd) using the process-wide pool.
+ *
+ * The range is cut into blocks of at most aGrain indices, which are executed as separate
+ * tasks so that uneven workloads are balanced by work stealing.  A grain of 0 picks a block
+ * size giving a few blocks per worker.  Returns once every index has been processed or the
+ * operation was cancelled through aReporter.
+ *
+ * @return false if the loop was cancelled before completion.
+ */
+bool ParallelFor( size_t aBegin, size_t aEnd, const std::function<void( size_t )>& aFunc,
+                  PROGRESS_REPORTER* aReporter = nullptr, size_t aGrain = 0 );
+
+#endif // THREAD_POOL_H
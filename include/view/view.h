@@ -33,6 +33,7 @@
 #include <math/box2.h>
 #include <gal/definitions.h>
 
+#include <view/view_item.h>
 #include <view/view_overlay.h>
 
 namespace KIGFX
@@ -533,6 +534,42 @@ public:
      */
     virtual void Redraw();
 
+    /**
+     * REDRAW_STATS
+     * What the last Redraw() drew, see GetRedrawStats().
+     */
+    struct REDRAW_STATS
+    {
+        double m_time;          ///< time spent in Redraw() [ms]
+        int    m_drawCalls;     ///< cached groups and items drawn, merged tiles included
+        int    m_tiles;         ///< merged tiles drawn
+        int    m_mergedItems;   ///< items drawn as part of a merged tile
+        int    m_builtTiles;    ///< merged tiles built by UpdateItems() since the previous redraw
+    };
+
+    /**
+     * Function GetRedrawStats()
+     * @return the frame time and the draw calls of the last Redraw().
+     */
+    const REDRAW_STATS& GetRedrawStats() const
+    {
+        return m_redrawStats;
+    }
+
+    /**
+     * Function SetLodThreshold()
+     * Sets the size in pixels under which the items of cached layers are not drawn one by one,
+     * but as their coarse shape (see VIEW_ITEM::ViewGetCoarseShape()) merged with the other
+     * small items of a screen tile in a single group. The tiles are built for zoom levels a
+     * factor of 2 apart. 0 disables it. The default value comes from the advanced config.
+     */
+    void SetLodThreshold( int aPixels );
+
+    int GetLodThreshold() const
+    {
+        return m_lodThreshold;
+    }
+
     /**
      * Function RecacheAllItems()
      * Rebuilds GAL display lists.
@@ -626,6 +663,18 @@ public:
      */
     void UpdateItems();
 
+    /**
+     * Function SetParallelRecacheItems()
+     * Sets the minimum number of items updated at once by UpdateItems() for their cached
+     * geometry to be drawn by several threads, when the GAL and the PAINTER support it (see
+     * GAL::CreateWorkerGal() and PAINTER::Clone()). 0 disables it. The default value comes
+     * from the advanced config.
+     */
+    void SetParallelRecacheItems( int aCount )
+    {
+        m_parallelRecacheItems = aCount;
+    }
+
     /**
      * Updates all items in the view according to the given flags
      * @param aUpdateFlags is is according to KIGFX::VIEW_UPDATE_FLAGS
@@ -726,6 +775,36 @@ protected:
     struct updateItemsColor;
     struct changeItemsDepth;
     struct extentsVisitor;
+    struct lodFrame;
+    struct lodTileBuilder;
+
+    ///> Merged tiles at a zoom level, see SetLodThreshold()
+    struct LOD_GRID
+    {
+        int    level;       ///< log2 of the world scale, rounded down
+        double tileSize;    ///< world size of the tiles
+        double itemSize;    ///< world size under which the items are merged
+        double minScale;    ///< lowest VIEW scale of the level, for VIEW_ITEM::ViewGetLOD()
+
+        /**
+         * Function Merges()
+         * Tells if an item is drawn by a merged tile on a layer.
+         * @param aLod is the level of detail of the item on aLayer.
+         * @param aShape is the coarse shape of the item, if merged.
+         * @param aTile is the tile of the item (the one holding the middle of its shape).
+         */
+        bool Merges( const VIEW_ITEM* aItem, int aLayer, unsigned int aLod,
+                     VIEW_COARSE_SHAPE& aShape, VECTOR2I& aTile ) const;
+
+        const BOX2I TileRect( const VECTOR2I& aTile ) const;
+    };
+
+    ///> A merged tile of a layer
+    struct LOD_TILE
+    {
+        int      group;         ///< cached group of the coarse shapes, -1 if none
+        uint64_t signature;     ///< items of the tile, and their state, when it was built
+    };
 
 
     ///* Redraws contents within rect aRect
@@ -781,8 +860,11 @@ protected:
      * Manages dirty flags & redraw queueing when updating an item.
      * @param aItem is the item to be updated.
      * @param aUpdateFlags determines the way an item is refreshed.
+     * @param aGeometryUpdates if given, collects the item if its geometry has to be drawn
+     * again instead of drawing it, for updateItemsGeometry().
      */
-    void invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags );
+    void invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags,
+                         std::vector<VIEW_ITEM*>* aGeometryUpdates = nullptr );
 
     /// Updates colors that are used for an item to be drawn
     void updateItemColor( VIEW_ITEM* aItem, int aLayer );
@@ -790,6 +872,22 @@ protected:
     /// Updates all informations needed to draw an item
     void updateItemGeometry( VIEW_ITEM* aItem, int aLayer );
 
+    /// Updates the geometry of items on all their cached layers, with several threads if possible
+    void updateItemsGeometry( const std::vector<VIEW_ITEM*>& aItems );
+
+    /**
+     * Function getLodGrid()
+     * @return false if the items are not merged in tiles at the current zoom, otherwise the
+     * tiles are given in aGrid.
+     */
+    bool getLodGrid( LOD_GRID& aGrid ) const;
+
+    /// Builds the merged tiles found out of date by the last redraw
+    void updateLodTiles();
+
+    /// Deletes the merged tiles of a layer, or of all layers if aLayer is -1
+    void clearLodTiles( int aLayer = -1 );
+
     /// Updates bounding box of an item
     void updateBbox( VIEW_ITEM* aItem );
 
@@ -867,6 +965,30 @@ protected:
     /// Flag to reverse the draw order when using draw priority
     bool m_reverseDrawOrder;
 
+    /// Minimum number of items updated at once to draw their geometry with several threads
+    int m_parallelRecacheItems;
+
+    /// Size in pixels under which the items are drawn by merged tiles, 0 if they are not
+    int m_lodThreshold;
+
+    /// Zoom level of the merged tiles
+    int m_lodLevel;
+
+    /// Merged tiles of each layer, by tile coordinates
+    std::unordered_map<int, std::unordered_map<uint64_t, LOD_TILE>> m_lodTiles;
+
+    /// Tiles (layer, coordinates) to be built by the next UpdateItems()
+    std::vector<std::pair<int, uint64_t>> m_lodPendingTiles;
+
+    /// Last state number given to an updated item, to find the out of date tiles
+    uint64_t m_lodStamp;
+
+    /// Number of tiles built since the last redraw
+    int m_lodBuiltTiles;
+
+    /// What the last redraw drew
+    REDRAW_STATS m_redrawStats;
+
     /// A control for printing: m_printMode <= 0 means no printing mode (normal draw mode
     /// m_printMode > 0 is a printing mode (currently means "we are in printing mode")
     int m_printMode;
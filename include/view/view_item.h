@@ -70,6 +70,41 @@ enum VIEW_VISIBILITY_FLAGS {
     HIDDEN      = 0x02      /// Item is temporarily hidden (e.g. being used by a tool). Overrides VISIBLE flag.
 };
 
+/**
+ * VIEW_COARSE_SHAPE
+ * A simplified shape of a VIEW_ITEM on one of its layers, drawn in the layer color in place of
+ * the item when it spans only a few pixels on the screen (see VIEW_ITEM::ViewGetCoarseShape()).
+ */
+struct VIEW_COARSE_SHAPE
+{
+    enum TYPE
+    {
+        SEGMENT,    ///< m_start to m_end, m_width wide
+        CIRCLE,     ///< centered on m_start, m_width in diameter
+        RECT        ///< filled rectangle from m_start to m_end
+    };
+
+    TYPE     m_type;
+    VECTOR2I m_start;
+    VECTOR2I m_end;
+    int      m_width;
+
+    const BOX2I BBox() const
+    {
+        switch( m_type )
+        {
+        case SEGMENT:
+            return BOX2I( m_start, m_end - m_start ).Normalize().Inflate( m_width / 2 );
+
+        case CIRCLE:
+            return BOX2I( m_start, VECTOR2I( 0, 0 ) ).Inflate( m_width / 2 );
+
+        default:
+            return BOX2I( m_start, m_end - m_start ).Normalize();
+        }
+    }
+};
+
 /**
  * VIEW_ITEM -
  * is an abstract base class for deriving all objects that can be added to a VIEW.
@@ -143,6 +178,20 @@ public:
         return 0;
     }
 
+    /**
+     * Function ViewGetCoarseShape()
+     * Returns a simplified shape of the item on a layer. When the item is smaller than a few
+     * pixels on the screen (see VIEW::SetLodThreshold()), this shape is merged with the ones of
+     * the other small items around it in a single cached group, drawn instead of the items.
+     * @param aLayer: current drawing layer
+     * @param aShape: the coarse shape of the item on aLayer
+     * @return false if the item has no coarse shape on aLayer and is always drawn in full.
+     */
+    virtual bool ViewGetCoarseShape( int aLayer, VIEW_COARSE_SHAPE& aShape ) const
+    {
+        return false;
+    }
+
 public:
 
     VIEW_ITEM_DATA* viewPrivData() const
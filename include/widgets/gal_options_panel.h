@@ -66,6 +66,9 @@ private:
     wxRadioBox* m_cursorShape;
     wxCheckBox* m_forceCursorDisplay;
 
+    ///> State of the vertex memory, shown only if enabled in the advanced config
+    wxStaticText* m_vertexMemory;
+
     ///> The GAL options to read/write
     KIGFX::GAL_DISPLAY_OPTIONS& m_galOptions;
 };
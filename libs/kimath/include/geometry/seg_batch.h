@@ -0,0 +1,127 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __SEG_BATCH_H
+#define __SEG_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <geometry/seg.h>
+#include <math/vector2d.h>
+
+/**
+ * SEG_BATCH
+ *
+ * A set of segments stored as arrays of coordinates, to test a single segment or point
+ * against all of them at once.
+ *
+ * The segments are first screened by the distance between their bounding boxes and the one
+ * of the tested segment, a few segments at a time with SSE4 or AVX2 instructions when the
+ * processor has them (chosen at run time). The screening is conservative: the segments left
+ * are then tested one by one by the SEG methods, so the results are exactly the ones of a
+ * plain loop calling SEG::Collide() or SEG::SquaredDistance() on every segment.
+ *
+ * The static *Chain() functions do the same for the segments joining consecutive points of
+ * an array, that is the segments of a SHAPE_LINE_CHAIN.
+ */
+class SEG_BATCH
+{
+public:
+    enum KERNEL
+    {
+        KERNEL_SCALAR = 0,
+        KERNEL_SSE4,
+        KERNEL_AVX2
+    };
+
+    void Clear();
+
+    void Reserve( size_t aCount );
+
+    void Append( const SEG& aSeg );
+
+    size_t Size() const
+    {
+        return m_ax.size();
+    }
+
+    const SEG Segment( size_t aIndex ) const
+    {
+        return SEG( VECTOR2I( m_ax[aIndex], m_ay[aIndex] ),
+                    VECTOR2I( m_bx[aIndex], m_by[aIndex] ) );
+    }
+
+    /**
+     * Function Collide()
+     *
+     * @return the index of the first segment for which SEG::Collide( aSeg, aClearance ) is
+     * true, or -1 if there is none.
+     */
+    int Collide( const SEG& aSeg, int aClearance ) const;
+
+    /**
+     * Function SquaredDistance()
+     *
+     * @return the smallest SEG::SquaredDistance( aSeg ) of the segments, VECTOR2I::ECOORD_MAX
+     * if there are none. The index of the first segment at that distance is stored in aIndex
+     * if given.
+     */
+    SEG::ecoord SquaredDistance( const SEG& aSeg, int* aIndex = nullptr ) const;
+
+    ///> Same as above, with SEG::SquaredDistance( aP )
+    SEG::ecoord SquaredDistance( const VECTOR2I& aP, int* aIndex = nullptr ) const;
+
+    ///> Collide() for the aCount segments joining aPoints[i] to aPoints[i + 1]
+    static int CollideChain( const VECTOR2I* aPoints, size_t aCount, const SEG& aSeg,
+                             int aClearance );
+
+    ///> SquaredDistance() for the aCount segments joining aPoints[i] to aPoints[i + 1]
+    static SEG::ecoord SquaredDistanceChain( const VECTOR2I* aPoints, size_t aCount,
+                                             const VECTOR2I& aP, int* aIndex = nullptr );
+
+    ///> Returns the kernel in use: the best one the processor supports, unless set otherwise
+    static KERNEL GetKernel();
+
+    /**
+     * Function SetKernel()
+     *
+     * Selects the kernel used from now on, to compare them. Not to be called while the
+     * batches are in use in other threads.
+     * @return false, if the processor (or the build) does not support aKernel.
+     */
+    static bool SetKernel( KERNEL aKernel );
+
+    static bool IsKernelSupported( KERNEL aKernel );
+
+    static const char* KernelName( KERNEL aKernel );
+
+private:
+    std::vector<int32_t> m_ax;
+    std::vector<int32_t> m_ay;
+    std::vector<int32_t> m_bx;
+    std::vector<int32_t> m_by;
+};
+
+#endif // __SEG_BATCH_H
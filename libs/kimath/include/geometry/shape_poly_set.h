@@ -28,6 +28,7 @@
 
 #include <cstdio>
 #include <deque>                        // for deque
+#include <functional>                   // for function
 #include <iosfwd>                       // for string, stringstream
 #include <memory>
 #include <set>                          // for set
@@ -68,6 +69,14 @@ class SHAPE_POLY_SET : public SHAPE
         ///> N.B. SWIG only supports typedef, so avoid c++ 'using' keyword
         typedef std::vector<SHAPE_LINE_CHAIN> POLYGON;
 
+        /**
+         * Runs aTask( i ) for every i in [0, aCount), possibly concurrently, and returns once
+         * all the calls are done.  The partitioned booleans and the triangulation use it to
+         * spread their work over the threads chosen by the caller.
+         */
+        typedef std::function<void( size_t aCount,
+                                    const std::function<void( size_t )>& aTask )> TASK_EXECUTOR;
+
         class TRIANGULATED_POLYGON
         {
         public:
@@ -865,6 +874,30 @@ class SHAPE_POLY_SET : public SHAPE
         void BooleanIntersection( const SHAPE_POLY_SET& a, const SHAPE_POLY_SET& b,
                                   POLYGON_MODE aFastMode );
 
+        /**
+         * Performs boolean polyset difference tile by tile.
+         *
+         * The bounding box of the set is split in a grid of aTiles x aTiles slightly overlapping
+         * tiles.  Each tile only sees the contours crossing it, so the costly part (the
+         * intersections between many overlapping holes) is done on small independent problems,
+         * run through aExecutor.  The tile results are then merged back by a union, which only
+         * has to deal with the tile overlaps.
+         *
+         * The result covers the same area as BooleanSubtract(), although the vertices can differ
+         * by rounding where the tile borders cut edges.
+         *
+         * @param aTiles is the number of tiles along each axis; 1 or less falls back to
+         *               BooleanSubtract().
+         * @param aExecutor runs the tiles; if empty they are processed one after the other.
+         */
+        void BooleanSubtractPartitioned( const SHAPE_POLY_SET& b, POLYGON_MODE aFastMode,
+                                         int aTiles,
+                                         const TASK_EXECUTOR& aExecutor = TASK_EXECUTOR() );
+
+        ///> Same as Simplify(), but done tile by tile like BooleanSubtractPartitioned()
+        void SimplifyPartitioned( POLYGON_MODE aFastMode, int aTiles,
+                                  const TASK_EXECUTOR& aExecutor = TASK_EXECUTOR() );
+
         enum CORNER_STRATEGY    ///< define how inflate transform build inflated polygon
         {
             ALLOW_ACUTE_CORNERS,    ///< just inflate the polygon. Acute angles create spikes
@@ -1162,7 +1195,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @return int -  The minimum distance between aPoint and all the segments of the aIndex-th
          *                polygon. If the point is contained in the polygon, the distance is zero.
          */
-        int DistanceToPolygon( VECTOR2I aPoint, int aIndex );
+        int DistanceToPolygon( VECTOR2I aPoint, int aIndex ) const;
 
         /**
          * Function DistanceToPolygon
@@ -1176,26 +1209,29 @@ class SHAPE_POLY_SET : public SHAPE
          *                  aIndex-th polygon. If the point is contained in the polygon, the
          *                  distance is zero.
          */
-        int DistanceToPolygon( const SEG& aSegment, int aIndex, int aSegmentWidth = 0 );
+        int DistanceToPolygon( const SEG& aSegment, int aIndex, int aSegmentWidth = 0 ) const;
 
         /**
          * Function DistanceToPolygon
-         * computes the minimum distance between aPoint and all the polygons in the set
+         * computes the minimum distance between aPoint and all the polygons in the set.
+         * Only reads the polygons and uses no lazily built cache, so it may be called
+         * concurrently on a shared set.
          * @param  aPoint is the point whose distance to the set has to be measured.
          * @return int -  The minimum distance between aPoint and all the polygons in the set. If
          *                the point is contained in any of the polygons, the distance is zero.
          */
-        int Distance( VECTOR2I aPoint );
+        int Distance( VECTOR2I aPoint ) const;
 
         /**
          * Function DistanceToPolygon
          * computes the minimum distance between aSegment and all the polygons in the set.
+         * Like Distance( VECTOR2I ), it may be called concurrently on a shared set.
          * @param  aSegment is the segment whose distance to the polygon set has to be measured.
          * @param  aSegmentWidth is the width of the segment; defaults to zero.
          * @return int -    The minimum distance between aSegment and all the polygons in the set.
          *                  If the point is contained in the polygon, the distance is zero.
          */
-        int Distance( const SEG& aSegment, int aSegmentWidth = 0 );
+        int Distance( const SEG& aSegment, int aSegmentWidth = 0 ) const;
 
         /**
          * Function IsVertexInHole.
@@ -1227,6 +1263,14 @@ class SHAPE_POLY_SET : public SHAPE
         void booleanOp( ClipperLib::ClipType aType, const SHAPE_POLY_SET& aShape,
                         const SHAPE_POLY_SET& aOtherShape, POLYGON_MODE aFastMode );
 
+        /**
+         * Partitioned version of booleanOp().  Only the union, difference and intersection are
+         * supported.  See BooleanSubtractPartitioned().
+         */
+        void booleanOpPartitioned( ClipperLib::ClipType aType, const SHAPE_POLY_SET& aOtherShape,
+                                   POLYGON_MODE aFastMode, int aTiles,
+                                   const TASK_EXECUTOR& aExecutor );
+
         bool pointInPolygon( const VECTOR2I& aP, const SHAPE_LINE_CHAIN& aPath,
                              bool aIgnoreEdges, bool aUseBBoxCaches = false ) const;
 
@@ -1287,9 +1331,33 @@ class SHAPE_POLY_SET : public SHAPE
 
     public:
 
+        /**
+         * Assigns the polygons of another set, and its triangulation if up to date.  Otherwise
+         * this set has no triangulation until the next CacheTriangulation(), which reuses the
+         * triangles this set had for the polygons which are still there.
+         */
         SHAPE_POLY_SET& operator=( const SHAPE_POLY_SET& );
 
-        void CacheTriangulation();
+        ///> What CacheTriangulation() did, per polygon of the set
+        struct TRIANGULATION_STATS
+        {
+            int                 m_reused = 0;       ///< polygons whose triangles were kept
+            int                 m_triangulated = 0; ///< polygons triangulated again
+            std::vector<double> m_times;            ///< ms spent on each polygon, 0 if reused
+        };
+
+        /**
+         * Triangulates the polygons of the set, for the renderers.
+         *
+         * The triangles are cached by polygon content: a polygon which did not change since the
+         * previous triangulation, even if other polygons did or the whole set was reassigned,
+         * keeps its triangles.  The others are triangulated independently, through aExecutor
+         * when given.
+         *
+         * @param aStats, if not null, receives the cache hits and the time spent per polygon.
+         */
+        void CacheTriangulation( const TASK_EXECUTOR& aExecutor = TASK_EXECUTOR(),
+                                 TRIANGULATION_STATS* aStats = nullptr );
         bool IsTriangulationUpToDate() const;
 
         MD5_HASH GetHash() const;
@@ -1298,7 +1366,22 @@ class SHAPE_POLY_SET : public SHAPE
 
         MD5_HASH checksum() const;
 
+        /**
+         * Triangulates aPolygon into aResult, fracturing it first if it has holes.
+         * @return false if some part of it could not be triangulated.
+         */
+        static bool triangulateSingle( const POLYGON& aPolygon,
+                        std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>& aResult );
+
         std::vector<std::unique_ptr<TRIANGULATED_POLYGON>> m_triangulatedPolys;
+
+        ///> Hash of the polygon each entry of m_triangulatedPolys was built from
+        std::vector<MD5_HASH> m_triangulatedSources;
+
+        ///> The triangles this set had before being assigned, and their sources, kept for the
+        ///> next CacheTriangulation() to reuse but not reported by TriangulatedPolygon()
+        std::vector<std::unique_ptr<TRIANGULATED_POLYGON>> m_staleTriangulatedPolys;
+        std::vector<MD5_HASH> m_staleTriangulatedSources;
         bool m_triangulationValid = false;
         MD5_HASH m_hash;
 
@@ -30,6 +30,9 @@ public:
     bool operator==( const MD5_HASH& aOther ) const;
     bool operator!=( const MD5_HASH& aOther ) const;
 
+    ///> Arbitrary strict ordering, to use hashes as keys of sorted containers
+    bool operator<( const MD5_HASH& aOther ) const;
+
     /** @return Build a hexadecimal string from the 16 bytes of MD5_HASH
      *  Mainly for debug purposes.
      */
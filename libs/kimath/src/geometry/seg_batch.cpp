@@ -0,0 +1,544 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>        // for min, max
+#include <atomic>
+#include <cmath>            // for sqrt, abs
+#include <limits>
+
+#include <geometry/seg_batch.h>
+
+// The SIMD kernels are built for their instruction set function by function, the rest of the
+// library keeps the baseline one: the kernel is picked at run time from what the processor has.
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define SEG_BATCH_X86
+#define SEG_BATCH_TARGET( isa ) __attribute__( ( target( isa ) ) )
+#include <immintrin.h>
+#elif defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#define SEG_BATCH_X86
+#define SEG_BATCH_TARGET( isa )
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+
+static_assert( sizeof( VECTOR2I ) == 2 * sizeof( int32_t ),
+               "the chain kernels read the points as pairs of 32 bit coordinates" );
+
+
+namespace
+{
+
+///> Number of segments screened at a time, before testing the ones left
+const size_t BLOCK_SIZE = 256;
+
+///> SEG::Collide() may find collisions a little beyond the clearance: the nearest points are
+///> rounded, and PointCloserThan() estimates the distance of almost diagonal segments
+const double COLLIDE_SLACK = 4.0;
+
+///> SEG::SquaredDistance() may be a little short of the exact distance, the nearest points
+///> being rounded
+const double DISTANCE_SLACK = 2.0;
+
+///> Covers the rounding of the squared box distances, computed with doubles
+const double LIMIT_MARGIN = 1e-9;
+
+
+/**
+ * Segments stored as coordinate arrays: either four arrays of their own (stride 1), or the
+ * points of a chain (stride 2, the ends of a segment being the start of the next one).
+ */
+struct SEG_ARRAYS
+{
+    const int32_t* m_ax;
+    const int32_t* m_ay;
+    const int32_t* m_bx;
+    const int32_t* m_by;
+    size_t         m_stride;
+
+    const SEG Segment( size_t aIndex ) const
+    {
+        size_t ii = aIndex * m_stride;
+
+        return SEG( VECTOR2I( m_ax[ii], m_ay[ii] ), VECTOR2I( m_bx[ii], m_by[ii] ) );
+    }
+};
+
+
+/**
+ * The bounding box of the tested segment, and the squared distance under which the segments
+ * whose bounding box is closer than that are kept.
+ */
+struct QUERY
+{
+    double m_minX;
+    double m_minY;
+    double m_maxX;
+    double m_maxY;
+    double m_limit;
+};
+
+
+/**
+ * Screens the segments [aBegin, aEnd) and writes the indices of the ones kept to aOut, in
+ * increasing order.
+ * @return the number of segments kept.
+ */
+typedef size_t ( *FILTER_FUNC )( const SEG_ARRAYS& aSegs, size_t aBegin, size_t aEnd,
+                                 const QUERY& aQuery, uint32_t* aOut );
+
+
+size_t filterScalar( const SEG_ARRAYS& aSegs, size_t aBegin, size_t aEnd, const QUERY& aQuery,
+                     uint32_t* aOut )
+{
+    size_t count = 0;
+
+    for( size_t ii = aBegin; ii < aEnd; ii++ )
+    {
+        size_t k = ii * aSegs.m_stride;
+        double ax = aSegs.m_ax[k];
+        double ay = aSegs.m_ay[k];
+        double bx = aSegs.m_bx[k];
+        double by = aSegs.m_by[k];
+
+        double dx = std::max( 0.0, std::max( aQuery.m_minX - std::max( ax, bx ),
+                                             std::min( ax, bx ) - aQuery.m_maxX ) );
+        double dy = std::max( 0.0, std::max( aQuery.m_minY - std::max( ay, by ),
+                                             std::min( ay, by ) - aQuery.m_maxY ) );
+
+        if( dx * dx + dy * dy < aQuery.m_limit )
+            aOut[count++] = (uint32_t) ii;
+    }
+
+    return count;
+}
+
+
+#ifdef SEG_BATCH_X86
+
+template <bool CHAIN>
+SEG_BATCH_TARGET( "sse4.1" )
+size_t filterSse4( const SEG_ARRAYS& aSegs, size_t aBegin, size_t aEnd, const QUERY& aQuery,
+                   uint32_t* aOut )
+{
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d minX = _mm_set1_pd( aQuery.m_minX );
+    const __m128d minY = _mm_set1_pd( aQuery.m_minY );
+    const __m128d maxX = _mm_set1_pd( aQuery.m_maxX );
+    const __m128d maxY = _mm_set1_pd( aQuery.m_maxY );
+    const __m128d limit = _mm_set1_pd( aQuery.m_limit );
+
+    size_t count = 0;
+    size_t ii = aBegin;
+
+    for( ; ii + 2 <= aEnd; ii += 2 )
+    {
+        __m128d ax, ay, bx, by;
+
+        if( CHAIN )
+        {
+            // x0 y0 x1 y1 -> x0 x1 y0 y1
+            __m128i a = _mm_loadu_si128( (const __m128i*) ( aSegs.m_ax + 2 * ii ) );
+            __m128i b = _mm_loadu_si128( (const __m128i*) ( aSegs.m_bx + 2 * ii ) );
+
+            a = _mm_shuffle_epi32( a, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+            b = _mm_shuffle_epi32( b, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+            ax = _mm_cvtepi32_pd( a );
+            ay = _mm_cvtepi32_pd( _mm_unpackhi_epi64( a, a ) );
+            bx = _mm_cvtepi32_pd( b );
+            by = _mm_cvtepi32_pd( _mm_unpackhi_epi64( b, b ) );
+        }
+        else
+        {
+            ax = _mm_cvtepi32_pd( _mm_loadl_epi64( (const __m128i*) ( aSegs.m_ax + ii ) ) );
+            ay = _mm_cvtepi32_pd( _mm_loadl_epi64( (const __m128i*) ( aSegs.m_ay + ii ) ) );
+            bx = _mm_cvtepi32_pd( _mm_loadl_epi64( (const __m128i*) ( aSegs.m_bx + ii ) ) );
+            by = _mm_cvtepi32_pd( _mm_loadl_epi64( (const __m128i*) ( aSegs.m_by + ii ) ) );
+        }
+
+        __m128d dx = _mm_max_pd( _mm_sub_pd( minX, _mm_max_pd( ax, bx ) ),
+                                 _mm_sub_pd( _mm_min_pd( ax, bx ), maxX ) );
+        __m128d dy = _mm_max_pd( _mm_sub_pd( minY, _mm_max_pd( ay, by ) ),
+                                 _mm_sub_pd( _mm_min_pd( ay, by ), maxY ) );
+
+        dx = _mm_max_pd( dx, zero );
+        dy = _mm_max_pd( dy, zero );
+
+        __m128d d2 = _mm_add_pd( _mm_mul_pd( dx, dx ), _mm_mul_pd( dy, dy ) );
+        int     mask = _mm_movemask_pd( _mm_cmplt_pd( d2, limit ) );
+
+        for( int lane = 0; lane < 2; lane++ )
+        {
+            if( mask & ( 1 << lane ) )
+                aOut[count++] = (uint32_t) ( ii + lane );
+        }
+    }
+
+    return count + filterScalar( aSegs, ii, aEnd, aQuery, aOut + count );
+}
+
+
+template <bool CHAIN>
+SEG_BATCH_TARGET( "avx2" )
+size_t filterAvx2( const SEG_ARRAYS& aSegs, size_t aBegin, size_t aEnd, const QUERY& aQuery,
+                   uint32_t* aOut )
+{
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d minX = _mm256_set1_pd( aQuery.m_minX );
+    const __m256d minY = _mm256_set1_pd( aQuery.m_minY );
+    const __m256d maxX = _mm256_set1_pd( aQuery.m_maxX );
+    const __m256d maxY = _mm256_set1_pd( aQuery.m_maxY );
+    const __m256d limit = _mm256_set1_pd( aQuery.m_limit );
+    const __m256i deinterleave = _mm256_setr_epi32( 0, 2, 4, 6, 1, 3, 5, 7 );
+
+    size_t count = 0;
+    size_t ii = aBegin;
+
+    for( ; ii + 4 <= aEnd; ii += 4 )
+    {
+        __m256d ax, ay, bx, by;
+
+        if( CHAIN )
+        {
+            // x0 y0 x1 y1 x2 y2 x3 y3 -> x0 x1 x2 x3 y0 y1 y2 y3
+            __m256i a = _mm256_loadu_si256( (const __m256i*) ( aSegs.m_ax + 2 * ii ) );
+            __m256i b = _mm256_loadu_si256( (const __m256i*) ( aSegs.m_bx + 2 * ii ) );
+
+            a = _mm256_permutevar8x32_epi32( a, deinterleave );
+            b = _mm256_permutevar8x32_epi32( b, deinterleave );
+
+            ax = _mm256_cvtepi32_pd( _mm256_castsi256_si128( a ) );
+            ay = _mm256_cvtepi32_pd( _mm256_extracti128_si256( a, 1 ) );
+            bx = _mm256_cvtepi32_pd( _mm256_castsi256_si128( b ) );
+            by = _mm256_cvtepi32_pd( _mm256_extracti128_si256( b, 1 ) );
+        }
+        else
+        {
+            ax = _mm256_cvtepi32_pd( _mm_loadu_si128( (const __m128i*) ( aSegs.m_ax + ii ) ) );
+            ay = _mm256_cvtepi32_pd( _mm_loadu_si128( (const __m128i*) ( aSegs.m_ay + ii ) ) );
+            bx = _mm256_cvtepi32_pd( _mm_loadu_si128( (const __m128i*) ( aSegs.m_bx + ii ) ) );
+            by = _mm256_cvtepi32_pd( _mm_loadu_si128( (const __m128i*) ( aSegs.m_by + ii ) ) );
+        }
+
+        __m256d dx = _mm256_max_pd( _mm256_sub_pd( minX, _mm256_max_pd( ax, bx ) ),
+                                    _mm256_sub_pd( _mm256_min_pd( ax, bx ), maxX ) );
+        __m256d dy = _mm256_max_pd( _mm256_sub_pd( minY, _mm256_max_pd( ay, by ) ),
+                                    _mm256_sub_pd( _mm256_min_pd( ay, by ), maxY ) );
+
+        dx = _mm256_max_pd( dx, zero );
+        dy = _mm256_max_pd( dy, zero );
+
+        __m256d d2 = _mm256_add_pd( _mm256_mul_pd( dx, dx ), _mm256_mul_pd( dy, dy ) );
+        int     mask = _mm256_movemask_pd( _mm256_cmp_pd( d2, limit, _CMP_LT_OQ ) );
+
+        for( int lane = 0; lane < 4; lane++ )
+        {
+            if( mask & ( 1 << lane ) )
+                aOut[count++] = (uint32_t) ( ii + lane );
+        }
+    }
+
+    return count + filterScalar( aSegs, ii, aEnd, aQuery, aOut + count );
+}
+
+#endif // SEG_BATCH_X86
+
+
+bool cpuSupports( SEG_BATCH::KERNEL aKernel )
+{
+    if( aKernel == SEG_BATCH::KERNEL_SCALAR )
+        return true;
+
+#if defined( SEG_BATCH_X86 ) && defined( _MSC_VER )
+    int info[4];
+
+    __cpuid( info, 0 );
+    int maxLeaf = info[0];
+
+    __cpuid( info, 1 );
+
+    if( aKernel == SEG_BATCH::KERNEL_SSE4 )
+        return ( info[2] & ( 1 << 19 ) ) != 0;
+
+    // AVX2 also needs the OS to save the AVX registers
+    bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+    bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+
+    if( maxLeaf < 7 || !osxsave || !avx || ( _xgetbv( 0 ) & 6 ) != 6 )
+        return false;
+
+    __cpuidex( info, 7, 0 );
+    return ( info[1] & ( 1 << 5 ) ) != 0;
+#elif defined( SEG_BATCH_X86 )
+    __builtin_cpu_init();
+
+    if( aKernel == SEG_BATCH::KERNEL_SSE4 )
+        return __builtin_cpu_supports( "sse4.1" );
+
+    return __builtin_cpu_supports( "avx2" );
+#else
+    return false;
+#endif
+}
+
+
+SEG_BATCH::KERNEL bestKernel()
+{
+    if( cpuSupports( SEG_BATCH::KERNEL_AVX2 ) )
+        return SEG_BATCH::KERNEL_AVX2;
+
+    if( cpuSupports( SEG_BATCH::KERNEL_SSE4 ) )
+        return SEG_BATCH::KERNEL_SSE4;
+
+    return SEG_BATCH::KERNEL_SCALAR;
+}
+
+
+std::atomic<int>& kernelSetting()
+{
+    static std::atomic<int> kernel( bestKernel() );
+
+    return kernel;
+}
+
+
+FILTER_FUNC filterFunc( const SEG_ARRAYS& aSegs )
+{
+    bool chain = aSegs.m_stride != 1;
+
+    switch( kernelSetting().load( std::memory_order_relaxed ) )
+    {
+#ifdef SEG_BATCH_X86
+    case SEG_BATCH::KERNEL_AVX2: return chain ? filterAvx2<true> : filterAvx2<false>;
+    case SEG_BATCH::KERNEL_SSE4: return chain ? filterSse4<true> : filterSse4<false>;
+#endif
+    default:                     return filterScalar;
+    }
+}
+
+
+QUERY makeQuery( const SEG& aSeg )
+{
+    QUERY query;
+
+    query.m_minX = std::min( aSeg.A.x, aSeg.B.x );
+    query.m_minY = std::min( aSeg.A.y, aSeg.B.y );
+    query.m_maxX = std::max( aSeg.A.x, aSeg.B.x );
+    query.m_maxY = std::max( aSeg.A.y, aSeg.B.y );
+    query.m_limit = std::numeric_limits<double>::infinity();
+
+    return query;
+}
+
+
+int collide( const SEG_ARRAYS& aSegs, size_t aCount, const SEG& aSeg, int aClearance )
+{
+    FILTER_FUNC filter = filterFunc( aSegs );
+    QUERY       query = makeQuery( aSeg );
+    uint32_t    candidates[BLOCK_SIZE];
+
+    // PointCloserThan() squares the clearance, a negative one acts as a positive one
+    double reach = std::abs( (double) aClearance ) + COLLIDE_SLACK;
+
+    query.m_limit = reach * reach * ( 1.0 + LIMIT_MARGIN ) + 1.0;
+
+    for( size_t begin = 0; begin < aCount; begin += BLOCK_SIZE )
+    {
+        size_t count = filter( aSegs, begin, std::min( aCount, begin + BLOCK_SIZE ), query,
+                               candidates );
+
+        for( size_t ii = 0; ii < count; ii++ )
+        {
+            if( aSegs.Segment( candidates[ii] ).Collide( aSeg, aClearance ) )
+                return (int) candidates[ii];
+        }
+    }
+
+    return -1;
+}
+
+
+template <typename DISTANCE_FUNC>
+SEG::ecoord nearest( const SEG_ARRAYS& aSegs, size_t aCount, const SEG& aQuery,
+                     DISTANCE_FUNC aDistance, int* aIndex )
+{
+    FILTER_FUNC filter = filterFunc( aSegs );
+    QUERY       query = makeQuery( aQuery );
+    uint32_t    candidates[BLOCK_SIZE];
+    SEG::ecoord best = VECTOR2I::ECOORD_MAX;
+    int         bestIndex = -1;
+
+    for( size_t begin = 0; begin < aCount && best > 0; begin += BLOCK_SIZE )
+    {
+        // A segment whose box is farther than the nearest one found so far can't be nearer
+        if( best != VECTOR2I::ECOORD_MAX )
+        {
+            double reach = std::sqrt( (double) best ) + DISTANCE_SLACK;
+
+            query.m_limit = reach * reach * ( 1.0 + LIMIT_MARGIN ) + 1.0;
+        }
+
+        size_t count = filter( aSegs, begin, std::min( aCount, begin + BLOCK_SIZE ), query,
+                               candidates );
+
+        for( size_t ii = 0; ii < count; ii++ )
+        {
+            SEG::ecoord d = aDistance( aSegs.Segment( candidates[ii] ) );
+
+            if( d < best )
+            {
+                best = d;
+                bestIndex = (int) candidates[ii];
+            }
+        }
+    }
+
+    if( aIndex )
+        *aIndex = bestIndex;
+
+    return best;
+}
+
+
+SEG_ARRAYS chainArrays( const VECTOR2I* aPoints )
+{
+    const int32_t* coords = reinterpret_cast<const int32_t*>( aPoints );
+
+    return SEG_ARRAYS{ coords, coords + 1, coords + 2, coords + 3, 2 };
+}
+
+}
+
+
+void SEG_BATCH::Clear()
+{
+    m_ax.clear();
+    m_ay.clear();
+    m_bx.clear();
+    m_by.clear();
+}
+
+
+void SEG_BATCH::Reserve( size_t aCount )
+{
+    m_ax.reserve( aCount );
+    m_ay.reserve( aCount );
+    m_bx.reserve( aCount );
+    m_by.reserve( aCount );
+}
+
+
+void SEG_BATCH::Append( const SEG& aSeg )
+{
+    m_ax.push_back( aSeg.A.x );
+    m_ay.push_back( aSeg.A.y );
+    m_bx.push_back( aSeg.B.x );
+    m_by.push_back( aSeg.B.y );
+}
+
+
+int SEG_BATCH::Collide( const SEG& aSeg, int aClearance ) const
+{
+    SEG_ARRAYS segs{ m_ax.data(), m_ay.data(), m_bx.data(), m_by.data(), 1 };
+
+    return collide( segs, Size(), aSeg, aClearance );
+}
+
+
+SEG::ecoord SEG_BATCH::SquaredDistance( const SEG& aSeg, int* aIndex ) const
+{
+    SEG_ARRAYS segs{ m_ax.data(), m_ay.data(), m_bx.data(), m_by.data(), 1 };
+
+    return nearest( segs, Size(), aSeg,
+                    [&aSeg]( const SEG& aOther )
+                    {
+                        return aOther.SquaredDistance( aSeg );
+                    },
+                    aIndex );
+}
+
+
+SEG::ecoord SEG_BATCH::SquaredDistance( const VECTOR2I& aP, int* aIndex ) const
+{
+    SEG_ARRAYS segs{ m_ax.data(), m_ay.data(), m_bx.data(), m_by.data(), 1 };
+
+    return nearest( segs, Size(), SEG( aP, aP ),
+                    [&aP]( const SEG& aOther )
+                    {
+                        return aOther.SquaredDistance( aP );
+                    },
+                    aIndex );
+}
+
+
+int SEG_BATCH::CollideChain( const VECTOR2I* aPoints, size_t aCount, const SEG& aSeg,
+                             int aClearance )
+{
+    return collide( chainArrays( aPoints ), aCount, aSeg, aClearance );
+}
+
+
+SEG::ecoord SEG_BATCH::SquaredDistanceChain( const VECTOR2I* aPoints, size_t aCount,
+                                             const VECTOR2I& aP, int* aIndex )
+{
+    return nearest( chainArrays( aPoints ), aCount, SEG( aP, aP ),
+                    [&aP]( const SEG& aOther )
+                    {
+                        return aOther.SquaredDistance( aP );
+                    },
+                    aIndex );
+}
+
+
+SEG_BATCH::KERNEL SEG_BATCH::GetKernel()
+{
+    return (KERNEL) kernelSetting().load( std::memory_order_relaxed );
+}
+
+
+bool SEG_BATCH::SetKernel( KERNEL aKernel )
+{
+    if( !IsKernelSupported( aKernel ) )
+        return false;
+
+    kernelSetting().store( aKernel, std::memory_order_relaxed );
+    return true;
+}
+
+
+bool SEG_BATCH::IsKernelSupported( KERNEL aKernel )
+{
+    return cpuSupports( aKernel );
+}
+
+
+const char* SEG_BATCH::KernelName( KERNEL aKernel )
+{
+    switch( aKernel )
+    {
+    case KERNEL_SSE4: return "sse4";
+    case KERNEL_AVX2: return "avx2";
+    default:          return "scalar";
+    }
+}
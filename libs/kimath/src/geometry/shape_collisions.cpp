@@ -156,16 +156,8 @@ static VECTOR2I pushoutForce( const SHAPE_CIRCLE& aA, const SEG& aB, int aCleara
 static inline bool Collide( const SHAPE_CIRCLE& aA, const SHAPE_LINE_CHAIN& aB, int aClearance,
                             bool aNeedMTV, VECTOR2I& aMTV )
 {
-    bool found = false;
-
-    for( int s = 0; s < aB.SegmentCount(); s++ )
-    {
-        if( aA.Collide( aB.CSegment( s ), aClearance ) )
-        {
-            found = true;
-            break;
-        }
-    }
+    // Distance to the outline, same as aA.Collide() on every segment
+    bool found = aB.Distance( aA.GetCenter(), true ) < aClearance + aA.GetRadius();
 
     if( !aNeedMTV || !found )
         return found;
@@ -29,6 +29,7 @@
 
 #include <clipper.hpp>
 #include <geometry/seg.h>    // for SEG, OPT_VECTOR2I
+#include <geometry/seg_batch.h>
 #include <geometry/shape_line_chain.h>
 #include <math/box2.h>       // for BOX2I
 #include <math/util.h>  // for rescale
@@ -109,24 +110,13 @@ void SHAPE_LINE_CHAIN::Rotate( double aAngle, const VECTOR2I& aCenter )
 
 bool SHAPE_LINE_CHAIN::Collide( const SEG& aSeg, int aClearance ) const
 {
-    BOX2I box_a( aSeg.A, aSeg.B - aSeg.A );
-    BOX2I::ecoord_type dist_sq = (BOX2I::ecoord_type) aClearance * aClearance;
-
-    for( int i = 0; i < SegmentCount(); i++ )
-    {
-        const SEG& s = CSegment( i );
-        BOX2I box_b( s.A, s.B - s.A );
-
-        BOX2I::ecoord_type d = box_a.SquaredDistance( box_b );
+    if( m_points.empty() )
+        return false;
 
-        if( d < dist_sq )
-        {
-            if( s.Collide( aSeg, aClearance ) )
-                return true;
-        }
-    }
+    if( SEG_BATCH::CollideChain( m_points.data(), m_points.size() - 1, aSeg, aClearance ) >= 0 )
+        return true;
 
-    return false;
+    return m_closed && CSegment( -1 ).Collide( aSeg, aClearance );
 }
 
 
@@ -272,8 +262,18 @@ int SHAPE_LINE_CHAIN::Distance( const VECTOR2I& aP, bool aOutlineOnly ) const
     if( IsClosed() && PointInside( aP ) && !aOutlineOnly )
         return 0;
 
-    for( int s = 0; s < SegmentCount(); s++ )
-        d = std::min( d, CSegment( s ).Distance( aP ) );
+    if( m_points.empty() )
+        return d;
+
+    SEG::ecoord d_sq = SEG_BATCH::SquaredDistanceChain( m_points.data(), m_points.size() - 1,
+                                                        aP );
+
+    if( m_closed )
+        d_sq = std::min( d_sq, CSegment( -1 ).SquaredDistance( aP ) );
+
+    // Same rounding as SEG::Distance()
+    if( d_sq != VECTOR2I::ECOORD_MAX )
+        d = sqrt( d_sq );
 
     return d;
 }
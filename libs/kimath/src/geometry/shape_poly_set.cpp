@@ -28,10 +28,12 @@
 
 #include <algorithm>
 #include <assert.h>                          // for assert
+#include <chrono>
 #include <cmath>                             // for sqrt, cos, hypot, isinf
 #include <cstdio>
 #include <istream>                           // for operator<<, operator>>
 #include <limits>                            // for numeric_limits
+#include <map>
 #include <memory>
 #include <set>
 #include <string>                            // for char_traits, operator!=
@@ -69,6 +71,7 @@ SHAPE_POLY_SET::SHAPE_POLY_SET( const SHAPE_POLY_SET& aOther, bool aDeepCopy ) :
             m_triangulatedPolys.push_back(
                     std::make_unique<TRIANGULATED_POLYGON>( *aOther.TriangulatedPolygon( i ) ) );
 
+        m_triangulatedSources = aOther.m_triangulatedSources;
         m_hash = aOther.GetHash();
         m_triangulationValid = true;
     }
@@ -517,6 +520,187 @@ void SHAPE_POLY_SET::BooleanIntersection( const SHAPE_POLY_SET& a,
 }
 
 
+void SHAPE_POLY_SET::BooleanSubtractPartitioned( const SHAPE_POLY_SET& b, POLYGON_MODE aFastMode,
+                                                 int aTiles, const TASK_EXECUTOR& aExecutor )
+{
+    booleanOpPartitioned( ctDifference, b, aFastMode, aTiles, aExecutor );
+}
+
+
+void SHAPE_POLY_SET::SimplifyPartitioned( POLYGON_MODE aFastMode, int aTiles,
+                                          const TASK_EXECUTOR& aExecutor )
+{
+    SHAPE_POLY_SET empty;
+
+    booleanOpPartitioned( ctUnion, empty, aFastMode, aTiles, aExecutor );
+}
+
+
+/**
+ * @return the bounding boxes of every contour of aSet, by outline then by contour index.
+ */
+static std::vector<std::vector<BOX2I>> contourBBoxes( const SHAPE_POLY_SET& aSet )
+{
+    std::vector<std::vector<BOX2I>> bboxes( aSet.OutlineCount() );
+
+    for( int ii = 0; ii < aSet.OutlineCount(); ii++ )
+    {
+        for( const SHAPE_LINE_CHAIN& contour : aSet.CPolygon( ii ) )
+            bboxes[ii].push_back( contour.BBox() );
+    }
+
+    return bboxes;
+}
+
+
+/**
+ * Copy to aDest the outlines of aSource crossing aBox, with their holes crossing aBox.  Holes
+ * entirely outside of aBox are dropped: they cannot change anything inside of it.
+ */
+static void appendContoursInBox( SHAPE_POLY_SET& aDest, const SHAPE_POLY_SET& aSource,
+                                 const std::vector<std::vector<BOX2I>>& aBBoxes,
+                                 const BOX2I& aBox )
+{
+    for( int ii = 0; ii < aSource.OutlineCount(); ii++ )
+    {
+        const SHAPE_POLY_SET::POLYGON& polygon = aSource.CPolygon( ii );
+
+        if( !aBBoxes[ii][0].Intersects( aBox ) )
+            continue;
+
+        int outline = aDest.AddOutline( polygon[0] );
+
+        for( size_t jj = 1; jj < polygon.size(); jj++ )
+        {
+            if( aBBoxes[ii][jj].Intersects( aBox ) )
+                aDest.AddHole( polygon[jj], outline );
+        }
+    }
+}
+
+
+void SHAPE_POLY_SET::booleanOpPartitioned( ClipperLib::ClipType aType,
+                                           const SHAPE_POLY_SET& aOtherShape,
+                                           POLYGON_MODE aFastMode, int aTiles,
+                                           const TASK_EXECUTOR& aExecutor )
+{
+    assert( aType == ctUnion || aType == ctDifference || aType == ctIntersection );
+
+    // A difference or an intersection lies inside this set; a union inside both sets
+    BOX2I bbox = BBox();
+
+    if( aType == ctUnion && aOtherShape.OutlineCount() )
+        bbox.Merge( aOtherShape.BBox() );
+
+    if( aTiles <= 1 || OutlineCount() == 0 )
+    {
+        booleanOp( aType, aOtherShape, aFastMode );
+        return;
+    }
+
+    const int64_t tileWidth  = ( (int64_t) bbox.GetWidth() + aTiles - 1 ) / aTiles + 1;
+    const int64_t tileHeight = ( (int64_t) bbox.GetHeight() + aTiles - 1 ) / aTiles + 1;
+
+    // Neighbouring tiles overlap a little, so that the rounding of the points added where
+    // the tile borders cut edges cannot leave slivers between the tile results
+    const int64_t overlap = std::max<int64_t>( 1, std::min( tileWidth, tileHeight ) / 64 );
+
+    const std::vector<std::vector<BOX2I>> bboxes = contourBBoxes( *this );
+    const std::vector<std::vector<BOX2I>> otherBBoxes = contourBBoxes( aOtherShape );
+
+    std::vector<SHAPE_POLY_SET> pieces( (size_t) aTiles * aTiles );
+
+    auto tileBox =
+            [&]( size_t aIndex )
+            {
+                int x0 = (int) ( bbox.GetX() + (int64_t) ( aIndex % aTiles ) * tileWidth - overlap );
+                int y0 = (int) ( bbox.GetY() + (int64_t) ( aIndex / aTiles ) * tileHeight - overlap );
+
+                return BOX2I( VECTOR2I( x0, y0 ), VECTOR2I( (int) ( tileWidth + 2 * overlap ),
+                                                            (int) ( tileHeight + 2 * overlap ) ) );
+            };
+
+    auto doTile =
+            [&]( size_t aIndex )
+            {
+                BOX2I          box = tileBox( aIndex );
+                int            x0 = box.GetX();
+                int            y0 = box.GetY();
+                int            x1 = box.GetRight();
+                int            y1 = box.GetBottom();
+                SHAPE_POLY_SET tile;
+                SHAPE_POLY_SET subject;
+                SHAPE_POLY_SET clip;
+
+                tile.NewOutline();
+                tile.Append( x0, y0 );
+                tile.Append( x1, y0 );
+                tile.Append( x1, y1 );
+                tile.Append( x0, y1 );
+
+                appendContoursInBox( subject, *this, bboxes, box );
+                appendContoursInBox( clip, aOtherShape, otherBBoxes, box );
+
+                SHAPE_POLY_SET& piece = pieces[aIndex];
+
+                if( aType == ctUnion )
+                {
+                    // Overlapping subject contours are merged by the non-zero fill rule
+                    subject.Append( clip );
+                    piece.booleanOp( ctIntersection, subject, tile, aFastMode );
+                }
+                else
+                {
+                    piece.booleanOp( ctIntersection, subject, tile, aFastMode );
+                    piece.booleanOp( aType, clip, aFastMode );
+                }
+            };
+
+    if( aExecutor )
+    {
+        aExecutor( pieces.size(), doTile );
+    }
+    else
+    {
+        for( size_t ii = 0; ii < pieces.size(); ii++ )
+            doTile( ii );
+    }
+
+    // Only the polygons reaching the borders a tile shares with its neighbours can be cut by
+    // them or overlap the pieces of the neighbours.  The others are final: a neighbour covers
+    // no more than 2 * overlap of a tile.  Only the former are stitched back together.
+    SHAPE_POLY_SET seams;
+    const int      border = (int) ( 2 * overlap + 1 );
+
+    m_polys.clear();
+
+    for( size_t ii = 0; ii < pieces.size(); ii++ )
+    {
+        BOX2I box = tileBox( ii );
+        int   col = (int) ( ii % aTiles );
+        int   row = (int) ( ii / aTiles );
+        int   left = box.GetX() + ( col > 0 ? border : 0 );
+        int   top = box.GetY() + ( row > 0 ? border : 0 );
+        int   right = box.GetRight() - ( col < aTiles - 1 ? border : 0 );
+        int   bottom = box.GetBottom() - ( row < aTiles - 1 ? border : 0 );
+        BOX2I inner( VECTOR2I( left, top ), VECTOR2I( right - left, bottom - top ) );
+
+        for( POLYGON& polygon : pieces[ii].m_polys )
+        {
+            if( inner.Contains( polygon[0].BBox() ) )
+                m_polys.push_back( std::move( polygon ) );
+            else
+                seams.m_polys.push_back( std::move( polygon ) );
+        }
+    }
+
+    seams.Simplify( aFastMode );
+
+    m_polys.insert( m_polys.end(), std::make_move_iterator( seams.m_polys.begin() ),
+                    std::make_move_iterator( seams.m_polys.end() ) );
+}
+
+
 void SHAPE_POLY_SET::InflateWithLinkedHoles( int aFactor, int aCircleSegmentsCount,
                                              POLYGON_MODE aFastMode )
 {
@@ -1550,7 +1734,7 @@ SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::FilletPolygon( unsigned int aRadius, int
 }
 
 
-int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex )
+int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex ) const
 {
     // We calculate the min dist between the segment and each outline segment.  However, if the
     // segment to test is inside the outline, and does not cross any edge, it can be seen outside
@@ -1559,7 +1743,7 @@ int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex )
     if( containsSingle( aPoint, aPolygonIndex, 1 ) )
         return 0;
 
-    SEGMENT_ITERATOR iterator = IterateSegmentsWithHoles( aPolygonIndex );
+    CONST_SEGMENT_ITERATOR iterator = CIterateSegmentsWithHoles( aPolygonIndex );
 
     SEG polygonEdge = *iterator;
     int minDistance = polygonEdge.Distance( aPoint );
@@ -1578,7 +1762,8 @@ int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex )
 }
 
 
-int SHAPE_POLY_SET::DistanceToPolygon( const SEG& aSegment, int aPolygonIndex, int aSegmentWidth )
+int SHAPE_POLY_SET::DistanceToPolygon( const SEG& aSegment, int aPolygonIndex,
+                                       int aSegmentWidth ) const
 {
     // We calculate the min dist between the segment and each outline segment.  However, if the
     // segment to test is inside the outline, and does not cross any edge, it can be seen outside
@@ -1587,7 +1772,7 @@ int SHAPE_POLY_SET::DistanceToPolygon( const SEG& aSegment, int aPolygonIndex, i
     if( containsSingle( aSegment.A, aPolygonIndex, 1 ) )
         return 0;
 
-    SEGMENT_ITERATOR iterator = IterateSegmentsWithHoles( aPolygonIndex );
+    CONST_SEGMENT_ITERATOR iterator = CIterateSegmentsWithHoles( aPolygonIndex );
 
     SEG polygonEdge = *iterator;
     int minDistance = polygonEdge.Distance( aSegment );
@@ -1611,7 +1796,7 @@ int SHAPE_POLY_SET::DistanceToPolygon( const SEG& aSegment, int aPolygonIndex, i
 }
 
 
-int SHAPE_POLY_SET::Distance( VECTOR2I aPoint )
+int SHAPE_POLY_SET::Distance( VECTOR2I aPoint ) const
 {
     int currentDistance;
     int minDistance = DistanceToPolygon( aPoint, 0 );
@@ -1629,7 +1814,7 @@ int SHAPE_POLY_SET::Distance( VECTOR2I aPoint )
 }
 
 
-int SHAPE_POLY_SET::Distance( const SEG& aSegment, int aSegmentWidth )
+int SHAPE_POLY_SET::Distance( const SEG& aSegment, int aSegmentWidth ) const
 {
     int currentDistance;
     int minDistance = DistanceToPolygon( aSegment, 0, aSegmentWidth );
@@ -1853,13 +2038,37 @@ SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::chamferFilletPolygon( CORNER_MODE aMode,
 
 SHAPE_POLY_SET &SHAPE_POLY_SET::operator=( const SHAPE_POLY_SET& aOther )
 {
+    if( &aOther == this )
+        return *this;
+
     static_cast<SHAPE&>(*this) = aOther;
     m_polys = aOther.m_polys;
 
-    // reset poly cache:
+    // Our triangles no longer match our polygons, but CacheTriangulation() can pick from them
+    if( !m_triangulatedPolys.empty() )
+    {
+        m_staleTriangulatedPolys = std::move( m_triangulatedPolys );
+        m_staleTriangulatedSources = std::move( m_triangulatedSources );
+    }
+
+    m_triangulatedPolys.clear();
+    m_triangulatedSources.clear();
     m_hash = MD5_HASH{};
     m_triangulationValid = false;
-    m_triangulatedPolys.clear();
+
+    if( aOther.IsTriangulationUpToDate() )
+    {
+        for( unsigned i = 0; i < aOther.TriangulatedPolyCount(); i++ )
+            m_triangulatedPolys.push_back(
+                    std::make_unique<TRIANGULATED_POLYGON>( *aOther.TriangulatedPolygon( i ) ) );
+
+        m_triangulatedSources = aOther.m_triangulatedSources;
+        m_hash = aOther.GetHash();
+        m_triangulationValid = true;
+        m_staleTriangulatedPolys.clear();
+        m_staleTriangulatedSources.clear();
+    }
+
     return *this;
 }
 
@@ -1886,7 +2095,82 @@ bool SHAPE_POLY_SET::IsTriangulationUpToDate() const
 }
 
 
-void SHAPE_POLY_SET::CacheTriangulation()
+static void hashPolygon( MD5_HASH& aHash, const SHAPE_POLY_SET::POLYGON& aPolygon )
+{
+    aHash.Hash( aPolygon.size() );
+
+    for( const SHAPE_LINE_CHAIN& lc : aPolygon )
+    {
+        aHash.Hash( lc.PointCount() );
+
+        for( int i = 0; i < lc.PointCount(); i++ )
+        {
+            aHash.Hash( lc.CPoint( i ).x );
+            aHash.Hash( lc.CPoint( i ).y );
+        }
+    }
+}
+
+
+///> The hash of a single polygon, hashed as checksum() hashes each polygon of the set
+static MD5_HASH polygonHash( const SHAPE_POLY_SET::POLYGON& aPolygon )
+{
+    MD5_HASH hash;
+
+    hashPolygon( hash, aPolygon );
+    hash.Finalize();
+
+    return hash;
+}
+
+
+bool SHAPE_POLY_SET::triangulateSingle( const POLYGON& aPolygon,
+                                        std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>& aResult )
+{
+    SHAPE_POLY_SET tmpSet;
+    bool           ok = true;
+    bool           retried = false;
+
+    tmpSet.m_polys.push_back( aPolygon );
+
+    if( tmpSet.HasHoles() )
+        tmpSet.Fracture( PM_FAST );
+
+    while( tmpSet.OutlineCount() > 0 )
+    {
+        auto                 triangulated = std::make_unique<TRIANGULATED_POLYGON>();
+        PolygonTriangulation tess( *triangulated );
+
+        // If the tesselation fails, we re-fracture the polygon, which will
+        // first simplify the system before fracturing and removing the holes
+        // This may result in multiple, disjoint polygons.  Give up on an outline
+        // which still fails after that.
+        if( !tess.TesselatePolygon( tmpSet.Polygon( 0 ).front() ) )
+        {
+            ok = false;
+
+            if( !retried )
+            {
+                tmpSet.Fracture( PM_FAST );
+                retried = true;
+                continue;
+            }
+        }
+        else
+        {
+            aResult.push_back( std::move( triangulated ) );
+        }
+
+        tmpSet.DeletePolygon( 0 );
+        retried = false;
+    }
+
+    return ok;
+}
+
+
+void SHAPE_POLY_SET::CacheTriangulation( const TASK_EXECUTOR& aExecutor,
+                                         TRIANGULATION_STATS* aStats )
 {
     bool recalculate = !m_hash.IsValid();
     MD5_HASH hash;
@@ -1905,34 +2189,108 @@ void SHAPE_POLY_SET::CacheTriangulation()
         }
     }
 
+    if( aStats )
+    {
+        aStats->m_reused = recalculate ? 0 : OutlineCount();
+        aStats->m_triangulated = 0;
+        aStats->m_times.assign( m_polys.size(), 0.0 );
+    }
+
     if( !recalculate )
         return;
 
-    SHAPE_POLY_SET tmpSet = *this;
+    auto runAll = [&]( size_t aCount, const std::function<void( size_t )>& aTask )
+                  {
+                      if( aExecutor )
+                      {
+                          aExecutor( aCount, aTask );
+                      }
+                      else
+                      {
+                          for( size_t ii = 0; ii < aCount; ii++ )
+                              aTask( ii );
+                      }
+                  };
+
+    // The triangles we had, by the polygon they were built from
+    std::map<MD5_HASH, std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>> cache;
+
+    auto addToCache = [&]( std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>& aPolys,
+                           std::vector<MD5_HASH>& aSources )
+                      {
+                          for( size_t ii = 0; ii < aPolys.size() && ii < aSources.size(); ii++ )
+                          {
+                              if( aSources[ii].IsValid() )
+                                  cache[ aSources[ii] ].push_back( std::move( aPolys[ii] ) );
+                          }
+
+                          aPolys.clear();
+                          aSources.clear();
+                      };
+
+    addToCache( m_triangulatedPolys, m_triangulatedSources );
+    addToCache( m_staleTriangulatedPolys, m_staleTriangulatedSources );
+
+    std::vector<MD5_HASH> sources( m_polys.size() );
+    std::vector<std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>> results( m_polys.size() );
+    std::vector<size_t> toTriangulate;
+    std::vector<char> failed( m_polys.size(), false );
+
+    runAll( m_polys.size(), [&]( size_t ii ) { sources[ii] = polygonHash( m_polys[ii] ); } );
+
+    for( size_t ii = 0; ii < m_polys.size(); ii++ )
+    {
+        auto it = cache.find( sources[ii] );
+
+        if( it != cache.end() )
+        {
+            // Moved out: a duplicate polygon in the set is triangulated again
+            results[ii] = std::move( it->second );
+            cache.erase( it );
 
-    if( tmpSet.HasHoles() )
-        tmpSet.Fracture( PM_FAST );
+            if( aStats )
+                aStats->m_reused++;
+        }
+        else
+        {
+            toTriangulate.push_back( ii );
+        }
+    }
+
+    cache.clear();
+
+    runAll( toTriangulate.size(),
+            [&]( size_t aIndex )
+            {
+                size_t ii = toTriangulate[aIndex];
+                auto   start = std::chrono::steady_clock::now();
+
+                failed[ii] = !triangulateSingle( m_polys[ii], results[ii] );
+
+                if( aStats )
+                {
+                    std::chrono::duration<double, std::milli> elapsed =
+                            std::chrono::steady_clock::now() - start;
+                    aStats->m_times[ii] = elapsed.count();
+                }
+            } );
+
+    if( aStats )
+        aStats->m_triangulated = (int) toTriangulate.size();
 
-    m_triangulatedPolys.clear();
     m_triangulationValid = true;
 
-    while( tmpSet.OutlineCount() > 0 )
+    for( size_t ii = 0; ii < m_polys.size(); ii++ )
     {
-        m_triangulatedPolys.push_back( std::make_unique<TRIANGULATED_POLYGON>() );
-        PolygonTriangulation tess( *m_triangulatedPolys.back() );
+        // A polygon which failed is not cached: it will be tried again next time
+        if( failed[ii] )
+            m_triangulationValid = false;
 
-        // If the tesselation fails, we re-fracture the polygon, which will
-        // first simplify the system before fracturing and removing the holes
-        // This may result in multiple, disjoint polygons.
-        if( !tess.TesselatePolygon( tmpSet.Polygon( 0 ).front() ) )
+        for( std::unique_ptr<TRIANGULATED_POLYGON>& triangulated : results[ii] )
         {
-            tmpSet.Fracture( PM_FAST );
-            m_triangulationValid = false;
-            continue;
+            m_triangulatedPolys.push_back( std::move( triangulated ) );
+            m_triangulatedSources.push_back( failed[ii] ? MD5_HASH() : sources[ii] );
         }
-
-        tmpSet.DeletePolygon( 0 );
-        m_triangulationValid = true;
     }
 
     if( m_triangulationValid )
@@ -1946,21 +2304,8 @@ MD5_HASH SHAPE_POLY_SET::checksum() const
 
     hash.Hash( m_polys.size() );
 
-    for( const auto& outline : m_polys )
-    {
-        hash.Hash( outline.size() );
-
-        for( const auto& lc : outline )
-        {
-            hash.Hash( lc.PointCount() );
-
-            for( int i = 0; i < lc.PointCount(); i++ )
-            {
-                hash.Hash( lc.CPoint( i ).x );
-                hash.Hash( lc.CPoint( i ).y );
-            }
-        }
-    }
+    for( const POLYGON& outline : m_polys )
+        hashPolygon( hash, outline );
 
     hash.Finalize();
 
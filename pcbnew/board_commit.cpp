@@ -27,6 +27,7 @@
 #include <pcb_edit_frame.h>
 #include <tool/tool_manager.h>
 #include <tools/selection_tool.h>
+#include <drc/drc.h>
 #include <view/view.h>
 #include <board_commit.h>
 #include <tools/pcb_tool_base.h>
@@ -91,6 +92,7 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
     auto                connectivity = board->GetConnectivity();
     std::set<EDA_ITEM*> savedModules;
     SELECTION_TOOL*     selTool = m_toolMgr->GetTool<SELECTION_TOOL>();
+    DRC*                drcTool = m_editModules ? nullptr : m_toolMgr->GetTool<DRC>();
     bool                itemsDeselected = false;
 
     if( Empty() )
@@ -163,6 +165,9 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                         board->Add( boardItem );        // handles connectivity
                 }
 
+                if( drcTool )
+                    drcTool->ItemChanged( boardItem );
+
                 view->Add( boardItem );
                 break;
             }
@@ -178,6 +183,9 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                     itemsDeselected = true;
                 }
 
+                if( drcTool )
+                    drcTool->ItemRemoved( boardItem );
+
                 switch( boardItem->Type() )
                 {
                 // Module items
@@ -263,6 +271,9 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                 connectivity->Update( boardItem );
                 view->Update( boardItem );
 
+                if( drcTool )
+                    drcTool->ItemChanged( boardItem );
+
                 // if no undo entry is needed, the copy would create a memory leak
                 if( !aCreateUndoEntry )
                     delete ent.m_copy;
@@ -280,7 +291,7 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
     {
         size_t num_changes = m_changes.size();
 
-        connectivity->RecalculateRatsnest( this );
+        connectivity->ScheduleRatsnestUpdate( this );
         connectivity->ClearDynamicRatsnest();
         frame->GetCanvas()->RedrawRatsnest();
 
@@ -295,6 +306,9 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
 
                 auto boardItem = static_cast<BOARD_ITEM*>( ent.m_item );
 
+                if( drcTool )
+                    drcTool->ItemChanged( boardItem );
+
                 if( aCreateUndoEntry )
                 {
                     ITEM_PICKER itemWrapper( boardItem, UR_CHANGED );
@@ -406,7 +420,7 @@ void BOARD_COMMIT::Revert()
     }
 
     if ( !m_editModules )
-        connectivity->RecalculateRatsnest();
+        connectivity->ScheduleRatsnestUpdate();
 
     SELECTION_TOOL* selTool = m_toolMgr->GetTool<SELECTION_TOOL>();
     selTool->RebuildSelection();
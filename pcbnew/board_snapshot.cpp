@@ -0,0 +1,626 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <board_snapshot.h>
+
+#include <build_version.h>
+#include <class_board.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <kicad_plugin.h>
+#include <macros.h>
+#include <pcb_parser.h>
+#include <richio.h>
+#include <trace_helpers.h>
+
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+
+/// Bump on any change of the layout of the header or of the binary sections
+#define BOARD_SNAPSHOT_VERSION  1
+
+static const char   snapshotMagic[8] = { 'K', 'i', 'C', 'a', 'd', 'S', 'n', 'p' };
+static const char   snapshotExtension[] = "-snapshot";
+static const size_t hashChunk = 1 << 20;
+
+
+/**
+ * Appends fixed size values to a section, in the byte order of the machine
+ */
+class SECTION_WRITER
+{
+public:
+    SECTION_WRITER( std::string& aData ) :
+        m_data( aData )
+    {}
+
+    void Bytes( const void* aData, size_t aSize )
+    {
+        m_data.append( static_cast<const char*>( aData ), aSize );
+    }
+
+    void Int( int32_t aValue )       { Bytes( &aValue, sizeof( aValue ) ); }
+    void UInt( uint32_t aValue )     { Bytes( &aValue, sizeof( aValue ) ); }
+    void UInt64( uint64_t aValue )   { Bytes( &aValue, sizeof( aValue ) ); }
+
+    void Point( const VECTOR2I& aPoint )
+    {
+        Int( aPoint.x );
+        Int( aPoint.y );
+    }
+
+    void String( const std::string& aString )
+    {
+        UInt( aString.size() );
+        Bytes( aString.data(), aString.size() );
+    }
+
+    void PolySet( const SHAPE_POLY_SET& aSet )
+    {
+        UInt( aSet.OutlineCount() );
+
+        for( int ii = 0; ii < aSet.OutlineCount(); ++ii )
+        {
+            const SHAPE_POLY_SET::POLYGON& polygon = aSet.CPolygon( ii );
+
+            UInt( polygon.size() );
+
+            for( const SHAPE_LINE_CHAIN& chain : polygon )
+            {
+                UInt( chain.PointCount() );
+
+                for( int jj = 0; jj < chain.PointCount(); ++jj )
+                    Point( chain.CPoint( jj ) );
+            }
+        }
+    }
+
+private:
+    std::string& m_data;
+};
+
+
+/**
+ * Reads back what a SECTION_WRITER wrote, throwing IO_ERROR past the end of the section
+ */
+class SECTION_READER
+{
+public:
+    SECTION_READER( const std::string& aData ) :
+        m_data( aData ),
+        m_pos( 0 )
+    {}
+
+    const char* Bytes( size_t aSize )
+    {
+        if( aSize > m_data.size() - m_pos )
+            THROW_IO_ERROR( _( "Truncated board snapshot section" ) );
+
+        const char* bytes = m_data.data() + m_pos;
+        m_pos += aSize;
+        return bytes;
+    }
+
+    template <typename T> T Value()
+    {
+        T value;
+        memcpy( &value, Bytes( sizeof( value ) ), sizeof( value ) );
+        return value;
+    }
+
+    int32_t  Int()      { return Value<int32_t>(); }
+    uint32_t UInt()     { return Value<uint32_t>(); }
+    uint64_t UInt64()   { return Value<uint64_t>(); }
+
+    /**
+     * Read a number of items taking at least \a aItemSize bytes each, checked against the
+     * rest of the section so that a damaged count cannot make room for more.
+     */
+    uint32_t Count( size_t aItemSize )
+    {
+        uint32_t count = UInt();
+
+        if( count > ( m_data.size() - m_pos ) / aItemSize )
+            THROW_IO_ERROR( _( "Truncated board snapshot section" ) );
+
+        return count;
+    }
+
+    wxPoint Point()
+    {
+        int32_t x = Int();
+        return wxPoint( x, Int() );
+    }
+
+    std::string String()
+    {
+        uint32_t size = UInt();
+        return std::string( Bytes( size ), size );
+    }
+
+    void PolySet( SHAPE_POLY_SET& aSet )
+    {
+        uint32_t outlines = UInt();
+
+        for( uint32_t ii = 0; ii < outlines; ++ii )
+        {
+            uint32_t contours = UInt();
+
+            for( uint32_t jj = 0; jj < contours; ++jj )
+            {
+                SHAPE_LINE_CHAIN chain;
+                uint32_t         points = UInt();
+
+                for( uint32_t kk = 0; kk < points; ++kk )
+                    chain.Append( Point() );
+
+                chain.SetClosed( true );
+
+                if( jj == 0 )
+                    aSet.AddOutline( chain );
+                else
+                    aSet.AddHole( chain, ii );
+            }
+        }
+    }
+
+    size_t Position() const { return m_pos; }
+
+private:
+    const std::string& m_data;
+    size_t             m_pos;
+};
+
+
+static MD5_HASH hashBytes( const char* aData, size_t aSize )
+{
+    MD5_HASH hash;
+
+    for( size_t ii = 0; ii < aSize; ii += hashChunk )
+    {
+        hash.Hash( reinterpret_cast<uint8_t*>( const_cast<char*>( aData + ii ) ),
+                   std::min( hashChunk, aSize - ii ) );
+    }
+
+    hash.Finalize();
+    return hash;
+}
+
+
+wxString BOARD_SNAPSHOT::GetFileName( const wxString& aBoardFileName )
+{
+    return aBoardFileName + snapshotExtension;
+}
+
+
+MD5_HASH BOARD_SNAPSHOT::HashFile( const wxString& aFileName )
+{
+    MD5_HASH hash;
+    wxFFile  file;
+
+    if( !wxFileExists( aFileName ) || !file.Open( aFileName, wxT( "rb" ) ) )
+        return hash;
+
+    std::vector<uint8_t> buffer( hashChunk );
+
+    while( !file.Eof() )
+    {
+        size_t count = file.Read( buffer.data(), buffer.size() );
+
+        if( file.Error() )
+            return MD5_HASH();
+
+        if( count )
+            hash.Hash( buffer.data(), count );
+    }
+
+    hash.Finalize();
+    return hash;
+}
+
+
+MD5_HASH BOARD_SNAPSHOT::HashString( const std::string& aText )
+{
+    return hashBytes( aText.data(), aText.size() );
+}
+
+
+void BOARD_SNAPSHOT::Store( BOARD* aBoard )
+{
+    PCB_IO                                  io;
+    STRING_FORMATTER                        formatter;
+    std::vector<std::pair<size_t, size_t>>  omitted;
+
+    io.m_mapping->SetBoard( aBoard );
+    io.m_out = &formatter;
+    io.m_snapshotRanges = &omitted;
+    io.formatBoardFile( aBoard );
+
+    Store( aBoard, formatter.GetString(), omitted );
+}
+
+
+void BOARD_SNAPSHOT::Store( BOARD* aBoard, const std::string& aBoardText,
+                            const std::vector<std::pair<size_t, size_t>>& aOmitted )
+{
+    m_sections.clear();
+
+    // The s-expression part: the board file but for the tracks and fills
+    std::string& board = m_sections[SECTION_BOARD];
+    size_t       pos = 0;
+
+    board.reserve( aBoardText.size() );
+
+    for( const std::pair<size_t, size_t>& range : aOmitted )
+    {
+        board.append( aBoardText, pos, range.first - pos );
+        pos = range.second;
+    }
+
+    board.append( aBoardText, pos, std::string::npos );
+
+    // The net table, in the net codes of the s-expression part
+    NETINFO_MAPPING            mapping;
+    std::vector<NETINFO_ITEM*> netList;
+    SECTION_WRITER             nets( m_sections[SECTION_NETS] );
+
+    mapping.SetBoard( aBoard );
+
+    for( NETINFO_ITEM* net : mapping )
+        netList.push_back( net );
+
+    nets.UInt( netList.size() );
+
+    for( NETINFO_ITEM* net : netList )
+    {
+        nets.Int( mapping.Translate( net->GetNet() ) );
+        nets.String( TO_UTF8( net->GetNetname() ) );
+    }
+
+    // The tracks
+    SECTION_WRITER tracks( m_sections[SECTION_TRACKS] );
+
+    tracks.UInt( aBoard->Tracks().size() );
+
+    for( TRACK* track : aBoard->Tracks() )
+    {
+        tracks.Int( track->Type() );
+        tracks.Point( track->GetStart() );
+        tracks.Point( track->GetEnd() );
+        tracks.Int( track->GetWidth() );
+
+        if( track->Type() == PCB_VIA_T )
+        {
+            VIA*         via = static_cast<VIA*>( track );
+            PCB_LAYER_ID top, bottom;
+
+            via->LayerPair( &top, &bottom );
+            tracks.Int( static_cast<int>( via->GetViaType() ) );
+            tracks.Int( via->GetDrill() );
+            tracks.Int( top );
+            tracks.Int( bottom );
+        }
+        else
+        {
+            if( track->Type() == PCB_ARC_T )
+                tracks.Point( static_cast<ARC*>( track )->GetMid() );
+
+            tracks.Int( track->GetLayer() );
+        }
+
+        tracks.Int( mapping.Translate( track->GetNetCode() ) );
+        tracks.String( TO_UTF8( track->m_Uuid.AsString() ) );
+        tracks.UInt( track->GetStatus() );
+    }
+
+    // The zone fills, in the order of the zones
+    SECTION_WRITER fills( m_sections[SECTION_ZONE_FILLS] );
+
+    fills.UInt( aBoard->GetAreaCount() );
+
+    for( int ii = 0; ii < aBoard->GetAreaCount(); ++ii )
+    {
+        ZONE_CONTAINER* zone = aBoard->GetArea( ii );
+
+        fills.PolySet( zone->GetFilledPolysList() );
+        fills.UInt( zone->FillSegments().size() );
+
+        for( const SEG& seg : zone->FillSegments() )
+        {
+            fills.Point( seg.A );
+            fills.Point( seg.B );
+        }
+    }
+}
+
+
+BOARD* BOARD_SNAPSHOT::Restore( const wxString& aSource ) const
+{
+    auto section = [&]( SECTION_ID aId ) -> const std::string&
+    {
+        auto it = m_sections.find( aId );
+
+        if( it == m_sections.end() )
+            THROW_IO_ERROR( wxString::Format( _( "Board snapshot section %d is missing" ), aId ) );
+
+        return it->second;
+    };
+
+    STRING_LINE_READER     reader( section( SECTION_BOARD ), aSource );
+    PCB_PARSER             parser( &reader );
+    std::unique_ptr<BOARD> board( dynamic_cast<BOARD*>( parser.Parse() ) );
+
+    if( !board )
+        THROW_IO_ERROR( _( "The board snapshot does not contain a PCB" ) );
+
+    // Nets are matched by name: the parser may give them other codes
+    SECTION_READER             nets( section( SECTION_NETS ) );
+    std::map<int32_t, NETINFO_ITEM*> netTable;
+
+    for( uint32_t ii = nets.UInt(); ii > 0; --ii )
+    {
+        int32_t       code = nets.Int();
+        wxString      name = FROM_UTF8( nets.String().c_str() );
+        NETINFO_ITEM* net = code == NETINFO_LIST::UNCONNECTED ?
+                                    board->FindNet( NETINFO_LIST::UNCONNECTED ) :
+                                    board->FindNet( name );
+
+        if( code < 0 || !net )
+            THROW_IO_ERROR( wxString::Format( _( "Unknown net \"%s\" in board snapshot" ), name ) );
+
+        netTable[code] = net;
+    }
+
+    // Tracks are inserted at the front, as PCB_PARSER does
+    SECTION_READER tracks( section( SECTION_TRACKS ) );
+
+    for( uint32_t ii = tracks.UInt(); ii > 0; --ii )
+    {
+        KICAD_T                type = static_cast<KICAD_T>( tracks.Int() );
+        std::unique_ptr<TRACK> track;
+
+        switch( type )
+        {
+        case PCB_TRACE_T: track.reset( new TRACK( board.get() ) ); break;
+        case PCB_ARC_T:   track.reset( new ARC( board.get() ) );   break;
+        case PCB_VIA_T:   track.reset( new VIA( board.get() ) );   break;
+        default:
+            THROW_IO_ERROR( wxString::Format( _( "Unknown track type %d in board snapshot" ),
+                                              type ) );
+        }
+
+        track->SetStart( tracks.Point() );
+        track->SetEnd( tracks.Point() );
+        track->SetWidth( tracks.Int() );
+
+        if( type == PCB_VIA_T )
+        {
+            VIA* via = static_cast<VIA*>( track.get() );
+
+            via->SetViaType( static_cast<VIATYPE>( tracks.Int() ) );
+            via->SetDrill( tracks.Int() );
+
+            PCB_LAYER_ID top = ToLAYER_ID( tracks.Int() );
+            via->SetLayerPair( top, ToLAYER_ID( tracks.Int() ) );
+        }
+        else
+        {
+            if( type == PCB_ARC_T )
+                static_cast<ARC*>( track.get() )->SetMid( tracks.Point() );
+
+            track->SetLayer( ToLAYER_ID( tracks.Int() ) );
+        }
+
+        int32_t code = tracks.Int();
+        auto    net = netTable.find( code );
+
+        if( net == netTable.end() )
+            THROW_IO_ERROR( wxString::Format( _( "Invalid net ID %d in board snapshot" ), code ) );
+
+        track->SetNetCode( net->second->GetNet(), /* aNoAssert */ true );
+        const_cast<KIID&>( track->m_Uuid ) = KIID( FROM_UTF8( tracks.String().c_str() ) );
+        track->SetStatus( static_cast<STATUS_FLAGS>( tracks.UInt() ) );
+
+        board->Add( track.release(), ADD_MODE::INSERT );
+    }
+
+    // The zone fills
+    SECTION_READER fills( section( SECTION_ZONE_FILLS ) );
+
+    if( fills.UInt() != (uint32_t) board->GetAreaCount() )
+        THROW_IO_ERROR( _( "The board snapshot zone fills do not match its zones" ) );
+
+    for( int ii = 0; ii < board->GetAreaCount(); ++ii )
+    {
+        ZONE_CONTAINER*   zone = board->GetArea( ii );
+        SHAPE_POLY_SET    fill;
+        ZONE_SEGMENT_FILL segs;
+
+        fills.PolySet( fill );
+
+        for( uint32_t jj = fills.UInt(); jj > 0; --jj )
+        {
+            VECTOR2I a = fills.Point();
+            segs.emplace_back( a, fills.Point() );
+        }
+
+        if( !fill.IsEmpty() )
+        {
+            zone->SetFilledPolysList( fill );
+            zone->CalculateFilledArea();
+        }
+
+        zone->SetFillSegments( segs );
+    }
+
+    return board.release();
+}
+
+
+void BOARD_SNAPSHOT::Write( const wxString& aFileName, const MD5_HASH& aSourceHash ) const
+{
+    MD5_HASH       sourceHash = aSourceHash;
+    std::string    header;
+    SECTION_WRITER out( header );
+    uint64_t       offset = 0;
+
+    out.Bytes( snapshotMagic, sizeof( snapshotMagic ) );
+    out.UInt( 0x01020304 );     // byte order mark
+    out.UInt( BOARD_SNAPSHOT_VERSION );
+    out.UInt( SEXPR_BOARD_FILE_VERSION );
+    out.String( sourceHash.Format() );
+    out.UInt( m_sections.size() );
+
+    // Section offsets are counted from the end of the header
+    for( const auto& section : m_sections )
+    {
+        out.Int( section.first );
+        out.UInt64( offset );
+        out.UInt64( section.second.size() );
+        out.String( hashBytes( section.second.data(), section.second.size() ).Format() );
+
+        offset += section.second.size();
+    }
+
+    // Write a temporary file first, so that a failure does not leave half a snapshot
+    wxString tmpFileName = aFileName + wxT( ".tmp" );
+    wxFFile  file;
+
+    if( !file.Open( tmpFileName, wxT( "wb" ) ) )
+    {
+        THROW_IO_ERROR( wxString::Format( _( "Cannot create board snapshot \"%s\"" ),
+                                          tmpFileName ) );
+    }
+
+    bool ok = file.Write( header.data(), header.size() ) == header.size();
+
+    for( const auto& section : m_sections )
+    {
+        ok = ok && file.Write( section.second.data(), section.second.size() )
+                           == section.second.size();
+    }
+
+    ok = file.Close() && ok;
+
+    if( !ok || !wxRenameFile( tmpFileName, aFileName, true ) )
+    {
+        wxRemoveFile( tmpFileName );
+        THROW_IO_ERROR( wxString::Format( _( "Cannot write board snapshot \"%s\"" ),
+                                          aFileName ) );
+    }
+}
+
+
+bool BOARD_SNAPSHOT::Read( const wxString& aFileName, const MD5_HASH& aSourceHash )
+{
+    m_sections.clear();
+
+    if( !aSourceHash.IsValid() || !wxFileExists( aFileName ) )
+        return false;
+
+    wxFFile     file;
+    std::string data;
+
+    if( !file.Open( aFileName, wxT( "rb" ) ) )
+        return false;
+
+    data.resize( file.Length() );
+
+    if( file.Read( &data[0], data.size() ) != data.size() )
+        return false;
+
+    MD5_HASH sourceHash = aSourceHash;
+
+    try
+    {
+        SECTION_READER in( data );
+
+        if( memcmp( in.Bytes( sizeof( snapshotMagic ) ), snapshotMagic, sizeof( snapshotMagic ) )
+                || in.UInt() != 0x01020304
+                || in.UInt() != BOARD_SNAPSHOT_VERSION
+                || in.UInt() != SEXPR_BOARD_FILE_VERSION )
+        {
+            wxLogTrace( traceKicadPcbPlugin, wxT( "Board snapshot '%s' has another format." ),
+                        aFileName );
+            return false;
+        }
+
+        if( in.String() != sourceHash.Format() )
+        {
+            wxLogTrace( traceKicadPcbPlugin, wxT( "Board snapshot '%s' is stale." ), aFileName );
+            return false;
+        }
+
+        struct ENTRY
+        {
+            int         id;
+            uint64_t    offset;
+            uint64_t    size;
+            std::string checksum;
+        };
+
+        // An entry holds at least its id, offset, size and checksum length
+        std::vector<ENTRY> entries( in.Count( 3 * sizeof( uint32_t ) + 2 * sizeof( uint64_t ) ) );
+
+        for( ENTRY& entry : entries )
+        {
+            entry.id = in.Int();
+            entry.offset = in.UInt64();
+            entry.size = in.UInt64();
+            entry.checksum = in.String();
+        }
+
+        uint64_t base = in.Position();
+
+        for( const ENTRY& entry : entries )
+        {
+            if( entry.offset > data.size() - base || entry.size > data.size() - base - entry.offset
+                    || hashBytes( data.data() + base + entry.offset, entry.size ).Format()
+                               != entry.checksum )
+            {
+                wxLogTrace( traceKicadPcbPlugin, wxT( "Board snapshot '%s' is damaged." ),
+                            aFileName );
+                m_sections.clear();
+                return false;
+            }
+
+            m_sections[entry.id] = data.substr( base + entry.offset, entry.size );
+        }
+    }
+    catch( const IO_ERROR& )
+    {
+        wxLogTrace( traceKicadPcbPlugin, wxT( "Board snapshot '%s' is truncated." ), aFileName );
+        m_sections.clear();
+        return false;
+    }
+
+    return true;
+}
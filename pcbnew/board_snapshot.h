@@ -0,0 +1,137 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef BOARD_SNAPSHOT_H
+#define BOARD_SNAPSHOT_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <md5_hash.h>
+#include <wx/string.h>
+
+class BOARD;
+
+
+/**
+ * BOARD_SNAPSHOT
+ * is a binary cache of a board file, written next to it when it is saved and loaded instead
+ * of the board file as long as the board file did not change.
+ *
+ * The snapshot file starts with a header holding a magic number, the snapshot and board
+ * file format versions, the MD5 hash of the board file it was made from and an index of its
+ * sections, each with its offset, size and MD5 checksum.  Any mismatch makes the snapshot
+ * stale, and the board file is parsed as usual.
+ *
+ * The sections hold:
+ *  - the board s-expression, less its tracks and zone fills (most of a large board),
+ *  - the net table, to map the net codes of the binary sections to the parsed nets,
+ *  - the tracks, arcs and vias, in binary,
+ *  - the zone fills, in binary.
+ *
+ * Snapshots are in the byte order of the machine writing them; they are a local cache, not
+ * a file format to share.
+ */
+class BOARD_SNAPSHOT
+{
+public:
+    enum SECTION_ID
+    {
+        SECTION_BOARD = 1,
+        SECTION_NETS,
+        SECTION_TRACKS,
+        SECTION_ZONE_FILLS
+    };
+
+    /**
+     * Function GetFileName
+     * @return the name of the snapshot of \a aBoardFileName.
+     */
+    static wxString GetFileName( const wxString& aBoardFileName );
+
+    /**
+     * Function HashFile
+     * @return the MD5 hash of the contents of \a aFileName, or an invalid hash if it cannot
+     *         be read.
+     */
+    static MD5_HASH HashFile( const wxString& aFileName );
+
+    /**
+     * Function HashString
+     * @return the MD5 hash of \a aText, as HashFile() would give for a file holding it.
+     */
+    static MD5_HASH HashString( const std::string& aText );
+
+    /**
+     * Function Store
+     * fills the sections from \a aBoard and from \a aBoardText, the board file PCB_IO made
+     * from it.
+     *
+     * @param aOmitted are the byte ranges of \a aBoardText holding the tracks and the zone
+     *                 fills, stored in binary instead.
+     */
+    void Store( BOARD* aBoard, const std::string& aBoardText,
+                const std::vector<std::pair<size_t, size_t>>& aOmitted );
+
+    /**
+     * Function Store
+     * fills the sections from \a aBoard, formatting its board file first.
+     */
+    void Store( BOARD* aBoard );
+
+    /**
+     * Function Restore
+     * builds a new board from the sections.
+     *
+     * @param aSource is the name given to the board s-expression in parse errors.
+     * @throw IO_ERROR or PARSE_ERROR if a section is malformed.
+     */
+    BOARD* Restore( const wxString& aSource ) const;
+
+    /**
+     * Function Write
+     * writes the sections to \a aFileName, marking them as made from a board file whose
+     * contents hash to \a aSourceHash.
+     *
+     * @throw IO_ERROR on write error.
+     */
+    void Write( const wxString& aFileName, const MD5_HASH& aSourceHash ) const;
+
+    /**
+     * Function Read
+     * reads the sections of \a aFileName.
+     *
+     * @return false if the file is missing, damaged, of another version or not made from a
+     *         board file whose contents hash to \a aSourceHash.
+     */
+    bool Read( const wxString& aFileName, const MD5_HASH& aSourceHash );
+
+    void Clear() { m_sections.clear(); }
+
+private:
+    std::map<int, std::string> m_sections;
+};
+
+#endif  // BOARD_SNAPSHOT_H
@@ -1436,6 +1436,42 @@ unsigned int D_PAD::ViewGetLOD( int aLayer, KIGFX::VIEW* aView ) const
 }
 
 
+bool D_PAD::ViewGetCoarseShape( int aLayer, KIGFX::VIEW_COARSE_SHAPE& aShape ) const
+{
+    if( aLayer == LAYER_PADS_TH || aLayer == LAYER_PAD_FR || aLayer == LAYER_PAD_BK )
+    {
+        if( GetShape() == PAD_SHAPE_CIRCLE )
+        {
+            aShape.m_type = KIGFX::VIEW_COARSE_SHAPE::CIRCLE;
+            aShape.m_start = VECTOR2I( ShapePos() );
+            aShape.m_width = m_Size.x;
+        }
+        else
+        {
+            EDA_RECT bbox = GetBoundingBox();
+
+            aShape.m_type = KIGFX::VIEW_COARSE_SHAPE::RECT;
+            aShape.m_start = VECTOR2I( bbox.GetOrigin() );
+            aShape.m_end = VECTOR2I( bbox.GetEnd() );
+        }
+
+        return true;
+    }
+
+    // Plated holes are drawn in the background color, which is not the one of their layer
+    if( aLayer == LAYER_NON_PLATEDHOLES && m_drillShape == PAD_DRILL_SHAPE_CIRCLE )
+    {
+        aShape.m_type = KIGFX::VIEW_COARSE_SHAPE::CIRCLE;
+        aShape.m_start = VECTOR2I( GetPosition() );
+        aShape.m_width = m_Drill.x;
+
+        return true;
+    }
+
+    return false;
+}
+
+
 const BOX2I D_PAD::ViewBBox() const
 {
     // Bounding box includes soldermask too
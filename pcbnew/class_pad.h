@@ -827,6 +827,9 @@ public:
 
     virtual unsigned int ViewGetLOD( int aLayer, KIGFX::VIEW* aView ) const override;
 
+    virtual bool ViewGetCoarseShape( int aLayer,
+                                     KIGFX::VIEW_COARSE_SHAPE& aShape ) const override;
+
     virtual const BOX2I ViewBBox() const override;
 
     virtual void SwapData( BOARD_ITEM* aImage ) override;
@@ -487,6 +487,21 @@ unsigned int TRACK::ViewGetLOD( int aLayer, KIGFX::VIEW* aView ) const
 }
 
 
+bool TRACK::ViewGetCoarseShape( int aLayer, KIGFX::VIEW_COARSE_SHAPE& aShape ) const
+{
+    // Arcs are drawn as they are, their ends tell little about their size
+    if( Type() != PCB_TRACE_T || aLayer != GetLayer() )
+        return false;
+
+    aShape.m_type = KIGFX::VIEW_COARSE_SHAPE::SEGMENT;
+    aShape.m_start = VECTOR2I( m_Start );
+    aShape.m_end = VECTOR2I( m_End );
+    aShape.m_width = m_Width;
+
+    return true;
+}
+
+
 const BOX2I TRACK::ViewBBox() const
 {
     BOX2I bbox = GetBoundingBox();
@@ -743,6 +758,28 @@ unsigned int VIA::ViewGetLOD( int aLayer, KIGFX::VIEW* aView ) const
 }
 
 
+bool VIA::ViewGetCoarseShape( int aLayer, KIGFX::VIEW_COARSE_SHAPE& aShape ) const
+{
+    aShape.m_type = KIGFX::VIEW_COARSE_SHAPE::CIRCLE;
+    aShape.m_start = VECTOR2I( m_Start );
+
+    if( aLayer == LAYER_VIAS_HOLES )
+    {
+        aShape.m_width = GetDrillValue();
+        return true;
+    }
+
+    // The arcs of blind/buried vias, telling their layers, are drawn as they are
+    if( aLayer == LAYER_VIA_THROUGH || aLayer == LAYER_VIA_MICROVIA )
+    {
+        aShape.m_width = m_Width;
+        return true;
+    }
+
+    return false;
+}
+
+
 // see class_track.h
 void TRACK::GetMsgPanelInfo( EDA_UNITS aUnits, std::vector<MSG_PANEL_ITEM>& aList )
 {
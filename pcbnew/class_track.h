@@ -216,6 +216,9 @@ public:
 
     virtual unsigned int ViewGetLOD( int aLayer, KIGFX::VIEW* aView ) const override;
 
+    virtual bool ViewGetCoarseShape( int aLayer,
+                                     KIGFX::VIEW_COARSE_SHAPE& aShape ) const override;
+
     const BOX2I ViewBBox() const override;
 
     virtual void SwapData( BOARD_ITEM* aImage ) override;
@@ -407,6 +410,8 @@ public:
 
     unsigned int ViewGetLOD( int aLayer, KIGFX::VIEW* aView ) const override;
 
+    bool ViewGetCoarseShape( int aLayer, KIGFX::VIEW_COARSE_SHAPE& aShape ) const override;
+
     void Flip( const wxPoint& aCentre, bool aFlipLeftRight ) override;
 
 #if defined (DEBUG)
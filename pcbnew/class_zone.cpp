@@ -44,6 +44,7 @@
 #include <pgm_base.h>
 #include <settings/color_settings.h>
 #include <settings/settings_manager.h>
+#include <thread_pool.h>
 
 
 ZONE_CONTAINER::ZONE_CONTAINER( BOARD_ITEM_CONTAINER* aParent, bool aInModule )
@@ -115,6 +116,7 @@ ZONE_CONTAINER& ZONE_CONTAINER::operator=( const ZONE_CONTAINER& aOther )
     m_HatchFillTypeOrientation = aOther.m_HatchFillTypeOrientation;
     m_HatchFillTypeSmoothingLevel = aOther.m_HatchFillTypeSmoothingLevel;
     m_HatchFillTypeSmoothingValue = aOther.m_HatchFillTypeSmoothingValue;
+    m_fillDependencies = aOther.m_fillDependencies;
 
     SetLayerSet( aOther.GetLayerSet() );
 
@@ -158,6 +160,7 @@ void ZONE_CONTAINER::initDataFromSrcInCopyCtor( const ZONE_CONTAINER& aZone )
     m_ThermalReliefCopperBridge = aZone.m_ThermalReliefCopperBridge;
     m_FilledPolysList.Append( aZone.m_FilledPolysList );
     m_FillSegmList = aZone.m_FillSegmList;      // vector <> copy
+    m_fillDependencies = aZone.m_fillDependencies;
 
     m_doNotAllowCopperPour = aZone.m_doNotAllowCopperPour;
     m_doNotAllowVias = aZone.m_doNotAllowVias;
@@ -1184,7 +1187,12 @@ void ZONE_CONTAINER::SwapData( BOARD_ITEM* aImage )
 
 void ZONE_CONTAINER::CacheTriangulation()
 {
-    m_FilledPolysList.CacheTriangulation();
+    // Big planes are made of many islands: triangulate them in parallel
+    m_FilledPolysList.CacheTriangulation(
+            []( size_t aCount, const std::function<void( size_t )>& aTask )
+            {
+                ParallelFor( 0, aCount, aTask );
+            } );
 }
 
 
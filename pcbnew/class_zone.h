@@ -575,6 +575,7 @@ public:
 
     /** (re)create a list of triangles that "fill" the solid areas.
      * used for instance to draw these solid areas on opengl
+     * The islands which did not change since the last call keep their triangles.
      */
     void CacheTriangulation();
 
@@ -719,6 +720,12 @@ public:
      */
     void BuildHashValue() { m_filledPolysHash = m_FilledPolysList.GetHash(); }
 
+    /** @return the signature of the fill inputs recorded by the last ZONE_FILLER run.
+     *  Invalid when the zone was never filled in this session.
+     */
+    const MD5_HASH& GetFillDependencies() const { return m_fillDependencies; }
+    void SetFillDependencies( const MD5_HASH& aHash ) { m_fillDependencies = aHash; }
+
 
 
 #if defined(DEBUG)
@@ -825,6 +832,8 @@ protected:
     SHAPE_POLY_SET        m_RawPolysList;
     MD5_HASH              m_filledPolysHash;    // A hash value used in zone filling calculations
                                                 // to see if the filled areas are up to date
+    MD5_HASH              m_fillDependencies;   // Signature of the items and settings the
+                                                // filled areas were computed from
 
     ZONE_HATCH_STYLE      m_hatchStyle;     // hatch style, see enum above
     int                   m_hatchPitch;     // for DIAGONAL_EDGE, distance between 2 hatch lines
@@ -26,11 +26,10 @@
 #include <widgets/progress_reporter.h>
 #include <geometry/geometry_utils.h>
 #include <board_commit.h>
+#include <thread_pool.h>
 
-#include <thread>
 #include <mutex>
 #include <algorithm>
-#include <future>
 
 #ifdef PROFILE
 #include <profile.h>
@@ -45,40 +44,19 @@ bool CN_CONNECTIVITY_ALGO::Remove( BOARD_ITEM* aItem )
     {
     case PCB_MODULE_T:
         for( auto pad : static_cast<MODULE*>( aItem ) -> Pads() )
-        {
-            m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( pad ) ].MarkItemsAsInvalid();
-            m_itemMap.erase( static_cast<BOARD_CONNECTED_ITEM*>( pad ) );
-        }
+            removeItemEntry( pad );
 
         m_itemList.SetDirty( true );
         break;
 
     case PCB_PAD_T:
-        m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( aItem ) ].MarkItemsAsInvalid();
-        m_itemMap.erase( static_cast<BOARD_CONNECTED_ITEM*>( aItem ) );
-        m_itemList.SetDirty( true );
-        break;
-
     case PCB_TRACE_T:
     case PCB_ARC_T:
-        m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( aItem ) ].MarkItemsAsInvalid();
-        m_itemMap.erase( static_cast<BOARD_CONNECTED_ITEM*>( aItem ) );
-        m_itemList.SetDirty( true );
-        break;
-
     case PCB_VIA_T:
-        m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( aItem ) ].MarkItemsAsInvalid();
-        m_itemMap.erase( static_cast<BOARD_CONNECTED_ITEM*>( aItem ) );
-        m_itemList.SetDirty( true );
-        break;
-
     case PCB_ZONE_AREA_T:
-    {
-        m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( aItem ) ].MarkItemsAsInvalid();
-        m_itemMap.erase ( static_cast<BOARD_CONNECTED_ITEM*>( aItem ) );
+        removeItemEntry( aItem );
         m_itemList.SetDirty( true );
         break;
-    }
 
     default:
         return false;
@@ -91,6 +69,22 @@ bool CN_CONNECTIVITY_ALGO::Remove( BOARD_ITEM* aItem )
 }
 
 
+void CN_CONNECTIVITY_ALGO::removeItemEntry( const BOARD_ITEM* aItem )
+{
+    auto it = m_itemMap.find( aItem );
+
+    if( it == m_itemMap.end() )
+        return;
+
+    // Split the clusters of the items while they are still linked to them
+    for( CN_ITEM* item : it->second.GetItems() )
+        m_clusterIndex.Detach( item );
+
+    it->second.MarkItemsAsInvalid();
+    m_itemMap.erase( it );
+}
+
+
 void CN_CONNECTIVITY_ALGO::markItemNetAsDirty( const BOARD_ITEM* aItem )
 {
     if( aItem->IsConnected() )
@@ -182,7 +176,10 @@ bool CN_CONNECTIVITY_ALGO::Add( BOARD_ITEM* aItem )
         m_itemMap[zone] = ITEM_MAP_ENTRY();
 
         for( auto zitem : m_itemList.Add( zone ) )
+        {
+            m_clusterIndex.Add( zitem );
             m_itemMap[zone].Link(zitem);
+        }
 
         break;
     }
@@ -204,13 +201,9 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
 #ifdef PROFILE
     PROF_COUNTER garbage_collection( "garbage-collection" );
 #endif
-    std::vector<CN_ITEM*> garbage;
-    garbage.reserve( 1024 );
-
-    m_itemList.RemoveInvalidItems( garbage );
-
-    for( auto item : garbage )
-        delete item;
+    // The removed items are freed next: the cluster index must let go of them first
+    m_clusterIndex.Update();
+    m_itemList.RemoveInvalidItems();
 
 #ifdef PROFILE
     garbage_collection.Show();
@@ -229,49 +222,55 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
 
     if( m_itemList.IsDirty() )
     {
-        size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-                ( dirtyItems.size() + 7 ) / 8 );
+        // Each block of dirty items records the connections it finds in a list of its own,
+        // merged into the items once all blocks are done: the workers share no lock.
+        const size_t blockSize = 32;
+        size_t       blockCount = ( dirtyItems.size() + blockSize - 1 ) / blockSize;
 
-        std::atomic<size_t> nextItem( 0 );
-        std::vector<std::future<size_t>> returns( parallelThreadCount );
+        std::vector<CN_CONNECTIONS> connections( blockCount );
 
-        auto conn_lambda = [&nextItem, &dirtyItems]
-                            ( CN_LIST* aItemList, PROGRESS_REPORTER* aReporter) -> size_t
+        auto conn_lambda = [&]( size_t aBlock )
         {
-            for( size_t i = nextItem++; i < dirtyItems.size(); i = nextItem++ )
+            size_t last = std::min( dirtyItems.size(), ( aBlock + 1 ) * blockSize );
+
+            for( size_t i = aBlock * blockSize; i < last; i++ )
             {
-                CN_VISITOR visitor( dirtyItems[i] );
-                aItemList->FindNearby( dirtyItems[i], visitor );
+                CN_VISITOR visitor( dirtyItems[i], &connections[aBlock] );
+                m_itemList.FindNearby( dirtyItems[i], visitor );
 
-                if( aReporter )
-                    aReporter->AdvanceProgress();
+                if( m_progressReporter )
+                    m_progressReporter->AdvanceProgress();
             }
-
-            return 1;
         };
 
-        if( parallelThreadCount <= 1 )
-            conn_lambda( &m_itemList, m_progressReporter );
-        else
-        {
-            for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-                returns[ii] = std::async( std::launch::async, conn_lambda,
-                        &m_itemList, m_progressReporter );
+        // A cancelled search simply leaves the items dirty for the next pass
+        if( !ParallelFor( 0, blockCount, conn_lambda, m_progressReporter, 1 ) )
+            return;
 
-            for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            {
-                // Here we balance returns with a 100ms timeout to allow UI updating
-                std::future_status status;
-                do
-                {
-                    if( m_progressReporter )
-                        m_progressReporter->KeepRefreshing();
+        std::vector<CN_ITEM*> connected;
 
-                    status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-                } while( status != std::future_status::ready );
+        for( const CN_CONNECTIONS& block : connections )
+        {
+            for( const auto& pair : block )
+            {
+                pair.first->AppendConnection( pair.second );
+                pair.second->AppendConnection( pair.first );
+                m_clusterIndex.Connect( pair.first, pair.second );
+                connected.push_back( pair.first );
+                connected.push_back( pair.second );
             }
         }
 
+        std::sort( connected.begin(), connected.end() );
+        connected.erase( std::unique( connected.begin(), connected.end() ), connected.end() );
+
+        ParallelFor( 0, connected.size(),
+                     [&connected]( size_t i )
+                     {
+                         connected[i]->SortConnections();
+                     },
+                     nullptr, 64 );
+
         if( m_progressReporter )
             m_progressReporter->KeepRefreshing();
     }
@@ -298,8 +297,11 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
 
     if( aMode == CSM_PROPAGATE )
         return SearchClusters( aMode, no_zones, -1 );
-    else
-        return SearchClusters( aMode, types, -1 );
+
+    if( m_itemList.IsDirty() )
+        searchConnections();
+
+    return m_clusterIndex.Clusters( m_itemList );
 }
 
 
@@ -625,8 +627,7 @@ void CN_VISITOR::checkZoneItemConnection( CN_ZONE* aZone, CN_ITEM* aItem )
     {
         if( zoneItem->ContainsPoint( aItem->GetAnchor( i ) ) )
         {
-            zoneItem->Connect( aItem );
-            aItem->Connect( zoneItem );
+            connect( zoneItem, aItem );
             return;
         }
     }
@@ -652,8 +653,7 @@ void CN_VISITOR::checkZoneZoneConnection( CN_ZONE* aZoneA, CN_ZONE* aZoneB )
     {
         if( aZoneB->ContainsPoint( outline.CPoint( i ) ) )
         {
-            aZoneA->Connect( aZoneB );
-            aZoneB->Connect( aZoneA );
+            connect( aZoneA, aZoneB );
             return;
         }
     }
@@ -664,8 +664,7 @@ void CN_VISITOR::checkZoneZoneConnection( CN_ZONE* aZoneA, CN_ZONE* aZoneB )
     {
         if( aZoneA->ContainsPoint( outline2.CPoint( i ) ) )
         {
-            aZoneA->Connect( aZoneB );
-            aZoneB->Connect( aZoneA );
+            connect( aZoneA, aZoneB );
             return;
         }
     }
@@ -718,8 +717,7 @@ bool CN_VISITOR::operator()( CN_ITEM* aCandidate )
     {
         if( parentB->HitTest( wxPoint( aCandidate->GetAnchor( i ) ) ) )
         {
-            m_item->Connect( aCandidate );
-            aCandidate->Connect( m_item );
+            connect( m_item, aCandidate );
             return true;
         }
     }
@@ -728,8 +726,7 @@ bool CN_VISITOR::operator()( CN_ITEM* aCandidate )
     {
         if( parentA->HitTest( wxPoint( m_item->GetAnchor( i ) ) ) )
         {
-            m_item->Connect( aCandidate );
-            aCandidate->Connect( m_item );
+            connect( m_item, aCandidate );
             return true;
         }
     }
@@ -743,6 +740,7 @@ void CN_CONNECTIVITY_ALGO::Clear()
     m_ratsnestClusters.clear();
     m_connClusters.clear();
     m_itemMap.clear();
+    m_clusterIndex.Clear();
     m_itemList.Clear();
 
 }
@@ -46,6 +46,7 @@
 #include <connectivity/connectivity_rtree.h>
 #include <connectivity/connectivity_data.h>
 #include <connectivity/connectivity_items.h>
+#include <connectivity/connectivity_clusters.h>
 
 class CN_CONNECTIVITY_ALGO_IMPL;
 class CN_RATSNEST_NODES;
@@ -93,8 +94,8 @@ public:
     }
 
 private:
-    CN_ANCHOR_PTR m_source;
-    CN_ANCHOR_PTR m_target;
+    CN_ANCHOR_PTR m_source = nullptr;
+    CN_ANCHOR_PTR m_target = nullptr;
     unsigned int m_weight = 0;
     bool m_visible = true;
 };
@@ -145,6 +146,9 @@ private:
 
     CN_LIST m_itemList;
 
+    ///> clusters of items of the same net, kept up to date as items are added and removed
+    CN_CLUSTER_INDEX m_clusterIndex;
+
     std::unordered_map<const BOARD_ITEM*, ITEM_MAP_ENTRY> m_itemMap;
 
     CLUSTERS m_connClusters;
@@ -163,9 +167,15 @@ private:
     {
         auto item = c.Add( brditem );
 
+        if( item )
+            m_clusterIndex.Add( item );
+
         m_itemMap[ brditem ] = ITEM_MAP_ENTRY( item );
     }
 
+    ///> Marks the connectivity items of aItem as invalid, and forgets about aItem
+    void removeItemEntry( const BOARD_ITEM* aItem );
+
     void markItemNetAsDirty( const BOARD_ITEM* aItem );
 
 public:
@@ -221,7 +231,20 @@ public:
     bool    Remove( BOARD_ITEM* aItem );
     bool    Add( BOARD_ITEM* aItem );
 
+    /**
+     * Function SearchClusters()
+     * searches the clusters of connected items of the given types from scratch, with a
+     * breadth-first search of the connected items.
+     * @param aSingleNet is the net of the items to search, or -1 for all items.
+     */
     const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode, const KICAD_T aTypes[], int aSingleNet );
+
+    /**
+     * Function SearchClusters()
+     * returns the clusters of all connected items.  The clusters of items of the same net
+     * (all modes but CSM_PROPAGATE) come from the cluster index, which only rebuilds the
+     * clusters changed since the previous call.
+     */
     const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode );
 
     /**
@@ -255,6 +278,9 @@ public:
 
 };
 
+///> Pairs of items found to be connected, to be merged into the items once a search is done
+typedef std::vector<std::pair<CN_ITEM*, CN_ITEM*>> CN_CONNECTIONS;
+
 /**
  * Struct CN_VISTOR
  **/
@@ -262,8 +288,9 @@ class CN_VISITOR {
 
 public:
 
-    CN_VISITOR( CN_ITEM* aItem ) :
-        m_item( aItem )
+    CN_VISITOR( CN_ITEM* aItem, CN_CONNECTIONS* aConnections ) :
+        m_item( aItem ),
+        m_connections( aConnections )
     {}
 
     bool operator()( CN_ITEM* aCandidate );
@@ -274,8 +301,16 @@ protected:
 
     void checkZoneZoneConnection( CN_ZONE* aZoneA, CN_ZONE* aZoneB );
 
+    void connect( CN_ITEM* aA, CN_ITEM* aB )
+    {
+        m_connections->emplace_back( aA, aB );
+    }
+
     ///> the item we are looking for connections to
     CN_ITEM* m_item;
+
+    ///> where the connections found are recorded
+    CN_CONNECTIONS* m_connections;
 };
 
 #endif
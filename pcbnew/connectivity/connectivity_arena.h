@@ -0,0 +1,107 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef PCBNEW_CONNECTIVITY_CONNECTIVITY_ARENA_H_
+#define PCBNEW_CONNECTIVITY_CONNECTIVITY_ARENA_H_
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * CN_ARENA -
+ * Hands out objects of type T from blocks of contiguous storage, and recycles the slots of
+ * the objects it is given back.  Objects allocated one after the other sit next to each
+ * other, and there is no heap allocation per object.
+ *
+ * Not thread safe: connectivity items and anchors are only created and destroyed by the
+ * thread editing the board.  Objects still allocated when the arena is destroyed are not
+ * destroyed.
+ */
+template <class T, size_t BLOCK_SIZE = 1024>
+class CN_ARENA
+{
+public:
+    CN_ARENA() :
+        m_count( 0 )
+    {
+    }
+
+    CN_ARENA( const CN_ARENA& ) = delete;
+    CN_ARENA& operator=( const CN_ARENA& ) = delete;
+
+    template <typename... ARGS>
+    T* New( ARGS&&... aArgs )
+    {
+        if( m_free.empty() )
+            grow();
+
+        void* slot = m_free.back();
+
+        m_free.pop_back();
+        m_count++;
+
+        return new( slot ) T( std::forward<ARGS>( aArgs )... );
+    }
+
+    void Delete( T* aObject )
+    {
+        aObject->~T();
+        m_free.push_back( aObject );
+        m_count--;
+    }
+
+    ///> Returns the number of objects allocated
+    size_t Size() const
+    {
+        return m_count;
+    }
+
+    ///> Returns the bytes held by the arena, used or not
+    size_t MemoryUsage() const
+    {
+        return m_blocks.size() * BLOCK_SIZE * sizeof( SLOT ) + m_free.capacity() * sizeof( void* );
+    }
+
+private:
+    using SLOT = typename std::aligned_storage<sizeof( T ), alignof( T )>::type;
+
+    void grow()
+    {
+        m_blocks.emplace_back( new SLOT[BLOCK_SIZE] );
+
+        SLOT* block = m_blocks.back().get();
+
+        // Backwards, so that the slots are handed out in address order
+        for( size_t i = BLOCK_SIZE; i > 0; i-- )
+            m_free.push_back( &block[i - 1] );
+    }
+
+    std::vector<std::unique_ptr<SLOT[]>> m_blocks;
+    std::vector<void*>                   m_free;
+    size_t                               m_count;
+};
+
+#endif /* PCBNEW_CONNECTIVITY_CONNECTIVITY_ARENA_H_ */
@@ -0,0 +1,177 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <connectivity/connectivity_clusters.h>
+
+#include <algorithm>
+
+
+CN_ITEM* CN_CLUSTER_INDEX::find( CN_ITEM* aItem )
+{
+    // Path halving: every other item on the way points to its grandparent afterwards
+    while( aItem->m_setParent != aItem )
+    {
+        aItem->m_setParent = aItem->m_setParent->m_setParent;
+        aItem = aItem->m_setParent;
+    }
+
+    return aItem;
+}
+
+
+void CN_CLUSTER_INDEX::Connect( CN_ITEM* aA, CN_ITEM* aB )
+{
+    // Invalid items have no net
+    int net = aA->Net();
+
+    if( net <= 0 || aB->Net() != net )
+        return;
+
+    CN_ITEM* rootA = find( aA );
+    CN_ITEM* rootB = find( aB );
+
+    if( rootA == rootB )
+        return;
+
+    m_clusters.erase( rootA );
+    m_clusters.erase( rootB );
+
+    if( rootA->m_setRank < rootB->m_setRank )
+        std::swap( rootA, rootB );
+
+    rootB->m_setParent = rootA;
+
+    if( rootA->m_setRank == rootB->m_setRank )
+        rootA->m_setRank++;
+
+    // Swapping the successors of two items of two circular lists joins the lists
+    std::swap( rootA->m_setNext, rootB->m_setNext );
+
+    m_touched.push_back( rootA );
+}
+
+
+void CN_CLUSTER_INDEX::Detach( CN_ITEM* aItem )
+{
+    CN_ITEM* root = find( aItem );
+    CN_ITEM* item = root;
+
+    m_clusters.erase( root );
+
+    do
+    {
+        CN_ITEM* next = item->m_setNext;
+
+        item->m_setParent = item;
+        item->m_setNext = item;
+        item->m_setRank = 0;
+        item->m_setNet = item->Net();
+
+        m_orphans.push_back( item );
+        item = next;
+    } while( item != root );
+}
+
+
+void CN_CLUSTER_INDEX::Update()
+{
+    for( CN_ITEM* item : m_orphans )
+    {
+        if( !item->Valid() )
+            continue;
+
+        m_touched.push_back( item );
+
+        for( CN_ITEM* connected : item->ConnectedItems() )
+            Connect( item, connected );
+    }
+
+    m_orphans.clear();
+
+    m_touched.erase( std::remove_if( m_touched.begin(), m_touched.end(),
+                                     []( const CN_ITEM* aItem )
+                                     {
+                                         return !aItem->Valid();
+                                     } ),
+                     m_touched.end() );
+}
+
+
+const CN_CLUSTER_INDEX::CLUSTERS CN_CLUSTER_INDEX::Clusters( CN_LIST& aItems )
+{
+    // Nets are changed behind our back by the net propagation: link the items of the sets
+    // with an item whose net changed again
+    for( CN_ITEM* item : aItems )
+    {
+        if( item->Valid() && item->Net() != item->m_setNet )
+            Detach( item );
+    }
+
+    Update();
+
+    for( CN_ITEM* item : m_touched )
+    {
+        if( item->Net() <= 0 )
+            continue;
+
+        CN_ITEM* root = find( item );
+
+        if( m_clusters.count( root ) )
+            continue;
+
+        CN_CLUSTER_PTR cluster = std::make_shared<CN_CLUSTER>();
+        CN_ITEM*       member = root;
+
+        do
+        {
+            cluster->Add( member );
+            member = member->m_setNext;
+        } while( member != root );
+
+        m_clusters[root] = cluster;
+    }
+
+    m_touched.clear();
+
+    CLUSTERS clusters;
+    clusters.reserve( m_clusters.size() );
+
+    for( const auto& entry : m_clusters )
+        clusters.push_back( entry.second );
+
+    std::sort( clusters.begin(), clusters.end(),
+               []( const CN_CLUSTER_PTR& a, const CN_CLUSTER_PTR& b )
+               {
+                   return a->OriginNet() < b->OriginNet();
+               } );
+
+    return clusters;
+}
+
+
+void CN_CLUSTER_INDEX::Clear()
+{
+    m_clusters.clear();
+    m_touched.clear();
+    m_orphans.clear();
+}
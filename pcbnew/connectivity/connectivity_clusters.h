@@ -0,0 +1,100 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef PCBNEW_CONNECTIVITY_CONNECTIVITY_CLUSTERS_H_
+#define PCBNEW_CONNECTIVITY_CONNECTIVITY_CLUSTERS_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <connectivity/connectivity_items.h>
+
+
+/**
+ * CN_CLUSTER_INDEX -
+ * Keeps the connectivity items in disjoint sets (union-find with path compression), one
+ * per cluster of connected items of the same net, as the items are connected, removed and
+ * change nets.  The clusters of the sets left untouched since the previous query are kept,
+ * so that a query after a small edit only rebuilds the clusters of the edited sets.
+ *
+ * The sets of the items are stored in the items themselves.  Items without a net are never
+ * linked, and belong to no cluster.
+ */
+class CN_CLUSTER_INDEX
+{
+public:
+    using CLUSTERS = std::vector<CN_CLUSTER_PTR>;
+
+    /**
+     * Function Add()
+     * records a new item, so that it gets a cluster even if it connects to nothing.
+     */
+    void Add( CN_ITEM* aItem )
+    {
+        m_touched.push_back( aItem );
+    }
+
+    /**
+     * Function Connect()
+     * merges the sets of two connected items, if they belong to the same net.
+     */
+    void Connect( CN_ITEM* aA, CN_ITEM* aB );
+
+    /**
+     * Function Detach()
+     * splits the set of an item about to be removed back into single items, which will be
+     * linked again by Update() along their remaining connections.
+     */
+    void Detach( CN_ITEM* aItem );
+
+    /**
+     * Function Update()
+     * links again the items of the split sets, and forgets about the removed items.  Must be
+     * called before the removed items are freed.
+     */
+    void Update();
+
+    /**
+     * Function Clusters()
+     * returns the clusters of all items, sorted by net.
+     * @param aItems are all the items, checked for net changes.
+     */
+    const CLUSTERS Clusters( CN_LIST& aItems );
+
+    void Clear();
+
+private:
+    CN_ITEM* find( CN_ITEM* aItem );
+
+    ///> clusters of the sets, by the root item of the set
+    std::unordered_map<CN_ITEM*, CN_CLUSTER_PTR> m_clusters;
+
+    ///> items of the sets whose cluster must be built again
+    std::vector<CN_ITEM*> m_touched;
+
+    ///> items of the split sets, to be linked again
+    std::vector<CN_ITEM*> m_orphans;
+};
+
+#endif /* PCBNEW_CONNECTIVITY_CONNECTIVITY_CLUSTERS_H_ */
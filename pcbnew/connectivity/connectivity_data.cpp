@@ -27,23 +27,24 @@
 #include <profile.h>
 #endif
 
-#include <thread>
 #include <algorithm>
-#include <future>
 
 #include <connectivity/connectivity_data.h>
 #include <connectivity/connectivity_algo.h>
 #include <ratsnest_data.h>
+#include <thread_pool.h>
 
 CONNECTIVITY_DATA::CONNECTIVITY_DATA()
 {
     m_connAlgo.reset( new CN_CONNECTIVITY_ALGO );
+    m_ratsnestPending = false;
     m_progressReporter = nullptr;
 }
 
 
 CONNECTIVITY_DATA::CONNECTIVITY_DATA( const std::vector<BOARD_ITEM*>& aItems )
 {
+    m_ratsnestPending = false;
     Build( aItems );
     m_progressReporter = nullptr;
 }
@@ -79,6 +80,7 @@ bool CONNECTIVITY_DATA::Update( BOARD_ITEM* aItem )
 
 void CONNECTIVITY_DATA::Build( BOARD* aBoard )
 {
+    clearNetNodes();
     m_connAlgo.reset( new CN_CONNECTIVITY_ALGO );
     m_connAlgo->Build( aBoard );
     RecalculateRatsnest();
@@ -87,6 +89,7 @@ void CONNECTIVITY_DATA::Build( BOARD* aBoard )
 
 void CONNECTIVITY_DATA::Build( const std::vector<BOARD_ITEM*>& aItems )
 {
+    clearNetNodes();
     m_connAlgo.reset( new CN_CONNECTIVITY_ALGO );
     m_connAlgo->Build( aItems );
 
@@ -94,44 +97,126 @@ void CONNECTIVITY_DATA::Build( const std::vector<BOARD_ITEM*>& aItems )
 }
 
 
-void CONNECTIVITY_DATA::updateRatsnest()
+void CONNECTIVITY_DATA::clearNetNodes()
 {
+    // The nodes belong to the connectivity items, which go with the algorithm
+    for( RN_NET* net : m_nets )
+    {
+        if( net )
+            net->Clear();
+    }
+}
+
+
+///> Nets with fewer nodes are never split in parts
+static const size_t RN_SPLIT_MIN_NODES = 4096;
+
+
+/**
+ * A step of the update of a net, with an estimate of its cost
+ */
+struct RN_JOB
+{
+    RN_NET* m_net;
+    int     m_part;
+    size_t  m_cost;
+};
+
+
+/**
+ * Runs jobs on the thread pool, the most expensive first.  Each thread takes the next job as
+ * soon as it is done with the previous one, so that a large job is not left for the end
+ * while the other threads are idle.
+ */
+static void runLargestFirst( std::vector<RN_JOB>& aJobs,
+                             const std::function<void( RN_JOB& )>& aFunc )
+{
+    std::sort( aJobs.begin(), aJobs.end(),
+               []( const RN_JOB& aJob1, const RN_JOB& aJob2 )
+               {
+                   return aJob1.m_cost > aJob2.m_cost;
+               } );
+
+    std::atomic<size_t> next( 0 );
+    TASK_GROUP          tasks;
+    size_t              workers = std::min( aJobs.size(), THREAD_POOL::Get().GetThreadCount() );
+
+    for( size_t i = 0; i < workers; i++ )
+    {
+        tasks.Run( [&]()
+                   {
+                       for( size_t job = next++; job < aJobs.size(); job = next++ )
+                           aFunc( aJobs[job] );
+                   } );
+    }
+
+    tasks.Wait();
+}
+
+
+void CONNECTIVITY_DATA::updateRatsnest() const
+{
+    if( !m_ratsnestPending )
+        return;
+
+    std::lock_guard<std::mutex> lock( m_ratsnestLock );
+
+    // Another reader may have computed it while this one waited
+    if( !m_ratsnestPending )
+        return;
+
     #ifdef PROFILE
     PROF_COUNTER rnUpdate( "update-ratsnest" );
     #endif
-    std::vector<RN_NET*> dirty_nets;
+    std::vector<RN_JOB> nets;
+    size_t              nodes = 0;
 
     // Start with net 1 as net 0 is reserved for not-connected
     // Nets without nodes are also ignored
-    std::copy_if( m_nets.begin() + 1, m_nets.end(), std::back_inserter( dirty_nets ),
-            [] ( RN_NET* aNet ) { return aNet->IsDirty() && aNet->GetNodeCount() > 0; } );
+    for( auto it = m_nets.begin() + 1; it < m_nets.end(); ++it )
+    {
+        RN_NET* net = *it;
 
-    // We don't want to spin up a new thread for fewer than 8 nets (overhead costs)
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            ( dirty_nets.size() + 7 ) / 8 );
+        if( net->IsDirty() && net->GetNodeCount() > 0 )
+        {
+            nets.push_back( { net, 0, net->GetNodeCount() } );
+            nodes += net->GetNodeCount();
+        }
+    }
 
-    std::atomic<size_t> nextNet( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
+    // Nets much larger than the share of a thread are split in parts computed in parallel
+    size_t threads = THREAD_POOL::Get().GetThreadCount();
+    size_t splitSize = std::max( RN_SPLIT_MIN_NODES, nodes / std::max<size_t>( threads, 1 ) );
 
-    auto update_lambda = [&nextNet, &dirty_nets]() -> size_t
-    {
-        for( size_t i = nextNet++; i < dirty_nets.size(); i = nextNet++ )
-            dirty_nets[i]->Update();
+    std::vector<RN_JOB> parts;
+    std::mutex          partsLock;
 
-        return 1;
-    };
+    runLargestFirst( nets,
+                     [&]( RN_JOB& aJob )
+                     {
+                         bool split = threads >= 4 && aJob.m_cost >= splitSize;
+                         int  count = aJob.m_net->BeginUpdate( split ? 4 : 1 );
 
-    if( parallelThreadCount == 1 )
-        update_lambda();
-    else
-    {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
+                         std::lock_guard<std::mutex> lock( partsLock );
 
-        // Finalize the ratsnest threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
-    }
+                         for( int i = 0; i < count; i++ )
+                             parts.push_back( { aJob.m_net, i, aJob.m_net->GetPartSize( i ) } );
+                     } );
+
+    runLargestFirst( parts,
+                     []( RN_JOB& aJob )
+                     {
+                         aJob.m_net->UpdatePart( aJob.m_part );
+                     } );
+
+    runLargestFirst( nets,
+                     []( RN_JOB& aJob )
+                     {
+                         aJob.m_net->EndUpdate();
+                     } );
+
+    // Only now, for readers not to skip the update while it runs
+    m_ratsnestPending = false;
 
     #ifdef PROFILE
     rnUpdate.Show();
@@ -148,6 +233,13 @@ void CONNECTIVITY_DATA::addRatsnestCluster( const std::shared_ptr<CN_CLUSTER>& a
 
 
 void CONNECTIVITY_DATA::RecalculateRatsnest( BOARD_COMMIT* aCommit  )
+{
+    ScheduleRatsnestUpdate( aCommit );
+    updateRatsnest();
+}
+
+
+void CONNECTIVITY_DATA::ScheduleRatsnestUpdate( BOARD_COMMIT* aCommit )
 {
     m_connAlgo->PropagateNets( aCommit );
 
@@ -186,8 +278,7 @@ void CONNECTIVITY_DATA::RecalculateRatsnest( BOARD_COMMIT* aCommit  )
     }
 
     m_connAlgo->ClearDirtyFlags();
-
-    updateRatsnest();
+    m_ratsnestPending = true;
 }
 
 
@@ -264,7 +355,8 @@ void CONNECTIVITY_DATA::ComputeDynamicRatsnest( const std::vector<BOARD_ITEM*>&
         if( dynNet->GetNodeCount() != 0 )
         {
             auto ourNet = m_nets[nc];
-            CN_ANCHOR_PTR nodeA, nodeB;
+            CN_ANCHOR_PTR nodeA = nullptr;
+            CN_ANCHOR_PTR nodeB = nullptr;
 
             if( ourNet->NearestBicoloredPair( *dynNet, nodeA, nodeB ) )
             {
@@ -326,6 +418,8 @@ unsigned int CONNECTIVITY_DATA::GetUnconnectedCount() const
 {
     unsigned int unconnected = 0;
 
+    updateRatsnest();
+
     for( auto net : m_nets )
     {
         if( !net )
@@ -349,6 +443,7 @@ void CONNECTIVITY_DATA::Clear()
         delete net;
 
     m_nets.clear();
+    m_ratsnestPending = false;
 }
 
 
@@ -591,6 +686,8 @@ const std::vector<VECTOR2I> CONNECTIVITY_DATA::NearestUnconnectedTargets(
 
 void CONNECTIVITY_DATA::GetUnconnectedEdges( std::vector<CN_EDGE>& aEdges) const
 {
+    updateRatsnest();
+
     for( auto rnNet : m_nets )
     {
         if( rnNet )
@@ -634,6 +731,8 @@ const std::vector<BOARD_CONNECTED_ITEM*> CONNECTIVITY_DATA::GetConnectedItems(
 
 RN_NET* CONNECTIVITY_DATA::GetRatsnestForNet( int aNet )
 {
+    updateRatsnest();
+
     if ( aNet < 0 || aNet >= (int) m_nets.size() )
     {
         return nullptr;
@@ -29,6 +29,7 @@
 
 #include <core/typeinfo.h>
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -163,6 +164,15 @@ public:
      */
     void RecalculateRatsnest( BOARD_COMMIT* aCommit = nullptr );
 
+    /**
+     * Function ScheduleRatsnestUpdate()
+     * Propagates the nets and collects the nodes of the changed nets like
+     * RecalculateRatsnest(), but leaves their ratsnest to be computed when it is next asked
+     * for, so that the nets changed by several commits in a row are only computed once.
+     * @param aCommit is used to save the undo state of items modified by this call
+     */
+    void ScheduleRatsnestUpdate( BOARD_COMMIT* aCommit = nullptr );
+
     /**
      * Function GetUnconnectedCount()
      * Returns the number of remaining edges in the ratsnest.
@@ -250,14 +260,23 @@ public:
 
 private:
 
-    void    updateRatsnest();
+    ///> Computes the pending ratsnest, the readers of the ratsnest call it
+    void    updateRatsnest() const;
     void    addRatsnestCluster( const std::shared_ptr<CN_CLUSTER>& aCluster );
 
+    ///> Drops the nodes of all nets, before the connectivity items they point to are replaced
+    void    clearNetNodes();
+
     std::shared_ptr<CN_CONNECTIVITY_ALGO> m_connAlgo;
 
     std::vector<RN_DYNAMIC_LINE> m_dynamicRatsnest;
     std::vector<RN_NET*> m_nets;
 
+    ///> True if the ratsnest of the dirty nets is yet to be computed.  It is computed by
+    ///> the first reader, from any thread.
+    mutable std::atomic<bool> m_ratsnestPending;
+    mutable std::mutex        m_ratsnestLock;
+
     PROGRESS_REPORTER* m_progressReporter;
 
     std::mutex m_lock;
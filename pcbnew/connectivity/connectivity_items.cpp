@@ -206,8 +206,8 @@ CN_ITEM* CN_LIST::Add( D_PAD* pad )
     if( !pad->IsOnCopperLayer() )
          return nullptr;
 
-     auto item = new CN_ITEM( pad, false, 1 );
-     item->AddAnchor( pad->ShapePos() );
+     auto item = m_itemArena.New( pad, false, 1 );
+     addAnchor( item, pad->ShapePos() );
      item->SetLayers( LAYER_RANGE( F_Cu, B_Cu ) );
 
      switch( pad->GetAttribute() )
@@ -240,10 +240,10 @@ CN_ITEM* CN_LIST::Add( D_PAD* pad )
 
 CN_ITEM* CN_LIST::Add( TRACK* track )
 {
-    auto item = new CN_ITEM( track, true );
+    auto item = m_itemArena.New( track, true );
     m_items.push_back( item );
-    item->AddAnchor( track->GetStart() );
-    item->AddAnchor( track->GetEnd() );
+    addAnchor( item, track->GetStart() );
+    addAnchor( item, track->GetEnd() );
     item->SetLayer( track->GetLayer() );
     addItemtoTree( item );
     SetDirty();
@@ -252,10 +252,10 @@ CN_ITEM* CN_LIST::Add( TRACK* track )
 
 CN_ITEM* CN_LIST::Add( ARC* aArc )
 {
-    auto item = new CN_ITEM( aArc, true );
+    auto item = m_itemArena.New( aArc, true );
     m_items.push_back( item );
-    item->AddAnchor( aArc->GetStart() );
-    item->AddAnchor( aArc->GetEnd() );
+    addAnchor( item, aArc->GetStart() );
+    addAnchor( item, aArc->GetEnd() );
     item->SetLayer( aArc->GetLayer() );
     addItemtoTree( item );
     SetDirty();
@@ -264,10 +264,10 @@ CN_ITEM* CN_LIST::Add( ARC* aArc )
 
  CN_ITEM* CN_LIST::Add( VIA* via )
  {
-     auto item = new CN_ITEM( via, true, 1 );
+     auto item = m_itemArena.New( via, true, 1 );
 
      m_items.push_back( item );
-     item->AddAnchor( via->GetStart() );
+     addAnchor( item, via->GetStart() );
      item->SetLayers( LAYER_RANGE( F_Cu, B_Cu ) );
      addItemtoTree( item );
      SetDirty();
@@ -282,11 +282,11 @@ CN_ITEM* CN_LIST::Add( ARC* aArc )
 
      for( int j = 0; j < polys.OutlineCount(); j++ )
      {
-         CN_ZONE* zitem = new CN_ZONE( zone, false, j );
+         CN_ZONE* zitem = m_zoneArena.New( zone, false, j );
          const auto& outline = zone->GetFilledPolysList().COutline( j );
 
          for( int k = 0; k < outline.PointCount(); k++ )
-             zitem->AddAnchor( outline.CPoint( k ) );
+             addAnchor( zitem, outline.CPoint( k ) );
 
          m_items.push_back( zitem );
          zitem->SetLayer( zone->GetLayer() );
@@ -299,16 +299,19 @@ CN_ITEM* CN_LIST::Add( ARC* aArc )
  }
 
 
-void CN_LIST::RemoveInvalidItems( std::vector<CN_ITEM*>& aGarbage )
+void CN_LIST::RemoveInvalidItems()
 {
     if( !m_hasInvalid )
         return;
 
-    auto lastItem = std::remove_if(m_items.begin(), m_items.end(), [&aGarbage] ( CN_ITEM* item )
+    std::vector<CN_ITEM*> garbage;
+    garbage.reserve( 1024 );
+
+    auto lastItem = std::remove_if(m_items.begin(), m_items.end(), [&garbage] ( CN_ITEM* item )
     {
         if( !item->Valid() )
         {
-            aGarbage.push_back ( item );
+            garbage.push_back ( item );
             return true;
         }
 
@@ -320,13 +323,29 @@ void CN_LIST::RemoveInvalidItems( std::vector<CN_ITEM*>& aGarbage )
     for( auto item : m_items )
         item->RemoveInvalidRefs();
 
-    for( auto item : aGarbage )
+    for( auto item : garbage )
+    {
         m_index.Remove( item );
+        freeItem( item );
+    }
 
     m_hasInvalid = false;
 }
 
 
+void CN_LIST::freeItem( CN_ITEM* aItem )
+{
+    for( CN_ANCHOR* anchor : aItem->Anchors() )
+        m_anchorArena.Delete( anchor );
+
+    // The parent may be gone already: tell zones apart by their own type
+    if( CN_ZONE* zone = dynamic_cast<CN_ZONE*>( aItem ) )
+        m_zoneArena.Delete( zone );
+    else
+        m_itemArena.Delete( aItem );
+}
+
+
 BOARD_CONNECTED_ITEM* CN_ANCHOR::Parent() const
 {
     assert( m_item->Valid() );
@@ -345,7 +364,7 @@ bool CN_ANCHOR::Valid() const
 
 bool CN_ANCHOR::IsDangling() const
 {
-    if( !m_cluster )
+    if( m_cluster < 0 )
         return true;
 
     // the minimal number of items connected to item_ref
@@ -382,7 +401,7 @@ bool CN_ANCHOR::IsDangling() const
 
 int CN_ANCHOR::ConnectedItemsCount() const
 {
-    if( !m_cluster )
+    if( m_cluster < 0 )
         return 0;
 
     int connected_count = 0;
@@ -45,6 +45,7 @@
 #include <deque>
 #include <intrusive_list.h>
 
+#include <connectivity/connectivity_arena.h>
 #include <connectivity/connectivity_rtree.h>
 #include <connectivity/connectivity_data.h>
 
@@ -105,12 +106,14 @@ public:
         return m_noline;
     }
 
-    inline void SetCluster( std::shared_ptr<CN_CLUSTER> aCluster )
+    /// Sets the index of the cluster the node belongs to among the clusters of its net
+    inline void SetCluster( int aCluster )
     {
         m_cluster = aCluster;
     }
 
-    inline const std::shared_ptr<CN_CLUSTER>& GetCluster() const
+    /// Returns the index of the cluster of the node within its net, or -1 if none
+    inline int GetCluster() const
     {
         return m_cluster;
     }
@@ -147,12 +150,13 @@ private:
     /// Whether it the node can be a target for ratsnest lines
     bool m_noline = false;
 
-    /// Cluster to which the anchor belongs
-    std::shared_ptr<CN_CLUSTER> m_cluster;
+    /// Index of the cluster to which the anchor belongs, within its net
+    int m_cluster = -1;
 };
 
 
-typedef std::shared_ptr<CN_ANCHOR>  CN_ANCHOR_PTR;
+/// Anchors are owned by the arena of the CN_LIST holding their item
+typedef CN_ANCHOR*                  CN_ANCHOR_PTR;
 typedef std::vector<CN_ANCHOR_PTR>  CN_ANCHORS;
 
 
@@ -179,8 +183,15 @@ private:
     ///> valid flag, used to identify garbage items (we use lazy removal)
     bool m_valid;
 
-    ///> mutex protecting this item's connected_items set to allow parallel connection threads
-    std::mutex m_listLock;
+    friend class CN_CLUSTER_INDEX;
+
+    ///> disjoint set of the item: parent, next item of the set (circular) and rank
+    CN_ITEM* m_setParent;
+    CN_ITEM* m_setNext;
+    int      m_setRank;
+
+    ///> net of the item when it was last linked into its set
+    int      m_setNet;
 
 protected:
     ///> dirty flag, used to identify recently added item not yet scanned into the connectivity search
@@ -205,15 +216,14 @@ public:
         m_anchors.reserve( std::max( 6, aAnchorCount ) );
         m_layers = LAYER_RANGE( 0, PCB_LAYER_ID_COUNT );
         m_connected.reserve( 8 );
+        m_setParent = this;
+        m_setNext = this;
+        m_setRank = 0;
+        m_setNet = Net();
     }
 
     virtual ~CN_ITEM() {};
 
-    void AddAnchor( const VECTOR2I& aPos )
-    {
-        m_anchors.emplace_back( std::make_shared<CN_ANCHOR>( aPos, this ) );
-    }
-
     CN_ANCHORS& Anchors()
     {
         return m_anchors;
@@ -319,10 +329,14 @@ public:
         return m_canChangeNet;
     }
 
+    /**
+     * Function Connect()
+     *
+     * Adds b to the connected items.  Not thread safe: parallel searches collect the
+     * connections they find, and merge them with AppendConnection() and SortConnections().
+     */
     void Connect( CN_ITEM* b )
     {
-        std::lock_guard<std::mutex> lock( m_listLock );
-
         auto i = std::lower_bound( m_connected.begin(), m_connected.end(), b );
 
         if( i != m_connected.end() && *i == b )
@@ -331,6 +345,20 @@ public:
         m_connected.insert( i, b );
     }
 
+    ///> Adds b to the connected items, leaving them unsorted until SortConnections()
+    void AppendConnection( CN_ITEM* b )
+    {
+        m_connected.push_back( b );
+    }
+
+    ///> Sorts the connected items and drops the duplicates
+    void SortConnections()
+    {
+        std::sort( m_connected.begin(), m_connected.end() );
+        m_connected.erase( std::unique( m_connected.begin(), m_connected.end() ),
+                           m_connected.end() );
+    }
+
     void RemoveInvalidRefs();
 
     virtual int             AnchorCount() const;
@@ -398,6 +426,12 @@ private:
 
     CN_RTREE<CN_ITEM*> m_index;
 
+    ///> storage of the items and their anchors, so that a board does not need millions of
+    ///> separate allocations
+    CN_ARENA<CN_ITEM>   m_itemArena;
+    CN_ARENA<CN_ZONE>   m_zoneArena;
+    CN_ARENA<CN_ANCHOR> m_anchorArena;
+
 protected:
     std::vector<CN_ITEM*> m_items;
 
@@ -406,6 +440,13 @@ protected:
         m_index.Insert( item );
     }
 
+    void addAnchor( CN_ITEM* aItem, const VECTOR2I& aPos )
+    {
+        aItem->Anchors().push_back( m_anchorArena.New( aPos, aItem ) );
+    }
+
+    void freeItem( CN_ITEM* aItem );
+
 public:
     CN_LIST()
     {
@@ -413,10 +454,15 @@ public:
         m_hasInvalid = false;
     }
 
+    ~CN_LIST()
+    {
+        Clear();
+    }
+
     void Clear()
     {
         for( auto item : m_items )
-            delete item;
+            freeItem( item );
 
         m_items.clear();
         m_index.RemoveAll();
@@ -450,7 +496,12 @@ public:
         return m_dirty;
     }
 
-    void RemoveInvalidItems( std::vector<CN_ITEM*>& aGarbage );
+    /**
+     * Function RemoveInvalidItems()
+     *
+     * Drops the items marked as invalid, and frees them.
+     */
+    void RemoveInvalidItems();
 
     void ClearDirtyFlags()
     {
@@ -473,6 +524,18 @@ public:
         return m_items.size();
     }
 
+    int AnchorCount() const
+    {
+        return m_anchorArena.Size();
+    }
+
+    ///> Returns the bytes held by the storage of the items and anchors
+    size_t MemoryUsage() const
+    {
+        return m_itemArena.MemoryUsage() + m_zoneArena.MemoryUsage()
+               + m_anchorArena.MemoryUsage() + m_items.capacity() * sizeof( CN_ITEM* );
+    }
+
     CN_ITEM* Add( D_PAD* pad );
 
     CN_ITEM* Add( TRACK* track );
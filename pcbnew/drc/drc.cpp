@@ -48,18 +48,50 @@
 #include <math/util.h>      // for KiROUND
 
 #include <dialog_drc.h>
-#include <wx/progdlg.h>
 #include <board_commit.h>
 #include <geometry/shape_arc.h>
 #include <drc/drc_item.h>
 #include <drc/courtyard_overlap.h>
 #include <tools/zone_filler_tool.h>
+#include <widgets/progress_reporter.h>
+#include <thread_pool.h>
+
+#include <algorithm>
+
+
+thread_local wxPoint DRC::m_padToTestPos;
+thread_local wxPoint DRC::m_segmEnd;
+thread_local double  DRC::m_segmAngle = 0;
+thread_local int     DRC::m_segmLength = 0;
+thread_local int     DRC::m_xcliplo = 0;
+thread_local int     DRC::m_ycliplo = 0;
+thread_local int     DRC::m_xcliphi = 0;
+thread_local int     DRC::m_ycliphi = 0;
+
+thread_local std::vector<MARKER_PCB*>* DRC::m_markerBuffer = nullptr;
+
+
+struct DRC::HOLE_PAD
+{
+    HOLE_PAD( BOARD* aBoard ) :
+            m_module( aBoard ),
+            m_pad( &m_module )
+    {
+    }
+
+    MODULE m_module;
+    D_PAD  m_pad;
+};
+
+thread_local std::unique_ptr<DRC::HOLE_PAD> DRC::m_holePad;
+
 
 DRC::DRC() :
         PCB_TOOL_BASE( "pcbnew.DRCTool" ),
         m_pcbEditorFrame( nullptr ),
         m_pcb( nullptr ),
-        m_drcDialog( nullptr )
+        m_drcDialog( nullptr ),
+        m_incremental( m_copperIndex )
 {
     // establish initial values for everything:
     m_doPad2PadTest     = true;         // enable pad to pad clearance tests
@@ -72,14 +104,6 @@ DRC::DRC() :
 
     m_drcRun = false;
     m_footprintsTested = false;
-
-    m_segmAngle  = 0;
-    m_segmLength = 0;
-
-    m_xcliplo = 0;
-    m_ycliplo = 0;
-    m_xcliphi = 0;
-    m_ycliphi = 0;
 }
 
 
@@ -103,6 +127,10 @@ void DRC::Reset( RESET_REASON aReason )
             DestroyDRCDialog( wxID_OK );
 
         m_pcb = m_pcbEditorFrame->GetBoard();
+
+        // The items of the previous board are gone
+        m_incremental.Stop();
+        m_copperIndex.Clear();
     }
 }
 
@@ -160,12 +188,39 @@ bool DRC::IsDRCDialogShown()
 
 void DRC::addMarkerToPcb( MARKER_PCB* aMarker )
 {
+    if( m_markerBuffer )
+    {
+        m_markerBuffer->push_back( aMarker );
+        return;
+    }
+
     BOARD_COMMIT commit( m_pcbEditorFrame );
     commit.Add( aMarker );
     commit.Push( wxEmptyString, false, false );
 }
 
 
+void DRC::commitMarkers( std::vector<std::vector<MARKER_PCB*>>& aMarkers )
+{
+    BOARD_COMMIT commit( m_pcbEditorFrame );
+    bool         empty = true;
+
+    for( std::vector<MARKER_PCB*>& markers : aMarkers )
+    {
+        for( MARKER_PCB* marker : markers )
+        {
+            commit.Add( marker );
+            empty = false;
+        }
+
+        markers.clear();
+    }
+
+    if( !empty )
+        commit.Push( wxEmptyString, false, false );
+}
+
+
 void DRC::DestroyDRCDialog( int aReason )
 {
     if( m_drcDialog )
@@ -324,6 +379,11 @@ void DRC::RunTests( wxTextCtrl* aMessages )
     // ( the board can be reloaded )
     m_pcb = m_pcbEditorFrame->GetBoard();
 
+    // Everything gets checked from scratch
+    m_dirtyTracks.clear();
+    m_dirtyAreas.clear();
+    m_removedItems.clear();
+
     if( aMessages )
     {
         aMessages->AppendText( _( "Board Outline...\n" ) );
@@ -387,6 +447,11 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         m_toolMgr->GetTool<ZONE_FILLER_TOOL>()->CheckAllZones( caller );
     }
 
+    // The copper items don't move until the end of the clearance tests.  The index is then
+    // kept up to date for the incremental tests.
+    m_incremental.Stop();
+    m_copperIndex.Build( m_pcb );
+
     // test track and via clearances to other tracks, pads, and vias
     if( aMessages )
     {
@@ -488,6 +553,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         testTextVars();
 
     m_drcRun = true;
+    m_incremental.Start( m_pcb );
 
     // update the m_drcDialog listboxes
     updatePointers();
@@ -501,6 +567,60 @@ void DRC::RunTests( wxTextCtrl* aMessages )
 }
 
 
+void DRC::ItemChanged( BOARD_ITEM* aItem )
+{
+    m_incremental.ItemChanged( aItem );
+}
+
+
+void DRC::ItemRemoved( BOARD_ITEM* aItem )
+{
+    m_incremental.ItemRemoved( aItem );
+}
+
+
+bool DRC::RunIncrementalTests( std::chrono::milliseconds aBudget )
+{
+    if( !m_incremental.HasChanges() )
+        return true;
+
+    std::vector<MARKER_PCB*> newMarkers;
+    std::vector<MARKER_PCB*> staleMarkers;
+
+    m_pcb = m_pcbEditorFrame->GetBoard();
+
+    bool done = m_incremental.Run(
+            [&]( TRACK* aTrack, const std::vector<TRACK*>& aTracks,
+                 const std::vector<D_PAD*>& aPads, const std::vector<ZONE_CONTAINER*>& aZones,
+                 std::vector<MARKER_PCB*>& aMarkers )
+            {
+                MARKER_BUFFER_SCOPE buffer( aMarkers );
+
+                doTrackDrc( aTrack, aTracks, aPads, aZones, m_doZonesTest );
+            },
+            std::chrono::steady_clock::now() + aBudget, newMarkers, staleMarkers );
+
+    BOARD_COMMIT commit( m_pcbEditorFrame );
+
+    for( MARKER_PCB* marker : newMarkers )
+        commit.Add( marker );
+
+    for( MARKER_PCB* marker : staleMarkers )
+        commit.Remove( marker );
+
+    commit.Push( wxEmptyString, false, false );
+
+    // No undo entry holds them
+    for( MARKER_PCB* marker : staleMarkers )
+        delete marker;
+
+    // update the m_drcDialog listboxes
+    updatePointers();
+
+    return done;
+}
+
+
 void DRC::updatePointers()
 {
     // update my pointers, m_pcbEditorFrame is the only unchangeable one
@@ -648,13 +768,22 @@ void DRC::testPad2Pad()
     // Upper limit of pad list (limit not included)
     D_PAD** listEnd = &sortedPads[0] + sortedPads.size();
 
+    // Every pad collects its own markers, which are then committed in list order so that
+    // the results don't depend on the thread scheduling
+    std::vector<std::vector<MARKER_PCB*>> markers( sortedPads.size() );
+
     // Test the pads
-    for( auto& pad : sortedPads )
-    {
-        int x_limit = pad->GetClearance() + pad->GetBoundingRadius() + pad->GetPosition().x;
+    ParallelFor( 0, sortedPads.size(),
+            [&]( size_t ii )
+            {
+                MARKER_BUFFER_SCOPE buffer( markers[ii] );
+                D_PAD*              pad = sortedPads[ii];
+                int x_limit = pad->GetClearance() + pad->GetBoundingRadius() + pad->GetPosition().x;
 
-        doPadToPadsDrc( pad, &pad, listEnd, max_size + x_limit );
-    }
+                doPadToPadsDrc( pad, &sortedPads[ii], listEnd, max_size + x_limit );
+            } );
+
+    commitMarkers( markers );
 }
 
 
@@ -733,51 +862,65 @@ void DRC::testDrilledHoles()
 
 void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
 {
-    wxProgressDialog * progressDialog = NULL;
-    const int delta = 500;  // This is the number of tests between 2 calls to the
-                            // progress bar
-    int count = m_pcb->Tracks().size();
+    const std::vector<TRACK*>& tracks = m_copperIndex.Tracks();
+    std::unique_ptr<WX_PROGRESS_REPORTER> reporter;
 
-    int deltamax = count/delta;
+    // The progress is reported between batches of tracks, from this thread only
+    const size_t batchCount = 50;
+    size_t       batchSize = tracks.size();
 
-    if( aShowProgressBar && deltamax > 3 )
+    // Don't bother the user with a progress dialog for a handful of tracks
+    if( aShowProgressBar && tracks.size() > 2000 )
     {
-        // Do not use wxPD_APP_MODAL style here: it is not necessary and create issues
-        // on OSX
-        progressDialog = new wxProgressDialog( _( "Track clearances" ), wxEmptyString,
-                                               deltamax, aActiveWindow,
-                                               wxPD_AUTO_HIDE | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME );
-        progressDialog->Update( 0, wxEmptyString );
+        reporter = std::make_unique<WX_PROGRESS_REPORTER>( aActiveWindow, _( "Track clearances" ),
+                                                           1, true );
+        batchSize = ( tracks.size() + batchCount - 1 ) / batchCount;
+        reporter->SetMaxProgress( (int) ( ( tracks.size() + batchSize - 1 ) / batchSize ) );
     }
 
-    int ii = 0;
-    count = 0;
+    // Every track collects its own markers, which are then committed in board order so that
+    // the results don't depend on the thread scheduling.  If the user aborts, the markers
+    // found so far are kept.
+    std::vector<std::vector<MARKER_PCB*>> markers( tracks.size() );
+
+    auto testTrack =
+            [&]( size_t ii )
+            {
+                MARKER_BUFFER_SCOPE buffer( markers[ii] );
+                TRACK*              refSeg = tracks[ii];
+                LSET                layers = refSeg->GetLayerSet();
+                EDA_RECT            area = refSeg->GetBoundingBox();
+
+                std::vector<TRACK*>          nearTracks;
+                std::vector<D_PAD*>          nearPads;
+                std::vector<ZONE_CONTAINER*> nearZones;
+
+                area.Inflate( m_copperIndex.GetMaxClearance() );
+
+                // Track pairs are tested once, from the first track of the pair
+                m_copperIndex.QueryTracks( area, layers, nearTracks, ii + 1 );
+                m_copperIndex.QueryPads( area, layers, nearPads );
 
-    for( auto seg_it = m_pcb->Tracks().begin(); seg_it != m_pcb->Tracks().end(); seg_it++ )
+                if( m_doZonesTest )
+                    m_copperIndex.QueryZones( area, layers, nearZones );
+
+                // Test new segment against tracks and pads, optionally against copper zones
+                doTrackDrc( refSeg, nearTracks, nearPads, nearZones, m_doZonesTest );
+            };
+
+    for( size_t done = 0; done < tracks.size(); done += batchSize )
     {
-        if( ii++ > delta )
+        if( !ParallelFor( done, std::min( done + batchSize, tracks.size() ), testTrack,
+                          reporter.get() ) )
         {
-            ii = 0;
-            count++;
-
-            if( progressDialog )
-            {
-                if( !progressDialog->Update( count, wxEmptyString ) )
-                    break;  // Aborted by user
-#ifdef __WXMAC__
-                // Work around a dialog z-order issue on OS X
-                if( count == deltamax )
-                    aActiveWindow->Raise();
-#endif
-            }
+            break;
         }
 
-        // Test new segment against tracks and pads, optionally against copper zones
-        doTrackDrc( *seg_it, seg_it + 1, m_pcb->Tracks().end(), m_doZonesTest );
+        if( reporter )
+            reporter->AdvanceProgress();
     }
 
-    if( progressDialog )
-        progressDialog->Destroy();
+    commitMarkers( markers );
 }
 
 
@@ -995,8 +1138,27 @@ void DRC::testCopperDrawItem( DRAWSEGMENT* aItem )
         break;
     }
 
+    if( itemShape.empty() )
+        return;
+
+    EDA_RECT area;
+
+    for( const SEG& itemSeg : itemShape )
+    {
+        area.Merge( (wxPoint) itemSeg.A );
+        area.Merge( (wxPoint) itemSeg.B );
+    }
+
+    area.Inflate( itemWidth / 2 + m_copperIndex.GetMaxClearance() );
+
+    std::vector<TRACK*> nearTracks;
+    std::vector<D_PAD*> nearPads;
+
+    m_copperIndex.QueryTracks( area, LSET( aItem->GetLayer() ), nearTracks );
+    m_copperIndex.QueryPads( area, LSET( aItem->GetLayer() ), nearPads );
+
     // Test tracks and vias
-    for( auto track : m_pcb->Tracks() )
+    for( TRACK* track : nearTracks )
     {
         if( !track->IsOnLayer( aItem->GetLayer() ) )
             continue;
@@ -1026,7 +1188,7 @@ void DRC::testCopperDrawItem( DRAWSEGMENT* aItem )
     }
 
     // Test pads
-    for( auto pad : m_pcb->GetPads() )
+    for( D_PAD* pad : nearPads )
     {
         if( !pad->IsOnLayer( aItem->GetLayer() ) )
             continue;
@@ -1070,8 +1232,17 @@ void DRC::testCopperTextItem( BOARD_ITEM* aTextItem )
     EDA_RECT bbox = text->GetTextBox();
     SHAPE_RECT rect_area( bbox.GetX(), bbox.GetY(), bbox.GetWidth(), bbox.GetHeight() );
 
+    EDA_RECT area = bbox;
+    area.Inflate( textWidth + m_copperIndex.GetMaxClearance() );
+
+    std::vector<TRACK*> nearTracks;
+    std::vector<D_PAD*> nearPads;
+
+    m_copperIndex.QueryTracks( area, LSET( aTextItem->GetLayer() ), nearTracks );
+    m_copperIndex.QueryPads( area, LSET( aTextItem->GetLayer() ), nearPads );
+
     // Test tracks and vias
-    for( auto track : m_pcb->Tracks() )
+    for( TRACK* track : nearTracks )
     {
         if( !track->IsOnLayer( aTextItem->GetLayer() ) )
             continue;
@@ -1107,7 +1278,7 @@ void DRC::testCopperTextItem( BOARD_ITEM* aTextItem )
     }
 
     // Test pads
-    for( auto pad : m_pcb->GetPads() )
+    for( D_PAD* pad : nearPads )
     {
         if( !pad->IsOnLayer( aTextItem->GetLayer() ) )
             continue;
@@ -1243,14 +1414,11 @@ bool DRC::doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_li
     /* used to test DRC pad to holes: this dummy pad has the size and shape of the hole
      * to test pad to pad hole DRC, using the pad to pad DRC test function.
      * Therefore, this dummy pad is a circle or an oval.
-     * A pad must have a parent because some functions expect a non null parent
-     * to find the parent board, and some other data
      */
-    MODULE  dummymodule( m_pcb );    // Creates a dummy parent
-    D_PAD   dummypad( &dummymodule );
+    D_PAD& dummypad = *holePad();
 
     // Ensure the hole is on all copper layers
-    dummypad.SetLayerSet( all_cu | dummypad.GetLayerSet() );
+    dummypad.SetLayerSet( all_cu | D_PAD::StandardMask() );
 
     // Use the minimal local clearance value for the dummy pad.
     // The clearance of the active pad will be used as minimum distance to a hole
@@ -1442,12 +1610,21 @@ void DRC::setTransitions()
 const int EPSILON = Mils2iu( 5 );
 
 
+D_PAD* DRC::holePad()
+{
+    if( !m_holePad || m_holePad->m_module.GetParent() != m_pcb )
+        m_holePad = std::make_unique<HOLE_PAD>( m_pcb );
+
+    return &m_holePad->m_pad;
+}
+
+
 wxPoint DRC::getLocation( TRACK* aTrack, ZONE_CONTAINER* aConflictZone ) const
 {
-    SHAPE_POLY_SET* conflictOutline;
+    const SHAPE_POLY_SET* conflictOutline;
 
     if( aConflictZone->IsFilled() )
-        conflictOutline = const_cast<SHAPE_POLY_SET*>( &aConflictZone->GetFilledPolysList() );
+        conflictOutline = &aConflictZone->GetFilledPolysList();
     else
         conflictOutline = aConflictZone->Outline();
 
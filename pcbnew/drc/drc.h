@@ -30,9 +30,12 @@
 #include <class_marker_pcb.h>
 #include <geometry/seg.h>
 #include <geometry/shape_poly_set.h>
+#include <chrono>
 #include <memory>
 #include <vector>
 #include <tools/pcb_tool_base.h>
+#include <drc/drc_incremental.h>
+#include <drc/drc_rtree.h>
 
 #define OK_DRC  0
 #define BAD_DRC 1
@@ -157,36 +160,52 @@ private:
     /* In DRC functions, many calculations are using coordinates relative
      * to the position of the segment under test (segm to segm DRC, segm to pad DRC
      * Next variables store coordinates relative to the start point of this segment
+     *
+     * These are scratch values of the test in progress.  As tracks and pads are tested
+     * concurrently, every thread gets its own copy.
      */
-    wxPoint  m_padToTestPos;            // Position of the pad for segm-to-pad and pad-to-pad
-    wxPoint  m_segmEnd;                 // End point of the reference segment (start = (0, 0) )
+    static thread_local wxPoint m_padToTestPos; // Position of the pad for segm-to-pad and pad-to-pad
+    static thread_local wxPoint m_segmEnd;      // End point of the reference segment (start = (0, 0) )
 
     /* Some functions are comparing the ref segm to pads or others segments using
      * coordinates relative to the ref segment considered as the X axis
      * so we store the ref segment length (the end point relative to these axis)
      * and the segment orientation (used to rotate other coordinates)
      */
-    double   m_segmAngle;               // Ref segm orientation in 0.1 degree
-    int      m_segmLength;              // length of the reference segment
+    static thread_local double m_segmAngle;     // Ref segm orientation in 0.1 degree
+    static thread_local int    m_segmLength;    // length of the reference segment
 
     /* variables used in checkLine to test DRC segm to segm:
      * define the area relative to the ref segment that does not contains any other segment
      */
-    int      m_xcliplo;
-    int      m_ycliplo;
-    int      m_xcliphi;
-    int      m_ycliphi;
+    static thread_local int m_xcliplo;
+    static thread_local int m_ycliplo;
+    static thread_local int m_xcliphi;
+    static thread_local int m_ycliphi;
+
+    /// When set, the markers found by the calling thread are collected here instead of being
+    /// committed to the board one at a time
+    static thread_local std::vector<MARKER_PCB*>* m_markerBuffer;
+
+    /// The pad standing for the holes in the tests of the calling thread, see holePad()
+    struct HOLE_PAD;
+    static thread_local std::unique_ptr<HOLE_PAD> m_holePad;
 
     PCB_EDIT_FRAME*        m_pcbEditorFrame;   // The pcb frame editor which owns the board
     BOARD*                 m_pcb;
     SHAPE_POLY_SET         m_board_outlines;   // The board outline including cutouts
     DIALOG_DRC*    m_drcDialog;
+    DRC_RTREE              m_copperIndex;      // Copper items, built for the clearance tests
+                                               // and kept up to date afterwards
 
     std::vector<DRC_ITEM*> m_unconnected;      // list of unconnected pads
     std::vector<DRC_ITEM*> m_footprints;       // list of footprint warnings
     bool                   m_drcRun;
     bool                   m_footprintsTested;
 
+    DRC_INCREMENTAL        m_incremental;      // Changes since the last run, waiting for
+                                               // RunIncrementalTests()
+
     ///> Sets up handlers for various events.
     void setTransitions() override;
 
@@ -199,9 +218,41 @@ private:
 
     /**
      * Adds a DRC marker to the PCB through the COMMIT mechanism.
+     *
+     * Thread-safe as long as a marker buffer is active on the calling thread.
      */
     void addMarkerToPcb( MARKER_PCB* aMarker );
 
+    /**
+     * Redirects the markers of the calling thread to a buffer for the lifetime of the object.
+     */
+    class MARKER_BUFFER_SCOPE
+    {
+    public:
+        MARKER_BUFFER_SCOPE( std::vector<MARKER_PCB*>& aBuffer )
+        {
+            m_markerBuffer = &aBuffer;
+        }
+
+        ~MARKER_BUFFER_SCOPE()
+        {
+            m_markerBuffer = nullptr;
+        }
+    };
+
+    /**
+     * Adds the buffered markers to the PCB in a single commit, in list order.
+     */
+    void commitMarkers( std::vector<std::vector<MARKER_PCB*>>& aMarkers );
+
+    /**
+     * Returns the pad of the calling thread used to test the clearances to a hole: the tests
+     * give it the size and shape of the hole.  It belongs to a dummy footprint of the board
+     * under test, as some functions need a parent to find the board.  It is only created
+     * once per thread and board.
+     */
+    D_PAD* holePad();
+
     /**
      * Fetches a reasonable point for marking a violoation between two non-point objects.
      */
@@ -280,14 +331,17 @@ private:
     /**
      * Test the current segment.
      *
+     * The candidate lists are the items near enough to aRefSeg to possibly violate the
+     * clearance (see #DRC_RTREE), in board order.
+     *
      * @param aRefSeg The segment to test
-     * @param aStartIt the iterator to the first track to test
-     * @param aEndIt the marker for the iterator end
+     * @param aTracks the tracks to test against aRefSeg
+     * @param aPads the pads to test against aRefSeg
+     * @param aZones the filled zones to test against aRefSeg
      * @param aTestZones true if should do copper zones test. This can be very time consumming
-     * @return bool - true if no problems, else false and m_currentMarker is
-     *          filled in with the problem information.
      */
-    void doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterator aEndIt,
+    void doTrackDrc( TRACK* aRefSeg, const std::vector<TRACK*>& aTracks,
+                     const std::vector<D_PAD*>& aPads, const std::vector<ZONE_CONTAINER*>& aZones,
                      bool aTestZones );
 
     /**
@@ -404,6 +458,35 @@ public:
      * @param aMessages = a wxTextControl where to display some activity messages. Can be NULL
      */
     void RunTests( wxTextCtrl* aMessages = NULL );
+
+    /**
+     * Record a change made to the board after a DRC run, so that RunIncrementalTests()
+     * can bring the markers up to date.  Called by BOARD_COMMIT::Push() and by undo and
+     * redo.
+     *
+     * @param aItem is the added or modified item
+     */
+    void ItemChanged( BOARD_ITEM* aItem );
+
+    /**
+     * Record the removal of an item after a DRC run, before it is deleted, see ItemChanged().
+     */
+    void ItemRemoved( BOARD_ITEM* aItem );
+
+    /**
+     * Re-check the board items changed since the last DRC run.
+     *
+     * The track and via tests are re-run for the changed tracks and vias, and for the ones
+     * near changed pads, footprints and zones; their previous markers are replaced.  The
+     * markers referring to removed items are deleted.  Other tests are left to the next
+     * full run.
+     *
+     * The tracks are checked in small batches until aBudget is spent; the remaining ones
+     * are kept for the next call.
+     *
+     * @return true if all the changes have been checked
+     */
+    bool RunIncrementalTests( std::chrono::milliseconds aBudget );
 };
 
 
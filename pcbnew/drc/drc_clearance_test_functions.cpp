@@ -107,10 +107,10 @@ bool poly2segmentDRC( wxPoint* aTref, int aTrefCount, wxPoint aSegStart, wxPoint
 }
 
 
-void DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterator aEndIt,
+void DRC::doTrackDrc( TRACK* aRefSeg, const std::vector<TRACK*>& aTracks,
+                      const std::vector<D_PAD*>& aPads, const std::vector<ZONE_CONTAINER*>& aZones,
                       bool aTestZones )
 {
-    TRACK*    track;
     wxPoint   delta;           // length on X and Y axis of segments
     wxPoint   shape_pos;
 
@@ -251,72 +251,67 @@ void DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterato
      * This dummy pad has the size and shape of the hole
      * to test tracks to pad hole DRC, using checkClearanceSegmToPad test function.
      * Therefore, this dummy pad is a circle or an oval.
-     * A pad must have a parent because some functions expect a non null parent
-     * to find the parent board, and some other data
      */
-    MODULE  dummymodule( m_pcb );    // Creates a dummy parent
-    D_PAD   dummypad( &dummymodule );
+    D_PAD& dummypad = *holePad();
 
     dummypad.SetLayerSet( LSET::AllCuMask() );     // Ensure the hole is on all layers
+    dummypad.SetLocalClearance( 0 );
 
     // Compute the min distance to pads
-    for( MODULE* mod : m_pcb->Modules() )
+    for( D_PAD* pad : aPads )
     {
-        for( D_PAD* pad : mod->Pads() )
-        {
-            SEG padSeg( pad->GetPosition(), pad->GetPosition() );
-
-            // No problem if pads are on another layer, but if a drill hole exists (a pad on
-            // a single layer can have a hole!) we must test the hole
-            if( !( pad->GetLayerSet() & layerMask ).any() )
-            {
-                // We must test the pad hole. In order to use checkClearanceSegmToPad(), a
-                // pseudo pad is used, with a shape and a size like the hole
-                if( pad->GetDrillSize().x == 0 )
-                    continue;
-
-                dummypad.SetSize( pad->GetDrillSize() );
-                dummypad.SetPosition( pad->GetPosition() );
-                dummypad.SetShape( pad->GetDrillShape() == PAD_DRILL_SHAPE_OBLONG ?
-                                                                            PAD_SHAPE_OVAL :
-                                                                            PAD_SHAPE_CIRCLE );
-                dummypad.SetOrientation( pad->GetOrientation() );
-
-                m_padToTestPos = dummypad.GetPosition() - origin;
-
-                if( !checkClearanceSegmToPad( &dummypad, ref_seg_width, ref_seg_clearance ) )
-                {
-                    addMarkerToPcb( new MARKER_PCB( userUnits(), DRCE_TRACK_NEAR_THROUGH_HOLE,
-                                                    getLocation( aRefSeg, pad, padSeg ),
-                                                    aRefSeg, pad ) );
-
-                    if( !m_reportAllTrackErrors )
-                        return;
-                }
+        SEG padSeg( pad->GetPosition(), pad->GetPosition() );
 
+        // No problem if pads are on another layer, but if a drill hole exists (a pad on
+        // a single layer can have a hole!) we must test the hole
+        if( !( pad->GetLayerSet() & layerMask ).any() )
+        {
+            // We must test the pad hole. In order to use checkClearanceSegmToPad(), a
+            // pseudo pad is used, with a shape and a size like the hole
+            if( pad->GetDrillSize().x == 0 )
                 continue;
-            }
 
-            // The pad must be in a net (i.e pt_pad->GetNet() != 0 )
-            // but no problem if the pad netcode is the current netcode (same net)
-            if( pad->GetNetCode()                       // the pad must be connected
-               && net_code_ref == pad->GetNetCode() )   // the pad net is the same as current net -> Ok
-                continue;
+            dummypad.SetSize( pad->GetDrillSize() );
+            dummypad.SetPosition( pad->GetPosition() );
+            dummypad.SetShape( pad->GetDrillShape() == PAD_DRILL_SHAPE_OBLONG ?
+                                                                        PAD_SHAPE_OVAL :
+                                                                        PAD_SHAPE_CIRCLE );
+            dummypad.SetOrientation( pad->GetOrientation() );
 
-            // DRC for the pad
-            shape_pos = pad->ShapePos();
-            m_padToTestPos = shape_pos - origin;
-            int segToPadClearance = std::max( ref_seg_clearance, pad->GetClearance() );
+            m_padToTestPos = dummypad.GetPosition() - origin;
 
-            if( !checkClearanceSegmToPad( pad, ref_seg_width, segToPadClearance ) )
+            if( !checkClearanceSegmToPad( &dummypad, ref_seg_width, ref_seg_clearance ) )
             {
-                addMarkerToPcb( new MARKER_PCB( userUnits(), DRCE_TRACK_NEAR_PAD,
+                addMarkerToPcb( new MARKER_PCB( userUnits(), DRCE_TRACK_NEAR_THROUGH_HOLE,
                                                 getLocation( aRefSeg, pad, padSeg ),
                                                 aRefSeg, pad ) );
 
                 if( !m_reportAllTrackErrors )
                     return;
             }
+
+            continue;
+        }
+
+        // The pad must be in a net (i.e pt_pad->GetNet() != 0 )
+        // but no problem if the pad netcode is the current netcode (same net)
+        if( pad->GetNetCode()                       // the pad must be connected
+           && net_code_ref == pad->GetNetCode() )   // the pad net is the same as current net -> Ok
+            continue;
+
+        // DRC for the pad
+        shape_pos = pad->ShapePos();
+        m_padToTestPos = shape_pos - origin;
+        int segToPadClearance = std::max( ref_seg_clearance, pad->GetClearance() );
+
+        if( !checkClearanceSegmToPad( pad, ref_seg_width, segToPadClearance ) )
+        {
+            addMarkerToPcb( new MARKER_PCB( userUnits(), DRCE_TRACK_NEAR_PAD,
+                                            getLocation( aRefSeg, pad, padSeg ),
+                                            aRefSeg, pad ) );
+
+            if( !m_reportAllTrackErrors )
+                return;
         }
     }
 
@@ -330,9 +325,8 @@ void DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterato
     wxPoint segStartPoint;
     wxPoint segEndPoint;
 
-    for( auto it = aStartIt; it != aEndIt; it++ )
+    for( TRACK* track : aTracks )
     {
-        track = *it;
         // No problem if segments have the same net code:
         if( net_code_ref == track->GetNetCode() )
             continue;
@@ -634,7 +628,7 @@ void DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterato
     {
         SEG refSeg( aRefSeg->GetStart(), aRefSeg->GetEnd() );
 
-        for( ZONE_CONTAINER* zone : m_pcb->Zones() )
+        for( ZONE_CONTAINER* zone : aZones )
         {
             if( zone->GetFilledPolysList().IsEmpty() || zone->GetIsKeepout() )
                 continue;
@@ -645,8 +639,10 @@ void DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterato
             if( zone->GetNetCode() && zone->GetNetCode() == net_code_ref )
                 continue;
 
+            // Only read: the fills are not modified while the tests run, and the distance
+            // queries use no lazily built cache, so they are safe from any thread
             int clearance = std::max( ref_seg_clearance, zone->GetClearance() );
-            SHAPE_POLY_SET* outline = const_cast<SHAPE_POLY_SET*>( &zone->GetFilledPolysList() );
+            const SHAPE_POLY_SET* outline = &zone->GetFilledPolysList();
 
             int error = clearance - outline->Distance( refSeg, ref_seg_width );
 
@@ -0,0 +1,315 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <drc/drc_incremental.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <class_board.h>
+#include <class_marker_pcb.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <drc/drc.h>
+#include <drc/drc_item.h>
+#include <drc/drc_rtree.h>
+#include <thread_pool.h>
+
+
+DRC_INCREMENTAL::DRC_INCREMENTAL( DRC_RTREE& aIndex ) :
+        m_board( nullptr ),
+        m_index( aIndex )
+{
+}
+
+
+void DRC_INCREMENTAL::Start( BOARD* aBoard )
+{
+    Stop();
+    m_board = aBoard;
+}
+
+
+void DRC_INCREMENTAL::Stop()
+{
+    m_board = nullptr;
+    m_dirtyTracks.clear();
+    m_dirtySet.clear();
+    m_removedItems.clear();
+}
+
+
+bool DRC_INCREMENTAL::HasChanges() const
+{
+    return !m_dirtyTracks.empty() || !m_removedItems.empty();
+}
+
+
+void DRC_INCREMENTAL::addDirtyTrack( TRACK* aTrack )
+{
+    if( m_dirtySet.insert( aTrack ).second )
+        m_dirtyTracks.push_back( aTrack );
+}
+
+
+void DRC_INCREMENTAL::addDirtyArea( const EDA_RECT& aArea )
+{
+    EDA_RECT            area = aArea;
+    std::vector<TRACK*> tracks;
+
+    area.Inflate( m_index.GetMaxClearance() );
+    m_index.QueryTracks( area, LSET::AllCuMask(), tracks );
+
+    for( TRACK* track : tracks )
+        addDirtyTrack( track );
+}
+
+
+void DRC_INCREMENTAL::ItemChanged( BOARD_ITEM* aItem )
+{
+    if( !m_board )
+        return;
+
+    std::vector<EDA_RECT> oldBoxes;
+
+    switch( aItem->Type() )
+    {
+    case PCB_TRACE_T:
+    case PCB_ARC_T:
+    case PCB_VIA_T:
+        m_index.Update( aItem );
+        addDirtyTrack( static_cast<TRACK*>( aItem ) );
+        break;
+
+    case PCB_MODULE_T:
+    case PCB_PAD_T:
+    case PCB_ZONE_AREA_T:
+        // The tracks near the old and new copper are tested again
+        m_index.Update( aItem, &oldBoxes );
+
+        for( const EDA_RECT& box : oldBoxes )
+            addDirtyArea( box );
+
+        addDirtyArea( aItem->GetBoundingBox() );
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+void DRC_INCREMENTAL::ItemRemoved( BOARD_ITEM* aItem )
+{
+    if( !m_board || aItem->Type() == PCB_MARKER_T )
+        return;
+
+    m_removedItems.insert( aItem->m_Uuid );
+
+    switch( aItem->Type() )
+    {
+    case PCB_TRACE_T:
+    case PCB_ARC_T:
+    case PCB_VIA_T:
+        if( m_dirtySet.erase( static_cast<TRACK*>( aItem ) ) )
+        {
+            m_dirtyTracks.erase( std::find( m_dirtyTracks.begin(), m_dirtyTracks.end(),
+                                            static_cast<TRACK*>( aItem ) ) );
+        }
+
+        break;
+
+    case PCB_MODULE_T:
+        for( D_PAD* pad : static_cast<MODULE*>( aItem )->Pads() )
+            m_removedItems.insert( pad->m_Uuid );
+
+        addDirtyArea( aItem->GetBoundingBox() );
+        break;
+
+    case PCB_PAD_T:
+    case PCB_ZONE_AREA_T:
+        addDirtyArea( aItem->GetBoundingBox() );
+        break;
+
+    default:
+        break;
+    }
+
+    m_index.Remove( aItem );
+}
+
+
+bool DRC_INCREMENTAL::IsTrackTestError( int aErrorCode )
+{
+    switch( aErrorCode )
+    {
+    case DRCE_TOO_SMALL_MICROVIA:
+    case DRCE_TOO_SMALL_MICROVIA_DRILL:
+    case DRCE_TOO_SMALL_VIA:
+    case DRCE_TOO_SMALL_VIA_DRILL:
+    case DRCE_VIA_HOLE_BIGGER:
+    case DRCE_MICRO_VIA_NOT_ALLOWED:
+    case DRCE_BURIED_VIA_NOT_ALLOWED:
+    case DRCE_MICRO_VIA_INCORRECT_LAYER_PAIR:
+    case DRCE_TOO_SMALL_TRACK_WIDTH:
+    case DRCE_TRACK_NEAR_THROUGH_HOLE:
+    case DRCE_TRACK_NEAR_PAD:
+    case DRCE_VIA_NEAR_VIA:
+    case DRCE_VIA_NEAR_TRACK:
+    case DRCE_TRACK_NEAR_VIA:
+    case DRCE_TRACK_ENDS:
+    case DRCE_TRACK_SEGMENTS_TOO_CLOSE:
+    case DRCE_TRACKS_CROSSING:
+    case DRCE_TRACK_NEAR_ZONE:
+    case DRCE_TRACK_NEAR_EDGE:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+bool DRC_INCREMENTAL::Run( const TRACK_TEST& aTest,
+                           std::chrono::steady_clock::time_point aDeadline,
+                           std::vector<MARKER_PCB*>& aNewMarkers,
+                           std::vector<MARKER_PCB*>& aStaleMarkers )
+{
+    if( !m_board || !HasChanges() )
+        return true;
+
+    // Changes not reported (made outside of a commit) would leave the index with items no
+    // longer on the board: start over from the board then
+    if( m_index.TrackCount() != m_board->Tracks().size() )
+    {
+        m_index.Build( m_board );
+
+        std::unordered_set<TRACK*> tracks( m_board->Tracks().begin(),
+                                           m_board->Tracks().end() );
+
+        m_dirtyTracks.erase( std::remove_if( m_dirtyTracks.begin(), m_dirtyTracks.end(),
+                                             [&]( TRACK* aTrack )
+                                             {
+                                                 return !tracks.count( aTrack );
+                                             } ),
+                             m_dirtyTracks.end() );
+        m_dirtySet = std::unordered_set<TRACK*>( m_dirtyTracks.begin(), m_dirtyTracks.end() );
+    }
+
+    // Position of the pending tracks in the list.  The tracks before the current batch are
+    // tested, the ones after it still pending.
+    std::unordered_map<TRACK*, size_t> pending;
+
+    for( size_t ii = 0; ii < m_dirtyTracks.size(); ++ii )
+        pending[ m_dirtyTracks[ii] ] = ii;
+
+    size_t batchSize = std::max<size_t>( THREAD_POOL::Get().GetThreadCount() * 4, 16 );
+    size_t done = 0;
+
+    while( done < m_dirtyTracks.size() )
+    {
+        size_t batchEnd = std::min( done + batchSize, m_dirtyTracks.size() );
+
+        std::vector<std::vector<MARKER_PCB*>> markers( batchEnd - done );
+
+        ParallelFor( done, batchEnd,
+                [&]( size_t ii )
+                {
+                    TRACK*   refSeg = m_dirtyTracks[ii];
+                    LSET     layers = refSeg->GetLayerSet();
+                    EDA_RECT area = refSeg->GetBoundingBox();
+
+                    std::vector<TRACK*>          candidates;
+                    std::vector<TRACK*>          nearTracks;
+                    std::vector<D_PAD*>          nearPads;
+                    std::vector<ZONE_CONTAINER*> nearZones;
+
+                    area.Inflate( m_index.GetMaxClearance() );
+
+                    m_index.QueryTracks( area, layers, candidates );
+                    m_index.QueryPads( area, layers, nearPads );
+                    m_index.QueryZones( area, layers, nearZones );
+
+                    // Test every pair once: pending tracks will test this one when their
+                    // turn comes, and pairs within the batch are tested from the first track
+                    for( TRACK* candidate : candidates )
+                    {
+                        auto it = pending.find( candidate );
+
+                        if( it != pending.end() && ( it->second >= batchEnd || it->second <= ii )
+                                && it->second >= done )
+                        {
+                            continue;
+                        }
+
+                        nearTracks.push_back( candidate );
+                    }
+
+                    aTest( refSeg, nearTracks, nearPads, nearZones, markers[ii - done] );
+                } );
+
+        for( std::vector<MARKER_PCB*>& batchMarkers : markers )
+            aNewMarkers.insert( aNewMarkers.end(), batchMarkers.begin(), batchMarkers.end() );
+
+        done = batchEnd;
+
+        if( std::chrono::steady_clock::now() >= aDeadline )
+            break;
+    }
+
+    // The previous track markers of the tracks tested are replaced, and the markers of
+    // removed items are obsolete whatever the test which made them
+    std::set<KIID> retested;
+
+    for( size_t ii = 0; ii < done; ++ii )
+        retested.insert( m_dirtyTracks[ii]->m_Uuid );
+
+    for( MARKER_PCB* marker : m_board->Markers() )
+    {
+        const RC_ITEM* item = marker->GetRCItem();
+
+        if( m_removedItems.count( item->GetMainItemID() )
+                || m_removedItems.count( item->GetAuxItemID() ) )
+        {
+            aStaleMarkers.push_back( marker );
+        }
+        else if( IsTrackTestError( item->GetErrorCode() )
+                    && ( retested.count( item->GetMainItemID() )
+                         || retested.count( item->GetAuxItemID() ) ) )
+        {
+            aStaleMarkers.push_back( marker );
+        }
+    }
+
+    m_removedItems.clear();
+
+    // What didn't fit in the budget is left for the next call
+    for( size_t ii = 0; ii < done; ++ii )
+        m_dirtySet.erase( m_dirtyTracks[ii] );
+
+    m_dirtyTracks.erase( m_dirtyTracks.begin(), m_dirtyTracks.begin() + done );
+
+    return m_dirtyTracks.empty();
+}
@@ -0,0 +1,126 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef DRC_INCREMENTAL_H
+#define DRC_INCREMENTAL_H
+
+#include <chrono>
+#include <functional>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include <common.h>     // KIID
+#include <eda_rect.h>
+
+class BOARD;
+class BOARD_ITEM;
+class D_PAD;
+class DRC_RTREE;
+class MARKER_PCB;
+class TRACK;
+class ZONE_CONTAINER;
+
+
+/**
+ * Keeps the track and via markers of a DRC run up to date as the board is edited, without
+ * testing the whole board again.
+ *
+ * The changes are reported with ItemChanged() and ItemRemoved() as they are made. They keep
+ * the copper index of the DRC up to date, and record which tracks must be tested again: the
+ * changed ones, and the ones near changed pads, footprints and zones. Run() tests them and
+ * gives the markers to add to the board and the markers that are now obsolete.
+ */
+class DRC_INCREMENTAL
+{
+public:
+    /**
+     * Tests aTrack against the tracks, pads and zones given, and adds the markers found to
+     * aMarkers. Called from several threads at once.
+     */
+    typedef std::function<void( TRACK* aTrack, const std::vector<TRACK*>& aTracks,
+                                const std::vector<D_PAD*>& aPads,
+                                const std::vector<ZONE_CONTAINER*>& aZones,
+                                std::vector<MARKER_PCB*>& aMarkers )> TRACK_TEST;
+
+    /**
+     * @param aIndex is the copper index of the DRC, kept up to date with the changes
+     */
+    DRC_INCREMENTAL( DRC_RTREE& aIndex );
+
+    /**
+     * Starts tracking the changes of aBoard, after a full DRC run whose markers are on the
+     * board. The index must have been built for aBoard.
+     */
+    void Start( BOARD* aBoard );
+
+    ///> Stops tracking changes, when the board is replaced for instance
+    void Stop();
+
+    bool IsStarted() const { return m_board != nullptr; }
+
+    /**
+     * Records an added or modified item. The index is updated at once.
+     */
+    void ItemChanged( BOARD_ITEM* aItem );
+
+    /**
+     * Records the removal of an item, before it is deleted.
+     */
+    void ItemRemoved( BOARD_ITEM* aItem );
+
+    bool HasChanges() const;
+
+    /**
+     * Tests the tracks and vias waiting to be tested, a few at a time, until aDeadline.
+     *
+     * Each pair of tracks is tested once. Only the track and via markers of the tracks
+     * tested are replaced, and the markers of removed items are dropped.
+     *
+     * @param aNewMarkers receives the markers found, to be added to the board
+     * @param aStaleMarkers receives the markers of the board made obsolete, to be removed
+     * @return true if all the changes have been tested, false if some are left for the next
+     *         call
+     */
+    bool Run( const TRACK_TEST& aTest, std::chrono::steady_clock::time_point aDeadline,
+              std::vector<MARKER_PCB*>& aNewMarkers, std::vector<MARKER_PCB*>& aStaleMarkers );
+
+    /**
+     * @return true if the error code is one reported by the track and via tests
+     */
+    static bool IsTrackTestError( int aErrorCode );
+
+private:
+    void addDirtyTrack( TRACK* aTrack );
+
+    void addDirtyArea( const EDA_RECT& aArea );
+
+    BOARD*                     m_board;
+    DRC_RTREE&                 m_index;
+
+    std::vector<TRACK*>        m_dirtyTracks;      ///< tracks and vias to test, in change order
+    std::unordered_set<TRACK*> m_dirtySet;         ///< same, to find them
+    std::set<KIID>             m_removedItems;     ///< items whose markers are obsolete
+};
+
+#endif // DRC_INCREMENTAL_H
@@ -0,0 +1,418 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <drc/drc_rtree.h>
+
+#include <algorithm>
+
+#include <board_design_settings.h>
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+
+
+// Bounding boxes and clearance tests don't round the same way; don't let an item slip through
+// the query because of a unit or two.
+static const int QUERY_MARGIN = 10;
+
+
+DRC_RTREE::DRC_RTREE() :
+        m_maxClearance( 0 )
+{
+}
+
+
+DRC_RTREE::~DRC_RTREE()
+{
+}
+
+
+void DRC_RTREE::Clear()
+{
+    m_tracks.clear();
+    m_pads.clear();
+    m_zones.clear();
+
+    for( auto& kindTrees : m_trees )
+    {
+        for( auto& tree : kindTrees )
+            tree.reset();
+    }
+
+    for( int kind = 0; kind < ITEM_KIND_COUNT; ++kind )
+    {
+        m_entries[kind].clear();
+        m_freeIndices[kind].clear();
+        m_slots[kind].clear();
+    }
+
+    m_modulePads.clear();
+    m_maxClearance = 0;
+}
+
+
+void DRC_RTREE::insert( ITEM_KIND aKind, BOARD_ITEM* aItem, const EDA_RECT& aBox, LSET aLayers )
+{
+    int index;
+
+    if( m_freeIndices[aKind].empty() )
+    {
+        index = (int) m_entries[aKind].size();
+        m_entries[aKind].emplace_back();
+
+        switch( aKind )
+        {
+        case TRACK_ITEMS: m_tracks.push_back( nullptr ); break;
+        case PAD_ITEMS:   m_pads.push_back( nullptr );   break;
+        default:          m_zones.push_back( nullptr );  break;
+        }
+    }
+    else
+    {
+        index = m_freeIndices[aKind].back();
+        m_freeIndices[aKind].pop_back();
+    }
+
+    switch( aKind )
+    {
+    case TRACK_ITEMS: m_tracks[index] = static_cast<TRACK*>( aItem );         break;
+    case PAD_ITEMS:   m_pads[index] = static_cast<D_PAD*>( aItem );           break;
+    default:          m_zones[index] = static_cast<ZONE_CONTAINER*>( aItem ); break;
+    }
+
+    EDA_RECT box = aBox;
+    box.Normalize();
+
+    m_entries[aKind][index] = { box, aLayers };
+    m_slots[aKind][aItem] = index;
+
+    const int mmin[2] = { box.GetX(), box.GetY() };
+    const int mmax[2] = { box.GetRight(), box.GetBottom() };
+
+    for( PCB_LAYER_ID layer : aLayers.Seq() )
+    {
+        std::unique_ptr<INDEX_TREE>& tree = m_trees[aKind][layer];
+
+        if( !tree )
+            tree.reset( new INDEX_TREE() );
+
+        tree->Insert( mmin, mmax, index );
+    }
+}
+
+
+bool DRC_RTREE::remove( ITEM_KIND aKind, const BOARD_ITEM* aItem, EDA_RECT* aOldBox )
+{
+    auto it = m_slots[aKind].find( aItem );
+
+    if( it == m_slots[aKind].end() )
+        return false;
+
+    int          index = it->second;
+    const ENTRY& entry = m_entries[aKind][index];
+    const int    mmin[2] = { entry.m_box.GetX(), entry.m_box.GetY() };
+    const int    mmax[2] = { entry.m_box.GetRight(), entry.m_box.GetBottom() };
+
+    for( PCB_LAYER_ID layer : entry.m_layers.Seq() )
+        m_trees[aKind][layer]->Remove( mmin, mmax, index );
+
+    if( aOldBox )
+        *aOldBox = entry.m_box;
+
+    switch( aKind )
+    {
+    case TRACK_ITEMS: m_tracks[index] = nullptr; break;
+    case PAD_ITEMS:   m_pads[index] = nullptr;   break;
+    default:          m_zones[index] = nullptr;  break;
+    }
+
+    m_slots[aKind].erase( it );
+    m_freeIndices[aKind].push_back( index );
+
+    return true;
+}
+
+
+void DRC_RTREE::padEntry( D_PAD* aPad, EDA_RECT& aBox, LSET& aLayers )
+{
+    aBox = aPad->GetBoundingBox();
+    aLayers = aPad->GetLayerSet() & LSET::AllCuMask();
+
+    // A hole goes through all the copper layers whatever the pad layers are
+    if( aPad->GetDrillSize().x > 0 )
+    {
+        wxSize drill = aPad->GetDrillSize();
+        int    radius = std::max( drill.x, drill.y ) / 2;
+
+        aBox.Merge( EDA_RECT( aPad->GetPosition() - wxPoint( radius, radius ),
+                              wxSize( 2 * radius, 2 * radius ) ) );
+        aLayers = LSET::AllCuMask();
+    }
+}
+
+
+bool DRC_RTREE::zoneEntry( ZONE_CONTAINER* aZone, EDA_RECT& aBox, LSET& aLayers )
+{
+    if( aZone->GetIsKeepout() || aZone->GetFilledPolysList().IsEmpty() )
+        return false;
+
+    BOX2I fillBox = aZone->GetFilledPolysList().BBox();
+
+    aBox = EDA_RECT( wxPoint( fillBox.GetX(), fillBox.GetY() ),
+                     wxSize( fillBox.GetWidth(), fillBox.GetHeight() ) );
+    aLayers = aZone->GetLayerSet() & LSET::AllCuMask();
+
+    return true;
+}
+
+
+void DRC_RTREE::Build( BOARD* aBoard )
+{
+    Clear();
+
+    const LSET allCu = LSET::AllCuMask();
+    EDA_RECT   bbox;
+    LSET       layers;
+
+    m_maxClearance = aBoard->GetDesignSettings().GetBiggestClearanceValue();
+
+    for( TRACK* track : aBoard->Tracks() )
+    {
+        insert( TRACK_ITEMS, track, track->GetBoundingBox(), track->GetLayerSet() & allCu );
+        m_maxClearance = std::max( m_maxClearance, track->GetClearance() );
+    }
+
+    for( MODULE* module : aBoard->Modules() )
+    {
+        std::vector<D_PAD*>& modulePads = m_modulePads[module];
+
+        for( D_PAD* pad : module->Pads() )
+        {
+            padEntry( pad, bbox, layers );
+            insert( PAD_ITEMS, pad, bbox, layers );
+            modulePads.push_back( pad );
+            m_maxClearance = std::max( m_maxClearance, pad->GetClearance() );
+
+            // Cached on first use: do it now rather than from several threads later
+            pad->GetBoundingRadius();
+        }
+    }
+
+    for( ZONE_CONTAINER* zone : aBoard->Zones() )
+    {
+        if( !zoneEntry( zone, bbox, layers ) )
+            continue;
+
+        insert( ZONE_ITEMS, zone, bbox, layers );
+        m_maxClearance = std::max( m_maxClearance, zone->GetClearance() );
+    }
+
+    m_maxClearance += QUERY_MARGIN;
+}
+
+
+void DRC_RTREE::updatePad( D_PAD* aPad, std::vector<EDA_RECT>* aOldBoxes )
+{
+    EDA_RECT oldBox;
+    EDA_RECT bbox;
+    LSET     layers;
+
+    if( remove( PAD_ITEMS, aPad, &oldBox ) && aOldBoxes )
+        aOldBoxes->push_back( oldBox );
+
+    padEntry( aPad, bbox, layers );
+    insert( PAD_ITEMS, aPad, bbox, layers );
+    m_maxClearance = std::max( m_maxClearance, aPad->GetClearance() + QUERY_MARGIN );
+
+    aPad->GetBoundingRadius();
+}
+
+
+void DRC_RTREE::Update( BOARD_ITEM* aItem, std::vector<EDA_RECT>* aOldBoxes )
+{
+    EDA_RECT oldBox;
+    EDA_RECT bbox;
+    LSET     layers;
+
+    switch( aItem->Type() )
+    {
+    case PCB_TRACE_T:
+    case PCB_ARC_T:
+    case PCB_VIA_T:
+    {
+        TRACK* track = static_cast<TRACK*>( aItem );
+
+        if( remove( TRACK_ITEMS, track, &oldBox ) && aOldBoxes )
+            aOldBoxes->push_back( oldBox );
+
+        insert( TRACK_ITEMS, track, track->GetBoundingBox(),
+                track->GetLayerSet() & LSET::AllCuMask() );
+        m_maxClearance = std::max( m_maxClearance, track->GetClearance() + QUERY_MARGIN );
+        break;
+    }
+
+    case PCB_PAD_T:
+        updatePad( static_cast<D_PAD*>( aItem ), aOldBoxes );
+        break;
+
+    case PCB_MODULE_T:
+    {
+        MODULE*              module = static_cast<MODULE*>( aItem );
+        std::vector<D_PAD*>& modulePads = m_modulePads[module];
+
+        // The pads the footprint no longer has (swapped by an undo, for instance)
+        for( D_PAD* pad : modulePads )
+        {
+            if( std::find( module->Pads().begin(), module->Pads().end(), pad )
+                    == module->Pads().end()
+                    && remove( PAD_ITEMS, pad, &oldBox ) && aOldBoxes )
+            {
+                aOldBoxes->push_back( oldBox );
+            }
+        }
+
+        modulePads.assign( module->Pads().begin(), module->Pads().end() );
+
+        for( D_PAD* pad : modulePads )
+            updatePad( pad, aOldBoxes );
+
+        break;
+    }
+
+    case PCB_ZONE_AREA_T:
+    {
+        ZONE_CONTAINER* zone = static_cast<ZONE_CONTAINER*>( aItem );
+
+        if( remove( ZONE_ITEMS, zone, &oldBox ) && aOldBoxes )
+            aOldBoxes->push_back( oldBox );
+
+        if( zoneEntry( zone, bbox, layers ) )
+        {
+            insert( ZONE_ITEMS, zone, bbox, layers );
+            m_maxClearance = std::max( m_maxClearance, zone->GetClearance() + QUERY_MARGIN );
+        }
+
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+
+void DRC_RTREE::Remove( BOARD_ITEM* aItem )
+{
+    // The item may be deleted already: find its kind from the index rather than its type
+    if( remove( TRACK_ITEMS, aItem ) || remove( PAD_ITEMS, aItem ) || remove( ZONE_ITEMS, aItem ) )
+        return;
+
+    auto it = m_modulePads.find( aItem );
+
+    if( it != m_modulePads.end() )
+    {
+        for( D_PAD* pad : it->second )
+            remove( PAD_ITEMS, pad );
+
+        m_modulePads.erase( it );
+    }
+}
+
+
+void DRC_RTREE::query( ITEM_KIND aKind, const EDA_RECT& aArea, LSET aLayers,
+                       std::vector<int>& aResult ) const
+{
+    EDA_RECT  area = aArea;
+    area.Normalize();
+
+    const int mmin[2] = { area.GetX(), area.GetY() };
+    const int mmax[2] = { area.GetRight(), area.GetBottom() };
+
+    aResult.clear();
+
+    for( int layer = 0; layer < MAX_CU_LAYERS; ++layer )
+    {
+        const std::unique_ptr<INDEX_TREE>& tree = m_trees[aKind][layer];
+
+        if( !tree || !aLayers[layer] )
+            continue;
+
+        tree->Search( mmin, mmax,
+                [&aResult]( const int& aIndex )
+                {
+                    aResult.push_back( aIndex );
+                    return true;
+                } );
+    }
+
+    // Items living on several layers are found once per layer
+    std::sort( aResult.begin(), aResult.end() );
+    aResult.erase( std::unique( aResult.begin(), aResult.end() ), aResult.end() );
+}
+
+
+void DRC_RTREE::QueryTracks( const EDA_RECT& aArea, LSET aLayers, std::vector<TRACK*>& aResult,
+                             size_t aFirst ) const
+{
+    std::vector<int> indices;
+
+    query( TRACK_ITEMS, aArea, aLayers, indices );
+
+    aResult.clear();
+
+    for( int index : indices )
+    {
+        if( (size_t) index >= aFirst )
+            aResult.push_back( m_tracks[index] );
+    }
+}
+
+
+void DRC_RTREE::QueryPads( const EDA_RECT& aArea, LSET aLayers,
+                           std::vector<D_PAD*>& aResult ) const
+{
+    std::vector<int> indices;
+
+    query( PAD_ITEMS, aArea, aLayers, indices );
+
+    aResult.clear();
+
+    for( int index : indices )
+        aResult.push_back( m_pads[index] );
+}
+
+
+void DRC_RTREE::QueryZones( const EDA_RECT& aArea, LSET aLayers,
+                            std::vector<ZONE_CONTAINER*>& aResult ) const
+{
+    std::vector<int> indices;
+
+    query( ZONE_ITEMS, aArea, aLayers, indices );
+
+    aResult.clear();
+
+    for( int index : indices )
+        aResult.push_back( m_zones[index] );
+}
@@ -0,0 +1,182 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef DRC_RTREE_H
+#define DRC_RTREE_H
+
+#include <eda_rect.h>
+#include <layers_id_colors_and_visibility.h>
+#include <geometry/rtree.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class BOARD;
+class BOARD_ITEM;
+class D_PAD;
+class TRACK;
+class ZONE_CONTAINER;
+
+
+/**
+ * Per copper layer spatial index of the tracks, vias, pads and filled copper zones of a board,
+ * used by the DRC to find the items that can possibly be closer than the clearance to a
+ * given item instead of testing every pair.
+ *
+ * Query results come back in board order (the order of BOARD::Tracks(), BOARD::GetPads()
+ * and BOARD::Zones()) so that the reported violations do not depend on the tree layout.
+ *
+ * The index can be queried from several threads at once, as long as it is not updated at the
+ * same time. Non-owning: the index must be rebuilt, or updated with Update() and Remove(),
+ * when the board items change.
+ *
+ * Items added by Update() are not in board order: they take the place of removed items or
+ * go after the other ones.
+ */
+class DRC_RTREE
+{
+public:
+    DRC_RTREE();
+    ~DRC_RTREE();
+
+    /**
+     * Index the copper items of aBoard.
+     *
+     * This also computes the lazily cached pad data used by the clearance tests, so that
+     * they can run concurrently afterwards.
+     */
+    void Build( BOARD* aBoard );
+
+    void Clear();
+
+    /**
+     * Add aItem to the index, or move it to its current place if already indexed.
+     *
+     * A footprint stands for its pads, including the pads it no longer has. Zones are only
+     * indexed while filled. Items other than tracks, vias, pads, footprints and zones are
+     * ignored.
+     *
+     * @param aOldBoxes receives the previous bounding boxes of the items moved, if given
+     */
+    void Update( BOARD_ITEM* aItem, std::vector<EDA_RECT>* aOldBoxes = nullptr );
+
+    /**
+     * Remove aItem from the index (a footprint stands for its pads).  aItem is not
+     * dereferenced when it is a track, pad or zone: it may be deleted already.
+     */
+    void Remove( BOARD_ITEM* aItem );
+
+    /**
+     * The items by index, in board order after Build().  The entries of the items removed
+     * since are null.
+     */
+    const std::vector<TRACK*>&          Tracks() const { return m_tracks; }
+    const std::vector<D_PAD*>&          Pads() const   { return m_pads; }
+    const std::vector<ZONE_CONTAINER*>& Zones() const  { return m_zones; }
+
+    ///> Returns the number of tracks and vias in the index
+    size_t TrackCount() const { return m_slots[TRACK_ITEMS].size(); }
+
+    /**
+     * @return the largest clearance any two indexed items can require, plus a small safety
+     *         margin for rounding errors.  Inflating the bounding box of an item by this
+     *         value gives an area containing everything that item must be tested against.
+     */
+    int GetMaxClearance() const { return m_maxClearance; }
+
+    /**
+     * Collect the tracks and vias on one of aLayers whose bounding box intersects aArea.
+     *
+     * @param aFirst skips the tracks before this index of Tracks().
+     */
+    void QueryTracks( const EDA_RECT& aArea, LSET aLayers, std::vector<TRACK*>& aResult,
+                      size_t aFirst = 0 ) const;
+
+    /**
+     * Collect the pads on one of aLayers whose bounding box intersects aArea.  Drilled
+     * pads are found on all copper layers.
+     */
+    void QueryPads( const EDA_RECT& aArea, LSET aLayers, std::vector<D_PAD*>& aResult ) const;
+
+    /**
+     * Collect the filled, non keepout zones on one of aLayers whose fill bounding box
+     * intersects aArea.
+     */
+    void QueryZones( const EDA_RECT& aArea, LSET aLayers,
+                     std::vector<ZONE_CONTAINER*>& aResult ) const;
+
+private:
+    ///> The items are stored by their index in the item lists
+    typedef RTree<int, int, 2, double> INDEX_TREE;
+
+    enum ITEM_KIND
+    {
+        TRACK_ITEMS = 0,
+        PAD_ITEMS,
+        ZONE_ITEMS,
+        ITEM_KIND_COUNT
+    };
+
+    ///> Where an item is stored in the trees
+    struct ENTRY
+    {
+        EDA_RECT m_box;
+        LSET     m_layers;
+    };
+
+    void insert( ITEM_KIND aKind, BOARD_ITEM* aItem, const EDA_RECT& aBox, LSET aLayers );
+
+    ///> @return false if aItem was not in the index
+    bool remove( ITEM_KIND aKind, const BOARD_ITEM* aItem, EDA_RECT* aOldBox = nullptr );
+
+    ///> @return false if the zone is not to be indexed
+    static bool zoneEntry( ZONE_CONTAINER* aZone, EDA_RECT& aBox, LSET& aLayers );
+
+    static void padEntry( D_PAD* aPad, EDA_RECT& aBox, LSET& aLayers );
+
+    void updatePad( D_PAD* aPad, std::vector<EDA_RECT>* aOldBoxes );
+
+    void query( ITEM_KIND aKind, const EDA_RECT& aArea, LSET aLayers,
+                std::vector<int>& aResult ) const;
+
+    std::vector<TRACK*>             m_tracks;
+    std::vector<D_PAD*>             m_pads;
+    std::vector<ZONE_CONTAINER*>    m_zones;
+
+    std::vector<ENTRY>              m_entries[ITEM_KIND_COUNT];
+    std::vector<int>                m_freeIndices[ITEM_KIND_COUNT];
+
+    ///> Index of every item in its item list
+    std::unordered_map<const BOARD_ITEM*, int> m_slots[ITEM_KIND_COUNT];
+
+    ///> Pads indexed for each footprint, to find the ones it no longer has
+    std::unordered_map<const BOARD_ITEM*, std::vector<D_PAD*>> m_modulePads;
+
+    ///> Trees are only allocated for the layers actually holding items
+    std::unique_ptr<INDEX_TREE>     m_trees[ITEM_KIND_COUNT][MAX_CU_LAYERS];
+
+    int                             m_maxClearance;
+};
+
+#endif // DRC_RTREE_H
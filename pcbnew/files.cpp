@@ -47,6 +47,7 @@
 #include <wildcards_and_files_ext.h>
 
 #include <class_board.h>
+#include <board_snapshot.h>
 #include <build_version.h>      // LEGACY_BOARD_FILE_VERSION
 
 #include <wx/stdpaths.h>
@@ -785,6 +786,11 @@ bool PCB_EDIT_FRAME::SavePcbFile( const wxString& aFileName, bool aCreateBackupF
     if( autoSaveFileName.FileExists() )
         wxRemoveFile( autoSaveFileName.GetFullPath() );
 
+    wxString snapshotFileName = BOARD_SNAPSHOT::GetFileName( autoSaveFileName.GetFullPath() );
+
+    if( wxFileExists( snapshotFileName ) )
+        wxRemoveFile( snapshotFileName );
+
     if( !!backupFileName )
         upperTxt.Printf( _( "Backup file: \"%s\"" ), GetChars( backupFileName ) );
 
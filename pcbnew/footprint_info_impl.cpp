@@ -47,6 +47,14 @@ void FOOTPRINT_INFO_IMPL::load()
 
     wxASSERT( fptable );
 
+    // The library index spares loading the footprint
+    if( fptable->GetEnumeratedFootprintInfo( m_nickname, m_fpname, &m_doc, &m_keywords,
+                                             &m_pad_count, &m_unique_pad_count ) )
+    {
+        m_loaded = true;
+        return;
+    }
+
     const MODULE* footprint = fptable->GetEnumeratedFootprint( m_nickname, m_fpname );
 
     if( footprint == NULL ) // Should happen only with malformed/broken libraries
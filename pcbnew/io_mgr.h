@@ -424,6 +424,21 @@ public:
                                                   const wxString& aFootprintName,
                                                   const PROPERTIES* aProperties = NULL );
 
+    /**
+     * Function GetEnumeratedFootprintInfo
+     * fetches the description, keywords and pad counts of a footprint found by a previous
+     * FootprintEnumerate(), without loading the footprint when the plugin keeps an index of
+     * its libraries.
+     *
+     * @return false if the plugin has no index entry for the footprint: the caller then gets
+     *         them from GetEnumeratedFootprint().
+     */
+    virtual bool GetEnumeratedFootprintInfo( const wxString& aLibraryPath,
+                                             const wxString& aFootprintName,
+                                             wxString* aDescription, wxString* aKeywords,
+                                             unsigned* aPadCount, unsigned* aUniquePadCount,
+                                             const PROPERTIES* aProperties = NULL );
+
     /**
      * Function FootprintExists
      * check for the existence of a footprint.
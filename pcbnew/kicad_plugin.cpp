@@ -44,7 +44,9 @@
 #include <kicad_plugin.h>
 #include <pcb_parser.h>
 #include <pcbnew_settings.h>
+#include <board_snapshot.h>
 #include <wx/dir.h>
+#include <wx/ffile.h>
 #include <wx/filename.h>
 #include <wx/wfstream.h>
 #include <boost/ptr_container/ptr_map.hpp>
@@ -54,6 +56,10 @@
 #include <kiface_i.h>
 
 #include <advanced_config.h> // for pad pin function and pad property feature management
+#include <md5_hash.h>
+#include <thread_pool.h>
+#include <wx/textfile.h>
+#include <map>
 
 using namespace PCB_KEYS_T;
 
@@ -82,26 +88,162 @@ void filterNetClass( const BOARD& aBoard, NETCLASS& aNetClass )
  * that contain a single module per file.  This class is a helper only for the
  * footprint portion of the PLUGIN API, and only for the #PCB_IO plugin.  It is
  * private to this implementation file so it is not placed into a header.
+ *
+ * Items read from an up to date library index only hold the footprint metadata; the
+ * footprint itself is parsed the first time it is needed (see FP_CACHE::GetModule()).
  */
 class FP_CACHE_ITEM
 {
     WX_FILENAME             m_filename;
-    std::unique_ptr<MODULE> m_module;
+    std::unique_ptr<MODULE> m_module;           // NULL until parsed
+
+    long long               m_timestamp;        // Of the footprint file, for the index
+    long long               m_size;
+    wxString                m_description;
+    wxString                m_keywords;
+    unsigned                m_padCount;
+    unsigned                m_uniquePadCount;
 
 public:
     FP_CACHE_ITEM( MODULE* aModule, const WX_FILENAME& aFileName );
+    FP_CACHE_ITEM( const WX_FILENAME& aFileName, long long aTimestamp, long long aSize );
 
     const WX_FILENAME& GetFileName() const { return m_filename; }
     const MODULE*      GetModule()   const { return m_module.get(); }
+
+    long long       GetTimestamp() const      { return m_timestamp; }
+    long long       GetSize() const           { return m_size; }
+    const wxString& GetDescription() const    { return m_description; }
+    const wxString& GetKeywords() const       { return m_keywords; }
+    unsigned        GetPadCount() const       { return m_padCount; }
+    unsigned        GetUniquePadCount() const { return m_uniquePadCount; }
+
+    /// Take ownership of \a aModule, and take the metadata from it
+    void SetModule( MODULE* aModule );
+
+    void SetInfo( const wxString& aDescription, const wxString& aKeywords, unsigned aPadCount,
+                  unsigned aUniquePadCount );
 };
 
 
 FP_CACHE_ITEM::FP_CACHE_ITEM( MODULE* aModule, const WX_FILENAME& aFileName ) :
     m_filename( aFileName ),
-    m_module( aModule )
+    m_timestamp( 0 ),
+    m_size( 0 )
+{
+    SetModule( aModule );
+}
+
+
+FP_CACHE_ITEM::FP_CACHE_ITEM( const WX_FILENAME& aFileName, long long aTimestamp,
+                              long long aSize ) :
+    m_filename( aFileName ),
+    m_timestamp( aTimestamp ),
+    m_size( aSize ),
+    m_padCount( 0 ),
+    m_uniquePadCount( 0 )
 { }
 
 
+void FP_CACHE_ITEM::SetModule( MODULE* aModule )
+{
+    m_module.reset( aModule );
+
+    SetInfo( aModule->GetDescription(), aModule->GetKeywords(),
+             aModule->GetPadCount( DO_NOT_INCLUDE_NPTH ),
+             aModule->GetUniquePadCount( DO_NOT_INCLUDE_NPTH ) );
+}
+
+
+void FP_CACHE_ITEM::SetInfo( const wxString& aDescription, const wxString& aKeywords,
+                             unsigned aPadCount, unsigned aUniquePadCount )
+{
+    m_description = aDescription;
+    m_keywords = aKeywords;
+    m_padCount = aPadCount;
+    m_uniquePadCount = aUniquePadCount;
+}
+
+
+/**
+ * A footprint as recorded in a library index: enough to tell whether its file changed since,
+ * and to list it without parsing it
+ */
+struct FP_INDEX_ENTRY
+{
+    long long m_timestamp = 0;
+    long long m_size = 0;
+    wxString  m_description;
+    wxString  m_keywords;
+    unsigned  m_padCount = 0;
+    unsigned  m_uniquePadCount = 0;
+};
+
+
+/// First line of the library index files.  Change it when their content changes.
+static const wxChar fpIndexHeader[] = wxT( "(kicad_fp_index (version 2))" );
+
+
+/**
+ * Escape a text field of a library index to fit it on one line.  EscapeString() turns both
+ * line end characters into {return}, so carriage returns get their own {cr} to come back as
+ * they were.
+ */
+static wxString escapeIndexField( const wxString& aField )
+{
+    wxString escaped;
+    size_t   start = 0;
+
+    while( true )
+    {
+        size_t cr = aField.find( '\r', start );
+
+        escaped += EscapeString( aField.substr( start, cr - start ), CTX_DELIMITED_STR );
+
+        if( cr == wxString::npos )
+            return escaped;
+
+        escaped += wxT( "{cr}" );
+        start = cr + 1;
+    }
+}
+
+
+/// The reverse of escapeIndexField()
+static wxString unescapeIndexField( const wxString& aEscaped )
+{
+    wxString field;
+    size_t   start = 0;
+
+    while( true )
+    {
+        size_t cr = aEscaped.find( wxT( "{cr}" ), start );
+
+        field += UnescapeString( aEscaped.substr( start, cr - start ) );
+
+        if( cr == wxString::npos )
+            return field;
+
+        field += '\r';
+        start = cr + 4;
+    }
+}
+
+
+/// Parse the footprint file \a aFileName, and name the footprint after it
+static MODULE* parseFootprint( PCB_PARSER* aParser, const WX_FILENAME& aFileName )
+{
+    WHOLE_FILE_LINE_READER reader( aFileName.GetFullPath() );
+
+    aParser->SetLineReader( &reader );
+
+    MODULE* footprint = (MODULE*) aParser->Parse();
+
+    footprint->SetFPID( LIB_ID( wxEmptyString, aFileName.GetName() ) );
+    return footprint;
+}
+
+
 typedef boost::ptr_map< wxString, FP_CACHE_ITEM >   MODULE_MAP;
 typedef MODULE_MAP::iterator                        MODULE_ITER;
 typedef MODULE_MAP::const_iterator                  MODULE_CITER;
@@ -139,8 +281,22 @@ public:
      */
     void Save( MODULE* aModule = NULL );
 
+    /**
+     * Function Load
+     * reads the library.  Footprints whose file did not change since it was last indexed are
+     * taken from the library index; only the others are parsed (in parallel), after which
+     * the index is updated.
+     */
     void Load();
 
+    /**
+     * Function GetModule
+     * returns the footprint of \a aItem, parsing its file if it was taken from the index.
+     *
+     * @throw IO_ERROR if the footprint file cannot be read or parsed.
+     */
+    const MODULE* GetModule( FP_CACHE_ITEM* aItem );
+
     void Remove( const wxString& aFootprintName );
 
     /**
@@ -170,6 +326,18 @@ public:
      * @return true if \a aPath is the same as the cache path.
      */
     bool IsPath( const wxString& aPath ) const;
+
+private:
+    /**
+     * The index of a library lives in the user cache directory, so that read-only libraries
+     * get one too.  It is named after the hash of the library path.
+     */
+    wxString indexFileName() const;
+
+    void readIndex( std::map<wxString, FP_INDEX_ENTRY>& aIndex ) const;
+
+    /// Failing to write the index only costs parsing the library again next time
+    void writeIndex() const;
 };
 
 
@@ -206,6 +374,13 @@ void FP_CACHE::Save( MODULE* aModule )
 
         WX_FILENAME fn = it->second->GetFileName();
 
+        // Footprints not parsed since the library was read did not change
+        if( !it->second->GetModule() )
+        {
+            m_cache_timestamp += fn.GetTimestamp();
+            continue;
+        }
+
         wxString tempFileName =
 #ifdef USE_TMP_FILE
         wxFileName::CreateTempFileName( fn.GetPath() );
@@ -274,41 +449,176 @@ void FP_CACHE::Load()
     // the filename thereafter.
     WX_FILENAME fn( m_lib_raw_path, wxT( "dummyName" ) );
 
+    std::map<wxString, FP_INDEX_ENTRY> index;
+    std::vector<FP_CACHE_ITEM*>        toParse;
+
+    readIndex( index );
+
     if( dir.GetFirst( &fullName, fileSpec ) )
     {
-        wxString cacheError;
-
         do
         {
             fn.SetFullName( fullName );
 
-            // Queue I/O errors so only files that fail to parse don't get loaded.
-            try
-            {
-                FILE_LINE_READER    reader( fn.GetFullPath() );
+            wxString       fpName = fn.GetName();
+            long long      timestamp = fn.GetTimestamp();
+            long long      size = wxFileName::GetSize( fn.GetFullPath() ).GetValue();
+            FP_CACHE_ITEM* item = new FP_CACHE_ITEM( fn, timestamp, size );
+            auto           entry = index.find( fpName );
 
-                m_owner->m_parser->SetLineReader( &reader );
+            if( entry != index.end() && entry->second.m_timestamp == timestamp
+                    && entry->second.m_size == size )
+            {
+                item->SetInfo( entry->second.m_description, entry->second.m_keywords,
+                               entry->second.m_padCount, entry->second.m_uniquePadCount );
+            }
+            else
+            {
+                toParse.push_back( item );
+            }
 
-                MODULE*     footprint = (MODULE*) m_owner->m_parser->Parse();
-                wxString    fpName = fn.GetName();
+            m_modules.insert( fpName, item );
+        } while( dir.GetNext( &fullName ) );
+    }
 
-                footprint->SetFPID( LIB_ID( wxEmptyString, fpName ) );
-                m_modules.insert( fpName, new FP_CACHE_ITEM( footprint, fn ) );
+    // Parse the new and changed footprints, a few batches per worker thread, each with its
+    // own parser.  Queue I/O errors so only files that fail to parse don't get loaded.
+    std::vector<wxString> errors( toParse.size() );
+    size_t                batchCount = std::min( toParse.size(),
+                                                 4 * THREAD_POOL::Get().GetThreadCount() );
 
-                m_cache_timestamp += fn.GetTimestamp();
-            }
-            catch( const IO_ERROR& ioe )
+    ParallelFor( 0, batchCount,
+            [&]( size_t aBatch )
             {
-                if( !cacheError.IsEmpty() )
-                    cacheError += "\n\n";
+                PCB_PARSER parser;
 
-                cacheError += ioe.What();
-            }
-        } while( dir.GetNext( &fullName ) );
+                for( size_t ii = aBatch; ii < toParse.size(); ii += batchCount )
+                {
+                    try
+                    {
+                        toParse[ii]->SetModule( parseFootprint( &parser,
+                                                                toParse[ii]->GetFileName() ) );
+                    }
+                    catch( const IO_ERROR& ioe )
+                    {
+                        errors[ii] = ioe.What();
+                    }
+                }
+            } );
+
+    wxString cacheError;
+    bool     indexChanged = index.size() != m_modules.size();
+
+    for( size_t ii = 0; ii < toParse.size(); ++ii )
+    {
+        if( errors[ii].IsEmpty() )
+        {
+            indexChanged = true;
+            continue;
+        }
 
         if( !cacheError.IsEmpty() )
-            THROW_IO_ERROR( cacheError );
+            cacheError += "\n\n";
+
+        cacheError += errors[ii];
+        m_modules.erase( toParse[ii]->GetFileName().GetName() );
+    }
+
+    for( MODULE_CITER it = m_modules.begin();  it != m_modules.end();  ++it )
+        m_cache_timestamp += it->second->GetTimestamp();
+
+    if( indexChanged )
+        writeIndex();
+
+    if( !cacheError.IsEmpty() )
+        THROW_IO_ERROR( cacheError );
+}
+
+
+const MODULE* FP_CACHE::GetModule( FP_CACHE_ITEM* aItem )
+{
+    if( !aItem->GetModule() )
+        aItem->SetModule( parseFootprint( m_owner->m_parser, aItem->GetFileName() ) );
+
+    return aItem->GetModule();
+}
+
+
+wxString FP_CACHE::indexFileName() const
+{
+    wxString indexPath = GetUserCachePath() + wxT( "footprints" );
+
+    std::string path = TO_UTF8( m_lib_raw_path );
+    MD5_HASH    hash;
+
+    hash.Hash( reinterpret_cast<uint8_t*>( const_cast<char*>( path.data() ) ), path.size() );
+    hash.Finalize();
+
+    return indexPath + wxFileName::GetPathSeparator() + hash.Format() + wxT( ".index" );
+}
+
+
+void FP_CACHE::readIndex( std::map<wxString, FP_INDEX_ENTRY>& aIndex ) const
+{
+    wxTextFile file( indexFileName() );
+
+    if( !file.Exists() || !file.Open() )
+        return;
+
+    if( file.GetLineCount() < 2 || file.GetFirstLine() != fpIndexHeader
+            || file.GetNextLine() != m_lib_raw_path )
+    {
+        return;
     }
+
+    while( file.GetCurrentLine() + 7 < file.GetLineCount() )
+    {
+        FP_INDEX_ENTRY& entry = aIndex[ file.GetNextLine() ];
+
+        file.GetNextLine().ToLongLong( &entry.m_timestamp );
+        file.GetNextLine().ToLongLong( &entry.m_size );
+        entry.m_description = unescapeIndexField( file.GetNextLine() );
+        entry.m_keywords = unescapeIndexField( file.GetNextLine() );
+        entry.m_padCount = (unsigned) wxAtoi( file.GetNextLine() );
+        entry.m_uniquePadCount = (unsigned) wxAtoi( file.GetNextLine() );
+    }
+}
+
+
+void FP_CACHE::writeIndex() const
+{
+    wxFileName fn( indexFileName() );
+
+    if( !fn.DirExists() && !fn.Mkdir( wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL ) )
+        return;
+
+    wxTextFile file( fn.GetFullPath() );
+
+    if( file.Exists() ? !file.Open() : !file.Create() )
+        return;
+
+    file.Clear();
+    file.AddLine( fpIndexHeader );
+    file.AddLine( m_lib_raw_path );
+
+    for( MODULE_CITER it = m_modules.begin();  it != m_modules.end();  ++it )
+    {
+        const FP_CACHE_ITEM* item = it->second;
+
+        file.AddLine( it->first );
+        file.AddLine( wxString::Format( "%lld", item->GetTimestamp() ) );
+        file.AddLine( wxString::Format( "%lld", item->GetSize() ) );
+        file.AddLine( escapeIndexField( item->GetDescription() ) );
+        file.AddLine( escapeIndexField( item->GetKeywords() ) );
+        file.AddLine( wxString::Format( "%u", item->GetPadCount() ) );
+        file.AddLine( wxString::Format( "%u", item->GetUniquePadCount() ) );
+    }
+
+    if( !file.Write() )
+        wxLogTrace( traceKicadPcbPlugin, wxT( "Cannot write footprint index '%s'." ),
+                    fn.GetFullPath() );
+
+    file.Close();
 }
 
 
@@ -364,12 +674,68 @@ void PCB_IO::Save( const wxString& aFileName, BOARD* aBoard, const PROPERTIES* a
     // Prepare net mapping that assures that net codes saved in a file are consecutive integers
     m_mapping->SetBoard( aBoard );
 
-    FILE_OUTPUTFORMATTER    formatter( aFileName );
+    if( !ADVANCED_CFG::GetCfg().m_boardSnapshots )
+    {
+        FILE_OUTPUTFORMATTER    formatter( aFileName );
+
+        m_out = &formatter;     // no ownership
+
+        formatBoardFile( aBoard );
+
+        m_out = &m_sf;
+        return;
+    }
+
+    // The board is formatted once, in memory: the file is written from that text, and the
+    // snapshot is made from it and from its hash.
+    STRING_FORMATTER                        formatter;
+    std::vector<std::pair<size_t, size_t>>  snapshotRanges;
+
+    m_out = &formatter;
+    m_snapshotRanges = &snapshotRanges;
+
+    formatBoardFile( aBoard );
+
+    m_out = &m_sf;
+    m_snapshotRanges = nullptr;
+
+    const std::string& text = formatter.GetString();
+
+    {
+        // Binary mode, for the file to hold the very bytes which are hashed
+        wxFFile file;
 
-    m_out = &formatter;     // no ownership
+        if( !file.Open( aFileName, wxT( "wb" ) )
+                || file.Write( text.data(), text.size() ) != text.size() || !file.Close() )
+        {
+            THROW_IO_ERROR( wxString::Format( _( "Cannot write file \"%s\"" ), aFileName ) );
+        }
+    }
+
+    wxString snapshotFileName = BOARD_SNAPSHOT::GetFileName( aFileName );
+
+    // The snapshot is only a cache: failing to write it does not fail the save
+    try
+    {
+        BOARD_SNAPSHOT snapshot;
+
+        snapshot.Store( aBoard, text, snapshotRanges );
+        snapshot.Write( snapshotFileName, BOARD_SNAPSHOT::HashString( text ) );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        wxLogTrace( traceKicadPcbPlugin, wxT( "Board snapshot not written: %s" ), ioe.What() );
+
+        if( wxFileExists( snapshotFileName ) )
+            wxRemoveFile( snapshotFileName );
+    }
+}
 
+
+void PCB_IO::formatBoardFile( BOARD* aBoard ) const
+{
     m_out->Print( 0, "(kicad_pcb (version %d) (host pcbnew %s)\n", SEXPR_BOARD_FILE_VERSION,
-                  formatter.Quotew( GetBuildVersion() ).c_str() );
+                  m_out->Quotew( GetBuildVersion() ).c_str() );
 
     Format( aBoard, 1 );
 
@@ -377,6 +743,12 @@ void PCB_IO::Save( const wxString& aFileName, BOARD* aBoard, const PROPERTIES* a
 }
 
 
+size_t PCB_IO::snapshotOffset() const
+{
+    return static_cast<STRING_FORMATTER*>( m_out )->GetString().size();
+}
+
+
 BOARD_ITEM* PCB_IO::Parse( const wxString& aClipboardSourceInput )
 {
     std::string input = TO_UTF8( aClipboardSourceInput );
@@ -787,12 +1159,17 @@ void PCB_IO::format( BOARD* aBoard, int aNestLevel ) const
     // Do not save MARKER_PCBs, they can be regenerated easily.
 
     // Save the tracks and vias.
+    size_t tracksStart = m_snapshotRanges ? snapshotOffset() : 0;
+
     for( auto track : aBoard->Tracks() )
         Format( track, aNestLevel );
 
     if( aBoard->Tracks().size() )
         m_out->Print( 0, "\n" );
 
+    if( m_snapshotRanges )
+        m_snapshotRanges->emplace_back( tracksStart, snapshotOffset() );
+
     // Save the polygon (which are the newer technology) zones.
     for( int i = 0; i < aBoard->GetAreaCount();  ++i )
         Format( aBoard->GetArea( i ), aNestLevel );
@@ -1945,6 +2322,10 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
     const SHAPE_POLY_SET& fv = aZone->GetFilledPolysList();
     newLine = 0;
 
+    // The snapshot holds the fills of the board zones, not of the footprint ones
+    bool   snapshotFill = m_snapshotRanges && aZone->Type() == PCB_ZONE_AREA_T;
+    size_t fillStart = snapshotFill ? snapshotOffset() : 0;
+
     if( !fv.IsEmpty() )
     {
         bool new_polygon = true;
@@ -2012,6 +2393,9 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
         m_out->Print( aNestLevel+1, ")\n" );
     }
 
+    if( snapshotFill )
+        m_snapshotRanges->emplace_back( fillStart, snapshotOffset() );
+
     m_out->Print( aNestLevel, ")\n" );
 }
 
@@ -2037,10 +2421,35 @@ PCB_IO::~PCB_IO()
 
 BOARD* PCB_IO::Load( const wxString& aFileName, BOARD* aAppendToMe, const PROPERTIES* aProperties )
 {
-    FILE_LINE_READER    reader( aFileName );
-
     init( aProperties );
 
+    // A snapshot made from this very file spares parsing most of it
+    if( !aAppendToMe && ADVANCED_CFG::GetCfg().m_boardSnapshots )
+    {
+        wxString       snapshotFileName = BOARD_SNAPSHOT::GetFileName( aFileName );
+        BOARD_SNAPSHOT snapshot;
+
+        // Hashing the board file is only worth it if there is a snapshot to match
+        if( wxFileExists( snapshotFileName )
+                && snapshot.Read( snapshotFileName, BOARD_SNAPSHOT::HashFile( aFileName ) ) )
+        {
+            try
+            {
+                BOARD* board = snapshot.Restore( aFileName );
+
+                board->SetFileName( aFileName );
+                return board;
+            }
+            catch( const IO_ERROR& ioe )
+            {
+                wxLogTrace( traceKicadPcbPlugin, wxT( "Board snapshot not restored: %s" ),
+                            ioe.What() );
+            }
+        }
+    }
+
+    WHOLE_FILE_LINE_READER reader( aFileName );
+
     m_parser->SetLineReader( &reader );
     m_parser->SetBoard( aAppendToMe );
 
@@ -2085,6 +2494,7 @@ void PCB_IO::init( const PROPERTIES* aProperties )
     m_reader = NULL;
     m_loading_format_version = SEXPR_BOARD_FILE_VERSION;
     m_props = aProperties;
+    m_snapshotRanges = nullptr;
 }
 
 
@@ -2147,14 +2557,56 @@ const MODULE* PCB_IO::getFootprint( const wxString& aLibraryPath,
         // do nothing with the error
     }
 
+    MODULE_MAP& mods = m_cache->GetModules();
+
+    MODULE_ITER it = mods.find( aFootprintName );
+
+    if( it == mods.end() )
+        return nullptr;
+
+    try
+    {
+        return m_cache->GetModule( it->second );
+    }
+    catch( const IO_ERROR& )
+    {
+        // the file changed since the library was read, or cannot be read anymore
+        return nullptr;
+    }
+}
+
+
+bool PCB_IO::GetEnumeratedFootprintInfo( const wxString& aLibraryPath,
+                                         const wxString& aFootprintName,
+                                         wxString* aDescription, wxString* aKeywords,
+                                         unsigned* aPadCount, unsigned* aUniquePadCount,
+                                         const PROPERTIES* aProperties )
+{
+    LOCALE_IO   toggle;     // toggles on, then off, the C locale.
+
+    init( aProperties );
+
+    try
+    {
+        validateCache( aLibraryPath, false );
+    }
+    catch( const IO_ERROR& )
+    {
+        // do nothing with the error
+    }
+
     const MODULE_MAP& mods = m_cache->GetModules();
 
     MODULE_CITER it = mods.find( aFootprintName );
 
     if( it == mods.end() )
-        return nullptr;
+        return false;
 
-    return it->second->GetModule();
+    *aDescription = it->second->GetDescription();
+    *aKeywords = it->second->GetKeywords();
+    *aPadCount = it->second->GetPadCount();
+    *aUniquePadCount = it->second->GetUniquePadCount();
+    return true;
 }
 
 
@@ -27,6 +27,8 @@
 
 #include <io_mgr.h>
 #include <string>
+#include <utility>
+#include <vector>
 #include <layers_id_colors_and_visibility.h>
 
 class BOARD;
@@ -100,6 +102,7 @@ class TEXTE_PCB;
 class PCB_IO : public PLUGIN
 {
     friend class FP_CACHE;
+    friend class BOARD_SNAPSHOT;
 
 public:
 
@@ -132,6 +135,12 @@ public:
                                           const wxString& aFootprintName,
                                           const PROPERTIES* aProperties = NULL ) override;
 
+    bool GetEnumeratedFootprintInfo( const wxString& aLibraryPath,
+                                     const wxString& aFootprintName,
+                                     wxString* aDescription, wxString* aKeywords,
+                                     unsigned* aPadCount, unsigned* aUniquePadCount,
+                                     const PROPERTIES* aProperties = NULL ) override;
+
     bool FootprintExists( const wxString& aLibraryPath, const wxString& aFootprintName,
                           const PROPERTIES* aProperties = NULL ) override;
 
@@ -202,6 +211,10 @@ protected:
     NETINFO_MAPPING*    m_mapping;  ///< mapping for net codes, so only not empty net codes
                                     ///< are stored with consecutive integers as net codes
 
+    /// When set, receives the byte ranges of m_out, then a STRING_FORMATTER, holding the
+    /// tracks and the zone fills, which BOARD_SNAPSHOT stores in binary.  No ownership.
+    std::vector<std::pair<size_t, size_t>>* m_snapshotRanges;
+
     void validateCache( const wxString& aLibraryPath, bool checkModified = true );
 
     const MODULE* getFootprint( const wxString& aLibraryPath, const wxString& aFootprintName,
@@ -227,6 +240,12 @@ protected:
     /// writes everything that comes before the board_items, like settings and layers etc
     void formatHeader( BOARD* aBoard, int aNestLevel = 0 ) const;
 
+    /// formats \a aBoard as a whole board file
+    void formatBoardFile( BOARD* aBoard ) const;
+
+    /// @return the size of the output so far, while m_snapshotRanges is set
+    size_t snapshotOffset() const;
+
 private:
     void format( BOARD* aBoard, int aNestLevel = 0 ) const;
 
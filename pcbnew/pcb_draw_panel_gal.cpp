@@ -39,12 +39,12 @@
 #include <pgm_base.h>
 #include <settings/settings_manager.h>
 #include <confirm.h>
+#include <thread_pool.h>
 
 #include <gal/graphics_abstraction_layer.h>
 
 #include <functional>
 #include <memory>
-#include <thread>
 using namespace std::placeholders;
 
 const LAYER_NUM GAL_LAYER_ORDER[] =
@@ -144,23 +144,11 @@ void PCB_DRAW_PANEL_GAL::DisplayBoard( BOARD* aBoard )
 
     m_view->Clear();
 
-    auto zones = aBoard->Zones();
-    std::atomic<size_t> next( 0 );
-    std::atomic<size_t> count_done( 0 );
-    size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+    // Triangulate the zones in the background while the other items are added to the view
+    TASK_GROUP triangulation;
 
-    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-    {
-        std::thread t = std::thread( [ &count_done, &next, &zones ]( )
-        {
-            for( size_t i = next.fetch_add( 1 ); i < zones.size(); i = next.fetch_add( 1 ) )
-                zones[i]->CacheTriangulation();
-
-            count_done++;
-        } );
-
-        t.detach();
-    }
+    for( ZONE_CONTAINER* zone : aBoard->Zones() )
+        triangulation.Run( [zone]() { zone->CacheTriangulation(); } );
 
     if( m_worksheet )
         m_worksheet->SetFileName( TO_UTF8( aBoard->GetFileName() ) );
@@ -181,9 +169,7 @@ void PCB_DRAW_PANEL_GAL::DisplayBoard( BOARD* aBoard )
     for( auto marker : aBoard->Markers() )
         m_view->Add( marker );
 
-    // Finalize the triangulation threads
-    while( count_done < parallelThreadCount )
-        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    triangulation.Wait();
 
     // Load zones
     for( auto zone : aBoard->Zones() )
@@ -47,6 +47,7 @@
 #include <class_track.h>
 #include <class_board.h>
 #include <class_module.h>
+#include <board_snapshot.h>
 #include <ws_proxy_view_item.h>
 #include <connectivity/connectivity_data.h>
 #include <ratsnest_viewitem.h>
@@ -578,6 +579,11 @@ void PCB_EDIT_FRAME::OnCloseWindow( wxCloseEvent& aEvent )
         wxMessageBox( msg, Pgm().App().GetAppName(), wxOK | wxICON_ERROR, this );
     }
 
+    wxString snapshotFileName = BOARD_SNAPSHOT::GetFileName( fn.GetFullPath() );
+
+    if( wxFileExists( snapshotFileName ) )
+        wxRemoveFile( snapshotFileName );
+
     // Do not show the layer manager during closing to avoid flicker
     // on some platforms (Windows) that generate useless redraw of items in
     // the Layer Manger
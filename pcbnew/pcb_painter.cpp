@@ -48,6 +48,15 @@
 
 using namespace KIGFX;
 
+
+/// The kinds of shapes drawn by instances, see SHAPE_INSTANCE_KEY
+enum SHAPE_INSTANCE_KIND
+{
+    PAD_SHAPE_INSTANCE,
+    PAD_HOLE_INSTANCE,
+    CIRCLE_INSTANCE
+};
+
 PCB_RENDER_SETTINGS::PCB_RENDER_SETTINGS()
 {
     m_backgroundColor = COLOR4D( 0.0, 0.0, 0.0, 1.0 );
@@ -303,6 +312,19 @@ PCB_PAINTER::PCB_PAINTER( GAL* aGal ) :
 }
 
 
+std::unique_ptr<PAINTER> PCB_PAINTER::Clone( GAL* aGal ) const
+{
+    // Drawing an item changes nothing but the item itself (e.g. its cached triangulation), so
+    // painters of different threads can draw at once as long as they draw different items
+    std::unique_ptr<PCB_PAINTER> painter = std::make_unique<PCB_PAINTER>( aGal );
+
+    painter->m_pcbSettings = m_pcbSettings;
+    painter->m_brightenedColor = m_brightenedColor;
+
+    return painter;
+}
+
+
 int PCB_PAINTER::getLineThickness( int aActualThickness ) const
 {
     // if items have 0 thickness, draw them with the outline
@@ -634,7 +656,7 @@ void PCB_PAINTER::draw( const VIA* aVia, int aLayer )
             m_gal->DrawArc( center, radius, 3.0 * M_PI / 2.0, 2.0 * M_PI );
         }
     }
-    else
+    else if( sketchMode || !drawCircleInstance( center, radius, color ) )
     {
         // Draw the outer circles of normal vias and the inner circles for all vias
         m_gal->DrawCircle( center, radius );
@@ -657,7 +679,6 @@ void PCB_PAINTER::draw( const VIA* aVia, int aLayer )
 
 void PCB_PAINTER::draw( const D_PAD* aPad, int aLayer )
 {
-    double m, n;
     double orientation = aPad->GetOrientation();
 
     // Draw description layer
@@ -769,8 +790,6 @@ void PCB_PAINTER::draw( const D_PAD* aPad, int aLayer )
         color = m_pcbSettings.GetColor( aPad, aLayer );
     }
 
-    VECTOR2D size;
-
     if( m_pcbSettings.m_sketchMode[LAYER_PADS_TH] )
     {
         // Outline mode
@@ -790,89 +809,55 @@ void PCB_PAINTER::draw( const D_PAD* aPad, int aLayer )
     // Choose drawing settings depending on if we are drawing a pad itself or a hole
     if( aLayer == LAYER_PADS_PLATEDHOLES || aLayer == LAYER_NON_PLATEDHOLES )
     {
-        m_gal->Save();
-        m_gal->Translate( VECTOR2D( aPad->GetPosition() ) );
-        m_gal->Rotate( -aPad->GetOrientationRadians() );
-
-        // Drawing hole: has same shape as PAD_CIRCLE or PAD_OVAL
-        size  = getDrillSize( aPad ) / 2.0;
-
-        if( getDrillShape( aPad ) == PAD_DRILL_SHAPE_OBLONG )
-        {
-            if( size.y >= size.x )
-            {
-                m = ( size.y - size.x );
-                n = size.x;
-
-                m_gal->DrawArc( VECTOR2D( 0, -m ), n, -M_PI, 0 );
-                m_gal->DrawArc( VECTOR2D( 0, m ),  n, M_PI, 0 );
-
-                if( m_pcbSettings.m_sketchMode[LAYER_PADS_TH] )
-                {
-                    m_gal->DrawLine( VECTOR2D( -n, -m ), VECTOR2D( -n, m ) );
-                    m_gal->DrawLine( VECTOR2D( n, -m ),  VECTOR2D( n, m ) );
-                }
-                else
-                {
-                    m_gal->DrawRectangle( VECTOR2D( -n, -m ), VECTOR2D( n, m ) );
-                }
-            }
-            else
-            {
-                m = ( size.x - size.y );
-                n = size.y;
-                m_gal->DrawArc( VECTOR2D( -m, 0 ), n, M_PI / 2, 3 * M_PI / 2 );
-                m_gal->DrawArc( VECTOR2D( m, 0 ),  n, M_PI / 2, -M_PI / 2 );
-
-                if( m_pcbSettings.m_sketchMode[LAYER_PADS_TH] )
-                {
-                    m_gal->DrawLine( VECTOR2D( -m, -n ), VECTOR2D( m, -n ) );
-                    m_gal->DrawLine( VECTOR2D( -m, n ),  VECTOR2D( m, n ) );
-                }
-                else
-                {
-                    m_gal->DrawRectangle( VECTOR2D( -m, -n ), VECTOR2D( m, n ) );
-                }
-            }
-        }
-        else
+        if( m_pcbSettings.m_sketchMode[LAYER_PADS_TH] || !drawPadHoleInstance( aPad, color ) )
         {
-            m_gal->DrawCircle( VECTOR2D( 0.0, 0.0 ), size.x );
+            m_gal->Save();
+            m_gal->Translate( VECTOR2D( aPad->GetPosition() ) );
+            m_gal->Rotate( -aPad->GetOrientationRadians() );
+            drawPadHole( aPad );
+            m_gal->Restore();
         }
-
-        m_gal->Restore();
     }
     else
     {
         SHAPE_POLY_SET polySet;
+        int            clearance = 0;
+        wxSize         margin( 0, 0 );
 
         switch( aLayer )
         {
         case F_Mask:
         case B_Mask:
-            {
-            int clearance = aPad->GetSolderMaskMargin();
-            aPad->TransformShapeWithClearanceToPolygon( polySet, clearance );
-            }
+            clearance = aPad->GetSolderMaskMargin();
             break;
 
         case F_Paste:
         case B_Paste:
-            {
-            wxSize pad_size = aPad->GetSize();
-            wxSize margin = aPad->GetSolderPasteMargin();
-            const_cast<D_PAD*>(aPad)->SetSize( pad_size + margin + margin );
-            aPad->TransformShapeWithClearanceToPolygon( polySet, 0 );
-            const_cast<D_PAD*>(aPad)->SetSize( pad_size );
-            }
+            margin = aPad->GetSolderPasteMargin();
             break;
 
         default:
-            aPad->TransformShapeWithClearanceToPolygon( polySet, 0 );
             break;
         }
 
-        m_gal->DrawPolygon( polySet );
+        // A board uses a few pad shapes many times, they are drawn by instances when possible
+        if( m_pcbSettings.m_sketchMode[LAYER_PADS_TH]
+                || !drawPadShapeInstance( aPad, clearance, margin, color ) )
+        {
+            if( margin != wxSize( 0, 0 ) )
+            {
+                wxSize pad_size = aPad->GetSize();
+                const_cast<D_PAD*>(aPad)->SetSize( pad_size + margin + margin );
+                aPad->TransformShapeWithClearanceToPolygon( polySet, 0 );
+                const_cast<D_PAD*>(aPad)->SetSize( pad_size );
+            }
+            else
+            {
+                aPad->TransformShapeWithClearanceToPolygon( polySet, clearance );
+            }
+
+            m_gal->DrawPolygon( polySet );
+        }
     }
 
     // Clearance lines
@@ -894,6 +879,172 @@ void PCB_PAINTER::draw( const D_PAD* aPad, int aLayer )
 }
 
 
+void PCB_PAINTER::drawPadHole( const D_PAD* aPad )
+{
+    double   m, n;
+    VECTOR2D size;
+
+    // Drawing hole: has same shape as PAD_CIRCLE or PAD_OVAL
+    size  = getDrillSize( aPad ) / 2.0;
+
+    if( getDrillShape( aPad ) == PAD_DRILL_SHAPE_OBLONG )
+    {
+        if( size.y >= size.x )
+        {
+            m = ( size.y - size.x );
+            n = size.x;
+
+            m_gal->DrawArc( VECTOR2D( 0, -m ), n, -M_PI, 0 );
+            m_gal->DrawArc( VECTOR2D( 0, m ),  n, M_PI, 0 );
+
+            if( m_pcbSettings.m_sketchMode[LAYER_PADS_TH] )
+            {
+                m_gal->DrawLine( VECTOR2D( -n, -m ), VECTOR2D( -n, m ) );
+                m_gal->DrawLine( VECTOR2D( n, -m ),  VECTOR2D( n, m ) );
+            }
+            else
+            {
+                m_gal->DrawRectangle( VECTOR2D( -n, -m ), VECTOR2D( n, m ) );
+            }
+        }
+        else
+        {
+            m = ( size.x - size.y );
+            n = size.y;
+            m_gal->DrawArc( VECTOR2D( -m, 0 ), n, M_PI / 2, 3 * M_PI / 2 );
+            m_gal->DrawArc( VECTOR2D( m, 0 ),  n, M_PI / 2, -M_PI / 2 );
+
+            if( m_pcbSettings.m_sketchMode[LAYER_PADS_TH] )
+            {
+                m_gal->DrawLine( VECTOR2D( -m, -n ), VECTOR2D( m, -n ) );
+                m_gal->DrawLine( VECTOR2D( -m, n ),  VECTOR2D( m, n ) );
+            }
+            else
+            {
+                m_gal->DrawRectangle( VECTOR2D( -m, -n ), VECTOR2D( m, n ) );
+            }
+        }
+    }
+    else
+    {
+        m_gal->DrawCircle( VECTOR2D( 0.0, 0.0 ), size.x );
+    }
+}
+
+
+bool PCB_PAINTER::drawPadShapeInstance( const D_PAD* aPad, int aClearance, const wxSize& aMargin,
+                                        const COLOR4D& aColor )
+{
+    if( !m_gal->IsShapeInstancingEnabled() )
+        return false;
+
+    SHAPE_INSTANCE_KEY key( PAD_SHAPE_INSTANCE );
+    wxSize             size = aPad->GetSize() + aMargin + aMargin;
+
+    key.Add( aPad->GetShape() ).Add( size.x ).Add( size.y );
+    key.Add( aPad->GetDelta().x ).Add( aPad->GetDelta().y );
+    key.Add( aPad->GetOffset().x ).Add( aPad->GetOffset().y ).Add( aClearance );
+
+    switch( aPad->GetShape() )
+    {
+    case PAD_SHAPE_ROUNDRECT:
+        key.Add( aPad->GetRoundRectRadiusRatio() );
+        break;
+
+    case PAD_SHAPE_CHAMFERED_RECT:
+        key.Add( aPad->GetRoundRectRadiusRatio() ).Add( aPad->GetChamferRectRatio() );
+        key.Add( aPad->GetChamferPositions() );
+        break;
+
+    case PAD_SHAPE_CUSTOM:
+    {
+        const SHAPE_POLY_SET& polySet = aPad->GetCustomShapeAsPolygon();
+
+        key.Add( aPad->GetAnchorPadShape() );
+
+        for( int ii = 0; ii < polySet.OutlineCount(); ++ii )
+        {
+            const SHAPE_LINE_CHAIN& outline = polySet.COutline( ii );
+
+            key.Add( outline.PointCount() );
+
+            for( int jj = 0; jj < outline.PointCount(); ++jj )
+                key.Add( outline.CPoint( jj ).x ).Add( outline.CPoint( jj ).y );
+        }
+    }
+        break;
+
+    default:
+        break;
+    }
+
+    if( !m_gal->HasShapeInstance( key ) && m_gal->BeginShapeInstance( key ) )
+    {
+        // The shape is drawn around the pad position, the instances rotate it
+        D_PAD          pad( *aPad );
+        SHAPE_POLY_SET polySet;
+
+        pad.SetPosition( wxPoint( 0, 0 ) );
+        pad.SetOrientation( 0.0 );
+        pad.SetSize( size );
+        pad.TransformShapeWithClearanceToPolygon( polySet, aClearance );
+
+        m_gal->SetFillColor( COLOR4D::WHITE );
+        m_gal->DrawPolygon( polySet );
+        m_gal->EndShapeInstance();
+        m_gal->SetFillColor( aColor );
+    }
+
+    return m_gal->DrawShapeInstance( key, VECTOR2D( aPad->GetPosition() ),
+                                     -aPad->GetOrientationRadians(), aColor );
+}
+
+
+bool PCB_PAINTER::drawPadHoleInstance( const D_PAD* aPad, const COLOR4D& aColor )
+{
+    if( !m_gal->IsShapeInstancingEnabled() )
+        return false;
+
+    SHAPE_INSTANCE_KEY key( PAD_HOLE_INSTANCE );
+    VECTOR2D           size = getDrillSize( aPad );
+
+    key.Add( getDrillShape( aPad ) ).Add( size.x ).Add( size.y );
+
+    if( !m_gal->HasShapeInstance( key ) && m_gal->BeginShapeInstance( key ) )
+    {
+        m_gal->SetFillColor( COLOR4D::WHITE );
+        drawPadHole( aPad );
+        m_gal->EndShapeInstance();
+        m_gal->SetFillColor( aColor );
+    }
+
+    return m_gal->DrawShapeInstance( key, VECTOR2D( aPad->GetPosition() ),
+                                     -aPad->GetOrientationRadians(), aColor );
+}
+
+
+bool PCB_PAINTER::drawCircleInstance( const VECTOR2D& aCenter, double aRadius,
+                                      const COLOR4D& aColor )
+{
+    if( !m_gal->IsShapeInstancingEnabled() )
+        return false;
+
+    SHAPE_INSTANCE_KEY key( CIRCLE_INSTANCE );
+
+    key.Add( aRadius );
+
+    if( !m_gal->HasShapeInstance( key ) && m_gal->BeginShapeInstance( key ) )
+    {
+        m_gal->SetFillColor( COLOR4D::WHITE );
+        m_gal->DrawCircle( VECTOR2D( 0.0, 0.0 ), aRadius );
+        m_gal->EndShapeInstance();
+        m_gal->SetFillColor( aColor );
+    }
+
+    return m_gal->DrawShapeInstance( key, aCenter, 0.0, aColor );
+}
+
+
 void PCB_PAINTER::draw( const DRAWSEGMENT* aSegment, int aLayer )
 {
     const COLOR4D& color = m_pcbSettings.GetColor( aSegment, aSegment->GetLayer() );
@@ -241,6 +241,9 @@ public:
     /// @copydoc PAINTER::Draw()
     virtual bool Draw( const VIEW_ITEM* aItem, int aLayer ) override;
 
+    /// @copydoc PAINTER::Clone()
+    virtual std::unique_ptr<PAINTER> Clone( GAL* aGal ) const override;
+
 protected:
     PCB_RENDER_SETTINGS m_pcbSettings;
 
@@ -267,6 +270,32 @@ protected:
      */
     int getLineThickness( int aActualThickness ) const;
 
+    /**
+     * Function drawPadShapeInstance()
+     * Draws the shape of a pad as an instance of a shape shared by the pads of the same
+     * geometry (see GAL::DrawShapeInstance()).
+     * @param aPad is the pad.
+     * @param aClearance is the clearance around the pad shape (the solder mask margin).
+     * @param aMargin is added on each side to the pad size (the solder paste margin).
+     * @param aColor is the color of the pad.
+     * @return false if the GAL does not draw shape instances, the pad is then to be drawn
+     * directly.
+     */
+    bool drawPadShapeInstance( const D_PAD* aPad, int aClearance, const wxSize& aMargin,
+                               const COLOR4D& aColor );
+
+    ///> Same as drawPadShapeInstance(), for the hole of a pad
+    bool drawPadHoleInstance( const D_PAD* aPad, const COLOR4D& aColor );
+
+    ///> Same as drawPadShapeInstance(), for a filled circle (the vias and their holes)
+    bool drawCircleInstance( const VECTOR2D& aCenter, double aRadius, const COLOR4D& aColor );
+
+    /**
+     * Function drawPadHole()
+     * Draws the hole of a pad at the origin, with no rotation.
+     */
+    void drawPadHole( const D_PAD* aPad );
+
     /**
      * Return drill shape of a pad.
      */
@@ -51,12 +51,19 @@
 #include <pcb_parser.h>
 #include <convert_basic_shapes_to_polygon.h>    // for RECT_CHAMFER_POSITIONS definition
 #include <template_fieldnames.h>
+#include <thread_pool.h>
 
 using namespace PCB_KEYS_T;
 
 
+PCB_PARSER::~PCB_PARSER()
+{
+}
+
+
 void PCB_PARSER::init()
 {
+    m_sections.clear();
     m_showLegacyZoneWarning = true;
     m_tooRecent = false;
     m_requiredVersion = 0;
@@ -536,6 +543,7 @@ BOARD* PCB_PARSER::parseBOARD_unchecked()
         switch( token )
         {
         case T_general:
+            parseSections();
             parseGeneralSection();
             break;
 
@@ -548,18 +556,22 @@ BOARD* PCB_PARSER::parseBOARD_unchecked()
             break;
 
         case T_layers:
+            parseSections();
             parseLayers();
             break;
 
         case T_setup:
+            parseSections();
             parseSetup();
             break;
 
         case T_net:
+            parseSections();
             parseNETINFO_ITEM();
             break;
 
         case T_net_class:
+            parseSections();
             parseNETCLASS();
             break;
 
@@ -580,23 +592,11 @@ BOARD* PCB_PARSER::parseBOARD_unchecked()
             break;
 
         case T_module:
-            m_board->Add( parseMODULE(), ADD_MODE::APPEND );
-            break;
-
         case T_segment:
-            m_board->Add( parseTRACK(), ADD_MODE::INSERT );
-            break;
-
         case T_arc:
-            m_board->Add( parseARC(), ADD_MODE::INSERT );
-            break;
-
         case T_via:
-            m_board->Add( parseVIA(), ADD_MODE::INSERT );
-            break;
-
         case T_zone:
-            m_board->Add( parseZONE_CONTAINER( m_board ), ADD_MODE::APPEND );
+            deferSection();
             break;
 
         case T_target:
@@ -610,6 +610,8 @@ BOARD* PCB_PARSER::parseBOARD_unchecked()
         }
     }
 
+    parseSections();
+
     if( m_undefinedLayers.size() > 0 )
     {
         bool deleteItems;
@@ -693,6 +695,171 @@ BOARD* PCB_PARSER::parseBOARD_unchecked()
 }
 
 
+void PCB_PARSER::deferSection()
+{
+    m_sections.emplace_back();
+
+    SECTION& section = m_sections.back();
+
+    section.m_token = (T) CurTok();
+    section.m_line  = CurLineNumber();
+
+    CaptureList( &section.m_text );
+}
+
+
+void PCB_PARSER::parseSections()
+{
+    if( m_sections.empty() )
+        return;
+
+    const wxString source = CurSource();
+
+    // Setting a parser up copies the layer maps: give each one a batch of sections rather
+    // than a single one.  Interleaving the batches spreads the big footprints and the many
+    // small tracks evenly.
+    size_t batchCount = std::min( m_sections.size(),
+                                  8 * std::max<size_t>( 1, THREAD_POOL::Get().GetThreadCount() ) );
+
+    auto newParser =
+            [&]()
+            {
+                std::unique_ptr<PCB_PARSER> parser( new PCB_PARSER() );
+
+                parser->m_board           = m_board;
+                parser->m_layerIndices    = m_layerIndices;
+                parser->m_layerMasks      = m_layerMasks;
+                parser->m_netCodes        = m_netCodes;
+                parser->m_tooRecent       = m_tooRecent;
+                parser->m_requiredVersion = m_requiredVersion;
+
+                return parser;
+            };
+
+    ParallelFor( 0, batchCount,
+            [&]( size_t aBatch )
+            {
+                std::unique_ptr<PCB_PARSER> parser = newParser();
+
+                for( size_t ii = aBatch; ii < m_sections.size(); ii += batchCount )
+                {
+                    SECTION&           section = m_sections[ii];
+                    STRING_LINE_READER reader( section.m_text, source, section.m_line - 1 );
+
+                    parser->PushReader( &reader );
+                    parser->m_section = &section;
+
+                    try
+                    {
+                        parser->NeedLEFT();
+                        parser->NextTok();
+
+                        switch( section.m_token )
+                        {
+                        case T_module:
+                            section.m_item.reset( parser->parseMODULE() );
+                            break;
+
+                        case T_segment:
+                            section.m_item.reset( parser->parseTRACK() );
+                            break;
+
+                        case T_arc:
+                            section.m_item.reset( parser->parseARC() );
+                            break;
+
+                        case T_via:
+                            section.m_item.reset( parser->parseVIA() );
+                            break;
+
+                        case T_zone:
+                            section.m_item.reset( parser->parseZONE_CONTAINER( m_board ) );
+                            break;
+
+                        default:
+                            wxFAIL_MSG( wxT( "Unexpected board section" ) );
+                        }
+
+                        parser->PopReader();
+                        section.m_undefinedLayers.swap( parser->m_undefinedLayers );
+                    }
+                    catch( ... )
+                    {
+                        section.m_error = std::current_exception();
+
+                        // Don't resume a lexer stopped in the middle of a section
+                        parser = newParser();
+                    }
+                }
+            } );
+
+    // Merge in file order, so that the board is the same as if the sections were parsed
+    // one after the other
+    bool legacyZoneFill = false;
+
+    for( SECTION& section : m_sections )
+    {
+        if( section.m_error )
+        {
+            std::exception_ptr error = section.m_error;
+
+            m_sections.clear();
+            std::rethrow_exception( error );
+        }
+
+        legacyZoneFill |= section.m_legacyZoneFill;
+    }
+
+    if( legacyZoneFill )
+    {
+        // SEGMENT fill mode no longer supported.  Make sure user is OK with converting them.
+        if( m_showLegacyZoneWarning )
+        {
+            KIDIALOG dlg( nullptr,
+                          _( "The legacy segment fill mode is no longer supported.\n"
+                             "Convert zones to polygon fills?"),
+                          _( "Legacy Zone Warning" ),
+                          wxYES_NO | wxICON_WARNING );
+
+            dlg.DoNotShowCheckbox( __FILE__, __LINE__ );
+
+            if( dlg.ShowModal() == wxID_NO )
+            {
+                m_sections.clear();
+                THROW_IO_ERROR( wxT( "CANCEL" ) );
+            }
+
+            m_showLegacyZoneWarning = false;
+        }
+
+        m_board->SetModified();
+    }
+
+    for( SECTION& section : m_sections )
+    {
+        m_undefinedLayers.insert( section.m_undefinedLayers.begin(),
+                                  section.m_undefinedLayers.end() );
+
+        for( const std::pair<ZONE_CONTAINER*, wxString>& zoneNet : section.m_zoneNets )
+            fixZoneNet( zoneNet.first, zoneNet.second );
+
+        switch( section.m_token )
+        {
+        case T_segment:
+        case T_arc:
+        case T_via:
+            m_board->Add( section.m_item.release(), ADD_MODE::INSERT );
+            break;
+
+        default:
+            m_board->Add( section.m_item.release(), ADD_MODE::APPEND );
+        }
+    }
+
+    m_sections.clear();
+}
+
+
 void PCB_PARSER::parseHeader()
 {
     wxCHECK_RET( CurTok() == T_kicad_pcb,
@@ -3767,7 +3934,13 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER( BOARD_ITEM_CONTAINER* aParent )
                     if( token != T_segment && token != T_hatch && token != T_polygon )
                         Expecting( "segment, hatch or polygon" );
 
-                    if( token == T_segment )    // deprecated
+                    if( token == T_segment && m_section )    // deprecated
+                    {
+                        // No dialog from a worker thread: parseSections() asks
+                        m_section->m_legacyZoneFill = true;
+                        zone->SetFillMode( ZONE_FILL_MODE::POLYGONS );
+                    }
+                    else if( token == T_segment )    // deprecated
                     {
                         // SEGMENT fill mode no longer supported.  Make sure user is OK with converting them.
                         if( m_showLegacyZoneWarning )
@@ -4007,34 +4180,48 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER( BOARD_ITEM_CONTAINER* aParent )
         zone->CalculateFilledArea();
     }
 
+    if( m_section )
+        m_section->m_zoneNets.emplace_back( zone.get(), netnameFromfile );
+    else
+        fixZoneNet( zone.get(), netnameFromfile );
+
+    // Clear flags used in zone edition:
+    zone->SetNeedRefill( false );
+
+    return zone.release();
+}
+
+
+void PCB_PARSER::fixZoneNet( ZONE_CONTAINER* aZone, const wxString& aNetname )
+{
     // Ensure keepout and non copper zones do not have a net
     // (which have no sense for these zones)
     // the netcode 0 is used for these zones
-    bool zone_has_net = zone->IsOnCopperLayer() && !zone->GetIsKeepout();
+    bool zone_has_net = aZone->IsOnCopperLayer() && !aZone->GetIsKeepout();
 
     if( !zone_has_net )
-        zone->SetNetCode( NETINFO_LIST::UNCONNECTED );
+        aZone->SetNetCode( NETINFO_LIST::UNCONNECTED );
 
     // Ensure the zone net name is valid, and matches the net code, for copper zones
-    if( zone_has_net && ( zone->GetNet()->GetNetname() != netnameFromfile ) )
+    if( zone_has_net && ( aZone->GetNet()->GetNetname() != aNetname ) )
     {
         // Can happens which old boards, with nonexistent nets ...
         // or after being edited by hand
         // We try to fix the mismatch.
-        NETINFO_ITEM* net = m_board->FindNet( netnameFromfile );
+        NETINFO_ITEM* net = m_board->FindNet( aNetname );
 
         if( net )   // An existing net has the same net name. use it for the zone
-            zone->SetNetCode( net->GetNet() );
+            aZone->SetNetCode( net->GetNet() );
         else    // Not existing net: add a new net to keep trace of the zone netname
         {
             int newnetcode = m_board->GetNetCount();
-            net = new NETINFO_ITEM( m_board, netnameFromfile, newnetcode );
+            net = new NETINFO_ITEM( m_board, aNetname, newnetcode );
             m_board->Add( net );
 
             // Store the new code mapping
             pushValueIntoMap( newnetcode, net->GetNet() );
             // and update the zone netcode
-            zone->SetNetCode( net->GetNet() );
+            aZone->SetNetCode( net->GetNet() );
 
             // FIXME: a call to any GUI item is not allowed in io plugins:
             // Change this code to generate a warning message outside this plugin
@@ -4043,15 +4230,10 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER( BOARD_ITEM_CONTAINER* aParent )
             msg.Printf( _( "There is a zone that belongs to a not existing net\n"
                            "\"%s\"\n"
                            "you should verify and edit it (run DRC test)." ),
-                           GetChars( netnameFromfile ) );
+                           GetChars( aNetname ) );
             DisplayError( NULL, msg );
         }
     }
-
-    // Clear flags used in zone edition:
-    zone->SetNeedRefill( false );
-
-    return zone.release();
 }
 
 
@@ -36,6 +36,9 @@
 #include <math/util.h>                           // KiROUND, Clamp
 #include <pcb_lexer.h>
 
+#include <exception>
+#include <memory>
+#include <set>
 #include <unordered_map>
 
 
@@ -81,6 +84,25 @@ class PCB_PARSER : public PCB_LEXER
 
     bool                m_showLegacyZoneWarning;
 
+    ///> A top level section of a board, set aside to be parsed in parallel with others
+    struct SECTION
+    {
+        PCB_KEYS_T::T               m_token;        ///< the keyword of the section
+        std::string                 m_text;         ///< its text, parentheses included
+        int                         m_line;         ///< the line it starts at
+        std::unique_ptr<BOARD_ITEM> m_item;         ///< what it was parsed to
+        std::exception_ptr          m_error;        ///< or why it could not be
+        std::set<wxString>          m_undefinedLayers;
+
+        ///> zones and their net names, for fixZoneNet()
+        std::vector<std::pair<ZONE_CONTAINER*, wxString>> m_zoneNets;
+
+        bool                        m_legacyZoneFill = false;   ///< found a segment fill mode
+    };
+
+    std::vector<SECTION> m_sections;    ///< sections waiting for parseSections()
+    SECTION*             m_section;     ///< the section parsed, when parsing one on a worker
+
     ///> Converts net code using the mapping table if available,
     ///> otherwise returns unchanged net code if < 0 or if is is out of range
     inline int getNetCode( int aNetCode )
@@ -171,6 +193,28 @@ class PCB_PARSER : public PCB_LEXER
      */
     BOARD*          parseBOARD_unchecked();
 
+    /**
+     * Function deferSection
+     * sets aside the section whose keyword was just read, for parseSections().  Footprints,
+     * tracks and zones only depend on the setup, layers and nets before them in the file,
+     * so they can be parsed in parallel.
+     */
+    void            deferSection();
+
+    /**
+     * Function parseSections
+     * parses the sections set aside by deferSection() on the thread pool, each worker with
+     * its own lexer, and adds the items to the board in file order.
+     */
+    void            parseSections();
+
+    /**
+     * Function fixZoneNet
+     * ensures that the net of a copper zone matches the net name found in the file, adding
+     * the net to the board if needed.  This changes the board, so zones parsed on a worker
+     * leave it to parseSections().
+     */
+    void            fixZoneNet( ZONE_CONTAINER* aZone, const wxString& aNetname );
 
     /**
      * Function lookUpLayer
@@ -319,12 +363,13 @@ public:
 
     PCB_PARSER( LINE_READER* aReader = NULL ) :
         PCB_LEXER( aReader ),
-        m_board( 0 )
+        m_board( 0 ),
+        m_section( nullptr )
     {
         init();
     }
 
-    // ~PCB_PARSER() {}
+    ~PCB_PARSER();
 
     /**
      * Function SetLineReader
@@ -81,6 +81,17 @@ const MODULE* PLUGIN::GetEnumeratedFootprint( const wxString& aLibraryPath,
 }
 
 
+bool PLUGIN::GetEnumeratedFootprintInfo( const wxString& aLibraryPath,
+                                         const wxString& aFootprintName,
+                                         wxString* aDescription, wxString* aKeywords,
+                                         unsigned* aPadCount, unsigned* aUniquePadCount,
+                                         const PROPERTIES* aProperties )
+{
+    // default implementation: no index
+    return false;
+}
+
+
 bool PLUGIN::FootprintExists( const wxString& aLibraryPath, const wxString& aFootprintName,
                               const PROPERTIES* aProperties )
 {
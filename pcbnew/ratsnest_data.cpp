@@ -33,12 +33,14 @@
 #endif
 
 #include <ratsnest_data.h>
+#include <ttl/ttl.h>
 #include <functional>
 using namespace std::placeholders;
 
 #include <cassert>
 #include <algorithm>
 #include <limits>
+#include <memory>
 
 static uint64_t getDistance( const CN_ANCHOR_PTR& aNode1, const CN_ANCHOR_PTR& aNode2 )
 {
@@ -150,19 +152,114 @@ static const std::vector<CN_EDGE> kruskalMST( std::list<CN_EDGE>& aEdges,
 }
 
 
+///> Ids of the corners of the rectangle enclosing a kept triangulation, and of the nodes kept
+///> in it although their position has no anchor anymore
+static const int CORNER_NODE_ID = -2;
+static const int STALE_NODE_ID = -1;
+
+
+/**
+ * A Delaunay triangulation kept from an update of a net to the next one, so that the nodes
+ * added in between can be inserted into it.  Unlike hed::TRIANGULATION::CreateDelaunay(),
+ * the rectangle enclosing the nodes is not removed afterwards: the edges to its corners are
+ * skipped instead.
+ */
+class RN_DELAUNAY : public hed::TRIANGULATION
+{
+public:
+    RN_DELAUNAY( std::vector<hed::NODE_PTR>& aNodes )
+    {
+        hed::EDGE_PTR boundary = InitTwoEnclosingTriangles( aNodes.begin(), aNodes.end() );
+
+        for( const hed::EDGE_PTR& leadingEdge : m_leadingEdges )
+        {
+            hed::EDGE_PTR edge = leadingEdge;
+
+            for( int i = 0; i < 3; i++ )
+            {
+                edge->GetSourceNode()->SetId( CORNER_NODE_ID );
+                edge = edge->GetNextEdgeInFace();
+            }
+        }
+
+        m_dart = hed::DART( boundary );
+
+        for( const hed::NODE_PTR& node : aNodes )
+            Insert( node );
+    }
+
+    bool Insert( hed::NODE_PTR aNode )
+    {
+        return m_helper->InsertNode<hed::TTLtraits>( m_dart, aNode );
+    }
+
+private:
+    ///> Where to start looking for the triangle of the next inserted node
+    hed::DART m_dart;
+};
+
+
+/**
+ * An edge between two nodes of a triangulation, by the indices of their first anchors
+ */
+struct RN_TRI_EDGE
+{
+    int          m_src;
+    int          m_dst;
+    unsigned int m_weight;
+};
+
+
 class RN_NET::TRIANGULATOR_STATE
 {
 private:
+    /**
+     * The triangulation of the nodes of one or two horizontal strips of the net, and the
+     * edges found in it by the last update
+     */
+    struct PART
+    {
+        int                          m_strips[2];
+        size_t                       m_nodeCount;
+        std::unique_ptr<RN_DELAUNAY> m_triangulation;
+        std::vector<RN_TRI_EDGE>     m_edges;
+        bool                         m_failed;
+    };
+
     std::vector<CN_ANCHOR_PTR>  m_allNodes;
 
-    std::list<hed::EDGE_PTR> hedTriangulation( std::vector<hed::NODE_PTR>& aNodes )
+    ///> Triangulation nodes of the anchor positions, by order of position
+    std::vector<hed::NODE_PTR>  m_triNodes;
+
+    ///> Triangulation nodes of the positions not in the previous triangulation
+    std::vector<hed::NODE_PTR>  m_newNodes;
+
+    ///> Number of nodes of the previous triangulation without an anchor anymore
+    size_t                      m_staleCount;
+
+    ///> True if the new nodes are inserted in the triangulation of the previous update
+    bool                        m_incremental;
+
+    ///> Smallest y of each strip but the first one
+    std::vector<int>            m_stripStarts;
+
+    ///> Triangulations of the previous update, none if its nodes were colinear
+    std::vector<PART>           m_parts;
+
+    ///> Nodes of the triangulations, by position
+    std::unordered_map<uint64_t, hed::NODE_PTR> m_triangulationNodes;
+
+    static uint64_t positionKey( const VECTOR2I& aPos )
     {
-        hed::TRIANGULATION triangulator;
-        triangulator.CreateDelaunay( aNodes.begin(), aNodes.end() );
-        std::list<hed::EDGE_PTR> edges;
-        triangulator.GetEdges( edges );
+        return ( (uint64_t) (uint32_t) aPos.x << 32 ) | (uint32_t) aPos.y;
+    }
 
-        return edges;
+    // Number of inserted and stale nodes above which the nodes are triangulated again from
+    // scratch: stale nodes make the graph denser, and inserting most of the nodes one by one
+    // is not faster than a new triangulation anyway.
+    static size_t maxIncrementalChanges( size_t aNodeCount )
+    {
+        return std::max<size_t>( 16, aNodeCount / 8 );
     }
 
 
@@ -189,6 +286,208 @@ private:
         return true;
     }
 
+
+    int stripOf( const hed::NODE_PTR& aNode ) const
+    {
+        return std::upper_bound( m_stripStarts.begin(), m_stripStarts.end(), aNode->GetY() )
+               - m_stripStarts.begin();
+    }
+
+
+    bool isInPart( const PART& aPart, const hed::NODE_PTR& aNode ) const
+    {
+        int strip = stripOf( aNode );
+
+        return strip == aPart.m_strips[0] || strip == aPart.m_strips[1];
+    }
+
+
+    std::vector<hed::NODE_PTR> partNodes( const PART& aPart ) const
+    {
+        std::vector<hed::NODE_PTR> nodes;
+
+        for( const auto& tn : m_triNodes )
+        {
+            if( isInPart( aPart, tn ) )
+                nodes.push_back( tn );
+        }
+
+        return nodes;
+    }
+
+
+    /**
+     * Prepares the parts of a triangulation from scratch.  The minimum spanning tree of the
+     * nodes is in the union of the minimum spanning trees of the nodes of every pair of strips:
+     * an edge missing from the tree of the pair of strips of its ends is the longest of a
+     * cycle of shorter edges.  Splitting in 4 strips gives 6 parts of half the nodes each.
+     */
+    void setupParts( int aStrips )
+    {
+        m_parts.clear();
+        m_stripStarts.clear();
+        m_triangulationNodes.clear();
+
+        // The nodes are sorted by y
+        for( int i = 1; i < aStrips; i++ )
+        {
+            int start = m_triNodes[ m_triNodes.size() * i / aStrips ]->GetY();
+
+            if( m_stripStarts.empty() || start > m_stripStarts.back() )
+                m_stripStarts.push_back( start );
+        }
+
+        int strips = m_stripStarts.size() + 1;
+
+        if( strips == 1 )
+        {
+            m_parts.push_back( PART() );
+            m_parts.back().m_strips[0] = 0;
+            m_parts.back().m_strips[1] = 0;
+        }
+
+        for( int i = 0; i < strips; i++ )
+        {
+            for( int j = i + 1; j < strips; j++ )
+            {
+                m_parts.push_back( PART() );
+                m_parts.back().m_strips[0] = i;
+                m_parts.back().m_strips[1] = j;
+            }
+        }
+
+        for( PART& part : m_parts )
+        {
+            std::vector<hed::NODE_PTR> nodes = partNodes( part );
+
+            // Strips are only worth it if they can be triangulated
+            if( areNodesColinear( nodes ) )
+            {
+                if( strips > 1 )
+                    setupParts( 1 );
+                else
+                    m_parts.clear();
+
+                return;
+            }
+
+            part.m_nodeCount = nodes.size();
+            part.m_failed = false;
+        }
+    }
+
+
+    void addTriangulationEdges( const RN_DELAUNAY& aTriangulation,
+                                std::vector<RN_TRI_EDGE>& aEdges ) const
+    {
+        std::list<hed::EDGE_PTR> triangEdges;
+        std::unordered_map<hed::NODE*, std::vector<hed::NODE*>> staleEdges;
+
+        aTriangulation.GetEdges( triangEdges );
+
+        auto addEdge = [&]( int aSrc, int aDst )
+        {
+            aEdges.push_back( { aSrc, aDst,
+                                (unsigned int) getDistance( m_allNodes[aSrc], m_allNodes[aDst] ) } );
+        };
+
+        for( const auto& e : triangEdges )
+        {
+            const hed::NODE_PTR& srcNode = e->GetSourceNode();
+            const hed::NODE_PTR& dstNode = e->GetTargetNode();
+
+            if( srcNode->Id() == CORNER_NODE_ID || dstNode->Id() == CORNER_NODE_ID )
+                continue;
+
+            if( srcNode->Id() == STALE_NODE_ID || dstNode->Id() == STALE_NODE_ID )
+            {
+                staleEdges[srcNode.get()].push_back( dstNode.get() );
+                staleEdges[dstNode.get()].push_back( srcNode.get() );
+                continue;
+            }
+
+            addEdge( srcNode->Id(), dstNode->Id() );
+        }
+
+        // Removing a node from a Delaunay triangulation only adds edges between the nodes
+        // around it.  Linking together all the nodes around each group of adjacent stale nodes
+        // gives a superset of the triangulation without the stale nodes, so the spanning tree
+        // is the same.
+        std::unordered_set<hed::NODE*> visited;
+
+        for( const auto& entry : staleEdges )
+        {
+            if( entry.first->Id() != STALE_NODE_ID || !visited.insert( entry.first ).second )
+                continue;
+
+            std::vector<hed::NODE*> stack = { entry.first };
+            std::vector<int>        around;
+
+            while( !stack.empty() )
+            {
+                hed::NODE* node = stack.back();
+                stack.pop_back();
+
+                for( hed::NODE* next : staleEdges.at( node ) )
+                {
+                    if( next->Id() != STALE_NODE_ID )
+                        around.push_back( next->Id() );
+                    else if( visited.insert( next ).second )
+                        stack.push_back( next );
+                }
+            }
+
+            std::sort( around.begin(), around.end() );
+            around.erase( std::unique( around.begin(), around.end() ), around.end() );
+
+            for( size_t i = 0; i < around.size(); i++ )
+            {
+                for( size_t j = i + 1; j < around.size(); j++ )
+                    addEdge( around[i], around[j] );
+            }
+        }
+    }
+
+
+    ///> Keeps only the edges of a minimum spanning tree of the nodes
+    void spanningTree( std::vector<RN_TRI_EDGE>& aEdges ) const
+    {
+        std::vector<int> parents( m_allNodes.size() );
+
+        for( size_t i = 0; i < parents.size(); i++ )
+            parents[i] = i;
+
+        auto find = [&]( int aNode )
+        {
+            while( parents[aNode] != aNode )
+                aNode = parents[aNode] = parents[parents[aNode]];
+
+            return aNode;
+        };
+
+        std::sort( aEdges.begin(), aEdges.end(),
+                []( const RN_TRI_EDGE& aEdge1, const RN_TRI_EDGE& aEdge2 )
+                {
+                    return aEdge1.m_weight < aEdge2.m_weight;
+                } );
+
+        size_t count = 0;
+
+        for( const RN_TRI_EDGE& edge : aEdges )
+        {
+            int src = find( edge.m_src );
+            int dst = find( edge.m_dst );
+
+            if( src != dst )
+            {
+                parents[src] = dst;
+                aEdges[count++] = edge;
+            }
+        }
+
+        aEdges.resize( count );
+    }
+
 public:
 
     void Clear()
@@ -201,17 +500,18 @@ public:
         m_allNodes.push_back( aNode );
     }
 
-    const std::list<CN_EDGE> Triangulate()
+    /**
+     * Function Prepare()
+     * finds the nodes to insert in the triangulation of the previous update, or splits the
+     * nodes in parts to be triangulated again if there are too many changes.
+     * @param aStrips is the number of strips to split the nodes in if they are triangulated
+     * again.
+     * @return the number of parts to compute with ComputePart().
+     */
+    int Prepare( int aStrips )
     {
-        std::list<CN_EDGE> mstEdges;
-        std::list<hed::EDGE_PTR> triangEdges;
-        std::vector<hed::NODE_PTR> triNodes;
-
-        using ANCHOR_LIST = std::vector<CN_ANCHOR_PTR>;
-        std::vector<ANCHOR_LIST> anchorChains;
-
-        triNodes.reserve( m_allNodes.size() );
-        anchorChains.resize( m_allNodes.size() );
+        m_triNodes.clear();
+        m_newNodes.clear();
 
         std::sort( m_allNodes.begin(), m_allNodes.end(),
                 [] ( const CN_ANCHOR_PTR& aNode1, const CN_ANCHOR_PTR& aNode2 )
@@ -227,77 +527,161 @@ public:
         }
                 );
 
-        CN_ANCHOR_PTR prev, last;
+        // Nodes of the previous triangulation are stale until an anchor is found at their
+        // position
+        for( const auto& entry : m_triangulationNodes )
+            entry.second->SetId( STALE_NODE_ID );
+
+        CN_ANCHOR_PTR prev = nullptr;
         int id = 0;
 
         for( const auto& n : m_allNodes )
         {
             if( !prev || prev->Pos() != n->Pos() )
             {
-                auto tn = std::make_shared<hed::NODE> ( n->Pos().x, n->Pos().y );
+                auto          it = m_triangulationNodes.find( positionKey( n->Pos() ) );
+                hed::NODE_PTR tn;
+
+                if( it != m_triangulationNodes.end() )
+                {
+                    tn = it->second;
+                }
+                else
+                {
+                    tn = std::make_shared<hed::NODE> ( n->Pos().x, n->Pos().y );
+                    m_newNodes.push_back( tn );
+                }
 
                 tn->SetId( id );
-                triNodes.push_back( tn );
+                m_triNodes.push_back( tn );
             }
 
             id++;
             prev = n;
         }
 
-        int prevId = 0;
+        m_staleCount = m_triangulationNodes.size() + m_newNodes.size() - m_triNodes.size();
+        m_incremental = !m_parts.empty()
+                        && m_newNodes.size() + m_staleCount
+                                   <= maxIncrementalChanges( m_triNodes.size() );
+
+        if( !m_incremental )
+            setupParts( aStrips );
+
+        return m_parts.size();
+    }
+
+    ///> Returns the number of nodes of a part, as an estimate of its cost
+    size_t GetPartSize( int aPart ) const
+    {
+        return m_parts[aPart].m_nodeCount;
+    }
+
+    /**
+     * Function ComputePart()
+     * updates the triangulation of a part, and finds its edges.  Parts can be computed in
+     * parallel.
+     */
+    void ComputePart( int aPart )
+    {
+        PART& part = m_parts[aPart];
+
+        part.m_edges.clear();
 
-        for( const auto& n : triNodes )
+        if( m_incremental )
         {
-            for( int i = prevId; i < n->Id(); i++ )
-                anchorChains[prevId].push_back( m_allNodes[ i ] );
+            for( const auto& tn : m_newNodes )
+            {
+                if( isInPart( part, tn ) && !part.m_triangulation->Insert( tn ) )
+                {
+                    part.m_failed = true;
+                    return;
+                }
+            }
+        }
+        else
+        {
+            std::vector<hed::NODE_PTR> nodes = partNodes( part );
 
-            prevId = n->Id();
+            part.m_triangulation.reset( new RN_DELAUNAY( nodes ) );
         }
 
-        for( int i = prevId; i < id; i++ )
-            anchorChains[prevId].push_back( m_allNodes[ i ] );
+        addTriangulationEdges( *part.m_triangulation, part.m_edges );
+
+        if( m_parts.size() > 1 )
+            spanningTree( part.m_edges );
+    }
+
+    /**
+     * Function Finish()
+     * returns the edges between the nodes the spanning tree is looked for in, once all the
+     * parts are computed.
+     */
+    const std::list<CN_EDGE> Finish()
+    {
+        std::list<CN_EDGE> mstEdges;
+
+        bool failed = std::any_of( m_parts.begin(), m_parts.end(),
+                                   []( const PART& aPart )
+                                   {
+                                       return aPart.m_failed;
+                                   } );
+
+        if( failed )
+        {
+            // A node could not be inserted: triangulate again, in the same number of parts
+            m_incremental = false;
+            setupParts( m_stripStarts.size() + 1 );
+
+            for( size_t i = 0; i < m_parts.size(); i++ )
+                ComputePart( i );
+        }
 
-        if( triNodes.size() == 1 )
+        if( m_incremental )
+        {
+            for( const auto& tn : m_newNodes )
+                m_triangulationNodes[ positionKey( tn->GetPos() ) ] = tn;
+        }
+        else if( !m_parts.empty() )
         {
-            return mstEdges;
+            for( const auto& tn : m_triNodes )
+                m_triangulationNodes[ positionKey( tn->GetPos() ) ] = tn;
         }
-        else if( areNodesColinear( triNodes ) )
+
+        if( m_parts.empty() )
         {
             // special case: all nodes are on the same line - there's no
             // triangulation for such set. In this case, we sort along any coordinate
             // and chain the nodes together.
-            for(int i = 0; i < (int)triNodes.size() - 1; i++ )
+            for(int i = 0; i < (int)m_triNodes.size() - 1; i++ )
             {
-                auto src = m_allNodes[ triNodes[i]->Id() ];
-                auto dst = m_allNodes[ triNodes[i + 1]->Id() ];
+                auto src = m_allNodes[ m_triNodes[i]->Id() ];
+                auto dst = m_allNodes[ m_triNodes[i + 1]->Id() ];
                 mstEdges.emplace_back( src, dst, getDistance( src, dst ) );
             }
         }
-        else
-        {
-            hed::TRIANGULATION triangulator;
-            triangulator.CreateDelaunay( triNodes.begin(), triNodes.end() );
-            triangulator.GetEdges( triangEdges );
 
-            for( const auto& e : triangEdges )
-            {
-                auto    src = m_allNodes[ e->GetSourceNode()->Id() ];
-                auto    dst = m_allNodes[ e->GetTargetNode()->Id() ];
-
-                mstEdges.emplace_back( src, dst, getDistance( src, dst ) );
-            }
+        for( const PART& part : m_parts )
+        {
+            for( const RN_TRI_EDGE& e : part.m_edges )
+                mstEdges.emplace_back( m_allNodes[e.m_src], m_allNodes[e.m_dst], e.m_weight );
         }
 
-        for( unsigned int i = 0; i < anchorChains.size(); i++ )
+        // Anchors at the same position are chained together
+        for( size_t i = 0; i < m_triNodes.size(); i++ )
         {
-            auto& chain = anchorChains[i];
+            int first = m_triNodes[i]->Id();
+            int last = i + 1 < m_triNodes.size() ? m_triNodes[i + 1]->Id() : m_allNodes.size();
 
-            if( chain.size() < 2 )
+            if( last - first < 2 )
                 continue;
 
+            std::vector<CN_ANCHOR_PTR> chain( m_allNodes.begin() + first,
+                                              m_allNodes.begin() + last );
+
             std::sort( chain.begin(), chain.end(),
                     [] ( const CN_ANCHOR_PTR& a, const CN_ANCHOR_PTR& b ) {
-                return a->GetCluster().get() < b->GetCluster().get();
+                return a->GetCluster() < b->GetCluster();
             } );
 
             for( unsigned int j = 1; j < chain.size(); j++ )
@@ -314,16 +698,52 @@ public:
 };
 
 
-RN_NET::RN_NET() : m_dirty( true )
+RN_NET::RN_NET() : m_dirty( true ), m_clusterCount( 0 )
 {
     m_triangulator.reset( new TRIANGULATOR_STATE );
 }
 
 
-void RN_NET::compute()
+int RN_NET::BeginUpdate( int aStrips )
 {
     // Special cases do not need complicated algorithms (actually, it does not work well with
     // the Delaunay triangulator)
+    if( m_nodes.size() <= 2 )
+        return 0;
+
+    m_triangulator->Clear();
+
+    for( const auto& n : m_nodes )
+    {
+        m_triangulator->AddNode( n );
+    }
+
+    return m_triangulator->Prepare( aStrips );
+}
+
+
+size_t RN_NET::GetPartSize( int aPart ) const
+{
+    return m_triangulator->GetPartSize( aPart );
+}
+
+
+void RN_NET::UpdatePart( int aPart )
+{
+    #ifdef PROFILE
+    PROF_COUNTER cnt("triangulate");
+    #endif
+    m_triangulator->ComputePart( aPart );
+    #ifdef PROFILE
+    cnt.Show();
+    #endif
+}
+
+
+void RN_NET::EndUpdate()
+{
+    m_dirty = false;
+
     if( m_nodes.size() <= 2 )
     {
         m_rnEdges.clear();
@@ -350,21 +770,7 @@ void RN_NET::compute()
         return;
     }
 
-
-    m_triangulator->Clear();
-
-    for( const auto& n : m_nodes )
-    {
-        m_triangulator->AddNode( n );
-    }
-
-    #ifdef PROFILE
-    PROF_COUNTER cnt("triangulate");
-    #endif
-    auto triangEdges = m_triangulator->Triangulate();
-    #ifdef PROFILE
-    cnt.Show();
-    #endif
+    auto triangEdges = m_triangulator->Finish();
 
     for( const auto& e : m_boardEdges )
         triangEdges.push_back( e );
@@ -380,12 +786,14 @@ void RN_NET::compute()
 }
 
 
-
 void RN_NET::Update()
 {
-    compute();
+    int parts = BeginUpdate( 1 );
 
-    m_dirty = false;
+    for( int i = 0; i < parts; i++ )
+        UpdatePart( i );
+
+    EndUpdate();
 }
 
 
@@ -394,6 +802,8 @@ void RN_NET::Clear()
     m_rnEdges.clear();
     m_boardEdges.clear();
     m_nodes.clear();
+    m_nodesByX.clear();
+    m_clusterCount = 0;
 
     m_dirty = true;
 }
@@ -401,7 +811,10 @@ void RN_NET::Clear()
 
 void RN_NET::AddCluster( CN_CLUSTER_PTR aCluster )
 {
-    CN_ANCHOR_PTR firstAnchor;
+    CN_ANCHOR_PTR firstAnchor = nullptr;
+    int           cluster = m_clusterCount++;
+
+    m_nodesByX.clear();
 
     for( auto item : *aCluster )
     {
@@ -414,7 +827,7 @@ void RN_NET::AddCluster( CN_CLUSTER_PTR aCluster )
 
         for( unsigned int i = 0; i < nAnchors; i++ )
         {
-            anchors[i]->SetCluster( aCluster );
+            anchors[i]->SetCluster( cluster );
             m_nodes.push_back(anchors[i]);
 
             if( firstAnchor )
@@ -440,13 +853,33 @@ bool RN_NET::NearestBicoloredPair( const RN_NET& aOtherNet, CN_ANCHOR_PTR& aNode
 
     VECTOR2I::extended_type distMax = VECTOR2I::ECOORD_MAX;
 
-    for( const auto& nodeA : m_nodes )
+    // Called for every mouse move while dragging items, with the same nodes of this net
+    if( m_nodesByX.empty() )
+    {
+        m_nodesByX = m_nodes;
+
+        std::sort( m_nodesByX.begin(), m_nodesByX.end(),
+                []( const CN_ANCHOR_PTR& aNode1, const CN_ANCHOR_PTR& aNode2 )
+                {
+                    return aNode1->Pos().x < aNode2->Pos().x;
+                } );
+    }
+
+    for( const auto& nodeB : aOtherNet.m_nodes )
     {
-        for( const auto& nodeB : aOtherNet.m_nodes )
+        const VECTOR2I& posB = nodeB->Pos();
+
+        // Returns false once the nodes are further away along x than the nearest pair found
+        auto check = [&]( const CN_ANCHOR_PTR& nodeA )
         {
+            VECTOR2I::extended_type dx = (VECTOR2I::extended_type) nodeA->Pos().x - posB.x;
+
+            if( dx * dx >= distMax )
+                return false;
+
             if( !nodeA->GetNoLine() )
             {
-                auto squaredDist = (nodeA->Pos() - nodeB->Pos() ).SquaredEuclideanNorm();
+                auto squaredDist = (nodeA->Pos() - posB ).SquaredEuclideanNorm();
 
                 if( squaredDist < distMax )
                 {
@@ -456,7 +889,21 @@ bool RN_NET::NearestBicoloredPair( const RN_NET& aOtherNet, CN_ANCHOR_PTR& aNode
                     aNode2  = nodeB;
                 }
             }
-        }
+
+            return true;
+        };
+
+        auto start = std::lower_bound( m_nodesByX.begin(), m_nodesByX.end(), posB.x,
+                []( const CN_ANCHOR_PTR& aNode, int aX )
+                {
+                    return aNode->Pos().x < aX;
+                } );
+
+        for( auto it = start; it != m_nodesByX.end() && check( *it ); ++it )
+            ;
+
+        for( auto it = start; it != m_nodesByX.begin() && check( *( it - 1 ) ); --it )
+            ;
     }
 
     return rv;
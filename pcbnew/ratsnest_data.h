@@ -105,6 +105,24 @@ public:
      * Recomputes ratsnest for a net.
      */
     void Update();
+
+    /**
+     * Function BeginUpdate()
+     * Starts recomputing the ratsnest in steps, so that the parts of a large net can be
+     * computed in parallel: each part is computed by UpdatePart(), in any order and by any
+     * thread, then EndUpdate() joins them.
+     * @param aStrips is the number of strips the nodes are split in, if they have to be
+     * triangulated again.  N strips give N * (N - 1) / 2 parts of 2 / N of the nodes each.
+     * @return the number of parts.
+     */
+    int BeginUpdate( int aStrips );
+
+    ///> Returns the number of nodes of a part, as an estimate of its cost
+    size_t GetPartSize( int aPart ) const;
+
+    void UpdatePart( int aPart );
+    void EndUpdate();
+
     void Clear();
 
     void AddCluster( std::shared_ptr<CN_CLUSTER> aCluster );
@@ -142,15 +160,21 @@ public:
      */
     const CN_ANCHOR_PTR GetClosestNode( const CN_ANCHOR_PTR& aNode ) const;
 
+    /**
+     * Function NearestBicoloredPair()
+     * finds the nearest pair of nodes of this net and of another one, skipping the nodes of
+     * this net with no ratsnest line.
+     * @return true if a pair was found.
+     */
     bool NearestBicoloredPair( const RN_NET& aOtherNet, CN_ANCHOR_PTR& aNode1, CN_ANCHOR_PTR& aNode2 ) const;
 
 protected:
-    ///> Recomputes ratsnest from scratch.
-    void compute();
-
     ///> Vector of nodes
     std::vector<CN_ANCHOR_PTR> m_nodes;
 
+    ///> Nodes sorted by their x coordinate, built on demand by NearestBicoloredPair()
+    mutable std::vector<CN_ANCHOR_PTR> m_nodesByX;
+
     ///> Vector of edges that make pre-defined connections
     std::vector<CN_EDGE> m_boardEdges;
 
@@ -160,6 +184,9 @@ protected:
     ///> Flag indicating necessity of recalculation of ratsnest for a net.
     bool m_dirty;
 
+    ///> Number of clusters added, used to number them in their anchors
+    int m_clusterCount;
+
     class TRIANGULATOR_STATE;
 
     std::shared_ptr<TRIANGULATOR_STATE> m_triangulator;
@@ -0,0 +1,381 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <class_board.h>
+#include <connectivity/connectivity_algo.h>
+#include <connectivity/connectivity_data.h>
+#include <profile.h>
+#include <thread_pool.h>
+
+#include "pns_batch_router.h"
+#include "pns_debug_decorator.h"
+#include "pns_line_placer.h"
+#include "pns_node.h"
+#include "pns_router.h"
+#include "pns_routing_settings.h"
+
+namespace PNS {
+
+BATCH_ROUTER::BATCH_ROUTER( ROUTER* aRouter ) :
+    m_router( aRouter ),
+    m_parallel( true ),
+    m_areaMargin( 1000000 ),
+    m_stats()
+{
+}
+
+
+BATCH_ROUTER::~BATCH_ROUTER()
+{
+}
+
+
+int BATCH_ROUTER::AddUnroutedConnections( BOARD* aBoard )
+{
+    std::vector<CN_EDGE> edges;
+    NODE*                world = m_router->GetWorld();
+    int                  count = 0;
+
+    aBoard->GetConnectivity()->GetUnconnectedEdges( edges );
+
+    for( const CN_EDGE& edge : edges )
+    {
+        BOARD_CONNECTED_ITEM* startParent = edge.GetSourceNode()->Parent();
+        BOARD_CONNECTED_ITEM* endParent = edge.GetTargetNode()->Parent();
+        ITEM*                 startItem = world->FindItemByParent( startParent );
+        ITEM*                 endItem = world->FindItemByParent( endParent );
+
+        if( !startItem || !endItem )
+            continue;
+
+        const LAYER_RANGE& startLayers = startItem->Layers();
+        const LAYER_RANGE& endLayers = endItem->Layers();
+        CONNECTION         conn;
+
+        conn.m_net = startItem->Net();
+        conn.m_priority = 0;
+        conn.m_start = edge.GetSourcePos();
+        conn.m_end = edge.GetTargetPos();
+        conn.m_startParent = startParent;
+        conn.m_endParent = endParent;
+        conn.m_conflicted = false;
+
+        // Vias are not placed automatically, a connection is routed on a single layer
+        if( startLayers.Overlaps( endLayers ) )
+            conn.m_layer = std::max( startLayers.Start(), endLayers.Start() );
+        else
+            conn.m_layer = startLayers.Start();
+
+        conn.m_sizes = m_router->Sizes();
+        conn.m_sizes.Init( aBoard, startItem );
+
+        m_connections.push_back( conn );
+        count++;
+    }
+
+    return count;
+}
+
+
+bool BATCH_ROUTER::Run()
+{
+    ROUTING_SETTINGS& settings = m_router->Settings();
+    PNS_MODE          mode = settings.Mode();
+    NODE*             world = m_router->GetWorld();
+
+    std::vector<CONNECTION*> pending;
+
+    for( CONNECTION& conn : m_connections )
+    {
+        auto priority = m_netPriorities.find( conn.m_net );
+
+        conn.m_priority = priority != m_netPriorities.end() ? priority->second : 0;
+        pending.push_back( &conn );
+    }
+
+    std::stable_sort( pending.begin(), pending.end(),
+            []( const CONNECTION* aA, const CONNECTION* aB )
+            {
+                if( aA->m_priority != aB->m_priority )
+                    return aA->m_priority > aB->m_priority;
+
+                return ( aA->m_end - aA->m_start ).SquaredEuclideanNorm()
+                       < ( aB->m_end - aB->m_start ).SquaredEuclideanNorm();
+            } );
+
+    m_stats = STATS();
+    m_stats.m_connections = (int) m_connections.size();
+
+    settings.SetMode( RM_Shove );
+
+    PROF_COUNTER counter;
+
+    while( !pending.empty() )
+    {
+        std::vector<RESULT> wave;
+
+        buildWave( pending, wave );
+        m_stats.m_waves++;
+
+        if( m_parallel && wave.size() > 1 )
+        {
+            ParallelFor( 0, wave.size(),
+                    [&]( size_t aIndex )
+                    {
+                        route( wave[aIndex] );
+                    },
+                    nullptr, 1 );
+        }
+        else
+        {
+            for( RESULT& result : wave )
+                route( result );
+        }
+
+        std::unordered_set<ITEM*> waveRemoved;
+        std::vector<CONNECTION*>  retry;
+
+        for( RESULT& result : wave )
+        {
+            if( !result.m_routed )
+            {
+                m_stats.m_failed++;
+            }
+            else if( commit( result, waveRemoved ) )
+            {
+                m_stats.m_routed++;
+            }
+            else if( !result.m_connection->m_conflicted )
+            {
+                m_stats.m_conflicts++;
+                result.m_connection->m_conflicted = true;
+                retry.push_back( result.m_connection );
+            }
+            else
+            {
+                // Routed alone and still colliding, another try would give the same result
+                m_stats.m_failed++;
+            }
+        }
+
+        world->KillChildren();
+        world->ClearRanks();
+        m_router->GetInterface()->Commit();
+
+        pending.insert( pending.begin(), retry.begin(), retry.end() );
+    }
+
+    counter.Stop();
+    m_stats.m_time = counter.msecs();
+
+    settings.SetMode( mode );
+    m_connections.clear();
+
+    return m_stats.m_routed == m_stats.m_connections;
+}
+
+
+void BATCH_ROUTER::buildWave( std::vector<CONNECTION*>& aPending, std::vector<RESULT>& aWave )
+{
+    NODE*                    world = m_router->GetWorld();
+    std::vector<BOX2I>       areas;
+    std::vector<CONNECTION*> left;
+    bool                     closed = false;
+    bool                     skipped = false;
+    int                      skippedPriority = 0;
+
+    for( CONNECTION* conn : aPending )
+    {
+        BOX2I area = this->area( *conn );
+        bool  take = !closed;
+
+        // A connection deferred to a later wave keeps the connections of lower priority
+        // waiting, and a connection which collided with another one is routed alone
+        if( skipped && conn->m_priority < skippedPriority )
+            take = false;
+
+        if( conn->m_conflicted && !aWave.empty() )
+            take = false;
+
+        for( size_t ii = 0; take && ii < areas.size(); ii++ )
+        {
+            if( areas[ii].Intersects( area ) )
+                take = false;
+        }
+
+        if( !take )
+        {
+            if( !skipped )
+                skippedPriority = conn->m_priority;
+
+            skipped = true;
+            left.push_back( conn );
+            continue;
+        }
+
+        RESULT result;
+
+        result.m_connection = conn;
+        result.m_startItem = findItem( conn->m_startParent, conn->m_start, conn->m_net,
+                                       conn->m_layer );
+        result.m_endItem = findItem( conn->m_endParent, conn->m_end, conn->m_net,
+                                     conn->m_layer );
+        result.m_node = nullptr;
+        result.m_routed = nullptr;
+
+        if( !result.m_startItem || !result.m_endItem )
+        {
+            m_stats.m_failed++;
+            continue;
+        }
+
+        // Branching changes the world, it is done here rather than by the workers
+        result.m_node = world->Branch();
+
+        aWave.push_back( result );
+        areas.push_back( area );
+
+        if( conn->m_conflicted )
+            closed = true;
+    }
+
+    aPending = std::move( left );
+}
+
+
+void BATCH_ROUTER::route( RESULT& aResult )
+{
+    const CONNECTION& conn = *aResult.m_connection;
+
+    // The decorator of the interface draws in the view, it can't be used outside the main
+    // thread. The placer expects one anyway.
+    DEBUG_DECORATOR dbg;
+    LINE_PLACER     placer( m_router );
+
+    placer.SetBaseNode( aResult.m_node );
+    placer.SetDebugDecorator( &dbg );
+    placer.UpdateSizes( conn.m_sizes );
+    placer.SetLayer( conn.m_layer );
+
+    if( !placer.Start( conn.m_start, aResult.m_startItem ) )
+        return;
+
+    placer.Move( conn.m_end, aResult.m_endItem );
+
+    if( placer.CurrentEnd() != conn.m_end )
+        return;
+
+    if( placer.FixRoute( conn.m_end, aResult.m_endItem, false ) )
+        aResult.m_routed = placer.CurrentNode( true );
+}
+
+
+bool BATCH_ROUTER::commit( const RESULT& aResult, std::unordered_set<ITEM*>& aWaveRemoved )
+{
+    NODE*             world = m_router->GetWorld();
+    ROUTER_IFACE*     iface = m_router->GetInterface();
+    NODE::ITEM_VECTOR removed, added;
+
+    aResult.m_routed->GetUpdatedItems( removed, added );
+
+    // Another result of the wave already changed the tracks this one shoved
+    for( ITEM* item : removed )
+    {
+        if( aWaveRemoved.count( item ) )
+            return false;
+    }
+
+    // ...or it placed tracks where this one goes
+    NODE* check = world->Branch();
+    bool  collides = false;
+
+    for( ITEM* item : removed )
+        check->Remove( item );
+
+    for( ITEM* item : added )
+    {
+        if( check->CheckColliding( item ) )
+        {
+            collides = true;
+            break;
+        }
+    }
+
+    delete check;
+
+    if( collides )
+        return false;
+
+    for( ITEM* item : removed )
+    {
+        iface->RemoveItem( item );
+        world->Remove( item );
+        aWaveRemoved.insert( item );
+    }
+
+    // The items of the branch go away with it at the end of the wave, the world gets copies
+    for( ITEM* item : added )
+    {
+        std::unique_ptr<ITEM> copy = Clone( *item );
+        ITEM*                 newItem = copy.get();
+
+        newItem->SetRank( -1 );
+        newItem->Unmark();
+        world->Add( std::move( copy ) );
+        iface->AddItem( newItem );
+    }
+
+    return true;
+}
+
+
+ITEM* BATCH_ROUTER::findItem( const BOARD_CONNECTED_ITEM* aParent, const VECTOR2I& aPos,
+                              int aNet, int aLayer ) const
+{
+    NODE* world = m_router->GetWorld();
+
+    if( ITEM* item = world->FindItemByParent( aParent ) )
+        return item;
+
+    // The track was replaced when an earlier connection shoved it
+    const ITEM_SET hits = world->HitTest( aPos );
+
+    for( int ii = 0; ii < hits.Size(); ii++ )
+    {
+        if( hits[ii]->Net() == aNet && hits[ii]->Layers().Overlaps( aLayer ) )
+            return hits[ii];
+    }
+
+    return nullptr;
+}
+
+
+BOX2I BATCH_ROUTER::area( const CONNECTION& aConnection ) const
+{
+    BOX2I box( aConnection.m_start, VECTOR2I( 0, 0 ) );
+
+    box.Merge( aConnection.m_end );
+    box.Inflate( m_areaMargin + aConnection.m_sizes.TrackWidth() );
+
+    return box;
+}
+
+}
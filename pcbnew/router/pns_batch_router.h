@@ -0,0 +1,173 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PNS_BATCH_ROUTER_H
+#define __PNS_BATCH_ROUTER_H
+
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+#include <math/box2.h>
+#include <math/vector2d.h>
+
+#include "pns_sizes_settings.h"
+
+class BOARD;
+class BOARD_CONNECTED_ITEM;
+
+namespace PNS {
+
+class ITEM;
+class NODE;
+class ROUTER;
+
+/**
+ * BATCH_ROUTER
+ *
+ * Routes the unrouted connections of a board with no user interaction, each one with the
+ * line placer in shove mode, as if the user clicked at the start of the connection and
+ * then at its end.
+ *
+ * The connections are routed by highest net priority first, then shortest first. They are
+ * routed in waves: a wave takes the next connections whose areas (the bounding box of the
+ * ratsnest line, inflated by a margin) do not overlap, and routes each of them in its own
+ * branch of the world, in parallel. The results are then committed to the world in order,
+ * and those colliding with an earlier result of the wave (the shove may push tracks out of
+ * the area) are routed again in a later wave, alone.
+ */
+class BATCH_ROUTER
+{
+public:
+    struct CONNECTION
+    {
+        int                   m_net;
+        int                   m_priority;
+        int                   m_layer;
+        VECTOR2I              m_start;
+        VECTOR2I              m_end;
+        BOARD_CONNECTED_ITEM* m_startParent;
+        BOARD_CONNECTED_ITEM* m_endParent;
+        SIZES_SETTINGS        m_sizes;
+
+        ///> true once the result of the connection has collided with another result
+        bool                  m_conflicted;
+    };
+
+    struct STATS
+    {
+        int    m_connections;   ///< connections to route
+        int    m_routed;        ///< connections routed and committed
+        int    m_failed;        ///< connections the placer could not complete
+        int    m_conflicts;     ///< results dropped for colliding with other results
+        int    m_waves;         ///< waves of parallel routing
+        double m_time;          ///< time spent routing, in milliseconds
+
+        double ConnectionsPerSecond() const
+        {
+            return m_time > 0.0 ? m_routed * 1000.0 / m_time : 0.0;
+        }
+    };
+
+    BATCH_ROUTER( ROUTER* aRouter );
+    ~BATCH_ROUTER();
+
+    /**
+     * Function SetNetPriority()
+     *
+     * Sets the priority of a net, its connections are routed before the ones of the nets of
+     * lower priority. Nets have a priority of 0 unless set otherwise.
+     */
+    void SetNetPriority( int aNet, int aPriority )
+    {
+        m_netPriorities[aNet] = aPriority;
+    }
+
+    ///> Enables routing the connections of a wave concurrently
+    void SetParallel( bool aParallel )
+    {
+        m_parallel = aParallel;
+    }
+
+    ///> Sets the margin added around the ratsnest line of a connection to form its area
+    void SetAreaMargin( int aMargin )
+    {
+        m_areaMargin = aMargin;
+    }
+
+    /**
+     * Function AddUnroutedConnections()
+     *
+     * Adds the unrouted connections of the ratsnest of aBoard, the router world having been
+     * synchronized with it. Connections between items the router does not know of (zones)
+     * are left out.
+     * @return the number of connections added.
+     */
+    int AddUnroutedConnections( BOARD* aBoard );
+
+    /**
+     * Function Run()
+     *
+     * Routes the connections added so far and commits the results to the router world and
+     * to its interface.
+     * @return true, if all the connections were routed.
+     */
+    bool Run();
+
+    const STATS& Stats() const
+    {
+        return m_stats;
+    }
+
+private:
+    struct RESULT
+    {
+        CONNECTION* m_connection;
+        ITEM*       m_startItem;
+        ITEM*       m_endItem;
+        NODE*       m_node;     ///< branch the connection is routed in
+        NODE*       m_routed;   ///< descendant of m_node holding the route, null if it failed
+    };
+
+    ///> Picks the connections of the next wave out of the pending ones
+    void buildWave( std::vector<CONNECTION*>& aPending, std::vector<RESULT>& aWave );
+
+    ///> Routes a connection in aResult.m_node. Called from the worker threads.
+    void route( RESULT& aResult );
+
+    ///> Commits a result to the world unless it collides with the earlier results of the wave
+    bool commit( const RESULT& aResult, std::unordered_set<ITEM*>& aWaveRemoved );
+
+    ///> Finds the router item a connection ends on, in the world as left by the earlier waves
+    ITEM* findItem( const BOARD_CONNECTED_ITEM* aParent, const VECTOR2I& aPos, int aNet,
+                    int aLayer ) const;
+
+    BOX2I area( const CONNECTION& aConnection ) const;
+
+    ROUTER*                 m_router;
+    std::vector<CONNECTION> m_connections;
+    std::map<int, int>      m_netPriorities;
+    bool                    m_parallel;
+    int                     m_areaMargin;
+    STATS                   m_stats;
+};
+
+}
+
+#endif
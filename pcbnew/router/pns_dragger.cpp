@@ -368,12 +368,17 @@ bool DRAGGER::dragWalkaround( const VECTOR2I& aP )
 
         if ( m_world->CheckColliding( &dragged ) )
         {
+            TIME_LIMIT timeLimit = Settings().WalkaroundTimeLimit();
             WALKAROUND walkaround( m_lastNode, Router() );
 
             walkaround.SetSolidsOnly( false );
             walkaround.SetDebugDecorator( Dbg() );
             walkaround.SetLogger( Logger() );
             walkaround.SetIterationLimit( Settings().WalkaroundIterationLimit() );
+            walkaround.SetParallel( Settings().ParallelSearch() );
+            walkaround.SetTimeLimit( &timeLimit );
+
+            timeLimit.Restart();
 
             WALKAROUND::RESULT wr = walkaround.Route( dragged );
 
@@ -35,6 +35,33 @@ INDEX::~INDEX()
 }
 
 
+INDEX::INDEX( const INDEX& aOther )
+{
+    memset( m_subIndices, 0, sizeof( m_subIndices ) );
+    *this = aOther;
+}
+
+
+INDEX& INDEX::operator=( const INDEX& aOther )
+{
+    if( this == &aOther )
+        return *this;
+
+    Clear();
+
+    for( int i = 0; i < MaxSubIndices; ++i )
+    {
+        if( aOther.m_subIndices[i] )
+            m_subIndices[i] = new ITEM_SHAPE_INDEX( *aOther.m_subIndices[i] );
+    }
+
+    m_netMap = aOther.m_netMap;
+    m_allItems = aOther.m_allItems;
+
+    return *this;
+}
+
+
 INDEX::ITEM_SHAPE_INDEX* INDEX::getSubindex( const ITEM* aItem )
 {
     int idx_n = -1;
@@ -90,7 +117,7 @@ void INDEX::Add( ITEM* aItem )
     if( !idx )
         return;
 
-    idx->Add( aItem );
+    idx->Add( aItem, aItem->Shape()->BBox() );
     m_allItems.insert( aItem );
     int net = aItem->Net();
 
@@ -133,6 +160,9 @@ void INDEX::Clear()
 
         m_subIndices[i] = NULL;
     }
+
+    m_netMap.clear();
+    m_allItems.clear();
 }
 
 
@@ -29,9 +29,10 @@
 #include <boost/range/adaptor/map.hpp>
 
 #include <list>
-#include <geometry/shape_index.h>
+#include <geometry/shape.h>
 
 #include "pns_item.h"
+#include "pns_item_grid.h"
 
 namespace PNS {
 
@@ -40,19 +41,26 @@ namespace PNS {
  * INDEX
  *
  * Custom spatial index, holding our board items and allowing for very fast searches. Items
- * are assigned to separate R-Tree subindices depending on their type and spanned layers, reducing
- * overlap and improving search time.
+ * are assigned to separate flat subindices (see ITEM_GRID) depending on their type and spanned
+ * layers, reducing overlap and improving search time.
  **/
 class INDEX
 {
 public:
     typedef std::list<ITEM*>            NET_ITEMS_LIST;
-    typedef SHAPE_INDEX<ITEM*>          ITEM_SHAPE_INDEX;
+    typedef ITEM_GRID                   ITEM_SHAPE_INDEX;
     typedef std::unordered_set<ITEM*>   ITEM_SET;
 
     INDEX();
     ~INDEX();
 
+    /**
+     * Copies the items of another index, along with their subindices. Much cheaper than
+     * adding the items one by one.
+     */
+    INDEX( const INDEX& aOther );
+    INDEX& operator=( const INDEX& aOther );
+
     /**
      * Function Add()
      *
@@ -150,7 +158,7 @@ private:
     static const int    SI_PadsBottom   = 1;
 
     template <class Visitor>
-    int querySingle( int index, const SHAPE* aShape, int aMinDistance, Visitor& aVisitor );
+    int querySingle( int index, const BOX2I& aBox, Visitor& aVisitor );
 
     ITEM_SHAPE_INDEX* getSubindex( const ITEM* aItem );
 
@@ -161,42 +169,44 @@ private:
 
 
 template<class Visitor>
-int INDEX::querySingle( int index, const SHAPE* aShape, int aMinDistance, Visitor& aVisitor )
+int INDEX::querySingle( int index, const BOX2I& aBox, Visitor& aVisitor )
 {
     if( !m_subIndices[index] )
         return 0;
 
-    return m_subIndices[index]->Query( aShape, aMinDistance, aVisitor, false );
+    return m_subIndices[index]->Query( aBox, aVisitor );
 }
 
 template<class Visitor>
 int INDEX::Query( const ITEM* aItem, int aMinDistance, Visitor& aVisitor )
 {
-    const SHAPE* shape = aItem->Shape();
+    BOX2I box = aItem->Shape()->BBox();
     int total = 0;
 
-    total += querySingle( SI_Multilayer, shape, aMinDistance, aVisitor );
+    box.Inflate( aMinDistance );
+
+    total += querySingle( SI_Multilayer, box, aVisitor );
 
     const LAYER_RANGE& layers = aItem->Layers();
 
     if( layers.IsMultilayer() )
     {
-        total += querySingle( SI_PadsTop, shape, aMinDistance, aVisitor );
-        total += querySingle( SI_PadsBottom, shape, aMinDistance, aVisitor );
+        total += querySingle( SI_PadsTop, box, aVisitor );
+        total += querySingle( SI_PadsBottom, box, aVisitor );
 
         for( int i = layers.Start(); i <= layers.End(); ++i )
-            total += querySingle( SI_Traces + 2 * i + SI_SegStraight, shape, aMinDistance, aVisitor );
+            total += querySingle( SI_Traces + 2 * i + SI_SegStraight, box, aVisitor );
     }
     else
     {
         int l = layers.Start();
 
         if( l == B_Cu )
-            total += querySingle( SI_PadsTop, shape, aMinDistance, aVisitor );
+            total += querySingle( SI_PadsTop, box, aVisitor );
         else if( l == F_Cu )
-            total += querySingle( SI_PadsBottom, shape, aMinDistance, aVisitor );
+            total += querySingle( SI_PadsBottom, box, aVisitor );
 
-        total += querySingle(  SI_Traces + 2 * l + SI_SegStraight, shape, aMinDistance, aVisitor );
+        total += querySingle(  SI_Traces + 2 * l + SI_SegStraight, box, aVisitor );
     }
 
     return total;
@@ -205,10 +215,13 @@ int INDEX::Query( const ITEM* aItem, int aMinDistance, Visitor& aVisitor )
 template<class Visitor>
 int INDEX::Query( const SHAPE* aShape, int aMinDistance, Visitor& aVisitor )
 {
+    BOX2I box = aShape->BBox();
     int total = 0;
 
+    box.Inflate( aMinDistance );
+
     for( int i = 0; i < MaxSubIndices; i++ )
-        total += querySingle( i, aShape, aMinDistance, aVisitor );
+        total += querySingle( i, box, aVisitor );
 
     return total;
 }
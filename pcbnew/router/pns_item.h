@@ -28,6 +28,7 @@
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 
+#include "pns_item_pool.h"
 #include "pns_layerset.h"
 
 class BOARD_CONNECTED_ITEM;
@@ -95,6 +96,17 @@ public:
 
     virtual ~ITEM();
 
+    ///> Items are allocated from the item pool (see ITEM_POOL)
+    static void* operator new( size_t aSize )
+    {
+        return ITEM_POOL::Allocate( aSize );
+    }
+
+    static void operator delete( void* aPtr, size_t aSize )
+    {
+        ITEM_POOL::Free( aPtr, aSize );
+    }
+
     /**
      * Function Clone()
      *
@@ -0,0 +1,175 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pns_item_grid.h"
+
+namespace PNS {
+
+ITEM_GRID::RECT ITEM_GRID::makeRect( const BOX2I& aBox )
+{
+    BOX2I box( aBox );
+    box.Normalize();
+
+    return RECT{ box.GetX(), box.GetY(), box.GetRight(), box.GetBottom() };
+}
+
+
+void ITEM_GRID::link( int aSlot )
+{
+    const RECT& rect = m_rects[aSlot];
+
+    if( isLarge( rect ) )
+    {
+        m_large.push_back( aSlot );
+        return;
+    }
+
+    for( int cx = rect.CellX0(); cx <= rect.CellX1(); ++cx )
+    {
+        for( int cy = rect.CellY0(); cy <= rect.CellY1(); ++cy )
+            m_cells[cellKey( cx, cy )].push_back( aSlot );
+    }
+}
+
+
+void ITEM_GRID::unlink( int aSlot )
+{
+    const RECT& rect = m_rects[aSlot];
+
+    auto drop = [aSlot]( std::vector<int>& aSlots )
+    {
+        auto it = std::find( aSlots.begin(), aSlots.end(), aSlot );
+
+        *it = aSlots.back();
+        aSlots.pop_back();
+    };
+
+    if( isLarge( rect ) )
+    {
+        drop( m_large );
+        return;
+    }
+
+    for( int cx = rect.CellX0(); cx <= rect.CellX1(); ++cx )
+    {
+        for( int cy = rect.CellY0(); cy <= rect.CellY1(); ++cy )
+        {
+            auto cell = m_cells.find( cellKey( cx, cy ) );
+
+            drop( cell->second );
+
+            if( cell->second.empty() )
+                m_cells.erase( cell );
+        }
+    }
+}
+
+
+void ITEM_GRID::relink( int aOldSlot, int aNewSlot )
+{
+    const RECT& rect = m_rects[aOldSlot];
+
+    auto rename = [aOldSlot, aNewSlot]( std::vector<int>& aSlots )
+    {
+        *std::find( aSlots.begin(), aSlots.end(), aOldSlot ) = aNewSlot;
+    };
+
+    if( isLarge( rect ) )
+    {
+        rename( m_large );
+        return;
+    }
+
+    for( int cx = rect.CellX0(); cx <= rect.CellX1(); ++cx )
+    {
+        for( int cy = rect.CellY0(); cy <= rect.CellY1(); ++cy )
+            rename( m_cells[cellKey( cx, cy )] );
+    }
+}
+
+
+void ITEM_GRID::buildGrid()
+{
+    m_gridded = true;
+
+    for( int slot = 0; slot < (int) m_items.size(); ++slot )
+        link( slot );
+}
+
+
+void ITEM_GRID::Add( ITEM* aItem, const BOX2I& aBBox )
+{
+    if( m_slots.count( aItem ) )
+        return;
+
+    int slot = m_items.size();
+
+    m_slots[aItem] = slot;
+    m_items.push_back( aItem );
+    m_rects.push_back( makeRect( aBBox ) );
+
+    if( m_gridded )
+        link( slot );
+    else if( (int) m_items.size() >= GRID_MIN_ITEMS )
+        buildGrid();
+}
+
+
+void ITEM_GRID::Remove( ITEM* aItem )
+{
+    auto it = m_slots.find( aItem );
+
+    if( it == m_slots.end() )
+        return;
+
+    int slot = it->second;
+    int last = m_items.size() - 1;
+
+    m_slots.erase( it );
+
+    if( m_gridded )
+        unlink( slot );
+
+    // The last item takes the place of the removed one, keeping the arrays packed
+    if( slot != last )
+    {
+        if( m_gridded )
+            relink( last, slot );
+
+        m_items[slot] = m_items[last];
+        m_rects[slot] = m_rects[last];
+        m_slots[m_items[slot]] = slot;
+    }
+
+    m_items.pop_back();
+    m_rects.pop_back();
+}
+
+
+void ITEM_GRID::Clear()
+{
+    m_rects.clear();
+    m_items.clear();
+    m_slots.clear();
+    m_cells.clear();
+    m_large.clear();
+    m_gridded = false;
+}
+
+}
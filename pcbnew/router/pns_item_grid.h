@@ -0,0 +1,214 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PNS_ITEM_GRID_H
+#define __PNS_ITEM_GRID_H
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <math/box2.h>
+
+namespace PNS {
+
+class ITEM;
+
+/**
+ * ITEM_GRID
+ *
+ * Flat spatial index of items by bounding box. The boxes and the items are kept in
+ * contiguous arrays: small sets are searched linearly, larger ones through a uniform grid
+ * of cells holding the slots of the items overlapping them. Items spanning many cells are
+ * kept aside and always searched linearly. Copying the index (when a node is branched)
+ * copies a few arrays instead of building a tree again.
+ */
+class ITEM_GRID
+{
+public:
+    ITEM_GRID() :
+        m_gridded( false )
+    {}
+
+    /**
+     * Function Add()
+     *
+     * Adds an item with its bounding box. The box is kept until the item is removed.
+     */
+    void Add( ITEM* aItem, const BOX2I& aBBox );
+
+    /**
+     * Function Remove()
+     *
+     * Removes an item, whatever its current shape is.
+     */
+    void Remove( ITEM* aItem );
+
+    void Clear();
+
+    int Size() const { return m_items.size(); }
+
+    /**
+     * Function Query()
+     *
+     * Calls aVisitor on every item whose bounding box overlaps aBox, in no particular
+     * order. Return false from the visitor to stop searching.
+     * @return number of items visited, not counting the one that stopped the search.
+     */
+    template <class Visitor>
+    int Query( const BOX2I& aBox, Visitor& aVisitor ) const;
+
+private:
+    ///> log2 of the cell size (about 2 mm)
+    static const int CELL_SHIFT = 21;
+
+    ///> number of items above which the grid is built
+    static const int GRID_MIN_ITEMS = 64;
+
+    ///> number of cells above which an item is kept aside
+    static const int MAX_ITEM_CELLS = 16;
+
+    ///> bounding box with inclusive limits
+    struct RECT
+    {
+        int m_x0, m_y0, m_x1, m_y1;
+
+        bool Overlaps( const RECT& aOther ) const
+        {
+            return m_x0 <= aOther.m_x1 && aOther.m_x0 <= m_x1
+                   && m_y0 <= aOther.m_y1 && aOther.m_y0 <= m_y1;
+        }
+
+        int CellX0() const { return m_x0 >> CELL_SHIFT; }
+        int CellY0() const { return m_y0 >> CELL_SHIFT; }
+        int CellX1() const { return m_x1 >> CELL_SHIFT; }
+        int CellY1() const { return m_y1 >> CELL_SHIFT; }
+
+        int64_t CellCount() const
+        {
+            return int64_t( CellX1() - CellX0() + 1 ) * ( CellY1() - CellY0() + 1 );
+        }
+    };
+
+    static RECT makeRect( const BOX2I& aBox );
+
+    static uint64_t cellKey( int aX, int aY )
+    {
+        return ( uint64_t( uint32_t( aX ) ) << 32 ) | uint32_t( aY );
+    }
+
+    static bool isLarge( const RECT& aRect ) { return aRect.CellCount() > MAX_ITEM_CELLS; }
+
+    void link( int aSlot );
+    void unlink( int aSlot );
+    void relink( int aOldSlot, int aNewSlot );
+    void buildGrid();
+
+    template <class Visitor>
+    int queryLinear( const RECT& aRect, Visitor& aVisitor ) const;
+
+    std::vector<RECT>                              m_rects;
+    std::vector<ITEM*>                             m_items;
+    std::unordered_map<const ITEM*, int>           m_slots;
+    std::unordered_map<uint64_t, std::vector<int>> m_cells;
+    std::vector<int>                               m_large;
+    bool                                           m_gridded;
+};
+
+
+template <class Visitor>
+int ITEM_GRID::queryLinear( const RECT& aRect, Visitor& aVisitor ) const
+{
+    int count = 0;
+
+    for( size_t slot = 0; slot < m_rects.size(); ++slot )
+    {
+        if( !m_rects[slot].Overlaps( aRect ) )
+            continue;
+
+        if( !aVisitor( m_items[slot] ) )
+            return count;
+
+        count++;
+    }
+
+    return count;
+}
+
+
+template <class Visitor>
+int ITEM_GRID::Query( const BOX2I& aBox, Visitor& aVisitor ) const
+{
+    RECT rect = makeRect( aBox );
+
+    // Scanning the boxes beats looking up more cells than there are
+    if( !m_gridded || rect.CellCount() > (int64_t) m_cells.size() )
+        return queryLinear( rect, aVisitor );
+
+    int count = 0;
+    int cx0 = rect.CellX0();
+    int cy0 = rect.CellY0();
+
+    for( int cx = cx0; cx <= rect.CellX1(); ++cx )
+    {
+        for( int cy = cy0; cy <= rect.CellY1(); ++cy )
+        {
+            auto cell = m_cells.find( cellKey( cx, cy ) );
+
+            if( cell == m_cells.end() )
+                continue;
+
+            for( int slot : cell->second )
+            {
+                const RECT& itemRect = m_rects[slot];
+
+                // Visit each item once, in the first cell shared by the item and the query
+                if( cx != std::max( cx0, itemRect.CellX0() )
+                        || cy != std::max( cy0, itemRect.CellY0() ) )
+                    continue;
+
+                if( !itemRect.Overlaps( rect ) )
+                    continue;
+
+                if( !aVisitor( m_items[slot] ) )
+                    return count;
+
+                count++;
+            }
+        }
+    }
+
+    for( int slot : m_large )
+    {
+        if( !m_rects[slot].Overlaps( rect ) )
+            continue;
+
+        if( !aVisitor( m_items[slot] ) )
+            return count;
+
+        count++;
+    }
+
+    return count;
+}
+
+}
+
+#endif
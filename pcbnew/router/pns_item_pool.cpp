@@ -0,0 +1,207 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pns_item_pool.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace PNS {
+
+static std::atomic<uint64_t> s_items( 0 );
+static std::atomic<uint64_t> s_heapAllocations( 0 );
+static std::atomic<uint64_t> s_chunkBytes( 0 );
+
+// The chunks are never given back, not even on exit: the blocks of a chunk may be in use or
+// in the free list of any thread until the very end. The mutex guards the shared free lists
+// as well.
+static std::mutex          s_chunkMutex;
+static std::vector<void*>* s_chunks = new std::vector<void*>;
+
+thread_local ITEM_POOL::THREAD_LISTS ITEM_POOL::m_threadLists;
+thread_local bool                    ITEM_POOL::m_threadExited = false;
+ITEM_POOL::FREE_LIST                 ITEM_POOL::m_sharedLists[ITEM_POOL::CLASS_COUNT] = {};
+
+
+ITEM_POOL::THREAD_LISTS::~THREAD_LISTS()
+{
+    for( size_t cls = 0; cls < CLASS_COUNT; ++cls )
+        release( cls, m_lists[cls], m_lists[cls].m_count );
+
+    // Items created or freed later on by this thread, while its other thread-local objects
+    // are destroyed, go straight to and from the shared lists
+    m_threadExited = true;
+}
+
+
+void ITEM_POOL::refill( size_t aClass )
+{
+    size_t blockSize = ( aClass + 1 ) * SIZE_STEP;
+    char*  chunk = static_cast<char*>( ::operator new( CHUNK_SIZE ) );
+
+    s_chunks->push_back( chunk );
+
+    s_heapAllocations.fetch_add( 1, std::memory_order_relaxed );
+    s_chunkBytes.fetch_add( CHUNK_SIZE, std::memory_order_relaxed );
+
+    FREE_LIST& shared = m_sharedLists[aClass];
+
+    for( size_t offset = 0; offset + blockSize <= CHUNK_SIZE; offset += blockSize )
+    {
+        FREE_BLOCK* block = reinterpret_cast<FREE_BLOCK*>( chunk + offset );
+
+        block->m_next = shared.m_head;
+        shared.m_head = block;
+        shared.m_count++;
+    }
+}
+
+
+void ITEM_POOL::acquire( size_t aClass, FREE_LIST& aList, size_t aCount )
+{
+    std::lock_guard<std::mutex> lock( s_chunkMutex );
+    FREE_LIST&                  shared = m_sharedLists[aClass];
+
+    if( !shared.m_head )
+        refill( aClass );
+
+    for( ; aCount > 0 && shared.m_head; --aCount )
+    {
+        FREE_BLOCK* block = shared.m_head;
+
+        shared.m_head = block->m_next;
+        shared.m_count--;
+
+        block->m_next = aList.m_head;
+        aList.m_head = block;
+        aList.m_count++;
+    }
+}
+
+
+void ITEM_POOL::release( size_t aClass, FREE_LIST& aList, size_t aCount )
+{
+    if( !aList.m_head || aCount == 0 )
+        return;
+
+    // Detach the first aCount blocks of the list, outside of the lock
+    FREE_BLOCK* first = aList.m_head;
+    FREE_BLOCK* last = first;
+    size_t      count = 1;
+
+    while( count < aCount && last->m_next )
+    {
+        last = last->m_next;
+        count++;
+    }
+
+    aList.m_head = last->m_next;
+    aList.m_count -= count;
+
+    std::lock_guard<std::mutex> lock( s_chunkMutex );
+    FREE_LIST&                  shared = m_sharedLists[aClass];
+
+    last->m_next = shared.m_head;
+    shared.m_head = first;
+    shared.m_count += count;
+}
+
+
+void* ITEM_POOL::Allocate( size_t aSize )
+{
+    s_items.fetch_add( 1, std::memory_order_relaxed );
+
+    if( aSize == 0 || aSize > MAX_SIZE )
+    {
+        s_heapAllocations.fetch_add( 1, std::memory_order_relaxed );
+        return ::operator new( aSize );
+    }
+
+    size_t cls = sizeClass( aSize );
+
+    if( m_threadExited )
+    {
+        FREE_LIST single = {};
+
+        acquire( cls, single, 1 );
+        return single.m_head;
+    }
+
+    FREE_LIST& list = m_threadLists.m_lists[cls];
+
+    if( !list.m_head )
+        acquire( cls, list, BATCH_SIZE );
+
+    FREE_BLOCK* block = list.m_head;
+
+    list.m_head = block->m_next;
+    list.m_count--;
+
+    return block;
+}
+
+
+void ITEM_POOL::Free( void* aPtr, size_t aSize )
+{
+    if( !aPtr )
+        return;
+
+    if( aSize == 0 || aSize > MAX_SIZE )
+    {
+        ::operator delete( aPtr );
+        return;
+    }
+
+    size_t      cls = sizeClass( aSize );
+    FREE_BLOCK* block = static_cast<FREE_BLOCK*>( aPtr );
+
+    if( m_threadExited )
+    {
+        FREE_LIST single = { block, 1 };
+
+        block->m_next = nullptr;
+        release( cls, single, 1 );
+        return;
+    }
+
+    FREE_LIST& list = m_threadLists.m_lists[cls];
+
+    block->m_next = list.m_head;
+    list.m_head = block;
+    list.m_count++;
+
+    if( list.m_count > 2 * BATCH_SIZE )
+        release( cls, list, BATCH_SIZE );
+}
+
+
+ITEM_POOL::STATS ITEM_POOL::GetStats()
+{
+    STATS stats;
+
+    stats.m_items = s_items.load( std::memory_order_relaxed );
+    stats.m_heapAllocations = s_heapAllocations.load( std::memory_order_relaxed );
+    stats.m_chunkBytes = s_chunkBytes.load( std::memory_order_relaxed );
+
+    return stats;
+}
+
+}
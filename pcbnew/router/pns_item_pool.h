@@ -0,0 +1,123 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PNS_ITEM_POOL_H
+#define __PNS_ITEM_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PNS {
+
+/**
+ * ITEM_POOL
+ *
+ * Allocator of the router items (lines, segments, arcs, vias...). The items are carved out
+ * of large chunks in a few size classes, and freed blocks are kept for the next items of the
+ * same size. Once the pool has grown to the peak needs of the shove and walkaround
+ * iterations, creating and discarding items no longer reaches the general-purpose heap. The
+ * chunks are kept for the whole session and beyond, the items of the world outliving the
+ * routing sessions.
+ *
+ * Each thread keeps a few free blocks of each size class to itself, and exchanges them in
+ * batches with free lists shared by all the threads. Items are often freed by another thread
+ * than the one which created them (the GUI thread discards the branches searched by the
+ * worker threads), so the blocks freed by a thread go back to the shared lists once it holds
+ * more than it needs, and when it exits.
+ */
+class ITEM_POOL
+{
+public:
+    struct STATS
+    {
+        ///> number of items allocated
+        uint64_t m_items;
+
+        ///> number of allocations from the heap: chunks and items too large for the pool
+        uint64_t m_heapAllocations;
+
+        ///> memory held in chunks, in bytes
+        uint64_t m_chunkBytes;
+    };
+
+    static void* Allocate( size_t aSize );
+
+    static void Free( void* aPtr, size_t aSize );
+
+    ///> Returns the counters since the start of the program
+    static STATS GetStats();
+
+private:
+    ///> granularity of the size classes, also the alignment of the blocks
+    static const size_t SIZE_STEP = 16;
+
+    ///> size of the largest items served by the pool
+    static const size_t MAX_SIZE = 512;
+
+    static const size_t CLASS_COUNT = MAX_SIZE / SIZE_STEP;
+
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    ///> number of blocks a thread takes from or gives back to the shared lists at once
+    static const size_t BATCH_SIZE = 64;
+
+    struct FREE_BLOCK
+    {
+        FREE_BLOCK* m_next;
+    };
+
+    struct FREE_LIST
+    {
+        FREE_BLOCK* m_head;
+        size_t      m_count;
+    };
+
+    ///> Free blocks of each size class held by a thread, given back to the shared lists
+    ///> when the thread exits
+    struct THREAD_LISTS
+    {
+        FREE_LIST m_lists[CLASS_COUNT] = {};
+
+        ~THREAD_LISTS();
+    };
+
+    static size_t sizeClass( size_t aSize ) { return ( aSize - 1 ) / SIZE_STEP; }
+
+    ///> Adds the blocks of a new chunk to a shared list. The shared lists must be locked.
+    static void refill( size_t aClass );
+
+    ///> Moves up to aCount blocks from the shared list of a size class to aList
+    static void acquire( size_t aClass, FREE_LIST& aList, size_t aCount );
+
+    ///> Moves aCount blocks (all of them if more) from aList to the shared list
+    static void release( size_t aClass, FREE_LIST& aList, size_t aCount );
+
+    ///> free blocks held by this thread
+    static thread_local THREAD_LISTS m_threadLists;
+
+    ///> true once the blocks of this thread have been given back, at its exit
+    static thread_local bool m_threadExited;
+
+    ///> free blocks of each size class shared by all the threads
+    static FREE_LIST m_sharedLists[CLASS_COUNT];
+};
+
+}
+
+#endif
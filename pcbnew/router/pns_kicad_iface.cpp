@@ -30,6 +30,8 @@
 #include <class_drawsegment.h>
 #include <class_pcb_text.h>
 #include <board_commit.h>
+#include <drc/drc.h>
+#include <advanced_config.h>
 #include <layers_id_colors_and_visibility.h>
 #include <geometry/convex_hull.h>
 #include <confirm.h>
@@ -1443,6 +1445,13 @@ void PNS_KICAD_IFACE::Commit()
 
     m_commit->Push( _( "Interactive Router" ) );
     m_commit = std::make_unique<BOARD_COMMIT>( m_tool );
+
+    // Keep the DRC markers up to date while routing
+    int drcBudget = ADVANCED_CFG::GetCfg().m_realTimeDrcBudget;
+    DRC* drc = m_tool->GetManager()->GetTool<DRC>();
+
+    if( drcBudget > 0 && drc )
+        drc->RunIncrementalTests( std::chrono::milliseconds( drcBudget ) );
 }
 
 
@@ -48,6 +48,7 @@ LINE_PLACER::LINE_PLACER( ROUTER* aRouter ) :
 
     // Init temporary variables (do not leave uninitialized members)
     m_lastNode = NULL;
+    m_baseNode = NULL;
     m_placingVia = false;
     m_currentNet = 0;
     m_currentLayer = 0;
@@ -392,18 +393,22 @@ VECTOR2I closestProjectedPoint( const SHAPE_LINE_CHAIN& line, const VECTOR2I& p
 bool LINE_PLACER::rhWalkOnly( const VECTOR2I& aP, LINE& aNewHead )
 {
     LINE initTrack( m_head );
-    LINE walkFull( m_head );
     int effort = 0;
-    bool rv = true, viaOk;
+    bool viaOk;
 
     viaOk = buildInitialLine( aP, initTrack );
 
+    TIME_LIMIT timeLimit = Settings().WalkaroundTimeLimit();
     WALKAROUND walkaround( m_currentNode, Router() );
 
     walkaround.SetSolidsOnly( false );
     walkaround.SetDebugDecorator( Dbg() );
     walkaround.SetLogger( Logger() );
     walkaround.SetIterationLimit( Settings().WalkaroundIterationLimit() );
+    walkaround.SetParallel( Settings().ParallelSearch() );
+    walkaround.SetTimeLimit( &timeLimit );
+
+    timeLimit.Restart();
 
     WALKAROUND::RESULT wr = walkaround.Route( initTrack );
     //WALKAROUND::WALKAROUND_STATUS wf = walkaround.Route( initTrack, walkFull, false );
@@ -433,10 +438,6 @@ bool LINE_PLACER::rhWalkOnly( const VECTOR2I& aP, LINE& aNewHead )
 
     }
 
-    walkFull.SetShape( l_ccw.Length() < l_cw.Length() ? l_ccw : l_cw );
-
-    Dbg()->AddLine( walkFull.CLine(), 2, 100000, "walk-full" );
-
     switch( Settings().OptimizerEffort() )
     {
     case OE_LOW:
@@ -452,28 +453,78 @@ bool LINE_PLACER::rhWalkOnly( const VECTOR2I& aP, LINE& aNewHead )
     if( Settings().SmartPads() )
         effort |= OPTIMIZER::SMART_PADS;
 
-    if( wr.statusCw == WALKAROUND::STUCK || wr.statusCcw == WALKAROUND::STUCK )
+    bool stuck = wr.statusCw == WALKAROUND::STUCK || wr.statusCcw == WALKAROUND::STUCK;
+
+    // With the parallel search, both paths are finished and optimized concurrently, the
+    // shorter one first, and the one with the lowest cost wins. They only read the current
+    // node, so the candidates share it. Otherwise only the shorter path is finished.
+    LINE candidates[2] = { m_head, m_head };
+    bool valid[2] = { false, false };
+    int  count = ( Settings().ParallelSearch() && l_cw != l_ccw ) ? 2 : 1;
+
+    candidates[0].SetShape( l_ccw.Length() < l_cw.Length() ? l_ccw : l_cw );
+    candidates[1].SetShape( l_ccw.Length() < l_cw.Length() ? l_cw : l_ccw );
+
+    Dbg()->AddLine( candidates[0].CLine(), 2, 100000, "walk-full" );
+
+    auto finishCandidate = [&]( int aIndex )
+    {
+        LINE& candidate = candidates[aIndex];
+
+        if( stuck )
+            candidate = candidate.ClipToNearestObstacle( m_currentNode );
+        else if( m_placingVia && viaOk )
+            candidate.AppendVia( makeVia( candidate.CPoint( -1 ) ) );
+
+        OPTIMIZER optimizer( m_currentNode );
+
+        optimizer.SetEffortLevel( effort );
+        optimizer.SetCollisionMask( -1 );
+        optimizer.Optimize( &candidate );
+
+        valid[aIndex] = !m_currentNode->CheckColliding( &candidate );
+    };
+
+    if( count > 1 )
     {
-        walkFull = walkFull.ClipToNearestObstacle( m_currentNode );
-        rv = true;
+        TASK_GROUP group;
+
+        group.Run( [&]()
+                   {
+                       finishCandidate( 1 );
+                   } );
+
+        finishCandidate( 0 );
+        group.Wait();
     }
-    else if( m_placingVia && viaOk )
+    else
     {
-        walkFull.AppendVia( makeVia( walkFull.CPoint( -1 ) ) );
+        finishCandidate( 0 );
     }
 
-    OPTIMIZER::Optimize( &walkFull, effort, m_currentNode );
+    int best = valid[0] ? 0 : -1;
+
+    if( count > 1 && valid[1] )
+    {
+        COST_ESTIMATOR cost[2];
+
+        cost[0].Add( candidates[0] );
+        cost[1].Add( candidates[1] );
+
+        if( best < 0 || cost[0].IsBetter( cost[1], 1.0, 1.0 ) )
+            best = 1;
+    }
 
-    if( m_currentNode->CheckColliding( &walkFull ) )
+    if( best < 0 )
     {
         aNewHead = m_head;
         return false;
     }
 
-    m_head = walkFull;
-    aNewHead = walkFull;
+    m_head = candidates[best];
+    aNewHead = m_head;
 
-    return rv;
+    return true;
 }
 
 
@@ -1003,7 +1054,7 @@ void LINE_PLACER::initPlacement()
     m_p_start = m_currentStart;
     m_direction = m_initial_direction;
 
-    NODE* world = Router()->GetWorld();
+    NODE* world = m_baseNode ? m_baseNode : Router()->GetWorld();
 
     world->KillChildren();
     NODE* rootNode = world->Branch();
@@ -231,6 +231,19 @@ public:
      */
     bool SplitAdjacentSegments( NODE* aNode, ITEM* aSeg, const VECTOR2I& aP );
 
+    /**
+     * Function SetBaseNode()
+     *
+     * Places the track in branches of aNode instead of the world of the router. The node
+     * is owned by the caller, who commits the placed track from CurrentNode( true ) in
+     * place of CommitPlacement(). Used to route several tracks at a time, each in its own
+     * branch of the world.
+     */
+    void SetBaseNode( NODE* aNode )
+    {
+        m_baseNode = aNode;
+    }
+
 
 private:
     /**
@@ -415,6 +428,9 @@ private:
     ///> Postprocessed world state (including marked collisions & removed loops)
     NODE* m_lastNode;
 
+    ///> node the placement branches from, the world of the router if null
+    NODE* m_baseNode;
+
     SIZES_SETTINGS m_sizes;
 
     ///> Are we placing a via?
@@ -26,17 +26,24 @@
 #include "pns_segment.h"
 #include "pns_solid.h"
 
+#include <class_board_connected_item.h>
+
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_rect.h>
 #include <geometry/shape_circle.h>
 #include <geometry/shape_simple.h>
 
+#include <macros.h>
+
+#include <fstream>
+
 namespace PNS {
 
 LOGGER::LOGGER( )
 {
     m_groupOpened = false;
+    m_enabled = false;
 }
 
 
@@ -48,10 +55,24 @@ LOGGER::~LOGGER()
 void LOGGER::Clear()
 {
     m_theLog.str( std::string() );
+    m_events.clear();
     m_groupOpened = false;
 }
 
 
+void LOGGER::Append( const LOGGER& aOther )
+{
+    EndGroup();
+
+    m_theLog << aOther.m_theLog.str();
+
+    if( aOther.m_groupOpened )
+        m_theLog << "endgroup" << std::endl;
+
+    m_events.insert( m_events.end(), aOther.m_events.begin(), aOther.m_events.end() );
+}
+
+
 void LOGGER::NewGroup( const std::string& aName, int aIter )
 {
     if( m_groupOpened )
@@ -139,6 +160,14 @@ void LOGGER::Log( const VECTOR2I& aStart, const VECTOR2I& aEnd,
 }
 
 
+void LOGGER::Log( LOGGER::EVENT_TYPE aEvent, const VECTOR2I& aPos, const ITEM* aItem, int aArg )
+{
+    const KIID& uuid = ( aItem && aItem->Parent() ) ? aItem->Parent()->m_Uuid : niluuid;
+
+    m_events.push_back( EVENT_ENTRY{ aEvent, aPos, uuid, aArg } );
+}
+
+
 void LOGGER::dumpShape( const SHAPE* aSh )
 {
     switch( aSh->Type() )
@@ -200,9 +229,52 @@ void LOGGER::Save( const std::string& aFilename )
 
     FILE* f = fopen( aFilename.c_str(), "wb" );
     wxLogTrace( "PNS", "Saving to '%s' [%p]", aFilename.c_str(), f );
+
+    if( !f )
+        return;
+
+    // event <type> <x> <y> <uuid> <arg>
+    for( const EVENT_ENTRY& evt : m_events )
+    {
+        fprintf( f, "event %d %d %d %s %d\n", evt.m_type, evt.m_p.x, evt.m_p.y,
+                 TO_UTF8( evt.m_uuid.AsString() ), evt.m_arg );
+    }
+
     const std::string s = m_theLog.str();
     fwrite( s.c_str(), 1, s.length(), f );
     fclose( f );
 }
 
+
+bool LOGGER::LoadEvents( const std::string& aFilename, std::vector<EVENT_ENTRY>& aEvents )
+{
+    std::ifstream file( aFilename );
+
+    if( !file )
+        return false;
+
+    std::string line;
+
+    while( std::getline( file, line ) )
+    {
+        std::istringstream stream( line );
+        std::string        keyword, uuid;
+        int                type, x, y, arg;
+
+        if( !( stream >> keyword ) || keyword != "event" )
+            continue;
+
+        if( !( stream >> type >> x >> y >> uuid >> arg ) )
+            continue;
+
+        if( type < EVT_START_ROUTE || type > EVT_STOP )
+            continue;
+
+        aEvents.push_back( EVENT_ENTRY{ static_cast<EVENT_TYPE>( type ), VECTOR2I( x, y ),
+                                        KIID( wxString( uuid ) ), arg } );
+    }
+
+    return true;
+}
+
 }
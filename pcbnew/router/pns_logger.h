@@ -28,6 +28,7 @@
 #include <sstream>
 
 #include <math/vector2d.h>
+#include <kiid.h>
 
 class SHAPE_LINE_CHAIN;
 class SHAPE;
@@ -39,12 +40,46 @@ class ITEM;
 class LOGGER
 {
 public:
+    ///> The calls made to the router by the interactive tools, in the order they came
+    enum EVENT_TYPE
+    {
+        EVT_START_ROUTE = 0,
+        EVT_START_DRAG,
+        EVT_FIX,
+        EVT_MOVE,
+        EVT_STOP
+    };
+
+    struct EVENT_ENTRY
+    {
+        EVENT_TYPE m_type;
+
+        ///> cursor position
+        VECTOR2I m_p;
+
+        ///> board item the router item under the cursor belongs to, niluuid if none
+        KIID m_uuid;
+
+        ///> start layer, drag mode or forced finish flag, depending on the type
+        int m_arg;
+    };
+
     LOGGER();
     ~LOGGER();
 
     void Save( const std::string& aFilename );
     void Clear();
 
+    ///> Events are only worth recording by the router when the log can be saved
+    void SetEnabled( bool aEnabled ) { m_enabled = aEnabled; }
+    bool IsEnabled() const { return m_enabled; }
+
+    /**
+     * Function Append()
+     * Adds the events and the item groups of another logger after the ones of this one.
+     */
+    void Append( const LOGGER& aOther );
+
     void NewGroup( const std::string& aName, int aIter = 0 );
     void EndGroup();
 
@@ -53,11 +88,25 @@ public:
     void Log( const VECTOR2I& aStart, const VECTOR2I& aEnd, int aKind = 0,
               const std::string& aName = std::string() );
 
+    void Log( EVENT_TYPE aEvent, const VECTOR2I& aPos, const ITEM* aItem = nullptr,
+              int aArg = 0 );
+
+    const std::vector<EVENT_ENTRY>& GetEvents() const { return m_events; }
+
+    /**
+     * Function LoadEvents()
+     * Reads the events of a log written by Save(), skipping the item groups.
+     * @return false if the file could not be read.
+     */
+    static bool LoadEvents( const std::string& aFilename, std::vector<EVENT_ENTRY>& aEvents );
+
 private:
     void dumpShape( const SHAPE* aSh );
 
     bool m_groupOpened;
+    bool m_enabled;
     std::stringstream m_theLog;
+    std::vector<EVENT_ENTRY> m_events;
 };
 
 }
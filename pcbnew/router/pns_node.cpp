@@ -21,6 +21,7 @@
 
 #include <vector>
 #include <cassert>
+#include <mutex>
 #include <utility>
 
 #include <math/vector2d.h>
@@ -41,9 +42,37 @@
 namespace PNS {
 
 #ifdef DEBUG
+// nodes are created and destroyed by the worker threads of the batch router too
+static std::mutex                allocNodesMutex;
 static std::unordered_set<NODE*> allocNodes;
 #endif
 
+
+/**
+ * Returns a structure shared by nodes, copied first if other nodes use it too. The nodes
+ * share their joints, overrides and index with the node they were branched from until one
+ * of them changes them.
+ */
+template <class T>
+static T& writable( std::shared_ptr<T>& aShared )
+{
+    if( aShared.use_count() > 1 )
+        aShared = std::make_shared<T>( *aShared );
+
+    return *aShared;
+}
+
+
+///> Returns an empty structure, shared by the nodes until they change it
+template <class T>
+static const std::shared_ptr<T>& emptyShared()
+{
+    static const std::shared_ptr<T> empty = std::make_shared<T>();
+
+    return empty;
+}
+
+
 NODE::NODE()
 {
     wxLogTrace( "PNS", "NODE::create %p", this );
@@ -52,9 +81,12 @@ NODE::NODE()
     m_parent = NULL;
     m_maxClearance = 800000;    // fixme: depends on how thick traces are.
     m_ruleResolver = NULL;
-    m_index = new INDEX;
+    m_index = emptyShared<INDEX>();
+    m_joints = emptyShared<JOINT_MAP>();
+    m_override = emptyShared<ITEM_HASH_SET>();
 
 #ifdef DEBUG
+    std::lock_guard<std::mutex> lock( allocNodesMutex );
     allocNodes.insert( this );
 #endif
 }
@@ -71,16 +103,20 @@ NODE::~NODE()
     }
 
 #ifdef DEBUG
-    if( allocNodes.find( this ) == allocNodes.end() )
     {
-        wxLogTrace( "PNS", "attempting to free an already-free'd node." );
-        assert( false );
-    }
+        std::lock_guard<std::mutex> lock( allocNodesMutex );
 
-    allocNodes.erase( this );
+        if( allocNodes.find( this ) == allocNodes.end() )
+        {
+            wxLogTrace( "PNS", "attempting to free an already-free'd node." );
+            assert( false );
+        }
+
+        allocNodes.erase( this );
+    }
 #endif
 
-    m_joints.clear();
+    m_joints.reset();
 
     for( ITEM* item : *m_index )
     {
@@ -90,8 +126,6 @@ NODE::~NODE()
 
     releaseGarbage();
     unlinkParent();
-
-    delete m_index;
 }
 
 int NODE::GetClearance( const ITEM* aA, const ITEM* aB ) const
@@ -117,21 +151,18 @@ NODE* NODE::Branch()
     child->m_root = isRoot() ? this : m_root;
     child->m_maxClearance = m_maxClearance;
 
-    // Immmediate offspring of the root branch needs not copy anything. For the rest, deep-copy
-    // joints, overridden item maps and pointers to stored items.
+    // Immmediate offspring of the root branch needs not copy anything. The rest share the
+    // joints, overridden item maps and pointers to stored items with this node, until either
+    // node changes them.
     if( !isRoot() )
     {
-        JOINT_MAP::iterator j;
-
-        for( ITEM* item : *m_index )
-            child->m_index->Add( item );
-
+        child->m_index = m_index;
         child->m_joints = m_joints;
         child->m_override = m_override;
     }
 
-    wxLogTrace( "PNS", "%d items, %d joints, %d overrides",
-            child->m_index->Size(), (int) child->m_joints.size(), (int) child->m_override.size() );
+    wxLogTrace( "PNS", "%d items, %d joints, %d overrides", child->m_index->Size(),
+            (int) child->m_joints->size(), (int) child->m_override->size() );
 
     return child;
 }
@@ -280,10 +311,6 @@ int NODE::QueryColliding( const ITEM* aItem, NODE::OBSTACLES& aObstacles, int aK
 {
     DEFAULT_OBSTACLE_VISITOR visitor( aObstacles, aItem, aKindMask, aDifferentNetsOnly );
 
-#ifdef DEBUG
-    assert( allocNodes.find( this ) != allocNodes.end() );
-#endif
-
     visitor.SetCountLimit( aLimitCount );
     visitor.SetWorld( this, NULL );
     visitor.m_forceClearance = aForceClearance;
@@ -541,7 +568,7 @@ void NODE::addSolid( SOLID* aSolid )
     if( aSolid->IsRoutable() )
         linkJoint( aSolid->Pos(), aSolid->Layers(), aSolid->Net(), aSolid );
 
-    m_index->Add( aSolid );
+    writable( m_index ).Add( aSolid );
 }
 
 void NODE::Add( std::unique_ptr< SOLID > aSolid )
@@ -553,7 +580,7 @@ void NODE::Add( std::unique_ptr< SOLID > aSolid )
 void NODE::addVia( VIA* aVia )
 {
     linkJoint( aVia->Pos(), aVia->Layers(), aVia->Net(), aVia );
-    m_index->Add( aVia );
+    writable( m_index ).Add( aVia );
 }
 
 void NODE::Add( std::unique_ptr< VIA > aVia )
@@ -614,7 +641,7 @@ void NODE::addSegment( SEGMENT* aSeg )
     linkJoint( aSeg->Seg().A, aSeg->Layers(), aSeg->Net(), aSeg );
     linkJoint( aSeg->Seg().B, aSeg->Layers(), aSeg->Net(), aSeg );
 
-    m_index->Add( aSeg );
+    writable( m_index ).Add( aSeg );
 }
 
 bool NODE::Add( std::unique_ptr< SEGMENT > aSegment, bool aAllowRedundant )
@@ -639,7 +666,7 @@ void NODE::addArc( ARC* aArc )
     linkJoint( aArc->Anchor( 0 ), aArc->Layers(), aArc->Net(), aArc );
     linkJoint( aArc->Anchor( 1 ), aArc->Layers(), aArc->Net(), aArc );
 
-    m_index->Add( aArc );
+    writable( m_index ).Add( aArc );
 }
 
 void NODE::Add( std::unique_ptr< ARC > aArc )
@@ -673,12 +700,12 @@ void NODE::doRemove( ITEM* aItem )
     // case 1: removing an item that is stored in the root node from any branch:
     // mark it as overridden, but do not remove
     if( aItem->BelongsTo( m_root ) && !isRoot() )
-        m_override.insert( aItem );
+        writable( m_override ).insert( aItem );
 
     // case 2: the item belongs to this branch or a parent, non-root branch,
     // or the root itself and we are the root: remove from the index
     else if( !aItem->BelongsTo( m_root ) || isRoot() )
-        m_index->Remove( aItem );
+        writable( m_index ).Remove( aItem );
 
     // the item belongs to this particular branch: un-reference it
     if( aItem->BelongsTo( this ) )
@@ -711,6 +738,7 @@ void NODE::rebuildJoint( JOINT* aJoint, ITEM* aItem )
     JOINT::LINKED_ITEMS links( aJoint->LinkList() );
     JOINT::HASH_TAG tag;
     int net = aItem->Net();
+    JOINT_MAP& joints = writable( m_joints );
 
     tag.net = net;
     tag.pos = aJoint->Pos();
@@ -719,9 +747,9 @@ void NODE::rebuildJoint( JOINT* aJoint, ITEM* aItem )
     do
     {
         split = false;
-        auto range = m_joints.equal_range( tag );
+        auto range = joints.equal_range( tag );
 
-        if( range.first == m_joints.end() )
+        if( range.first == joints.end() )
             break;
 
         // find and remove all joints containing the via to be removed
@@ -730,7 +758,7 @@ void NODE::rebuildJoint( JOINT* aJoint, ITEM* aItem )
         {
             if( aItem->LayersOverlap( &f->second ) )
             {
-                m_joints.erase( f );
+                joints.erase( f );
                 split = true;
                 break;
             }
@@ -1031,12 +1059,12 @@ JOINT* NODE::FindJoint( const VECTOR2I& aPos, int aLayer, int aNet )
     tag.net = aNet;
     tag.pos = aPos;
 
-    JOINT_MAP::iterator f = m_joints.find( tag ), end = m_joints.end();
+    JOINT_MAP::iterator f = m_joints->find( tag ), end = m_joints->end();
 
     if( f == end && !isRoot() )
     {
-        end = m_root->m_joints.end();
-        f = m_root->m_joints.find( tag );    // m_root->FindJoint(aPos, aLayer, aNet);
+        end = m_root->m_joints->end();
+        f = m_root->m_joints->find( tag );    // m_root->FindJoint(aPos, aLayer, aNet);
     }
 
     if( f == end )
@@ -1056,11 +1084,50 @@ JOINT* NODE::FindJoint( const VECTOR2I& aPos, int aLayer, int aNet )
 
 void NODE::LockJoint( const VECTOR2I& aPos, const ITEM* aItem, bool aLock )
 {
+    const JOINT* found = findTouchedJoint( aPos, aItem->Layers(), aItem->Net() );
+
+    if( found && found->IsLocked() == aLock )
+        return;
+
     JOINT& jt = touchJoint( aPos, aItem->Layers(), aItem->Net() );
     jt.Lock( aLock );
 }
 
 
+const JOINT* NODE::findTouchedJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers,
+                                     int aNet ) const
+{
+    JOINT::HASH_TAG tag;
+
+    tag.pos = aPos;
+    tag.net = aNet;
+
+    // touchJoint() only looks in the root for joints this node has none of at aPos
+    const JOINT_MAP* joints = m_joints.get();
+
+    if( !isRoot() && joints->find( tag ) == joints->end() )
+        joints = m_root->m_joints.get();
+
+    auto range = joints->equal_range( tag );
+
+    // The joints of a position are merged when their layers overlap, at most one can
+    for( auto f = range.first; f != range.second; ++f )
+    {
+        const LAYER_RANGE& layers = f->second.Layers();
+
+        if( layers.Overlaps( aLayers ) )
+        {
+            if( layers.Start() <= aLayers.Start() && layers.End() >= aLayers.End() )
+                return &f->second;
+
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+
 JOINT& NODE::touchJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers, int aNet )
 {
     JOINT::HASH_TAG tag;
@@ -1068,18 +1135,20 @@ JOINT& NODE::touchJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers, int a
     tag.pos = aPos;
     tag.net = aNet;
 
+    JOINT_MAP& joints = writable( m_joints );
+
     // try to find the joint in this node.
-    JOINT_MAP::iterator f = m_joints.find( tag );
+    JOINT_MAP::iterator f = joints.find( tag );
 
     std::pair<JOINT_MAP::iterator, JOINT_MAP::iterator> range;
 
     // not found and we are not root? find in the root and copy results here.
-    if( f == m_joints.end() && !isRoot() )
+    if( f == joints.end() && !isRoot() )
     {
-        range = m_root->m_joints.equal_range( tag );
+        range = m_root->m_joints->equal_range( tag );
 
         for( f = range.first; f != range.second; ++f )
-            m_joints.insert( *f );
+            joints.insert( *f );
     }
 
     // now insert and combine overlapping joints
@@ -1090,9 +1159,9 @@ JOINT& NODE::touchJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers, int a
     do
     {
         merged  = false;
-        range   = m_joints.equal_range( tag );
+        range   = joints.equal_range( tag );
 
-        if( range.first == m_joints.end() )
+        if( range.first == joints.end() )
             break;
 
         for( f = range.first; f != range.second; ++f )
@@ -1100,7 +1169,7 @@ JOINT& NODE::touchJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers, int a
             if( aLayers.Overlaps( f->second.Layers() ) )
             {
                 jt.Merge( f->second );
-                m_joints.erase( f );
+                joints.erase( f );
                 merged = true;
                 break;
             }
@@ -1108,7 +1177,7 @@ JOINT& NODE::touchJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers, int a
     }
     while( merged );
 
-    return m_joints.insert( TagJointPair( tag, jt ) )->second;
+    return joints.insert( TagJointPair( tag, jt ) )->second;
 }
 
 
@@ -1122,6 +1191,12 @@ void JOINT::Dump() const
 void NODE::linkJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers,
                           int aNet, ITEM* aWhere )
 {
+    // Only changes to the joints copy the joints shared with other nodes
+    const JOINT* found = findTouchedJoint( aPos, aLayers, aNet );
+
+    if( found && found->CLinks().Contains( aWhere ) )
+        return;
+
     JOINT& jt = touchJoint( aPos, aLayers, aNet );
 
     jt.Link( aWhere );
@@ -1131,6 +1206,11 @@ void NODE::linkJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers,
 void NODE::unlinkJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers,
                             int aNet, ITEM* aWhere )
 {
+    const JOINT* found = findTouchedJoint( aPos, aLayers, aNet );
+
+    if( found && !found->CLinks().Contains( aWhere ) )
+        return;
+
     // fixme: remove dangling joints
     JOINT& jt = touchJoint( aPos, aLayers, aNet );
 
@@ -1224,13 +1304,13 @@ void NODE::GetUpdatedItems( ITEM_VECTOR& aRemoved, ITEM_VECTOR& aAdded )
     if( isRoot() )
         return;
 
-    if( m_override.size() )
-        aRemoved.reserve( m_override.size() );
+    if( m_override->size() )
+        aRemoved.reserve( m_override->size() );
     
     if( m_index->Size() )
         aAdded.reserve( m_index->Size() );
 
-    for( ITEM* item : m_override )
+    for( ITEM* item : *m_override )
         aRemoved.push_back( item );
 
     for( INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
@@ -1270,7 +1350,7 @@ void NODE::Commit( NODE* aNode )
         if( aNode->isRoot() )
             return;
 
-        for( ITEM* item : aNode->m_override )
+        for( ITEM* item : *aNode->m_override )
             Remove( item );
 
         for( auto i : *aNode->m_index )
@@ -1410,7 +1490,7 @@ int NODE::QueryJoints( const BOX2I& aBox,
 
     aJoints.clear();
 
-    for( auto j = m_joints.begin(); j != m_joints.end(); ++j )
+    for( auto j = m_joints->begin(); j != m_joints->end(); ++j )
     {
         if ( aBox.Contains(j->second.Pos()) && j->second.LinkCount ( aKindMask ) )
         {
@@ -1423,7 +1503,7 @@ int NODE::QueryJoints( const BOX2I& aBox,
     if ( isRoot() )
         return n;
 
-    for( auto j = m_root->m_joints.begin(); j != m_root->m_joints.end(); ++j )
+    for( auto j = m_root->m_joints->begin(); j != m_root->m_joints->end(); ++j )
     {
         if( ! Overrides( &j->second) )
         {   if ( aBox.Contains(j->second.Pos()) && j->second.LinkCount ( aKindMask ) )
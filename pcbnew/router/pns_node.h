@@ -24,6 +24,7 @@
 
 #include <vector>
 #include <list>
+#include <memory>
 #include <unordered_set>
 #include <unordered_map>
 
@@ -181,7 +182,7 @@ public:
     ///> Returns the number of joints
     int JointCount() const
     {
-        return m_joints.size();
+        return m_joints->size();
     }
 
     ///> Returns the number of nodes in the inheritance chain (wrs to the root node)
@@ -433,18 +434,24 @@ public:
     ///> from the root branch.
     bool Overrides( ITEM* aItem ) const
     {
-        return m_override.find( aItem ) != m_override.end();
+        return m_override->find( aItem ) != m_override->end();
     }
 
 private:
     struct DEFAULT_OBSTACLE_VISITOR;
     typedef std::unordered_multimap<JOINT::HASH_TAG, JOINT, JOINT::JOINT_TAG_HASH> JOINT_MAP;
     typedef JOINT_MAP::value_type TagJointPair;
+    typedef std::unordered_set<ITEM*> ITEM_HASH_SET;
 
     /// nodes are not copyable
     NODE( const NODE& aB );
     NODE& operator=( const NODE& aB );
 
+    ///> finds the joint touchJoint() would change, if it exists and spans aLayers, without
+    ///> copying the joints shared with other nodes
+    const JOINT* findTouchedJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers,
+                                   int aNet ) const;
+
     ///> tries to find matching joint and creates a new one if not found
     JOINT& touchJoint( const VECTOR2I&     aPos,
                        const LAYER_RANGE&  aLayers,
@@ -492,8 +499,9 @@ private:
             LINKED_ITEM** aSegments, bool& aGuardHit, bool aStopAtLockedJoints );
 
     ///> hash table with the joints, linking the items. Joints are hashed by
-    ///> their position, layer set and net.
-    JOINT_MAP m_joints;
+    ///> their position, layer set and net. Like the overrides and the index, shared with the
+    ///> parent node until either of them changes it (copy-on-write).
+    std::shared_ptr<JOINT_MAP> m_joints;
 
     ///> node this node was branched from
     NODE* m_parent;
@@ -505,7 +513,7 @@ private:
     std::set<NODE*> m_children;
 
     ///> hash of root's items that have been changed in this node
-    std::unordered_set<ITEM*> m_override;
+    std::shared_ptr<ITEM_HASH_SET> m_override;
 
     ///> worst case item-item clearance
     int m_maxClearance;
@@ -514,7 +522,7 @@ private:
     RULE_RESOLVER* m_ruleResolver;
 
     ///> Geometric/Net index of the items
-    INDEX* m_index;
+    std::shared_ptr<INDEX> m_index;
 
     ///> depth of the node (number of parent nodes in the inheritance chain)
     int m_depth;
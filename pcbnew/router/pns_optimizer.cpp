@@ -24,6 +24,8 @@
 #include <geometry/shape_simple.h>
 #include <geometry/shape_file_io.h>
 
+#include <atomic>
+#include <chrono>
 #include <cmath>
 
 #include "pns_arc.h"
@@ -41,7 +43,6 @@
 namespace PNS {
 
 
-static DEBUG_DECORATOR *g_dbg;
 /**
  *  Cost Estimator Methods
  */
@@ -597,8 +598,50 @@ bool OPTIMIZER::mergeFull( LINE* aLine )
 }
 
 
+static std::atomic<uint64_t> s_passes( 0 );
+static std::atomic<uint64_t> s_passTime( 0 );
+
+
+/**
+ * Counts an optimization pass and its duration, for the benchmarks of the router
+ */
+class PASS_TIMER
+{
+public:
+    PASS_TIMER() :
+        m_start( std::chrono::steady_clock::now() )
+    {
+    }
+
+    ~PASS_TIMER()
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start );
+
+        s_passes.fetch_add( 1, std::memory_order_relaxed );
+        s_passTime.fetch_add( elapsed.count(), std::memory_order_relaxed );
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+
+OPTIMIZER::STATS OPTIMIZER::GetStats()
+{
+    STATS stats;
+
+    stats.m_passes = s_passes.load( std::memory_order_relaxed );
+    stats.m_time = s_passTime.load( std::memory_order_relaxed );
+
+    return stats;
+}
+
+
 bool OPTIMIZER::Optimize( LINE* aLine, LINE* aResult )
 {
+    PASS_TIMER timer;
+
     if( !aResult )
         aResult = aLine;
     else
@@ -1015,8 +1058,6 @@ bool OPTIMIZER::Optimize( LINE* aLine, int aEffortLevel, NODE* aWorld, const VEC
 {
     OPTIMIZER opt( aWorld );
 
-    g_dbg = ROUTER::GetInstance()->GetInterface()->GetDebugDecorator();
-
     opt.SetEffortLevel( aEffortLevel );
     opt.SetCollisionMask( -1 );
 
@@ -1293,6 +1334,8 @@ bool OPTIMIZER::mergeDpSegments( DIFF_PAIR* aPair )
 
 bool OPTIMIZER::Optimize( DIFF_PAIR* aPair )
 {
+    PASS_TIMER timer;
+
     return mergeDpSegments( aPair );
 }
 
@@ -22,6 +22,7 @@
 #ifndef __PNS_OPTIMIZER_H
 #define __PNS_OPTIMIZER_H
 
+#include <cstdint>
 #include <unordered_map>
 #include <memory>
 
@@ -105,6 +106,15 @@ public:
         PRESERVE_VERTEX = 0x20
     };
 
+    struct STATS
+    {
+        ///> number of lines and diff pairs optimized
+        uint64_t m_passes;
+
+        ///> time spent optimizing them, in nanoseconds
+        uint64_t m_time;
+    };
+
     OPTIMIZER( NODE* aWorld );
     ~OPTIMIZER();
 
@@ -114,6 +124,8 @@ public:
     bool Optimize( LINE* aLine, LINE* aResult = NULL );
     bool Optimize( DIFF_PAIR* aPair );
 
+    ///> Returns the counters of the optimization passes since the start of the program
+    static STATS GetStats();
 
     void SetWorld( NODE* aNode ) { m_world = aNode; }
     void CacheStaticItem( ITEM* aItem );
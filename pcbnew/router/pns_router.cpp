@@ -55,6 +55,7 @@
 #include "pns_meander_placer.h"
 #include "pns_meander_skew_placer.h"
 #include "pns_dp_meander_placer.h"
+#include "pns_logger.h"
 
 namespace PNS {
 
@@ -77,6 +78,12 @@ ROUTER::ROUTER()
     m_snapshotIter = 0;
     m_violation = false;
     m_iface = nullptr;
+    m_logger = std::make_unique<LOGGER>();
+
+#ifdef DEBUG
+    // Only the debug builds of the router tool save the log
+    m_logger->SetEnabled( true );
+#endif
 }
 
 
@@ -139,6 +146,10 @@ bool ROUTER::StartDragging( const VECTOR2I& aP, ITEM_SET aStartItems, int aDragM
     if( aStartItems.Empty() )
         return false;
 
+    m_logger->Clear();
+    if( m_logger->IsEnabled() )
+        m_logger->Log( LOGGER::EVT_START_DRAG, aP, aStartItems[0], aDragMode );
+
     if( aStartItems.Count( ITEM::SOLID_T ) == aStartItems.Size() )
     {
         m_dragger = std::make_unique<COMPONENT_DRAGGER>( this );
@@ -189,7 +200,10 @@ bool ROUTER::isStartingPointRoutable( const VECTOR2I& aWhere, int aLayer )
 }
 
 bool ROUTER::StartRouting( const VECTOR2I& aP, ITEM* aStartItem, int aLayer )
-{   
+{
+    m_logger->Clear();
+    if( m_logger->IsEnabled() )
+        m_logger->Log( LOGGER::EVT_START_ROUTE, aP, aStartItem, aLayer );
 
     if( ! isStartingPointRoutable( aP, aLayer ) )
     {
@@ -245,6 +259,9 @@ void ROUTER::DisplayItems( const ITEM_SET& aItems )
 
 void ROUTER::Move( const VECTOR2I& aP, ITEM* endItem )
 {
+    if( m_logger->IsEnabled() )
+        m_logger->Log( LOGGER::EVT_MOVE, aP, endItem );
+
     m_currentEnd = aP;
 
     switch( m_state )
@@ -392,6 +409,9 @@ bool ROUTER::FixRoute( const VECTOR2I& aP, ITEM* aEndItem, bool aForceFinish )
 {
     bool rv = false;
 
+    if( m_logger->IsEnabled() )
+        m_logger->Log( LOGGER::EVT_FIX, aP, aEndItem, aForceFinish );
+
     switch( m_state )
     {
     case ROUTE_TRACK:
@@ -445,6 +465,9 @@ void ROUTER::StopRouting()
     if( !RoutingInProgress() )
         return;
 
+    if( m_logger->IsEnabled() )
+        m_logger->Log( LOGGER::EVT_STOP, m_currentEnd );
+
     m_placer.reset();
     m_dragger.reset();
 
@@ -507,6 +530,7 @@ int ROUTER::GetCurrentLayer() const
 
 void ROUTER::DumpLog()
 {
+    LOGGER  log;
     LOGGER* logger = nullptr;
 
     switch( m_state )
@@ -523,8 +547,12 @@ void ROUTER::DumpLog()
         break;
     }
 
+    log.Append( *m_logger );
+
     if( logger )
-        logger->Save( "/tmp/shove.log" );
+        log.Append( *logger );
+
+    log.Save( "/tmp/shove.log" );
 }
 
 
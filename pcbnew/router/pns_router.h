@@ -63,6 +63,7 @@ class RULE_RESOLVER;
 class SHOVE;
 class DRAGGER;
 class DRAG_ALGO;
+class LOGGER;
 
 enum ROUTER_MODE {
     PNS_MODE_ROUTE_SINGLE = 1,
@@ -169,8 +170,19 @@ public:
     int GetCurrentLayer() const;
     const std::vector<int> GetCurrentNets() const;
 
+    /**
+     * Function DumpLog()
+     * Saves the events of the last routing or dragging session, followed by the items
+     * logged by the algorithm in use, to /tmp/shove.log.
+     */
     void DumpLog();
 
+    ///> Returns the logger recording the events of the current (or last) session
+    LOGGER* Logger() const
+    {
+        return m_logger.get();
+    }
+
     RULE_RESOLVER* GetRuleResolver() const
     {
         return m_iface->GetRuleResolver();
@@ -268,6 +280,7 @@ private:
     std::unique_ptr< PLACEMENT_ALGO > m_placer;
     std::unique_ptr< DRAG_ALGO >        m_dragger;
     std::unique_ptr< SHOVE >          m_shove;
+    std::unique_ptr< LOGGER >         m_logger;
 
     ROUTER_IFACE* m_iface;
 
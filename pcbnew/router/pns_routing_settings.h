@@ -132,6 +132,15 @@ public:
     int WalkaroundIterationLimit() const { return m_walkaroundIterationLimit; };
     TIME_LIMIT WalkaroundTimeLimit() const;
 
+    ///> Returns true if the candidate paths of the walkaround are searched concurrently.
+    ///> Each direction then gets the whole time limit, so when it expires the paths found
+    ///> differ from those of the sequential search.  The line placer then also finishes
+    ///> both paths and keeps the cheaper one, instead of only finishing the shorter one.
+    bool ParallelSearch() const { return m_parallelSearch; }
+
+    ///> Enables the concurrent search of the candidate paths of the walkaround.
+    void SetParallelSearch( bool aEnable ) { m_parallelSearch = aEnable; }
+
     void SetInlineDragEnabled ( bool aEnable ) { m_inlineDragEnabled = aEnable; }
     bool InlineDragEnabled() const { return m_inlineDragEnabled; }
 
@@ -182,6 +191,7 @@ private:
     bool m_snapToPads;
     bool m_roundedCorners;
     bool m_optimizeDraggedTrack;
+    bool m_parallelSearch;
 
     int m_minRadius;
     int m_maxRadius;
@@ -23,6 +23,8 @@
 
 #include <geometry/shape_line_chain.h>
 
+#include <thread_pool.h>
+
 #include "pns_walkaround.h"
 #include "pns_optimizer.h"
 #include "pns_utils.h"
@@ -57,6 +59,8 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
 {
     OPT<OBSTACLE>& current_obs =
         aWindingDirection ? m_currentObstacle[0] : m_currentObstacle[1];
+    int& blockage_count =
+        aWindingDirection ? m_recursiveBlockageCount[0] : m_recursiveBlockageCount[1];
 
     if( !current_obs )
         return DONE;
@@ -67,9 +71,9 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
 
     if( ( current_obs->m_hull ).PointInside( last ) || ( current_obs->m_hull ).PointOnEdge( last ) )
     {
-        m_recursiveBlockageCount++;
+        blockage_count++;
 
-        if( m_recursiveBlockageCount < 3 )
+        if( blockage_count < 3 )
             aPath.Line().Append( current_obs->m_hull.NearestPoint( last ) );
         else
         {
@@ -153,7 +157,7 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
 
 
 
-bool clipToLoopStart( SHAPE_LINE_CHAIN& l )
+bool clipToLoopStart( SHAPE_LINE_CHAIN& l, DEBUG_DECORATOR* aDbg )
 {
     auto ip = l.SelfIntersecting();
 
@@ -166,8 +170,8 @@ bool clipToLoopStart( SHAPE_LINE_CHAIN& l )
 
         int pidx2 = tail.Split( ip->p );
         
-        auto dbg = ROUTER::GetInstance()->GetInterface()->GetDebugDecorator();
-        dbg->AddPoint( ip->p, 5 );
+        if( aDbg )
+            aDbg->AddPoint( ip->p, 5 );
         
         l = lead;
         l.Append( tail.Slice( 0, pidx2 ) );
@@ -180,8 +184,42 @@ bool clipToLoopStart( SHAPE_LINE_CHAIN& l )
 
 
 
+const WALKAROUND::RESULT WALKAROUND::routeParallel( const LINE& aInitialPath )
+{
+    // Each direction is walked by a copy of this walker, forced to its winding. The copies
+    // don't report to the debug decorator and the logger, which are not thread safe.
+    WALKAROUND walkCw( *this ), walkCcw( *this );
+    RESULT     resultCw, resultCcw;
+
+    for( WALKAROUND* walk : { &walkCw, &walkCcw } )
+    {
+        walk->SetDebugDecorator( nullptr );
+        walk->SetLogger( nullptr );
+        walk->SetParallel( false );
+    }
+
+    walkCw.SetForceWinding( true, true );
+    walkCcw.SetForceWinding( true, false );
+
+    TASK_GROUP group;
+
+    group.Run( [&]()
+               {
+                   resultCcw = walkCcw.Route( aInitialPath );
+               } );
+
+    resultCw = walkCw.Route( aInitialPath );
+    group.Wait();
+
+    return RESULT( resultCw.statusCw, resultCcw.statusCcw, resultCw.lineCw, resultCcw.lineCcw );
+}
+
+
 const WALKAROUND::RESULT WALKAROUND::Route( const LINE& aInitialPath )
 {
+    if( m_parallel && !m_forceWinding && aInitialPath.PointCount() > 1 )
+        return routeParallel( aInitialPath );
+
     LINE path_cw( aInitialPath ), path_ccw( aInitialPath );
     WALKAROUND_STATUS s_cw = IN_PROGRESS, s_ccw = IN_PROGRESS;
     SHAPE_LINE_CHAIN best_path;
@@ -199,7 +237,7 @@ const WALKAROUND::RESULT WALKAROUND::Route( const LINE& aInitialPath )
     start( aInitialPath );
 
     m_currentObstacle[0] = m_currentObstacle[1] = nearestObstacle( aInitialPath );
-    m_recursiveBlockageCount = 0;
+    m_recursiveBlockageCount[0] = m_recursiveBlockageCount[1] = 0;
 
     result.lineCw = aInitialPath;
     result.lineCcw = aInitialPath;
@@ -228,14 +266,14 @@ const WALKAROUND::RESULT WALKAROUND::Route( const LINE& aInitialPath )
         
         auto old = path_cw.CLine();
 
-        if( clipToLoopStart( path_cw.Line() ))
+        if( clipToLoopStart( path_cw.Line(), Dbg() ) )
         {
             //printf("ClipCW\n");
             //Dbg()->AddLine( old, 1, 40000 );
             s_cw = ALMOST_DONE;
         }
 
-        if( clipToLoopStart( path_ccw.Line() ))
+        if( clipToLoopStart( path_ccw.Line(), Dbg() ) )
         {
             //printf("ClipCCW\n");
             s_ccw = ALMOST_DONE;
@@ -258,6 +296,9 @@ const WALKAROUND::RESULT WALKAROUND::Route( const LINE& aInitialPath )
             break;
 
         m_iteration++;
+
+        if( m_timeLimit && m_timeLimit->Expired() )
+            break;
     }
 
     if( s_cw == IN_PROGRESS )
@@ -320,7 +361,7 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::Route( const LINE& aInitialPath,
     start( aInitialPath );
 
     m_currentObstacle[0] = m_currentObstacle[1] = nearestObstacle( aInitialPath );
-    m_recursiveBlockageCount = 0;
+    m_recursiveBlockageCount[0] = m_recursiveBlockageCount[1] = 0;
 
     aWalkPath = aInitialPath;
 
@@ -29,6 +29,7 @@
 #include "pns_router.h"
 #include "pns_logger.h"
 #include "pns_algo_base.h"
+#include "time_limit.h"
 
 namespace PNS {
 
@@ -49,11 +50,13 @@ public:
         m_itemMask = ITEM::ANY_T;
 
         // Initialize other members, to avoid uninitialized variables.
-        m_recursiveBlockageCount = 0;
+        m_recursiveBlockageCount[0] = m_recursiveBlockageCount[1] = 0;
         m_recursiveCollision[0] = m_recursiveCollision[1] = false;
         m_iteration = 0;
         m_forceCw = false;
         m_forceUniqueWindingDirection = false;
+        m_parallel = false;
+        m_timeLimit = nullptr;
     }
 
     ~WALKAROUND() {};
@@ -126,6 +129,32 @@ public:
         m_forceWinding = aEnabled;
     }
 
+    /**
+     * Function SetParallel()
+     * Walks the two winding directions at the same time, on the workers of the thread pool,
+     * when looking for both paths around the obstacles.
+     */
+    void SetParallel( bool aEnabled )
+    {
+        m_parallel = aEnabled;
+    }
+
+    /**
+     * Function SetTimeLimit()
+     * Stops the search for both paths when aLimit expires, the paths found so far being
+     * returned as ALMOST_DONE. The limit can be shared with other searches running at the
+     * same time.
+     *
+     * The search stops after a number of iterations that depends on the machine load, so
+     * when the limit expires the paths found are not reproducible, and differ between the
+     * sequential and the parallel walks. Only the iteration limit bounds the search
+     * deterministically.
+     */
+    void SetTimeLimit( const TIME_LIMIT* aLimit )
+    {
+        m_timeLimit = aLimit;
+    }
+
     void RestrictToSet( bool aEnabled, const std::set<ITEM*>& aSet )
     {
         if( aEnabled )
@@ -142,12 +171,14 @@ public:
 private:
     void start( const LINE& aInitialPath );
 
+    const RESULT routeParallel( const LINE& aInitialPath );
+
     WALKAROUND_STATUS singleStep( LINE& aPath, bool aWindingDirection );
     NODE::OPT_OBSTACLE nearestObstacle( const LINE& aPath );
 
     NODE* m_world;
 
-    int m_recursiveBlockageCount;
+    int m_recursiveBlockageCount[2];
     int m_iteration;
     int m_iterationLimit;
     int m_itemMask;
@@ -156,6 +187,8 @@ private:
     bool m_forceWinding;
     bool m_forceCw;
     bool m_forceUniqueWindingDirection;
+    bool m_parallel;
+    const TIME_LIMIT* m_timeLimit;
     VECTOR2I m_cursorPos;
     NODE::OPT_OBSTACLE m_currentObstacle[2];
     bool m_recursiveCollision[2];
@@ -53,6 +53,7 @@ using namespace std::placeholders;
 #include "pns_segment.h"
 #include "pns_router.h"
 #include "pns_itemset.h"
+#include "pns_item_pool.h"
 
 using namespace KIGFX;
 
@@ -462,6 +463,25 @@ void ROUTER_TOOL::Reset( RESET_REASON aReason )
 }
 
 
+/**
+ * Traces the router items allocated since the previous call, and how many of them needed
+ * a heap allocation: none should, once the item pool has grown to the needs of the session.
+ */
+static void traceItemAllocations( const char* aWhat )
+{
+    static PNS::ITEM_POOL::STATS previous = PNS::ITEM_POOL::GetStats();
+
+    PNS::ITEM_POOL::STATS stats = PNS::ITEM_POOL::GetStats();
+
+    wxLogTrace( "PNS", "%s: %llu items allocated, %llu heap allocations, %llu kB in item pool",
+                aWhat, (unsigned long long) ( stats.m_items - previous.m_items ),
+                (unsigned long long) ( stats.m_heapAllocations - previous.m_heapAllocations ),
+                (unsigned long long) ( stats.m_chunkBytes / 1024 ) );
+
+    previous = stats;
+}
+
+
 void ROUTER_TOOL::handleCommonEvents( const TOOL_EVENT& aEvent )
 {
 #ifdef DEBUG
@@ -771,6 +791,8 @@ void ROUTER_TOOL::performRouting()
     if( !prepareInteractive() )
         return;
 
+    traceItemAllocations( "start routing" );
+
     while( TOOL_EVENT* evt = Wait() )
     {
         frame()->GetCanvas()->SetCurrentCursor( wxCURSOR_PENCIL );
@@ -785,6 +807,7 @@ void ROUTER_TOOL::performRouting()
             m_router->SetOrthoMode( evt->Modifier( MD_CTRL ) );
             updateEndItem( *evt );
             m_router->Move( m_endSnapPoint, m_endItem );
+            traceItemAllocations( "route" );
         }
         else if( evt->IsAction( &ACT_UndoLastSegment ) )
         {
@@ -1051,6 +1074,8 @@ void ROUTER_TOOL::performDragging( int aMode )
     if( !dragStarted )
         return;
 
+    traceItemAllocations( "start dragging" );
+
     if( m_startItem && m_startItem->Net() >= 0 )
         highlightNet( true, m_startItem->Net() );
 
@@ -1066,6 +1091,7 @@ void ROUTER_TOOL::performDragging( int aMode )
         {
             updateEndItem( *evt );
             m_router->Move( m_endSnapPoint, m_endItem );
+            traceItemAllocations( "drag" );
         }
         else if( evt->IsClick( BUT_LEFT ) )
         {
@@ -67,6 +67,7 @@ void ZONE_FILLER_TOOL::CheckAllZones( wxWindow* aCaller )
 
     ZONE_FILLER filler( frame()->GetBoard(), &commit );
     filler.InstallNewProgressReporter( aCaller, _( "Checking Zones" ), 4 );
+    filler.SetIncremental( true );
 
     if( filler.Fill( toFill, true ) )
     {
@@ -94,6 +95,7 @@ void ZONE_FILLER_TOOL::FillAllZones( wxWindow* aCaller )
 
     ZONE_FILLER filler( board(), &commit );
     filler.InstallNewProgressReporter( aCaller, _( "Fill All Zones" ),  4 );
+    filler.SetIncremental( true );
 
     if( filler.Fill( toFill ) )
         getEditFrame<PCB_EDIT_FRAME>()->m_ZoneFillsDirty = false;
@@ -49,6 +49,7 @@ using namespace std::placeholders;
 #include <tools/selection_tool.h>
 #include <tools/pcbnew_control.h>
 #include <tools/pcb_editor_control.h>
+#include <drc/drc.h>
 #include <view/view.h>
 #include <ws_proxy_undo_item.h>
 
@@ -397,6 +398,9 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
     auto view = GetCanvas()->GetView();
     auto connectivity = GetBoard()->GetConnectivity();
 
+    // The DRC keeps its index of the copper items up to date with the board
+    DRC* drcTool = IsType( FRAME_PCB_EDITOR ) ? m_toolManager->GetTool<DRC>() : nullptr;
+
     // Undo in the reverse order of list creation: (this can allow stacked changes
     // like the same item can be changes and deleted in the same complex command
 
@@ -475,11 +479,18 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
 
             view->Add( eda_item );
             connectivity->Add( item );
+
+            if( drcTool )
+                drcTool->ItemChanged( item );
         }
         break;
 
         case UR_NEW:        /* new items are deleted */
             aList->SetPickedItemStatus( UR_DELETED, ii );
+
+            if( drcTool )
+                drcTool->ItemRemoved( (BOARD_ITEM*) eda_item );
+
             GetModel()->Remove( (BOARD_ITEM*) eda_item );
             view->Remove( eda_item );
             break;
@@ -488,6 +499,10 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
             aList->SetPickedItemStatus( UR_NEW, ii );
             GetModel()->Add( (BOARD_ITEM*) eda_item );
             view->Add( eda_item );
+
+            if( drcTool )
+                drcTool->ItemChanged( (BOARD_ITEM*) eda_item );
+
             break;
 
         case UR_MOVED:
@@ -496,6 +511,9 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
             item->Move( aRedoCommand ? aList->m_TransformPoint : -aList->m_TransformPoint );
             view->Update( item, KIGFX::GEOMETRY );
             connectivity->Update( item );
+
+            if( drcTool )
+                drcTool->ItemChanged( item );
         }
             break;
 
@@ -506,6 +524,9 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
                           aRedoCommand ? m_rotationAngle : -m_rotationAngle );
             view->Update( item, KIGFX::GEOMETRY );
             connectivity->Update( item );
+
+            if( drcTool )
+                drcTool->ItemChanged( item );
         }
             break;
 
@@ -516,6 +537,9 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
                           aRedoCommand ? -m_rotationAngle : m_rotationAngle );
             view->Update( item, KIGFX::GEOMETRY );
             connectivity->Update( item );
+
+            if( drcTool )
+                drcTool->ItemChanged( item );
         }
             break;
 
@@ -525,6 +549,9 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
             item->Flip( aList->m_TransformPoint, m_Settings->m_FlipLeftRight );
             view->Update( item, KIGFX::LAYERS );
             connectivity->Update( item );
+
+            if( drcTool )
+                drcTool->ItemChanged( item );
         }
             break;
 
@@ -23,9 +23,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
-#include <thread>
 #include <algorithm>
-#include <future>
+#include <cmath>
 
 #include <class_board.h>
 #include <class_zone.h>
@@ -45,6 +44,8 @@
 #include <confirm.h>
 #include <convert_to_biu.h>
 #include <math/util.h>      // for KiROUND
+#include <thread_pool.h>
+#include <advanced_config.h>
 
 #include "zone_filler.h"
 
@@ -78,6 +79,8 @@ ZONE_FILLER::ZONE_FILLER(  BOARD* aBoard, COMMIT* aCommit ) :
     m_board( aBoard ),
     m_brdOutlinesValid( false ),
     m_commit( aCommit ),
+    m_incremental( false ),
+    m_dependencyMargin( 0 ),
     m_progressReporter( nullptr ),
     m_high_def( 9 ),
     m_low_def( 6 )
@@ -119,10 +122,76 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
     m_boardOutline.RemoveAllContours();
     m_brdOutlinesValid = m_board->GetBoardPolygonOutlines( m_boardOutline );
 
+    std::vector<ZONE_CONTAINER*> candidates;
+
     for( auto zone : aZones )
     {
         // Keepout zones are not filled
-        if( zone->GetIsKeepout() )
+        if( !zone->GetIsKeepout() )
+            candidates.push_back( zone );
+    }
+
+    std::vector<MD5_HASH> dependencies( candidates.size() );
+    std::vector<bool>     refill( candidates.size(), true );
+
+    if( m_incremental )
+    {
+        buildDependencyIndex();
+
+        ParallelFor( 0, candidates.size(),
+                     [&]( size_t i )
+                     {
+                         dependencies[i] = buildFillDependencies( candidates[i] );
+                     } );
+
+        m_dependencyItems.clear();
+        m_dependencyTree.reset();
+
+        for( size_t i = 0; i < candidates.size(); ++i )
+        {
+            ZONE_CONTAINER* zone = candidates[i];
+
+            refill[i] = !zone->IsFilled() || zone->NeedRefill()
+                        || !zone->GetFillDependencies().IsValid()
+                        || zone->GetFillDependencies() != dependencies[i];
+        }
+
+        // Islands are kept or removed depending on what they touch, and that includes the fill
+        // of other zones of the same net.  Refill those too when they overlap a refilled zone.
+        bool changed = true;
+
+        while( changed )
+        {
+            changed = false;
+
+            for( size_t i = 0; i < candidates.size(); ++i )
+            {
+                if( !refill[i] || candidates[i]->GetNetCode() <= 0 )
+                    continue;
+
+                EDA_RECT bbox = candidates[i]->GetBoundingBox();
+
+                for( size_t j = 0; j < candidates.size(); ++j )
+                {
+                    if( refill[j] || candidates[j]->GetNetCode() != candidates[i]->GetNetCode() )
+                        continue;
+
+                    if( candidates[j]->CommonLayerExists( candidates[i]->GetLayerSet() )
+                            && candidates[j]->GetBoundingBox().Intersects( bbox ) )
+                    {
+                        refill[j] = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    for( size_t i = 0; i < candidates.size(); ++i )
+    {
+        ZONE_CONTAINER* zone = candidates[i];
+
+        if( !refill[i] )
             continue;
 
         if( m_commit )
@@ -131,6 +200,7 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         // calculate the hash value for filled areas. it will be used later
         // to know if the current filled areas are up to date
         zone->BuildHashValue();
+        zone->SetFillDependencies( dependencies[i] );
 
         // Add the zone to the list of zones to test or refill
         toFill.emplace_back( CN_ZONE_ISOLATED_ISLAND_LIST(zone) );
@@ -140,54 +210,32 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         zone->UnFill();
     }
 
-    std::atomic<size_t> nextItem( 0 );
-    size_t              parallelThreadCount =
-            std::min<size_t>( std::thread::hardware_concurrency(), aZones.size() );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
+    // Nothing changed since the last fill
+    if( toFill.empty() )
+        return true;
 
-    auto fill_lambda = [&] ( PROGRESS_REPORTER* aReporter ) -> size_t
+    auto fill_lambda = [&]( size_t i )
     {
-        size_t num = 0;
+        ZONE_CONTAINER* zone = toFill[i].m_zone;
+        zone->SetFilledPolysUseThickness( filledPolyWithOutline );
+        SHAPE_POLY_SET rawPolys, finalPolys;
+        fillSingleZone( zone, rawPolys, finalPolys );
 
-        for( size_t i = nextItem++; i < toFill.size(); i = nextItem++ )
-        {
-            ZONE_CONTAINER* zone = toFill[i].m_zone;
-            zone->SetFilledPolysUseThickness( filledPolyWithOutline );
-            SHAPE_POLY_SET rawPolys, finalPolys;
-            fillSingleZone( zone, rawPolys, finalPolys );
-
-            zone->SetRawPolysList( rawPolys );
-            zone->SetFilledPolysList( finalPolys );
-            zone->SetIsFilled( true );
+        zone->SetRawPolysList( rawPolys );
+        zone->SetFilledPolysList( finalPolys );
+        zone->SetIsFilled( true );
 
-            if( m_progressReporter )
-                m_progressReporter->AdvanceProgress();
-
-            num++;
-        }
-
-        return num;
+        if( m_progressReporter )
+            m_progressReporter->AdvanceProgress();
     };
 
-    if( parallelThreadCount <= 1 )
-        fill_lambda( m_progressReporter );
-    else
+    // Zones vary wildly in cost, so hand them out one at a time
+    if( !ParallelFor( 0, toFill.size(), fill_lambda, m_progressReporter, 1 ) )
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, fill_lambda, m_progressReporter );
-
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            // Here we balance returns with a 100ms timeout to allow UI updating
-            std::future_status status;
-            do
-            {
-                if( m_progressReporter )
-                    m_progressReporter->KeepRefreshing();
+        if( m_commit )
+            m_commit->Revert();
 
-                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-            } while( status != std::future_status::ready );
-        }
+        return false;
     }
 
     // Now update the connectivity to check for copper islands
@@ -275,44 +323,15 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
     }
 
 
-    nextItem = 0;
-
-    auto tri_lambda = [&] ( PROGRESS_REPORTER* aReporter ) -> size_t
+    auto tri_lambda = [&]( size_t i )
     {
-        size_t num = 0;
+        toFill[i].m_zone->CacheTriangulation();
 
-        for( size_t i = nextItem++; i < toFill.size(); i = nextItem++ )
-        {
-            toFill[i].m_zone->CacheTriangulation();
-            num++;
-
-            if( m_progressReporter )
-                m_progressReporter->AdvanceProgress();
-        }
-
-        return num;
+        if( m_progressReporter )
+            m_progressReporter->AdvanceProgress();
     };
 
-    if( parallelThreadCount <= 1 )
-        tri_lambda( m_progressReporter );
-    else
-    {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, tri_lambda, m_progressReporter );
-
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            // Here we balance returns with a 100ms timeout to allow UI updating
-            std::future_status status;
-            do
-            {
-                if( m_progressReporter )
-                    m_progressReporter->KeepRefreshing();
-
-                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-            } while( status != std::future_status::ready );
-        }
-    }
+    ParallelFor( 0, toFill.size(), tri_lambda, m_progressReporter, 1 );
 
     if( m_progressReporter )
     {
@@ -505,8 +524,8 @@ void ZONE_FILLER::knockoutThermalReliefs( const ZONE_CONTAINER* aZone, SHAPE_POL
         }
     }
 
-    holes.Simplify( SHAPE_POLY_SET::PM_FAST );
-    aFill.BooleanSubtract( holes, SHAPE_POLY_SET::PM_FAST );
+    simplify( holes );
+    subtract( aFill, holes );
 }
 
 
@@ -676,7 +695,357 @@ void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_
         zone->TransformOutlinesShapeWithClearanceToPolygon( aHoles, minClearance, useNetClearance );
     }
 
-    aHoles.Simplify( SHAPE_POLY_SET::PM_FAST );
+    simplify( aHoles );
+}
+
+
+static int countContours( const SHAPE_POLY_SET& aPolys )
+{
+    int count = 0;
+
+    for( int ii = 0; ii < aPolys.OutlineCount(); ++ii )
+        count += (int) aPolys.CPolygon( ii ).size();
+
+    return count;
+}
+
+
+int ZONE_FILLER::partitionTiles( int aContours ) const
+{
+    int threshold = ADVANCED_CFG::GetCfg().m_zoneFillPartitionContours;
+
+    if( threshold <= 0 || aContours < threshold )
+        return 0;
+
+    // About 500 contours per tile.  This must not depend on the number of threads: the
+    // vertices created at the tile borders would make the fills differ between machines.
+    int tiles = KiROUND( std::ceil( std::sqrt( aContours / 500.0 ) ) );
+
+    return std::min( std::max( tiles, 2 ), 32 );
+}
+
+
+static void runTiles( size_t aCount, const std::function<void( size_t )>& aTask )
+{
+    ParallelFor( 0, aCount, aTask, nullptr, 1 );
+}
+
+
+void ZONE_FILLER::subtract( SHAPE_POLY_SET& aPolys, const SHAPE_POLY_SET& aHoles ) const
+{
+    int tiles = partitionTiles( countContours( aPolys ) + countContours( aHoles ) );
+
+    if( tiles )
+        aPolys.BooleanSubtractPartitioned( aHoles, SHAPE_POLY_SET::PM_FAST, tiles, runTiles );
+    else
+        aPolys.BooleanSubtract( aHoles, SHAPE_POLY_SET::PM_FAST );
+}
+
+
+void ZONE_FILLER::simplify( SHAPE_POLY_SET& aPolys ) const
+{
+    int tiles = partitionTiles( countContours( aPolys ) );
+
+    if( tiles )
+        aPolys.SimplifyPartitioned( SHAPE_POLY_SET::PM_FAST, tiles, runTiles );
+    else
+        aPolys.Simplify( SHAPE_POLY_SET::PM_FAST );
+}
+
+
+static void hashPolySet( MD5_HASH& aHash, const SHAPE_POLY_SET& aPolySet )
+{
+    aHash.Hash( aPolySet.OutlineCount() );
+
+    for( int ii = 0; ii < aPolySet.OutlineCount(); ++ii )
+    {
+        const SHAPE_POLY_SET::POLYGON& polygon = aPolySet.CPolygon( ii );
+
+        aHash.Hash( (int) polygon.size() );
+
+        for( const SHAPE_LINE_CHAIN& chain : polygon )
+        {
+            aHash.Hash( chain.PointCount() );
+
+            for( int jj = 0; jj < chain.PointCount(); jj++ )
+            {
+                aHash.Hash( chain.CPoint( jj ).x );
+                aHash.Hash( chain.CPoint( jj ).y );
+            }
+        }
+    }
+}
+
+
+/**
+ * The dependency region is the same clearance-inflated bounding box as the one used by
+ * buildCopperItemClearances(), and items are matched against it with their own clearance or
+ * thermal gap so that everything knocking out, connecting to or isolating copper is seen.
+ * Items of any net are taken into account: the same net items decide which islands are kept.
+ */
+MD5_HASH ZONE_FILLER::buildFillDependencies( ZONE_CONTAINER* aZone )
+{
+    BOARD_DESIGN_SETTINGS& bds = m_board->GetDesignSettings();
+    PCB_LAYER_ID           layer = aZone->GetLayer();
+    int                    extra_margin = Millimeter2iu( 0.002 );
+    int                    zone_clearance = aZone->GetClearance();
+    MD5_HASH               hash;
+
+    EDA_RECT zone_boundingbox = aZone->GetBoundingBox();
+    int biggest_clearance = bds.GetBiggestClearanceValue();
+    biggest_clearance = std::max( biggest_clearance, zone_clearance ) + extra_margin;
+    zone_boundingbox.Inflate( biggest_clearance );
+
+    // The zone itself
+    //
+    hashPolySet( hash, *aZone->Outline() );
+    hash.Hash( layer );
+    hash.Hash( aZone->GetNetCode() );
+    hash.Hash( aZone->GetPriority() );
+    hash.Hash( zone_clearance );
+    hash.Hash( aZone->GetZoneClearance() );
+    hash.Hash( aZone->GetMinThickness() );
+    hash.Hash( (int) aZone->GetPadConnection() );
+    hash.Hash( aZone->GetThermalReliefGap() );
+    hash.Hash( aZone->GetThermalReliefCopperBridge() );
+    hash.Hash( (int) aZone->GetFillMode() );
+    hash.Hash( aZone->GetHatchFillTypeThickness() );
+    hash.Hash( aZone->GetHatchFillTypeGap() );
+    hash.Hash( KiROUND( aZone->GetHatchFillTypeOrientation() * 10.0 ) );
+    hash.Hash( aZone->GetHatchFillTypeSmoothingLevel() );
+    hash.Hash( KiROUND( aZone->GetHatchFillTypeSmoothingValue() * 1000.0 ) );
+    hash.Hash( aZone->GetCornerSmoothingType() );
+    hash.Hash( (int) aZone->GetCornerRadius() );
+
+    // Board wide settings
+    //
+    hash.Hash( biggest_clearance );
+    hash.Hash( bds.m_CopperEdgeClearance );
+    hash.Hash( bds.m_ZoneUseNoOutlineInFill );
+
+    // Zones with no net are clipped to the board outline rather than losing their islands
+    if( aZone->GetNetCode() <= 0 )
+    {
+        hash.Hash( m_brdOutlinesValid );
+
+        if( m_brdOutlinesValid )
+            hashPolySet( hash, m_boardOutline );
+    }
+
+    // Pads, and holes going through the zone layer
+    //
+    auto doPad = [&]( D_PAD* pad )
+    {
+        bool onLayer = pad->IsOnLayer( layer );
+
+        if( !onLayer && pad->GetDrillSize().x == 0 && pad->GetDrillSize().y == 0 )
+            return;
+
+        int      thermalGap = aZone->GetThermalReliefGap( pad );
+        EDA_RECT item_boundingbox = pad->GetBoundingBox();
+        item_boundingbox.Inflate( std::max( pad->GetClearance(), thermalGap ) );
+
+        if( !item_boundingbox.Intersects( zone_boundingbox ) )
+            return;
+
+        hash.Hash( PCB_PAD_T );
+        hash.Hash( onLayer );
+        hash.Hash( pad->GetNetCode() );
+        hash.Hash( pad->GetClearance() );
+        hash.Hash( (int) pad->GetAttribute() );
+        hash.Hash( (int) aZone->GetPadConnection( pad ) );
+        hash.Hash( thermalGap );
+        hash.Hash( aZone->GetThermalReliefCopperBridge( pad ) );
+        hash.Hash( pad->GetPosition().x );
+        hash.Hash( pad->GetPosition().y );
+        hash.Hash( KiROUND( pad->GetOrientation() ) );
+        hash.Hash( pad->GetDrillSize().x );
+        hash.Hash( pad->GetDrillSize().y );
+        hash.Hash( (int) pad->GetDrillShape() );
+
+        if( onLayer )
+        {
+            SHAPE_POLY_SET shape;
+            addKnockout( pad, 0, shape );
+            hashPolySet( hash, shape );
+        }
+    };
+
+    // Tracks and vias
+    //
+    auto doTrack = [&]( TRACK* track )
+    {
+        if( !track->IsOnLayer( layer ) )
+            return;
+
+        EDA_RECT item_boundingbox = track->GetBoundingBox();
+        item_boundingbox.Inflate( track->GetClearance() );
+
+        if( !item_boundingbox.Intersects( zone_boundingbox ) )
+            return;
+
+        hash.Hash( track->Type() );
+        hash.Hash( track->GetNetCode() );
+        hash.Hash( track->GetClearance() );
+        hash.Hash( track->GetWidth() );
+        hash.Hash( track->GetStart().x );
+        hash.Hash( track->GetStart().y );
+        hash.Hash( track->GetEnd().x );
+        hash.Hash( track->GetEnd().y );
+
+        if( track->Type() == PCB_ARC_T )
+        {
+            hash.Hash( static_cast<ARC*>( track )->GetMid().x );
+            hash.Hash( static_cast<ARC*>( track )->GetMid().y );
+        }
+        else if( track->Type() == PCB_VIA_T )
+        {
+            hash.Hash( static_cast<VIA*>( track )->GetDrillValue() );
+        }
+    };
+
+    // Graphic items
+    //
+    auto doGraphicItem = [&]( BOARD_ITEM* aItem )
+    {
+        bool onEdge = aItem->IsOnLayer( Edge_Cuts );
+
+        if( !aItem->IsOnLayer( layer ) && !onEdge )
+            return;
+
+        if( !aItem->GetBoundingBox().Intersects( zone_boundingbox ) )
+            return;
+
+        SHAPE_POLY_SET shape;
+        addKnockout( aItem, 0, onEdge, shape );
+
+        hash.Hash( aItem->Type() );
+        hash.Hash( onEdge );
+        hashPolySet( hash, shape );
+    };
+
+    // Other zones: higher priority zones and keepouts knock out copper, same net zones can
+    // connect islands
+    //
+    auto doZone = [&]( ZONE_CONTAINER* zone )
+    {
+        if( zone == aZone || !aZone->CommonLayerExists( zone->GetLayerSet() ) )
+            return;
+
+        if( !zone->GetBoundingBox().Intersects( zone_boundingbox ) )
+            return;
+
+        hashPolySet( hash, *zone->Outline() );
+        hash.Hash( zone->GetNetCode() );
+        hash.Hash( zone->GetPriority() );
+        hash.Hash( zone->GetClearance() );
+        hash.Hash( zone->GetIsKeepout() );
+        hash.Hash( zone->GetDoNotAllowCopperPour() );
+    };
+
+    // The index finds every item which can pass the tests above, and the items are hashed in
+    // board order so that the signature does not depend on the shape of the tree
+    //
+    EDA_RECT area = zone_boundingbox;
+    area.Inflate( std::max( m_dependencyMargin, aZone->GetThermalReliefGap() ) );
+    area.Normalize();
+
+    const int        mmin[2] = { area.GetX(), area.GetY() };
+    const int        mmax[2] = { area.GetRight(), area.GetBottom() };
+    std::vector<int> nearby;
+
+    m_dependencyTree->Search( mmin, mmax,
+            [&nearby]( const int& aIndex )
+            {
+                nearby.push_back( aIndex );
+                return true;
+            } );
+
+    std::sort( nearby.begin(), nearby.end() );
+
+    for( int index : nearby )
+    {
+        BOARD_ITEM* item = m_dependencyItems[index];
+
+        switch( item->Type() )
+        {
+        case PCB_PAD_T:
+            doPad( static_cast<D_PAD*>( item ) );
+            break;
+
+        case PCB_TRACE_T:
+        case PCB_ARC_T:
+        case PCB_VIA_T:
+            doTrack( static_cast<TRACK*>( item ) );
+            break;
+
+        case PCB_ZONE_AREA_T:
+        case PCB_MODULE_ZONE_AREA_T:
+            doZone( static_cast<ZONE_CONTAINER*>( item ) );
+            break;
+
+        default:
+            doGraphicItem( item );
+            break;
+        }
+    }
+
+    hash.Finalize();
+
+    return hash;
+}
+
+
+void ZONE_FILLER::buildDependencyIndex()
+{
+    m_dependencyItems.clear();
+    m_dependencyTree.reset( new RTree<int, int, 2, double>() );
+    m_dependencyMargin = 0;
+
+    auto add = [&]( BOARD_ITEM* aItem )
+    {
+        EDA_RECT  box = aItem->GetBoundingBox();
+        const int index = (int) m_dependencyItems.size();
+
+        box.Normalize();
+
+        const int mmin[2] = { box.GetX(), box.GetY() };
+        const int mmax[2] = { box.GetRight(), box.GetBottom() };
+
+        m_dependencyItems.push_back( aItem );
+        m_dependencyTree->Insert( mmin, mmax, index );
+    };
+
+    for( MODULE* module : m_board->Modules() )
+    {
+        for( D_PAD* pad : module->Pads() )
+        {
+            m_dependencyMargin = std::max( m_dependencyMargin, pad->GetClearance() );
+            m_dependencyMargin = std::max( m_dependencyMargin, pad->GetThermalGap() );
+            add( pad );
+        }
+    }
+
+    for( TRACK* track : m_board->Tracks() )
+    {
+        m_dependencyMargin = std::max( m_dependencyMargin, track->GetClearance() );
+        add( track );
+    }
+
+    for( MODULE* module : m_board->Modules() )
+    {
+        add( &module->Reference() );
+        add( &module->Value() );
+
+        for( BOARD_ITEM* item : module->GraphicalItems() )
+            add( item );
+    }
+
+    for( BOARD_ITEM* item : m_board->Drawings() )
+        add( item );
+
+    for( ZONE_CONTAINER* zone : m_board->GetZoneList( true ) )
+        add( zone );
 }
 
 
@@ -748,7 +1117,7 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone,
     // because the "real" subtract-clearance-holes has to be done after the spokes are added.
     static const bool USE_BBOX_CACHES = true;
     SHAPE_POLY_SET testAreas = aRawPolys;
-    testAreas.BooleanSubtract( clearanceHoles, SHAPE_POLY_SET::PM_FAST );
+    subtract( testAreas, clearanceHoles );
 
     // Prune features that don't meet minimum-width criteria
     if( half_min_width - epsilon > epsilon )
@@ -791,7 +1160,7 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone,
     if( s_DumpZonesWhenFilling )
         dumper->Write( &aRawPolys, "solid-areas-with-thermal-spokes" );
 
-    aRawPolys.BooleanSubtract( clearanceHoles, SHAPE_POLY_SET::PM_FAST );
+    subtract( aRawPolys, clearanceHoles );
     // Prune features that don't meet minimum-width criteria
     if( half_min_width - epsilon > epsilon )
         aRawPolys.Deflate( half_min_width - epsilon, numSegs, intermediatecornerStrategy );
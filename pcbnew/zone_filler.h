@@ -26,8 +26,10 @@
 #ifndef __ZONE_FILLER_H
 #define __ZONE_FILLER_H
 
+#include <memory>
 #include <vector>
 #include <class_zone.h>
+#include <geometry/rtree.h>
 
 class WX_PROGRESS_REPORTER;
 class BOARD;
@@ -45,8 +47,32 @@ public:
     void InstallNewProgressReporter( wxWindow* aParent, const wxString& aTitle, int aNumPhases );
     bool Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck = false );
 
+    /**
+     * When set, Fill() only refills the zones whose fill inputs changed since their last fill.
+     *
+     * Each fill records on the zone a signature of everything it was computed from (see
+     * buildFillDependencies()).  Zones whose signature still matches keep their current fill;
+     * the others are refilled, along with the same net zones they can connect through.
+     * Signatures are only computed by incremental fills: the zones filled otherwise are all
+     * refilled by the next incremental fill.
+     */
+    void SetIncremental( bool aIncremental ) { m_incremental = aIncremental; }
+
 private:
 
+    /**
+     * Build the dependency record of aZone's fill: its outline and settings, plus the shape,
+     * net and clearances of every item inside its clearance-inflated bounding box which can
+     * knock out copper from it, connect to it or isolate parts of it.
+     */
+    MD5_HASH buildFillDependencies( ZONE_CONTAINER* aZone );
+
+    /**
+     * Index the board items buildFillDependencies() looks at by their bounding box, so that
+     * each zone only visits the items near it.
+     */
+    void buildDependencyIndex();
+
     void addKnockout( D_PAD* aPad, int aGap, SHAPE_POLY_SET& aHoles );
 
     void addKnockout( BOARD_ITEM* aItem, int aGap, bool aIgnoreLineWidth, SHAPE_POLY_SET& aHoles );
@@ -55,6 +81,17 @@ private:
 
     void buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aHoles );
 
+    /**
+     * Boolean operations on the fill areas and knockout sets, which can be huge for ground
+     * planes.  Past the ZoneFillPartitionContours advanced setting they are split in tiles
+     * computed in parallel (see SHAPE_POLY_SET::BooleanSubtractPartitioned()).
+     */
+    void subtract( SHAPE_POLY_SET& aPolys, const SHAPE_POLY_SET& aHoles ) const;
+    void simplify( SHAPE_POLY_SET& aPolys ) const;
+
+    ///> @return the number of tiles per axis for a boolean on aContours contours, 0 for none
+    int partitionTiles( int aContours ) const;
+
     /**
      * Function computeRawFilledArea
      * Add non copper areas polygons (pads and tracks with clearance)
@@ -108,6 +145,14 @@ private:
     bool m_brdOutlinesValid;            // true if m_boardOutline can be calculated
                                         // false if not (not closed outlines for instance)
     COMMIT* m_commit;
+    bool m_incremental;                 // refill only zones with changed fill dependencies
+
+    ///> The items zone fills can depend on, in board order: pads first, then tracks, graphic
+    ///> items and zones.  m_dependencyTree holds their indices in this list.
+    std::vector<BOARD_ITEM*>                    m_dependencyItems;
+    std::unique_ptr<RTree<int, int, 2, double>> m_dependencyTree;
+    int m_dependencyMargin;             // the largest clearance by which an item box is inflated
+
     WX_PROGRESS_REPORTER* m_progressReporter;
     std::unique_ptr<WX_PROGRESS_REPORTER> m_uniqueReporter;
 
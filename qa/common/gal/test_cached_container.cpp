@@ -0,0 +1,324 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <gal/opengl/cached_container.h>
+#include <gal/opengl/vertex_item.h>
+#include <gal/opengl/vertex_manager.h>
+
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <vector>
+
+
+using namespace KIGFX;
+
+
+/**
+ * A CACHED_CONTAINER keeping its vertices in memory allocated by malloc(), with no OpenGL
+ * buffer, and showing its allocator state to the tests
+ */
+class TEST_CONTAINER : public CACHED_CONTAINER
+{
+public:
+    TEST_CONTAINER( unsigned int aSize ) :
+            CACHED_CONTAINER( aSize ),
+            m_mapped( false )
+    {
+        m_vertices = static_cast<VERTEX*>( malloc( m_currentSize * VERTEX_SIZE ) );
+    }
+
+    ~TEST_CONTAINER()
+    {
+        free( m_vertices );
+    }
+
+    unsigned int GetBufferHandle() const override { return 0; }
+
+    bool IsMapped() const override { return m_mapped; }
+
+    void Map() override { m_mapped = true; }
+
+    void Unmap() override { m_mapped = false; }
+
+    static unsigned int PageSize() { return PAGE_SIZE; }
+
+    unsigned int FreeSpace() const { return m_freeSpace; }
+
+    ///> The free space according to the pages: free pages and free blocks of the slabs
+    unsigned int CountFreeSpace() const
+    {
+        unsigned int freeSpace = 0;
+
+        for( const PAGE& page : m_pages )
+        {
+            if( page.m_class == FREE_PAGE )
+                freeSpace += PAGE_SIZE;
+            else if( page.m_class >= 0 )
+                freeSpace += PAGE_SIZE - page.m_used * blockSize( page.m_class );
+        }
+
+        return freeSpace;
+    }
+
+    ///> The number of vertices the block or the run of pages of an item can hold
+    unsigned int Capacity( const VERTEX_ITEM& aItem ) const
+    {
+        return chunkCapacity( aItem.GetOffset() );
+    }
+
+protected:
+    bool resize( unsigned int aNewSize ) override
+    {
+        VERTEX* vertices = static_cast<VERTEX*>( realloc( m_vertices, aNewSize * VERTEX_SIZE ) );
+
+        if( !vertices )
+            return false;
+
+        m_vertices = vertices;
+        return true;
+    }
+
+private:
+    bool m_mapped;
+};
+
+
+struct CACHED_CONTAINER_FIXTURE
+{
+    CACHED_CONTAINER_FIXTURE() :
+            m_container( new TEST_CONTAINER( TEST_CONTAINER::PageSize() ) ),
+            m_manager( m_container )
+    {
+        m_container->Map();
+    }
+
+    ~CACHED_CONTAINER_FIXTURE()
+    {
+        // Before the manager and its container
+        m_items.clear();
+    }
+
+    VERTEX_ITEM* addItem()
+    {
+        m_items.emplace_back( new VERTEX_ITEM( m_manager ) );
+        m_container->FinishItem();
+        m_tags[m_items.back().get()] = m_items.size();
+
+        return m_items.back().get();
+    }
+
+    /**
+     * Adds aCount vertices to an item, one Allocate() call each.  The vertices hold the index
+     * of the item and their own index.
+     */
+    void grow( VERTEX_ITEM* aItem, unsigned int aCount )
+    {
+        float tag = m_tags[aItem];
+
+        m_container->SetItem( aItem );
+
+        for( unsigned int ii = 0; ii < aCount; ++ii )
+        {
+            unsigned int index = aItem->GetSize();
+            VERTEX*      vertex = m_container->Allocate( 1 );
+
+            BOOST_REQUIRE( vertex );
+            vertex->x = tag;
+            vertex->y = index;
+        }
+
+        m_container->FinishItem();
+    }
+
+    ///> True if the vertices of the item are at its offset
+    bool intact( const VERTEX_ITEM* aItem )
+    {
+        const VERTEX* vertices = m_container->GetVertices( aItem->GetOffset() );
+        float         tag = m_tags[aItem];
+
+        for( unsigned int ii = 0; ii < aItem->GetSize(); ++ii )
+        {
+            if( vertices[ii].x != tag || vertices[ii].y != ii )
+                return false;
+        }
+
+        return true;
+    }
+
+    void checkAll()
+    {
+        for( const std::unique_ptr<VERTEX_ITEM>& item : m_items )
+        {
+            if( !item->GetSize() )
+                continue;
+
+            BOOST_CHECK( intact( item.get() ) );
+            BOOST_CHECK_GE( m_container->Capacity( *item ), item->GetSize() );
+        }
+
+        BOOST_CHECK_EQUAL( m_container->FreeSpace(), m_container->CountFreeSpace() );
+    }
+
+    TEST_CONTAINER*                           m_container;
+    VERTEX_MANAGER                            m_manager;
+    std::vector<std::unique_ptr<VERTEX_ITEM>> m_items;
+    std::map<const VERTEX_ITEM*, float>       m_tags;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( CachedContainer, CACHED_CONTAINER_FIXTURE )
+
+
+/**
+ * Items growing a vertex at a time move from size class to size class, and to a run of pages,
+ * with their vertices
+ */
+BOOST_AUTO_TEST_CASE( GrowAcrossSizeClasses )
+{
+    VERTEX_ITEM* a = addItem();
+    VERTEX_ITEM* b = addItem();
+
+    for( unsigned int ii = 0; ii < 2 * TEST_CONTAINER::PageSize(); ++ii )
+    {
+        grow( a, 1 );
+        grow( b, ii % 2 );
+
+        if( ii % 997 == 0 )
+            checkAll();
+    }
+
+    checkAll();
+    BOOST_CHECK_EQUAL( m_container->Capacity( *a ), 2 * TEST_CONTAINER::PageSize() );
+}
+
+
+/**
+ * A large item growing in one go gets room to double, and gives back the pages it did not use
+ */
+BOOST_AUTO_TEST_CASE( LargeItemRun )
+{
+    VERTEX_ITEM*       item = addItem();
+    const unsigned int pageSize = TEST_CONTAINER::PageSize();
+
+    m_container->SetItem( item );
+
+    for( unsigned int ii = 0; ii < 2 * pageSize + 5; ++ii )
+    {
+        VERTEX* vertex = m_container->Allocate( 1 );
+
+        BOOST_REQUIRE( vertex );
+        vertex->x = m_tags[item];
+        vertex->y = ii;
+    }
+
+    BOOST_CHECK_EQUAL( m_container->Capacity( *item ), 4 * pageSize );
+
+    m_container->FinishItem();
+
+    BOOST_CHECK_EQUAL( m_container->Capacity( *item ), 3 * pageSize );
+    checkAll();
+
+    // The page given back is used again
+    unsigned int size = m_container->GetSize();
+
+    grow( addItem(), pageSize );
+    BOOST_CHECK_EQUAL( m_container->GetSize(), size );
+    checkAll();
+}
+
+
+/**
+ * Compact() moves the blocks of the emptiest slabs to the others, with their vertices
+ */
+BOOST_AUTO_TEST_CASE( Compact )
+{
+    const unsigned int blocks = TEST_CONTAINER::PageSize() / 4;
+
+    for( unsigned int ii = 0; ii < 4 * blocks; ++ii )
+        grow( addItem(), 1 + ii % 4 );
+
+    int slabs = m_container->GetStats().m_slabCount;
+
+    BOOST_CHECK_EQUAL( slabs, 4 );
+
+    // Keep one item in ten
+    for( unsigned int ii = 0; ii < m_items.size(); ++ii )
+    {
+        if( ii % 10 )
+            m_manager.FreeItem( *m_items[ii] );
+    }
+
+    checkAll();
+
+    std::vector<unsigned int> offsets;
+
+    for( const std::unique_ptr<VERTEX_ITEM>& item : m_items )
+        offsets.push_back( item->GetOffset() );
+
+    m_container->Compact( 4 * blocks );
+
+    BOOST_CHECK_EQUAL( m_container->GetStats().m_slabCount, 1 );
+    BOOST_CHECK_EQUAL( m_container->GetStats().m_compactions, 3 );
+
+    unsigned int moved = 0;
+
+    for( unsigned int ii = 0; ii < m_items.size(); ++ii )
+    {
+        if( m_items[ii]->GetSize() && m_items[ii]->GetOffset() != offsets[ii] )
+            ++moved;
+    }
+
+    BOOST_CHECK_GT( moved, 0 );
+    checkAll();
+}
+
+
+/**
+ * The container grows without moving the items already stored
+ */
+BOOST_AUTO_TEST_CASE( ResizeKeepsOffsets )
+{
+    std::vector<unsigned int> offsets;
+    unsigned int              size = m_container->GetSize();
+
+    while( m_container->GetStats().m_resizes < 3 )
+    {
+        VERTEX_ITEM* item = addItem();
+
+        grow( item, 1 + m_items.size() * 37 % 2000 );
+        offsets.push_back( item->GetOffset() );
+    }
+
+    BOOST_CHECK_EQUAL( m_container->GetSize(), 8 * size );
+
+    for( unsigned int ii = 0; ii < m_items.size(); ++ii )
+        BOOST_CHECK_EQUAL( m_items[ii]->GetOffset(), offsets[ii] );
+
+    checkAll();
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,295 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <gal/gal_display_options.h>
+#include <gal/graphics_abstraction_layer.h>
+#include <gal/stroke_font.h>
+#include <gr_text.h>
+
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+
+using namespace KIGFX;
+
+
+/**
+ * A GAL writing down what it is asked to draw
+ */
+class RECORDING_GAL : public GAL
+{
+public:
+    RECORDING_GAL() :
+            GAL( s_options )
+    {
+    }
+
+    void DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint ) override
+    {
+        m_log << "L";
+        point( aStartPoint );
+        point( aEndPoint );
+        m_log << "\n";
+    }
+
+    void DrawPolyline( const std::deque<VECTOR2D>& aPointList ) override
+    {
+        m_log << "P";
+
+        for( const VECTOR2D& pt : aPointList )
+            point( pt );
+
+        m_log << "\n";
+    }
+
+    void Translate( const VECTOR2D& aTranslation ) override
+    {
+        m_log << "T";
+        point( aTranslation );
+        m_log << "\n";
+    }
+
+    void Rotate( double aAngle ) override { m_log << "R" << aAngle << "\n"; }
+
+    void Scale( const VECTOR2D& aScale ) override
+    {
+        m_log << "S";
+        point( aScale );
+        m_log << "\n";
+    }
+
+    void Save() override { m_log << "{\n"; }
+
+    void Restore() override { m_log << "}\n"; }
+
+    ///> Draws a text and returns what was drawn
+    std::string Draw( const wxString& aText, int aMarkupFlags = 0 )
+    {
+        m_log.str( "" );
+        StrokeText( aText, VECTOR2D( 1.0, 2.0 ), 0.0, aMarkupFlags );
+        return m_log.str();
+    }
+
+private:
+    void point( const VECTOR2D& aPoint )
+    {
+        char buf[64];
+
+        snprintf( buf, sizeof( buf ), "(%.9g,%.9g)", aPoint.x, aPoint.y );
+        m_log << buf;
+    }
+
+    static GAL_DISPLAY_OPTIONS s_options;
+
+    std::ostringstream m_log;
+};
+
+
+GAL_DISPLAY_OPTIONS RECORDING_GAL::s_options;
+
+
+/**
+ * Leaves the layout cache enabled, as the other tests expect it
+ */
+struct STROKE_FONT_FIXTURE
+{
+    ~STROKE_FONT_FIXTURE()
+    {
+        STROKE_FONT::SetLayoutCacheEnabled( true );
+    }
+
+    ///> Draws a text with the layout cache disabled
+    std::string drawUncached( RECORDING_GAL& aAttributes, const wxString& aText,
+                              int aMarkupFlags = 0 )
+    {
+        RECORDING_GAL gal;
+
+        gal.SetGlyphSize( aAttributes.GetGlyphSize() );
+        gal.SetLineWidth( aAttributes.GetLineWidth() );
+        gal.SetFontItalic( aAttributes.IsFontItalic() );
+        gal.SetTextMirrored( aAttributes.IsTextMirrored() );
+        gal.SetHorizontalJustify( aAttributes.GetHorizontalJustify() );
+
+        STROKE_FONT::SetLayoutCacheEnabled( false );
+        std::string result = gal.Draw( aText, aMarkupFlags );
+        STROKE_FONT::SetLayoutCacheEnabled( true );
+
+        return result;
+    }
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( StrokeFont, STROKE_FONT_FIXTURE )
+
+
+/**
+ * The texts drawn from the layout cache are drawn as without it
+ */
+BOOST_AUTO_TEST_CASE( CachedLayouts )
+{
+    const wxString texts[] = { "Hello", "R12", "~RESET~ x", "a~~b~~~c", "x^2 y#i z",
+                               "\tTab\tbed", "~a b~c", "multi\nline ~ov~",
+                               wxString::FromUTF8( "\xc3\xa9t\xc3\xa9 \xe2\x82\xac" ), "~~~", "^",
+                               "" };
+
+    RECORDING_GAL gal;
+
+    for( int pass = 0; pass < 2; ++pass )
+    {
+        for( int flags = 0; flags < 16; ++flags )
+        {
+            for( int justify = -1; justify <= 1; ++justify )
+            {
+                for( const wxString& text : texts )
+                {
+                    BOOST_TEST_CONTEXT( "text: " << text << ", flags: " << flags
+                                                 << ", justify: " << justify )
+                    {
+                        int markup = flags & 3;
+
+                        gal.SetGlyphSize( VECTOR2D( 1.5 + markup, 1.25 ) );
+                        gal.SetLineWidth( 0.2 + 0.05 * markup );
+                        gal.SetFontItalic( flags & 4 );
+                        gal.SetTextMirrored( flags & 8 );
+                        gal.SetHorizontalJustify( (EDA_TEXT_HJUSTIFY_T) justify );
+
+                        BOOST_CHECK_EQUAL( gal.Draw( text, markup ),
+                                           drawUncached( gal, text, markup ) );
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * A text drawn with other attributes is not taken from the cache
+ */
+BOOST_AUTO_TEST_CASE( LayoutKey )
+{
+    const wxString text = "~x^2~ y#i";
+
+    RECORDING_GAL gal;
+
+    gal.SetGlyphSize( VECTOR2D( 1.5, 1.25 ) );
+    gal.SetLineWidth( 0.2 );
+
+    const std::string plain = gal.Draw( text );
+
+    gal.SetFontItalic( true );
+    std::string italic = gal.Draw( text );
+    BOOST_CHECK( italic != plain );
+    BOOST_CHECK_EQUAL( italic, drawUncached( gal, text ) );
+    gal.SetFontItalic( false );
+
+    gal.SetTextMirrored( true );
+    std::string mirrored = gal.Draw( text );
+    BOOST_CHECK( mirrored != plain );
+    BOOST_CHECK_EQUAL( mirrored, drawUncached( gal, text ) );
+    gal.SetTextMirrored( false );
+
+    for( int markup : { ENABLE_SUBSCRIPT_MARKUP, ENABLE_SUPERSCRIPT_MARKUP } )
+    {
+        std::string withMarkup = gal.Draw( text, markup );
+        BOOST_CHECK( withMarkup != plain );
+        BOOST_CHECK_EQUAL( withMarkup, drawUncached( gal, text, markup ) );
+    }
+
+    gal.SetGlyphSize( VECTOR2D( 2.0, 1.25 ) );
+    std::string wider = gal.Draw( text );
+    BOOST_CHECK( wider != plain );
+    BOOST_CHECK_EQUAL( wider, drawUncached( gal, text ) );
+    gal.SetGlyphSize( VECTOR2D( 1.5, 1.25 ) );
+
+    gal.SetLineWidth( 0.3 );
+    std::string thicker = gal.Draw( text );
+    BOOST_CHECK( thicker != plain );
+    BOOST_CHECK_EQUAL( thicker, drawUncached( gal, text ) );
+    gal.SetLineWidth( 0.2 );
+
+    BOOST_CHECK_EQUAL( gal.Draw( text ), plain );
+}
+
+
+/**
+ * The layouts are shared by the fonts drawing in several threads, and more texts than the
+ * cache holds make it evict some
+ */
+BOOST_AUTO_TEST_CASE( SharedCache )
+{
+    const int TEXT_COUNT = 10000;
+    const int THREAD_COUNT = 4;
+
+    auto drawAll = [&]( RECORDING_GAL& aGal, int aSeed )
+    {
+        std::string result;
+
+        for( int ii = 0; ii < TEXT_COUNT; ++ii )
+        {
+            int n = ( ii * 7919 + aSeed * 31 ) % ( TEXT_COUNT / 2 );
+
+            aGal.SetFontItalic( n & 1 );
+            result += aGal.Draw( wxString::Format( "T%d", n ) );
+        }
+
+        return result;
+    };
+
+    std::string expected[THREAD_COUNT];
+    std::string drawn[THREAD_COUNT];
+
+    STROKE_FONT::SetLayoutCacheEnabled( false );
+
+    for( int ii = 0; ii < THREAD_COUNT; ++ii )
+    {
+        RECORDING_GAL gal;
+        expected[ii] = drawAll( gal, ii );
+    }
+
+    STROKE_FONT::SetLayoutCacheEnabled( true );
+
+    // Made here, a GAL subscribes to the display options when created
+    RECORDING_GAL            gals[THREAD_COUNT];
+    std::vector<std::thread> threads;
+
+    for( int ii = 0; ii < THREAD_COUNT; ++ii )
+    {
+        threads.emplace_back( [&, ii]()
+                {
+                    drawn[ii] = drawAll( gals[ii], ii );
+                } );
+    }
+
+    for( std::thread& thread : threads )
+        thread.join();
+
+    for( int ii = 0; ii < THREAD_COUNT; ++ii )
+        BOOST_CHECK( drawn[ii] == expected[ii] );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
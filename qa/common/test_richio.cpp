@@ -0,0 +1,189 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <dsnlexer.h>
+#include <richio.h>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include <string>
+#include <vector>
+
+
+/**
+ * An s-expression file written to a temporary location, without a trailing newline so
+ * that the last token ends with the file
+ */
+struct RICHIO_FIXTURE
+{
+    RICHIO_FIXTURE()
+    {
+        m_text = "(kicad_pcb (version 20200512)\n"
+                 "\n"
+                 "  (net 1 \"Net-(U1-Pad1)\")\n"
+                 "  (gr_text \"a \\\"quoted\\\" \\x41\\101 text\" (at 1.5 -2e3))\n"
+                 "  (segment (start 0 0) (end 10 10) (width 0.25))\n"
+                 ")";
+
+        m_path = wxFileName::CreateTempFileName( "richio" );
+
+        wxFFile file( m_path, "wb" );
+        file.Write( m_text.c_str(), m_text.size() );
+    }
+
+    ~RICHIO_FIXTURE()
+    {
+        wxRemoveFile( m_path );
+    }
+
+    static std::vector<std::string> tokens( LINE_READER* aReader )
+    {
+        std::vector<std::string> result;
+        DSNLEXER                 lexer( nullptr, 0, aReader );
+
+        while( lexer.NextTok() != DSN_EOF )
+            result.push_back( lexer.CurStr() );
+
+        return result;
+    }
+
+    std::string m_text;
+    wxString    m_path;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( RichIO, RICHIO_FIXTURE )
+
+
+/**
+ * The whole file reader reads the same lines as the file reader, copied or in place
+ */
+BOOST_AUTO_TEST_CASE( WholeFileLines )
+{
+    WHOLE_FILE_LINE_READER whole( m_path );
+    FILE_LINE_READER       file( m_path );
+
+    while( true )
+    {
+        char* expected = file.ReadLine();
+        char* line = whole.ReadLine();
+
+        BOOST_CHECK_EQUAL( whole.LineNumber(), file.LineNumber() );
+
+        if( !expected )
+        {
+            BOOST_CHECK( line == nullptr );
+            break;
+        }
+
+        BOOST_REQUIRE( line != nullptr );
+        BOOST_CHECK_EQUAL( std::string( line ), std::string( expected ) );
+    }
+
+    whole.Rewind();
+
+    std::string text;
+    unsigned    length;
+
+    for( const char* line = whole.ReadLineInPlace( &length ); length;
+         line = whole.ReadLineInPlace( &length ) )
+    {
+        text.append( line, length );
+    }
+
+    BOOST_CHECK_EQUAL( text, m_text );
+
+    // A line read in place is only copied on request
+    whole.Rewind();
+    whole.ReadLineInPlace( &length );
+    BOOST_CHECK_EQUAL( std::string( whole.FetchLine() ), "(kicad_pcb (version 20200512)\n" );
+}
+
+
+/**
+ * A file truncated while it is read is read to the end as it was
+ */
+BOOST_AUTO_TEST_CASE( TruncatedWhileRead )
+{
+    WHOLE_FILE_LINE_READER whole( m_path );
+
+    // The reader already holds the text, or on Windows the mapping keeps the file from
+    // being truncated
+    {
+        wxFFile file( m_path, "wb" );
+    }
+
+    std::string text;
+    unsigned    length;
+
+    for( const char* line = whole.ReadLineInPlace( &length ); length;
+         line = whole.ReadLineInPlace( &length ) )
+    {
+        text.append( line, length );
+    }
+
+    BOOST_CHECK_EQUAL( text, m_text );
+}
+
+
+/**
+ * The lexer finds the same tokens whether the lines are copied or read in place
+ */
+BOOST_AUTO_TEST_CASE( LexerTokens )
+{
+    FILE_LINE_READER       file( m_path );
+    WHOLE_FILE_LINE_READER whole( m_path );
+    STRING_LINE_READER     string( m_text, "test" );
+
+    const std::vector<std::string> expected = tokens( &file );
+
+    BOOST_CHECK_EQUAL( expected.size(), 37 );
+    BOOST_CHECK_EQUAL( expected[12], "a \"quoted\" AA text" );
+    BOOST_CHECK_EQUAL( expected.back(), ")" );
+
+    BOOST_CHECK( tokens( &whole ) == expected );
+    BOOST_CHECK( tokens( &string ) == expected );
+}
+
+
+/**
+ * Errors report the offending line even when it was read in place
+ */
+BOOST_AUTO_TEST_CASE( ErrorLine )
+{
+    WHOLE_FILE_LINE_READER whole( m_path );
+    DSNLEXER               lexer( nullptr, 0, &whole );
+
+    lexer.NextTok();
+    lexer.NextTok();
+
+    BOOST_CHECK_EQUAL( std::string( lexer.CurLine() ), "(kicad_pcb (version 20200512)\n" );
+    BOOST_CHECK_EQUAL( lexer.CurLineNumber(), 1 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
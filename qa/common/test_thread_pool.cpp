@@ -0,0 +1,131 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the shared #THREAD_POOL, #TASK_GROUP and #ParallelFor
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <thread_pool.h>
+
+#include <numeric>
+#include <stdexcept>
+
+
+BOOST_AUTO_TEST_SUITE( ThreadPool )
+
+
+/**
+ * Every index of the range is visited exactly once, whatever the grain
+ */
+BOOST_AUTO_TEST_CASE( ParallelForVisitsAll )
+{
+    for( size_t grain : { 0, 1, 7, 1000 } )
+    {
+        BOOST_TEST_CONTEXT( "Grain: " << grain )
+        {
+            std::vector<std::atomic<int>> visits( 5000 );
+
+            for( auto& v : visits )
+                v.store( 0 );
+
+            bool done = ParallelFor( 0, visits.size(),
+                                     [&]( size_t i )
+                                     {
+                                         visits[i]++;
+                                     }, nullptr, grain );
+
+            BOOST_CHECK( done );
+
+            for( auto& v : visits )
+                BOOST_CHECK_EQUAL( v.load(), 1 );
+        }
+    }
+
+    // Empty ranges do nothing
+    BOOST_CHECK( ParallelFor( 10, 10, []( size_t ) { BOOST_ERROR( "Called" ); } ) );
+}
+
+
+/**
+ * Parallel loops started from inside pool tasks must not deadlock, even on a single thread
+ */
+BOOST_AUTO_TEST_CASE( NestedParallelFor )
+{
+    THREAD_POOL pool( 1 );
+    TASK_GROUP  outer( nullptr, pool );
+    std::atomic<long> sum( 0 );
+
+    for( int ii = 0; ii < 8; ++ii )
+    {
+        outer.Run( [&]()
+                {
+                    TASK_GROUP inner( nullptr, pool );
+
+                    for( int jj = 0; jj < 100; ++jj )
+                        inner.Run( [&sum, jj]() { sum += jj; } );
+
+                    inner.Wait();
+                } );
+    }
+
+    BOOST_CHECK( outer.Wait() );
+    BOOST_CHECK_EQUAL( sum.load(), 8 * 4950 );
+}
+
+
+/**
+ * Tasks of a cancelled group that have not yet started are dropped
+ */
+BOOST_AUTO_TEST_CASE( Cancel )
+{
+    THREAD_POOL pool( 2 );
+    TASK_GROUP  group( nullptr, pool );
+    std::atomic<int> ran( 0 );
+
+    group.Cancel();
+
+    for( int ii = 0; ii < 100; ++ii )
+        group.Run( [&ran]() { ran++; } );
+
+    BOOST_CHECK( !group.Wait() );
+    BOOST_CHECK_EQUAL( ran.load(), 0 );
+}
+
+
+/**
+ * An exception thrown by a task is rethrown by Wait()
+ */
+BOOST_AUTO_TEST_CASE( Exception )
+{
+    TASK_GROUP group;
+
+    group.Run( []() { throw std::runtime_error( "task failed" ); } );
+
+    BOOST_CHECK_THROW( group.Wait(), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
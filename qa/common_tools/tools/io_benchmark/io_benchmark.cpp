@@ -22,6 +22,7 @@
  */
 
 #include <wx/wx.h>
+#include <dsnlexer.h>
 #include <richio.h>
 
 #include <chrono>
@@ -156,6 +157,50 @@ static void bench_line_reader_reuse( const wxFileName& aFile, int aReps, BENCH_R
 }
 
 
+/**
+ * Benchmark using WHOLE_FILE_LINE_READER without copying the lines out of its buffer.
+ * The reader is recreated, so the file read again, for each cycle.
+ */
+static void bench_whole_in_place( const wxFileName& aFile, int aReps, BENCH_REPORT& report )
+{
+    for( int i = 0; i < aReps; ++i)
+    {
+        WHOLE_FILE_LINE_READER fstr( aFile.GetFullPath() );
+        unsigned               length;
+        const char*            line;
+
+        for( line = fstr.ReadLineInPlace( &length ); length;
+             line = fstr.ReadLineInPlace( &length ) )
+        {
+            report.linesRead++;
+            report.charAcc += (unsigned char) line[0];
+        }
+    }
+}
+
+
+/**
+ * Benchmark tokenizing the file with a DSNLEXER over a given LINE_READER implementation,
+ * i.e. what the s-expression parsers pay before they do any work.  Tokens are counted
+ * as lines.
+ */
+template<typename LR>
+static void bench_lexer( const wxFileName& aFile, int aReps, BENCH_REPORT& report )
+{
+    for( int i = 0; i < aReps; ++i)
+    {
+        LR       fstr( aFile.GetFullPath() );
+        DSNLEXER lexer( nullptr, 0, &fstr );
+
+        while( lexer.NextTok() != DSN_EOF )
+        {
+            report.linesRead++;
+            report.charAcc += (unsigned char) lexer.CurText()[0];
+        }
+    }
+}
+
+
 /**
  * Benchmark using STRING_LINE_READER on string data read into memory from a file
  * using std::ifstream, but read the data fresh from the file each time
@@ -312,6 +357,9 @@ static std::vector<BENCHMARK> benchmarkList =
     { 'F', bench_fstream_reuse, "std::fstream, reused" },
     { 'r', bench_line_reader<FILE_LINE_READER>, "RichIO FILE_L_R" },
     { 'R', bench_line_reader_reuse<FILE_LINE_READER>, "RichIO FILE_L_R, reused" },
+    { 'm', bench_line_reader<WHOLE_FILE_LINE_READER>, "RichIO WHOLE_F_L_R" },
+    { 'M', bench_line_reader_reuse<WHOLE_FILE_LINE_READER>, "RichIO WHOLE_F_L_R, reused" },
+    { 'i', bench_whole_in_place, "RichIO WHOLE_F_L_R, in place" },
     { 'n', bench_line_reader<IFSTREAM_LINE_READER>, "std::ifstream L_R" },
     { 'N', bench_line_reader_reuse<IFSTREAM_LINE_READER>, "std::ifstream L_R, reused" },
     { 's', bench_string_lr, "RichIO STRING_L_R"},
@@ -324,6 +372,8 @@ static std::vector<BENCHMARK> benchmarkList =
     { 'B', bench_wxbis_reuse<wxFileInputStream>, "wxFileIStream, buf'd, reused" },
     { 'c', bench_wxbis<wxFFileInputStream>, "wxFFileIStream. buf'd" },
     { 'C', bench_wxbis_reuse<wxFFileInputStream>, "wxFFileIStream, buf'd, reused" },
+    { 'x', bench_lexer<FILE_LINE_READER>, "DSNLEXER, FILE_L_R" },
+    { 'X', bench_lexer<WHOLE_FILE_LINE_READER>, "DSNLEXER, WHOLE_F_L_R" },
 };
 
 
@@ -0,0 +1,213 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/utility_registry.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pcb_text.h>
+#include <class_text_mod.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <gal/gal_display_options.h>
+#include <gal/opengl/opengl_gal.h>
+#include <gal/stroke_font.h>
+#include <pcb_painter.h>
+#include <pcb_view.h>
+#include <profile.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+
+enum GAL_RECACHE_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+};
+
+
+/**
+ * Cache the geometry of all the items of a board in a view, the way it is done when a board
+ * is loaded or the display options change, and print the throughput of the GUI thread alone
+ * and of the worker threads.
+ *
+ * The view draws with an OPENGL_WORKER_GAL: the items go through the painter and the OpenGL
+ * tessellation code, but the vertices are kept in memory rather than uploaded to a GPU, so
+ * neither a display nor an OpenGL context is needed. The items are cached with the pads and
+ * vias drawn as shape instances and without.
+ *
+ * With -t, only the texts of the board and of its footprints are cached, with the text layout
+ * cache of the stroke font disabled and enabled. The layouts are kept from one run to the next,
+ * as they are when the items are cached again after a change of the display options.
+ *
+ * Usage: gal_recache <board file> [-r <runs>] [-t]
+ */
+int gal_recache_main( int argc, char* argv[] )
+{
+    if( argc < 2 )
+    {
+        printf( "usage: %s <board file> [-r <runs>] [-t]\n", argv[0] );
+        return KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    int  runs = 3;
+    bool textsOnly = false;
+
+    for( int ii = 2; ii < argc; ii++ )
+    {
+        std::string arg( argv[ii] );
+
+        if( arg == "-r" && ii + 1 < argc )
+            runs = std::max( 1, atoi( argv[++ii] ) );
+        else if( arg == "-t" )
+            textsOnly = true;
+        else
+            return KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    auto brd = KI_TEST::ReadBoardFromFileOrStream( argv[1] );
+
+    if( !brd )
+        return GAL_RECACHE_RET_CODES::LOAD_FAILED;
+
+    KIGFX::GAL_DISPLAY_OPTIONS options;
+    KIGFX::OPENGL_WORKER_GAL   gal( options );
+    KIGFX::PCB_PAINTER         painter( &gal );
+    KIGFX::PCB_VIEW            view( true );
+    int                        itemCount = 0;
+
+    view.SetGAL( &gal );
+    view.SetPainter( &painter );
+
+    auto add = [&]( BOARD_ITEM* aItem )
+    {
+        view.Add( aItem );
+        itemCount++;
+    };
+
+    if( textsOnly )
+    {
+        for( BOARD_ITEM* drawing : brd->Drawings() )
+        {
+            if( drawing->Type() == PCB_TEXT_T )
+                add( drawing );
+        }
+
+        for( MODULE* module : brd->Modules() )
+        {
+            add( &module->Reference() );
+            add( &module->Value() );
+
+            for( BOARD_ITEM* item : module->GraphicalItems() )
+            {
+                if( item->Type() == PCB_MODULE_TEXT_T )
+                    add( item );
+            }
+        }
+    }
+    else
+    {
+        for( ZONE_CONTAINER* zone : brd->Zones() )
+            zone->CacheTriangulation();
+
+        for( BOARD_ITEM* drawing : brd->Drawings() )
+            add( drawing );
+
+        for( TRACK* track : brd->Tracks() )
+            add( track );
+
+        for( MODULE* module : brd->Modules() )
+        {
+            // PCB_VIEW adds the children of the modules as well
+            module->RunOnChildren( [&]( BOARD_ITEM* ) { itemCount++; } );
+            add( module );
+        }
+
+        for( ZONE_CONTAINER* zone : brd->Zones() )
+            add( zone );
+    }
+
+    printf( "%-14s %8s %10s %10s %10s %10s\n", "mode", "items", "vertices", "instances",
+            "time [ms]", "items/s" );
+
+    // The texts are compared with the layout cache and without, the rest with the pads and vias
+    // drawn as instances and without
+    for( bool option : { false, true } )
+    {
+        if( textsOnly )
+            KIGFX::STROKE_FONT::SetLayoutCacheEnabled( option );
+        else
+            gal.SetShapeInstancing( option );   // the worker GALs draw instances when it does
+
+        for( bool parallel : { false, true } )
+        {
+            double total = 0.0;
+
+            view.SetParallelRecacheItems( parallel ? 1 : 0 );
+
+            for( int run = 0; run < runs; run++ )
+            {
+                // The worker GAL keeps the deleted groups until its cache is cleared
+                gal.ClearCache();
+                view.RecacheAllItems();
+
+                PROF_COUNTER counter;
+
+                view.UpdateItems();
+
+                counter.Stop();
+                total += counter.msecs();
+            }
+
+            double      time = total / runs;
+            std::string mode = parallel ? "parallel" : "serial";
+
+            if( option )
+                mode += textsOnly ? "+cache" : "+inst";
+
+            // The vertices of the shapes count once, whatever the number of their instances
+            unsigned int vertices = gal.GetVertexCount();
+
+            for( const KIGFX::OPENGL_GAL_BASE::INSTANCED_SHAPE& shape : gal.GetShapes() )
+                vertices += shape.m_vertices.size();
+
+            printf( "%-14s %8d %10u %10u %10.1f %10.1f\n", mode.c_str(), itemCount, vertices,
+                    gal.GetInstanceCount(), time,
+                    time > 0.0 ? itemCount * 1000.0 / time : 0.0 );
+        }
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+static bool registered = UTILITY_REGISTRY::Register( {
+        "gal_recache",
+        "Cache the geometry of the items of a board in a view and report the throughput",
+        gal_recache_main,
+} );
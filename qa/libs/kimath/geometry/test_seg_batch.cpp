@@ -0,0 +1,325 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * Test suite for the batched segment kernels, checked against the SEG methods they stand in
+ * for, along with a microbenchmark of the kernels.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <geometry/seg_batch.h>
+#include <geometry/shape_line_chain.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+/**
+ * A long track-like polyline of orthogonal, diagonal and any angle segments, and segments
+ * with clearances to test against it, most of them close to the polyline
+ */
+struct SEG_BATCH_FIXTURE
+{
+    static const int POINT_COUNT = 4001;
+    static const int QUERY_COUNT = 400;
+
+    SEG_BATCH_FIXTURE() :
+        m_bestKernel( SEG_BATCH::GetKernel() )
+    {
+        std::mt19937                       rng( 42 );
+        std::uniform_int_distribution<int> step( -2000000, 2000000 );
+        std::uniform_int_distribution<int> clearance( -100, 400000 );
+        VECTOR2I                           p( 0, 0 );
+
+        for( int ii = 0; ii < POINT_COUNT; ++ii )
+        {
+            m_points.push_back( p );
+
+            int dx = step( rng );
+            int dy = step( rng );
+
+            switch( ii % 4 )
+            {
+            case 0: dy = 0; break;                              // horizontal
+            case 1: dy = dx; break;                             // diagonal
+            case 2: dy = dx + ( ii % 3 ) - 1; break;            // almost diagonal
+            default: break;
+            }
+
+            p += VECTOR2I( dx, dy );
+        }
+
+        for( int ii = 0; ii + 1 < POINT_COUNT; ++ii )
+            m_batch.Append( SEG( m_points[ii], m_points[ii + 1] ) );
+
+        for( int ii = 0; ii < QUERY_COUNT; ++ii )
+        {
+            VECTOR2I a = m_points[rng() % POINT_COUNT] + VECTOR2I( step( rng ) / 4,
+                                                                   step( rng ) / 4 );
+
+            m_queries.push_back( SEG( a, a + VECTOR2I( step( rng ) / 2, step( rng ) / 2 ) ) );
+            m_clearances.push_back( clearance( rng ) );
+        }
+    }
+
+    ~SEG_BATCH_FIXTURE()
+    {
+        SEG_BATCH::SetKernel( m_bestKernel );
+    }
+
+    ///> The kernels this processor can run
+    static std::vector<SEG_BATCH::KERNEL> supportedKernels()
+    {
+        std::vector<SEG_BATCH::KERNEL> kernels;
+
+        for( SEG_BATCH::KERNEL kernel : { SEG_BATCH::KERNEL_SCALAR, SEG_BATCH::KERNEL_SSE4,
+                                          SEG_BATCH::KERNEL_AVX2 } )
+        {
+            if( SEG_BATCH::IsKernelSupported( kernel ) )
+                kernels.push_back( kernel );
+        }
+
+        return kernels;
+    }
+
+    ///> Plain loop over the segments, the reference of SEG_BATCH::Collide()
+    int referenceCollide( size_t aCount, const SEG& aSeg, int aClearance ) const
+    {
+        for( size_t ii = 0; ii < aCount; ++ii )
+        {
+            if( m_batch.Segment( ii ).Collide( aSeg, aClearance ) )
+                return (int) ii;
+        }
+
+        return -1;
+    }
+
+    SEG::ecoord referenceDistance( const SEG& aSeg ) const
+    {
+        SEG::ecoord d = VECTOR2I::ECOORD_MAX;
+
+        for( size_t ii = 0; ii < m_batch.Size(); ++ii )
+            d = std::min( d, m_batch.Segment( ii ).SquaredDistance( aSeg ) );
+
+        return d;
+    }
+
+    SEG::ecoord referenceDistance( const VECTOR2I& aP ) const
+    {
+        SEG::ecoord d = VECTOR2I::ECOORD_MAX;
+
+        for( size_t ii = 0; ii < m_batch.Size(); ++ii )
+            d = std::min( d, m_batch.Segment( ii ).SquaredDistance( aP ) );
+
+        return d;
+    }
+
+    SEG_BATCH::KERNEL     m_bestKernel;
+    std::vector<VECTOR2I> m_points;
+    SEG_BATCH             m_batch;
+    std::vector<SEG>      m_queries;
+    std::vector<int>      m_clearances;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( SegBatch, SEG_BATCH_FIXTURE )
+
+
+/**
+ * Every kernel finds the same first colliding segment as SEG::Collide(), batched or chained
+ */
+BOOST_AUTO_TEST_CASE( CollideMatchesSeg )
+{
+    std::vector<int> expected;
+
+    for( int ii = 0; ii < QUERY_COUNT; ++ii )
+        expected.push_back( referenceCollide( m_batch.Size(), m_queries[ii], m_clearances[ii] ) );
+
+    // Make sure both outcomes are covered
+    BOOST_CHECK( std::count( expected.begin(), expected.end(), -1 ) > 0 );
+    BOOST_CHECK( std::count( expected.begin(), expected.end(), -1 ) < QUERY_COUNT );
+
+    for( SEG_BATCH::KERNEL kernel : supportedKernels() )
+    {
+        BOOST_TEST_CONTEXT( SEG_BATCH::KernelName( kernel ) )
+        {
+            BOOST_REQUIRE( SEG_BATCH::SetKernel( kernel ) );
+
+            for( int ii = 0; ii < QUERY_COUNT; ++ii )
+            {
+                BOOST_CHECK_EQUAL( m_batch.Collide( m_queries[ii], m_clearances[ii] ),
+                                   expected[ii] );
+                BOOST_CHECK_EQUAL( SEG_BATCH::CollideChain( m_points.data(), m_batch.Size(),
+                                                            m_queries[ii], m_clearances[ii] ),
+                                   expected[ii] );
+            }
+        }
+    }
+}
+
+
+/**
+ * Every kernel finds the same smallest distance as SEG::SquaredDistance()
+ */
+BOOST_AUTO_TEST_CASE( SquaredDistanceMatchesSeg )
+{
+    for( SEG_BATCH::KERNEL kernel : supportedKernels() )
+    {
+        BOOST_TEST_CONTEXT( SEG_BATCH::KernelName( kernel ) )
+        {
+            BOOST_REQUIRE( SEG_BATCH::SetKernel( kernel ) );
+
+            for( int ii = 0; ii < QUERY_COUNT; ++ii )
+            {
+                const SEG& query = m_queries[ii];
+
+                BOOST_CHECK_EQUAL( m_batch.SquaredDistance( query ), referenceDistance( query ) );
+                BOOST_CHECK_EQUAL( m_batch.SquaredDistance( query.A ),
+                                   referenceDistance( query.A ) );
+                BOOST_CHECK_EQUAL( SEG_BATCH::SquaredDistanceChain( m_points.data(),
+                                                                    m_batch.Size(), query.A ),
+                                   referenceDistance( query.A ) );
+            }
+        }
+    }
+}
+
+
+/**
+ * Batches of any size, the SIMD kernels leaving the last few segments to the scalar code
+ */
+BOOST_AUTO_TEST_CASE( SmallBatches )
+{
+    const SEG& query = m_queries[0];
+
+    for( SEG_BATCH::KERNEL kernel : supportedKernels() )
+    {
+        BOOST_REQUIRE( SEG_BATCH::SetKernel( kernel ) );
+
+        for( size_t count = 0; count < 12; ++count )
+        {
+            for( size_t ii = 0; ii < 12; ++ii )
+            {
+                SEG seg( m_points[ii], m_points[ii] + VECTOR2I( 1000, 0 ) );
+
+                BOOST_CHECK_EQUAL( SEG_BATCH::CollideChain( m_points.data(), count, seg, 500000 ),
+                                   referenceCollide( count, seg, 500000 ) );
+            }
+        }
+    }
+
+    SEG_BATCH empty;
+
+    BOOST_CHECK_EQUAL( empty.Collide( query, 1000 ), -1 );
+    BOOST_CHECK( empty.SquaredDistance( query ) == VECTOR2I::ECOORD_MAX );
+}
+
+
+/**
+ * The line chain fast paths give the results of the plain loops over CSegment()
+ */
+BOOST_AUTO_TEST_CASE( LineChain )
+{
+    for( bool closed : { false, true } )
+    {
+        SHAPE_LINE_CHAIN chain( std::vector<VECTOR2I>( m_points.begin(),
+                                                       m_points.begin() + 200 ) );
+
+        chain.SetClosed( closed );
+
+        for( int ii = 0; ii < QUERY_COUNT; ++ii )
+        {
+            const SEG& query = m_queries[ii];
+            bool       collide = false;
+            int        distance = INT_MAX;
+
+            for( int s = 0; s < chain.SegmentCount(); s++ )
+            {
+                collide |= chain.CSegment( s ).Collide( query, m_clearances[ii] );
+                distance = std::min( distance, chain.CSegment( s ).Distance( query.A ) );
+            }
+
+            BOOST_CHECK_EQUAL( chain.Collide( query, m_clearances[ii] ), collide );
+            BOOST_CHECK_EQUAL( chain.Distance( query.A, true ), distance );
+        }
+    }
+}
+
+
+/**
+ * Not a test as such: times the kernels against the plain loops over the SEG methods.
+ *
+ * Disabled, so that it does not slow down the test runs. Run it explicitly with
+ * qa_kimath --run_test=SegBatch/Benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE( Benchmark, *boost::unit_test::disabled() )
+{
+    using CLOCK = std::chrono::steady_clock;
+
+    auto msecs = []( CLOCK::time_point aStart )
+    {
+        return std::chrono::duration<double, std::milli>( CLOCK::now() - aStart ).count();
+    };
+
+    long long         checksum = 0;
+    CLOCK::time_point start = CLOCK::now();
+
+    for( int ii = 0; ii < QUERY_COUNT; ++ii )
+    {
+        checksum += referenceCollide( m_batch.Size(), m_queries[ii], m_clearances[ii] );
+        checksum += referenceDistance( m_queries[ii].A ) % 1000;
+    }
+
+    double reference = msecs( start );
+
+    BOOST_TEST_MESSAGE( "SEG loops: " << reference << " ms" );
+
+    for( SEG_BATCH::KERNEL kernel : supportedKernels() )
+    {
+        long long sum = 0;
+
+        BOOST_REQUIRE( SEG_BATCH::SetKernel( kernel ) );
+        start = CLOCK::now();
+
+        for( int ii = 0; ii < QUERY_COUNT; ++ii )
+        {
+            sum += m_batch.Collide( m_queries[ii], m_clearances[ii] );
+            sum += m_batch.SquaredDistance( m_queries[ii].A ) % 1000;
+        }
+
+        double time = msecs( start );
+
+        BOOST_TEST_MESSAGE( SEG_BATCH::KernelName( kernel ) << ": " << time << " ms, x"
+                                                            << reference / time );
+        BOOST_CHECK_EQUAL( sum, checksum );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
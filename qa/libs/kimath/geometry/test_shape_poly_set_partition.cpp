@@ -0,0 +1,207 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * Test suite for the partitioned booleans of SHAPE_POLY_SET, checked against the single
+ * pass ones
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <geometry/shape_poly_set.h>
+
+#include <math/util.h>
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+
+/**
+ * A plane with a few holes, and a grid of overlapping octagonal knockouts over it
+ */
+struct PARTITION_FIXTURE
+{
+    PARTITION_FIXTURE()
+    {
+        m_plane.NewOutline();
+        m_plane.Append( 0, 0 );
+        m_plane.Append( 100000, 0 );
+        m_plane.Append( 100000, 80000 );
+        m_plane.Append( 0, 80000 );
+
+        for( int x = 20000; x < 100000; x += 30000 )
+        {
+            SHAPE_LINE_CHAIN hole;
+
+            hole.Append( x, 10000 );
+            hole.Append( x, 20000 );
+            hole.Append( x + 5000, 20000 );
+            hole.SetClosed( true );
+            m_plane.AddHole( hole );
+        }
+
+        for( int x = -2000; x < 104000; x += 3100 )
+        {
+            for( int y = -2000; y < 84000; y += 2900 )
+                addOctagon( x, y, 1000 + std::abs( x + y ) % 1700 );
+        }
+    }
+
+    void addOctagon( int aX, int aY, int aRadius )
+    {
+        m_knockouts.NewOutline();
+
+        for( int ii = 0; ii < 8; ++ii )
+        {
+            double angle = ( ii * 45.0 + 22.5 ) * M_PI / 180.0;
+
+            m_knockouts.Append( aX + KiROUND( aRadius * cos( angle ) ),
+                                aY + KiROUND( aRadius * sin( angle ) ) );
+        }
+    }
+
+    static double area( const SHAPE_POLY_SET& aSet )
+    {
+        double area = 0.0;
+
+        for( int ii = 0; ii < aSet.OutlineCount(); ++ii )
+        {
+            const SHAPE_POLY_SET::POLYGON& polygon = aSet.CPolygon( ii );
+
+            area += std::abs( polygon[0].Area() );
+
+            for( size_t jj = 1; jj < polygon.size(); ++jj )
+                area -= std::abs( polygon[jj].Area() );
+        }
+
+        return area;
+    }
+
+    /**
+     * Check that aResult covers the same area as aExpected, but for the rounding of the
+     * points where the tile borders cut edges.  That leaves slivers one unit wide along some
+     * edges, far below the area of the smallest knockout.
+     */
+    static void checkSameArea( const SHAPE_POLY_SET& aResult, const SHAPE_POLY_SET& aExpected )
+    {
+        SHAPE_POLY_SET missing = aExpected;
+        SHAPE_POLY_SET extra = aResult;
+
+        missing.BooleanSubtract( aResult, SHAPE_POLY_SET::PM_FAST );
+        extra.BooleanSubtract( aExpected, SHAPE_POLY_SET::PM_FAST );
+
+        double tolerance = area( aExpected ) * 1e-4;
+
+        BOOST_CHECK_GT( area( aExpected ), 0.0 );
+        BOOST_CHECK_CLOSE( area( aResult ), area( aExpected ), 1e-2 );
+        BOOST_CHECK_LE( area( missing ), tolerance );
+        BOOST_CHECK_LE( area( extra ), tolerance );
+    }
+
+    SHAPE_POLY_SET m_plane;
+    SHAPE_POLY_SET m_knockouts;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ShapePolySetPartition, PARTITION_FIXTURE )
+
+
+/**
+ * Partitioned differences match the single pass one whatever the number of tiles
+ */
+BOOST_AUTO_TEST_CASE( Subtract )
+{
+    SHAPE_POLY_SET expected = m_plane;
+    expected.BooleanSubtract( m_knockouts, SHAPE_POLY_SET::PM_FAST );
+
+    for( int tiles : { 1, 2, 3, 7, 16 } )
+    {
+        BOOST_TEST_CONTEXT( "Tiles: " << tiles )
+        {
+            SHAPE_POLY_SET result = m_plane;
+            result.BooleanSubtractPartitioned( m_knockouts, SHAPE_POLY_SET::PM_FAST, tiles );
+
+            checkSameArea( result, expected );
+        }
+    }
+}
+
+
+/**
+ * Partitioned simplification matches the single pass one
+ */
+BOOST_AUTO_TEST_CASE( Simplify )
+{
+    SHAPE_POLY_SET expected = m_knockouts;
+    expected.Simplify( SHAPE_POLY_SET::PM_FAST );
+
+    for( int tiles : { 2, 5 } )
+    {
+        BOOST_TEST_CONTEXT( "Tiles: " << tiles )
+        {
+            SHAPE_POLY_SET result = m_knockouts;
+            result.SimplifyPartitioned( SHAPE_POLY_SET::PM_FAST, tiles );
+
+            checkSameArea( result, expected );
+        }
+    }
+}
+
+
+/**
+ * The executor is handed every tile exactly once
+ */
+BOOST_AUTO_TEST_CASE( Executor )
+{
+    std::vector<int> calls;
+
+    auto executor = [&]( size_t aCount, const std::function<void( size_t )>& aTask )
+    {
+        calls.assign( aCount, 0 );
+
+        // Run them backwards: the result must not depend on the order
+        for( size_t ii = aCount; ii > 0; --ii )
+        {
+            aTask( ii - 1 );
+            calls[ii - 1]++;
+        }
+    };
+
+    SHAPE_POLY_SET expected = m_plane;
+    expected.BooleanSubtract( m_knockouts, SHAPE_POLY_SET::PM_FAST );
+
+    SHAPE_POLY_SET result = m_plane;
+    result.BooleanSubtractPartitioned( m_knockouts, SHAPE_POLY_SET::PM_FAST, 4, executor );
+
+    BOOST_CHECK_EQUAL( calls.size(), 16 );
+
+    for( int count : calls )
+        BOOST_CHECK_EQUAL( count, 1 );
+
+    checkSameArea( result, expected );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,179 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * Test suite for the triangulation cache of SHAPE_POLY_SET
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <geometry/shape_poly_set.h>
+
+
+/**
+ * Three separate squares
+ */
+struct TRIANGULATION_FIXTURE
+{
+    TRIANGULATION_FIXTURE()
+    {
+        for( int ii = 0; ii < 3; ++ii )
+            addSquare( m_squares, ii * 20000 );
+    }
+
+    static void addSquare( SHAPE_POLY_SET& aSet, int aX )
+    {
+        aSet.NewOutline();
+        aSet.Append( aX, 0 );
+        aSet.Append( aX + 10000, 0 );
+        aSet.Append( aX + 10000, 10000 );
+        aSet.Append( aX, 10000 );
+    }
+
+    ///> @return true if all the triangle vertices of aSet are vertices of its polygons
+    static bool trianglesMatch( const SHAPE_POLY_SET& aSet )
+    {
+        for( unsigned ii = 0; ii < aSet.TriangulatedPolyCount(); ++ii )
+        {
+            const SHAPE_POLY_SET::TRIANGULATED_POLYGON* poly = aSet.TriangulatedPolygon( ii );
+
+            for( size_t jj = 0; jj < poly->GetTriangleCount(); ++jj )
+            {
+                VECTOR2I v[3];
+                poly->GetTriangle( jj, v[0], v[1], v[2] );
+
+                for( const VECTOR2I& vertex : v )
+                {
+                    bool found = false;
+
+                    for( auto it = aSet.CIterate(); it && !found; ++it )
+                        found = ( *it == vertex );
+
+                    if( !found )
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    SHAPE_POLY_SET m_squares;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ShapePolySetTriangulation, TRIANGULATION_FIXTURE )
+
+
+/**
+ * A set triangulated again without changes keeps all its triangles
+ */
+BOOST_AUTO_TEST_CASE( CacheHit )
+{
+    SHAPE_POLY_SET::TRIANGULATION_STATS stats;
+
+    m_squares.CacheTriangulation( SHAPE_POLY_SET::TASK_EXECUTOR(), &stats );
+
+    BOOST_CHECK( m_squares.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( stats.m_triangulated, 3 );
+    BOOST_CHECK_EQUAL( m_squares.TriangulatedPolyCount(), 3 );
+    BOOST_CHECK( trianglesMatch( m_squares ) );
+
+    m_squares.CacheTriangulation( SHAPE_POLY_SET::TASK_EXECUTOR(), &stats );
+
+    BOOST_CHECK( m_squares.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( stats.m_reused, 3 );
+    BOOST_CHECK_EQUAL( stats.m_triangulated, 0 );
+}
+
+
+/**
+ * Editing a polygon makes the triangulation out of date, and only that polygon is
+ * triangulated again
+ */
+BOOST_AUTO_TEST_CASE( EditInvalidates )
+{
+    SHAPE_POLY_SET::TRIANGULATION_STATS stats;
+
+    m_squares.CacheTriangulation();
+
+    // The first corner of the second square
+    m_squares.SetVertex( 4, VECTOR2I( 21000, 1000 ) );
+
+    BOOST_CHECK( !m_squares.IsTriangulationUpToDate() );
+
+    m_squares.CacheTriangulation( SHAPE_POLY_SET::TASK_EXECUTOR(), &stats );
+
+    BOOST_CHECK( m_squares.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( stats.m_reused, 2 );
+    BOOST_CHECK_EQUAL( stats.m_triangulated, 1 );
+    BOOST_CHECK( trianglesMatch( m_squares ) );
+}
+
+
+/**
+ * An assigned set never shows its previous triangles, but reuses them for the polygons it
+ * still has.  A set assigned from an up to date one takes its triangulation.
+ */
+BOOST_AUTO_TEST_CASE( Assignment )
+{
+    SHAPE_POLY_SET::TRIANGULATION_STATS stats;
+    SHAPE_POLY_SET                      moved;
+
+    m_squares.CacheTriangulation();
+
+    // The same first two squares, and a new third one
+    addSquare( moved, 0 );
+    addSquare( moved, 20000 );
+    addSquare( moved, 100000 );
+
+    m_squares = moved;
+
+    BOOST_CHECK( !m_squares.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( m_squares.TriangulatedPolyCount(), 0 );
+
+    m_squares.CacheTriangulation( SHAPE_POLY_SET::TASK_EXECUTOR(), &stats );
+
+    BOOST_CHECK( m_squares.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( stats.m_reused, 2 );
+    BOOST_CHECK_EQUAL( stats.m_triangulated, 1 );
+    BOOST_CHECK( trianglesMatch( m_squares ) );
+
+    SHAPE_POLY_SET copy;
+
+    addSquare( copy, 500000 );
+    copy.CacheTriangulation();
+    copy = m_squares;
+
+    BOOST_CHECK( copy.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( copy.TriangulatedPolyCount(), m_squares.TriangulatedPolyCount() );
+    BOOST_CHECK( trianglesMatch( copy ) );
+
+    copy.CacheTriangulation( SHAPE_POLY_SET::TASK_EXECUTOR(), &stats );
+
+    BOOST_CHECK_EQUAL( stats.m_triangulated, 0 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
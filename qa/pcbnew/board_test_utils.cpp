@@ -25,6 +25,8 @@
 
 #include <pcbnew_utils/board_file_utils.h>
 
+#include <kicad_plugin.h>
+
 // For the temp directory logic: can be std::filesystem in C++17
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
@@ -50,4 +52,13 @@ void BOARD_DUMPER::DumpBoardToFile( BOARD& aBoard, const std::string& aName ) co
     ::KI_TEST::DumpBoardToFile( aBoard, path.string() );
 }
 
+
+std::string FormatBoard( BOARD* aBoard )
+{
+    PCB_IO io;
+
+    io.Format( aBoard );
+    return io.GetStringOutput( true );
+}
+
 } // namespace KI_TEST
\ No newline at end of file
@@ -58,6 +58,12 @@ public:
     const bool m_dump_boards;
 };
 
+
+/**
+ * Format a board as PCB_IO saves it, to compare boards through their text.
+ */
+std::string FormatBoard( BOARD* aBoard );
+
 } // namespace KI_TEST
 
 #endif // QA_PCBNEW_BOARD_TEST_UTILS__H
\ No newline at end of file
@@ -0,0 +1,320 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <class_marker_pcb.h>
+#include <class_track.h>
+#include <drc/drc.h>
+#include <drc/drc_rtree.h>
+
+#include <drc/drc_incremental.h>
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+
+/**
+ * A row of vertical tracks, one of them close to its neighbour, and a stand-in for the DRC
+ * track test: a marker for each pair of tracks closer than CLEARANCE
+ */
+struct DRC_INCREMENTAL_FIXTURE
+{
+    static const int CLEARANCE = 200000;
+
+    typedef std::pair<KIID, KIID> KIID_PAIR;
+
+    DRC_INCREMENTAL_FIXTURE() :
+            m_incremental( m_index )
+    {
+        for( int ii = 0; ii < 10; ++ii )
+            m_tracks.push_back( addTrack( ii * 1000000 ) );
+
+        m_close = addTrack( 300000 );
+
+        for( const KIID_PAIR& pair : fullRun() )
+            m_board.Add( makeMarker( findTrack( pair.first ), findTrack( pair.second ) ) );
+
+        m_index.Build( &m_board );
+        m_incremental.Start( &m_board );
+
+        m_test = [&]( TRACK* aTrack, const std::vector<TRACK*>& aTracks,
+                      const std::vector<D_PAD*>&, const std::vector<ZONE_CONTAINER*>&,
+                      std::vector<MARKER_PCB*>& aMarkers )
+                 {
+                     for( TRACK* track : aTracks )
+                     {
+                         if( track != aTrack && tooClose( aTrack, track ) )
+                             aMarkers.push_back( makeMarker( aTrack, track ) );
+                     }
+                 };
+    }
+
+    TRACK* addTrack( int aX )
+    {
+        TRACK* track = new TRACK( &m_board );
+
+        track->SetStart( wxPoint( aX, 0 ) );
+        track->SetEnd( wxPoint( aX, 5000000 ) );
+        track->SetWidth( 250000 );
+        track->SetLayer( F_Cu );
+        m_board.Add( track, ADD_MODE::APPEND );
+
+        return track;
+    }
+
+    static void moveTrack( TRACK* aTrack, int aX )
+    {
+        aTrack->SetStart( wxPoint( aX, 0 ) );
+        aTrack->SetEnd( wxPoint( aX, 5000000 ) );
+    }
+
+    TRACK* findTrack( const KIID& aId )
+    {
+        for( TRACK* track : m_board.Tracks() )
+        {
+            if( track->m_Uuid == aId )
+                return track;
+        }
+
+        return nullptr;
+    }
+
+    static bool tooClose( TRACK* aA, TRACK* aB )
+    {
+        SEG a( aA->GetStart(), aA->GetEnd() );
+        SEG b( aB->GetStart(), aB->GetEnd() );
+
+        return a.Distance( b ) < ( aA->GetWidth() + aB->GetWidth() ) / 2 + CLEARANCE;
+    }
+
+    static MARKER_PCB* makeMarker( TRACK* aA, TRACK* aB )
+    {
+        return new MARKER_PCB( EDA_UNITS::MILLIMETRES, DRCE_TRACKS_CROSSING, aA->GetStart(), aA,
+                               aB );
+    }
+
+    static KIID_PAIR markerPair( const MARKER_PCB* aMarker )
+    {
+        KIID a = aMarker->GetRCItem()->GetMainItemID();
+        KIID b = aMarker->GetRCItem()->GetAuxItemID();
+
+        return b < a ? KIID_PAIR( b, a ) : KIID_PAIR( a, b );
+    }
+
+    ///> The pairs of tracks too close, tested all against all
+    std::set<KIID_PAIR> fullRun()
+    {
+        std::set<KIID_PAIR> pairs;
+
+        for( TRACK* a : m_board.Tracks() )
+        {
+            for( TRACK* b : m_board.Tracks() )
+            {
+                if( a->m_Uuid < b->m_Uuid && tooClose( a, b ) )
+                    pairs.emplace( a->m_Uuid, b->m_Uuid );
+            }
+        }
+
+        return pairs;
+    }
+
+    std::set<KIID_PAIR> boardPairs()
+    {
+        std::set<KIID_PAIR> pairs;
+
+        for( MARKER_PCB* marker : m_board.Markers() )
+            pairs.insert( markerPair( marker ) );
+
+        return pairs;
+    }
+
+    /**
+     * Run the incremental tests and apply their results to the board, as the DRC does.
+     *
+     * @param aStalePairs receives the tracks of the deleted markers.
+     */
+    void run( std::vector<MARKER_PCB*>& aNewMarkers, std::vector<KIID_PAIR>& aStalePairs )
+    {
+        std::vector<MARKER_PCB*> staleMarkers;
+
+        BOOST_CHECK( m_incremental.Run( m_test, std::chrono::steady_clock::now()
+                                                        + std::chrono::hours( 1 ),
+                                        aNewMarkers, staleMarkers ) );
+
+        for( MARKER_PCB* marker : staleMarkers )
+        {
+            aStalePairs.push_back( markerPair( marker ) );
+            m_board.Remove( marker );
+            delete marker;
+        }
+
+        for( MARKER_PCB* marker : aNewMarkers )
+            m_board.Add( marker );
+
+        BOOST_CHECK( !m_incremental.HasChanges() );
+    }
+
+    static bool involves( const KIID_PAIR& aPair, TRACK* aTrack )
+    {
+        return aPair.first == aTrack->m_Uuid || aPair.second == aTrack->m_Uuid;
+    }
+
+    BOARD                       m_board;
+    DRC_RTREE                   m_index;
+    DRC_INCREMENTAL             m_incremental;
+    DRC_INCREMENTAL::TRACK_TEST m_test;
+    std::vector<TRACK*>         m_tracks;
+    TRACK*                      m_close;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( DrcIncremental, DRC_INCREMENTAL_FIXTURE )
+
+
+/**
+ * Only the markers of a changed track are made again, and the board ends up with the markers
+ * of a full run
+ */
+BOOST_AUTO_TEST_CASE( ChangedTrack )
+{
+    TRACK* moved = m_tracks[5];
+
+    BOOST_REQUIRE_EQUAL( m_board.Markers().size(), 1u );
+
+    MARKER_PCB* unrelated = m_board.Markers()[0];
+
+    for( int x : { 4200000, 5000000, 300000 } )
+    {
+        BOOST_TEST_CONTEXT( "x: " << x )
+        {
+            std::vector<MARKER_PCB*> newMarkers;
+            std::vector<KIID_PAIR>   stalePairs;
+
+            moveTrack( moved, x );
+            m_incremental.ItemChanged( moved );
+            run( newMarkers, stalePairs );
+
+            for( MARKER_PCB* marker : newMarkers )
+                BOOST_CHECK( involves( markerPair( marker ), moved ) );
+
+            for( const KIID_PAIR& pair : stalePairs )
+                BOOST_CHECK( involves( pair, moved ) );
+
+            // The markers of the other tracks are left alone
+            BOOST_CHECK( std::count( m_board.Markers().begin(), m_board.Markers().end(),
+                                     unrelated ) == 1 );
+
+            BOOST_CHECK( ( boardPairs() == fullRun() ) );
+        }
+    }
+
+    // Close to the track near m_close: both markers
+    BOOST_CHECK_EQUAL( m_board.Markers().size(), 3u );
+
+    // The index follows the track
+    std::vector<TRACK*> found;
+
+    m_index.QueryTracks( EDA_RECT( wxPoint( 5000000, 1000000 ), wxSize( 10, 10 ) ), LSET( F_Cu ),
+                         found );
+    BOOST_CHECK( std::find( found.begin(), found.end(), moved ) == found.end() );
+
+    m_index.QueryTracks( EDA_RECT( wxPoint( 300000, 1000000 ), wxSize( 10, 10 ) ), LSET( F_Cu ),
+                         found );
+    BOOST_CHECK( std::find( found.begin(), found.end(), moved ) != found.end() );
+}
+
+
+/**
+ * The markers of a removed track are dropped, and nothing is tested again
+ */
+BOOST_AUTO_TEST_CASE( RemovedTrack )
+{
+    std::vector<MARKER_PCB*> newMarkers;
+    std::vector<KIID_PAIR>   stalePairs;
+
+    BOOST_REQUIRE_EQUAL( m_board.Markers().size(), 1u );
+
+    m_incremental.ItemRemoved( m_close );
+    m_board.Remove( m_close );
+    delete m_close;
+
+    run( newMarkers, stalePairs );
+
+    BOOST_CHECK( newMarkers.empty() );
+    BOOST_CHECK_EQUAL( stalePairs.size(), 1u );
+    BOOST_CHECK( m_board.Markers().empty() );
+    BOOST_CHECK_EQUAL( m_index.TrackCount(), m_board.Tracks().size() );
+}
+
+
+/**
+ * Tracks added without being reported (outside of a commit) make the index start over
+ */
+BOOST_AUTO_TEST_CASE( UnreportedChange )
+{
+    std::vector<MARKER_PCB*> newMarkers;
+    std::vector<KIID_PAIR>   stalePairs;
+
+    addTrack( 9200000 );
+
+    m_incremental.ItemChanged( m_tracks[0] );
+    run( newMarkers, stalePairs );
+
+    BOOST_CHECK_EQUAL( m_index.TrackCount(), m_board.Tracks().size() );
+}
+
+
+/**
+ * What doesn't fit in the time budget is tested by the next calls
+ */
+BOOST_AUTO_TEST_CASE( Budget )
+{
+    std::vector<TRACK*> far;
+
+    for( int ii = 0; ii < 500; ++ii )
+    {
+        far.push_back( addTrack( 20000000 + ii * 1000000 ) );
+        m_incremental.ItemChanged( far.back() );
+    }
+
+    std::vector<MARKER_PCB*> newMarkers;
+    std::vector<MARKER_PCB*> staleMarkers;
+
+    // A single batch at most when the deadline has passed
+    BOOST_CHECK( !m_incremental.Run( m_test, std::chrono::steady_clock::now(), newMarkers,
+                                     staleMarkers ) );
+    BOOST_CHECK( m_incremental.HasChanges() );
+    BOOST_CHECK( newMarkers.empty() && staleMarkers.empty() );
+
+    std::vector<KIID_PAIR> stalePairs;
+
+    run( newMarkers, stalePairs );
+
+    BOOST_CHECK( ( boardPairs() == fullRun() ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
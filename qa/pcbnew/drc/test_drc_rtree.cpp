@@ -0,0 +1,177 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+
+#include <drc/drc_rtree.h>
+
+#include <algorithm>
+
+
+/**
+ * A board with a grid of tracks on both outer layers, a few vias, and a footprint with an SMD
+ * pad and a through hole pad
+ */
+struct DRC_RTREE_FIXTURE
+{
+    DRC_RTREE_FIXTURE()
+    {
+        for( int ii = 0; ii < 20; ++ii )
+        {
+            TRACK* track = new TRACK( &m_board );
+
+            track->SetStart( wxPoint( ii * 1000000, 0 ) );
+            track->SetEnd( wxPoint( ii * 1000000, 5000000 ) );
+            track->SetWidth( 250000 );
+            track->SetLayer( ii % 2 ? B_Cu : F_Cu );
+            m_board.Add( track, ADD_MODE::APPEND );
+
+            if( ii % 5 == 0 )
+            {
+                VIA* via = new VIA( &m_board );
+
+                via->SetPosition( wxPoint( ii * 1000000, 6000000 ) );
+                via->SetWidth( 600000 );
+                via->SetLayerPair( F_Cu, B_Cu );
+                m_board.Add( via, ADD_MODE::APPEND );
+            }
+        }
+
+        MODULE* module = new MODULE( &m_board );
+
+        m_smdPad = new D_PAD( module );
+        m_smdPad->SetLayerSet( D_PAD::SMDMask() );
+        m_smdPad->SetSize( wxSize( 1000000, 1000000 ) );
+        m_smdPad->SetPosition( wxPoint( 3000000, 10000000 ) );
+        module->Add( m_smdPad );
+
+        m_thPad = new D_PAD( module );
+        m_thPad->SetLayerSet( D_PAD::StandardMask() );
+        m_thPad->SetSize( wxSize( 1500000, 1500000 ) );
+        m_thPad->SetDrillSize( wxSize( 800000, 800000 ) );
+        m_thPad->SetPosition( wxPoint( 6000000, 10000000 ) );
+        module->Add( m_thPad );
+
+        m_board.Add( module, ADD_MODE::APPEND );
+
+        m_index.Build( &m_board );
+    }
+
+    BOARD     m_board;
+    D_PAD*    m_smdPad;
+    D_PAD*    m_thPad;
+    DRC_RTREE m_index;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( DrcRtree, DRC_RTREE_FIXTURE )
+
+
+/**
+ * Queries find every track a brute force scan finds, in board order and only once
+ */
+BOOST_AUTO_TEST_CASE( TrackQueryMatchesScan )
+{
+    const std::vector<TRACK*>& tracks = m_index.Tracks();
+
+    BOOST_REQUIRE_EQUAL( tracks.size(), m_board.Tracks().size() );
+
+    for( const LSET& layers : { LSET( F_Cu ), LSET( B_Cu ), LSET( In1_Cu ), LSET::AllCuMask() } )
+    {
+        for( int x = -1000000; x < 21000000; x += 700000 )
+        {
+            EDA_RECT area( wxPoint( x, 1000000 ), wxSize( 1500000, 5500000 ) );
+
+            for( size_t first : { 0, 7 } )
+            {
+                std::vector<TRACK*> found;
+                std::vector<TRACK*> expected;
+
+                m_index.QueryTracks( area, layers, found, first );
+
+                for( size_t ii = first; ii < tracks.size(); ++ii )
+                {
+                    if( ( tracks[ii]->GetLayerSet() & layers ).any()
+                            && tracks[ii]->GetBoundingBox().Intersects( area ) )
+                    {
+                        expected.push_back( tracks[ii] );
+                    }
+                }
+
+                BOOST_TEST_CONTEXT( "x: " << x << ", first: " << first )
+                {
+                    // Every candidate of the scan is found...
+                    BOOST_CHECK( std::includes( found.begin(), found.end(), expected.begin(),
+                                                expected.end(),
+                                                [&]( TRACK* a, TRACK* b )
+                                                {
+                                                    return std::find( tracks.begin(), tracks.end(), a )
+                                                           < std::find( tracks.begin(), tracks.end(), b );
+                                                } ) );
+
+                    // ...in board order, once, and never before the first track asked for
+                    for( size_t ii = 1; ii < found.size(); ++ii )
+                    {
+                        BOOST_CHECK( std::find( tracks.begin(), tracks.end(), found[ii - 1] )
+                                     < std::find( tracks.begin(), tracks.end(), found[ii] ) );
+                    }
+
+                    for( TRACK* track : found )
+                    {
+                        BOOST_CHECK( std::find( tracks.begin(), tracks.end(), track )
+                                     >= tracks.begin() + first );
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * Drilled pads are found on every copper layer, other pads only on their own
+ */
+BOOST_AUTO_TEST_CASE( PadLayers )
+{
+    EDA_RECT            area( wxPoint( 0, 8000000 ), wxSize( 10000000, 4000000 ) );
+    std::vector<D_PAD*> found;
+
+    m_index.QueryPads( area, LSET( F_Cu ), found );
+    BOOST_CHECK( ( found == std::vector<D_PAD*>{ m_smdPad, m_thPad } ) );
+
+    m_index.QueryPads( area, LSET( In2_Cu ), found );
+    BOOST_CHECK( ( found == std::vector<D_PAD*>{ m_thPad } ) );
+
+    // Outside of the pads
+    m_index.QueryPads( EDA_RECT( wxPoint( 0, 0 ), wxSize( 1000, 1000 ) ), LSET::AllCuMask(),
+                       found );
+    BOOST_CHECK( found.empty() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,242 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include "board_test_utils.h"
+
+#include <board_snapshot.h>
+#include <class_board.h>
+#include <class_module.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <pcb_parser.h>
+#include <richio.h>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include <memory>
+
+
+/**
+ * A board with a net, a footprint, the three kinds of tracks and a filled zone, and a
+ * temporary file name for its snapshot
+ */
+struct BOARD_SNAPSHOT_FIXTURE
+{
+    BOARD_SNAPSHOT_FIXTURE()
+    {
+        NETINFO_ITEM* net = new NETINFO_ITEM( &m_board, "GND", 1 );
+        m_board.Add( net );
+
+        MODULE* module = new MODULE( &m_board );
+        module->SetReference( "U1" );
+        m_board.Add( module, ADD_MODE::APPEND );
+
+        TRACK* track = new TRACK( &m_board );
+        track->SetStart( wxPoint( 0, 0 ) );
+        track->SetEnd( wxPoint( 1000000, 0 ) );
+        track->SetWidth( 250000 );
+        track->SetLayer( B_Cu );
+        track->SetNet( net );
+        m_board.Add( track, ADD_MODE::APPEND );
+
+        ARC* arc = new ARC( &m_board );
+        arc->SetStart( wxPoint( 1000000, 0 ) );
+        arc->SetMid( wxPoint( 1500000, 500000 ) );
+        arc->SetEnd( wxPoint( 2000000, 0 ) );
+        arc->SetWidth( 200000 );
+        arc->SetLayer( F_Cu );
+        m_board.Add( arc, ADD_MODE::APPEND );
+
+        VIA* via = new VIA( &m_board );
+        via->SetViaType( VIATYPE::BLIND_BURIED );
+        via->SetStart( wxPoint( 2000000, 0 ) );
+        via->SetEnd( wxPoint( 2000000, 0 ) );
+        via->SetWidth( 600000 );
+        via->SetDrill( 300000 );
+        via->SetLayerPair( F_Cu, In1_Cu );
+        via->SetNet( net );
+        m_board.Add( via, ADD_MODE::APPEND );
+
+        ZONE_CONTAINER* zone = new ZONE_CONTAINER( &m_board );
+        zone->SetLayer( B_Cu );
+        zone->SetNet( net );
+        zone->Outline()->NewOutline();
+        zone->Outline()->Append( 0, 0 );
+        zone->Outline()->Append( 5000000, 0 );
+        zone->Outline()->Append( 5000000, 5000000 );
+
+        SHAPE_POLY_SET fill;
+        SHAPE_LINE_CHAIN hole;
+
+        fill.NewOutline();
+        fill.Append( 100000, 100000 );
+        fill.Append( 4000000, 100000 );
+        fill.Append( 4000000, 3000000 );
+        hole.Append( 3000000, 500000 );
+        hole.Append( 3500000, 500000 );
+        hole.Append( 3500000, 1000000 );
+        hole.SetClosed( true );
+        fill.AddHole( hole );
+        zone->SetFilledPolysList( fill );
+        zone->SetIsFilled( true );
+        m_board.Add( zone, ADD_MODE::APPEND );
+
+        m_sourceHash.Hash( reinterpret_cast<uint8_t*>( const_cast<char*>( "board" ) ), 5 );
+        m_sourceHash.Finalize();
+
+        m_path = wxFileName::CreateTempFileName( "snapshot" );
+    }
+
+    ~BOARD_SNAPSHOT_FIXTURE()
+    {
+        wxRemoveFile( m_path );
+    }
+
+    BOARD    m_board;
+    MD5_HASH m_sourceHash;
+    wxString m_path;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( BoardSnapshot, BOARD_SNAPSHOT_FIXTURE )
+
+
+/**
+ * A board restored from its snapshot is the board parsed from its file
+ */
+BOOST_AUTO_TEST_CASE( RoundTrip )
+{
+    BOARD_SNAPSHOT snapshot;
+
+    snapshot.Store( &m_board );
+    snapshot.Write( m_path, m_sourceHash );
+    snapshot.Clear();
+
+    BOOST_REQUIRE( snapshot.Read( m_path, m_sourceHash ) );
+
+    std::unique_ptr<BOARD> restored( snapshot.Restore( "snapshot" ) );
+
+    std::string        text = KI_TEST::FormatBoard( &m_board );
+    STRING_LINE_READER reader( text, "test" );
+    PCB_PARSER         parser( &reader );
+    std::unique_ptr<BOARD> parsed( dynamic_cast<BOARD*>( parser.Parse() ) );
+
+    BOOST_REQUIRE( restored );
+    BOOST_REQUIRE( parsed );
+    BOOST_CHECK_EQUAL( restored->Tracks().size(), 3 );
+    BOOST_CHECK( restored->GetArea( 0 )->GetFilledPolysList().GetHash()
+                 == m_board.GetArea( 0 )->GetFilledPolysList().GetHash() );
+    BOOST_CHECK( KI_TEST::FormatBoard( restored.get() ) == KI_TEST::FormatBoard( parsed.get() ) );
+}
+
+
+/**
+ * Snapshots of another board file, or damaged ones, are not read
+ */
+BOOST_AUTO_TEST_CASE( Rejected )
+{
+    BOARD_SNAPSHOT snapshot;
+
+    snapshot.Store( &m_board );
+    snapshot.Write( m_path, m_sourceHash );
+
+    MD5_HASH otherHash;
+    otherHash.Hash( reinterpret_cast<uint8_t*>( const_cast<char*>( "other" ) ), 5 );
+    otherHash.Finalize();
+
+    BOOST_CHECK( !snapshot.Read( m_path, otherHash ) );
+    BOOST_CHECK( !snapshot.Read( m_path + "-missing", m_sourceHash ) );
+
+    // Flip a byte of the last section
+    {
+        wxFFile file( m_path, "r+b" );
+        char    byte;
+
+        file.Seek( -1, wxFromEnd );
+        file.Read( &byte, 1 );
+        byte ^= 0x55;
+        file.Seek( -1, wxFromEnd );
+        file.Write( &byte, 1 );
+    }
+
+    BOOST_CHECK( !snapshot.Read( m_path, m_sourceHash ) );
+
+    // Cut it short
+    {
+        wxFFile file( m_path, "wb" );
+        file.Write( "KiCadSnp", 8 );
+    }
+
+    BOOST_CHECK( !snapshot.Read( m_path, m_sourceHash ) );
+}
+
+
+/**
+ * A damaged section count is rejected before anything is allocated for it
+ */
+BOOST_AUTO_TEST_CASE( CorruptCount )
+{
+    BOARD_SNAPSHOT snapshot;
+
+    snapshot.Store( &m_board );
+    snapshot.Write( m_path, m_sourceHash );
+
+    // The count follows the magic, three version numbers and the source hash
+    MD5_HASH sourceHash = m_sourceHash;
+    size_t   countOffset = 8 + 3 * sizeof( uint32_t ) + sizeof( uint32_t )
+                         + sourceHash.Format().size();
+
+    {
+        wxFFile  file( m_path, "r+b" );
+        uint32_t count = 0xFFFFFFFF;
+
+        file.Seek( countOffset );
+        file.Write( &count, sizeof( count ) );
+    }
+
+    BOOST_CHECK_NO_THROW( BOOST_CHECK( !snapshot.Read( m_path, m_sourceHash ) ) );
+}
+
+
+
+/**
+ * The hash of the board text PCB_IO::Save() writes is the hash of the file holding it
+ */
+BOOST_AUTO_TEST_CASE( HashString )
+{
+    std::string text = KI_TEST::FormatBoard( &m_board );
+
+    {
+        wxFFile file( m_path, "wb" );
+        file.Write( text.data(), text.size() );
+    }
+
+    BOOST_CHECK( BOARD_SNAPSHOT::HashString( text ) == BOARD_SNAPSHOT::HashFile( m_path ) );
+    BOOST_CHECK( BOARD_SNAPSHOT::HashString( text + " " ) != BOARD_SNAPSHOT::HashFile( m_path ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,214 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <connectivity/connectivity_algo.h>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+
+/**
+ * Three nets, each a row of tracks between two pads, with a via halfway
+ */
+struct CLUSTERS_FIXTURE
+{
+    static const int NET_COUNT = 3;
+    static const int TRACK_COUNT = 5;
+    static const int PITCH = 10000000;
+
+    CLUSTERS_FIXTURE()
+    {
+        for( int net = 1; net <= NET_COUNT; ++net )
+        {
+            m_board.Add( new NETINFO_ITEM( &m_board, wxString::Format( "N%d", net ), net ) );
+
+            int y = net * PITCH;
+
+            for( int x : { 0, TRACK_COUNT * PITCH } )
+            {
+                MODULE* module = new MODULE( &m_board );
+                D_PAD*  pad = new D_PAD( module );
+
+                module->SetPosition( wxPoint( x, y ) );
+                pad->SetName( "1" );
+                pad->SetLayerSet( D_PAD::SMDMask() );
+                pad->SetSize( wxSize( 1000000, 1000000 ) );
+                pad->SetPosition( module->GetPosition() );
+                module->Add( pad );
+                m_board.Add( module, ADD_MODE::APPEND );
+                pad->SetNetCode( net );
+            }
+
+            for( int ii = 0; ii < TRACK_COUNT; ++ii )
+            {
+                TRACK* track = new TRACK( &m_board );
+
+                track->SetStart( wxPoint( ii * PITCH, y ) );
+                track->SetEnd( wxPoint( ( ii + 1 ) * PITCH, y ) );
+                track->SetWidth( 250000 );
+                track->SetLayer( F_Cu );
+                m_board.Add( track, ADD_MODE::APPEND );
+                track->SetNetCode( net );
+                m_tracks.push_back( track );
+            }
+
+            VIA* via = new VIA( &m_board );
+
+            via->SetPosition( wxPoint( 2 * PITCH, y ) );
+            via->SetWidth( 600000 );
+            m_board.Add( via, ADD_MODE::APPEND );
+            via->SetNetCode( net );
+        }
+
+        m_algo.Build( &m_board );
+    }
+
+    using CLUSTER_SET = std::set<std::pair<int, std::vector<BOARD_CONNECTED_ITEM*>>>;
+
+    static CLUSTER_SET canonical( const CN_CONNECTIVITY_ALGO::CLUSTERS& aClusters )
+    {
+        CLUSTER_SET result;
+
+        for( const CN_CLUSTER_PTR& cluster : aClusters )
+        {
+            std::vector<BOARD_CONNECTED_ITEM*> items;
+
+            for( CN_ITEM* item : *cluster )
+                items.push_back( item->Parent() );
+
+            std::sort( items.begin(), items.end() );
+            result.emplace( cluster->OriginNet(), items );
+        }
+
+        return result;
+    }
+
+    /**
+     * Check the clusters kept up to date by the cluster index against the ones found by a
+     * full search
+     * @return the number of clusters.
+     */
+    size_t checkClusters()
+    {
+        const KICAD_T types[] = { PCB_TRACE_T, PCB_ARC_T, PCB_PAD_T, PCB_VIA_T,
+                                  PCB_ZONE_AREA_T, PCB_MODULE_T, EOT };
+
+        CLUSTER_SET incremental = canonical(
+                m_algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_RATSNEST ) );
+        CLUSTER_SET full = canonical(
+                m_algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_RATSNEST, types, -1 ) );
+
+        BOOST_CHECK( incremental == full );
+        return incremental.size();
+    }
+
+    BOARD                m_board;
+    CN_CONNECTIVITY_ALGO m_algo;
+    std::vector<TRACK*>  m_tracks;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ConnectivityClusters, CLUSTERS_FIXTURE )
+
+
+/**
+ * Removing a track splits its cluster, adding it back joins them again
+ */
+BOOST_AUTO_TEST_CASE( RemoveAdd )
+{
+    BOOST_CHECK_EQUAL( checkClusters(), NET_COUNT );
+
+    m_algo.Remove( m_tracks[3] );
+    BOOST_CHECK_EQUAL( checkClusters(), NET_COUNT + 1 );
+
+    m_algo.Remove( m_tracks[1] );
+    BOOST_CHECK_EQUAL( checkClusters(), NET_COUNT + 2 );
+
+    m_algo.Add( m_tracks[3] );
+    m_algo.Add( m_tracks[1] );
+    BOOST_CHECK_EQUAL( checkClusters(), NET_COUNT );
+
+    // A whole footprint at once
+    m_algo.Remove( m_board.Modules().front() );
+    BOOST_CHECK_EQUAL( checkClusters(), NET_COUNT );
+}
+
+
+/**
+ * Items changing nets without being removed and added again, as the net propagation does
+ */
+BOOST_AUTO_TEST_CASE( NetChange )
+{
+    checkClusters();
+
+    m_tracks[2]->SetNetCode( 2 );
+    BOOST_CHECK_EQUAL( checkClusters(), NET_COUNT + 2 );
+
+    m_tracks[2]->SetNetCode( 0 );
+    BOOST_CHECK_EQUAL( checkClusters(), NET_COUNT + 1 );
+
+    m_tracks[2]->SetNetCode( 1 );
+    BOOST_CHECK_EQUAL( checkClusters(), NET_COUNT );
+}
+
+
+/**
+ * A sequence of edits, checked after each one
+ */
+BOOST_AUTO_TEST_CASE( EditSequence )
+{
+    std::vector<bool> present( m_tracks.size(), true );
+    unsigned          seed = 12345;
+
+    for( int step = 0; step < 100; ++step )
+    {
+        seed = seed * 1103515245 + 12345;
+
+        size_t ii = ( seed >> 8 ) % m_tracks.size();
+
+        BOOST_TEST_CONTEXT( "Step " << step << ", track " << ii )
+        {
+            if( present[ii] )
+                m_algo.Remove( m_tracks[ii] );
+            else
+                m_algo.Add( m_tracks[ii] );
+
+            present[ii] = !present[ii];
+
+            if( step % 7 == 0 )
+                m_tracks[( seed >> 16 ) % m_tracks.size()]->SetNetCode( 1 + seed % NET_COUNT );
+
+            checkClusters();
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,184 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_module.h>
+#include <class_pad.h>
+#include <kicad_plugin.h>
+
+#include <wx/datetime.h>
+#include <wx/ffile.h>
+#include <wx/filename.h>
+#include <wx/utils.h>
+
+
+/**
+ * A footprint library with one footprint, indexed in a temporary cache directory
+ */
+struct FP_CACHE_INDEX_FIXTURE
+{
+    FP_CACHE_INDEX_FIXTURE() :
+            m_time( 1, wxDateTime::Jan, 2020, 12 )
+    {
+        m_libPath = wxFileName::CreateTempFileName( "fpindex" );
+        wxRemoveFile( m_libPath );
+        m_cachePath = m_libPath + "-cache";
+        m_libPath += ".pretty";
+
+        // The index goes to the user cache directory
+        m_hadCacheHome = wxGetEnv( "XDG_CACHE_HOME", &m_cacheHome );
+        wxSetEnv( "XDG_CACHE_HOME", m_cachePath );
+
+        PCB_IO io;
+        io.FootprintLibCreate( m_libPath );
+
+        MODULE  module( nullptr );
+        D_PAD*  pad = new D_PAD( &module );
+
+        pad->SetName( "1" );
+        module.Add( pad );
+        module.SetFPID( LIB_ID( wxEmptyString, "R1" ) );
+        module.SetDescription( "first line\r\nsecond line" );
+        module.SetKeywords( "a b\tc {cr}" );
+        io.FootprintSave( m_libPath, &module );
+
+        setTime( m_time );
+    }
+
+    ~FP_CACHE_INDEX_FIXTURE()
+    {
+        wxFileName::Rmdir( m_libPath, wxPATH_RMDIR_RECURSIVE );
+        wxFileName::Rmdir( m_cachePath, wxPATH_RMDIR_RECURSIVE );
+
+        if( m_hadCacheHome )
+            wxSetEnv( "XDG_CACHE_HOME", m_cacheHome );
+        else
+            wxUnsetEnv( "XDG_CACHE_HOME" );
+    }
+
+    wxString footprintPath() const
+    {
+        return wxFileName( m_libPath, "R1.kicad_mod" ).GetFullPath();
+    }
+
+    void setTime( const wxDateTime& aTime )
+    {
+        wxFileName( footprintPath() ).SetTimes( nullptr, &aTime, nullptr );
+    }
+
+    ///> Edits the footprint file behind the back of the index
+    void replace( const wxString& aFrom, const wxString& aTo, const wxDateTime& aTime )
+    {
+        wxString content;
+
+        {
+            wxFFile file( footprintPath(), "rb" );
+            BOOST_REQUIRE( file.ReadAll( &content ) );
+        }
+
+        BOOST_REQUIRE_EQUAL( content.Replace( aFrom, aTo ), 1 );
+
+        {
+            wxFFile file( footprintPath(), "wb" );
+            BOOST_REQUIRE( file.Write( content ) );
+        }
+
+        setTime( aTime );
+    }
+
+    ///> Reads the library with a new plugin, and returns the description of the footprint
+    wxString readDescription()
+    {
+        PCB_IO   io;
+        wxString description;
+        wxString keywords;
+        unsigned padCount = 0;
+        unsigned uniquePadCount = 0;
+
+        BOOST_REQUIRE( io.GetEnumeratedFootprintInfo( m_libPath, "R1", &description, &keywords,
+                                                      &padCount, &uniquePadCount ) );
+        BOOST_CHECK_EQUAL( keywords, "a b\tc {cr}" );
+        BOOST_CHECK_EQUAL( padCount, 1u );
+        BOOST_CHECK_EQUAL( uniquePadCount, 1u );
+
+        return description;
+    }
+
+    wxString   m_libPath;
+    wxString   m_cachePath;
+    wxString   m_cacheHome;
+    bool       m_hadCacheHome;
+    wxDateTime m_time;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( FpCacheIndex, FP_CACHE_INDEX_FIXTURE )
+
+
+/**
+ * A footprint whose file did not change is listed from the index, line ends included, and
+ * parsed only when it is asked for
+ */
+BOOST_AUTO_TEST_CASE( IndexedFootprint )
+{
+    // Parsed, and written to the index
+    BOOST_CHECK_EQUAL( readDescription(), "first line\r\nsecond line" );
+
+    // Same size and time: the index is trusted
+    replace( "first", "FIRST", m_time );
+    BOOST_CHECK_EQUAL( readDescription(), "first line\r\nsecond line" );
+
+    PCB_IO        io;
+    const MODULE* module = io.GetEnumeratedFootprint( m_libPath, "R1" );
+
+    BOOST_REQUIRE( module );
+    BOOST_CHECK_EQUAL( module->GetDescription(), "FIRST line\r\nsecond line" );
+}
+
+
+/**
+ * A footprint file of another size is parsed again
+ */
+BOOST_AUTO_TEST_CASE( StaleSize )
+{
+    BOOST_CHECK_EQUAL( readDescription(), "first line\r\nsecond line" );
+
+    replace( "first", "longer first", m_time );
+    BOOST_CHECK_EQUAL( readDescription(), "longer first line\r\nsecond line" );
+}
+
+
+/**
+ * A footprint file modified since it was indexed is parsed again
+ */
+BOOST_AUTO_TEST_CASE( StaleTimestamp )
+{
+    BOOST_CHECK_EQUAL( readDescription(), "first line\r\nsecond line" );
+
+    replace( "first", "FIRST", m_time + wxTimeSpan::Hour() );
+    BOOST_CHECK_EQUAL( readDescription(), "FIRST line\r\nsecond line" );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,386 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * Test suite for the pads and vias drawn as shape instances by PCB_PAINTER: the instances
+ * expanded into vertices give the geometry the painter draws without instances.
+ *
+ * The GALs are OPENGL_WORKER_GALs, which tessellate like OPENGL_GAL but need no OpenGL
+ * context. The instanced draws of OPENGL_GAL itself can be compared to the plain ones by
+ * switching ShapeInstancing off in the advanced config, Mesa's software rasterizer
+ * (LIBGL_ALWAYS_SOFTWARE=1) does both.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <convert_basic_shapes_to_polygon.h>
+#include <gal/gal_display_options.h>
+#include <gal/opengl/opengl_gal.h>
+#include <gal/opengl/vertex_common.h>
+#include <pcb_painter.h>
+#include <view/view.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+
+using namespace KIGFX;
+
+
+/**
+ * What is compared between two groups: the triangulation of a shape depends on the rotation
+ * of its outline, so the triangles themselves are not, but the area they cover is.
+ */
+struct GROUP_SUMMARY
+{
+    GROUP_SUMMARY( const VERTEX* aVertices, unsigned int aSize ) :
+        m_area( 0.0 ),
+        m_radii( 0.0 ),
+        m_lineLengths( 0.0 )
+    {
+        VECTOR2D moment( 0.0, 0.0 );
+
+        for( int ii = 0; ii < 4; ++ii )
+        {
+            m_minColor[ii] = 255;
+            m_maxColor[ii] = 0;
+        }
+
+        m_min = VECTOR2D( INFINITY, INFINITY );
+        m_max = VECTOR2D( -INFINITY, -INFINITY );
+
+        for( unsigned int ii = 0; ii < aSize; ++ii )
+        {
+            const VERTEX& v = aVertices[ii];
+            int           mode = (int) v.shader[0];
+
+            m_modes[mode]++;
+            m_min.x = std::min( m_min.x, (double) v.x );
+            m_min.y = std::min( m_min.y, (double) v.y );
+            m_max.x = std::max( m_max.x, (double) v.x );
+            m_max.y = std::max( m_max.y, (double) v.y );
+
+            if( ( mode == SHADER_FILLED_CIRCLE || mode == SHADER_STROKED_CIRCLE )
+                    && v.shader[1] <= 3.0 )
+            {
+                m_radii += v.shader[2];
+            }
+            else if( mode >= SHADER_LINE_A && mode <= SHADER_LINE_F )
+            {
+                m_lineLengths += hypot( v.shader[2], v.shader[3] );
+            }
+
+            const GLubyte color[4] = { v.r, v.g, v.b, v.a };
+
+            for( int jj = 0; jj < 4; ++jj )
+            {
+                m_minColor[jj] = std::min( m_minColor[jj], (int) color[jj] );
+                m_maxColor[jj] = std::max( m_maxColor[jj], (int) color[jj] );
+            }
+        }
+
+        for( unsigned int ii = 0; ii + 2 < aSize; ii += 3 )
+        {
+            const VERTEX* t = &aVertices[ii];
+
+            if( t[0].shader[0] != SHADER_NONE || t[1].shader[0] != SHADER_NONE
+                    || t[2].shader[0] != SHADER_NONE )
+                continue;
+
+            double area = std::abs( ( (double) t[1].x - t[0].x ) * ( (double) t[2].y - t[0].y )
+                                    - ( (double) t[2].x - t[0].x ) * ( (double) t[1].y - t[0].y ) )
+                          / 2.0;
+
+            m_area += area;
+            moment += VECTOR2D( t[0].x + t[1].x + t[2].x, t[0].y + t[1].y + t[2].y ) * area / 3.0;
+        }
+
+        m_centroid = m_area > 0.0 ? moment / m_area : VECTOR2D( 0.0, 0.0 );
+    }
+
+    double             m_area;          ///< Area of the plain triangles
+    VECTOR2D           m_centroid;      ///< Centroid of the plain triangles
+    VECTOR2D           m_min;           ///< Bounding box of all the vertices
+    VECTOR2D           m_max;
+    std::map<int, int> m_modes;         ///< Number of vertices of each shader mode
+    double             m_radii;         ///< Sum of the radii of the circles
+    double             m_lineLengths;   ///< Sum of the lengths of the lines
+    int                m_minColor[4];
+    int                m_maxColor[4];
+};
+
+
+/**
+ * @param aMaxError is the error of the arcs approximated by segments: the segments of a
+ * rotated circle do not start at the same angle as the ones of a circle rotated afterwards.
+ */
+static void checkSummaries( const GROUP_SUMMARY& aExpanded, const GROUP_SUMMARY& aDirect,
+                            int aMaxError )
+{
+    // The shapes are rotated and moved in single precision, as the vertices are
+    const double tolerance = 10.0;
+
+    BOOST_CHECK( aExpanded.m_modes == aDirect.m_modes );
+    BOOST_CHECK_CLOSE( aExpanded.m_area + 1.0, aDirect.m_area + 1.0, 1e-3 );
+    BOOST_CHECK_SMALL( ( aExpanded.m_centroid - aDirect.m_centroid ).EuclideanNorm(), tolerance );
+    BOOST_CHECK_SMALL( ( aExpanded.m_min - aDirect.m_min ).EuclideanNorm(),
+                       tolerance + 2 * aMaxError );
+    BOOST_CHECK_SMALL( ( aExpanded.m_max - aDirect.m_max ).EuclideanNorm(),
+                       tolerance + 2 * aMaxError );
+    BOOST_CHECK_CLOSE( aExpanded.m_radii + 1.0, aDirect.m_radii + 1.0, 1e-4 );
+    BOOST_CHECK_CLOSE( aExpanded.m_lineLengths + 1.0, aDirect.m_lineLengths + 1.0, 1e-3 );
+
+    // The instance colors are stored as bytes, and multiply the (white) colors of the shapes
+    for( int ii = 0; ii < 4; ++ii )
+    {
+        BOOST_CHECK_LE( std::abs( aExpanded.m_minColor[ii] - aDirect.m_minColor[ii] ), 1 );
+        BOOST_CHECK_LE( std::abs( aExpanded.m_maxColor[ii] - aDirect.m_maxColor[ii] ), 1 );
+    }
+}
+
+
+/**
+ * A board with a few pad shapes used many times, in several orientations, and vias
+ */
+struct PAD_INSTANCES_FIXTURE
+{
+    static const int COPIES = 5;
+
+    PAD_INSTANCES_FIXTURE()
+    {
+        MODULE* module = new MODULE( &m_board );
+        m_board.Add( module, ADD_MODE::APPEND );
+
+        auto addPads = [&]( PAD_SHAPE_T aShape, const wxSize& aSize, bool aThroughHole )
+        {
+            for( double orientation : { 0.0, 450.0, 900.0, 305.0 } )
+            {
+                for( int ii = 0; ii < COPIES; ++ii )
+                {
+                    D_PAD* pad = new D_PAD( module );
+
+                    pad->SetShape( aShape );
+                    pad->SetSize( aSize );
+                    pad->SetOrientation( orientation );
+                    pad->SetPosition( wxPoint( 3000000 * ii, 3000000 * (int) m_items.size() ) );
+
+                    if( aThroughHole )
+                    {
+                        pad->SetAttribute( PAD_ATTRIB_STANDARD );
+                        pad->SetLayerSet( D_PAD::StandardMask() );
+                        pad->SetDrillShape( aSize.x == aSize.y ? PAD_DRILL_SHAPE_CIRCLE
+                                                               : PAD_DRILL_SHAPE_OBLONG );
+                        pad->SetDrillSize( wxSize( aSize.x / 2, aSize.y / 2 ) );
+                    }
+                    else
+                    {
+                        pad->SetAttribute( PAD_ATTRIB_SMD );
+                        pad->SetLayerSet( D_PAD::SMDMask() );
+                    }
+
+                    if( aShape == PAD_SHAPE_TRAPEZOID )
+                        pad->SetDelta( wxSize( 0, aSize.y / 4 ) );
+
+                    if( aShape == PAD_SHAPE_ROUNDRECT || aShape == PAD_SHAPE_CHAMFERED_RECT )
+                        pad->SetRoundRectRadiusRatio( 0.25 );
+
+                    if( aShape == PAD_SHAPE_CHAMFERED_RECT )
+                    {
+                        pad->SetChamferRectRatio( 0.2 );
+                        pad->SetChamferPositions( RECT_CHAMFER_TOP_LEFT );
+                    }
+
+                    module->Add( pad, ADD_MODE::APPEND );
+                    m_items.push_back( pad );
+                }
+            }
+        };
+
+        addPads( PAD_SHAPE_CIRCLE, wxSize( 1500000, 1500000 ), true );
+        addPads( PAD_SHAPE_OVAL, wxSize( 1200000, 2000000 ), true );
+        addPads( PAD_SHAPE_RECT, wxSize( 1500000, 1500000 ), true );
+        addPads( PAD_SHAPE_RECT, wxSize( 600000, 1100000 ), false );
+        addPads( PAD_SHAPE_ROUNDRECT, wxSize( 900000, 1300000 ), false );
+        addPads( PAD_SHAPE_CHAMFERED_RECT, wxSize( 1000000, 1400000 ), false );
+        addPads( PAD_SHAPE_TRAPEZOID, wxSize( 1000000, 1400000 ), false );
+
+        for( int ii = 0; ii < 4 * COPIES; ++ii )
+        {
+            VIA* via = new VIA( &m_board );
+
+            via->SetViaType( VIATYPE::THROUGH );
+            via->SetLayerPair( F_Cu, B_Cu );
+            via->SetPosition( wxPoint( 1500000 * ii, -5000000 ) );
+            via->SetWidth( ii % 2 ? 600000 : 800000 );
+            via->SetDrill( 300000 );
+            m_board.Add( via, ADD_MODE::APPEND );
+            m_items.push_back( via );
+        }
+    }
+
+    ///> Draws all the layers of all the items, a group per layer, as a VIEW would
+    static std::vector<int> draw( const std::vector<BOARD_ITEM*>& aItems, OPENGL_WORKER_GAL& aGal )
+    {
+        PCB_PAINTER      painter( &aGal );
+        std::vector<int> groups;
+
+        // Colors telling the layers apart, to check the colors of the instances
+        for( int layer = 0; layer < LAYER_ID_COUNT; ++layer )
+        {
+            painter.GetSettings()->SetLayerColor( layer, COLOR4D( ( layer % 7 ) / 7.0,
+                                                                  ( layer % 5 ) / 5.0, 0.6, 0.8 ) );
+        }
+
+        for( BOARD_ITEM* item : aItems )
+        {
+            int layers[VIEW::VIEW_MAX_LAYERS];
+            int layerCount;
+
+            item->ViewGetLayers( layers, layerCount );
+
+            for( int ii = 0; ii < layerCount; ++ii )
+            {
+                // The net names and pad numbers are text, which is not instanced
+                if( IsNetnameLayer( layers[ii] ) || layers[ii] == LAYER_PADS_NETNAMES
+                        || layers[ii] == LAYER_PAD_FR_NETNAMES
+                        || layers[ii] == LAYER_PAD_BK_NETNAMES
+                        || layers[ii] == LAYER_VIAS_NETNAMES )
+                {
+                    continue;
+                }
+
+                groups.push_back( aGal.BeginGroup() );
+                painter.Draw( item, layers[ii] );
+                aGal.EndGroup();
+            }
+        }
+
+        return groups;
+    }
+
+    BOARD                    m_board;
+    std::vector<BOARD_ITEM*> m_items;
+    GAL_DISPLAY_OPTIONS      m_options;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PadInstances, PAD_INSTANCES_FIXTURE )
+
+
+/**
+ * The pads and vias drawn as instances, expanded when adopted by a GAL that does not draw
+ * instances, give the geometry drawn without instances
+ */
+BOOST_AUTO_TEST_CASE( ExpandedMatchesDirect )
+{
+    OPENGL_WORKER_GAL instanced( m_options );
+    OPENGL_WORKER_GAL expanded( m_options );
+    OPENGL_WORKER_GAL direct( m_options );
+
+    instanced.SetShapeInstancing( true );
+    expanded.SetShapeInstancing( false );
+    direct.SetShapeInstancing( false );
+
+    std::vector<int> instancedGroups = draw( m_items, instanced );
+    std::vector<int> directGroups = draw( m_items, direct );
+
+    BOOST_REQUIRE_EQUAL( instancedGroups.size(), directGroups.size() );
+    BOOST_CHECK_EQUAL( direct.GetInstanceCount(), 0u );
+    BOOST_REQUIRE_GT( instanced.GetInstanceCount(), 0u );
+
+    for( size_t ii = 0; ii < instancedGroups.size(); ++ii )
+    {
+        BOOST_TEST_CONTEXT( "group " << ii )
+        {
+            int group = expanded.AdoptGroup( &instanced, instancedGroups[ii] );
+
+            BOOST_REQUIRE_GE( group, 0 );
+
+            const VERTEX* expandedVertices = nullptr;
+            const VERTEX* directVertices = nullptr;
+            unsigned int  expandedSize = 0;
+            unsigned int  directSize = 0;
+
+            BOOST_REQUIRE( expanded.GetGroupVertices( group, expandedVertices, expandedSize ) );
+            BOOST_REQUIRE( direct.GetGroupVertices( directGroups[ii], directVertices,
+                                                    directSize ) );
+            BOOST_REQUIRE_EQUAL( expandedSize, directSize );
+
+            checkSummaries( GROUP_SUMMARY( expandedVertices, expandedSize ),
+                            GROUP_SUMMARY( directVertices, directSize ),
+                            m_board.GetDesignSettings().m_MaxError );
+        }
+    }
+
+    BOOST_CHECK_EQUAL( expanded.GetInstanceCount(), 0u );
+}
+
+
+/**
+ * The pads of the same geometry share a shape whatever their position and orientation, and
+ * the shapes are shared again when the groups are adopted by a GAL drawing instances
+ */
+BOOST_AUTO_TEST_CASE( ShapesAreShared )
+{
+    OPENGL_WORKER_GAL instanced( m_options );
+    OPENGL_WORKER_GAL direct( m_options );
+    OPENGL_WORKER_GAL adopting( m_options );
+
+    instanced.SetShapeInstancing( true );
+    direct.SetShapeInstancing( false );
+    adopting.SetShapeInstancing( true );
+
+    std::vector<int> groups = draw( m_items, instanced );
+
+    draw( m_items, direct );
+
+    unsigned int shapeVertices = 0;
+
+    for( const OPENGL_GAL_BASE::INSTANCED_SHAPE& shape : instanced.GetShapes() )
+        shapeVertices += shape.m_vertices.size();
+
+    BOOST_TEST_MESSAGE( instanced.GetShapes().size() << " shapes (" << shapeVertices
+                        << " vertices), " << instanced.GetInstanceCount() << " instances, "
+                        << instanced.GetVertexCount() << " vertices instead of "
+                        << direct.GetVertexCount() );
+
+    // Each pad geometry is drawn at 4 orientations, COPIES times each
+    BOOST_CHECK_GE( instanced.GetInstanceCount(), COPIES * instanced.GetShapes().size() );
+    BOOST_CHECK_LT( instanced.GetVertexCount() + shapeVertices, direct.GetVertexCount() / 4 );
+
+    for( int group : groups )
+        BOOST_CHECK_GE( adopting.AdoptGroup( &instanced, group ), 0 );
+
+    BOOST_CHECK_EQUAL( adopting.GetShapes().size(), instanced.GetShapes().size() );
+    BOOST_CHECK_EQUAL( adopting.GetInstanceCount(), instanced.GetInstanceCount() );
+    BOOST_CHECK_EQUAL( adopting.GetVertexCount(), instanced.GetVertexCount() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,151 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include "board_test_utils.h"
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <pcb_parser.h>
+#include <richio.h>
+
+#include <algorithm>
+
+
+/**
+ * A board with enough footprints, tracks and zones for the parser to parse them in several
+ * batches
+ */
+struct PCB_PARSER_FIXTURE
+{
+    PCB_PARSER_FIXTURE()
+    {
+        for( int ii = 0; ii < 200; ++ii )
+        {
+            MODULE* module = new MODULE( &m_board );
+            D_PAD*  pad = new D_PAD( module );
+
+            module->SetReference( wxString::Format( "R%d", ii ) );
+            module->SetPosition( wxPoint( ii * 2000000, 0 ) );
+            pad->SetName( "1" );
+            pad->SetLayerSet( D_PAD::SMDMask() );
+            pad->SetSize( wxSize( 1000000, 1000000 ) );
+            pad->SetPosition( module->GetPosition() );
+            module->Add( pad );
+            m_board.Add( module, ADD_MODE::APPEND );
+
+            TRACK* track = ii % 3 ? new TRACK( &m_board ) : new VIA( &m_board );
+
+            track->SetStart( wxPoint( ii * 2000000, 0 ) );
+            track->SetEnd( wxPoint( ii * 2000000, 5000000 + ii ) );
+            track->SetWidth( 250000 );
+            track->SetLayer( F_Cu );
+            m_board.Add( track, ADD_MODE::APPEND );
+
+            if( ii % 50 == 0 )
+            {
+                ZONE_CONTAINER* zone = new ZONE_CONTAINER( &m_board );
+
+                zone->SetLayer( B_Cu );
+                zone->SetPriority( ii );
+                zone->Outline()->NewOutline();
+                zone->Outline()->Append( ii * 2000000, 0 );
+                zone->Outline()->Append( ii * 2000000 + 1000000, 0 );
+                zone->Outline()->Append( ii * 2000000 + 1000000, 1000000 );
+                m_board.Add( zone, ADD_MODE::APPEND );
+            }
+        }
+    }
+
+    static std::unique_ptr<BOARD> parse( const std::string& aText )
+    {
+        STRING_LINE_READER reader( aText, "test" );
+        PCB_PARSER         parser( &reader );
+
+        return std::unique_ptr<BOARD>( dynamic_cast<BOARD*>( parser.Parse() ) );
+    }
+
+    BOARD m_board;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PcbParser, PCB_PARSER_FIXTURE )
+
+
+/**
+ * The sections parsed in parallel end up in the board in file order: saving the board
+ * again gives the same file.  Tracks are inserted at the front of the list when loaded,
+ * as they always were, so that takes two round trips.
+ */
+BOOST_AUTO_TEST_CASE( RoundTrip )
+{
+    std::string            text = KI_TEST::FormatBoard( &m_board );
+    std::unique_ptr<BOARD> board = parse( text );
+
+    BOOST_REQUIRE( board );
+    BOOST_CHECK_EQUAL( board->Modules().size(), m_board.Modules().size() );
+    BOOST_CHECK_EQUAL( board->Tracks().size(), m_board.Tracks().size() );
+    BOOST_CHECK_EQUAL( board->Zones().size(), m_board.Zones().size() );
+
+    BOOST_CHECK( board->Modules().front()->GetReference() == "R0" );
+    BOOST_CHECK( board->Tracks().front()->GetEnd() == m_board.Tracks().back()->GetEnd() );
+
+    std::unique_ptr<BOARD> reloaded = parse( KI_TEST::FormatBoard( board.get() ) );
+
+    BOOST_REQUIRE( reloaded );
+    BOOST_CHECK( KI_TEST::FormatBoard( reloaded.get() ) == text );
+}
+
+
+/**
+ * An error in a section parsed on a worker is reported at its place in the file
+ */
+BOOST_AUTO_TEST_CASE( ErrorLocation )
+{
+    std::string text = KI_TEST::FormatBoard( &m_board );
+    size_t      offset = text.find( "(fp_text reference R150" );
+
+    BOOST_REQUIRE( offset != std::string::npos );
+
+    text.insert( offset, "(bogus) " );
+
+    int expectedLine = 1 + std::count( text.begin(), text.begin() + offset, '\n' );
+
+    try
+    {
+        parse( text );
+        BOOST_ERROR( "The parser did not throw" );
+    }
+    catch( const PARSE_ERROR& error )
+    {
+        BOOST_CHECK_EQUAL( error.lineNumber, expectedLine );
+        BOOST_CHECK( error.inputLine.find( "(bogus)" ) != std::string::npos );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,220 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <settings/json_settings.h>
+#include <router/pns_batch_router.h>
+#include <router/pns_kicad_iface.h>
+#include <router/pns_node.h>
+#include <router/pns_router.h>
+#include <router/pns_routing_settings.h>
+#include <router/pns_segment.h>
+
+#include <algorithm>
+#include <array>
+#include <set>
+#include <vector>
+
+
+/**
+ * A board of small pads to connect on the top layer, routed with a router whose interface
+ * leaves the board as it is, so that it can be routed again from the same state
+ */
+struct PNS_BATCH_ROUTER_FIXTURE
+{
+    static const int MM = 1000000;
+
+    typedef std::array<int, 5> NET_SEGMENT;     ///< net, then the ends of a segment
+
+    PNS_BATCH_ROUTER_FIXTURE() :
+        m_settingsParent( "pns_batch_router", SETTINGS_LOC::NESTED, 0 ),
+        m_settings( &m_settingsParent, "pns" )
+    {
+        NETCLASSPTR netclass = m_board.GetDesignSettings().GetDefault();
+
+        netclass->SetTrackWidth( MM / 4 );
+        netclass->SetClearance( MM / 5 );
+
+        for( int net = 1; net <= 3; ++net )
+            m_board.Add( new NETINFO_ITEM( &m_board, wxString::Format( "N%d", net ), net ) );
+    }
+
+    /**
+     * Adds a pad smaller than the tracks, so that a track running past it collides with
+     * obstacles the pad keeps clear of
+     */
+    void addPad( const wxPoint& aPos, int aNet )
+    {
+        MODULE* module = new MODULE( &m_board );
+        D_PAD*  pad = new D_PAD( module );
+
+        module->SetPosition( aPos );
+        pad->SetName( "1" );
+        pad->SetAttribute( PAD_ATTRIB_SMD );
+        pad->SetLayerSet( D_PAD::SMDMask() );
+        pad->SetSize( wxSize( MM / 10, MM / 10 ) );
+        pad->SetPosition( aPos );
+        module->Add( pad );
+        m_board.Add( module, ADD_MODE::APPEND );
+        pad->SetNetCode( aNet );
+    }
+
+    void addTrack( const wxPoint& aStart, const wxPoint& aEnd, int aNet )
+    {
+        TRACK* track = new TRACK( &m_board );
+
+        track->SetStart( aStart );
+        track->SetEnd( aEnd );
+        track->SetWidth( MM / 4 );
+        track->SetLayer( F_Cu );
+        m_board.Add( track, ADD_MODE::APPEND );
+        track->SetNetCode( aNet );
+    }
+
+    /**
+     * Routes the unrouted connections of the board from scratch.
+     * @param aSegments receives the segments of the world once routed, sorted.
+     */
+    PNS::BATCH_ROUTER::STATS route( bool aParallel, std::vector<NET_SEGMENT>& aSegments )
+    {
+        m_board.BuildConnectivity();
+
+        PNS_KICAD_IFACE_BASE iface;
+        PNS::ROUTER          router;
+
+        iface.SetBoard( &m_board );
+        router.SetInterface( &iface );
+        router.LoadSettings( &m_settings );
+        router.SyncWorld();
+
+        PNS::BATCH_ROUTER batch( &router );
+
+        batch.SetParallel( aParallel );
+        batch.SetAreaMargin( MM );
+        batch.AddUnroutedConnections( &m_board );
+        batch.Run();
+
+        aSegments.clear();
+
+        for( int net = 1; net <= 3; ++net )
+        {
+            std::set<PNS::ITEM*> items;
+
+            router.GetWorld()->AllItemsInNet( net, items );
+
+            for( PNS::ITEM* item : items )
+            {
+                if( !item->OfKind( PNS::ITEM::SEGMENT_T ) )
+                    continue;
+
+                const SEG& seg = static_cast<PNS::SEGMENT*>( item )->Seg();
+
+                aSegments.push_back( { net, seg.A.x, seg.A.y, seg.B.x, seg.B.y } );
+            }
+        }
+
+        std::sort( aSegments.begin(), aSegments.end() );
+
+        return batch.Stats();
+    }
+
+    /**
+     * Routes the board one connection at a time, then in parallel, and checks that both
+     * give the same results.
+     * @return the statistics of the parallel run.
+     */
+    PNS::BATCH_ROUTER::STATS routeSerialAndParallel()
+    {
+        std::vector<NET_SEGMENT> serialSegments, parallelSegments;
+
+        PNS::BATCH_ROUTER::STATS serial = route( false, serialSegments );
+        PNS::BATCH_ROUTER::STATS parallel = route( true, parallelSegments );
+
+        BOOST_CHECK_EQUAL( parallel.m_connections, serial.m_connections );
+        BOOST_CHECK_EQUAL( parallel.m_routed, serial.m_routed );
+        BOOST_CHECK_EQUAL( parallel.m_failed, serial.m_failed );
+        BOOST_CHECK_EQUAL( parallel.m_conflicts, serial.m_conflicts );
+        BOOST_CHECK_EQUAL( parallel.m_waves, serial.m_waves );
+        BOOST_CHECK( parallelSegments == serialSegments );
+
+        return parallel;
+    }
+
+    BOARD                 m_board;
+    JSON_SETTINGS         m_settingsParent;
+    PNS::ROUTING_SETTINGS m_settings;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PnsBatchRouter, PNS_BATCH_ROUTER_FIXTURE )
+
+
+/**
+ * Two parallel connections closer than the area margin are routed in separate waves
+ */
+BOOST_AUTO_TEST_CASE( OverlappingAreas )
+{
+    addPad( wxPoint( 0, 0 ), 1 );
+    addPad( wxPoint( 10 * MM, 0 ), 1 );
+    addPad( wxPoint( 0, 3 * MM / 2 ), 2 );
+    addPad( wxPoint( 10 * MM, 3 * MM / 2 ), 2 );
+
+    PNS::BATCH_ROUTER::STATS stats = routeSerialAndParallel();
+
+    BOOST_CHECK_EQUAL( stats.m_connections, 2 );
+    BOOST_CHECK_EQUAL( stats.m_routed, 2 );
+    BOOST_CHECK_EQUAL( stats.m_conflicts, 0 );
+    BOOST_CHECK_EQUAL( stats.m_waves, 2 );
+}
+
+
+/**
+ * Two connections far apart are routed in the same wave, but both shove the same track
+ * lying under them.  The second result to be committed is dropped and routed again alone,
+ * against the track as shoved by the first one.
+ */
+BOOST_AUTO_TEST_CASE( ShovedTrackConflict )
+{
+    addTrack( wxPoint( -5 * MM, 0 ), wxPoint( 25 * MM, 0 ), 3 );
+
+    // The pads keep clear of the track, the tracks between them do not
+    addPad( wxPoint( 0, 2 * MM / 5 ), 1 );
+    addPad( wxPoint( 5 * MM, 2 * MM / 5 ), 1 );
+    addPad( wxPoint( 15 * MM, 2 * MM / 5 ), 2 );
+    addPad( wxPoint( 20 * MM, 2 * MM / 5 ), 2 );
+
+    PNS::BATCH_ROUTER::STATS stats = routeSerialAndParallel();
+
+    BOOST_CHECK_EQUAL( stats.m_connections, 2 );
+    BOOST_CHECK_EQUAL( stats.m_routed, 2 );
+    BOOST_CHECK_EQUAL( stats.m_conflicts, 1 );
+    BOOST_CHECK_EQUAL( stats.m_waves, 2 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
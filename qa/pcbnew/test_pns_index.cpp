@@ -0,0 +1,196 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <router/pns_index.h>
+#include <router/pns_segment.h>
+#include <router/pns_via.h>
+
+#include <geometry/shape_circle.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+
+/**
+ * Segments of a few nets scattered over a few layers, with vias between them
+ */
+struct PNS_INDEX_FIXTURE
+{
+    static const int SEGMENT_COUNT = 500;
+    static const int VIA_COUNT = 100;
+    static const int MIN_DISTANCE = 200000;
+
+    PNS_INDEX_FIXTURE() :
+        m_seed( 12345 )
+    {
+        const int layers[] = { F_Cu, In1_Cu, B_Cu };
+
+        for( int ii = 0; ii < SEGMENT_COUNT; ++ii )
+        {
+            VECTOR2I a = randomPoint();
+
+            // A few long segments, spanning many cells of the grid
+            VECTOR2I b = a + VECTOR2I( random( ii % 10 ? 2000000 : 50000000 ), random( 2000000 ) );
+
+            auto seg = std::make_unique<PNS::SEGMENT>( SEG( a, b ), 1 + ii % 4 );
+
+            seg->SetWidth( 250000 );
+            seg->SetLayer( layers[ii % 3] );
+            m_items.push_back( std::move( seg ) );
+        }
+
+        for( int ii = 0; ii < VIA_COUNT; ++ii )
+        {
+            m_items.push_back( std::make_unique<PNS::VIA>( randomPoint(), LAYER_RANGE( F_Cu, B_Cu ),
+                                                           600000, 300000, 1 + ii % 4 ) );
+        }
+
+        for( const auto& item : m_items )
+            m_index.Add( item.get() );
+    }
+
+    int random( int aRange )
+    {
+        m_seed = m_seed * 1103515245 + 12345;
+        return ( m_seed >> 8 ) % aRange;
+    }
+
+    VECTOR2I randomPoint()
+    {
+        return VECTOR2I( random( 100000000 ) - 50000000, random( 100000000 ) - 50000000 );
+    }
+
+    /**
+     * Check the items found by the index around a point against the ones found by testing
+     * all the items of the index
+     */
+    void checkQuery( PNS::INDEX& aIndex, const VECTOR2I& aPoint, int aRadius )
+    {
+        SHAPE_CIRCLE         circle( aPoint, aRadius );
+        std::set<PNS::ITEM*> found, expected;
+
+        auto visitor = [&]( PNS::ITEM* aItem )
+        {
+            BOOST_CHECK( found.insert( aItem ).second );
+            return true;
+        };
+
+        BOX2I box = circle.BBox();
+        box.Inflate( MIN_DISTANCE );
+
+        for( PNS::ITEM* item : aIndex )
+        {
+            BOX2I itemBox = item->Shape()->BBox();
+
+            if( itemBox.GetX() <= box.GetRight() && box.GetX() <= itemBox.GetRight()
+                    && itemBox.GetY() <= box.GetBottom() && box.GetY() <= itemBox.GetBottom() )
+            {
+                expected.insert( item );
+            }
+        }
+
+        BOOST_CHECK_EQUAL( aIndex.Query( &circle, MIN_DISTANCE, visitor ), (int) expected.size() );
+        BOOST_CHECK( found == expected );
+    }
+
+    PNS::INDEX                              m_index;
+    std::vector<std::unique_ptr<PNS::ITEM>> m_items;
+    unsigned                                m_seed;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PnsIndex, PNS_INDEX_FIXTURE )
+
+
+/**
+ * Every item overlapping the query box is visited exactly once
+ */
+BOOST_AUTO_TEST_CASE( Query )
+{
+    BOOST_CHECK_EQUAL( m_index.Size(), SEGMENT_COUNT + VIA_COUNT );
+
+    for( int ii = 0; ii < 200; ++ii )
+        checkQuery( m_index, randomPoint(), random( 5000000 ) );
+
+    // The whole board
+    checkQuery( m_index, VECTOR2I( 0, 0 ), 100000000 );
+}
+
+
+/**
+ * A copy of the index, as made for a branch, is searched and edited on its own
+ */
+BOOST_AUTO_TEST_CASE( CopyAndRemove )
+{
+    PNS::INDEX copy;
+
+    copy = m_index;
+
+    for( size_t ii = 0; ii < m_items.size(); ii += 2 )
+        copy.Remove( m_items[ii].get() );
+
+    BOOST_CHECK_EQUAL( m_index.Size(), SEGMENT_COUNT + VIA_COUNT );
+    BOOST_CHECK_EQUAL( copy.Size(), ( SEGMENT_COUNT + VIA_COUNT ) / 2 );
+    BOOST_CHECK( !copy.Contains( m_items[0].get() ) );
+    BOOST_CHECK( m_index.Contains( m_items[0].get() ) );
+
+    for( int ii = 0; ii < 100; ++ii )
+    {
+        VECTOR2I p = randomPoint();
+        int      r = random( 5000000 );
+
+        checkQuery( m_index, p, r );
+        checkQuery( copy, p, r );
+    }
+
+    // Items of the removed nets are gone from the copy only
+    BOOST_CHECK_EQUAL( m_index.GetItemsForNet( 1 )->size(), ( SEGMENT_COUNT + VIA_COUNT ) / 4u );
+    BOOST_CHECK( copy.GetItemsForNet( 1 )->empty() );
+}
+
+
+/**
+ * The visitor stops the search of a subindex by returning false
+ */
+BOOST_AUTO_TEST_CASE( StopSearch )
+{
+    SHAPE_CIRCLE circle( VECTOR2I( 0, 0 ), 100000000 );
+    int          visited = 0;
+
+    auto visitor = [&]( PNS::ITEM* aItem )
+    {
+        visited++;
+        return false;
+    };
+
+    BOOST_CHECK_EQUAL( m_index.Query( &circle, 0, visitor ), 0 );
+
+    // Segments on three layers and vias: one item of each of the four subindices
+    BOOST_CHECK_EQUAL( visited, 4 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,202 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <router/pns_item_pool.h>
+#include <router/pns_node.h>
+#include <router/pns_segment.h>
+#include <thread_pool.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+/**
+ * A world with a row of segments of a single net
+ */
+struct PNS_NODE_FIXTURE
+{
+    static const int SEGMENT_COUNT = 10;
+    static const int PITCH = 1000000;
+
+    PNS_NODE_FIXTURE()
+    {
+        for( int ii = 0; ii < SEGMENT_COUNT; ++ii )
+            m_world.Add( makeSegment( ii, 0 ) );
+    }
+
+    static std::unique_ptr<PNS::SEGMENT> makeSegment( int aX, int aY )
+    {
+        SEG  seg( VECTOR2I( aX * PITCH, aY * PITCH ), VECTOR2I( ( aX + 1 ) * PITCH, aY * PITCH ) );
+        auto segment = std::make_unique<PNS::SEGMENT>( seg, 1 );
+
+        segment->SetWidth( 200000 );
+        segment->SetLayer( F_Cu );
+
+        return segment;
+    }
+
+    ///> Returns true if the node holds an item at the middle of a segment
+    static bool hasSegmentAt( PNS::NODE* aNode, int aX, int aY )
+    {
+        return aNode->HitTest( VECTOR2I( aX * PITCH + PITCH / 2, aY * PITCH ) ).Size() > 0;
+    }
+
+    PNS::NODE m_world;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PnsNode, PNS_NODE_FIXTURE )
+
+
+/**
+ * Branches of a branch see its items, and their changes are kept to themselves
+ */
+BOOST_AUTO_TEST_CASE( BranchCopyOnWrite )
+{
+    PNS::NODE*    branch = m_world.Branch();
+    auto          added = makeSegment( 0, 1 );
+    PNS::SEGMENT* addedItem = added.get();
+
+    branch->Add( std::move( added ) );
+
+    PNS::NODE* changed = branch->Branch();
+    PNS::NODE* unchanged = branch->Branch();
+    int        joints = branch->JointCount();
+
+    changed->Remove( addedItem );
+    changed->Add( makeSegment( 0, 2 ) );
+
+    BOOST_CHECK( hasSegmentAt( branch, 0, 1 ) );
+    BOOST_CHECK( !hasSegmentAt( branch, 0, 2 ) );
+    BOOST_CHECK_EQUAL( branch->JointCount(), joints );
+
+    BOOST_CHECK( !hasSegmentAt( changed, 0, 1 ) );
+    BOOST_CHECK( hasSegmentAt( changed, 0, 2 ) );
+
+    BOOST_CHECK( hasSegmentAt( unchanged, 0, 1 ) );
+    BOOST_CHECK( !hasSegmentAt( unchanged, 0, 2 ) );
+    BOOST_CHECK_EQUAL( unchanged->JointCount(), joints );
+
+    // Items of the world removed in a branch only
+    unchanged->Remove( m_world.HitTest( VECTOR2I( PITCH / 2, 0 ) )[0] );
+
+    BOOST_CHECK( !hasSegmentAt( unchanged, 0, 0 ) );
+    BOOST_CHECK( hasSegmentAt( changed, 0, 0 ) );
+    BOOST_CHECK( hasSegmentAt( &m_world, 0, 0 ) );
+
+    m_world.KillChildren();
+}
+
+
+/**
+ * Once the pool has grown, creating and discarding items takes no heap allocation
+ */
+BOOST_AUTO_TEST_CASE( ItemPool )
+{
+    for( int round = 0; round < 3; ++round )
+    {
+        PNS::ITEM_POOL::STATS before = PNS::ITEM_POOL::GetStats();
+
+        PNS::NODE* branch = m_world.Branch();
+
+        for( int ii = 0; ii < 1000; ++ii )
+            branch->Add( makeSegment( ii, 3 ) );
+
+        m_world.KillChildren();
+
+        PNS::ITEM_POOL::STATS after = PNS::ITEM_POOL::GetStats();
+
+        BOOST_CHECK_EQUAL( after.m_items - before.m_items, 1000u );
+
+        if( round > 0 )
+            BOOST_CHECK_EQUAL( after.m_heapAllocations, before.m_heapAllocations );
+    }
+}
+
+
+/**
+ * Items created by worker threads and discarded by the main thread, as the branches of the
+ * parallel searches are: the blocks are reused, the pool stops growing
+ */
+BOOST_AUTO_TEST_CASE( ItemPoolAcrossThreads )
+{
+    THREAD_POOL pool( 2 );
+    uint64_t    chunkBytes = 0;
+
+    for( int round = 0; round < 20; ++round )
+    {
+        std::vector<PNS::SEGMENT*> segments;
+        TASK_GROUP                 group( nullptr, pool );
+
+        group.Run( [&]()
+                   {
+                       for( int ii = 0; ii < 5000; ++ii )
+                           segments.push_back( makeSegment( ii, 4 ).release() );
+                   } );
+
+        group.Wait();
+
+        for( PNS::SEGMENT* segment : segments )
+            delete segment;
+
+        // A few rounds for the free lists of the threads to fill up
+        if( round > 4 )
+            BOOST_CHECK_EQUAL( PNS::ITEM_POOL::GetStats().m_chunkBytes, chunkBytes );
+
+        chunkBytes = PNS::ITEM_POOL::GetStats().m_chunkBytes;
+    }
+}
+
+
+/**
+ * The free blocks a thread holds go back to the shared lists when it exits, for the next
+ * threads to reuse
+ */
+BOOST_AUTO_TEST_CASE( ItemPoolThreadExit )
+{
+    uint64_t chunkBytes = 0;
+
+    for( int round = 0; round < 100; ++round )
+    {
+        std::thread thread( [&]()
+                            {
+                                std::vector<std::unique_ptr<PNS::SEGMENT>> segments;
+
+                                for( int ii = 0; ii < 100; ++ii )
+                                    segments.push_back( makeSegment( ii, 5 ) );
+                            } );
+
+        thread.join();
+
+        if( round > 0 )
+            BOOST_CHECK_EQUAL( PNS::ITEM_POOL::GetStats().m_chunkBytes, chunkBytes );
+
+        chunkBytes = PNS::ITEM_POOL::GetStats().m_chunkBytes;
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
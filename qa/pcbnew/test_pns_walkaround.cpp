@@ -0,0 +1,127 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <router/pns_line.h>
+#include <router/pns_node.h>
+#include <router/pns_segment.h>
+#include <router/pns_walkaround.h>
+
+#include <limits>
+#include <memory>
+
+
+/**
+ * A line of net 1 crossing a few segments of net 2
+ */
+struct PNS_WALKAROUND_FIXTURE
+{
+    static const int MM = 1000000;
+
+    PNS_WALKAROUND_FIXTURE()
+    {
+        addObstacle( SEG( VECTOR2I( 0, -MM ), VECTOR2I( 0, MM ) ) );
+        addObstacle( SEG( VECTOR2I( 3 * MM, -2 * MM ), VECTOR2I( 3 * MM, MM / 2 ) ) );
+
+        m_line.SetNet( 1 );
+        m_line.SetLayer( F_Cu );
+        m_line.SetWidth( MM / 5 );
+        m_line.SetShape( SHAPE_LINE_CHAIN( { VECTOR2I( -5 * MM, 0 ), VECTOR2I( 6 * MM, 0 ) } ) );
+    }
+
+    void addObstacle( const SEG& aSeg )
+    {
+        auto segment = std::make_unique<PNS::SEGMENT>( aSeg, 2 );
+
+        segment->SetWidth( MM / 5 );
+        segment->SetLayer( F_Cu );
+        m_world.Add( std::move( segment ) );
+    }
+
+    PNS::NODE m_world;
+    PNS::LINE m_line;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PnsWalkaround, PNS_WALKAROUND_FIXTURE )
+
+
+/**
+ * Walking both directions at the same time finds the paths of the sequential walk.
+ *
+ * The walks only agree when the iteration limit stops them, so the time limit is made
+ * long enough never to expire.
+ */
+BOOST_AUTO_TEST_CASE( ParallelDirections )
+{
+    PNS::TIME_LIMIT unlimited( std::numeric_limits<int>::max() );
+    PNS::WALKAROUND sequential( &m_world, nullptr );
+    PNS::WALKAROUND parallel( &m_world, nullptr );
+
+    sequential.SetTimeLimit( &unlimited );
+    parallel.SetTimeLimit( &unlimited );
+    parallel.SetParallel( true );
+
+    PNS::WALKAROUND::RESULT expected = sequential.Route( m_line );
+    PNS::WALKAROUND::RESULT result = parallel.Route( m_line );
+
+    BOOST_CHECK_EQUAL( result.statusCw, expected.statusCw );
+    BOOST_CHECK_EQUAL( result.statusCcw, expected.statusCcw );
+    BOOST_CHECK( result.lineCw.CLine().CompareGeometry( expected.lineCw.CLine() ) );
+    BOOST_CHECK( result.lineCcw.CLine().CompareGeometry( expected.lineCcw.CLine() ) );
+
+    // The line was walked around the obstacles, on each side
+    BOOST_CHECK( result.lineCw.CLine() != m_line.CLine() );
+    BOOST_CHECK( result.lineCcw.CLine() != result.lineCw.CLine() );
+}
+
+
+/**
+ * A line ending inside the hull of an obstacle is blocked at each step.  The blockages are
+ * counted per winding direction, so walking both directions at the same time still finds
+ * the paths of the sequential walk.
+ */
+BOOST_AUTO_TEST_CASE( ParallelRecursiveBlockage )
+{
+    PNS::TIME_LIMIT unlimited( std::numeric_limits<int>::max() );
+    PNS::WALKAROUND sequential( &m_world, nullptr );
+    PNS::WALKAROUND parallel( &m_world, nullptr );
+
+    sequential.SetTimeLimit( &unlimited );
+    parallel.SetTimeLimit( &unlimited );
+    parallel.SetParallel( true );
+
+    m_line.SetShape( SHAPE_LINE_CHAIN( { VECTOR2I( -5 * MM, 0 ), VECTOR2I( 0, MM / 2 ) } ) );
+
+    PNS::WALKAROUND::RESULT expected = sequential.Route( m_line );
+    PNS::WALKAROUND::RESULT result = parallel.Route( m_line );
+
+    BOOST_CHECK_EQUAL( result.statusCw, expected.statusCw );
+    BOOST_CHECK_EQUAL( result.statusCcw, expected.statusCcw );
+    BOOST_CHECK( result.lineCw.CLine().CompareGeometry( expected.lineCw.CLine() ) );
+    BOOST_CHECK( result.lineCcw.CLine().CompareGeometry( expected.lineCcw.CLine() ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,207 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <connectivity/connectivity_algo.h>
+#include <ratsnest_data.h>
+
+#include <vector>
+
+
+/**
+ * A single net of pads scattered over the board, each pad in its own footprint
+ */
+struct RATSNEST_FIXTURE
+{
+    static const int PAD_COUNT = 200;
+
+    RATSNEST_FIXTURE() :
+        m_seed( 12345 )
+    {
+        m_board.Add( new NETINFO_ITEM( &m_board, "N1", 1 ) );
+
+        for( int ii = 0; ii < PAD_COUNT; ++ii )
+        {
+            MODULE* module = new MODULE( &m_board );
+            D_PAD*  pad = new D_PAD( module );
+
+            module->SetPosition( randomPosition() );
+            pad->SetName( "1" );
+            pad->SetLayerSet( D_PAD::SMDMask() );
+            pad->SetSize( wxSize( 500000, 500000 ) );
+            pad->SetPosition( module->GetPosition() );
+            module->Add( pad );
+            m_board.Add( module, ADD_MODE::APPEND );
+            pad->SetNetCode( 1 );
+            m_modules.push_back( module );
+        }
+
+        m_algo.Build( &m_board );
+    }
+
+    wxPoint randomPosition()
+    {
+        m_seed = m_seed * 1103515245 + 12345;
+        int x = ( m_seed >> 8 ) % 1000;
+        m_seed = m_seed * 1103515245 + 12345;
+        int y = ( m_seed >> 8 ) % 1000;
+
+        return wxPoint( x * 100000, y * 100000 );
+    }
+
+    void moveModules( int aCount )
+    {
+        for( int ii = 0; ii < aCount; ++ii )
+        {
+            m_seed = m_seed * 1103515245 + 12345;
+            MODULE* module = m_modules[( m_seed >> 8 ) % m_modules.size()];
+
+            m_algo.Remove( module );
+            module->SetPosition( randomPosition() );
+            m_algo.Add( module );
+        }
+    }
+
+    /**
+     * Update a net from the clusters of the board, the way CONNECTIVITY_DATA does
+     * @param aStrips is the number of strips to split the nodes in if they are triangulated
+     * again.
+     * @return the total length of the ratsnest lines.
+     */
+    uint64_t updateNet( RN_NET& aNet, size_t& aClusterCount, int aStrips = 1 )
+    {
+        aNet.Clear();
+        aClusterCount = 0;
+
+        for( const CN_CLUSTER_PTR& cluster :
+                m_algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_RATSNEST ) )
+        {
+            if( cluster->OriginNet() == 1 )
+            {
+                aNet.AddCluster( cluster );
+                aClusterCount++;
+            }
+        }
+
+        // Parts can be computed in any order
+        for( int part = aNet.BeginUpdate( aStrips ) - 1; part >= 0; --part )
+            aNet.UpdatePart( part );
+
+        aNet.EndUpdate();
+
+        uint64_t length = 0;
+
+        for( const CN_EDGE& edge : aNet.GetUnconnected() )
+            length += edge.GetWeight();
+
+        BOOST_CHECK_EQUAL( aNet.GetUnconnected().size() + 1, aClusterCount );
+        return length;
+    }
+
+    /**
+     * Check the ratsnest of a net updated from its previous triangulation against the one
+     * of a net computed from scratch.  Both are minimum spanning trees, with the same length.
+     */
+    void checkRatsnest( int aStrips = 1 )
+    {
+        size_t clusters;
+        RN_NET fresh;
+
+        uint64_t incremental = updateNet( m_net, clusters, aStrips );
+        uint64_t full = updateNet( fresh, clusters );
+
+        BOOST_CHECK_EQUAL( incremental, full );
+    }
+
+    BOARD                m_board;
+    CN_CONNECTIVITY_ALGO m_algo;
+    RN_NET               m_net;
+    std::vector<MODULE*> m_modules;
+    unsigned             m_seed;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( Ratsnest, RATSNEST_FIXTURE )
+
+
+/**
+ * A few footprints moved at a time: the nodes are inserted in the previous triangulation
+ */
+BOOST_AUTO_TEST_CASE( IncrementalUpdate )
+{
+    checkRatsnest();
+
+    for( int step = 0; step < 50; ++step )
+    {
+        BOOST_TEST_CONTEXT( "Step " << step )
+        {
+            moveModules( 1 + step % 3 );
+            checkRatsnest();
+        }
+    }
+}
+
+
+/**
+ * Most footprints moved at once: the nodes are triangulated again
+ */
+BOOST_AUTO_TEST_CASE( FullUpdate )
+{
+    checkRatsnest();
+
+    moveModules( PAD_COUNT );
+    checkRatsnest();
+
+    moveModules( 2 );
+    checkRatsnest();
+}
+
+
+/**
+ * Nodes split in strips, whose pairs are triangulated separately
+ */
+BOOST_AUTO_TEST_CASE( SplitUpdate )
+{
+    for( int strips = 2; strips <= 4; ++strips )
+    {
+        BOOST_TEST_CONTEXT( strips << " strips" )
+        {
+            moveModules( PAD_COUNT );
+            checkRatsnest( strips );
+
+            // Moved nodes are inserted in the triangulations of their strips
+            for( int step = 0; step < 10; ++step )
+            {
+                moveModules( 2 );
+                checkRatsnest( strips );
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
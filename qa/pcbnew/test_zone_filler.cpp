@@ -0,0 +1,157 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <class_track.h>
+#include <class_zone.h>
+
+#include <zone_filler.h>
+
+
+/**
+ * A board with a 10mm square zone on F_Cu crossed by a track, and a second track far away
+ */
+struct ZONE_FILLER_FIXTURE
+{
+    ZONE_FILLER_FIXTURE()
+    {
+        m_zone = new ZONE_CONTAINER( &m_board );
+        m_zone->SetLayer( F_Cu );
+        m_zone->Outline()->NewOutline();
+        m_zone->Outline()->Append( 0, 0 );
+        m_zone->Outline()->Append( 10000000, 0 );
+        m_zone->Outline()->Append( 10000000, 10000000 );
+        m_zone->Outline()->Append( 0, 10000000 );
+        m_board.Add( m_zone, ADD_MODE::APPEND );
+
+        m_nearTrack = addTrack( wxPoint( 5000000, -1000000 ), wxPoint( 5000000, 11000000 ) );
+        m_farTrack = addTrack( wxPoint( 50000000, 0 ), wxPoint( 50000000, 10000000 ) );
+
+        m_board.BuildConnectivity();
+    }
+
+    TRACK* addTrack( const wxPoint& aStart, const wxPoint& aEnd )
+    {
+        TRACK* track = new TRACK( &m_board );
+
+        track->SetStart( aStart );
+        track->SetEnd( aEnd );
+        track->SetWidth( 250000 );
+        track->SetLayer( F_Cu );
+        m_board.Add( track, ADD_MODE::APPEND );
+
+        return track;
+    }
+
+    /**
+     * Replace the fill by a recognizable polygon, so that we can tell if it was recomputed
+     */
+    void markFill()
+    {
+        SHAPE_POLY_SET marker;
+
+        marker.NewOutline();
+        marker.Append( 1000, 1000 );
+        marker.Append( 2000, 1000 );
+        marker.Append( 2000, 2000 );
+
+        m_zone->SetFilledPolysList( marker );
+        m_markerHash = marker.GetHash();
+    }
+
+    bool fill( bool aIncremental )
+    {
+        ZONE_FILLER filler( &m_board );
+
+        filler.SetIncremental( aIncremental );
+
+        return filler.Fill( { m_zone } );
+    }
+
+    BOARD           m_board;
+    ZONE_CONTAINER* m_zone;
+    TRACK*          m_nearTrack;
+    TRACK*          m_farTrack;
+    MD5_HASH        m_markerHash;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ZoneFiller, ZONE_FILLER_FIXTURE )
+
+
+/**
+ * An incremental fill leaves the zone alone until something inside its clearance area changes
+ */
+BOOST_AUTO_TEST_CASE( IncrementalRefill )
+{
+    BOOST_REQUIRE( fill( true ) );
+    BOOST_CHECK( m_zone->IsFilled() );
+    BOOST_CHECK( m_zone->GetFillDependencies().IsValid() );
+
+    // Nothing changed
+    markFill();
+    BOOST_CHECK( fill( true ) );
+    BOOST_CHECK( m_zone->GetFilledPolysList().GetHash() == m_markerHash );
+
+    // A change far away from the zone
+    m_farTrack->Move( wxPoint( 1000000, 0 ) );
+    BOOST_CHECK( fill( true ) );
+    BOOST_CHECK( m_zone->GetFilledPolysList().GetHash() == m_markerHash );
+
+    // A change of a knockout
+    m_nearTrack->Move( wxPoint( 1000000, 0 ) );
+    BOOST_CHECK( fill( true ) );
+    BOOST_CHECK( m_zone->GetFilledPolysList().GetHash() != m_markerHash );
+
+    // A change of the zone settings
+    markFill();
+    m_zone->SetZoneClearance( m_zone->GetZoneClearance() + 100000 );
+    BOOST_CHECK( fill( true ) );
+    BOOST_CHECK( m_zone->GetFilledPolysList().GetHash() != m_markerHash );
+
+    // A non incremental fill always refills
+    markFill();
+    BOOST_CHECK( fill( false ) );
+    BOOST_CHECK( m_zone->GetFilledPolysList().GetHash() != m_markerHash );
+}
+
+
+/**
+ * A non incremental fill records no signature, so the next incremental fill refills the zone
+ */
+BOOST_AUTO_TEST_CASE( NonIncrementalFill )
+{
+    BOOST_REQUIRE( fill( false ) );
+    BOOST_CHECK( m_zone->IsFilled() );
+    BOOST_CHECK( !m_zone->GetFillDependencies().IsValid() );
+
+    markFill();
+    BOOST_CHECK( fill( true ) );
+    BOOST_CHECK( m_zone->GetFilledPolysList().GetHash() != m_markerHash );
+    BOOST_CHECK( m_zone->GetFillDependencies().IsValid() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/utility_registry.h>
+
+#include <class_board.h>
+#include <connectivity/connectivity_algo.h>
+#include <profile.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+enum CONNECTIVITY_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+};
+
+
+/**
+ * Build the connectivity of a board a few times, and report the build and search times and
+ * the memory held by the connectivity items.
+ *
+ * Usage: connectivity <board file> [runs]
+ */
+int connectivity_main( int argc, char* argv[] )
+{
+    std::string filename;
+    int         runs = 5;
+
+    if( argc > 1 )
+        filename = argv[1];
+
+    if( argc > 2 )
+        runs = std::max( 1, atoi( argv[2] ) );
+
+    auto brd = KI_TEST::ReadBoardFromFileOrStream( filename );
+
+    if( !brd )
+        return CONNECTIVITY_RET_CODES::LOAD_FAILED;
+
+    std::vector<double> buildTimes, searchTimes, researchTimes;
+
+    for( int run = 0; run < runs; run++ )
+    {
+        CN_CONNECTIVITY_ALGO algo;
+
+        PROF_COUNTER build;
+        algo.Build( brd.get() );
+        build.Stop();
+
+        PROF_COUNTER search;
+        auto clusters = algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_RATSNEST );
+        search.Stop();
+
+        // An edit of everything: the items are there, only their connections are searched
+        algo.ItemList().MarkAllAsDirty();
+
+        PROF_COUNTER research;
+        algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_RATSNEST );
+        research.Stop();
+
+        buildTimes.push_back( build.msecs() );
+        searchTimes.push_back( search.msecs() );
+        researchTimes.push_back( research.msecs() );
+
+        if( run == 0 )
+        {
+            size_t connections = 0;
+            size_t listBytes = 0;
+
+            algo.ForEachItem( [&]( CN_ITEM& aItem )
+                    {
+                        connections += aItem.ConnectedItems().size();
+                        listBytes += aItem.ConnectedItems().capacity() * sizeof( CN_ITEM* )
+                                     + aItem.Anchors().capacity() * sizeof( CN_ANCHOR_PTR );
+                    } );
+
+            printf( "%d items, %d anchors, %zu connections, %zu clusters\n",
+                    algo.ItemList().Size(), algo.ItemList().AnchorCount(), connections / 2,
+                    clusters.size() );
+            printf( "memory: %.1f kB in item and anchor arenas, %.1f kB in item lists\n",
+                    algo.ItemList().MemoryUsage() / 1024.0, listBytes / 1024.0 );
+        }
+    }
+
+    auto median = []( std::vector<double>& aTimes )
+    {
+        std::sort( aTimes.begin(), aTimes.end() );
+        return aTimes[aTimes.size() / 2];
+    };
+
+    printf( "median of %d runs: build %.3f ms, search %.3f ms, search again %.3f ms\n", runs,
+            median( buildTimes ), median( searchTimes ), median( researchTimes ) );
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+static bool registered = UTILITY_REGISTRY::Register( {
+        "connectivity",
+        "Benchmark building the connectivity of a PCB",
+        connectivity_main,
+} );
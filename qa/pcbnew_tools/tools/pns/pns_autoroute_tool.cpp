@@ -0,0 +1,152 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/utility_registry.h>
+
+#include <class_board.h>
+#include <netinfo.h>
+#include <settings/json_settings.h>
+
+#include <router/pns_batch_router.h>
+#include <router/pns_kicad_iface.h>
+#include <router/pns_router.h>
+#include <router/pns_routing_settings.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+enum PNS_AUTOROUTE_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    UNKNOWN_NET,
+};
+
+
+/**
+ * Route the unrouted connections of a board with PNS::BATCH_ROUTER, one connection at a
+ * time and then in parallel, and print the throughput of both. The board file is left as
+ * it is.
+ *
+ * Usage: pns_autoroute <board file> [-m area margin [mm]] [-p <net name>=<priority>...]
+ */
+int pns_autoroute_main( int argc, char* argv[] )
+{
+    if( argc < 2 )
+    {
+        printf( "usage: %s <board file> [-m area margin [mm]] [-p <net name>=<priority>...]\n",
+                argv[0] );
+        return KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    double                                margin = 1.0;
+    std::vector<std::pair<wxString, int>> priorities;
+
+    for( int ii = 2; ii < argc; ii++ )
+    {
+        std::string arg( argv[ii] );
+
+        if( arg == "-m" && ii + 1 < argc )
+        {
+            margin = atof( argv[++ii] );
+        }
+        else if( arg == "-p" && ii + 1 < argc )
+        {
+            std::string priority( argv[++ii] );
+            size_t      sep = priority.rfind( '=' );
+
+            if( sep == std::string::npos )
+                return KI_TEST::RET_CODES::BAD_CMDLINE;
+
+            priorities.emplace_back( wxString::FromUTF8( priority.substr( 0, sep ).c_str() ),
+                                     atoi( priority.c_str() + sep + 1 ) );
+        }
+        else
+        {
+            return KI_TEST::RET_CODES::BAD_CMDLINE;
+        }
+    }
+
+    auto brd = KI_TEST::ReadBoardFromFileOrStream( argv[1] );
+
+    if( !brd )
+        return PNS_AUTOROUTE_RET_CODES::LOAD_FAILED;
+
+    JSON_SETTINGS         settingsParent( "pns_autoroute", SETTINGS_LOC::NESTED, 0 );
+    PNS::ROUTING_SETTINGS settings( &settingsParent, "pns" );
+    PNS_KICAD_IFACE_BASE  iface;
+    PNS::ROUTER           router;
+
+    iface.SetBoard( brd.get() );
+    router.SetInterface( &iface );
+    router.LoadSettings( &settings );
+
+    printf( "%-10s %8s %8s %8s %8s %8s %10s %10s\n", "mode", "conns", "routed", "failed",
+            "confl", "waves", "time [ms]", "conn/s" );
+
+    for( bool parallel : { false, true } )
+    {
+        // The interface makes no change to the board, each run starts from the board as loaded
+        router.SyncWorld();
+
+        PNS::BATCH_ROUTER batch( &router );
+
+        for( const std::pair<wxString, int>& priority : priorities )
+        {
+            NETINFO_ITEM* net = brd->FindNet( priority.first );
+
+            if( !net )
+            {
+                printf( "no net '%s'\n", (const char*) priority.first.utf8_str() );
+                return PNS_AUTOROUTE_RET_CODES::UNKNOWN_NET;
+            }
+
+            batch.SetNetPriority( net->GetNet(), priority.second );
+        }
+
+        batch.SetParallel( parallel );
+        batch.SetAreaMargin( (int) ( margin * 1e6 ) );
+        batch.AddUnroutedConnections( brd.get() );
+        batch.Run();
+
+        const PNS::BATCH_ROUTER::STATS& stats = batch.Stats();
+
+        printf( "%-10s %8d %8d %8d %8d %8d %10.1f %10.1f\n", parallel ? "parallel" : "serial",
+                stats.m_connections, stats.m_routed, stats.m_failed, stats.m_conflicts,
+                stats.m_waves, stats.m_time, stats.ConnectionsPerSecond() );
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+static bool registered = UTILITY_REGISTRY::Register( {
+        "pns_autoroute",
+        "Route the unrouted connections of a board and report the throughput",
+        pns_autoroute_main,
+} );
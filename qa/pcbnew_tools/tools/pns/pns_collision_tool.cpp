@@ -0,0 +1,301 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/utility_registry.h>
+
+#include <class_board.h>
+#include <profile.h>
+
+#include <router/pns_kicad_iface.h>
+#include <router/pns_node.h>
+#include <router/pns_router.h>
+#include <router/pns_segment.h>
+#include <router/pns_via.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+enum PNS_COLLISION_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    LOG_LOAD_FAILED,
+};
+
+
+using ITEM_GROUP = std::vector<std::unique_ptr<PNS::ITEM>>;
+
+
+/**
+ * Read the items of a log written by PNS::LOGGER, one group of items per router iteration.
+ * Lines become segments and vias become vias; solids are left out, as they are the pads
+ * already in the world.
+ */
+static bool loadLoggerGroups( const std::string& aFilename, std::vector<ITEM_GROUP>& aGroups )
+{
+    std::ifstream file( aFilename );
+
+    if( !file )
+        return false;
+
+    std::string line;
+    bool        inGroup = false;
+
+    while( std::getline( file, line ) )
+    {
+        std::istringstream       stream( line );
+        std::vector<std::string> tok;
+        std::string              word;
+
+        while( stream >> word )
+            tok.push_back( word );
+
+        if( tok.empty() )
+            continue;
+
+        if( tok[0] == "group" )
+        {
+            aGroups.emplace_back();
+            inGroup = true;
+            continue;
+        }
+        else if( tok[0] == "endgroup" )
+        {
+            inGroup = false;
+            continue;
+        }
+        else if( tok[0] != "item" || tok.size() < 9 )
+        {
+            continue;
+        }
+
+        // item <kind> [<name>] <net> <layer start> <layer end> <marker> <rank> <type> ...
+        bool   named = tok[8] == "line" || tok[8] == "via" || tok[8] == "solid";
+        size_t t = named ? 8 : 7;
+        int    net = atoi( tok[t - 5].c_str() );
+        int    layerStart = atoi( tok[t - 4].c_str() );
+        int    layerEnd = atoi( tok[t - 3].c_str() );
+
+        if( !inGroup || aGroups.empty() )
+            aGroups.emplace_back();
+
+        ITEM_GROUP& group = aGroups.back();
+
+        if( tok[t] == "line" && tok.size() > t + 5 && tok[t + 3] == "linechain" )
+        {
+            int    width = atoi( tok[t + 1].c_str() );
+            size_t count = atoi( tok[t + 4].c_str() );
+
+            if( tok.size() < t + 6 + 2 * count )
+                continue;
+
+            for( size_t ii = 1; ii < count; ++ii )
+            {
+                size_t   a = t + 6 + 2 * ( ii - 1 );
+                VECTOR2I pa( atoi( tok[a].c_str() ), atoi( tok[a + 1].c_str() ) );
+                VECTOR2I pb( atoi( tok[a + 2].c_str() ), atoi( tok[a + 3].c_str() ) );
+                auto     seg = std::make_unique<PNS::SEGMENT>( SEG( pa, pb ), net );
+
+                seg->SetWidth( width );
+                seg->SetLayer( layerStart );
+                group.push_back( std::move( seg ) );
+            }
+        }
+        else if( tok[t] == "via" && tok.size() > t + 6 && tok[t + 3] == "circle" )
+        {
+            VECTOR2I pos( atoi( tok[t + 4].c_str() ), atoi( tok[t + 5].c_str() ) );
+            int      radius = atoi( tok[t + 6].c_str() );
+
+            group.push_back( std::make_unique<PNS::VIA>( pos, LAYER_RANGE( layerStart, layerEnd ),
+                                                         2 * radius, radius, net ) );
+        }
+    }
+
+    aGroups.erase( std::remove_if( aGroups.begin(), aGroups.end(),
+                                   []( const ITEM_GROUP& aGroup )
+                                   {
+                                       return aGroup.empty();
+                                   } ),
+                   aGroups.end() );
+
+    return true;
+}
+
+
+/**
+ * Without a log, the copies of the items of each net make a group, as if the nets were
+ * routed again one by one.
+ */
+static void makeNetGroups( BOARD* aBoard, PNS::NODE* aWorld, std::vector<ITEM_GROUP>& aGroups )
+{
+    for( unsigned net = 1; net < aBoard->GetNetCount(); ++net )
+    {
+        std::set<PNS::ITEM*> items;
+        ITEM_GROUP           group;
+
+        aWorld->AllItemsInNet( net, items );
+
+        for( PNS::ITEM* item : items )
+        {
+            if( item->OfKind( PNS::ITEM::SEGMENT_T | PNS::ITEM::VIA_T ) )
+                group.emplace_back( item->Clone() );
+        }
+
+        if( !group.empty() )
+            aGroups.push_back( std::move( group ) );
+    }
+}
+
+
+/**
+ * Replay the collision queries of a routing session against the router world of a board:
+ * the items of each group are added to a branch of the world, then searched for obstacles
+ * in the branch and in a branch of it, the way the shove and walkaround algorithms do.
+ *
+ * Usage: pns_collision <board file> [PNS::LOGGER log file] [runs]
+ */
+int pns_collision_main( int argc, char* argv[] )
+{
+    std::string filename, logFilename;
+    int         runs = 5;
+
+    if( argc > 1 )
+        filename = argv[1];
+
+    if( argc > 2 )
+        logFilename = argv[2];
+
+    if( argc > 3 )
+        runs = std::max( 1, atoi( argv[3] ) );
+
+    auto brd = KI_TEST::ReadBoardFromFileOrStream( filename );
+
+    if( !brd )
+        return PNS_COLLISION_RET_CODES::LOAD_FAILED;
+
+    PNS::ROUTER          router;
+    PNS_KICAD_IFACE_BASE iface;
+
+    iface.SetBoard( brd.get() );
+    router.SetInterface( &iface );
+
+    PROF_COUNTER sync;
+    router.SyncWorld();
+    sync.Stop();
+
+    PNS::NODE*              world = router.GetWorld();
+    std::vector<ITEM_GROUP> groups;
+
+    if( !logFilename.empty() )
+    {
+        if( !loadLoggerGroups( logFilename, groups ) )
+            return PNS_COLLISION_RET_CODES::LOG_LOAD_FAILED;
+    }
+    else
+    {
+        makeNetGroups( brd.get(), world, groups );
+    }
+
+    size_t queries = 0;
+
+    for( const ITEM_GROUP& group : groups )
+        queries += group.size();
+
+    printf( "world synced in %.3f ms, %zu groups, %zu queries per run\n", sync.msecs(),
+            groups.size(), queries );
+
+    std::vector<double> branchTimes, queryTimes;
+    size_t              obstacles = 0;
+
+    for( int run = 0; run < runs; run++ )
+    {
+        double branchTime = 0.0, queryTime = 0.0;
+
+        for( const ITEM_GROUP& group : groups )
+        {
+            PROF_COUNTER branching;
+            PNS::NODE*   branch = world->Branch();
+
+            for( const auto& item : group )
+                branch->Add( std::unique_ptr<PNS::ITEM>( item->Clone() ), true );
+
+            // A second level branch copies the index of the first one
+            PNS::NODE* subBranch = branch->Branch();
+            branching.Stop();
+
+            PROF_COUNTER querying;
+
+            for( const auto& item : group )
+            {
+                PNS::NODE::OBSTACLES obs;
+
+                branch->QueryColliding( item.get(), obs );
+                subBranch->QueryColliding( item.get(), obs );
+
+                if( run == 0 )
+                    obstacles += obs.size();
+            }
+
+            querying.Stop();
+
+            world->KillChildren();
+
+            branchTime += branching.msecs();
+            queryTime += querying.msecs();
+        }
+
+        branchTimes.push_back( branchTime );
+        queryTimes.push_back( queryTime );
+    }
+
+    auto median = []( std::vector<double>& aTimes )
+    {
+        std::sort( aTimes.begin(), aTimes.end() );
+        return aTimes[aTimes.size() / 2];
+    };
+
+    double queryTime = median( queryTimes );
+
+    printf( "%zu obstacles found\n", obstacles );
+    printf( "median of %d runs: branching %.3f ms, queries %.3f ms (%.2f us per query)\n", runs,
+            median( branchTimes ), queryTime,
+            queries ? 1000.0 * queryTime / ( 2 * queries ) : 0.0 );
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+static bool registered = UTILITY_REGISTRY::Register( {
+        "pns_collision",
+        "Benchmark the collision queries of the router, replaying a router log",
+        pns_collision_main,
+} );
@@ -0,0 +1,315 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/utility_registry.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_track.h>
+#include <profile.h>
+#include <settings/json_settings.h>
+
+#include <router/pns_kicad_iface.h>
+#include <router/pns_logger.h>
+#include <router/pns_node.h>
+#include <router/pns_optimizer.h>
+#include <router/pns_router.h>
+#include <router/pns_routing_settings.h>
+#include <router/pns_sizes_settings.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+enum PNS_REPLAY_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    LOG_LOAD_FAILED,
+};
+
+
+using EVENTS = std::vector<PNS::LOGGER::EVENT_ENTRY>;
+
+///> Latencies of the events of each kind, in milliseconds
+using LATENCIES = std::map<std::string, std::vector<double>>;
+
+
+static const char* modeName( PNS::PNS_MODE aMode )
+{
+    switch( aMode )
+    {
+    case PNS::RM_MarkObstacles: return "placement";
+    case PNS::RM_Shove:         return "shove";
+    case PNS::RM_Walkaround:    return "walkaround";
+    default:                    return "smart";
+    }
+}
+
+
+/**
+ * Replays the events recorded by PNS::LOGGER against the router world of a board, with no
+ * view and no commit to the board: every replay starts from the board as loaded.
+ */
+class ROUTER_REPLAY
+{
+public:
+    ROUTER_REPLAY( BOARD* aBoard ) :
+        m_board( aBoard ),
+        m_settingsParent( "pns_replay", SETTINGS_LOC::NESTED, 0 ),
+        m_settings( &m_settingsParent, "pns" )
+    {
+        for( TRACK* track : aBoard->Tracks() )
+            m_parents[track->m_Uuid] = track;
+
+        for( MODULE* module : aBoard->Modules() )
+        {
+            for( D_PAD* pad : module->Pads() )
+                m_parents[pad->m_Uuid] = pad;
+        }
+
+        m_iface.SetBoard( aBoard );
+        m_router.SetInterface( &m_iface );
+        m_router.LoadSettings( &m_settings );
+    }
+
+    void Run( const EVENTS& aEvents, PNS::PNS_MODE aMode, LATENCIES& aLatencies )
+    {
+        m_router.SyncWorld();
+        m_settings.SetMode( aMode );
+
+        std::string mode = modeName( aMode );
+        bool        dragging = false;
+
+        for( const PNS::LOGGER::EVENT_ENTRY& evt : aEvents )
+        {
+            PNS::ITEM* item = findItem( evt );
+
+            switch( evt.m_type )
+            {
+            case PNS::LOGGER::EVT_START_ROUTE:
+            {
+                PNS::SIZES_SETTINGS sizes( m_router.Sizes() );
+
+                sizes.Init( m_board, item );
+                m_router.UpdateSizes( sizes );
+                m_router.StartRouting( evt.m_p, item, evt.m_arg );
+                dragging = false;
+                break;
+            }
+
+            case PNS::LOGGER::EVT_START_DRAG:
+                startDragging( evt, item );
+                dragging = true;
+                break;
+
+            case PNS::LOGGER::EVT_MOVE:
+            case PNS::LOGGER::EVT_FIX:
+            {
+                if( !m_router.RoutingInProgress() )
+                    break;
+
+                PNS::OPTIMIZER::STATS optBefore = PNS::OPTIMIZER::GetStats();
+                PROF_COUNTER          counter;
+
+                if( evt.m_type == PNS::LOGGER::EVT_MOVE )
+                    m_router.Move( evt.m_p, item );
+                else
+                    m_router.FixRoute( evt.m_p, item, evt.m_arg != 0 );
+
+                counter.Stop();
+
+                PNS::OPTIMIZER::STATS optAfter = PNS::OPTIMIZER::GetStats();
+                std::string           kind = evt.m_type == PNS::LOGGER::EVT_FIX ? "fix" :
+                                             dragging ? "drag" : "route";
+
+                aLatencies[kind + "/" + mode].push_back( counter.msecs() );
+
+                if( optAfter.m_passes != optBefore.m_passes )
+                {
+                    aLatencies["optimizer/" + mode].push_back(
+                            ( optAfter.m_time - optBefore.m_time ) / 1e6 );
+                }
+
+                break;
+            }
+
+            case PNS::LOGGER::EVT_STOP:
+                m_router.StopRouting();
+                break;
+            }
+        }
+
+        if( m_router.RoutingInProgress() )
+            m_router.StopRouting();
+    }
+
+private:
+    /**
+     * Finds the router item of the board item an event refers to. Items made by the router
+     * during the recorded session are not in the board, the item under the cursor stands in
+     * for them.
+     */
+    PNS::ITEM* findItem( const PNS::LOGGER::EVENT_ENTRY& aEvent )
+    {
+        if( aEvent.m_uuid == niluuid )
+            return nullptr;
+
+        auto parent = m_parents.find( aEvent.m_uuid );
+
+        if( parent != m_parents.end() )
+        {
+            if( PNS::ITEM* item = m_router.GetWorld()->FindItemByParent( parent->second ) )
+                return item;
+        }
+
+        PNS::ITEM_SET hover = m_router.QueryHoverItems( aEvent.m_p );
+
+        return hover.Empty() ? nullptr : hover[0];
+    }
+
+    void startDragging( const PNS::LOGGER::EVENT_ENTRY& aEvent, PNS::ITEM* aItem )
+    {
+        if( !aItem )
+            return;
+
+        if( !( aEvent.m_arg & PNS::DM_COMPONENT ) || !aItem->Parent()
+                || aItem->Parent()->Type() != PCB_PAD_T )
+        {
+            m_router.StartDragging( aEvent.m_p, aItem, aEvent.m_arg );
+            return;
+        }
+
+        // A component is dragged by all of its pads
+        PNS::ITEM_SET items;
+        MODULE*       module = static_cast<D_PAD*>( aItem->Parent() )->GetParent();
+
+        for( D_PAD* pad : module->Pads() )
+        {
+            if( PNS::ITEM* solid = m_router.GetWorld()->FindItemByParent( pad ) )
+                items.Add( solid );
+        }
+
+        m_router.StartDragging( aEvent.m_p, items, aEvent.m_arg );
+    }
+
+    BOARD*                                m_board;
+    JSON_SETTINGS                         m_settingsParent;
+    PNS::ROUTING_SETTINGS                 m_settings;
+    PNS_KICAD_IFACE_BASE                  m_iface;
+    PNS::ROUTER                           m_router;
+    std::map<KIID, BOARD_CONNECTED_ITEM*> m_parents;
+};
+
+
+static double percentile( const std::vector<double>& aSorted, double aFraction )
+{
+    size_t index = std::min( aSorted.size() - 1, (size_t) ( aFraction * aSorted.size() ) );
+
+    return aSorted[index];
+}
+
+
+/**
+ * Replay router logs saved by PNS::ROUTER::DumpLog() on a board, in the placement (mark
+ * obstacles), shove and walkaround modes, and print the percentiles of the latency of the
+ * moves, fixes and optimizer passes.
+ *
+ * Usage: pns_replay <board file> [-r runs] <log file> [<log file>...]
+ */
+int pns_replay_main( int argc, char* argv[] )
+{
+    if( argc < 3 )
+    {
+        printf( "usage: %s <board file> [-r runs] <log file> [<log file>...]\n", argv[0] );
+        return KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    int                 runs = 3;
+    std::vector<EVENTS> logs;
+
+    for( int ii = 2; ii < argc; ii++ )
+    {
+        if( std::string( argv[ii] ) == "-r" && ii + 1 < argc )
+        {
+            runs = std::max( 1, atoi( argv[++ii] ) );
+            continue;
+        }
+
+        logs.emplace_back();
+
+        if( !PNS::LOGGER::LoadEvents( argv[ii], logs.back() ) )
+        {
+            printf( "cannot read log '%s'\n", argv[ii] );
+            return PNS_REPLAY_RET_CODES::LOG_LOAD_FAILED;
+        }
+    }
+
+    auto brd = KI_TEST::ReadBoardFromFileOrStream( argv[1] );
+
+    if( !brd )
+        return PNS_REPLAY_RET_CODES::LOAD_FAILED;
+
+    ROUTER_REPLAY replay( brd.get() );
+    LATENCIES     latencies;
+
+    const PNS::PNS_MODE modes[] = { PNS::RM_MarkObstacles, PNS::RM_Shove, PNS::RM_Walkaround };
+
+    for( int run = 0; run < runs; run++ )
+    {
+        for( PNS::PNS_MODE mode : modes )
+        {
+            for( const EVENTS& events : logs )
+                replay.Run( events, mode, latencies );
+        }
+    }
+
+    printf( "%-24s %8s %10s %10s %10s %10s\n", "event", "count", "p50 [ms]", "p90 [ms]",
+            "p99 [ms]", "max [ms]" );
+
+    for( auto& entry : latencies )
+    {
+        std::vector<double>& times = entry.second;
+
+        std::sort( times.begin(), times.end() );
+
+        printf( "%-24s %8zu %10.3f %10.3f %10.3f %10.3f\n", entry.first.c_str(), times.size(),
+                percentile( times, 0.5 ), percentile( times, 0.9 ), percentile( times, 0.99 ),
+                times.back() );
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+static bool registered = UTILITY_REGISTRY::Register( {
+        "pns_replay",
+        "Replay router logs on a board and report the latency of the router events",
+        pns_replay_main,
+} );
@@ -32,9 +32,9 @@
 #include <class_board.h>
 #include <class_zone.h>
 #include <profile.h>
+#include <thread_pool.h>
 
-#include <atomic>
-#include <thread>
+#include <functional>
 #include <unordered_set>
 #include <utility>
 
@@ -220,51 +220,64 @@ int polygon_triangulation_main( int argc, char *argv[] )
     if( !brd )
         return POLY_TRI_RET_CODES::LOAD_FAILED;
 
+    auto executor = []( size_t aCount, const std::function<void( size_t )>& aTask )
+    {
+        ParallelFor( 0, aCount, aTask );
+    };
+
+    int    outlineCount = 0;
+    int    reusedCount = 0;
+    double coldTime = 0.0;
+    double warmTime = 0.0;
 
     PROF_COUNTER cnt( "allBoard" );
 
+    for( int areaId = 0; areaId < brd->GetAreaCount(); ++areaId )
+    {
+        ZONE_CONTAINER* zone = brd->GetArea( areaId );
+        SHAPE_POLY_SET  poly = zone->GetFilledPolysList();
+
+        SHAPE_POLY_SET::TRIANGULATION_STATS stats;
+        PROF_COUNTER                        cold;
 
-    std::atomic<size_t> zonesToTriangulate( 0 );
-    std::atomic<size_t> threadsFinished( 0 );
+        poly.CacheTriangulation( executor, &stats );
+        cold.Stop();
 
-    size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
-    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-    {
-        std::thread t = std::thread( [&brd, &zonesToTriangulate, &threadsFinished]() {
-            for( size_t areaId = zonesToTriangulate.fetch_add( 1 );
-                        areaId < static_cast<size_t>( brd->GetAreaCount() );
-                        areaId = zonesToTriangulate.fetch_add( 1 ) )
-            {
-                auto zone = brd->GetArea( areaId );
-                SHAPE_POLY_SET poly = zone->GetFilledPolysList();
-
-                poly.CacheTriangulation();
-
-                (void) poly;
-                printf("zone %zu/%d\n", ( areaId + 1 ), brd->GetAreaCount() );
-#if 0
-                PROF_COUNTER unfrac("unfrac");
-                poly.Unfracture( SHAPE_POLY_SET::PM_FAST );
-                unfrac.Show();
-
-                PROF_COUNTER triangulate("triangulate");
-
-                for(int i =0; i< poly.OutlineCount(); i++)
-                {
-                    poly.triangulatePoly( &poly.Polygon(i) );
-                }
-                triangulate.Show();
-#endif
-            }
+        printf( "zone %d/%d: %d outlines, %.3f ms\n", areaId + 1, brd->GetAreaCount(),
+                poly.OutlineCount(), cold.msecs() );
+
+        for( size_t ii = 0; ii < stats.m_times.size(); ++ii )
+        {
+            const SHAPE_POLY_SET::POLYGON& polygon = poly.CPolygon( (int) ii );
+            int                            vertices = 0;
+
+            for( const SHAPE_LINE_CHAIN& chain : polygon )
+                vertices += chain.PointCount();
+
+            printf( "    outline %zu: %d vertices, %.3f ms\n", ii, vertices, stats.m_times[ii] );
+        }
+
+        // A refill which did not change anything hands the same polygons back: they should
+        // all keep their triangles
+        poly = zone->GetFilledPolysList();
+
+        PROF_COUNTER warm;
+
+        poly.CacheTriangulation( executor, &stats );
+        warm.Stop();
 
-            threadsFinished++;
-        } );
+        printf( "    refill: %d reused, %d triangulated, %.3f ms\n", stats.m_reused,
+                stats.m_triangulated, warm.msecs() );
 
-        t.detach();
+        outlineCount += poly.OutlineCount();
+        reusedCount += stats.m_reused;
+        coldTime += cold.msecs();
+        warmTime += warm.msecs();
     }
 
-    while( threadsFinished < parallelThreadCount )
-        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    printf( "%d outlines: triangulated in %.3f ms, refilled in %.3f ms, %.1f%% cache hits\n",
+            outlineCount, coldTime, warmTime,
+            outlineCount ? 100.0 * reusedCount / outlineCount : 0.0 );
 
     cnt.Show();
 